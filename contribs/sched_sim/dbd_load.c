@@ -0,0 +1,615 @@
+/*****************************************************************************\
+ *  dbd_load.c - stream synthetic job accounting records from many virtual
+ *	clusters into slurmdbd and report ingest rate, commit latency and
+ *	rollup time
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <getopt.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "slurm/slurm.h"
+#include "slurm/slurm_errno.h"
+
+#include "src/common/list.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/pack.h"
+#include "src/common/read_config.h"
+#include "src/common/slurm_persist_conn.h"
+#include "src/common/slurmdbd_defs.h"
+#include "src/common/slurmdbd_pack.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+typedef enum {
+	PHASE_JOB_START,
+	PHASE_STEP_START,
+	PHASE_STEP_COMPLETE,
+	PHASE_JOB_COMPLETE,
+	PHASE_COUNT
+} phase_t;
+
+static const char *phase_names[PHASE_COUNT] = {
+	"job_start", "step_start", "step_complete", "job_complete"
+};
+
+/* A job of the stream, kept from its start message to its completion */
+typedef struct {
+	uint64_t db_index;
+	uint32_t job_id;
+	uint32_t node_cnt;
+	uint32_t first_node;
+	time_t submit;
+	time_t start;
+	time_t end;
+} bench_job_t;
+
+/* One virtual cluster, with its own connection and results */
+typedef struct {
+	pthread_t id;
+	int inx;
+	char *name;
+	slurm_persist_conn_t *pc;
+	uint32_t *lat[PHASE_COUNT];	/* usec of each batch round trip */
+	uint32_t lat_cnt[PHASE_COUNT];
+	uint32_t lat_alloc[PHASE_COUNT];
+	uint32_t errors;
+	uint64_t msgs;
+} vcluster_t;
+
+static int batch_size = 1000;
+static int job_cnt = 10000;		/* per cluster */
+static int node_cnt = 1000;		/* per cluster */
+static int step_cnt = 2;		/* per job */
+static time_t span = 24 * 3600;		/* submit times are spread over */
+static time_t first_submit;
+
+#define CPUS_PER_NODE 64
+#define MEM_PER_NODE 256000
+
+/* Seconds to wait for slurmdbd, as the accounting_storage/slurmdbd plugin */
+#define DBD_TIMEOUT 900
+
+static double _now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + (tv.tv_usec / 1e6);
+}
+
+static int _connect(vcluster_t *vc)
+{
+	slurm_persist_conn_t *pc = xmalloc(sizeof(*pc));
+
+	pc->flags = PERSIST_FLAG_DBD;
+	pc->persist_type = PERSIST_TYPE_DBD;
+	pc->cluster_name = xstrdup(vc->name);
+	pc->timeout = DBD_TIMEOUT * 1000;
+	pc->rem_host = xstrdup(slurm_conf.accounting_storage_host);
+	pc->rem_port = slurm_conf.accounting_storage_port;
+	pc->version = SLURM_PROTOCOL_VERSION;
+	vc->pc = pc;
+
+	return slurm_persist_conn_open(pc);
+}
+
+/* Return code of one response, with the db_index of a job start */
+static int _resp_rc(persist_msg_t *resp, uint64_t *db_index)
+{
+	int rc = SLURM_ERROR;
+
+	if (resp->msg_type == DBD_ID_RC) {
+		dbd_id_rc_msg_t *msg = resp->data;
+		rc = msg->return_code;
+		if (db_index)
+			*db_index = msg->db_index;
+		slurmdbd_free_id_rc_msg(msg);
+	} else if (resp->msg_type == PERSIST_RC) {
+		persist_rc_msg_t *msg = resp->data;
+		rc = msg->rc;
+		if (rc)
+			debug("%s: %s", slurmdbd_msg_type_2_str(msg->ret_info,
+								1),
+			      msg->comment ? msg->comment : slurm_strerror(rc));
+		slurm_persist_free_rc_msg(msg);
+	} else {
+		slurmdbd_free_msg(resp);
+	}
+
+	return rc;
+}
+
+/*
+ * Send packed messages the way the slurmctld agent does: one at a time, or
+ * wrapped in DBD_SEND_MULT_MSG. Job start responses fill in the db_index of
+ * the matching jobs.
+ */
+static int _send(vcluster_t *vc, List bufs, phase_t phase, bench_job_t *jobs)
+{
+	persist_msg_t req = { 0 }, resp = { 0 };
+	dbd_list_msg_t list_msg = { 0 };
+	buf_t *buffer, *out;
+	int errors = 0, i = 0;
+	double start;
+
+	if (list_count(bufs) == 1) {
+		buffer = list_pop(bufs);
+	} else {
+		req.msg_type = DBD_SEND_MULT_MSG;
+		req.data = &list_msg;
+		list_msg.my_list = bufs;
+		buffer = pack_slurmdbd_msg(&req, vc->pc->version);
+	}
+
+	start = _now();
+	if (slurm_persist_send_msg(vc->pc, buffer) ||
+	    !(out = slurm_persist_recv_msg(vc->pc)))
+		fatal("%s: lost connection to slurmdbd", vc->name);
+
+	if (vc->lat_cnt[phase] >= vc->lat_alloc[phase]) {
+		vc->lat_alloc[phase] = MAX(64, vc->lat_alloc[phase] * 2);
+		xrecalloc(vc->lat[phase], vc->lat_alloc[phase],
+			  sizeof(uint32_t));
+	}
+	vc->lat[phase][vc->lat_cnt[phase]++] = (_now() - start) * USEC_IN_SEC;
+	free_buf(buffer);
+
+	if (unpack_slurmdbd_msg(&resp, vc->pc->version, out))
+		fatal("%s: unable to unpack response", vc->name);
+	free_buf(out);
+
+	if (resp.msg_type == DBD_GOT_MULT_MSG) {
+		dbd_list_msg_t *got = resp.data;
+		ListIterator itr = list_iterator_create(got->my_list);
+		while ((out = list_next(itr))) {
+			persist_msg_t one = { 0 };
+			if (unpack_slurmdbd_msg(&one, vc->pc->version, out) ||
+			    _resp_rc(&one, jobs ? &jobs[i].db_index : NULL))
+				errors++;
+			i++;
+		}
+		list_iterator_destroy(itr);
+		slurmdbd_free_list_msg(got);
+	} else if (_resp_rc(&resp, jobs ? &jobs[0].db_index : NULL)) {
+		errors++;
+	}
+	list_flush(bufs);
+
+	vc->errors += errors;
+	return errors;
+}
+
+static void _queue(vcluster_t *vc, List bufs, uint16_t msg_type, void *data)
+{
+	persist_msg_t req = { .msg_type = msg_type, .data = data };
+
+	list_append(bufs, pack_slurmdbd_msg(&req, vc->pc->version));
+	vc->msgs++;
+}
+
+static char *_nodes(vcluster_t *vc, bench_job_t *job)
+{
+	return xstrdup_printf("%s-[%u-%u]", vc->name, job->first_node,
+			      job->first_node + job->node_cnt - 1);
+}
+
+static char *_tres(bench_job_t *job)
+{
+	return xstrdup_printf("%d=%u,%d=%u,%d=%u",
+			      TRES_CPU, job->node_cnt * CPUS_PER_NODE,
+			      TRES_MEM, job->node_cnt * MEM_PER_NODE,
+			      TRES_NODE, job->node_cnt);
+}
+
+static void _job_start(vcluster_t *vc, List bufs, bench_job_t *job)
+{
+	dbd_job_start_msg_t msg = { 0 };
+
+	msg.alloc_nodes = job->node_cnt;
+	msg.array_task_id = NO_VAL;
+	msg.eligible_time = job->submit;
+	msg.gid = getgid();
+	msg.job_id = job->job_id;
+	msg.job_state = JOB_RUNNING;
+	msg.name = "dbd_load";
+	msg.nodes = _nodes(vc, job);
+	msg.node_inx = xstrdup_printf("%u-%u", job->first_node,
+				      job->first_node + job->node_cnt - 1);
+	msg.partition = "batch";
+	msg.priority = 1000;
+	msg.req_cpus = job->node_cnt * CPUS_PER_NODE;
+	msg.req_mem = MEM_PER_NODE;
+	msg.start_time = job->start;
+	msg.submit_time = job->submit;
+	msg.timelimit = 120;
+	msg.uid = getuid();
+	msg.tres_alloc_str = _tres(job);
+	msg.tres_req_str = msg.tres_alloc_str;
+	msg.work_dir = "/tmp";
+
+	_queue(vc, bufs, DBD_JOB_START, &msg);
+	xfree(msg.nodes);
+	xfree(msg.node_inx);
+	xfree(msg.tres_alloc_str);
+}
+
+static void _step(vcluster_t *vc, List bufs, bench_job_t *job, int step,
+		  bool complete)
+{
+	time_t len = (job->end - job->start) / step_cnt;
+	time_t start = job->start + (step * len);
+	slurm_step_id_t step_id = {
+		.job_id = job->job_id,
+		.step_het_comp = NO_VAL,
+		.step_id = step,
+	};
+	char *tres = _tres(job);
+
+	if (!complete) {
+		dbd_step_start_msg_t msg = { 0 };
+		msg.db_index = job->db_index;
+		msg.name = "dbd_load";
+		msg.nodes = _nodes(vc, job);
+		msg.node_inx = xstrdup_printf("%u-%u", job->first_node,
+					      job->first_node +
+					      job->node_cnt - 1);
+		msg.node_cnt = job->node_cnt;
+		msg.start_time = start;
+		msg.job_submit_time = job->submit;
+		msg.req_cpufreq_min = NO_VAL;
+		msg.req_cpufreq_max = NO_VAL;
+		msg.req_cpufreq_gov = NO_VAL;
+		msg.step_id = step_id;
+		msg.task_dist = SLURM_DIST_CYCLIC;
+		msg.total_tasks = job->node_cnt * CPUS_PER_NODE;
+		msg.tres_alloc_str = tres;
+		_queue(vc, bufs, DBD_STEP_START, &msg);
+		xfree(msg.nodes);
+		xfree(msg.node_inx);
+	} else {
+		dbd_step_comp_msg_t msg = { 0 };
+		msg.db_index = job->db_index;
+		msg.end_time = start + len;
+		msg.job_submit_time = job->submit;
+		msg.req_uid = getuid();
+		msg.start_time = start;
+		msg.state = JOB_COMPLETE;
+		msg.step_id = step_id;
+		msg.total_tasks = job->node_cnt * CPUS_PER_NODE;
+		_queue(vc, bufs, DBD_STEP_COMPLETE, &msg);
+	}
+	xfree(tres);
+}
+
+static void _job_complete(vcluster_t *vc, List bufs, bench_job_t *job)
+{
+	dbd_job_comp_msg_t msg = { 0 };
+
+	msg.db_index = job->db_index;
+	msg.end_time = job->end;
+	msg.job_id = job->job_id;
+	msg.job_state = JOB_COMPLETE;
+	msg.nodes = _nodes(vc, job);
+	msg.req_uid = getuid();
+	msg.start_time = job->start;
+	msg.submit_time = job->submit;
+	msg.tres_alloc_str = _tres(job);
+
+	_queue(vc, bufs, DBD_JOB_COMPLETE, &msg);
+	xfree(msg.nodes);
+	xfree(msg.tres_alloc_str);
+}
+
+/* Record the cluster size, as slurmctld does when it registers */
+static void _cluster_tres(vcluster_t *vc)
+{
+	dbd_cluster_tres_msg_t msg = { 0 };
+	List bufs = list_create(slurmdbd_free_buffer);
+
+	msg.cluster_nodes = xstrdup_printf("%s-[0-%d]", vc->name,
+					   node_cnt - 1);
+	msg.event_time = first_submit - 3600;
+	msg.tres_str = xstrdup_printf("%d=%u,%d=%u,%d=%u",
+				      TRES_CPU, node_cnt * CPUS_PER_NODE,
+				      TRES_MEM, node_cnt * MEM_PER_NODE,
+				      TRES_NODE, node_cnt);
+	_queue(vc, bufs, DBD_CLUSTER_TRES, &msg);
+	vc->msgs--;
+	if (_send(vc, bufs, PHASE_JOB_START, NULL))
+		error("%s: DBD_CLUSTER_TRES failed, was the cluster added with sacctmgr?",
+		      vc->name);
+	vc->lat_cnt[PHASE_JOB_START] = 0;
+	vc->errors = 0;
+
+	FREE_NULL_LIST(bufs);
+	xfree(msg.cluster_nodes);
+	xfree(msg.tres_str);
+}
+
+/*
+ * Stream the jobs of one cluster in waves of batch_size jobs: their starts,
+ * then step starts, step completions and job completions, as a busy
+ * slurmctld would send them.
+ */
+static void *_stream(void *arg)
+{
+	vcluster_t *vc = arg;
+	bench_job_t *jobs = xcalloc(batch_size, sizeof(bench_job_t));
+	List bufs = list_create(slurmdbd_free_buffer);
+	unsigned int seed = vc->inx + 1;
+
+	for (int done = 0; done < job_cnt; ) {
+		int cnt = MIN(batch_size, job_cnt - done);
+
+		for (int i = 0; i < cnt; i++) {
+			bench_job_t *job = &jobs[i];
+			job->db_index = 0;
+			job->job_id = done + i + 1;
+			job->node_cnt = 1 + (rand_r(&seed) % 4);
+			job->first_node = rand_r(&seed) %
+					  (node_cnt - job->node_cnt + 1);
+			job->submit = first_submit +
+				      (time_t) ((double) (done + i) *
+						span / job_cnt);
+			job->start = job->submit + (rand_r(&seed) % 600);
+			job->end = job->start + 60 + (rand_r(&seed) % 3540);
+			_job_start(vc, bufs, job);
+		}
+		_send(vc, bufs, PHASE_JOB_START, jobs);
+
+		for (int s = 0; s < step_cnt; s++) {
+			for (int i = 0; i < cnt; i++) {
+				_step(vc, bufs, &jobs[i], s, false);
+				if (list_count(bufs) >= batch_size)
+					_send(vc, bufs, PHASE_STEP_START, NULL);
+			}
+		}
+		if (list_count(bufs))
+			_send(vc, bufs, PHASE_STEP_START, NULL);
+
+		for (int s = 0; s < step_cnt; s++) {
+			for (int i = 0; i < cnt; i++) {
+				_step(vc, bufs, &jobs[i], s, true);
+				if (list_count(bufs) >= batch_size)
+					_send(vc, bufs, PHASE_STEP_COMPLETE,
+					      NULL);
+			}
+		}
+		if (list_count(bufs))
+			_send(vc, bufs, PHASE_STEP_COMPLETE, NULL);
+
+		for (int i = 0; i < cnt; i++)
+			_job_complete(vc, bufs, &jobs[i]);
+		_send(vc, bufs, PHASE_JOB_COMPLETE, NULL);
+
+		done += cnt;
+	}
+
+	FREE_NULL_LIST(bufs);
+	xfree(jobs);
+
+	return NULL;
+}
+
+static int _cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(uint32_t *) a, y = *(uint32_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+static void _report_phases(FILE *out, vcluster_t *vcs, int cluster_cnt)
+{
+	for (phase_t phase = 0; phase < PHASE_COUNT; phase++) {
+		uint32_t *lat = NULL, cnt = 0;
+		uint64_t sum = 0;
+
+		for (int i = 0; i < cluster_cnt; i++) {
+			if (!vcs[i].lat_cnt[phase])
+				continue;
+			xrecalloc(lat, cnt + vcs[i].lat_cnt[phase],
+				  sizeof(uint32_t));
+			memcpy(lat + cnt, vcs[i].lat[phase],
+			       vcs[i].lat_cnt[phase] * sizeof(uint32_t));
+			cnt += vcs[i].lat_cnt[phase];
+		}
+		if (!cnt)
+			continue;
+
+		qsort(lat, cnt, sizeof(uint32_t), _cmp_u32);
+		for (uint32_t i = 0; i < cnt; i++)
+			sum += lat[i];
+
+		fprintf(out, "{\"type\":\"commit\",\"msg\":\"%s\",\"batches\":%u,\"mean_us\":%.0f,\"p50_us\":%u,\"p90_us\":%u,\"p99_us\":%u,\"max_us\":%u}\n",
+			phase_names[phase], cnt, (double) sum / cnt,
+			lat[cnt / 2], lat[(uint64_t) cnt * 90 / 100],
+			lat[(uint64_t) cnt * 99 / 100], lat[cnt - 1]);
+		xfree(lat);
+	}
+}
+
+/* Roll up usage over the streamed period, as "sacctmgr roll" does */
+static void _rollup(FILE *out, vcluster_t *vc)
+{
+	persist_msg_t req = { 0 }, resp = { 0 };
+	dbd_roll_usage_msg_t msg = { 0 };
+	buf_t *buffer, *in;
+	double start;
+	int rc = SLURM_ERROR;
+
+	msg.start = first_submit - (first_submit % 3600);
+	req.msg_type = DBD_ROLL_USAGE;
+	req.data = &msg;
+	buffer = pack_slurmdbd_msg(&req, vc->pc->version);
+
+	start = _now();
+	if (!slurm_persist_send_msg(vc->pc, buffer) &&
+	    (in = slurm_persist_recv_msg(vc->pc))) {
+		if (!unpack_slurmdbd_msg(&resp, vc->pc->version, in))
+			rc = _resp_rc(&resp, NULL);
+		free_buf(in);
+	}
+	free_buf(buffer);
+
+	fprintf(out, "{\"type\":\"rollup\",\"start\":%ld,\"usec\":%.0f,\"rc\":\"%s\"}\n",
+		(long) msg.start, (_now() - start) * USEC_IN_SEC,
+		slurm_strerror(rc));
+}
+
+static void _usage(void)
+{
+	fprintf(stderr,
+"Usage: dbd_load [options]\n"
+"  -b count     messages per DBD_SEND_MULT_MSG, 1 sends them one by one,\n"
+"               default 1000\n"
+"  -c count     virtual clusters, each on its own connection, default 4\n"
+"  -C prefix    cluster name prefix, default dbdbench (clusters are\n"
+"               dbdbench0, dbdbench1, ... and must exist in the database)\n"
+"  -H hours     spread the job submit times over this many hours before\n"
+"               now, default 24\n"
+"  -j count     jobs per cluster, default 10000\n"
+"  -n count     nodes per cluster, default 1000\n"
+"  -o file      write results to file instead of stdout\n"
+"  -r           roll up usage after the streams and time it\n"
+"  -s count     steps per job, default 2\n"
+"  -v           increase verbosity\n");
+}
+
+int main(int argc, char **argv)
+{
+	log_options_t log_opts = LOG_OPTS_STDERR_ONLY;
+	vcluster_t *vcs;
+	FILE *out = stdout;
+	char *prefix = "dbdbench";
+	int c, cluster_cnt = 4;
+	uint64_t msgs = 0;
+	uint32_t errors = 0;
+	bool rollup = false;
+	double start, elapsed;
+
+	while ((c = getopt(argc, argv, "b:c:C:hH:j:n:o:rs:v")) != -1) {
+		switch (c) {
+		case 'b':
+			batch_size = atoi(optarg);
+			break;
+		case 'c':
+			cluster_cnt = atoi(optarg);
+			break;
+		case 'C':
+			prefix = optarg;
+			break;
+		case 'H':
+			span = atoi(optarg) * 3600;
+			break;
+		case 'j':
+			job_cnt = atoi(optarg);
+			break;
+		case 'n':
+			node_cnt = atoi(optarg);
+			break;
+		case 'o':
+			if (!(out = fopen(optarg, "w")))
+				fatal("unable to open %s: %m", optarg);
+			break;
+		case 'r':
+			rollup = true;
+			break;
+		case 's':
+			step_cnt = atoi(optarg);
+			break;
+		case 'v':
+			log_opts.stderr_level++;
+			break;
+		default:
+			_usage();
+			exit(1);
+		}
+	}
+	if ((batch_size <= 0) || (cluster_cnt <= 0) || (span <= 0) ||
+	    (job_cnt <= 0) || (node_cnt < 4) || (step_cnt < 0)) {
+		_usage();
+		exit(1);
+	}
+
+	log_init(xbasename(argv[0]), log_opts, 0, NULL);
+	slurm_conf_init(NULL);
+
+	/* End two hours back so the last jobs fall in a rolled up hour */
+	first_submit = time(NULL) - span - (2 * 3600);
+
+	vcs = xcalloc(cluster_cnt, sizeof(vcluster_t));
+	for (int i = 0; i < cluster_cnt; i++) {
+		vcs[i].inx = i;
+		vcs[i].name = xstrdup_printf("%s%d", prefix, i);
+		if (_connect(&vcs[i]))
+			fatal("unable to connect to slurmdbd as cluster %s",
+			      vcs[i].name);
+		_cluster_tres(&vcs[i]);
+	}
+
+	start = _now();
+	for (int i = 0; i < cluster_cnt; i++)
+		slurm_thread_create(&vcs[i].id, _stream, &vcs[i]);
+	for (int i = 0; i < cluster_cnt; i++) {
+		pthread_join(vcs[i].id, NULL);
+		msgs += vcs[i].msgs;
+		errors += vcs[i].errors;
+	}
+	elapsed = _now() - start;
+
+	fprintf(out, "{\"type\":\"ingest\",\"clusters\":%d,\"jobs\":%"PRIu64",\"steps_per_job\":%d,\"batch\":%d,\"elapsed\":%.1f,\"messages\":%"PRIu64",\"errors\":%u,\"msgs_per_sec\":%.0f,\"jobs_per_sec\":%.0f}\n",
+		cluster_cnt, (uint64_t) job_cnt * cluster_cnt, step_cnt,
+		batch_size, elapsed, msgs, errors, msgs / elapsed,
+		((double) job_cnt * cluster_cnt) / elapsed);
+	_report_phases(out, vcs, cluster_cnt);
+	if (rollup)
+		_rollup(out, &vcs[0]);
+	if (out != stdout)
+		fclose(out);
+
+	for (int i = 0; i < cluster_cnt; i++) {
+		slurm_persist_conn_destroy(vcs[i].pc);
+		for (phase_t phase = 0; phase < PHASE_COUNT; phase++)
+			xfree(vcs[i].lat[phase]);
+		xfree(vcs[i].name);
+	}
+	xfree(vcs);
+	log_fini();
+
+	return 0;
+}
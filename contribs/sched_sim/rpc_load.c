@@ -0,0 +1,567 @@
+/*****************************************************************************\
+ *  rpc_load.c - generate a mixed RPC load against slurmctld and report
+ *	client latency and controller time per RPC
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <getopt.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "slurm/slurm.h"
+#include "slurm/slurm_errno.h"
+
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/read_config.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xsignal.h"
+#include "src/common/xstring.h"
+
+typedef enum {
+	OP_SUBMIT,
+	OP_JOB_INFO,
+	OP_NODE_INFO,
+	OP_STEP_CREATE,
+	OP_CANCEL,
+	OP_COUNT
+} op_type_t;
+
+static const char *op_names[OP_COUNT] = {
+	"submit", "job_info", "node_info", "step_create", "cancel"
+};
+
+/* Per thread results, merged once the threads have stopped */
+typedef struct {
+	pthread_t id;
+	int inx;
+	uint32_t *lat[OP_COUNT];	/* usec of each successful call */
+	uint32_t lat_cnt[OP_COUNT];
+	uint32_t lat_alloc[OP_COUNT];
+	uint32_t errors[OP_COUNT];
+	uint32_t late;			/* calls started behind schedule */
+} worker_t;
+
+static int weights[OP_COUNT] = { 1, 10, 5, 0, 1 };
+static int weight_sum = 0;
+static double rate = 0;			/* per thread, 0 for closed loop */
+static double duration = 60;
+static char *partition = NULL;
+
+static uint32_t alloc_job_id = 0;	/* allocation used for steps */
+
+/* Held jobs made by OP_SUBMIT, popped by OP_CANCEL */
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t *pool = NULL;
+static int pool_cnt = 0, pool_alloc = 0;
+
+static volatile sig_atomic_t stop = 0;
+
+static double _now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + (tv.tv_usec / 1e6);
+}
+
+static void _pool_push(uint32_t job_id)
+{
+	slurm_mutex_lock(&pool_mutex);
+	if (pool_cnt >= pool_alloc) {
+		pool_alloc = MAX(1024, pool_alloc * 2);
+		xrecalloc(pool, pool_alloc, sizeof(uint32_t));
+	}
+	pool[pool_cnt++] = job_id;
+	slurm_mutex_unlock(&pool_mutex);
+}
+
+static uint32_t _pool_pop(void)
+{
+	uint32_t job_id = 0;
+
+	slurm_mutex_lock(&pool_mutex);
+	if (pool_cnt)
+		job_id = pool[--pool_cnt];
+	slurm_mutex_unlock(&pool_mutex);
+
+	return job_id;
+}
+
+static int _submit(void)
+{
+	job_desc_msg_t desc;
+	submit_response_msg_t *resp = NULL;
+	char *env[] = { "RPC_LOAD=1", NULL };
+	int rc;
+
+	slurm_init_job_desc_msg(&desc);
+	desc.name = "rpc_load";
+	desc.script = "#!/bin/sh\n";
+	desc.partition = partition;
+	desc.priority = 0;	/* held, so the jobs never compete for nodes */
+	desc.time_limit = 1;
+	desc.user_id = getuid();
+	desc.group_id = getgid();
+	desc.work_dir = "/tmp";
+	desc.std_out = "/dev/null";
+	desc.environment = env;
+	desc.env_size = 1;
+
+	if (!(rc = slurm_submit_batch_job(&desc, &resp)))
+		_pool_push(resp->job_id);
+	slurm_free_submit_response_response_msg(resp);
+
+	return rc;
+}
+
+static int _job_info(void)
+{
+	job_info_msg_t *jobs = NULL;
+	int rc;
+
+	rc = slurm_load_jobs(0, &jobs, SHOW_ALL);
+	slurm_free_job_info_msg(jobs);
+
+	return rc;
+}
+
+static int _node_info(void)
+{
+	node_info_msg_t *nodes = NULL;
+	int rc;
+
+	rc = slurm_load_node(0, &nodes, SHOW_ALL);
+	slurm_free_node_info_msg(nodes);
+
+	return rc;
+}
+
+/* Create a step in the allocation, then complete it the way srun does */
+static int _step_create(void)
+{
+	slurm_step_ctx_params_t params;
+	slurm_step_ctx_t *ctx;
+	slurm_msg_t req;
+	step_complete_msg_t msg;
+	uint32_t node_cnt = 0;
+	int rc = SLURM_SUCCESS;
+
+	slurm_step_ctx_params_t_init(&params);
+	params.step_id.job_id = alloc_job_id;
+	params.min_nodes = 1;
+	params.max_nodes = 1;
+	params.task_count = 1;
+	params.cpu_count = 1;
+	params.name = "rpc_load";
+	if (!(ctx = slurm_step_ctx_create(&params)))
+		return SLURM_ERROR;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.step_id.job_id = alloc_job_id;
+	msg.step_id.step_het_comp = NO_VAL;
+	slurm_step_ctx_get(ctx, SLURM_STEP_CTX_STEPID, &msg.step_id.step_id);
+	slurm_step_ctx_get(ctx, SLURM_STEP_CTX_NUM_HOSTS, &node_cnt);
+	msg.range_last = node_cnt ? (node_cnt - 1) : 0;
+
+	slurm_msg_t_init(&req);
+	req.msg_type = REQUEST_STEP_COMPLETE;
+	req.data = &msg;
+	if (slurm_send_recv_controller_rc_msg(&req, &rc, NULL))
+		rc = SLURM_ERROR;
+	slurm_step_ctx_destroy(ctx);
+
+	return rc;
+}
+
+static int _cancel(void)
+{
+	uint32_t job_id;
+
+	if (!(job_id = _pool_pop())) {
+		errno = ESLURM_INVALID_JOB_ID;
+		return SLURM_ERROR;
+	}
+
+	return slurm_kill_job(job_id, SIGKILL, 0);
+}
+
+static op_type_t _pick_op(unsigned int *seed)
+{
+	int r = rand_r(seed) % weight_sum;
+
+	for (op_type_t op = 0; op < OP_COUNT; op++) {
+		if (r < weights[op])
+			return op;
+		r -= weights[op];
+	}
+
+	return OP_JOB_INFO;
+}
+
+static void *_worker(void *arg)
+{
+	worker_t *w = arg;
+	unsigned int seed = w->inx + 1;
+	double end = _now() + duration, next = _now();
+
+	while (!stop) {
+		op_type_t op = _pick_op(&seed);
+		double start;
+		int rc;
+
+		if (rate) {
+			double now = _now();
+			if (next > now)
+				usleep((next - now) * USEC_IN_SEC);
+			else if ((now - next) > (1 / rate))
+				w->late++;
+			next += 1 / rate;
+		}
+		if ((start = _now()) >= end)
+			break;
+
+		/* Nothing left to cancel, make one instead of skipping */
+		if ((op == OP_CANCEL) && !pool_cnt)
+			op = OP_SUBMIT;
+
+		switch (op) {
+		case OP_SUBMIT:
+			rc = _submit();
+			break;
+		case OP_JOB_INFO:
+			rc = _job_info();
+			break;
+		case OP_NODE_INFO:
+			rc = _node_info();
+			break;
+		case OP_STEP_CREATE:
+			rc = _step_create();
+			break;
+		case OP_CANCEL:
+		default:
+			rc = _cancel();
+			break;
+		}
+
+		if (rc) {
+			w->errors[op]++;
+			debug("%s: %s", op_names[op], slurm_strerror(errno));
+			continue;
+		}
+		if (w->lat_cnt[op] >= w->lat_alloc[op]) {
+			w->lat_alloc[op] = MAX(1024, w->lat_alloc[op] * 2);
+			xrecalloc(w->lat[op], w->lat_alloc[op],
+				  sizeof(uint32_t));
+		}
+		w->lat[op][w->lat_cnt[op]++] = (_now() - start) * USEC_IN_SEC;
+	}
+
+	return NULL;
+}
+
+static int _cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(uint32_t *) a, y = *(uint32_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+static void _report_ops(FILE *out, worker_t *workers, int thread_cnt,
+			double elapsed)
+{
+	for (op_type_t op = 0; op < OP_COUNT; op++) {
+		uint32_t *lat = NULL, cnt = 0, errors = 0;
+		uint64_t sum = 0;
+
+		for (int i = 0; i < thread_cnt; i++) {
+			errors += workers[i].errors[op];
+			if (!workers[i].lat_cnt[op])
+				continue;
+			xrecalloc(lat, cnt + workers[i].lat_cnt[op],
+				  sizeof(uint32_t));
+			memcpy(lat + cnt, workers[i].lat[op],
+			       workers[i].lat_cnt[op] * sizeof(uint32_t));
+			cnt += workers[i].lat_cnt[op];
+		}
+		if (!cnt && !errors)
+			continue;
+
+		qsort(lat, cnt, sizeof(uint32_t), _cmp_u32);
+		for (uint32_t i = 0; i < cnt; i++)
+			sum += lat[i];
+
+		fprintf(out, "{\"type\":\"op\",\"op\":\"%s\",\"count\":%u,\"errors\":%u,\"per_sec\":%.1f,\"mean_us\":%.0f,\"p50_us\":%u,\"p90_us\":%u,\"p99_us\":%u,\"p999_us\":%u,\"max_us\":%u}\n",
+			op_names[op], cnt, errors, cnt / elapsed,
+			cnt ? ((double) sum / cnt) : 0.0,
+			cnt ? lat[cnt / 2] : 0,
+			cnt ? lat[(uint64_t) cnt * 90 / 100] : 0,
+			cnt ? lat[(uint64_t) cnt * 99 / 100] : 0,
+			cnt ? lat[(uint64_t) cnt * 999 / 1000] : 0,
+			cnt ? lat[cnt - 1] : 0);
+		xfree(lat);
+	}
+}
+
+/*
+ * Attribute controller time to each RPC type from the difference of two
+ * sdiag snapshots. Entries are matched by type since the arrays are in
+ * first seen order.
+ */
+static void _report_rpcs(FILE *out, stats_info_response_msg_t *before,
+			 stats_info_response_msg_t *after, double elapsed)
+{
+	uint64_t total = 0;
+
+	for (int pass = 0; pass < 2; pass++) {
+		for (uint32_t i = 0; i < after->rpc_type_size; i++) {
+			uint32_t cnt = after->rpc_type_cnt[i];
+			uint64_t time = after->rpc_type_time[i];
+			uint64_t auth = after->rpc_type_auth_time[i];
+			uint64_t lock = after->rpc_type_lock_time[i];
+
+			for (uint32_t j = 0; j < before->rpc_type_size; j++) {
+				if (before->rpc_type_id[j] !=
+				    after->rpc_type_id[i])
+					continue;
+				cnt -= before->rpc_type_cnt[j];
+				time -= before->rpc_type_time[j];
+				auth -= before->rpc_type_auth_time[j];
+				lock -= before->rpc_type_lock_time[j];
+				break;
+			}
+			if (!cnt)
+				continue;
+			if (!pass) {
+				total += time;
+				continue;
+			}
+
+			fprintf(out, "{\"type\":\"rpc\",\"rpc\":\"%s\",\"count\":%u,\"per_sec\":%.1f,\"mean_us\":%.0f,\"auth_mean_us\":%.0f,\"lock_mean_us\":%.0f,\"time_share\":%.3f}\n",
+				rpc_num2string(after->rpc_type_id[i]), cnt,
+				cnt / elapsed, (double) time / cnt,
+				(double) auth / cnt, (double) lock / cnt,
+				total ? ((double) time / total) : 0.0);
+		}
+	}
+
+	fprintf(out, "{\"type\":\"server\",\"agent_queue_size\":%u,\"server_thread_count\":%u,\"rpc_usec\":%"PRIu64",\"jobs_submitted\":%u,\"jobs_canceled\":%u}\n",
+		after->agent_queue_size, after->server_thread_count, total,
+		after->jobs_submitted - before->jobs_submitted,
+		after->jobs_canceled - before->jobs_canceled);
+}
+
+static stats_info_response_msg_t *_get_stats(void)
+{
+	stats_info_request_msg_t req = { .command_id = STAT_COMMAND_GET };
+	stats_info_response_msg_t *stats = NULL;
+
+	if (slurm_get_statistics(&stats, &req))
+		fatal("slurm_get_statistics: %m");
+
+	return stats;
+}
+
+/* One node allocation that OP_STEP_CREATE makes its steps in */
+static void _allocate(void)
+{
+	job_desc_msg_t desc;
+	resource_allocation_response_msg_t *alloc;
+
+	slurm_init_job_desc_msg(&desc);
+	desc.name = "rpc_load";
+	desc.partition = partition;
+	desc.min_nodes = 1;
+	desc.max_nodes = 1;
+	desc.shared = JOB_SHARED_NONE;
+	desc.user_id = getuid();
+	desc.group_id = getgid();
+
+	if (!(alloc = slurm_allocate_resources_blocking(&desc, 60, NULL)))
+		fatal("unable to allocate a node for step_create: %m");
+	alloc_job_id = alloc->job_id;
+	info("steps are created in job %u on %s", alloc_job_id,
+	     alloc->node_list);
+	slurm_free_resource_allocation_response_msg(alloc);
+}
+
+static int _parse_mix(char *mix)
+{
+	char *tmp = xstrdup(mix), *tok, *save_ptr = NULL, *val;
+	int rc = SLURM_SUCCESS;
+
+	memset(weights, 0, sizeof(weights));
+	for (tok = strtok_r(tmp, ",", &save_ptr); tok;
+	     tok = strtok_r(NULL, ",", &save_ptr)) {
+		op_type_t op;
+
+		if (!(val = xstrchr(tok, '='))) {
+			rc = SLURM_ERROR;
+			break;
+		}
+		*val++ = '\0';
+		for (op = 0; op < OP_COUNT; op++) {
+			if (!xstrcasecmp(tok, op_names[op]))
+				break;
+		}
+		if (op == OP_COUNT) {
+			rc = SLURM_ERROR;
+			break;
+		}
+		weights[op] = atoi(val);
+	}
+	xfree(tmp);
+
+	return rc;
+}
+
+static void _sig_handler(int signo)
+{
+	stop = 1;
+}
+
+static void _usage(void)
+{
+	fprintf(stderr,
+"Usage: rpc_load [options]\n"
+"  -d seconds   run time, default 60\n"
+"  -m mix       weights of the operations, default\n"
+"               submit=1,job_info=10,node_info=5,step_create=0,cancel=1\n"
+"  -o file      write results to file instead of stdout\n"
+"  -p partition partition for submitted jobs and the step allocation\n"
+"  -R rate      total operations per second, default 0 (closed loop)\n"
+"  -t threads   concurrent clients, default 8\n"
+"  -v           increase verbosity\n");
+}
+
+int main(int argc, char **argv)
+{
+	log_options_t log_opts = LOG_OPTS_STDERR_ONLY;
+	stats_info_response_msg_t *before, *after;
+	worker_t *workers;
+	FILE *out = stdout;
+	double total_rate = 0, start, elapsed;
+	int c, thread_cnt = 8;
+	uint32_t late = 0, job_id;
+
+	while ((c = getopt(argc, argv, "d:hm:o:p:R:t:v")) != -1) {
+		switch (c) {
+		case 'd':
+			if ((duration = strtod(optarg, NULL)) <= 0)
+				fatal("invalid duration: %s", optarg);
+			break;
+		case 'm':
+			if (_parse_mix(optarg))
+				fatal("invalid mix: %s", optarg);
+			break;
+		case 'o':
+			if (!(out = fopen(optarg, "w")))
+				fatal("unable to open %s: %m", optarg);
+			break;
+		case 'p':
+			partition = optarg;
+			break;
+		case 'R':
+			total_rate = strtod(optarg, NULL);
+			break;
+		case 't':
+			if ((thread_cnt = atoi(optarg)) <= 0)
+				fatal("invalid thread count: %s", optarg);
+			break;
+		case 'v':
+			log_opts.stderr_level++;
+			break;
+		default:
+			_usage();
+			exit(1);
+		}
+	}
+	for (op_type_t op = 0; op < OP_COUNT; op++)
+		weight_sum += weights[op];
+	if (!weight_sum)
+		fatal("the operation mix is empty");
+	rate = total_rate / thread_cnt;
+
+	log_init(xbasename(argv[0]), log_opts, 0, NULL);
+	slurm_conf_init(NULL);
+
+	if (weights[OP_STEP_CREATE])
+		_allocate();
+
+	xsignal(SIGINT, _sig_handler);
+	xsignal(SIGTERM, _sig_handler);
+
+	before = _get_stats();
+	workers = xcalloc(thread_cnt, sizeof(worker_t));
+	start = _now();
+	for (int i = 0; i < thread_cnt; i++) {
+		workers[i].inx = i;
+		slurm_thread_create(&workers[i].id, _worker, &workers[i]);
+	}
+	for (int i = 0; i < thread_cnt; i++) {
+		pthread_join(workers[i].id, NULL);
+		late += workers[i].late;
+	}
+	elapsed = _now() - start;
+	after = _get_stats();
+
+	fprintf(out, "{\"type\":\"run\",\"threads\":%d,\"target_per_sec\":%.1f,\"elapsed\":%.1f,\"late\":%u}\n",
+		thread_cnt, total_rate, elapsed, late);
+	_report_ops(out, workers, thread_cnt, elapsed);
+	_report_rpcs(out, before, after, elapsed);
+	if (out != stdout)
+		fclose(out);
+
+	/* Clean up the held jobs and the step allocation */
+	while ((job_id = _pool_pop()))
+		slurm_kill_job(job_id, SIGKILL, 0);
+	if (alloc_job_id)
+		slurm_complete_job(alloc_job_id, 0);
+
+	for (int i = 0; i < thread_cnt; i++) {
+		for (op_type_t op = 0; op < OP_COUNT; op++)
+			xfree(workers[i].lat[op]);
+	}
+	xfree(workers);
+	xfree(pool);
+	slurm_free_stats_response_msg(before);
+	slurm_free_stats_response_msg(after);
+	log_fini();
+
+	return 0;
+}
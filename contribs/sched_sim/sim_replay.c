@@ -0,0 +1,425 @@
+/*****************************************************************************\
+ *  sim_replay.c - replay a job trace against slurmctld and report scheduler
+ *	statistics
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <getopt.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "slurm/slurm.h"
+#include "slurm/slurm_errno.h"
+
+#include "src/common/log.h"
+#include "src/common/parse_time.h"
+#include "src/common/read_config.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xsignal.h"
+#include "src/common/xstring.h"
+
+typedef enum {
+	TRACE_SWF,	/* Standard Workload Format */
+	TRACE_SACCT,	/* sacct -XPn -o Submit,ElapsedRaw,NCPUS,TimelimitRaw,Partition */
+} trace_format_t;
+
+typedef struct {
+	double submit;		/* seconds since the first job of the trace */
+	double run_time;	/* seconds */
+	uint32_t cpus;
+	uint32_t time_limit;	/* seconds, or NO_VAL */
+	char *partition;
+} trace_job_t;
+
+static double accel = 1.0;
+static uint32_t max_cpus = 0;
+static char *partition = NULL;
+static FILE *out = NULL;
+
+static trace_job_t *jobs = NULL;
+static int job_cnt = 0;
+
+static volatile sig_atomic_t stop = 0;
+
+static double _now(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + (tv.tv_usec / 1e6);
+}
+
+static void _add_job(double submit, double run_time, long cpus,
+		     long time_limit, char *part)
+{
+	static int job_alloc = 0;
+	trace_job_t *job;
+
+	if ((run_time < 0) || (cpus <= 0))
+		return;
+
+	if (job_cnt >= job_alloc) {
+		job_alloc = MAX(1024, job_alloc * 2);
+		xrecalloc(jobs, job_alloc, sizeof(trace_job_t));
+	}
+	job = &jobs[job_cnt++];
+	job->submit = submit;
+	job->run_time = run_time;
+	job->cpus = (max_cpus && (cpus > max_cpus)) ? max_cpus : cpus;
+	job->time_limit = (time_limit > 0) ? time_limit : NO_VAL;
+	job->partition = xstrdup(part);
+}
+
+/*
+ * SWF fields: 1 job number, 2 submit time, 3 wait time, 4 run time,
+ * 5 allocated processors, 6 average CPU time, 7 used memory, 8 requested
+ * processors, 9 requested time, ... Unknown values are -1.
+ */
+static void _read_swf_line(char *line)
+{
+	double f[18];
+	int cnt = 0;
+	char *tok, *save_ptr = NULL;
+
+	if (line[0] == ';')
+		return;
+	for (tok = strtok_r(line, " \t\n", &save_ptr); tok && (cnt < 18);
+	     tok = strtok_r(NULL, " \t\n", &save_ptr))
+		f[cnt++] = strtod(tok, NULL);
+	if (cnt < 9)
+		return;
+
+	_add_job(f[1], f[3], (f[4] > 0) ? f[4] : f[7], f[8], NULL);
+}
+
+static void _read_sacct_line(char *line)
+{
+	char *fields[5], *save_ptr = NULL;
+	int cnt = 0;
+	time_t submit;
+	long limit;
+
+	line[strcspn(line, "\n")] = '\0';
+	for (char *tok = strtok_r(line, "|", &save_ptr); tok && (cnt < 5);
+	     tok = strtok_r(NULL, "|", &save_ptr))
+		fields[cnt++] = tok;
+	if ((cnt < 4) || !(submit = parse_time(fields[0], 1)))
+		return;
+
+	/* TimelimitRaw is in minutes, or e.g. "Partition_Limit" */
+	if ((limit = strtol(fields[3], NULL, 10)) > 0)
+		limit *= 60;
+	_add_job(submit, strtod(fields[1], NULL), strtol(fields[2], NULL, 10),
+		 limit, (cnt == 5) ? fields[4] : NULL);
+}
+
+static int _cmp_submit(const void *a, const void *b)
+{
+	double x = ((trace_job_t *) a)->submit, y = ((trace_job_t *) b)->submit;
+
+	return (x > y) - (x < y);
+}
+
+static void _read_trace(char *file, trace_format_t format)
+{
+	FILE *fp;
+	char *line = NULL;
+	size_t len = 0;
+	double first;
+
+	if (!(fp = fopen(file, "r")))
+		fatal("unable to open %s: %m", file);
+	while (getline(&line, &len, fp) != -1) {
+		if (format == TRACE_SWF)
+			_read_swf_line(line);
+		else
+			_read_sacct_line(line);
+	}
+	free(line);
+	fclose(fp);
+
+	if (!job_cnt)
+		fatal("no usable jobs in %s", file);
+
+	qsort(jobs, job_cnt, sizeof(trace_job_t), _cmp_submit);
+	first = jobs[0].submit;
+	for (int i = 0; i < job_cnt; i++)
+		jobs[i].submit -= first;
+}
+
+static int _submit(trace_job_t *job)
+{
+	job_desc_msg_t desc;
+	submit_response_msg_t *resp = NULL;
+	char *env[2] = { NULL, NULL };
+	int rc;
+
+	slurm_init_job_desc_msg(&desc);
+	desc.name = "sim_replay";
+	desc.script = "#!/bin/sh\n# simulated by sim_slurmd\n";
+	desc.min_cpus = job->cpus;
+	if (job->time_limit != NO_VAL)
+		desc.time_limit = MAX(1, ceil(job->time_limit / accel / 60));
+	desc.partition = partition ? partition : job->partition;
+	desc.user_id = getuid();
+	desc.group_id = getgid();
+	desc.work_dir = "/tmp";
+	desc.std_out = "/dev/null";
+	desc.std_err = "/dev/null";
+
+	/* Read by sim_slurmd to complete the batch script */
+	env[0] = xstrdup_printf("SLURM_SIM_RUN_TIME=%.3f",
+				job->run_time / accel);
+	desc.environment = env;
+	desc.env_size = 1;
+
+	if ((rc = slurm_submit_batch_job(&desc, &resp)))
+		rc = errno;
+	slurm_free_submit_response_response_msg(resp);
+	xfree(env[0]);
+
+	return rc;
+}
+
+/*
+ * Print the scheduler statistics since the previous sample, and over the
+ * whole replay with total set.
+ */
+static int _sample(double elapsed, int submitted, bool total)
+{
+	static stats_info_response_msg_t *first = NULL, *prev = NULL;
+	stats_info_request_msg_t req = { .command_id = STAT_COMMAND_GET };
+	stats_info_response_msg_t *stats = NULL, *base;
+	uint32_t sched_cnt, bf_cnt, started;
+	int rc;
+
+	if ((rc = slurm_get_statistics(&stats, &req))) {
+		error("slurm_get_statistics: %m");
+		return rc;
+	}
+	if (!first)
+		first = stats;
+	base = total ? first : (prev ? prev : first);
+
+	sched_cnt = stats->schedule_cycle_counter -
+		    base->schedule_cycle_counter;
+	bf_cnt = stats->bf_cycle_counter - base->bf_cycle_counter;
+	started = stats->jobs_started - base->jobs_started;
+
+	fprintf(out, "{\"type\":\"%s\",\"elapsed\":%.1f,\"sim_time\":%.1f,\"submitted\":%d,\"jobs_started\":%u,\"jobs_completed\":%u,\"jobs_pending\":%u,\"jobs_running\":%u,\"throughput_per_min\":%.2f,\"sched_cycles\":%u,\"sched_cycle_last\":%u,\"sched_cycle_mean\":%.0f,\"sched_cycle_max\":%u,\"sched_depth_mean\":%.1f,\"bf_cycles\":%u,\"bf_cycle_last\":%u,\"bf_cycle_mean\":%.0f,\"bf_cycle_max\":%u,\"bf_last_depth\":%u,\"bf_last_depth_try\":%u,\"bf_depth_mean\":%.1f,\"bf_queue_len\":%u,\"bf_backfilled_jobs\":%u}\n",
+		total ? "total" : "sample", elapsed, elapsed * accel, submitted,
+		started, stats->jobs_completed - base->jobs_completed,
+		stats->jobs_pending, stats->jobs_running,
+		elapsed ? (started * 60.0 / elapsed) : 0.0,
+		sched_cnt, stats->schedule_cycle_last,
+		sched_cnt ? ((double) (stats->schedule_cycle_sum -
+				       base->schedule_cycle_sum) / sched_cnt) :
+			    0.0,
+		stats->schedule_cycle_max,
+		sched_cnt ? ((double) (stats->schedule_cycle_depth -
+				       base->schedule_cycle_depth) /
+			     sched_cnt) : 0.0,
+		bf_cnt, stats->bf_cycle_last,
+		bf_cnt ? ((double) (stats->bf_cycle_sum - base->bf_cycle_sum) /
+			  bf_cnt) : 0.0,
+		stats->bf_cycle_max, stats->bf_last_depth,
+		stats->bf_last_depth_try,
+		bf_cnt ? ((double) (stats->bf_depth_sum - base->bf_depth_sum) /
+			  bf_cnt) : 0.0,
+		stats->bf_queue_len,
+		stats->bf_backfilled_jobs - base->bf_backfilled_jobs);
+	fflush(out);
+
+	if (!total) {
+		if (prev != first)
+			slurm_free_stats_response_msg(prev);
+		prev = stats;
+	} else if (stats != first) {
+		slurm_free_stats_response_msg(stats);
+	}
+
+	/* Drained when no jobs are left in the controller */
+	return (stats->jobs_pending || stats->jobs_running) ? EAGAIN : 0;
+}
+
+static void _sig_handler(int signo)
+{
+	stop = 1;
+}
+
+static void _usage(void)
+{
+	fprintf(stderr,
+"Usage: sim_replay -f trace [options]\n"
+"  -f trace      job trace to replay\n"
+"  -F swf|sacct  trace format, default swf. sacct traces are made with\n"
+"                sacct -XPn -o Submit,ElapsedRaw,NCPUS,TimelimitRaw,Partition\n"
+"  -a factor     time acceleration, divides inter-arrival, run and limit times\n"
+"  -c cpus       cap the CPUs requested by each job\n"
+"  -i seconds    statistics sample interval, default 10\n"
+"  -n count      only replay the first count jobs\n"
+"  -o file       write statistics to file instead of stdout\n"
+"  -p partition  submit every job to this partition\n"
+"  -r            reset the slurmctld statistics before starting\n");
+}
+
+int main(int argc, char **argv)
+{
+	log_options_t log_opts = LOG_OPTS_STDERR_ONLY;
+	trace_format_t format = TRACE_SWF;
+	char *file = NULL;
+	double interval = 10, start, next_sample;
+	int c, limit = 0, next = 0, submitted = 0, failed = 0;
+	bool reset = false;
+
+	out = stdout;
+	while ((c = getopt(argc, argv, "a:c:f:F:hi:n:o:p:r")) != -1) {
+		switch (c) {
+		case 'a':
+			if ((accel = strtod(optarg, NULL)) <= 0)
+				fatal("invalid acceleration: %s", optarg);
+			break;
+		case 'c':
+			max_cpus = strtoul(optarg, NULL, 10);
+			break;
+		case 'f':
+			file = optarg;
+			break;
+		case 'F':
+			if (!xstrcasecmp(optarg, "swf"))
+				format = TRACE_SWF;
+			else if (!xstrcasecmp(optarg, "sacct"))
+				format = TRACE_SACCT;
+			else
+				fatal("invalid trace format: %s", optarg);
+			break;
+		case 'i':
+			if ((interval = strtod(optarg, NULL)) <= 0)
+				fatal("invalid interval: %s", optarg);
+			break;
+		case 'n':
+			limit = strtol(optarg, NULL, 10);
+			break;
+		case 'o':
+			if (!(out = fopen(optarg, "w")))
+				fatal("unable to open %s: %m", optarg);
+			break;
+		case 'p':
+			partition = optarg;
+			break;
+		case 'r':
+			reset = true;
+			break;
+		default:
+			_usage();
+			exit(1);
+		}
+	}
+	if (!file) {
+		_usage();
+		exit(1);
+	}
+
+	log_init(xbasename(argv[0]), log_opts, 0, NULL);
+	slurm_conf_init(NULL);
+
+	_read_trace(file, format);
+	if ((limit > 0) && (limit < job_cnt)) {
+		for (int i = limit; i < job_cnt; i++)
+			xfree(jobs[i].partition);
+		job_cnt = limit;
+	}
+	info("replaying %d jobs over %.0fs, accelerated %gx",
+	     job_cnt, jobs[job_cnt - 1].submit / accel, accel);
+
+	if (reset) {
+		stats_info_request_msg_t req = {
+			.command_id = STAT_COMMAND_RESET
+		};
+		if (slurm_reset_statistics(&req))
+			error("slurm_reset_statistics: %m");
+	}
+
+	xsignal(SIGINT, _sig_handler);
+	xsignal(SIGTERM, _sig_handler);
+
+	start = _now();
+	_sample(0, 0, false);
+	next_sample = start + interval;
+	while (!stop) {
+		double now = _now(), due;
+
+		if (now >= next_sample) {
+			if ((_sample(now - start, submitted, false) !=
+			     EAGAIN) && (next >= job_cnt))
+				break;
+			next_sample += interval;
+		}
+
+		if (next >= job_cnt) {
+			usleep((next_sample - now) * USEC_IN_SEC);
+			continue;
+		}
+
+		due = start + (jobs[next].submit / accel);
+		if (due > now) {
+			usleep((MIN(due, next_sample) - now) * USEC_IN_SEC);
+			continue;
+		}
+		if (_submit(&jobs[next])) {
+			debug("job %d: submit failed: %s",
+			      next, slurm_strerror(errno));
+			failed++;
+		} else {
+			submitted++;
+		}
+		next++;
+	}
+
+	_sample(_now() - start, submitted, true);
+	if (failed)
+		error("%d of %d jobs failed to submit", failed, next);
+
+	for (int i = 0; i < job_cnt; i++)
+		xfree(jobs[i].partition);
+	xfree(jobs);
+	if (out != stdout)
+		fclose(out);
+	log_fini();
+
+	return 0;
+}
@@ -0,0 +1,493 @@
+/*****************************************************************************\
+ *  sim_slurmd.c - simulate the slurmd daemons of many nodes in one process
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "slurm/slurm.h"
+
+#include "src/common/env.h"
+#include "src/common/hostlist.h"
+#include "src/common/list.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/read_config.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xsignal.h"
+#include "src/common/xstring.h"
+
+/* Run time of jobs launched without SLURM_SIM_RUN_TIME in their env */
+#define DEFAULT_RUN_TIME 60
+
+typedef struct {
+	char *name;
+	uint16_t port;
+	int fd;
+	uint16_t boards;
+	uint16_t cpus;
+	uint16_t cores;
+	uint16_t sockets;
+	uint16_t threads;
+	uint64_t real_memory;
+	uint32_t tmp_disk;
+} sim_node_t;
+
+typedef struct {
+	int fd;
+	slurm_addr_t cli_addr;
+	sim_node_t *node;
+} sim_conn_t;
+
+/* A batch script "running" on its batch host */
+typedef struct {
+	uint64_t end_usec;
+	uint32_t job_id;
+	sim_node_t *node;
+	uint32_t uid;
+} sim_job_t;
+
+static sim_node_t *nodes = NULL;
+static int node_cnt = 0;
+static time_t start_time = 0;
+
+static pthread_mutex_t job_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List job_list = NULL;
+
+static volatile sig_atomic_t shutdown_time = 0;
+
+static uint64_t _now_usec(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return ((uint64_t) tv.tv_sec * USEC_IN_SEC) + tv.tv_usec;
+}
+
+static int _find_job(void *x, void *key)
+{
+	sim_job_t *job = x, *match = key;
+
+	return ((job->job_id == match->job_id) && (job->node == match->node));
+}
+
+static int _find_done_job(void *x, void *key)
+{
+	sim_job_t *job = x;
+
+	return (job->end_usec <= *(uint64_t *) key);
+}
+
+static int _send_registration(sim_node_t *node)
+{
+	slurm_node_registration_status_msg_t *reg;
+	slurm_msg_t msg;
+	ListIterator itr;
+	sim_job_t *job;
+	int rc = SLURM_SUCCESS;
+
+	reg = xmalloc(sizeof(*reg));
+	reg->node_name = xstrdup(node->name);
+	reg->version = xstrdup(SLURM_VERSION_STRING);
+	reg->arch = xstrdup("sim");
+	reg->os = xstrdup("simulated");
+	reg->boards = node->boards;
+	reg->cpus = node->cpus;
+	reg->sockets = node->sockets;
+	reg->cores = node->cores;
+	reg->threads = node->threads;
+	reg->real_memory = node->real_memory;
+	reg->free_mem = node->real_memory;
+	reg->tmp_disk = node->tmp_disk;
+	reg->hash_val = slurm_conf.hash_val;
+	reg->slurmd_start_time = start_time;
+	reg->timestamp = time(NULL);
+	reg->up_time = reg->timestamp - start_time;
+
+	/* Report the batch scripts still "running", or they get killed */
+	slurm_mutex_lock(&job_mutex);
+	reg->step_id = xcalloc(list_count(job_list) + 1,
+			       sizeof(*reg->step_id));
+	itr = list_iterator_create(job_list);
+	while ((job = list_next(itr))) {
+		if (job->node != node)
+			continue;
+		reg->step_id[reg->job_count].job_id = job->job_id;
+		reg->step_id[reg->job_count].step_id = SLURM_BATCH_SCRIPT;
+		reg->step_id[reg->job_count].step_het_comp = NO_VAL;
+		reg->job_count++;
+	}
+	list_iterator_destroy(itr);
+	slurm_mutex_unlock(&job_mutex);
+
+	slurm_msg_t_init(&msg);
+	msg.msg_type = MESSAGE_NODE_REGISTRATION_STATUS;
+	msg.data = reg;
+	if (slurm_send_recv_controller_rc_msg(&msg, &rc, NULL) < 0) {
+		error("%s: unable to register: %m", node->name);
+		rc = SLURM_ERROR;
+	} else if (rc) {
+		error("%s: registration rejected: %s",
+		      node->name, slurm_strerror(rc));
+	}
+	slurm_free_node_registration_status_msg(reg);
+
+	return rc;
+}
+
+static void _send_batch_complete(sim_job_t *job)
+{
+	complete_batch_script_msg_t req;
+	slurm_msg_t msg;
+	int rc = SLURM_SUCCESS;
+
+	memset(&req, 0, sizeof(req));
+	req.job_id = job->job_id;
+	req.node_name = job->node->name;
+	req.user_id = job->uid;
+
+	slurm_msg_t_init(&msg);
+	msg.msg_type = REQUEST_COMPLETE_BATCH_SCRIPT;
+	msg.data = &req;
+	if (slurm_send_recv_controller_rc_msg(&msg, &rc, NULL) < 0)
+		error("JobId=%u: unable to send batch completion: %m",
+		      job->job_id);
+	else
+		debug("JobId=%u: batch script completed on %s, rc=%d",
+		      job->job_id, job->node->name, rc);
+}
+
+static void _send_epilog_complete(uint32_t job_id, sim_node_t *node)
+{
+	epilog_complete_msg_t req;
+	slurm_msg_t msg;
+
+	memset(&req, 0, sizeof(req));
+	req.job_id = job_id;
+	req.node_name = node->name;
+
+	slurm_msg_t_init(&msg);
+	msg.msg_type = MESSAGE_EPILOG_COMPLETE;
+	msg.data = &req;
+	if (slurm_send_only_controller_msg(&msg, NULL) < 0)
+		error("JobId=%u: unable to send epilog complete for %s: %m",
+		      job_id, node->name);
+}
+
+static void _send_prolog_complete(uint32_t job_id)
+{
+	complete_prolog_msg_t req;
+	slurm_msg_t msg;
+	int rc;
+
+	memset(&req, 0, sizeof(req));
+	req.job_id = job_id;
+
+	slurm_msg_t_init(&msg);
+	msg.msg_type = REQUEST_COMPLETE_PROLOG;
+	msg.data = &req;
+	if (slurm_send_recv_controller_rc_msg(&msg, &rc, NULL) < 0)
+		error("JobId=%u: unable to send prolog complete: %m", job_id);
+}
+
+static void _batch_launch(slurm_msg_t *msg, sim_node_t *node)
+{
+	batch_job_launch_msg_t *req = msg->data;
+	sim_job_t *job = xmalloc(sizeof(*job));
+	char *run_time_str;
+	double run_time = DEFAULT_RUN_TIME;
+
+	if ((run_time_str = getenvp(req->environment, "SLURM_SIM_RUN_TIME")))
+		run_time = strtod(run_time_str, NULL);
+
+	job->job_id = req->job_id;
+	job->node = node;
+	job->uid = req->uid;
+	job->end_usec = _now_usec() + (uint64_t) (run_time * USEC_IN_SEC);
+
+	slurm_mutex_lock(&job_mutex);
+	list_append(job_list, job);
+	slurm_mutex_unlock(&job_mutex);
+
+	debug("JobId=%u: batch script started on %s for %.3fs",
+	      req->job_id, node->name, run_time);
+	slurm_send_rc_msg(msg, SLURM_SUCCESS);
+}
+
+static void _terminate_job(slurm_msg_t *msg, sim_node_t *node)
+{
+	kill_job_msg_t *req = msg->data;
+	sim_job_t key = {
+		.job_id = req->step_id.job_id,
+		.node = node,
+	};
+
+	slurm_send_rc_msg(msg, SLURM_SUCCESS);
+
+	slurm_mutex_lock(&job_mutex);
+	list_delete_all(job_list, _find_job, &key);
+	slurm_mutex_unlock(&job_mutex);
+
+	/* Like slurmd, an aborted job gets no epilog */
+	if (msg->msg_type != REQUEST_ABORT_JOB)
+		_send_epilog_complete(req->step_id.job_id, node);
+}
+
+static void *_service_connection(void *arg)
+{
+	sim_conn_t *con = arg;
+	slurm_msg_t *msg = xmalloc(sizeof(slurm_msg_t));
+	int rc;
+
+	slurm_msg_t_init(msg);
+	/* Forwards the RPC to the other nodes on its list, like slurmd */
+	if ((rc = slurm_receive_msg_and_forward(con->fd, &con->cli_addr,
+						msg))) {
+		error("%s: slurm_receive_msg: %m", con->node->name);
+		slurm_send_rc_msg(msg, rc);
+		goto cleanup;
+	}
+
+	debug2("%s: processing RPC: %s",
+	       con->node->name, rpc_num2string(msg->msg_type));
+	switch (msg->msg_type) {
+	case REQUEST_BATCH_JOB_LAUNCH:
+		_batch_launch(msg, con->node);
+		break;
+	case REQUEST_LAUNCH_PROLOG:
+		slurm_send_rc_msg(msg, SLURM_SUCCESS);
+		_send_prolog_complete(
+			((prolog_launch_msg_t *) msg->data)->job_id);
+		break;
+	case REQUEST_ABORT_JOB:
+	case REQUEST_KILL_PREEMPTED:
+	case REQUEST_KILL_TIMELIMIT:
+	case REQUEST_TERMINATE_JOB:
+		_terminate_job(msg, con->node);
+		break;
+	case REQUEST_NODE_REGISTRATION_STATUS:
+		slurm_send_rc_msg(msg, SLURM_SUCCESS);
+		_send_registration(con->node);
+		break;
+	case REQUEST_SHUTDOWN:
+		slurm_send_rc_msg(msg, SLURM_SUCCESS);
+		shutdown_time = time(NULL);
+		break;
+	case REQUEST_LAUNCH_TASKS:
+		/* Job steps are not simulated */
+		slurm_send_rc_msg(msg, ESLURM_NOT_SUPPORTED);
+		break;
+	default:
+		/* Pings, health checks, reconfigures, signals, ... */
+		slurm_send_rc_msg(msg, SLURM_SUCCESS);
+		break;
+	}
+
+cleanup:
+	if (msg->conn_fd >= 0)
+		close(msg->conn_fd);
+	slurm_free_msg(msg);
+	xfree(con);
+	return NULL;
+}
+
+/* Complete the batch scripts which have run for their simulated time */
+static void *_job_timer(void *arg)
+{
+	List done_list = list_create(xfree_ptr);
+
+	while (!shutdown_time) {
+		uint64_t now = _now_usec();
+		sim_job_t *job;
+
+		slurm_mutex_lock(&job_mutex);
+		while ((job = list_remove_first(job_list, _find_done_job,
+						&now)))
+			list_append(done_list, job);
+		slurm_mutex_unlock(&job_mutex);
+
+		while ((job = list_pop(done_list))) {
+			_send_batch_complete(job);
+			xfree(job);
+		}
+		usleep(100000);
+	}
+
+	FREE_NULL_LIST(done_list);
+	return NULL;
+}
+
+static void _load_nodes(char *node_names)
+{
+	node_info_msg_t *node_info = NULL;
+	hostset_t hs = NULL;
+
+	if (slurm_load_node(0, &node_info, SHOW_ALL))
+		fatal("slurm_load_node: %m");
+	if (node_names && !(hs = hostset_create(node_names)))
+		fatal("invalid node list: %s", node_names);
+
+	nodes = xcalloc(node_info->record_count, sizeof(sim_node_t));
+	for (int i = 0; i < node_info->record_count; i++) {
+		node_info_t *info = &node_info->node_array[i];
+		sim_node_t *node = &nodes[node_cnt];
+
+		if (!info->name || (hs && !hostset_within(hs, info->name)))
+			continue;
+
+		node->name = xstrdup(info->name);
+		node->port = slurm_conf_get_port(info->name);
+		node->boards = info->boards;
+		node->cpus = info->cpus;
+		node->sockets = info->sockets;
+		node->cores = info->cores;
+		node->threads = info->threads;
+		node->real_memory = info->real_memory;
+		node->tmp_disk = info->tmp_disk;
+
+		for (int j = 0; j < node_cnt; j++) {
+			if (nodes[j].port == node->port)
+				fatal("nodes %s and %s both use port %u, give each simulated node its own Port in slurm.conf",
+				      nodes[j].name, node->name, node->port);
+		}
+		if ((node->fd = slurm_init_msg_engine_port(node->port)) < 0)
+			fatal("%s: unable to listen on port %u: %m",
+			      node->name, node->port);
+		node_cnt++;
+	}
+
+	if (hs)
+		hostset_destroy(hs);
+	slurm_free_node_info_msg(node_info);
+
+	if (!node_cnt)
+		fatal("no nodes to simulate");
+}
+
+static void _sig_handler(int signo)
+{
+	shutdown_time = time(NULL);
+}
+
+static void _usage(void)
+{
+	fprintf(stderr,
+"Usage: sim_slurmd [-n nodelist] [-v...]\n"
+"  -n nodelist  only simulate these nodes, default is all nodes\n"
+"  -v           increase verbosity\n");
+}
+
+int main(int argc, char **argv)
+{
+	log_options_t log_opts = LOG_OPTS_STDERR_ONLY;
+	struct pollfd *fds;
+	char *node_names = NULL;
+	pthread_t timer_tid;
+	int c;
+
+	while ((c = getopt(argc, argv, "hn:v")) != -1) {
+		switch (c) {
+		case 'n':
+			node_names = optarg;
+			break;
+		case 'v':
+			log_opts.stderr_level++;
+			break;
+		default:
+			_usage();
+			exit(1);
+		}
+	}
+
+	log_init(xbasename(argv[0]), log_opts, 0, NULL);
+	slurm_conf_init(NULL);
+	start_time = time(NULL);
+	job_list = list_create(xfree_ptr);
+
+	_load_nodes(node_names);
+	info("simulating %d nodes", node_cnt);
+
+	xsignal(SIGINT, _sig_handler);
+	xsignal(SIGTERM, _sig_handler);
+	xsignal(SIGPIPE, SIG_IGN);
+
+	slurm_thread_create(&timer_tid, _job_timer, NULL);
+
+	for (int i = 0; i < node_cnt; i++)
+		_send_registration(&nodes[i]);
+
+	fds = xcalloc(node_cnt, sizeof(struct pollfd));
+	for (int i = 0; i < node_cnt; i++) {
+		fds[i].fd = nodes[i].fd;
+		fds[i].events = POLLIN;
+	}
+
+	while (!shutdown_time) {
+		if (poll(fds, node_cnt, 1000) <= 0)
+			continue;
+		for (int i = 0; i < node_cnt; i++) {
+			sim_conn_t *con;
+
+			if (!(fds[i].revents & POLLIN))
+				continue;
+			con = xmalloc(sizeof(*con));
+			con->node = &nodes[i];
+			if ((con->fd = slurm_accept_msg_conn(
+				     nodes[i].fd, &con->cli_addr)) < 0) {
+				error("%s: accept: %m", nodes[i].name);
+				xfree(con);
+				continue;
+			}
+			slurm_thread_create_detached(NULL, _service_connection,
+						     con);
+		}
+	}
+
+	pthread_join(timer_tid, NULL);
+	for (int i = 0; i < node_cnt; i++) {
+		close(nodes[i].fd);
+		xfree(nodes[i].name);
+	}
+	xfree(nodes);
+	xfree(fds);
+	FREE_NULL_LIST(job_list);
+	log_fini();
+
+	return 0;
+}
@@ -201,6 +201,10 @@ enum cluster_fed_states {
 #define JOBCOND_FLAG_NO_DEFAULT_USAGE 0x00000080 /* Use usage_time as the
 						  * submit_time of the job.
 						  */
+#define JOBCOND_FLAG_MOD_TIME         0x00000100 /* Select jobs whose record
+						  * was modified between
+						  * usage_start and usage_end.
+						  */
 
 /* Archive / Purge time flags */
 #define SLURMDB_PURGE_BASE    0x0000ffff   /* Apply to get the number
@@ -0,0 +1,131 @@
+/*****************************************************************************\
+ *  ctld_event.c - get job and node state change events from slurmctld
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#include <errno.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "slurm/slurm.h"
+
+#include "src/common/read_config.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/xmalloc.h"
+
+#define CTLD_EVENT_WAIT 30	/* seconds per request when subscribed */
+
+/*
+ * slurm_load_ctld_events - get the job and node state changes recorded by
+ *	slurmctld since a sequence number
+ * Use slurm_free_ctld_event_msg() to free the memory allocated by this
+ * function
+ * RET 0 or -1 on error
+ */
+extern int slurm_load_ctld_events(uint64_t since_seq,
+				  ctld_event_filter_t *filter, uint16_t wait,
+				  ctld_event_msg_t **resp)
+{
+	int rc;
+	slurm_msg_t resp_msg;
+	slurm_msg_t req_msg;
+	ctld_event_req_msg_t req;
+
+	slurm_msg_t_init(&req_msg);
+	slurm_msg_t_init(&resp_msg);
+
+	memset(&req, 0, sizeof(req));
+	if (filter)
+		req.filter = *filter;
+	else
+		req.filter.user_id = NO_VAL;
+	req.since_seq = since_seq;
+	/* Reply well within the time we wait for it */
+	req.wait = MIN(wait, slurm_conf.msg_timeout / 2);
+	req_msg.msg_type = REQUEST_CTLD_EVENTS;
+	req_msg.data = &req;
+
+	if (slurm_send_recv_controller_msg(&req_msg, &resp_msg,
+					   working_cluster_rec) < 0)
+		return SLURM_ERROR;
+
+	switch (resp_msg.msg_type) {
+	case RESPONSE_CTLD_EVENTS:
+		*resp = (ctld_event_msg_t *) resp_msg.data;
+		break;
+	case RESPONSE_SLURM_RC:
+		rc = ((return_code_msg_t *) resp_msg.data)->return_code;
+		slurm_free_return_code_msg(resp_msg.data);
+		if (rc)
+			slurm_seterrno_ret(rc);
+		*resp = NULL;
+		break;
+	default:
+		slurm_seterrno_ret(SLURM_UNEXPECTED_MSG_ERROR);
+		break;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * slurm_ctld_event_subscribe - call a function for every job and node state
+ *	change recorded by slurmctld from now on
+ * RET 0 or -1 on error
+ */
+extern int slurm_ctld_event_subscribe(ctld_event_filter_t *filter,
+				      int (*callback)(ctld_event_t *event,
+						      void *arg),
+				      void *arg)
+{
+	ctld_event_msg_t *resp = NULL;
+	uint64_t since_seq = 0;
+	uint32_t i;
+	int rc = 0;
+
+	while (!rc) {
+		if (slurm_load_ctld_events(since_seq, filter, CTLD_EVENT_WAIT,
+					   &resp) != SLURM_SUCCESS)
+			return SLURM_ERROR;
+		if (!resp)
+			continue;
+		for (i = 0; !rc && (i < resp->record_count); i++)
+			rc = (*callback)(&resp->event_array[i], arg);
+		/* 0 is "from now on", never ask for that again */
+		since_seq = MAX(resp->next_seq - 1, 1);
+		slurm_free_ctld_event_msg(resp);
+		resp = NULL;
+	}
+
+	return SLURM_SUCCESS;
+}
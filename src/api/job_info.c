@@ -334,6 +334,32 @@ slurm_print_job_info ( FILE* out, job_info_t * job_ptr, int one_liner )
 	_free_node_info();
 }
 
+/* Print the batch launch stages reached in seconds since the allocation */
+static void _sprint_launch_time(job_info_t *job_ptr, char **out,
+				char *line_end)
+{
+	uint64_t alloc = job_ptr->launch_time[JOB_LAUNCH_ALLOC];
+	char *sep = "LaunchTimes=";
+	bool found = false;
+
+	if (!alloc)
+		return;
+
+	for (int i = JOB_LAUNCH_ALLOC + 1; i < JOB_LAUNCH_STAGE_CNT; i++) {
+		int64_t delta;
+
+		if (!job_ptr->launch_time[i])
+			continue;
+		delta = (int64_t) (job_ptr->launch_time[i] - alloc);
+		xstrfmtcat(*out, "%s%s:%.3f", sep, job_launch_stage_string(i),
+			   (double) delta / USEC_IN_SEC);
+		sep = ",";
+		found = true;
+	}
+	if (found)
+		xstrcat(*out, line_end);
+}
+
 /*
  * slurm_sprint_job_info - output information about a specific Slurm
  *	job based upon message as loaded using slurm_load_jobs
@@ -540,6 +566,9 @@ slurm_sprint_job_info ( job_info_t * job_ptr, int one_liner )
 
 	xstrcat(out, line_end);
 
+	/****** Line 9a (optional) ******/
+	_sprint_launch_time(job_ptr, &out, line_end);
+
 	/****** Line ******/
 
 	if (job_ptr->bitflags & CRON_JOB || job_ptr->cronspec) {
@@ -1315,6 +1344,24 @@ extern int slurm_job_batch_script(FILE *out, uint32_t jobid)
 extern int
 slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 		 uint16_t show_flags)
+{
+	return slurm_load_jobs_filter(update_time, job_info_msg_pptr,
+				      show_flags, NULL);
+}
+
+/*
+ * slurm_load_jobs_filter - equivalent to slurm_load_jobs() but only return
+ *	the jobs matching filter, which slurmctld applies before packing
+ * IN update_time - time of current configuration data
+ * IN/OUT job_info_msg_pptr - place to store a job configuration pointer
+ * IN show_flags -  job filtering option: 0, SHOW_ALL, SHOW_DETAIL or SHOW_LOCAL
+ * IN filter - record filter or NULL for all jobs
+ * RET 0 or -1 on error
+ * NOTE: free the response using slurm_free_job_info_msg
+ */
+extern int slurm_load_jobs_filter(time_t update_time,
+				  job_info_msg_t **job_info_msg_pptr,
+				  uint16_t show_flags, info_filter_t *filter)
 {
 	slurm_msg_t req_msg;
 	job_info_request_msg_t req;
@@ -1344,6 +1391,8 @@ slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 	memset(&req, 0, sizeof(req));
 	req.last_update  = update_time;
 	req.show_flags   = show_flags;
+	if (filter)
+		req.filter = *filter;
 	req_msg.msg_type = REQUEST_JOB_INFO;
 	req_msg.data     = &req;
 
@@ -1374,6 +1423,25 @@ slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 extern int slurm_load_job_user (job_info_msg_t **job_info_msg_pptr,
 				uint32_t user_id,
 				uint16_t show_flags)
+{
+	return slurm_load_job_user_update((time_t) 0, job_info_msg_pptr,
+					  user_id, show_flags);
+}
+
+/*
+ * slurm_load_job_user_update - issue RPC to get slurm information about all
+ *	jobs to be run as the specified user if changed since update_time
+ * IN update_time - time of current job data, 0 to always load
+ * IN/OUT job_info_msg_pptr - place to store a job configuration pointer
+ * IN user_id - ID of user we want information for
+ * IN show_flags - job filtering options
+ * RET 0 or -1 on error
+ * NOTE: free the response using slurm_free_job_info_msg
+ */
+extern int slurm_load_job_user_update(time_t update_time,
+				      job_info_msg_t **job_info_msg_pptr,
+				      uint32_t user_id,
+				      uint16_t show_flags)
 {
 	slurm_msg_t req_msg;
 	job_user_id_msg_t req;
@@ -1391,6 +1459,7 @@ extern int slurm_load_job_user (job_info_msg_t **job_info_msg_pptr,
 
 	slurm_msg_t_init(&req_msg);
 	memset(&req, 0, sizeof(req));
+	req.last_update  = update_time;
 	req.show_flags   = show_flags;
 	req.user_id      = user_id;
 	req_msg.msg_type = REQUEST_JOB_USER_INFO;
@@ -1402,6 +1471,8 @@ extern int slurm_load_job_user (job_info_msg_t **job_info_msg_pptr,
 		rc = _load_cluster_jobs(&req_msg, job_info_msg_pptr,
 					working_cluster_rec);
 	} else {
+		/* Need full info from all clusters */
+		req.last_update = (time_t) 0;
 		fed = (slurmdb_federation_rec_t *) ptr;
 		rc = _load_fed_jobs(&req_msg, job_info_msg_pptr, show_flags,
 				    slurm_conf.cluster_name, fed);
@@ -1717,6 +1788,41 @@ extern int slurm_job_node_ready(uint32_t job_id)
 	return rc;
 }
 
+/*
+ * slurm_job_wait_register - ask slurmctld to notify the given port on this
+ *	host once any of the jobs ends
+ * IN job_ids - job ids to watch
+ * IN job_cnt - number of job_ids
+ * IN port - port this host listens on for the notification
+ * RET 0 or -1 on error
+ */
+extern int slurm_job_wait_register(uint32_t *job_ids, uint32_t job_cnt,
+				   uint16_t port)
+{
+	int rc;
+	slurm_msg_t msg;
+	job_wait_notify_msg_t req;
+
+	slurm_msg_t_init(&msg);
+	memset(&req, 0, sizeof(req));
+	req.job_ids  = job_ids;
+	req.job_cnt  = job_cnt;
+	req.port     = port;
+	msg.msg_type = REQUEST_JOB_WAIT_NOTIFY;
+	msg.data     = &req;
+
+	if (slurm_send_recv_controller_rc_msg(&msg, &rc,
+					      working_cluster_rec) < 0)
+		return SLURM_ERROR;
+
+	if (rc) {
+		slurm_seterrno_ret(rc);
+		return SLURM_ERROR;
+	}
+
+	return SLURM_SUCCESS;
+}
+
 extern int slurm_job_cpus_allocated_on_node_id(
 	job_resources_t *job_resrcs_ptr, int node_id)
 {
@@ -534,19 +534,9 @@ extern slurm_step_layout_t *slurm_job_step_layout_get(slurm_step_id_t *step_id)
 	}
 }
 
-/*
- * slurm_job_step_stat - status a current step
- *
- * IN step_id
- * IN node_list, optional, if NULL then all nodes in step are returned.
- * IN use_protocol_ver protocol version to use.
- * OUT resp
- * RET SLURM_SUCCESS on success SLURM_ERROR else
- */
-extern int slurm_job_step_stat(slurm_step_id_t *step_id,
-			       char *node_list,
-			       uint16_t use_protocol_ver,
-			       job_step_stat_response_msg_t **resp)
+static int _job_step_stat(slurm_step_id_t *step_id, char *node_list,
+			  uint16_t use_protocol_ver, uint16_t msg_flags,
+			  job_step_stat_response_msg_t **resp)
 {
 	slurm_msg_t req_msg;
 	ListIterator itr;
@@ -590,6 +580,7 @@ extern int slurm_job_step_stat(slurm_step_id_t *step_id,
 
 	req_msg.protocol_version = use_protocol_ver;
 	req_msg.msg_type = REQUEST_JOB_STEP_STAT;
+	req_msg.flags = msg_flags;
 	req_msg.data = &req;
 
 	if (!(ret_list = slurm_send_recv_msgs(node_list, &req_msg, 0))) {
@@ -648,6 +639,43 @@ cleanup:
 	return rc;
 }
 
+/*
+ * slurm_job_step_stat - status a current step
+ *
+ * IN step_id
+ * IN node_list, optional, if NULL then all nodes in step are returned.
+ * IN use_protocol_ver protocol version to use.
+ * OUT resp
+ * RET SLURM_SUCCESS on success SLURM_ERROR else
+ */
+extern int slurm_job_step_stat(slurm_step_id_t *step_id,
+			       char *node_list,
+			       uint16_t use_protocol_ver,
+			       job_step_stat_response_msg_t **resp)
+{
+	return _job_step_stat(step_id, node_list, use_protocol_ver, 0, resp);
+}
+
+/*
+ * slurm_job_step_stat_aggregate - status a current step, letting the nodes
+ *	forwarding the request merge the accounting of the nodes below them
+ *	into their own response
+ *
+ * IN step_id
+ * IN node_list, optional, if NULL then all nodes in step are returned.
+ * IN use_protocol_ver protocol version to use.
+ * OUT resp
+ * RET SLURM_SUCCESS on success SLURM_ERROR else
+ */
+extern int slurm_job_step_stat_aggregate(slurm_step_id_t *step_id,
+					 char *node_list,
+					 uint16_t use_protocol_ver,
+					 job_step_stat_response_msg_t **resp)
+{
+	return _job_step_stat(step_id, node_list, use_protocol_ver,
+			      SLURM_MSG_AGGREGATE, resp);
+}
+
 /*
  * slurm_job_step_get_pids - get the complete list of pids for a given
  *      job step
@@ -685,6 +685,22 @@ static int _load_fed_nodes(slurm_msg_t *req_msg,
  */
 extern int slurm_load_node(time_t update_time, node_info_msg_t **resp,
 			   uint16_t show_flags)
+{
+	return slurm_load_node_filter(update_time, resp, show_flags, NULL);
+}
+
+/*
+ * slurm_load_node_filter - equivalent to slurm_load_node() but slurmctld
+ *	reports nodes not matching filter as hidden records with no name
+ * IN update_time - time of current configuration data
+ * OUT resp - place to store a node configuration pointer
+ * IN show_flags - node filtering options
+ * IN filter - record filter or NULL for all nodes
+ * RET 0 or a slurm error code
+ * NOTE: free the response using slurm_free_node_info_msg
+ */
+extern int slurm_load_node_filter(time_t update_time, node_info_msg_t **resp,
+				  uint16_t show_flags, info_filter_t *filter)
 {
 	slurm_msg_t req_msg;
 	node_info_request_msg_t req;
@@ -714,6 +730,8 @@ extern int slurm_load_node(time_t update_time, node_info_msg_t **resp,
 	memset(&req, 0, sizeof(req));
 	req.last_update  = update_time;
 	req.show_flags   = show_flags;
+	if (filter)
+		req.filter = *filter;
 	req_msg.msg_type = REQUEST_NODE_INFO;
 	req_msg.data     = &req;
 
@@ -110,3 +110,42 @@ extern int slurm_get_statistics(stats_info_response_msg_t **buf,
 
 	return SLURM_SUCCESS;
 }
+
+extern int slurm_get_ctld_profile(char **folded)
+{
+	int rc;
+	slurm_msg_t req_msg;
+	slurm_msg_t resp_msg;
+	ctld_profile_msg_t *profile_msg;
+
+	slurm_msg_t_init(&req_msg);
+	slurm_msg_t_init(&resp_msg);
+
+	req_msg.msg_type = REQUEST_CTLD_PROFILE;
+	*folded = NULL;
+
+	rc = slurm_send_recv_controller_msg(&req_msg, &resp_msg,
+					    working_cluster_rec);
+
+	if (rc == SLURM_ERROR)
+		return SLURM_ERROR;
+
+	switch (resp_msg.msg_type) {
+		case RESPONSE_CTLD_PROFILE:
+			profile_msg = (ctld_profile_msg_t *) resp_msg.data;
+			*folded = profile_msg->folded;
+			profile_msg->folded = NULL;
+			slurm_free_ctld_profile_msg(profile_msg);
+			break;
+		case RESPONSE_SLURM_RC:
+			rc = ((return_code_msg_t *) resp_msg.data)->return_code;
+			slurm_free_return_code_msg(resp_msg.data);
+			if (rc)
+				slurm_seterrno_ret(rc);
+			break;
+		default:
+			slurm_seterrno_ret(SLURM_UNEXPECTED_MSG_ERROR);
+	}
+
+	return SLURM_SUCCESS;
+}
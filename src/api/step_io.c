@@ -28,7 +28,6 @@
 #include <arpa/inet.h>
 #include <errno.h>
 #include <fcntl.h>
-#include <poll.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -879,37 +878,23 @@ static int _read_io_init_msg(int fd, client_io_t *cio, slurm_addr_t *host)
 }
 
 
-static bool
-_is_fd_ready(int fd)
-{
-	struct pollfd pfd[1];
-	int    rc;
-
-	pfd[0].fd     = fd;
-	pfd[0].events = POLLIN;
-
-	rc = poll(pfd, 1, 10);
-
-	return ((rc == 1) && (pfd[0].revents & POLLIN));
-}
-
-
 static void
 _handle_io_init_msg(int fd, client_io_t *cio)
 {
 	int j;
 	debug2("Activity on IO listening socket %d", fd);
 
+	/*
+	 * The listening sockets are non-blocking, so just accept until
+	 * EAGAIN. Polling the fd before each accept() used to cost an extra
+	 * syscall per connection plus a 10ms stall of the whole eio loop
+	 * every time the backlog was drained, which added up to seconds
+	 * while thousands of slurmstepds connect at step launch.
+	 */
 	for (j = 0; j < 15; j++) {
 		int sd;
 		slurm_addr_t addr;
 
-		/*
-		 * Return early if fd is not now ready
-		 */
-		if (!_is_fd_ready(fd))
-			return;
-
 		while ((sd = slurm_accept_msg_conn(fd, &addr)) < 0) {
 			if (errno == EINTR)
 				continue;
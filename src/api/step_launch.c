@@ -84,6 +84,8 @@
 #include "src/api/pmi_server.h"
 
 #define STEP_ABORT_TIME 2
+#define MAX_MSG_WORKERS 8
+#define MAX_ASYNC_CREATE 16	/* step create RPCs in flight per process */
 
 extern char **environ;
 
@@ -103,18 +105,40 @@ static void _print_launch_msg(launch_tasks_request_msg_t *msg,
 static bool   force_terminated_job = false;
 static int    task_exit_signal = 0;
 
+/* steps started by slurm_step_launch_async() */
+typedef struct {
+	slurm_step_ctx_params_t step_params;
+	slurm_step_launch_params_t launch_params;
+	slurm_step_launch_callbacks_t callbacks;
+	void (*done)(slurm_step_ctx_t *ctx, int rc, void *arg);
+	void *arg;
+} async_step_t;
+
+static pthread_mutex_t async_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t async_cond = PTHREAD_COND_INITIALIZER;
+static int async_creating = 0;	/* step create RPCs in flight */
+static int async_running = 0;	/* steps started and not yet done */
+
+static void *_async_step(void *arg);
 static void _exec_prog(slurm_msg_t *msg);
 static int  _msg_thr_create(struct step_launch_state *sls, int num_nodes);
+static void _msg_thr_destroy(struct step_launch_state *sls);
+static int  _msg_socket_accept(eio_obj_t *obj, List objs);
 static void _handle_msg(void *arg, slurm_msg_t *msg);
 static int  _cr_notify_step_launch(slurm_step_ctx_t *ctx);
 static void *_check_io_timeout(void *_sls);
 
 static struct io_operations message_socket_ops = {
 	.readable = &eio_message_socket_readable,
-	.handle_read = &eio_message_socket_accept,
+	.handle_read = &_msg_socket_accept,
 	.handle_msg = &_handle_msg
 };
 
+typedef struct {
+	slurm_addr_t addr;
+	int fd;
+} msg_conn_t;
+
 
 /**********************************************************************
  * API functions
@@ -782,6 +806,7 @@ void slurm_step_launch_wait_finish(slurm_step_ctx_t *ctx)
 	slurm_mutex_unlock(&sls->lock);
 	if (sls->msg_thread)
 		pthread_join(sls->msg_thread, NULL);
+	_msg_thr_destroy(sls);
 	slurm_mutex_lock(&sls->lock);
 	pmi_kvs_free();
 
@@ -948,6 +973,53 @@ RESEND:	slurm_msg_t_init(&req);
 	xfree(name);
 }
 
+/*
+ * slurm_step_launch_async - create and launch a job step from a
+ *	background thread, see slurm.h
+ */
+extern int slurm_step_launch_async(const slurm_step_ctx_params_t *step_params,
+				   const slurm_step_launch_params_t *params,
+				   const slurm_step_launch_callbacks_t *callbacks,
+				   void (*done)(slurm_step_ctx_t *ctx, int rc,
+						void *arg),
+				   void *arg)
+{
+	async_step_t *step;
+
+	if (!step_params || !params) {
+		slurm_seterrno(EINVAL);
+		return SLURM_ERROR;
+	}
+
+	step = xmalloc(sizeof(*step));
+	step->step_params = *step_params;
+	step->launch_params = *params;
+	if (callbacks)
+		step->callbacks = *callbacks;
+	step->done = done;
+	step->arg = arg;
+
+	slurm_mutex_lock(&async_mutex);
+	async_running++;
+	slurm_mutex_unlock(&async_mutex);
+
+	slurm_thread_create_detached(NULL, _async_step, step);
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * slurm_step_launch_async_wait - wait for all the steps started with
+ *	slurm_step_launch_async() to be done, see slurm.h
+ */
+extern void slurm_step_launch_async_wait(void)
+{
+	slurm_mutex_lock(&async_mutex);
+	while (async_running)
+		slurm_cond_wait(&async_cond, &async_mutex);
+	slurm_mutex_unlock(&async_mutex);
+}
+
 /**********************************************************************
  * Functions used by step_ctx code, but not exported throught the API
  **********************************************************************/
@@ -983,6 +1055,9 @@ struct step_launch_state *step_launch_state_create(slurm_step_ctx_t *ctx)
 	sls->mpi_state = NULL;
 	slurm_mutex_init(&sls->lock);
 	slurm_cond_init(&sls->cond, NULL);
+	slurm_mutex_init(&sls->msg_lock);
+	slurm_cond_init(&sls->msg_cond, NULL);
+	slurm_mutex_init(&sls->msg_handler_lock);
 
 	for (ii = 0; ii < layout->node_cnt; ii++) {
 		sls->io_deadline[ii] = (time_t)NO_VAL;
@@ -1021,6 +1096,9 @@ void step_launch_state_destroy(struct step_launch_state *sls)
 	/* First undo anything created in step_launch_state_create() */
 	slurm_mutex_destroy(&sls->lock);
 	slurm_cond_destroy(&sls->cond);
+	slurm_mutex_destroy(&sls->msg_lock);
+	slurm_cond_destroy(&sls->msg_cond);
+	slurm_mutex_destroy(&sls->msg_handler_lock);
 	FREE_NULL_BITMAP(sls->tasks_started);
 	FREE_NULL_BITMAP(sls->tasks_exited);
 	FREE_NULL_BITMAP(sls->node_io_error);
@@ -1117,6 +1195,79 @@ static int _cr_notify_step_launch(slurm_step_ctx_t *ctx)
 	return rc;
 }
 
+/**********************************************************************
+ * Asynchronous step launch functions
+ **********************************************************************/
+/* Create the step, retrying while the allocation is busy */
+static slurm_step_ctx_t *_async_step_create(async_step_t *step)
+{
+	slurm_step_ctx_t *ctx;
+	int delay = 0, rc;
+
+	while (1) {
+		/* limit the step create RPCs queued at the slurmctld */
+		slurm_mutex_lock(&async_mutex);
+		while (async_creating >= MAX_ASYNC_CREATE)
+			slurm_cond_wait(&async_cond, &async_mutex);
+		async_creating++;
+		slurm_mutex_unlock(&async_mutex);
+
+		ctx = slurm_step_ctx_create(&step->step_params);
+		rc = slurm_get_errno();
+
+		slurm_mutex_lock(&async_mutex);
+		async_creating--;
+		slurm_cond_broadcast(&async_cond);
+		slurm_mutex_unlock(&async_mutex);
+
+		if (ctx || !slurm_step_retry_errno(rc))
+			return ctx;
+
+		if (delay < 60)
+			delay++;
+		debug("%s: step creation temporarily disabled, retrying in %d sec: %s",
+		      __func__, delay, slurm_strerror(rc));
+		sleep(delay);
+	}
+}
+
+static void *_async_step(void *arg)
+{
+	async_step_t *step = arg;
+	slurm_step_ctx_t *ctx;
+	int rc = SLURM_SUCCESS;
+
+	if (!(ctx = _async_step_create(step))) {
+		rc = slurm_get_errno();
+		error("%s: unable to create step for job %u: %s",
+		      __func__, step->step_params.step_id.job_id,
+		      slurm_strerror(rc));
+	} else if (slurm_step_launch(ctx, &step->launch_params,
+				     &step->callbacks) != SLURM_SUCCESS) {
+		rc = errno;
+		error("%s: launch of %ps failed: %m",
+		      __func__, &ctx->step_req->step_id);
+		slurm_step_launch_abort(ctx);
+		slurm_step_launch_wait_finish(ctx);
+	} else {
+		rc = slurm_step_launch_wait_start(ctx);
+		slurm_step_launch_wait_finish(ctx);
+	}
+
+	if (step->done)
+		(step->done)(ctx, rc, step->arg);
+	if (ctx)
+		slurm_step_ctx_destroy(ctx);
+	xfree(step);
+
+	slurm_mutex_lock(&async_mutex);
+	async_running--;
+	slurm_cond_broadcast(&async_cond);
+	slurm_mutex_unlock(&async_mutex);
+
+	return NULL;
+}
+
 /**********************************************************************
  * Message handler functions
  **********************************************************************/
@@ -1129,6 +1280,132 @@ static void *_msg_thr_internal(void *arg)
 	return NULL;
 }
 
+static void _free_msg_conn(void *x)
+{
+	msg_conn_t *conn = x;
+
+	if (!conn)
+		return;
+
+	close(conn->fd);
+	xfree(conn);
+}
+
+/*
+ * Accept every pending connection on a message socket and queue them for
+ * the message workers. Receiving a message includes verifying its
+ * credential, which at launch and termination of a large step has to be
+ * done for a burst of connections from every node, so leave that to
+ * several threads rather than handle one connection at a time here.
+ */
+static int _msg_socket_accept(eio_obj_t *obj, List objs)
+{
+	struct step_launch_state *sls = obj->arg;
+	slurm_addr_t addr;
+	msg_conn_t *conn;
+	int fd;
+
+	while (1) {
+		if ((fd = slurm_accept_msg_conn(obj->fd, &addr)) < 0) {
+			if (errno == EINTR)
+				continue;
+			if ((errno == EAGAIN) ||
+			    (errno == ECONNABORTED) ||
+			    (errno == EWOULDBLOCK))
+				return SLURM_SUCCESS;
+			error("Error on msg accept socket: %m");
+			if ((errno == EMFILE)  ||
+			    (errno == ENFILE)  ||
+			    (errno == ENOBUFS) ||
+			    (errno == ENOMEM))
+				return SLURM_SUCCESS;
+			obj->shutdown = true;
+			return SLURM_SUCCESS;
+		}
+
+		net_set_keep_alive(fd);
+		fd_set_close_on_exec(fd);
+		fd_set_blocking(fd);
+
+		debug2("%s: got message connection from %pA %d",
+		       __func__, &addr, fd);
+
+		conn = xmalloc(sizeof(*conn));
+		conn->addr = addr;
+		conn->fd = fd;
+
+		slurm_mutex_lock(&sls->msg_lock);
+		list_enqueue(sls->msg_conns, conn);
+		slurm_cond_signal(&sls->msg_cond);
+		slurm_mutex_unlock(&sls->msg_lock);
+	}
+}
+
+/*
+ * Receive the messages of the accepted connections. The handlers (and the
+ * callbacks they call) still run one at a time, as they did when called
+ * from the eio thread.
+ */
+static void *_msg_worker(void *arg)
+{
+	struct step_launch_state *sls = arg;
+	msg_conn_t *conn;
+	slurm_msg_t *msg;
+
+	while (1) {
+		slurm_mutex_lock(&sls->msg_lock);
+		while (!(conn = list_dequeue(sls->msg_conns)) &&
+		       !sls->msg_shutdown)
+			slurm_cond_wait(&sls->msg_cond, &sls->msg_lock);
+		slurm_mutex_unlock(&sls->msg_lock);
+		if (!conn)
+			break;
+
+		msg = xmalloc(sizeof(slurm_msg_t));
+		slurm_msg_t_init(msg);
+again:
+		if (slurm_receive_msg(conn->fd, msg,
+				      message_socket_ops.timeout) != 0) {
+			if (errno == EINTR)
+				goto again;
+			error("%s: slurm_receive_msg[%pA]: %m",
+			      __func__, &conn->addr);
+		} else {
+			slurm_mutex_lock(&sls->msg_handler_lock);
+			_handle_msg(sls, msg);
+			slurm_mutex_unlock(&sls->msg_handler_lock);
+		}
+
+		/* the handler may keep the connection, see conn_fd */
+		if ((msg->conn_fd >= STDERR_FILENO) && (close(msg->conn_fd) < 0))
+			error("%s: close(%d): %m", __func__, msg->conn_fd);
+		slurm_free_msg(msg);
+		xfree(conn);
+	}
+
+	return NULL;
+}
+
+/* Stop the message workers, must be called after msg_thread exited */
+static void _msg_thr_destroy(struct step_launch_state *sls)
+{
+	int i;
+
+	if (!sls->msg_workers)
+		return;
+
+	slurm_mutex_lock(&sls->msg_lock);
+	sls->msg_shutdown = true;
+	slurm_cond_broadcast(&sls->msg_cond);
+	slurm_mutex_unlock(&sls->msg_lock);
+
+	for (i = 0; i < sls->msg_worker_cnt; i++)
+		pthread_join(sls->msg_workers[i], NULL);
+	xfree(sls->msg_workers);
+	sls->msg_worker_cnt = 0;
+	FREE_NULL_LIST(sls->msg_conns);
+}
+
 static inline int
 _estimate_nports(int nclients, int cli_per_port)
 {
@@ -1171,17 +1448,29 @@ static int _msg_thr_create(struct step_launch_state *sls, int num_nodes)
 			return SLURM_ERROR;
 		}
 		sls->resp_port[i] = port;
+		/* _msg_socket_accept() accepts until no connection is left */
+		fd_set_nonblocking(sock);
 		obj = eio_obj_create(sock, &message_socket_ops, (void *)sls);
 		eio_new_initial_obj(sls->msg_handle, obj);
 	}
 	/* finally, add the listening port that we told the slurmctld about
 	 * eariler in the step context creation phase */
 	if (sls->slurmctld_socket_fd > -1) {
+		fd_set_nonblocking(sls->slurmctld_socket_fd);
 		obj = eio_obj_create(sls->slurmctld_socket_fd,
 				     &message_socket_ops, (void *)sls);
 		eio_new_initial_obj(sls->msg_handle, obj);
 	}
 
+	/* one worker per response port, each port serves 48 nodes */
+	sls->msg_conns = list_create(_free_msg_conn);
+	sls->msg_shutdown = false;
+	sls->msg_worker_cnt = MIN(MAX_MSG_WORKERS, sls->num_resp_port);
+	sls->msg_worker_cnt = MAX(sls->msg_worker_cnt, 1);
+	sls->msg_workers = xcalloc(sls->msg_worker_cnt, sizeof(pthread_t));
+	for (i = 0; i < sls->msg_worker_cnt; i++)
+		slurm_thread_create(&sls->msg_workers[i], _msg_worker, sls);
+
 	slurm_thread_create(&sls->msg_thread, _msg_thr_internal, sls);
 	return rc;
 }
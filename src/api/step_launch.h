@@ -83,6 +83,14 @@ struct step_launch_state {
 	/* message thread variables */
 	eio_handle_t *msg_handle;
 	pthread_t msg_thread;
+	/* connections accepted by msg_thread and read by msg_workers */
+	pthread_mutex_t msg_lock;
+	pthread_cond_t msg_cond;
+	List msg_conns;
+	bool msg_shutdown;
+	int msg_worker_cnt;
+	pthread_t *msg_workers;
+	pthread_mutex_t msg_handler_lock; /* one message handled at a time */
 	/* set to -1 if step launch message handler should not attempt
 	   to handle */
 	int slurmctld_socket_fd;
@@ -153,3 +153,57 @@ extern int slurm_submit_batch_het_job(List job_req_list,
 
 	return SLURM_SUCCESS;
 }
+
+/*
+ * slurm_submit_batch_jobs - issue RPC to submit several independent batch
+ *			     jobs for later execution
+ * NOTE: free the response using slurm_free_submit_batch_jobs_response_msg
+ * IN job_req_list - List of batch job requests, type job_desc_msg_t
+ * OUT resp - per job IDs and error codes, in job_req_list order
+ * RET SLURM_SUCCESS on success, otherwise return SLURM_ERROR with errno set
+ */
+extern int slurm_submit_batch_jobs(List job_req_list,
+				   submit_batch_jobs_response_msg_t **resp)
+{
+	int rc;
+	job_desc_msg_t *req;
+	slurm_msg_t req_msg;
+	slurm_msg_t resp_msg;
+	ListIterator iter;
+
+	slurm_msg_t_init(&req_msg);
+	slurm_msg_t_init(&resp_msg);
+
+	/*
+	 * set session id for this request
+	 */
+	iter = list_iterator_create(job_req_list);
+	while ((req = (job_desc_msg_t *) list_next(iter))) {
+		if (req->alloc_sid == NO_VAL)
+			req->alloc_sid = getsid(0);
+	}
+	list_iterator_destroy(iter);
+
+	req_msg.msg_type = REQUEST_SUBMIT_BATCH_JOBS;
+	req_msg.data     = job_req_list;
+
+	rc = slurm_send_recv_controller_msg(&req_msg, &resp_msg,
+					    working_cluster_rec);
+	if (rc == SLURM_ERROR)
+		return SLURM_ERROR;
+	switch (resp_msg.msg_type) {
+	case RESPONSE_SLURM_RC:
+		rc = ((return_code_msg_t *) resp_msg.data)->return_code;
+		if (rc)
+			slurm_seterrno_ret(rc);
+		*resp = NULL;
+		break;
+	case RESPONSE_SUBMIT_BATCH_JOBS:
+		*resp = (submit_batch_jobs_response_msg_t *) resp_msg.data;
+		break;
+	default:
+		slurm_seterrno_ret(SLURM_UNEXPECTED_MSG_ERROR);
+	}
+
+	return SLURM_SUCCESS;
+}
@@ -77,6 +77,7 @@
 
 #define MAX_THREADS      8	/* These can be huge messages, so
 				 * only run MAX_THREADS at one time */
+#define MAX_INFLIGHT     4	/* Blocks being forwarded at one time */
 
 int block_len;				/* block size */
 int fd;					/* source file descriptor */
@@ -84,10 +85,26 @@ void *src;				/* source mmap'd address */
 struct stat f_stat;			/* source file stats */
 job_sbcast_cred_msg_t *sbcast_cred;	/* job alloc info and sbcast cred */
 
+/* pipelined transfer of the blocks between the first and the last one */
+static pthread_mutex_t inflight_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t inflight_cond = PTHREAD_COND_INITIALIZER;
+static int inflight_cnt = 0;
+static int inflight_rc = SLURM_SUCCESS;
+
+/* compression statistics, updated by the threads sending blocks */
+static uint64_t size_compressed = 0;
+static uint32_t time_compression = 0;
+
+typedef struct {
+	file_bcast_msg_t msg;
+	struct bcast_parameters *params;
+} bcast_block_t;
+
 static int   _bcast_file(struct bcast_parameters *params);
 static int   _file_bcast(struct bcast_parameters *params,
 			 file_bcast_msg_t *bcast_msg,
-			 job_sbcast_cred_msg_t *sbcast_cred);
+			 job_sbcast_cred_msg_t *sbcast_cred,
+			 bool *all_cached);
 static int   _file_state(struct bcast_parameters *params);
 static int   _get_job_info(struct bcast_parameters *params);
 
@@ -123,6 +140,7 @@ static int _file_state(struct bcast_parameters *params)
 		error("Can't mmap file `%s`, %m.", params->src_fname);
 		return SLURM_ERROR;
 	}
+	(void) madvise(src, f_stat.st_size, MADV_SEQUENTIAL);
 
 	return SLURM_SUCCESS;
 }
@@ -156,15 +174,20 @@ static int _get_job_info(struct bcast_parameters *params)
 	return rc;
 }
 
-/* Issue the RPC to transfer the file's data */
+/*
+ * Issue the RPC to transfer the file's data
+ * all_cached OUT - set if every node already had the file in its sbcast
+ *		    cache, may be NULL
+ */
 static int _file_bcast(struct bcast_parameters *params,
 		       file_bcast_msg_t *bcast_msg,
-		       job_sbcast_cred_msg_t *sbcast_cred)
+		       job_sbcast_cred_msg_t *sbcast_cred,
+		       bool *all_cached)
 {
 	List ret_list = NULL;
 	ListIterator itr;
 	ret_data_info_t *ret_data_info = NULL;
-	int rc = 0, msg_rc;
+	int rc = 0, msg_rc, cached_cnt = 0;
 	slurm_msg_t msg;
 
 	slurm_msg_t_init(&msg);
@@ -186,6 +209,10 @@ static int _file_bcast(struct bcast_parameters *params,
 					       ret_data_info->data);
 		if (msg_rc == SLURM_SUCCESS)
 			continue;
+		if (msg_rc == ESLURMD_BCAST_CACHED) {
+			cached_cnt++;
+			continue;
+		}
 
 		error("REQUEST_FILE_BCAST(%s): %s",
 		      ret_data_info->node_name,
@@ -193,168 +220,269 @@ static int _file_bcast(struct bcast_parameters *params,
 		rc = MAX(rc, msg_rc);
 	}
 	list_iterator_destroy(itr);
+	if (all_cached)
+		*all_cached = (cached_cnt == list_count(ret_list));
 	FREE_NULL_LIST(ret_list);
 
 	return rc;
 }
 
-/* load a buffer with data from the file to broadcast,
- * return number of bytes read, zero on end of file */
-static int _get_block_none(char **buffer, int *orig_len, bool *more)
-{
-	static int64_t remaining = -1;
-	static void *position;
-	int size;
-
-	if (remaining < 0) {
-		*buffer = xmalloc(block_len);
-		remaining = f_stat.st_size;
-		position = src;
-	}
-
-	size = MIN(block_len, remaining);
-	memcpy(*buffer, position, size);
-	remaining -= size;
-	position += size;
-
-	*orig_len = size;
-	*more = (remaining) ? true : false;
-	return size;
-}
-
-static int _get_block_zlib(struct bcast_parameters *params,
-			   char **buffer,
-			   int *orig_len,
-			   bool *more)
+/*
+ * Compress one block of the mmap'd source file with zlib into a newly
+ * allocated buffer, each block is compressed independently.
+ * RET size of the compressed data or -1 to send the block uncompressed
+ */
+static int _compress_block_zlib(void *in, int in_len, char **buffer)
 {
 #if HAVE_LIBZ
-	static z_stream strm;
-	int chunk = (256 * 1024);
-	int flush = Z_NO_FLUSH;
-
-	static int64_t remaining = -1;
-	static int max_out;
-	static void *position;
-	int chunk_remaining, out_remaining, chunk_bite, size = 0;
+	z_stream strm;
+	int max_out;
 
-	/* allocate deflate state, compress each block independently */
 	strm.zalloc = Z_NULL;
 	strm.zfree = Z_NULL;
 	strm.opaque = Z_NULL;
-	strm.avail_in = 0;
-	strm.next_in = Z_NULL;
 	if (deflateInit(&strm, Z_DEFAULT_COMPRESSION) != Z_OK) {
 		error("File compression configuration error,"
-		      "sending uncompressed file.");
-		params->compress = 0;
-		return _get_block_none(buffer, orig_len, more);
-	}
-
-	/* first pass through, initialize */
-	if (remaining < 0) {
-		remaining = f_stat.st_size;
-		max_out = deflateBound(&strm, block_len);
-		*buffer = xmalloc(max_out);
-		position = src;
+		      "sending uncompressed block.");
+		return -1;
 	}
 
-	chunk_remaining = MIN(block_len, remaining);
-	out_remaining = max_out;
+	max_out = deflateBound(&strm, in_len);
+	*buffer = xmalloc(max_out);
+	strm.next_in = in;
+	strm.avail_in = in_len;
 	strm.next_out = (void *) *buffer;
-	while (chunk_remaining) {
-		strm.next_in = position;
-		chunk_bite = MIN(chunk, chunk_remaining);
-		strm.avail_in = chunk_bite;
-		strm.avail_out = out_remaining;
-
-		if (chunk_remaining <= chunk)
-			flush = Z_FINISH;
+	strm.avail_out = max_out;
 
-		if (deflate(&strm, flush) == Z_STREAM_ERROR)
-			fatal("Error compressing file");
-
-		position += chunk_bite;
-		size += chunk_bite;
-		chunk_remaining -= chunk_bite;
-		out_remaining = strm.avail_out;
-	}
-	remaining -= size;
+	/* deflateBound() guarantees a single pass is enough */
+	if (deflate(&strm, Z_FINISH) != Z_STREAM_END)
+		fatal("Error compressing file");
 
 	(void) deflateEnd(&strm);
 
-	*orig_len = size;
-	*more = (remaining) ? true : false;
-	return (max_out - out_remaining);
+	return (max_out - strm.avail_out);
 #else
-	info("zlib compression not supported, sending uncompressed file.");
-	params->compress = 0;
-	return _get_block_none(buffer, orig_len, more);
+	return -1;
 #endif
 }
 
-static int _get_block_lz4(struct bcast_parameters *params,
-			  char **buffer,
-			  int32_t *orig_len,
-			  bool *more)
+/*
+ * Compress one block of the mmap'd source file with lz4 into a newly
+ * allocated buffer.
+ * RET size of the compressed data or -1 to send the block uncompressed
+ */
+static int _compress_block_lz4(void *in, int in_len, char **buffer)
 {
 #if HAVE_LZ4
-	int size_out;
-	static int64_t remaining = -1;
-	static void *position;
-	int size;
+	int max_out, size_out;
 
-	if (!f_stat.st_size) {
-		*more = false;
-		return 0;
-	}
-
-	if (remaining < 0) {
-		position = src;
-		remaining = f_stat.st_size;
-		*buffer = xmalloc(block_len);
-	}
-
-	/* intentionally limit decompressed size to 10x compressed
-	 * to avoid problems on receive size when decompressed */
-	size = MIN(block_len * 10, remaining);
-	if (!(size_out = LZ4_compress_destSize(position, *buffer,
-					       &size, block_len))) {
+	max_out = LZ4_compressBound(in_len);
+	*buffer = xmalloc(max_out);
+	if (!(size_out = LZ4_compress_default(in, *buffer, in_len, max_out))) {
 		/* compression failure */
 		fatal("LZ4 compression error");
 	}
-	position += size;
-	remaining -= size;
 
-	*orig_len = size;
-	*more = (remaining) ? true : false;
 	return size_out;
 #else
-	info("lz4 compression not supported, sending uncompressed file.");
-	params->compress = 0;
-	return _get_block_none(buffer, orig_len, more);
+	return -1;
 #endif
+}
+
+/*
+ * Fill in the message's data for one block of the source file.
+ * Compression happens here, in the thread sending the block, so blocks are
+ * compressed in parallel with each other and with the transfers.
+ * Uncompressed blocks are packed straight from the mmap'd file.
+ * RET pointer to free once the message is sent, may be NULL
+ */
+static char *_load_block(file_bcast_msg_t *bcast_msg)
+{
+	void *position = src + bcast_msg->block_offset;
+	char *buffer = NULL;
+	int size = -1;
+	DEF_TIMERS;
+
+	START_TIMER;
+	switch (bcast_msg->uncomp_len ? bcast_msg->compress : COMPRESS_OFF) {
+	case COMPRESS_ZLIB:
+		size = _compress_block_zlib(position, bcast_msg->uncomp_len,
+					    &buffer);
+		break;
+	case COMPRESS_LZ4:
+		size = _compress_block_lz4(position, bcast_msg->uncomp_len,
+					   &buffer);
+		break;
+	}
+	END_TIMER;
+
+	if (size < 0) {
+		xfree(buffer);
+		bcast_msg->compress = COMPRESS_OFF;
+		bcast_msg->block = position;
+		bcast_msg->block_len = bcast_msg->uncomp_len;
+	} else {
+		bcast_msg->block = buffer;
+		bcast_msg->block_len = size;
+	}
+
+	slurm_mutex_lock(&inflight_mutex);
+	size_compressed += bcast_msg->block_len;
+	time_compression += DELTA_TIMER;
+	slurm_mutex_unlock(&inflight_mutex);
+
+	debug("block %u, size %u", bcast_msg->block_no, bcast_msg->block_len);
+
+	return buffer;
+}
 
+/* Load and send one block, waiting for all nodes to receive it */
+static int _send_block(struct bcast_parameters *params,
+		       file_bcast_msg_t *bcast_msg, bool *all_cached)
+{
+	char *buffer = _load_block(bcast_msg);
+	int rc;
+
+	rc = _file_bcast(params, bcast_msg, sbcast_cred, all_cached);
+	xfree(buffer);
+
+	return rc;
 }
 
-static int _next_block(struct bcast_parameters *params,
-		       char **buffer,
-		       int32_t *orig_len,
-		       bool *more)
+static void *_file_bcast_thread(void *arg)
+{
+	bcast_block_t *block = arg;
+	int rc;
+
+	rc = _send_block(block->params, &block->msg, NULL);
+
+	slurm_mutex_lock(&inflight_mutex);
+	inflight_rc = MAX(inflight_rc, rc);
+	inflight_cnt--;
+	slurm_cond_broadcast(&inflight_cond);
+	slurm_mutex_unlock(&inflight_mutex);
+
+	xfree(block);
+	return NULL;
+}
+
+/*
+ * Wait until no more than max_cnt blocks are being forwarded
+ * RET the worst return code of the blocks completed so far
+ */
+static int _wait_inflight(int max_cnt)
+{
+	int rc;
+
+	slurm_mutex_lock(&inflight_mutex);
+	while (inflight_cnt > max_cnt)
+		slurm_cond_wait(&inflight_cond, &inflight_mutex);
+	rc = inflight_rc;
+	slurm_mutex_unlock(&inflight_mutex);
+
+	return rc;
+}
+
+/*
+ * Send a block without waiting for the previous ones to reach all nodes.
+ * Each slurmd writes the block at its offset, so blocks may complete in any
+ * order. The forwarding tree then carries up to MAX_INFLIGHT blocks at once
+ * instead of idling while each block travels to the leaves and back.
+ */
+static int _file_bcast_async(struct bcast_parameters *params,
+			     file_bcast_msg_t *bcast_msg)
+{
+	bcast_block_t *block;
+	int rc;
+
+	if ((rc = _wait_inflight(MAX_INFLIGHT - 1)))
+		return rc;
+
+	block = xmalloc(sizeof(*block));
+	block->params = params;
+	block->msg = *bcast_msg;
+
+	slurm_mutex_lock(&inflight_mutex);
+	inflight_cnt++;
+	slurm_mutex_unlock(&inflight_mutex);
+
+	slurm_thread_create_detached(NULL, _file_bcast_thread, block);
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Hash the contents of the source file, so slurmd can tell whether it
+ * already has the file in its sbcast cache. This is 64-bit FNV-1a applied
+ * to 8 byte words rather than single bytes.
+ */
+static uint64_t _file_hash(void)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL, word;
+	uint64_t offset;
+	const unsigned char *data = src;
+
+	for (offset = 0; (offset + sizeof(word)) <= f_stat.st_size;
+	     offset += sizeof(word)) {
+		memcpy(&word, data + offset, sizeof(word));
+		hash ^= word;
+		hash *= 0x100000001b3ULL;
+	}
+	for ( ; offset < f_stat.st_size; offset++) {
+		hash ^= data[offset];
+		hash *= 0x100000001b3ULL;
+	}
+	hash ^= f_stat.st_size;
+	hash *= 0x100000001b3ULL;
+
+	/* zero means no hash */
+	return hash ? hash : 1;
+}
+
+/* Ask the kernel to start reading a block of the source file */
+static void _readahead_block(uint64_t offset)
+{
+	static long page_size = 0;
+	uint64_t start;
+
+	if (offset >= f_stat.st_size)
+		return;
+	if (!page_size)
+		page_size = sysconf(_SC_PAGESIZE);
+
+	start = offset - (offset % page_size);
+	(void) madvise(src + start,
+		       MIN(block_len + (offset - start),
+			   f_stat.st_size - start), MADV_WILLNEED);
+}
+
+/* Fall back to no compression if the requested type is not available */
+static void _validate_compress(struct bcast_parameters *params)
 {
 	switch (params->compress) {
 	case COMPRESS_OFF:
-		return _get_block_none(buffer, orig_len, more);
+		return;
 	case COMPRESS_ZLIB:
-		return _get_block_zlib(params, buffer, orig_len, more);
+#if HAVE_LIBZ
+		return;
+#else
+		info("zlib compression not supported, sending uncompressed file.");
+		break;
+#endif
 	case COMPRESS_LZ4:
-		return _get_block_lz4(params, buffer, orig_len, more);
+#if HAVE_LZ4
+		return;
+#else
+		info("lz4 compression not supported, sending uncompressed file.");
+		break;
+#endif
+	default:
+		/* compression type not recognized */
+		error("File compression type %u not supported,"
+		      " sending uncompressed file.", params->compress);
+		break;
 	}
-
-	/* compression type not recognized */
-	error("File compression type %u not supported,"
-	      " sending uncompressed file.", params->compress);
-	params->compress = 0;
-	return _get_block_none(buffer, orig_len, more);
+	params->compress = COMPRESS_OFF;
 }
 
 /* read and broadcast the file */
@@ -362,18 +490,18 @@ static int _bcast_file(struct bcast_parameters *params)
 {
 	int rc = SLURM_SUCCESS;
 	file_bcast_msg_t bcast_msg;
-	char *buffer = NULL;
-	int32_t orig_len = 0;
-	uint64_t size_uncompressed = 0, size_compressed = 0;
-	uint32_t time_compression = 0;
-	bool more = true;
-	DEF_TIMERS;
+	uint64_t size_uncompressed = 0;
+	int64_t remaining = f_stat.st_size;
+	bool all_cached = false;
+	int i;
 
 	if (params->block_size)
 		block_len = MIN(params->block_size, f_stat.st_size);
 	else
 		block_len = MIN((512 * 1024), f_stat.st_size);
 
+	_validate_compress(params);
+
 	memset(&bcast_msg, 0, sizeof(file_bcast_msg_t));
 	bcast_msg.fname		= params->dst_fname;
 	bcast_msg.block_no	= 1;
@@ -384,6 +512,8 @@ static int _bcast_file(struct bcast_parameters *params)
 	bcast_msg.gid		= f_stat.st_gid;
 	bcast_msg.file_size	= f_stat.st_size;
 	bcast_msg.cred          = sbcast_cred->sbcast_cred;
+	if (f_stat.st_size)
+		bcast_msg.file_hash = _file_hash();
 
 	if (params->preserve) {
 		bcast_msg.atime     = f_stat.st_atime;
@@ -395,32 +525,45 @@ static int _bcast_file(struct bcast_parameters *params)
 	else
 		params->fanout = MIN(MAX_THREADS, params->fanout);
 
-	while (more) {
-		START_TIMER;
-		bcast_msg.block_len = _next_block(params, &buffer, &orig_len,
-						  &more);
-		END_TIMER;
-		time_compression += DELTA_TIMER;
-		size_uncompressed += orig_len;
-		size_compressed += bcast_msg.block_len;
-		debug("block %u, size %u", bcast_msg.block_no,
-		      bcast_msg.block_len);
+	/* prime the page cache for the first window of blocks */
+	for (i = 0; i <= MAX_INFLIGHT; i++)
+		_readahead_block((uint64_t) block_len * i);
+
+	/* an empty file still gets one (empty) block to create it */
+	do {
 		bcast_msg.compress = params->compress;
-		bcast_msg.uncomp_len = orig_len;
-		bcast_msg.block = buffer;
-		if (!more)
+		bcast_msg.uncomp_len = MIN(block_len, remaining);
+		remaining -= bcast_msg.uncomp_len;
+		size_uncompressed += bcast_msg.uncomp_len;
+		if (!remaining)
 			bcast_msg.last_block = 1;
 
-		rc = _file_bcast(params, &bcast_msg, sbcast_cred);
+		/* keep reading MAX_INFLIGHT blocks ahead of the senders */
+		_readahead_block(bcast_msg.block_offset +
+				 ((uint64_t) block_len * (MAX_INFLIGHT + 1)));
+
+		if ((bcast_msg.block_no == 1) || bcast_msg.last_block) {
+			/*
+			 * The first block creates the file and the last one
+			 * closes it, so these can not overlap with others.
+			 */
+			if ((rc = _wait_inflight(0)) == SLURM_SUCCESS)
+				rc = _send_block(params, &bcast_msg,
+						 &all_cached);
+		} else
+			rc = _file_bcast_async(params, &bcast_msg);
 		if (rc != SLURM_SUCCESS)
 			break;
-		if (bcast_msg.last_block)
-			break;	/* end of file */
+		if (all_cached && remaining) {
+			/* only the closing (empty) block is still needed */
+			verbose("File found in the sbcast cache of all nodes");
+			remaining = 0;
+		}
 		bcast_msg.block_no++;
-		bcast_msg.block_offset += orig_len;
-	}
+		bcast_msg.block_offset += bcast_msg.uncomp_len;
+	} while (!bcast_msg.last_block);
+	rc = MAX(rc, _wait_inflight(0));
 	xfree(bcast_msg.user_name);
-	xfree(buffer);
 
 	if (size_uncompressed && (params->compress != 0)) {
 		int64_t pct = (int64_t) size_uncompressed - size_compressed;
@@ -55,8 +55,13 @@ struct bcast_parameters {
 };
 
 typedef struct file_bcast_info {
+	bool cache_error;	/* write to sbcast cache entry failed */
+	int cache_fd;		/* sbcast cache entry being written */
+	char *cache_tmp;	/* temporary name of the sbcast cache entry */
+	bool cached;		/* file was copied from the sbcast cache */
 	void *data;		/* mmap of file data */
 	int fd;			/* file descriptor */
+	uint64_t file_hash;	/* content hash of the file */
 	uint64_t file_size;	/* file size */
 	char *fname;		/* filename */
 	gid_t gid;		/* gid of owner */
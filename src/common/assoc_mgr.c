@@ -45,6 +45,7 @@
 #include <ctype.h>
 
 #include "src/common/uid.h"
+#include "src/common/xhash.h"
 #include "src/common/xstring.h"
 #include "src/common/slurm_priority.h"
 #include "src/common/slurmdbd_pack.h"
@@ -76,6 +77,7 @@ static pthread_mutex_t assoc_lock_init = PTHREAD_MUTEX_INITIALIZER;
 static assoc_init_args_t init_setup;
 static slurmdb_assoc_rec_t **assoc_hash_id = NULL;
 static slurmdb_assoc_rec_t **assoc_hash = NULL;
+static xhash_t *user_uid_hash = NULL; /* assoc_mgr_user_list by uid */
 static int *assoc_mgr_tres_old_pos = NULL;
 
 static bool _running_cache(void)
@@ -520,6 +522,45 @@ static int _clear_used_qos_info(slurmdb_qos_rec_t *qos)
 }
 
 /* Locks should be in place before calling this. */
+static void _user_uid_hash_id(void *item, const char **key, uint32_t *key_len)
+{
+	slurmdb_user_rec_t *user = (slurmdb_user_rec_t *) item;
+
+	*key = (char *) &user->uid;
+	*key_len = sizeof(user->uid);
+}
+
+/* Index a user by uid, the first user in the list with a given uid wins. */
+static void _add_user_uid_hash(slurmdb_user_rec_t *user)
+{
+	if (user->uid == NO_VAL)
+		return;
+
+	if (!user_uid_hash)
+		user_uid_hash = xhash_init(_user_uid_hash_id, NULL);
+	if (!xhash_get(user_uid_hash, (char *) &user->uid, sizeof(user->uid)))
+		xhash_add(user_uid_hash, user);
+}
+
+static int _add_user_uid_hash_foreach(void *x, void *arg)
+{
+	_add_user_uid_hash(x);
+	return 0;
+}
+
+/*
+ * Rebuild user_uid_hash from assoc_mgr_user_list, call whenever the list is
+ * replaced or a user is removed or has its uid changed.
+ * locks should be put in place before calling this function USER_WRITE
+ */
+static void _rebuild_user_uid_hash(void)
+{
+	xhash_free(user_uid_hash);
+	if (assoc_mgr_user_list)
+		(void) list_for_each(assoc_mgr_user_list,
+				     _add_user_uid_hash_foreach, NULL);
+}
+
 static int _change_user_name(slurmdb_user_rec_t *user)
 {
 	int rc = SLURM_SUCCESS;
@@ -537,6 +578,7 @@ static int _change_user_name(slurmdb_user_rec_t *user)
 		user->uid = NO_VAL;
 	} else
 		user->uid = pw_uid;
+	_rebuild_user_uid_hash();
 
 	if (assoc_mgr_assoc_list) {
 		itr = list_iterator_create(assoc_mgr_assoc_list);
@@ -667,14 +709,13 @@ static int _local_update_assoc_qos_list(slurmdb_assoc_rec_t *assoc,
 	return SLURM_SUCCESS;
 }
 
-static int _list_find_uid(void *x, void *key)
+/* locks should be put in place before calling this function USER_READ */
+static slurmdb_user_rec_t *_find_user_uid(uint32_t uid)
 {
-	slurmdb_user_rec_t *user = (slurmdb_user_rec_t *) x;
-	uint32_t uid = *(uint32_t *) key;
+	if (!user_uid_hash)
+		return NULL;
 
-	if (user->uid == uid)
-		return 1;
-	return 0;
+	return xhash_get(user_uid_hash, (char *) &uid, sizeof(uid));
 }
 
 /* locks should be put in place before calling this function USER_WRITE */
@@ -686,8 +727,7 @@ static void _set_user_default_acct(slurmdb_assoc_rec_t *assoc)
 
 	/* set up the default if this is it */
 	if ((assoc->is_def == 1) && (assoc->uid != NO_VAL)) {
-		slurmdb_user_rec_t *user = list_find_first(
-			assoc_mgr_user_list, _list_find_uid, &assoc->uid);
+		slurmdb_user_rec_t *user = _find_user_uid(assoc->uid);
 
 		if (!user)
 			return;
@@ -713,8 +753,7 @@ static void _set_user_default_wckey(slurmdb_wckey_rec_t *wckey)
 
 	/* set up the default if this is it */
 	if ((wckey->is_def == 1) && (wckey->uid != NO_VAL)) {
-		slurmdb_user_rec_t *user = list_find_first(
-			assoc_mgr_user_list, _list_find_uid, &wckey->uid);
+		slurmdb_user_rec_t *user = _find_user_uid(wckey->uid);
 
 		if (!user)
 			return;
@@ -1660,6 +1699,7 @@ static int _get_assoc_mgr_user_list(void *db_conn, int enforce)
 
 	assoc_mgr_lock(&locks);
 	FREE_NULL_LIST(assoc_mgr_user_list);
+	xhash_free(user_uid_hash);
 	assoc_mgr_user_list = acct_storage_g_get_users(db_conn, uid, &user_q);
 
 	if (!assoc_mgr_user_list) {
@@ -1673,6 +1713,7 @@ static int _get_assoc_mgr_user_list(void *db_conn, int enforce)
 	}
 
 	_post_user_list(assoc_mgr_user_list);
+	_rebuild_user_uid_hash();
 
 	assoc_mgr_unlock(&locks);
 	return SLURM_SUCCESS;
@@ -1929,6 +1970,7 @@ static int _refresh_assoc_mgr_user_list(void *db_conn, int enforce)
 	FREE_NULL_LIST(assoc_mgr_user_list);
 
 	assoc_mgr_user_list = current_users;
+	_rebuild_user_uid_hash();
 
 	assoc_mgr_unlock(&locks);
 
@@ -2073,6 +2115,7 @@ extern int assoc_mgr_fini(bool save_state)
 	FREE_NULL_LIST(assoc_mgr_res_list);
 	FREE_NULL_LIST(assoc_mgr_qos_list);
 	FREE_NULL_LIST(assoc_mgr_user_list);
+	xhash_free(user_uid_hash);
 	FREE_NULL_LIST(assoc_mgr_wckey_list);
 	if (assoc_mgr_tres_name_array) {
 		int i;
@@ -2594,6 +2637,13 @@ extern int assoc_mgr_fill_in_assoc(void *db_conn,
 	return SLURM_SUCCESS;
 }
 
+extern slurmdb_assoc_rec_t *assoc_mgr_find_assoc_rec_id(uint32_t assoc_id)
+{
+	xassert(verify_assoc_lock(ASSOC_LOCK, READ_LOCK));
+
+	return _find_assoc_rec_id(assoc_id);
+}
+
 extern int assoc_mgr_fill_in_user(void *db_conn, slurmdb_user_rec_t *user,
 				  int enforce,
 				  slurmdb_user_rec_t **user_pptr,
@@ -2621,16 +2671,16 @@ extern int assoc_mgr_fill_in_user(void *db_conn, slurmdb_user_rec_t *user,
 		return SLURM_SUCCESS;
 	}
 
-	itr = list_iterator_create(assoc_mgr_user_list);
-	while ((found_user = list_next(itr))) {
-		if (user->uid != NO_VAL) {
-			if (user->uid == found_user->uid)
+	if (user->uid != NO_VAL) {
+		found_user = _find_user_uid(user->uid);
+	} else if (user->name) {
+		itr = list_iterator_create(assoc_mgr_user_list);
+		while ((found_user = list_next(itr))) {
+			if (!xstrcasecmp(user->name, found_user->name))
 				break;
-		} else if (user->name
-			   && !xstrcasecmp(user->name, found_user->name))
-			break;
+		}
+		list_iterator_destroy(itr);
 	}
-	list_iterator_destroy(itr);
 
 	if (!found_user) {
 		if (!locked)
@@ -3007,7 +3057,7 @@ extern slurmdb_admin_level_t assoc_mgr_get_admin_level(void *db_conn,
 		return SLURMDB_ADMIN_NOTSET;
 	}
 
-	found_user = list_find_first(assoc_mgr_user_list, _list_find_uid, &uid);
+	found_user = _find_user_uid(uid);
 
 	if (found_user)
 		level = found_user->admin_level;
@@ -3039,8 +3089,7 @@ extern bool assoc_mgr_is_user_acct_coord(void *db_conn,
 		return false;
 	}
 
-	found_user = list_find_first(assoc_mgr_user_list, _list_find_uid,
-				     &uid);
+	found_user = _find_user_uid(uid);
 
 	if (!found_user || !found_user->coord_accts) {
 		assoc_mgr_unlock(&locks);
@@ -4330,6 +4379,7 @@ extern int assoc_mgr_update_users(slurmdb_update_object_t *update, bool locked)
 			} else
 				object->uid = pw_uid;
 			list_append(assoc_mgr_user_list, object);
+			_add_user_uid_hash(object);
 			object = NULL;
 			break;
 		case SLURMDB_REMOVE_USER:
@@ -4338,6 +4388,7 @@ extern int assoc_mgr_update_users(slurmdb_update_object_t *update, bool locked)
 				break;
 			}
 			list_delete_item(itr);
+			_rebuild_user_uid_hash();
 			break;
 		case SLURMDB_ADD_COORD:
 			/* same as SLURMDB_REMOVE_COORD */
@@ -5947,6 +5998,7 @@ extern int load_assoc_mgr_state(bool only_tres)
 			FREE_NULL_LIST(assoc_mgr_user_list);
 			assoc_mgr_user_list = msg->my_list;
 			_post_user_list(assoc_mgr_user_list);
+			_rebuild_user_uid_hash();
 			debug("Recovered %u users",
 			      list_count(assoc_mgr_user_list));
 			msg->my_list = NULL;
@@ -6151,6 +6203,7 @@ extern int assoc_mgr_set_missing_uids()
 			}
 		}
 		list_iterator_destroy(itr);
+		_rebuild_user_uid_hash();
 	}
 	assoc_mgr_unlock(&locks);
 
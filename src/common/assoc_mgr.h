@@ -205,6 +205,15 @@ extern int assoc_mgr_fill_in_assoc(void *db_conn,
 				   slurmdb_assoc_rec_t **assoc_pptr,
 				   bool locked);
 
+/*
+ * find an association in the cache by its id
+ * IN: assoc_id - id of the association
+ * NOTE: READ lock on associations must be held while using the return
+ * RET: pointer to the slurmdb_assoc record in cache, NULL if not found
+ *      DO NOT FREE.
+ */
+extern slurmdb_assoc_rec_t *assoc_mgr_find_assoc_rec_id(uint32_t assoc_id);
+
 /*
  * get info from the storage
  * IN/OUT:  user - slurmdb_user_rec_t with the name set of the user.
@@ -70,6 +70,31 @@
 /* number of bits actually allocated to a bitstr */
 #define _bitstr_bits(name) 	((name)[1])
 
+/* number of whole words in a bitstr and number of bits in its partial word */
+#define _bitstr_full_words(name) (_bitstr_bits(name) >> BITSTR_SHIFT)
+#define _bitstr_tail_bits(name)	 (_bitstr_bits(name) & BITSTR_MAXPOS)
+
+/* mask for the first nbits bits of a word, 0 < nbits < word size */
+#ifdef SLURM_BIGENDIAN
+#define _bit_tail_mask(nbits) \
+	((bitstr_t)(~(uint64_t)0 << (BITSTR_MAXPOS + 1 - (nbits))))
+#else
+#define _bit_tail_mask(nbits) \
+	((bitstr_t)(((uint64_t)1 << (nbits)) - 1))
+#endif
+
+/*
+ * Without -mpopcnt, __builtin_popcountll() is a libgcc call per word. Build
+ * the word counting loops a second time for POPCNT capable CPUs and let the
+ * dynamic loader pick the version to use.
+ */
+#if defined(__x86_64__) && defined(__GLIBC__) && defined(__GNUC__) && \
+    !defined(__clang__) && (__GNUC__ >= 6) && !defined(__POPCNT__)
+#define BIT_POPCNT_CLONES __attribute__((target_clones("popcnt", "default")))
+#else
+#define BIT_POPCNT_CLONES
+#endif
+
 /* magic cookie stored here */
 #define _bitstr_magic(name) 	((name)[0])
 
@@ -147,6 +172,8 @@ strong_alias(bit_nffs,		slurm_bit_nffs);
 strong_alias(bit_copybits,	slurm_bit_copybits);
 strong_alias(bit_get_bit_num,	slurm_bit_get_bit_num);
 strong_alias(bit_get_pos_num,	slurm_bit_get_pos_num);
+strong_alias(bit_get_word64,	slurm_bit_get_word64);
+strong_alias(bit_set_word64,	slurm_bit_set_word64);
 
 /*
  * Allocate a bitstring.
@@ -618,14 +645,15 @@ bit_equal(bitstr_t *b1, bitstr_t *b2)
 void
 bit_and(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
+	bitoff_t word, end;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] &= b2[_bit_word(bit)];
+	end = _bitstr_words(_bitstr_bits(b1));
+	for (word = BITSTR_OVERHEAD; word < end; word++)
+		b1[word] &= b2[word];
 }
 
 /*
@@ -635,14 +663,15 @@ bit_and(bitstr_t *b1, bitstr_t *b2)
  */
 void bit_and_not(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
+	bitoff_t word, end;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] &= ~b2[_bit_word(bit)];
+	end = _bitstr_words(_bitstr_bits(b1));
+	for (word = BITSTR_OVERHEAD; word < end; word++)
+		b1[word] &= ~b2[word];
 }
 
 /*
@@ -652,12 +681,13 @@ void bit_and_not(bitstr_t *b1, bitstr_t *b2)
 void
 bit_not(bitstr_t *b)
 {
-	bitoff_t bit;
+	bitoff_t word, end;
 
 	_assert_bitstr_valid(b);
 
-	for (bit = 0; bit < _bitstr_bits(b); bit += sizeof(bitstr_t)*8)
-		b[_bit_word(bit)] = ~b[_bit_word(bit)];
+	end = _bitstr_words(_bitstr_bits(b));
+	for (word = BITSTR_OVERHEAD; word < end; word++)
+		b[word] = ~b[word];
 }
 
 /*
@@ -668,14 +698,15 @@ bit_not(bitstr_t *b)
 void
 bit_or(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
+	bitoff_t word, end;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] |= b2[_bit_word(bit)];
+	end = _bitstr_words(_bitstr_bits(b1));
+	for (word = BITSTR_OVERHEAD; word < end; word++)
+		b1[word] |= b2[word];
 }
 
 /*
@@ -685,14 +716,15 @@ bit_or(bitstr_t *b1, bitstr_t *b2)
  */
 void bit_or_not(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
+	bitoff_t word, end;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] |= ~b2[_bit_word(bit)];
+	end = _bitstr_words(_bitstr_bits(b1));
+	for (word = BITSTR_OVERHEAD; word < end; word++)
+		b1[word] |= ~b2[word];
 }
 
 /*
@@ -746,6 +778,44 @@ hweight(uint64_t w)
 }
 #endif
 
+/* Count the bits set in words[0 .. word_cnt-1] */
+BIT_POPCNT_CLONES
+static int32_t _bit_count_words(const bitstr_t *words, bitoff_t word_cnt)
+{
+	int32_t count = 0;
+	bitoff_t word;
+
+	for (word = 0; word < word_cnt; word++)
+		count += hweight(words[word]);
+
+	return count;
+}
+
+/*
+ * Count the bits set in both w1[0 .. word_cnt-1] and w2[0 .. word_cnt-1].
+ * If count_it is false, return 1 as soon as any common bit is found.
+ */
+BIT_POPCNT_CLONES
+static int32_t _bit_overlap_words(const bitstr_t *w1, const bitstr_t *w2,
+				  bitoff_t word_cnt, bool count_it)
+{
+	int32_t count = 0;
+	bitoff_t word;
+
+	if (!count_it) {
+		for (word = 0; word < word_cnt; word++) {
+			if (w1[word] & w2[word])
+				return 1;
+		}
+		return 0;
+	}
+
+	for (word = 0; word < word_cnt; word++)
+		count += hweight(w1[word] & w2[word]);
+
+	return count;
+}
+
 /*
  * Count the number of bits set in bitstring.
  *   b (IN)		bitstring to check
@@ -754,19 +824,17 @@ hweight(uint64_t w)
 int32_t
 bit_set_count(bitstr_t *b)
 {
-	int32_t count = 0;
-	bitoff_t bit, bit_cnt;
-	int32_t word_size = sizeof(bitstr_t) * 8;
+	int32_t count;
+	bitoff_t full_words, tail_bits;
 
 	_assert_bitstr_valid(b);
 
-	bit_cnt = _bitstr_bits(b);
-	for (bit = 0; (bit + word_size) <= bit_cnt; bit += word_size) {
-		count += hweight(b[_bit_word(bit)]);
-	}
-	for ( ; bit < bit_cnt; bit++) {
-		if (bit_test(b, bit))
-			count++;
+	full_words = _bitstr_full_words(b);
+	tail_bits = _bitstr_tail_bits(b);
+	count = _bit_count_words(&b[BITSTR_OVERHEAD], full_words);
+	if (tail_bits) {
+		count += hweight(b[BITSTR_OVERHEAD + full_words] &
+				 _bit_tail_mask(tail_bits));
 	}
 	return count;
 }
@@ -807,33 +875,29 @@ bit_set_count_range(bitstr_t *b, int32_t start, int32_t end)
 
 static int32_t _bit_overlap_internal(bitstr_t *b1, bitstr_t *b2, bool count_it)
 {
-	int32_t count = 0;
-	int64_t anded;
-	bitoff_t bit, bit_cnt;
-	int32_t word_size = sizeof(bitstr_t) * 8;
+	int32_t count;
+	bitstr_t anded;
+	bitoff_t full_words, tail_bits;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	bit_cnt = _bitstr_bits(b1);
-	for (bit = 0; bit < bit_cnt; bit += word_size) {
-		if ((bit + word_size - 1) >= bit_cnt)
-			break;
-		anded = b1[_bit_word(bit)] & b2[_bit_word(bit)];
+	full_words = _bitstr_full_words(b1);
+	tail_bits = _bitstr_tail_bits(b1);
+	count = _bit_overlap_words(&b1[BITSTR_OVERHEAD], &b2[BITSTR_OVERHEAD],
+				   full_words, count_it);
+	if (count && !count_it)
+		return 1;
+	if (tail_bits) {
+		anded = b1[BITSTR_OVERHEAD + full_words] &
+			b2[BITSTR_OVERHEAD + full_words] &
+			_bit_tail_mask(tail_bits);
 		if (count_it)
 			count += hweight(anded);
 		else if (anded)
 			return 1;
 	}
-	for ( ; bit < bit_cnt; bit++) {
-		if (bit_test(b1, bit) && bit_test(b2, bit)) {
-			if (count_it)
-				count++;
-			else
-				return 1;
-		}
-	}
 
 	return count;
 }
@@ -1315,6 +1379,36 @@ int inx2bitstr(bitstr_t *b, int32_t *inx)
  * convert a bitstring to inx format
  * returns an xmalloc()'d array of int32_t that must be xfree()'d
  */
+/* Return the number of ranges of consecutive set bits in b */
+static int32_t _bit_range_count(bitstr_t *b)
+{
+	bitoff_t word, end, full_words, tail_bits;
+	bitstr_t cur, prev_high = 0;
+	int32_t cnt = 0;
+
+	full_words = _bitstr_full_words(b);
+	tail_bits = _bitstr_tail_bits(b);
+	end = BITSTR_OVERHEAD + full_words + (tail_bits ? 1 : 0);
+	for (word = BITSTR_OVERHEAD; word < end; word++) {
+		uint64_t w = b[word], starts;
+
+		if ((word == (end - 1)) && tail_bits)
+			w &= _bit_tail_mask(tail_bits);
+#ifdef SLURM_BIGENDIAN
+		/* a range starts at each set bit whose predecessor is clear */
+		starts = w & ~((w >> 1) | ((uint64_t) prev_high << 63));
+		cur = w & 1;
+#else
+		starts = w & ~((w << 1) | (uint64_t) prev_high);
+		cur = w >> 63;
+#endif
+		cnt += hweight(starts);
+		prev_high = cur;
+	}
+
+	return cnt;
+}
+
 int32_t *bitstr2inx(bitstr_t *b)
 {
 	bitoff_t start, bit, pos = 0;
@@ -1326,10 +1420,12 @@ int32_t *bitstr2inx(bitstr_t *b)
 		return bit_inx;
 	}
 
-	/* worst case: every other bit set, resulting in an array of length
-	 * bitstr_bits(b) + 1 (if an odd number of elements)
-	 * + 1 (for trailing -1) */
-	bit_inx = xmalloc_nz(sizeof(int32_t) * (_bitstr_bits(b) + 2));
+	/*
+	 * Size the array for the actual number of ranges rather than the
+	 * worst case of every other bit set, which would allocate one entry
+	 * per bit for every bitmap converted.
+	 */
+	bit_inx = xmalloc_nz(sizeof(int32_t) * (_bit_range_count(b) * 2 + 1));
 
 	for (bit = 0; bit < _bitstr_bits(b); ) {
 		/* skip past empty words */
@@ -1627,3 +1723,60 @@ bit_get_pos_num(bitstr_t *b, bitoff_t pos)
 
 	return cnt;
 }
+
+#ifdef SLURM_BIGENDIAN
+static uint64_t _reverse_word(uint64_t w)
+{
+	uint64_t r = 0;
+	int i;
+
+	for (i = 0; i <= BITSTR_MAXPOS; i++, w >>= 1)
+		r = (r << 1) | (w & 1);
+
+	return r;
+}
+#endif
+
+/*
+ * Get the 64 bits starting at bit word * 64, with bit n of the value being
+ * bit word * 64 + n whatever the host bit order, for packing.
+ *   b (IN)		bitstring
+ *   word (IN)		word index, 0 to (bit_size(b) - 1) / 64
+ *   RETURN		bits, those past the end of b are zero
+ */
+uint64_t
+bit_get_word64(bitstr_t *b, int32_t word)
+{
+	uint64_t w;
+
+	_assert_bitstr_valid(b);
+	xassert((word >= 0) &&
+		(word < (_bitstr_words(_bitstr_bits(b)) - BITSTR_OVERHEAD)));
+
+	w = b[word + BITSTR_OVERHEAD];
+	if ((word == _bitstr_full_words(b)) && _bitstr_tail_bits(b))
+		w &= _bit_tail_mask(_bitstr_tail_bits(b));
+#ifdef SLURM_BIGENDIAN
+	w = _reverse_word(w);
+#endif
+	return w;
+}
+
+/*
+ * Set the 64 bits starting at bit word * 64, the reverse of bit_get_word64().
+ *   b (IN/OUT)		bitstring
+ *   word (IN)		word index, 0 to (bit_size(b) - 1) / 64
+ *   val (IN)		bits, those past the end of b must be zero
+ */
+void
+bit_set_word64(bitstr_t *b, int32_t word, uint64_t val)
+{
+	_assert_bitstr_valid(b);
+	xassert((word >= 0) &&
+		(word < (_bitstr_words(_bitstr_bits(b)) - BITSTR_OVERHEAD)));
+
+#ifdef SLURM_BIGENDIAN
+	val = _reverse_word(val);
+#endif
+	b[word + BITSTR_OVERHEAD] = val;
+}
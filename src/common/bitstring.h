@@ -148,6 +148,8 @@ bitstr_t *bit_copy(bitstr_t *b);
 bitstr_t *bit_pick_cnt(bitstr_t *b, bitoff_t nbits);
 bitoff_t bit_get_bit_num(bitstr_t *b, int32_t pos);
 int32_t	bit_get_pos_num(bitstr_t *b, bitoff_t pos);
+uint64_t bit_get_word64(bitstr_t *b, int32_t word);
+void	bit_set_word64(bitstr_t *b, int32_t word, uint64_t val);
 
 #define FREE_NULL_BITMAP(_X)		\
 	do {				\
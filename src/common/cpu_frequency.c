@@ -125,16 +125,22 @@ static int _fd_lock_retry(int fd)
  * can be timing issues.
  * _set_cpu_owner_lock  - set specified job to own the CPU, file locked at exit
  * _test_cpu_owner_lock - test if the specified job owns the CPU
+ * The owner lock is held across every write made to one CPU for a step, so
+ * each CPU costs one lock file open rather than one per sysfs file written.
  */
 static int _set_cpu_owner_lock(int cpu_id, uint32_t job_id)
 {
+	static bool cpu_dir_made = false;
 	char tmp[PATH_MAX];
 	int fd;
 
-	snprintf(tmp, sizeof(tmp), "%s/cpu", slurmd_spooldir);
-	if ((mkdir(tmp, 0700) != 0) && (errno != EEXIST)) {
-		error("mkdir failed: %m %s",tmp);
-		return -1;
+	if (!cpu_dir_made) {
+		snprintf(tmp, sizeof(tmp), "%s/cpu", slurmd_spooldir);
+		if ((mkdir(tmp, 0700) != 0) && (errno != EEXIST)) {
+			error("mkdir failed: %m %s",tmp);
+			return -1;
+		}
+		cpu_dir_made = true;
 	}
 	snprintf(tmp, sizeof(tmp), "%s/cpu/%d", slurmd_spooldir, cpu_id);
 	fd = open(tmp, O_CREAT | O_RDWR, 0600);
@@ -153,6 +159,14 @@ rwfail:
 	return fd;
 }
 
+static void _release_cpu_owner_lock(int fd)
+{
+	if (fd >= 0) {
+		(void) fd_release_lock(fd);
+		(void) close(fd);
+	}
+}
+
 /* Test if specified job ID owns this CPU for frequency/governor control
  * RET 0 if owner, -1 otherwise */
 static int _test_cpu_owner_lock(int cpu_id, uint32_t job_id)
@@ -701,16 +715,15 @@ _cpu_freq_get_cur_gov(int cpuidx)
  * set cpu governor
  */
 static int
-_cpu_freq_set_gov(stepd_step_rec_t *job, int cpuidx, char* gov )
+_cpu_freq_set_gov(int cpuidx, char* gov )
 {
 	char path[PATH_MAX];
 	FILE *fp;
-	int fd, rc;
+	int rc;
 
 	rc = SLURM_SUCCESS;
 	snprintf(path, sizeof(path), PATH_TO_CPU
 		 "cpu%u/cpufreq/scaling_governor", cpuidx);
-	fd = _set_cpu_owner_lock(cpuidx, job->step_id.job_id);
 	if ((fp = fopen(path, "w"))) {
 		fputs(gov, fp);
 		fputc('\n', fp);
@@ -719,10 +732,6 @@ _cpu_freq_set_gov(stepd_step_rec_t *job, int cpuidx, char* gov )
 		error("%s: Can not set CPU governor: %m", __func__);
 		rc = SLURM_ERROR;
 	}
-	if (fd >= 0) {
-		(void) fd_release_lock(fd);
-		(void) close(fd);
-	}
 	return rc;
 }
 
@@ -778,18 +787,16 @@ _cpu_freq_test_scaling_freq(int cpuidx, char *option)
  *
  */
 static int
-_cpu_freq_set_scaling_freq(stepd_step_rec_t *job, int cpx, uint32_t freq,
-		char* option)
+_cpu_freq_set_scaling_freq(int cpx, uint32_t freq, char* option)
 {
 	char path[PATH_MAX];
 	FILE *fp;
-	int fd, rc;
+	int rc;
 	uint32_t newfreq;
 
 	rc = SLURM_SUCCESS;
 	snprintf(path, sizeof(path), PATH_TO_CPU
 		 "cpu%u/cpufreq/%s", cpx, option);
-	fd = _set_cpu_owner_lock(cpx, job->step_id.job_id);
 	if ((fp = fopen(path, "w"))) {
 		fprintf(fp, "%u\n", freq);
 		fclose(fp);
@@ -797,10 +804,6 @@ _cpu_freq_set_scaling_freq(stepd_step_rec_t *job, int cpx, uint32_t freq,
 		error("%s: Can not set %s: %m", __func__, option);
 		rc = SLURM_ERROR;
 	}
-	if (fd >= 0) {
-		(void) fd_release_lock(fd);
-		(void) close(fd);
-	}
 	if (slurm_conf.debug_flags & DEBUG_FLAG_CPU_FREQ) {
 		newfreq = _cpu_freq_get_scaling_freq(cpx, option);
 		if (newfreq != freq) {
@@ -1133,15 +1136,115 @@ _cpu_freq_check_freq(const char* arg)
 	return 0;
 }
 
+/*
+ * Apply the new settings of one cpu, the caller holds its owner lock
+ */
+static int _cpu_freq_set_cpu(int i)
+{
+	char freq_detail[100];
+	uint32_t freq;
+	int rc;
+
+	log_flag(CPU_FREQ, "cpu_freq: current_state cpu=%d org_min=%u org_freq=%u org_max=%u org_gpv=%s",
+		 i, cpufreq[i].org_min_freq, cpufreq[i].org_frequency,
+		 cpufreq[i].org_max_freq, cpufreq[i].org_governor);
+
+	/* Max must be set before min, per
+	 * www.kernel.org/doc/Documentation/cpu-freq/user-guide.txt
+	 */
+	if (cpufreq[i].new_max_freq != NO_VAL ) {
+		freq = cpufreq[i].new_max_freq;
+		if (cpufreq[i].org_frequency > freq) {
+			/* The current frequency is > requested max,
+			 * Set it so it is in range
+			 * have to go to UserSpace to do it. */
+			rc = _cpu_freq_set_gov(i, "userspace");
+			if (rc == SLURM_ERROR)
+				return SLURM_ERROR;
+			rc = _cpu_freq_set_scaling_freq(i, freq,
+					         "scaling_setspeed");
+			if (rc == SLURM_ERROR)
+				return SLURM_ERROR;
+			if (cpufreq[i].new_governor[0] == '\0') {
+				/* Not requesting new gov, so restore */
+				rc = _cpu_freq_set_gov(i,
+					cpufreq[i].org_governor);
+				if (rc == SLURM_ERROR)
+					return SLURM_ERROR;
+			}
+		}
+		rc = _cpu_freq_set_scaling_freq(i, freq,
+						"scaling_max_freq");
+		if (rc == SLURM_ERROR)
+			return SLURM_ERROR;
+	}
+	if (cpufreq[i].new_min_freq != NO_VAL) {
+		freq = cpufreq[i].new_min_freq;
+		if (cpufreq[i].org_frequency < freq) {
+			/* The current frequency is < requested min,
+			 * Set it so it is in range
+			 * have to go to UserSpace to do it. */
+			rc = _cpu_freq_set_gov(i, "userspace");
+			if (rc == SLURM_ERROR)
+				return SLURM_ERROR;
+			rc = _cpu_freq_set_scaling_freq(i, freq,
+					         "scaling_setspeed");
+			if (rc == SLURM_ERROR)
+				return SLURM_ERROR;
+			if (cpufreq[i].new_governor[0] == '\0') {
+				/* Not requesting new gov, so restore */
+				rc= _cpu_freq_set_gov(i,
+					cpufreq[i].org_governor);
+				if (rc == SLURM_ERROR)
+					return SLURM_ERROR;
+			}
+		}
+		rc= _cpu_freq_set_scaling_freq(i, freq,
+					       "scaling_min_freq");
+		if (rc == SLURM_ERROR)
+			return SLURM_ERROR;
+	}
+	if (cpufreq[i].new_frequency != NO_VAL) {
+		if (xstrcmp(cpufreq[i].org_governor,"userspace")) {
+			rc = _cpu_freq_set_gov(i, "userspace");
+			if (rc == SLURM_ERROR)
+				return SLURM_ERROR;
+		}
+		rc = _cpu_freq_set_scaling_freq(i,
+				cpufreq[i].new_frequency,
+				"scaling_setspeed");
+		if (rc == SLURM_ERROR)
+			return SLURM_ERROR;
+	}
+	if (cpufreq[i].new_governor[0] != '\0') {
+		rc = _cpu_freq_set_gov(i, cpufreq[i].new_governor);
+		if (rc == SLURM_ERROR)
+			return SLURM_ERROR;
+	}
+	if (slurm_conf.debug_flags & DEBUG_FLAG_CPU_FREQ) {
+		cpu_freq_debug(NULL, NULL,
+				freq_detail, sizeof(freq_detail),
+				NO_VAL, cpufreq[i].new_min_freq,
+				cpufreq[i].new_max_freq,
+				cpufreq[i].new_frequency);
+		if (cpufreq[i].new_governor[0] != '\0') {
+			info("cpu_freq: set cpu=%d %s Governor=%s",
+			     i, freq_detail, cpufreq[i].new_governor);
+		} else {
+			info("cpu_freq: reset cpu=%d %s", i,
+			     freq_detail);
+		}
+	}
+	return SLURM_SUCCESS;
+}
+
 /*
  * set cpu frequency if possible for each cpu of the job step
  */
 extern void
 cpu_freq_set(stepd_step_rec_t *job)
 {
-	char freq_detail[100];
-	uint32_t freq;
-	int i, rc;
+	int i, fd;
 
 	if ((!cpu_freq_count) || (!cpufreq))
 		return;
@@ -1153,97 +1256,69 @@ cpu_freq_set(stepd_step_rec_t *job)
 		    && cpufreq[i].new_governor[0] == '\0')
 			continue; /* Nothing to set on this CPU */
 
-		log_flag(CPU_FREQ, "cpu_freq: current_state cpu=%d org_min=%u org_freq=%u org_max=%u org_gpv=%s",
-			 i, cpufreq[i].org_min_freq, cpufreq[i].org_frequency,
-			 cpufreq[i].org_max_freq, cpufreq[i].org_governor);
+		fd = _set_cpu_owner_lock(i, job->step_id.job_id);
+		(void) _cpu_freq_set_cpu(i);
+		_release_cpu_owner_lock(fd);
+	}
+}
 
-		/* Max must be set before min, per
-		 * www.kernel.org/doc/Documentation/cpu-freq/user-guide.txt
-		 */
-		if (cpufreq[i].new_max_freq != NO_VAL ) {
-			freq = cpufreq[i].new_max_freq;
-			if (cpufreq[i].org_frequency > freq) {
-				/* The current frequency is > requested max,
-				 * Set it so it is in range
-				 * have to go to UserSpace to do it. */
-				rc = _cpu_freq_set_gov(job, i, "userspace");
-				if (rc == SLURM_ERROR)
-					return;
-				rc = _cpu_freq_set_scaling_freq(job, i, freq,
-						         "scaling_setspeed");
-				if (rc == SLURM_ERROR)
-					continue;
-				if (cpufreq[i].new_governor[0] == '\0') {
-					/* Not requesting new gov, so restore */
-					rc = _cpu_freq_set_gov(job, i,
-						cpufreq[i].org_governor);
-					if (rc == SLURM_ERROR)
-						continue;
-				}
-			}
-			rc = _cpu_freq_set_scaling_freq(job, i, freq,
-							"scaling_max_freq");
-			if (rc == SLURM_ERROR)
-				continue;
-		}
-		if (cpufreq[i].new_min_freq != NO_VAL) {
-			freq = cpufreq[i].new_min_freq;
-			if (cpufreq[i].org_frequency < freq) {
-				/* The current frequency is < requested min,
-				 * Set it so it is in range
-				 * have to go to UserSpace to do it. */
-				rc = _cpu_freq_set_gov(job, i, "userspace");
-				if (rc == SLURM_ERROR)
-					continue;
-				rc = _cpu_freq_set_scaling_freq(job, i, freq,
-						         "scaling_setspeed");
-				if (rc == SLURM_ERROR)
-					continue;
-				if (cpufreq[i].new_governor[0] == '\0') {
-					/* Not requesting new gov, so restore */
-					rc= _cpu_freq_set_gov(job, i,
-						cpufreq[i].org_governor);
-					if (rc == SLURM_ERROR)
-						continue;
-				}
-			}
-			rc= _cpu_freq_set_scaling_freq(job, i, freq,
-						       "scaling_min_freq");
-			if (rc == SLURM_ERROR)
-				continue;
-		}
-		if (cpufreq[i].new_frequency != NO_VAL) {
-			if (xstrcmp(cpufreq[i].org_governor,"userspace")) {
-				rc = _cpu_freq_set_gov(job, i, "userspace");
-				if (rc == SLURM_ERROR)
-					continue;
-			}
-			rc = _cpu_freq_set_scaling_freq(job, i,
-					cpufreq[i].new_frequency,
-					"scaling_setspeed");
-			if (rc == SLURM_ERROR)
-				continue;
-		}
+/*
+ * Restore the original settings of one cpu, the caller holds its owner lock
+ */
+static int _cpu_freq_reset_cpu(int i)
+{
+	char freq_detail[100];
+	int rc;
+
+	if (cpufreq[i].new_frequency != NO_VAL) {
+		rc = _cpu_freq_set_gov(i, "userspace");
+		if (rc == SLURM_ERROR)
+			return SLURM_ERROR;
+		rc = _cpu_freq_set_scaling_freq(i,
+				cpufreq[i].org_frequency,
+				"scaling_setspeed");
+		if (rc == SLURM_ERROR)
+			return SLURM_ERROR;
+		cpufreq[i].new_governor[0] = 'u'; /* force gov reset */
+	}
+	/* Max must be set before min, per
+	 * www.kernel.org/doc/Documentation/cpu-freq/user-guide.txt
+	 */
+	if (cpufreq[i].new_max_freq != NO_VAL) {
+		rc = _cpu_freq_set_scaling_freq(i,
+				cpufreq[i].org_max_freq,
+				"scaling_max_freq");
+		if (rc == SLURM_ERROR)
+			return SLURM_ERROR;
+	}
+	if (cpufreq[i].new_min_freq != NO_VAL) {
+		rc = _cpu_freq_set_scaling_freq(i,
+				cpufreq[i].org_min_freq,
+				"scaling_min_freq");
+		if (rc == SLURM_ERROR)
+			return SLURM_ERROR;
+	}
+	if (cpufreq[i].new_governor[0] != '\0') {
+		rc = _cpu_freq_set_gov(i, cpufreq[i].org_governor);
+		if (rc == SLURM_ERROR)
+			return SLURM_ERROR;
+	}
+
+	if (slurm_conf.debug_flags & DEBUG_FLAG_CPU_FREQ) {
+		cpu_freq_debug(NULL, NULL,
+				freq_detail, sizeof(freq_detail),
+				NO_VAL, cpufreq[i].org_min_freq,
+				cpufreq[i].org_max_freq,
+				cpufreq[i].org_frequency);
 		if (cpufreq[i].new_governor[0] != '\0') {
-			rc = _cpu_freq_set_gov(job, i, cpufreq[i].new_governor);
-			if (rc == SLURM_ERROR)
-				continue;
-		}
-		if (slurm_conf.debug_flags & DEBUG_FLAG_CPU_FREQ) {
-			cpu_freq_debug(NULL, NULL,
-					freq_detail, sizeof(freq_detail),
-					NO_VAL, cpufreq[i].new_min_freq,
-					cpufreq[i].new_max_freq,
-					cpufreq[i].new_frequency);
-			if (cpufreq[i].new_governor[0] != '\0') {
-				info("cpu_freq: set cpu=%d %s Governor=%s",
-				     i, freq_detail, cpufreq[i].new_governor);
-			} else {
-				info("cpu_freq: reset cpu=%d %s", i,
-				     freq_detail);
-			}
+			info("cpu_freq: reset cpu=%d %s Governor=%s",
+			     i, freq_detail, cpufreq[i].org_governor);
+		} else {
+			info("cpu_freq: reset cpu=%d %s", i,
+			     freq_detail);
 		}
 	}
+	return SLURM_SUCCESS;
 }
 
 /*
@@ -1253,8 +1328,7 @@ cpu_freq_set(stepd_step_rec_t *job)
 extern void
 cpu_freq_reset(stepd_step_rec_t *job)
 {
-	int i, rc, fd;
-	char freq_detail[100];
+	int i, fd;
 	uint32_t jobid;
 
 	if ((!cpu_freq_count) || (!cpufreq))
@@ -1276,58 +1350,12 @@ cpu_freq_reset(stepd_step_rec_t *job)
 		    && cpufreq[i].new_governor[0] == '\0')
 			continue; /* Nothing to reset on this CPU */
 
-		fd = _test_cpu_owner_lock(i, jobid);
-		if (fd < 0)
+		if (_test_cpu_owner_lock(i, jobid) < 0)
 			continue;
 
-		if (cpufreq[i].new_frequency != NO_VAL) {
-			rc = _cpu_freq_set_gov(job, i, "userspace");
-			if (rc == SLURM_ERROR)
-				continue;
-			rc = _cpu_freq_set_scaling_freq(job, i,
-					cpufreq[i].org_frequency,
-					"scaling_setspeed");
-			if (rc == SLURM_ERROR)
-				continue;
-			cpufreq[i].new_governor[0] = 'u'; /* force gov reset */
-		}
-		/* Max must be set before min, per
-		 * www.kernel.org/doc/Documentation/cpu-freq/user-guide.txt
-		 */
-		if (cpufreq[i].new_max_freq != NO_VAL) {
-			rc = _cpu_freq_set_scaling_freq(job, i,
-					cpufreq[i].org_max_freq,
-					"scaling_max_freq");
-			if (rc == SLURM_ERROR)
-				continue;
-		}
-		if (cpufreq[i].new_min_freq != NO_VAL) {
-			rc = _cpu_freq_set_scaling_freq(job, i,
-					cpufreq[i].org_min_freq,
-					"scaling_min_freq");
-			if (rc == SLURM_ERROR)
-				continue;
-		}
-		if (cpufreq[i].new_governor[0] != '\0') {
-			rc = _cpu_freq_set_gov(job, i, cpufreq[i].org_governor);
-			if (rc == SLURM_ERROR)
-				continue;
-		}
-
-		if (slurm_conf.debug_flags & DEBUG_FLAG_CPU_FREQ) {
-			cpu_freq_debug(NULL, NULL,
-					freq_detail, sizeof(freq_detail),
-					NO_VAL, cpufreq[i].org_min_freq,
-					cpufreq[i].org_max_freq,
-					cpufreq[i].org_frequency);
-			if (cpufreq[i].new_governor[0] != '\0') {
-				info("cpu_freq: reset cpu=%d %s Governor=%s",
-				     i, freq_detail, cpufreq[i].org_governor);
-			} else {
-				info("cpu_freq: reset cpu=%d %s", i,
-				     freq_detail);
-			}
-		}
+		fd = _set_cpu_owner_lock(i, jobid);
+		(void) _cpu_freq_reset_cpu(i);
+		_release_cpu_owner_lock(fd);
 	}
 }
 
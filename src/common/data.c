@@ -47,6 +47,7 @@
 #include "src/common/log.h"
 #include "src/common/read_config.h"
 #include "src/common/xassert.h"
+#include "src/common/xhash.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
@@ -73,6 +74,8 @@ static bool initialized = false; /* protected by init_mutex */
 #define DATA_MAGIC 0x1992189F
 #define DATA_LIST_MAGIC 0x1992F89F
 #define DATA_LIST_NODE_MAGIC 0x1921F89F
+/* dictionaries with at least this many keys get a key index */
+#define DATA_DICT_HASH_MIN 16
 
 typedef struct data_list_node_s data_list_node_t;
 struct data_list_node_s {
@@ -90,6 +93,8 @@ struct data_list_s {
 
 	data_list_node_t *begin;
 	data_list_node_t *end;
+
+	xhash_t *key_hash; /* index of dictionary nodes by key or NULL */
 };
 
 static void _check_magic(const data_t *data);
@@ -308,6 +313,8 @@ static void _release_data_list_node(data_list_t *dl, data_list_node_t *dn)
 	}
 
 	dl->count--;
+	if (dl->key_hash && dn->key)
+		(void) xhash_pop_str(dl->key_hash, dn->key);
 	FREE_NULL_DATA(dn->data);
 	xfree(dn->key);
 
@@ -345,6 +352,7 @@ static void _release_data_list(data_list_t *dl)
 #ifndef NDEBUG
 	xassert(count == init_count);
 #endif
+	xhash_free(dl->key_hash);
 	dl->magic = ~DATA_LIST_MAGIC;
 	xfree(dl);
 }
@@ -370,6 +378,55 @@ static data_list_node_t *_new_data_list_node(data_t *d, const char *key)
 	return dn;
 }
 
+static void _data_list_node_id(void *item, const char **key,
+			       uint32_t *key_len)
+{
+	data_list_node_t *dn = item;
+
+	*key = dn->key;
+	*key_len = strlen(dn->key);
+}
+
+/* Add an already linked node to the key index, creating it once needed */
+static void _data_list_hash_add(data_list_t *dl, data_list_node_t *dn)
+{
+	data_list_node_t *i;
+
+	if (!dn->key)
+		return;
+
+	if (dl->key_hash) {
+		xhash_add(dl->key_hash, dn);
+		return;
+	}
+
+	if (dl->count < DATA_DICT_HASH_MIN)
+		return;
+
+	dl->key_hash = xhash_init(_data_list_node_id, NULL);
+	for (i = dl->begin; i; i = i->next)
+		xhash_add(dl->key_hash, i);
+}
+
+/* Find dictionary node by key */
+static data_list_node_t *_data_list_find_key(const data_list_t *dl,
+					     const char *key)
+{
+	data_list_node_t *i;
+
+	if (dl->key_hash)
+		return xhash_get_str(dl->key_hash, key);
+
+	for (i = dl->begin; i; i = i->next) {
+		_check_data_list_node_magic(i);
+
+		if (!xstrcmp(key, i->key))
+			break;
+	}
+
+	return i;
+}
+
 static void _data_list_append(data_list_t *dl, data_t *d, const char *key)
 {
 	data_list_node_t *n = _new_data_list_node(d, key);
@@ -390,6 +447,7 @@ static void _data_list_append(data_list_t *dl, data_t *d, const char *key)
 	}
 
 	dl->count++;
+	_data_list_hash_add(dl, n);
 }
 
 static void _data_list_prepend(data_list_t *dl, data_t *d, const char *key)
@@ -409,6 +467,7 @@ static void _data_list_prepend(data_list_t *dl, data_t *d, const char *key)
 	}
 
 	dl->count++;
+	_data_list_hash_add(dl, n);
 }
 
 data_t *data_new(void)
@@ -695,15 +754,7 @@ const data_t *data_key_get_const(const data_t *data, const char *key)
 		return NULL;
 
 	_check_data_list_magic(data->data.dict_u);
-	i = data->data.dict_u->begin;
-	while (i) {
-		_check_data_list_node_magic(i);
-
-		if (!xstrcmp(key, i->key))
-			break;
-
-		i = i->next;
-	}
+	i = _data_list_find_key(data->data.dict_u, key);
 
 	if (i)
 		return i->data;
@@ -725,15 +776,7 @@ data_t *data_key_get(data_t *data, const char *key)
 		return NULL;
 
 	_check_data_list_magic(data->data.dict_u);
-	i = data->data.dict_u->begin;
-	while (i) {
-		_check_data_list_node_magic(i);
-
-		if (!xstrcmp(key, i->key))
-			break;
-
-		i = i->next;
-	}
+	i = _data_list_find_key(data->data.dict_u, key);
 
 	if (i)
 		return i->data;
@@ -786,15 +829,7 @@ bool data_key_unset(data_t *data, const char *key)
 		return NULL;
 
 	_check_data_list_magic(data->data.dict_u);
-	i = data->data.dict_u->begin;
-	while (i) {
-		_check_data_list_node_magic(i);
-
-		if (!xstrcmp(key, i->key))
-			break;
-
-		i = i->next;
-	}
+	i = _data_list_find_key(data->data.dict_u, key);
 
 	if (!i) {
 		log_flag(DATA, "%s: remove non-existent key in data (0x%"PRIXPTR") key: %s",
@@ -44,6 +44,10 @@
 #include <sys/socket.h>
 #include <unistd.h>
 
+#if defined(__linux__)
+#include <sys/epoll.h>
+#endif
+
 #if defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__)
 #define POLLRDHUP POLLHUP
 #endif
@@ -88,6 +92,13 @@ struct eio_handle_components {
 	uint16_t shutdown_wait;
 	List obj_list;
 	List new_objs;
+#if defined(__linux__)
+	int epfd;		/* epoll instance, -1 if using poll() */
+	int ep_size;		/* length of the per fd arrays below */
+	short *ep_reg;		/* poll events registered with epfd */
+	short *ep_want;		/* poll events wanted on this pass */
+	eio_obj_t **ep_map;	/* object wanting events on this pass */
+#endif
 };
 
 /* Function prototypes */
@@ -99,12 +110,19 @@ static void         _poll_dispatch(struct pollfd *, unsigned int, eio_obj_t **,
 		                   List objList);
 static void         _poll_handle_event(short revents, eio_obj_t *obj,
 		                       List objList);
+#if defined(__linux__)
+static int          _epoll_mainloop(eio_handle_t *eio);
+#endif
 
 eio_handle_t *eio_handle_create(uint16_t shutdown_wait)
 {
 	eio_handle_t *eio = xmalloc(sizeof(*eio));
 
 	eio->magic = EIO_MAGIC;
+#if defined(__linux__)
+	if ((eio->epfd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+		debug("%s: epoll_create1: %m, using poll()", __func__);
+#endif
 
 	if (pipe(eio->fds) < 0) {
 		error("%s: pipe: %m", __func__);
@@ -135,6 +153,13 @@ void eio_handle_destroy(eio_handle_t *eio)
 	close(eio->fds[1]);
 	FREE_NULL_LIST(eio->obj_list);
 	FREE_NULL_LIST(eio->new_objs);
+#if defined(__linux__)
+	if (eio->epfd >= 0)
+		close(eio->epfd);
+	xfree(eio->ep_reg);
+	xfree(eio->ep_want);
+	xfree(eio->ep_map);
+#endif
 	slurm_mutex_destroy(&eio->shutdown_mutex);
 
 	eio->magic = ~EIO_MAGIC;
@@ -267,6 +292,24 @@ static int _eio_wakeup_handler(eio_handle_t *eio)
 	return 0;
 }
 
+/* Return true once shutdown_wait has passed since eio_signal_shutdown() */
+static bool _shutdown_expired(eio_handle_t *eio)
+{
+	time_t shutdown_time;
+
+	slurm_mutex_lock(&eio->shutdown_mutex);
+	shutdown_time = eio->shutdown_time;
+	slurm_mutex_unlock(&eio->shutdown_mutex);
+	if (shutdown_time &&
+	    (difftime(time(NULL), shutdown_time)>=eio->shutdown_wait)) {
+		error("%s: Abandoning IO %d secs after job shutdown initiated",
+		      __func__, eio->shutdown_wait);
+		return true;
+	}
+
+	return false;
+}
+
 int eio_handle_mainloop(eio_handle_t *eio)
 {
 	int            retval  = 0;
@@ -279,6 +322,13 @@ int eio_handle_mainloop(eio_handle_t *eio)
 	xassert (eio != NULL);
 	xassert (eio->magic == EIO_MAGIC);
 
+#if defined(__linux__)
+	/* Continue below with poll() if epoll can't handle some fd */
+	if ((eio->epfd >= 0) && ((retval = _epoll_mainloop(eio)) != 1))
+		return retval;
+	retval = 0;
+#endif
+
 	while (1) {
 		/* Alloc memory for pfds and map if needed */
 		n = list_count(eio->obj_list);
@@ -321,15 +371,8 @@ int eio_handle_mainloop(eio_handle_t *eio)
 
 		_poll_dispatch(pollfds, nfds - 1, map, eio->obj_list);
 
-		slurm_mutex_lock(&eio->shutdown_mutex);
-		shutdown_time = eio->shutdown_time;
-		slurm_mutex_unlock(&eio->shutdown_mutex);
-		if (shutdown_time &&
-		    (difftime(time(NULL), shutdown_time)>=eio->shutdown_wait)) {
-			error("%s: Abandoning IO %d secs after job shutdown initiated",
-			      __func__, eio->shutdown_wait);
+		if (_shutdown_expired(eio))
 			break;
-		}
 	}
 
 error:
@@ -486,6 +529,236 @@ static void _poll_handle_event(short revents, eio_obj_t *obj, List objList)
 	}
 }
 
+#if defined(__linux__)
+/*
+ * epoll backend for eio_handle_mainloop()
+ *
+ * The readable()/writable() callbacks are still asked on every pass, as they
+ * decide from application state what each object is interested in, but the
+ * fds stay registered with the kernel between passes and epoll_ctl() is only
+ * called when the wanted events of an fd change. epoll_wait() then only
+ * returns the fds that are ready instead of poll() scanning all of them.
+ *
+ * Registrations are level-triggered and keyed by fd. Since epoll keeps
+ * reporting a closed fd as long as some dup of it is still open elsewhere
+ * (e.g. in a freshly forked child), readiness of the reported fds is
+ * confirmed with a zero timeout poll() before dispatching, which is O(ready)
+ * rather than O(objects).
+ *
+ * Anything epoll can't handle (regular files, two objects on the same fd)
+ * makes the handle fall back to poll() for good.
+ */
+
+static uint32_t _poll_to_epoll(short events)
+{
+	uint32_t ep_events = 0;
+
+	if (events & POLLIN)
+		ep_events |= EPOLLIN;
+	if (events & POLLOUT)
+		ep_events |= EPOLLOUT;
+	if (events & POLLHUP)
+		ep_events |= EPOLLHUP;
+	if (events & POLLRDHUP)
+		ep_events |= EPOLLRDHUP;
+
+	return ep_events;
+}
+
+static void _epoll_fallback(eio_handle_t *eio)
+{
+	close(eio->epfd);
+	eio->epfd = -1;
+	xfree(eio->ep_reg);
+	xfree(eio->ep_want);
+	xfree(eio->ep_map);
+	eio->ep_size = 0;
+}
+
+static void _epoll_grow(eio_handle_t *eio, int fd)
+{
+	if (fd < eio->ep_size)
+		return;
+
+	/* xrealloc() zero fills the new part */
+	eio->ep_size = fd + 64;
+	xrealloc(eio->ep_reg, eio->ep_size * sizeof(short));
+	xrealloc(eio->ep_want, eio->ep_size * sizeof(short));
+	xrealloc(eio->ep_map, eio->ep_size * sizeof(eio_obj_t *));
+}
+
+/* Bring the registration of fd in line with eio->ep_want[fd] */
+static int _epoll_update(eio_handle_t *eio, int fd)
+{
+	struct epoll_event ev = { 0 };
+	int op, rc;
+
+	if (!eio->ep_want[fd]) {
+		/* fd may be closed already, that removed it too */
+		(void) epoll_ctl(eio->epfd, EPOLL_CTL_DEL, fd, &ev);
+		eio->ep_reg[fd] = 0;
+		return SLURM_SUCCESS;
+	}
+
+	ev.events = _poll_to_epoll(eio->ep_want[fd]);
+	ev.data.fd = fd;
+	op = eio->ep_reg[fd] ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+	rc = epoll_ctl(eio->epfd, op, fd, &ev);
+	/* fd was closed and reused behind our back */
+	if ((rc < 0) && (op == EPOLL_CTL_MOD) && (errno == ENOENT))
+		rc = epoll_ctl(eio->epfd, EPOLL_CTL_ADD, fd, &ev);
+	else if ((rc < 0) && (op == EPOLL_CTL_ADD) && (errno == EEXIST))
+		rc = epoll_ctl(eio->epfd, EPOLL_CTL_MOD, fd, &ev);
+	if (rc < 0) {
+		debug("%s: epoll_ctl(%d): %m, falling back to poll()",
+		      __func__, fd);
+		return SLURM_ERROR;
+	}
+
+	eio->ep_reg[fd] = eio->ep_want[fd];
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Record what every object wants on this pass and update the epoll set.
+ * RET number of objects wanting events, or -1 to fall back to poll()
+ */
+static int _epoll_setup(eio_handle_t *eio)
+{
+	ListIterator itr;
+	eio_obj_t *obj;
+	int nobjs = 0, fd;
+	bool readable, writable;
+	short events;
+
+	memset(eio->ep_want, 0, eio->ep_size * sizeof(short));
+	memset(eio->ep_map, 0, eio->ep_size * sizeof(eio_obj_t *));
+
+	itr = list_iterator_create(eio->obj_list);
+	while ((obj = list_next(itr))) {
+		writable = _is_writable(obj);
+		readable = _is_readable(obj);
+		if (writable && readable)
+			events = POLLOUT | POLLIN | POLLHUP | POLLRDHUP;
+		else if (readable)
+			events = POLLIN | POLLRDHUP;
+		else if (writable)
+			events = POLLOUT | POLLHUP;
+		else
+			continue;
+
+		/* Counted, like poll() would wait on a negative fd */
+		nobjs++;
+		if (obj->fd < 0)
+			continue;
+
+		_epoll_grow(eio, obj->fd);
+		if (eio->ep_map[obj->fd]) {
+			debug("%s: fd %d is shared by several objects, falling back to poll()",
+			      __func__, obj->fd);
+			nobjs = -1;
+			break;
+		}
+		eio->ep_map[obj->fd] = obj;
+		eio->ep_want[obj->fd] = events;
+	}
+	list_iterator_destroy(itr);
+
+	if (nobjs <= 0)
+		return nobjs;
+
+	_epoll_grow(eio, eio->fds[0]);
+	eio->ep_want[eio->fds[0]] = POLLIN;
+
+	for (fd = 0; fd < eio->ep_size; fd++) {
+		if ((eio->ep_want[fd] != eio->ep_reg[fd]) &&
+		    (_epoll_update(eio, fd) != SLURM_SUCCESS))
+			return -1;
+	}
+
+	return nobjs;
+}
+
+/* RET 0 when done, -1 on error or 1 to continue with poll() instead */
+static int _epoll_mainloop(eio_handle_t *eio)
+{
+	struct epoll_event *events = NULL;
+	struct pollfd *pollfds = NULL;
+	eio_obj_t **map = NULL;
+	int retval = 0, maxevents = 0, nobjs, timeout, n, i, fd;
+	unsigned int nfds;
+	bool wakeup;
+	time_t shutdown_time;
+
+	while (1) {
+		if ((nobjs = _epoll_setup(eio)) < 0) {
+			_epoll_fallback(eio);
+			retval = 1;
+			break;
+		} else if (!nobjs)
+			break;
+
+		/* Alloc memory for events, pfds and map if needed */
+		if (maxevents < (nobjs + 1)) {
+			maxevents = nobjs + 1;
+			xrealloc(events, maxevents * sizeof(*events));
+			xrealloc(pollfds, maxevents * sizeof(*pollfds));
+			xrealloc(map, maxevents * sizeof(*map));
+		}
+
+		slurm_mutex_lock(&eio->shutdown_mutex);
+		shutdown_time = eio->shutdown_time;
+		slurm_mutex_unlock(&eio->shutdown_mutex);
+		if (shutdown_time)
+			timeout = 1000;	/* Return every 1000 msec during shutdown */
+		else
+			timeout = -1;
+		n = epoll_wait(eio->epfd, events, maxevents, timeout);
+		if (n < 0) {
+			if (errno != EINTR) {
+				error("epoll_wait: %m");
+				retval = -1;
+				break;
+			}
+			n = 0;
+		}
+
+		wakeup = false;
+		nfds = 0;
+		for (i = 0; i < n; i++) {
+			fd = events[i].data.fd;
+			if (fd == eio->fds[0]) {
+				wakeup = true;
+			} else if ((fd < eio->ep_size) && eio->ep_map[fd]) {
+				pollfds[nfds].fd = fd;
+				pollfds[nfds].events = eio->ep_want[fd];
+				map[nfds] = eio->ep_map[fd];
+				nfds++;
+			}
+		}
+		/* Anything missed on EINTR is reported again next pass */
+		if (nfds && (poll(pollfds, nfds, 0) <= 0))
+			nfds = 0;
+
+		/* See if we've been told to shut down by eio_signal_shutdown */
+		if (wakeup)
+			_eio_wakeup_handler(eio);
+
+		_poll_dispatch(pollfds, nfds, map, eio->obj_list);
+
+		if (_shutdown_expired(eio)) {
+			retval = -1;
+			break;
+		}
+	}
+
+	xfree(events);
+	xfree(pollfds);
+	xfree(map);
+	return retval;
+}
+#endif
+
 static struct io_operations *_ops_copy(struct io_operations *ops)
 {
 	struct io_operations *ret = xmalloc(sizeof(*ops));
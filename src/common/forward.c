@@ -55,6 +55,19 @@
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
+#define FWD_FAIL_CNT	64	/* failed forwarders remembered */
+#define FWD_FAIL_AGE	120	/* seconds to avoid a failed forwarder */
+
+typedef struct {
+	char *name;
+	time_t time;
+} fwd_fail_t;
+
+static pthread_mutex_t fwd_fail_lock = PTHREAD_MUTEX_INITIALIZER;
+static fwd_fail_t fwd_fail[FWD_FAIL_CNT];
+static int fwd_fail_next = 0;
+static int fwd_fail_used = 0;
+
 typedef struct {
 	pthread_cond_t *notify;
 	int            *p_thr_count;
@@ -73,6 +86,79 @@ static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
 				  header_t *header, int timeout,
 				  int hl_count);
 
+/*
+ * Remember a node that failed to receive or forward a message, so it is not
+ * picked again as the head of a branch for FWD_FAIL_AGE seconds.
+ */
+static void _note_fwd_failure(const char *name)
+{
+	int i;
+
+	slurm_mutex_lock(&fwd_fail_lock);
+	for (i = 0; i < fwd_fail_used; i++) {
+		if (!xstrcmp(fwd_fail[i].name, name)) {
+			fwd_fail[i].time = time(NULL);
+			slurm_mutex_unlock(&fwd_fail_lock);
+			return;
+		}
+	}
+	xfree(fwd_fail[fwd_fail_next].name);
+	fwd_fail[fwd_fail_next].name = xstrdup(name);
+	fwd_fail[fwd_fail_next].time = time(NULL);
+	fwd_fail_next = (fwd_fail_next + 1) % FWD_FAIL_CNT;
+	if (fwd_fail_used < FWD_FAIL_CNT)
+		fwd_fail_used++;
+	slurm_mutex_unlock(&fwd_fail_lock);
+}
+
+static bool _fwd_failed_recently(const char *name, time_t now)
+{
+	int i;
+	bool rc = false;
+
+	slurm_mutex_lock(&fwd_fail_lock);
+	for (i = 0; i < fwd_fail_used; i++) {
+		if (!xstrcmp(fwd_fail[i].name, name)) {
+			rc = (difftime(now, fwd_fail[i].time) < FWD_FAIL_AGE);
+			break;
+		}
+	}
+	slurm_mutex_unlock(&fwd_fail_lock);
+
+	return rc;
+}
+
+/*
+ * Shift the node to send to next from a branch's hostlist. Nodes which
+ * recently failed are moved to the end of the list, so they are reached
+ * through another node rather than delaying every node under them.
+ * RET node name, must be free()'d, or NULL if the hostlist is empty
+ */
+static char *_shift_forwarder(hostlist_t hl)
+{
+	int i, cnt;
+	char *name;
+	time_t now;
+
+	if (!fwd_fail_used || ((cnt = hostlist_count(hl)) < 2))
+		return hostlist_shift(hl);
+
+	now = time(NULL);
+	for (i = 0; (i < cnt) && (i <= FWD_FAIL_CNT); i++) {
+		if (!(name = hostlist_shift(hl)))
+			return NULL;
+		if (!_fwd_failed_recently(name, now))
+			return name;
+		debug3("%s: skipping recently failed forwarder %s",
+		       __func__, name);
+		hostlist_push_host(hl, name);
+		free(name);
+	}
+
+	/* Every candidate failed recently, use the next one anyway */
+	return hostlist_shift(hl);
+}
+
 void _destroy_tree_fwd(fwd_tree_t *fwd_tree)
 {
 	if (fwd_tree) {
@@ -108,7 +194,7 @@ void *_forward_thread(void *arg)
 	int start_timeout = fwd_msg->timeout;
 
 	/* repeat until we are sure the message was sent */
-	while ((name = hostlist_shift(hl))) {
+	while ((name = _shift_forwarder(hl))) {
 		if (slurm_conf_get_addr(name, &addr, fwd_msg->header.flags)
 		    == SLURM_ERROR) {
 			error("forward_thread: can't find address for host "
@@ -125,6 +211,7 @@ void *_forward_thread(void *arg)
 		}
 		if ((fd = slurm_open_msg_conn(&addr)) < 0) {
 			error("forward_thread to %s: %m", name);
+			_note_fwd_failure(name);
 
 			slurm_mutex_lock(&fwd_struct->forward_mutex);
 			mark_as_failed_forward(
@@ -183,6 +270,7 @@ void *_forward_thread(void *arg)
 				     get_buf_data(buffer),
 				     get_buf_offset(buffer)) < 0) {
 			error("forward_thread: slurm_msg_sendto: %m");
+			_note_fwd_failure(name);
 
 			slurm_mutex_lock(&fwd_struct->forward_mutex);
 			mark_as_failed_forward(&fwd_struct->ret_list, name,
@@ -249,6 +337,7 @@ void *_forward_thread(void *arg)
 
 		if (!ret_list || (fwd_msg->header.forward.cnt != 0
 				  && list_count(ret_list) <= 1)) {
+			_note_fwd_failure(name);
 			slurm_mutex_lock(&fwd_struct->forward_mutex);
 			mark_as_failed_forward(&fwd_struct->ret_list, name,
 					       errno);
@@ -354,7 +443,7 @@ void *_fwd_tree_thread(void *arg)
 	send_msg.protocol_version = fwd_tree->orig_msg->protocol_version;
 
 	/* repeat until we are sure the message was sent */
-	while ((name = hostlist_shift(fwd_tree->tree_hl))) {
+	while ((name = _shift_forwarder(fwd_tree->tree_hl))) {
 		if (slurm_conf_get_addr(name, &send_msg.address, send_msg.flags)
 		    == SLURM_ERROR) {
 			error("fwd_tree_thread: can't find address for host "
@@ -425,6 +514,7 @@ void *_fwd_tree_thread(void *arg)
 			FREE_NULL_LIST(ret_list);
 			/* try next node */
 			if (ret_cnt <= send_msg.forward.cnt) {
+				_note_fwd_failure(name);
 				free(name);
 				/* Abandon tree. This way if all the
 				 * nodes in the branch are down we
@@ -455,11 +545,14 @@ void *_fwd_tree_thread(void *arg)
 			continue;
 		}
 
-		free(name);
-
 		/* check for error and try again */
-		if (errno == SLURM_COMMUNICATIONS_CONNECTION_ERROR)
- 			continue;
+		if (errno == SLURM_COMMUNICATIONS_CONNECTION_ERROR) {
+			_note_fwd_failure(name);
+			free(name);
+			continue;
+		}
+
+		free(name);
 
 		break;
 	}
@@ -546,6 +639,7 @@ static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
 		fwd_msg->header.flags = header->flags;
 		fwd_msg->header.msg_type = header->msg_type;
 		fwd_msg->header.body_length = header->body_length;
+		fwd_msg->header.trace_id = header->trace_id;
 		fwd_msg->header.ret_list = NULL;
 		fwd_msg->header.ret_cnt = 0;
 
@@ -5770,9 +5770,9 @@ extern int gres_job_state_pack(List gres_list, buf_t *buffer,
 			if (gres_job_ptr->gres_bit_alloc) {
 				pack8((uint8_t) 1, buffer);
 				for (i = 0; i < gres_job_ptr->node_cnt; i++) {
-					pack_bit_str_hex(gres_job_ptr->
-							 gres_bit_alloc[i],
-							 buffer);
+					pack_bit_str(gres_job_ptr->
+						     gres_bit_alloc[i],
+						     buffer, protocol_version);
 				}
 			} else {
 				pack8((uint8_t) 0, buffer);
@@ -5780,9 +5780,9 @@ extern int gres_job_state_pack(List gres_list, buf_t *buffer,
 			if (details && gres_job_ptr->gres_bit_step_alloc) {
 				pack8((uint8_t) 1, buffer);
 				for (i = 0; i < gres_job_ptr->node_cnt; i++) {
-					pack_bit_str_hex(gres_job_ptr->
-							 gres_bit_step_alloc[i],
-							 buffer);
+					pack_bit_str(gres_job_ptr->
+						     gres_bit_step_alloc[i],
+						     buffer, protocol_version);
 				}
 			} else {
 				pack8((uint8_t) 0, buffer);
@@ -5823,9 +5823,9 @@ extern int gres_job_state_pack(List gres_list, buf_t *buffer,
 			if (gres_job_ptr->gres_bit_alloc) {
 				pack8((uint8_t) 1, buffer);
 				for (i = 0; i < gres_job_ptr->node_cnt; i++) {
-					pack_bit_str_hex(gres_job_ptr->
-							 gres_bit_alloc[i],
-							 buffer);
+					pack_bit_str(gres_job_ptr->
+						     gres_bit_alloc[i],
+						     buffer, protocol_version);
 				}
 			} else {
 				pack8((uint8_t) 0, buffer);
@@ -5833,9 +5833,9 @@ extern int gres_job_state_pack(List gres_list, buf_t *buffer,
 			if (details && gres_job_ptr->gres_bit_step_alloc) {
 				pack8((uint8_t) 1, buffer);
 				for (i = 0; i < gres_job_ptr->node_cnt; i++) {
-					pack_bit_str_hex(gres_job_ptr->
-							 gres_bit_step_alloc[i],
-							 buffer);
+					pack_bit_str(gres_job_ptr->
+						     gres_bit_step_alloc[i],
+						     buffer, protocol_version);
 				}
 			} else {
 				pack8((uint8_t) 0, buffer);
@@ -5937,9 +5937,10 @@ extern int gres_job_state_unpack(List *gres_list, buf_t *buffer,
 					     gres_job_ptr->node_cnt,
 					     sizeof(bitstr_t *));
 				for (i = 0; i < gres_job_ptr->node_cnt; i++) {
-					unpack_bit_str_hex(&gres_job_ptr->
-							   gres_bit_alloc[i],
-							   buffer);
+					unpack_bit_str(&gres_job_ptr->
+						       gres_bit_alloc[i],
+						       buffer,
+						       protocol_version);
 				}
 			}
 			safe_unpack8(&has_more, buffer);
@@ -5948,9 +5949,10 @@ extern int gres_job_state_unpack(List *gres_list, buf_t *buffer,
 					     gres_job_ptr->node_cnt,
 					     sizeof(bitstr_t *));
 				for (i = 0; i < gres_job_ptr->node_cnt; i++) {
-					unpack_bit_str_hex(&gres_job_ptr->
-							   gres_bit_step_alloc[i],
-							   buffer);
+					unpack_bit_str(&gres_job_ptr->
+						       gres_bit_step_alloc[i],
+						       buffer,
+						       protocol_version);
 				}
 			}
 			safe_unpack8(&has_more, buffer);
@@ -6000,9 +6002,10 @@ extern int gres_job_state_unpack(List *gres_list, buf_t *buffer,
 					     gres_job_ptr->node_cnt,
 					     sizeof(bitstr_t *));
 				for (i = 0; i < gres_job_ptr->node_cnt; i++) {
-					unpack_bit_str_hex(&gres_job_ptr->
-							   gres_bit_alloc[i],
-							   buffer);
+					unpack_bit_str(&gres_job_ptr->
+						       gres_bit_alloc[i],
+						       buffer,
+						       protocol_version);
 				}
 			}
 			safe_unpack8(&has_more, buffer);
@@ -6011,9 +6014,10 @@ extern int gres_job_state_unpack(List *gres_list, buf_t *buffer,
 					     gres_job_ptr->node_cnt,
 					     sizeof(bitstr_t *));
 				for (i = 0; i < gres_job_ptr->node_cnt; i++) {
-					unpack_bit_str_hex(&gres_job_ptr->
-							   gres_bit_step_alloc[i],
-							   buffer);
+					unpack_bit_str(&gres_job_ptr->
+						       gres_bit_step_alloc[i],
+						       buffer,
+						       protocol_version);
 				}
 			}
 			safe_unpack8(&has_more, buffer);
@@ -6107,9 +6111,9 @@ extern int gres_job_alloc_pack(List gres_list, buf_t *buffer,
 			if (gres_job_ptr->gres_bit_alloc) {
 				pack8((uint8_t) 1, buffer);
 				for (i = 0; i < gres_job_ptr->node_cnt; i++) {
-					pack_bit_str_hex(gres_job_ptr->
-							 gres_bit_alloc[i],
-							 buffer);
+					pack_bit_str(gres_job_ptr->
+						     gres_bit_alloc[i],
+						     buffer, protocol_version);
 				}
 			} else {
 				pack8((uint8_t) 0, buffer);
@@ -6201,9 +6205,10 @@ extern int gres_job_alloc_unpack(List *gres_list, buf_t *buffer,
 					     gres_job_ptr->node_cnt,
 					     sizeof(bitstr_t *));
 				for (i = 0; i < gres_job_ptr->node_cnt; i++) {
-					unpack_bit_str_hex(&gres_job_ptr->
-							   gres_bit_alloc[i],
-							   buffer);
+					unpack_bit_str(&gres_job_ptr->
+						       gres_bit_alloc[i],
+						       buffer,
+						       protocol_version);
 				}
 			}
 		} else {
@@ -6858,6 +6863,14 @@ extern char *gres_sock_str(List sock_gres_list, int sock_inx)
 	return gres_str;
 }
 
+/* Return true if any bit in the range [start, end) of a bitmap is set */
+static bool _bit_range_any(bitstr_t *b, int start, int end)
+{
+	if (start >= bit_size(b))
+		return false;
+	return (bit_set_count_range(b, start, end) > 0);
+}
+
 /*
  * Determine how many GRES of a given type can be used by this job on a
  * given node and return a structure with the details. Note that multiple
@@ -6886,6 +6899,35 @@ static sock_gres_t *_build_sock_gres_by_topo(
 	if (node_gres_ptr->gres_cnt_avail == 0)
 		return NULL;
 
+	/*
+	 * Reject the node before building per-socket bitmaps if the sum of
+	 * its free GRES of the requested type is below the node minimum
+	 */
+	if (job_gres_ptr->gres_per_node)
+		min_gres = job_gres_ptr->gres_per_node;
+	if (job_gres_ptr->gres_per_task)
+		min_gres = MAX(min_gres, job_gres_ptr->gres_per_task);
+	if (min_gres > 1) {
+		avail_gres = 0;
+		for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
+			if (job_gres_ptr->type_name &&
+			    (job_gres_ptr->type_id !=
+			     node_gres_ptr->topo_type_id[i]))
+				continue;
+			if (use_total_gres || node_gres_ptr->no_consume) {
+				avail_gres +=
+					node_gres_ptr->topo_gres_cnt_avail[i];
+			} else if (node_gres_ptr->topo_gres_cnt_avail[i] >
+				   node_gres_ptr->topo_gres_cnt_alloc[i]) {
+				avail_gres +=
+					node_gres_ptr->topo_gres_cnt_avail[i] -
+					node_gres_ptr->topo_gres_cnt_alloc[i];
+			}
+		}
+		if (avail_gres < min_gres)
+			return NULL;	/* Insufficient GRES remaining */
+	}
+
 	if (!use_total_gres &&
 	    gres_id_shared(main_plugin_id) &&
 	    (node_gres_ptr->gres_cnt_alloc != 0)) {
@@ -6951,16 +6993,10 @@ static sock_gres_t *_build_sock_gres_by_topo(
 		    node_gres_ptr->topo_core_bitmap[i]) {
 			use_all_sockets = true;
 			for (s = 0; s < sockets; s++) {
-				bool use_this_socket = false;
-				for (c = 0; c < cores_per_sock; c++) {
-					j = (s * cores_per_sock) + c;
-					if (bit_test(node_gres_ptr->
-						     topo_core_bitmap[i], j)) {
-						use_this_socket = true;
-						break;
-					}
-				}
-				if (!use_this_socket) {
+				j = s * cores_per_sock;
+				if (!_bit_range_any(
+					    node_gres_ptr->topo_core_bitmap[i],
+					    j, j + cores_per_sock)) {
 					use_all_sockets = false;
 					break;
 				}
@@ -6997,44 +7033,34 @@ static sock_gres_t *_build_sock_gres_by_topo(
 						 topo_core_bitmap[i]));
 		}
 		for (s = 0; ((s < sockets) && avail_gres); s++) {
-			if (enforce_binding && core_bitmap) {
-				for (c = 0; c < cores_per_sock; c++) {
-					j = (s * cores_per_sock) + c;
-					if (bit_test(core_bitmap, j))
-						break;
-				}
-				if (c >= cores_per_sock) {
-					/* No available cores on this socket */
-					continue;
-				}
+			j = s * cores_per_sock;
+			if (enforce_binding && core_bitmap &&
+			    !_bit_range_any(core_bitmap, j,
+					    j + cores_per_sock)) {
+				/* No available cores on this socket */
+				continue;
 			}
-			for (c = 0; c < cores_per_sock; c++) {
-				j = (s * cores_per_sock) + c;
-				if (j >= tot_cores)
-					break;	/* Off end of core bitmap */
-				if (node_gres_ptr->topo_core_bitmap[i] &&
-				    !bit_test(node_gres_ptr->topo_core_bitmap[i],
-					      j))
-					continue;
-				if (!node_gres_ptr->topo_gres_bitmap[i]) {
-					error("%s: topo_gres_bitmap NULL on node %s",
-					      __func__, node_name);
-					continue;
-				}
-				if (!sock_gres->bits_by_sock[s]) {
-					sock_gres->bits_by_sock[s] =
-						bit_copy(node_gres_ptr->
-							 topo_gres_bitmap[i]);
-				} else {
-					bit_or(sock_gres->bits_by_sock[s],
-					       node_gres_ptr->topo_gres_bitmap[i]);
-				}
-				sock_gres->cnt_by_sock[s] += avail_gres;
-				sock_gres->total_cnt += avail_gres;
-				avail_gres = 0;
-				match = true;
-				break;
+			if (!_bit_range_any(node_gres_ptr->topo_core_bitmap[i],
+					    j, MIN(j + cores_per_sock,
+						   tot_cores)))
+				continue;
+			if (!node_gres_ptr->topo_gres_bitmap[i]) {
+				error("%s: topo_gres_bitmap NULL on node %s",
+				      __func__, node_name);
+				continue;
 			}
+			if (!sock_gres->bits_by_sock[s]) {
+				sock_gres->bits_by_sock[s] =
+					bit_copy(node_gres_ptr->
+						 topo_gres_bitmap[i]);
+			} else {
+				bit_or(sock_gres->bits_by_sock[s],
+				       node_gres_ptr->topo_gres_bitmap[i]);
+			}
+			sock_gres->cnt_by_sock[s] += avail_gres;
+			sock_gres->total_cnt += avail_gres;
+			avail_gres = 0;
+			match = true;
 		}
 	}
 
@@ -7112,14 +7138,8 @@ static sock_gres_t *_build_sock_gres_by_topo(
 		xfree(avail_sock_flag);
 	}
 
-	if (match) {
-		if (job_gres_ptr->gres_per_node)
-			min_gres = job_gres_ptr->gres_per_node;
-		if (job_gres_ptr->gres_per_task)
-			min_gres = MAX(min_gres, job_gres_ptr->gres_per_task);
-		if (sock_gres->total_cnt < min_gres)
-			match = false;
-	}
+	if (match && (sock_gres->total_cnt < min_gres))
+		match = false;
 
 
 	/*
@@ -8473,7 +8493,8 @@ extern int gres_step_state_pack(List gres_list, buf_t *buffer,
 			pack64(gres_step_ptr->mem_per_gres, buffer);
 			pack64(gres_step_ptr->total_gres, buffer);
 			pack32(gres_step_ptr->node_cnt, buffer);
-			pack_bit_str_hex(gres_step_ptr->node_in_use, buffer);
+			pack_bit_str(gres_step_ptr->node_in_use, buffer,
+				     protocol_version);
 			if (gres_step_ptr->gres_cnt_node_alloc) {
 				pack8((uint8_t) 1, buffer);
 				pack64_array(gres_step_ptr->gres_cnt_node_alloc,
@@ -8484,9 +8505,9 @@ extern int gres_step_state_pack(List gres_list, buf_t *buffer,
 			if (gres_step_ptr->gres_bit_alloc) {
 				pack8((uint8_t) 1, buffer);
 				for (i = 0; i < gres_step_ptr->node_cnt; i++)
-					pack_bit_str_hex(gres_step_ptr->
-							 gres_bit_alloc[i],
-							 buffer);
+					pack_bit_str(gres_step_ptr->
+						     gres_bit_alloc[i],
+						     buffer, protocol_version);
 			} else {
 				pack8((uint8_t) 0, buffer);
 			}
@@ -8557,7 +8578,8 @@ extern int gres_step_state_unpack(List *gres_list, buf_t *buffer,
 			safe_unpack32(&gres_step_ptr->node_cnt, buffer);
 			if (gres_step_ptr->node_cnt > NO_VAL)
 				goto unpack_error;
-			unpack_bit_str_hex(&gres_step_ptr->node_in_use, buffer);
+			unpack_bit_str(&gres_step_ptr->node_in_use, buffer,
+				       protocol_version);
 			safe_unpack8(&data_flag, buffer);
 			if (data_flag) {
 				safe_unpack64_array(
@@ -8570,9 +8592,10 @@ extern int gres_step_state_unpack(List *gres_list, buf_t *buffer,
 					xcalloc(gres_step_ptr->node_cnt,
 						sizeof(bitstr_t *));
 				for (i = 0; i < gres_step_ptr->node_cnt; i++) {
-					unpack_bit_str_hex(&gres_step_ptr->
-							   gres_bit_alloc[i],
-							   buffer);
+					unpack_bit_str(&gres_step_ptr->
+						       gres_bit_alloc[i],
+						       buffer,
+						       protocol_version);
 				}
 			}
 		} else {
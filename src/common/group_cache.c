@@ -43,8 +43,12 @@
  *   grow.
  * - This always succeeds. The only error getgrouplist() is allowed to throw
  *   is -1 for not enough space, and we will xrealloc to handle this.
- *   In practice, if the name service cannot resolve a given user ID you will
- *   get an array back with a single element equal to the gid passed in.
+ *   If the name service cannot resolve a given user ID the entry holds a
+ *   single element equal to the gid passed in, and is cached like any other
+ *   so unknown users do not hit the name service on every lookup.
+ * - Entries are hashed on (uid, gid). The name service is called without
+ *   gids_mutex held, so a slow lookup for one user does not block lookups
+ *   for every other user.
  */
 
 #include <grp.h>
@@ -54,36 +58,40 @@
 #include "src/common/read_config.h"
 #include "src/common/timers.h"
 #include "src/common/uid.h"
+#include "src/common/xhash.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
 /* how many groups to use by default to avoid repeated calls to getgrouplist */
 #define NGROUPS_START 64
 
-typedef struct gids_cache {
+typedef struct {
 	uid_t uid;
 	gid_t gid;
-	char *username;
+} gids_cache_key_t;
+
+typedef struct gids_cache {
+	gids_cache_key_t key;
 	int ngids;
 	gid_t *gids;
 	time_t expiration;
 } gids_cache_t;
 
-typedef struct gids_cache_needle {
-	uid_t uid;		/* required */
-	gid_t gid;		/* required */
-	char *username;		/* optional, will be looked up if needed */
-	time_t now;		/* automatically filled in */
-} gids_cache_needle_t;
-
 static pthread_mutex_t gids_mutex = PTHREAD_MUTEX_INITIALIZER;
-static List gids_cache_list = NULL;
+static xhash_t *gids_cache = NULL;
+
+static void _gids_cache_id(void *item, const char **key, uint32_t *key_len)
+{
+	gids_cache_t *entry = item;
+
+	*key = (const char *) &entry->key;
+	*key_len = sizeof(entry->key);
+}
 
-static void _group_cache_list_delete(void *x)
+static void _group_cache_delete(void *x)
 {
 	gids_cache_t *entry = (gids_cache_t *) x;
 	xfree(entry->gids);
-	xfree(entry->username);
 	xfree(entry);
 }
 
@@ -91,98 +99,96 @@ static void _group_cache_list_delete(void *x)
 void group_cache_purge(void)
 {
 	slurm_mutex_lock(&gids_mutex);
-	if (gids_cache_list)
-		list_destroy(gids_cache_list);
-	gids_cache_list = NULL;
+	xhash_free(gids_cache);
 	slurm_mutex_unlock(&gids_mutex);
 }
 
-static int _find_entry(void *x, void *key)
+/*
+ * Query the name service for the extended groups of a user
+ * IN: uid
+ * IN: gid - primary group id (will always exist first in gids list)
+ * IN: (optional) username, will be looked up if NULL
+ * OUT: gids - xmalloc'd gid_t * structure with ngids elements
+ * RET: ngids
+ */
+static int _getgrouplist(uid_t uid, gid_t gid, char *username, gid_t **gids)
 {
-	gids_cache_t *entry = (gids_cache_t *) x;
-	gids_cache_needle_t *needle = (gids_cache_needle_t *) key;
+	char *name = username;
+	int ngids = NGROUPS_START;
+
+	if (!name && !(name = uid_to_string_or_null(uid))) {
+		debug2("%s: unknown uid %u, caching primary group only",
+		       __func__, uid);
+		*gids = xmalloc(sizeof(gid_t));
+		(*gids)[0] = gid;
+		return 1;
+	}
 
-	if (needle->uid != entry->uid)
-		return 0;
+	*gids = xmalloc(sizeof(gid_t) * ngids);
+#if defined(__APPLE__)
+	/*
+	 * macOS has (int *) for the third argument instead
+	 * of (gid_t *) like FreeBSD, NetBSD, and Linux.
+	 */
+	while (getgrouplist(name, gid, (int *) *gids, &ngids) == -1) {
+#else
+	while (getgrouplist(name, gid, *gids, &ngids) == -1) {
+#endif
+		/* group list larger than array, resize array to fit */
+		*gids = xrealloc(*gids, ngids * sizeof(gid_t));
+	}
 
-	if (needle->gid != entry->gid)
-		return 0;
+	if (name != username)
+		xfree(name);
 
-	/* success! all checks passed, we've found it */
-	return 1;
+	return ngids;
 }
 
 /*
  * OUT: ngids as return value
- * IN: populated needle structure
- * IN: primary group id (will always exist first in gids list)
+ * IN: uid
+ * IN: gid - primary group id (will always exist first in gids list)
+ * IN: (optional) username, will be looked up if NULL and is needed
  * IN/OUT: gids - xmalloc'd gid_t * structure with ngids elements
  */
-static int _group_cache_lookup_internal(gids_cache_needle_t *needle, gid_t **gids)
+extern int group_cache_lookup(uid_t uid, gid_t gid, char *username, gid_t **gids)
 {
+	gids_cache_key_t key = { .uid = uid, .gid = gid };
 	gids_cache_t *entry;
+	gid_t *new_gids = NULL;
 	int ngids; /* need a copy to safely return outside the lock */
+	time_t now = time(NULL);
 	DEF_TIMERS;
 	START_TIMER;
 
 	slurm_mutex_lock(&gids_mutex);
-	if (!gids_cache_list)
-		gids_cache_list = list_create(_group_cache_list_delete);
-
-	needle->now = time(NULL);
-	entry = list_find_first(gids_cache_list, _find_entry, needle);
+	if (!gids_cache)
+		gids_cache = xhash_init(_gids_cache_id, _group_cache_delete);
 
-	if (entry && (entry->expiration > needle->now)) {
-		debug2("%s: found valid entry for %s",
-		       __func__, entry->username);
+	entry = xhash_get(gids_cache, (char *) &key, sizeof(key));
+	if (entry && (entry->expiration > now)) {
+		debug2("%s: found valid entry for uid %u", __func__, uid);
 		goto out;
 	}
+	slurm_mutex_unlock(&gids_mutex);
 
-	if (entry) {
-		debug2("%s: found old entry for %s, looking up again",
-		       __func__, entry->username);
-		/*
-		 * The timestamp is too old, need to replace the values.
-		 * Reuse the same gids_cache_t entry, just reset the
-		 * ngids to the largest the gids field can store.
-		 */
-		entry->ngids = xsize(entry->gids) / sizeof(gid_t);
-	} else {
-		/* no result, allocate and add to list */
-		entry = xmalloc(sizeof(gids_cache_t));
-		if (!needle->username)
-			entry->username = uid_to_string(needle->uid);
-		else
-			entry->username = xstrdup(needle->username);
-		entry->uid = needle->uid;
-		entry->gid = needle->gid;
-		entry->ngids = NGROUPS_START;
-		entry->gids = xmalloc(sizeof(gid_t) * entry->ngids);
-		list_prepend(gids_cache_list, entry);
-
-		debug2("%s: no entry found for %s",
-		       __func__, entry->username);
-	}
-
-	entry->expiration = needle->now + slurm_conf.group_time;
+	debug2("%s: %s entry for uid %u, looking up",
+	       __func__, entry ? "found old" : "no", uid);
+	ngids = _getgrouplist(uid, gid, username, &new_gids);
 
-	/* Cache lookup failed or entry value was too old, fetch new
-	 * value and insert it into cache.  */
-#if defined(__APPLE__)
-	/*
-	 * macOS has (int *) for the third argument instead
-	 * of (gid_t *) like FreeBSD, NetBSD, and Linux.
-	 */
-	while (getgrouplist(entry->username, entry->gid,
-			    (int *)entry->gids, &entry->ngids) == -1) {
-#else
-	while (getgrouplist(entry->username, entry->gid,
-			    entry->gids, &entry->ngids) == -1) {
-#endif
-		/* group list larger than array, resize array to fit */
-		entry->gids = xrealloc(entry->gids,
-				       entry->ngids * sizeof(gid_t));
+	/* The entry may have been replaced or purged while unlocked */
+	slurm_mutex_lock(&gids_mutex);
+	if (!gids_cache)
+		gids_cache = xhash_init(_gids_cache_id, _group_cache_delete);
+	if (!(entry = xhash_get(gids_cache, (char *) &key, sizeof(key)))) {
+		entry = xmalloc(sizeof(gids_cache_t));
+		entry->key = key;
+		xhash_add(gids_cache, entry);
 	}
+	xfree(entry->gids);
+	entry->gids = new_gids;
+	entry->ngids = ngids;
+	entry->expiration = now + slurm_conf.group_time;
 
 out:
 	ngids = entry->ngids;
@@ -197,33 +203,15 @@ out:
 	return ngids;
 }
 
-/*
- * OUT: ngids as return value
- * IN: uid
- * IN: gid - primary group id (will always exist first in gids list)
- * IN: (optional) username, will be looked up if NULL and is needed
- * IN/OUT: gids - xmalloc'd gid_t * structure with ngids elements
- */
-extern int group_cache_lookup(uid_t uid, gid_t gid, char *username, gid_t **gids)
-{
-	gids_cache_needle_t needle = {0};
-
-	needle.username = username;
-	needle.uid = uid;
-	needle.gid = gid;
-
-	return _group_cache_lookup_internal(&needle, gids);
-}
-
-static int _cleanup_search(void *x, void *key)
+static void _find_expired(void *x, void *arg)
 {
 	gids_cache_t *cached = (gids_cache_t *) x;
-	time_t *now = (time_t *) key;
+	void **args = arg;
+	time_t *now = args[0];
+	List expired = args[1];
 
 	if (cached->expiration < *now)
-		return 1;
-
-	return 0;
+		list_append(expired, &cached->key);
 }
 
 /*
@@ -232,10 +220,20 @@ static int _cleanup_search(void *x, void *key)
 extern void group_cache_cleanup(void)
 {
 	time_t now = time(NULL);
+	List expired;
+	void *args[2];
+	gids_cache_key_t *key;
 
 	slurm_mutex_lock(&gids_mutex);
-	if (gids_cache_list)
-		list_delete_all(gids_cache_list, _cleanup_search, &now);
+	if (gids_cache) {
+		expired = list_create(NULL);
+		args[0] = &now;
+		args[1] = expired;
+		xhash_walk(gids_cache, _find_expired, args);
+		while ((key = list_pop(expired)))
+			xhash_delete(gids_cache, (char *) key, sizeof(*key));
+		FREE_NULL_LIST(expired);
+	}
 	slurm_mutex_unlock(&gids_mutex);
 }
 
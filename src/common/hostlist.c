@@ -84,6 +84,7 @@ strong_alias(hostlist_deranged_string_xmalloc,
 					slurm_hostlist_deranged_string_xmalloc);
 strong_alias(hostlist_destroy,		slurm_hostlist_destroy);
 strong_alias(hostlist_find,		slurm_hostlist_find);
+strong_alias(hostlist_for_each_host,	slurm_hostlist_for_each_host);
 strong_alias(hostlist_iterator_create,	slurm_hostlist_iterator_create);
 strong_alias(hostlist_iterator_destroy,	slurm_hostlist_iterator_destroy);
 strong_alias(hostlist_iterator_reset,	slurm_hostlist_iterator_reset);
@@ -1244,12 +1245,13 @@ static int hostlist_resize(hostlist_t hl, size_t newsize)
 	return 1;
 }
 
-/* Resize hostlist by one HOSTLIST_CHUNK
+/* Grow hostlist by its current size (at least one HOSTLIST_CHUNK) so that
+ * pushing many disjoint ranges does not realloc once per HOSTLIST_CHUNK
  * Assumes that hostlist hl is locked by caller
  */
 static int hostlist_expand(hostlist_t hl)
 {
-	if (!hostlist_resize(hl, hl->size + HOSTLIST_CHUNK))
+	if (!hostlist_resize(hl, hl->size + MAX(hl->size, HOSTLIST_CHUNK)))
 		return 0;
 	else
 		return 1;
@@ -1946,6 +1948,50 @@ int hostlist_push(hostlist_t hl, const char *hosts)
 	return retval;
 }
 
+/*
+ * Push a single one-dimensional host name without building intermediate
+ * hostname_t and hostrange_t objects. The prefix is split off into a stack
+ * buffer and a new range is only allocated when the host can not be merged
+ * into the tail range of hl.
+ * RET 1 if pushed, 0 if the name must go through the generic path
+ */
+static int _push_host_1d(hostlist_t hl, const char *str)
+{
+	char prefix[HOST_NAME_MAX + 1];
+	hostrange_t hr;
+	int idx, len, width;
+
+	len = strlen(str);
+	idx = len - 1;
+	while ((idx >= 0) && isdigit((int)str[idx]))
+		idx--;
+	width = len - idx - 1;
+
+	if (width == 0) {
+		/* no numeric suffix, prefix is the whole name */
+		hr.prefix = (char *) str;
+		hr.lo = hr.hi = 0L;
+		hr.width = 0;
+		hr.singlehost = 1;
+	} else if ((width < 10) && (idx < (int) sizeof(prefix) - 1)) {
+		unsigned long num = 0;
+		int i;
+
+		for (i = idx + 1; i < len; i++)
+			num = (num * 10) + (str[i] - '0');
+		memcpy(prefix, str, idx + 1);
+		prefix[idx + 1] = '\0';
+		hr.prefix = prefix;
+		hr.lo = hr.hi = num;
+		hr.width = width;
+		hr.singlehost = 0;
+	} else
+		return 0;
+
+	hostlist_push_range(hl, &hr);
+	return 1;
+}
+
 int hostlist_push_host_dims(hostlist_t hl, const char *str, int dims)
 {
 	hostrange_t *hr;
@@ -1957,6 +2003,9 @@ int hostlist_push_host_dims(hostlist_t hl, const char *str, int dims)
 	if (!dims)
 		dims = slurmdb_setup_cluster_name_dims();
 
+	if ((dims == 1) && _push_host_1d(hl, str))
+		return 1;
+
 	hn = hostname_create_dims(str, dims);
 
 	if (hostname_suffix_is_valid(hn))
@@ -2340,6 +2389,58 @@ int hostlist_count(hostlist_t hl)
 	return retval;
 }
 
+int hostlist_for_each_host(hostlist_t hl, int (*f)(char *host, void *arg),
+			   void *arg)
+{
+	char buf[HOST_NAME_MAX + 16];
+	const int size = sizeof(buf);
+	int dims = slurmdb_setup_cluster_name_dims();
+	int i, len, count = 0;
+	unsigned long n;
+
+	xassert(f);
+
+	if (!hl)
+		return -1;
+
+	LOCK_HOSTLIST(hl);
+	for (i = 0; i < hl->nranges; i++) {
+		hostrange_t *hr = hl->hr[i];
+
+		len = snprintf(buf, size, "%s", hr->prefix);
+		if ((len < 0) || (len + dims >= size))
+			continue;
+
+		if (hr->singlehost) {
+			count++;
+			if (f(buf, arg) < 0)
+				goto done;
+			continue;
+		} else if (hostrange_empty(hr))
+			continue;
+
+		for (n = hr->lo; n <= hr->hi; n++) {
+			if ((dims > 1) && (hr->width == dims)) {
+				int i2 = 0, len2 = len;
+				int coord[dims];
+
+				hostlist_parse_int_to_array(n, coord, dims, 0);
+				while (i2 < dims)
+					buf[len2++] = alpha_num[coord[i2++]];
+				buf[len2] = '\0';
+			} else if (snprintf(buf + len, size - len, "%0*lu",
+					    hr->width, n) >= size - len)
+				continue;
+			count++;
+			if (f(buf, arg) < 0)
+				goto done;
+		}
+	}
+done:
+	UNLOCK_HOSTLIST(hl);
+	return count;
+}
+
 int hostlist_find_dims(hostlist_t hl, const char *hostname, int dims)
 {
 	int i, count, ret = -1;
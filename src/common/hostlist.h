@@ -256,6 +256,20 @@ int hostlist_pop_range_values(
 char * hostlist_shift_range(hostlist_t hl);
 
 
+/* hostlist_for_each_host():
+ *
+ * Call f() for every host in hostlist hl, in list order, without removing
+ * the hosts and without allocating a string per host. The host name passed
+ * to f() is only valid for the duration of the call. Iteration stops early
+ * if f() returns a negative value.
+ *
+ * Returns the number of hosts passed to f(), or -1 if hl is NULL.
+ * The hostlist is locked for the duration of the walk, so f() must not
+ * call back into hl.
+ */
+int hostlist_for_each_host(hostlist_t hl, int (*f)(char *host, void *arg),
+			   void *arg);
+
 /* hostlist_find():
  *
  * Searches hostlist hl for the first host matching hostname
@@ -51,6 +51,95 @@
 #include "src/common/xmalloc.h"
 #include "src/slurmctld/slurmctld.h"
 
+/*
+ * Per node arrays are mostly the same value repeated for every node of the
+ * job, so they are packed as runs of identical values from 21.08 on:
+ * element count, run count, then the value and repetitions of each run.
+ * size is the element size, 2 (uint16_t) or 8 (uint64_t).
+ */
+static uint64_t _array_get(void *array, int size, uint32_t i)
+{
+	if (size == sizeof(uint16_t))
+		return ((uint16_t *) array)[i];
+	return ((uint64_t *) array)[i];
+}
+
+static void _pack_array_rle(void *array, int size, uint32_t cnt,
+			    buf_t *buffer)
+{
+	uint32_t i, reps, run_cnt = 0;
+	uint64_t val;
+
+	if (!array)
+		cnt = 0;
+	pack32(cnt, buffer);
+	if (!cnt)
+		return;
+
+	for (i = 0; i < cnt; i++)
+		if (!i || (_array_get(array, size, i) !=
+			   _array_get(array, size, i - 1)))
+			run_cnt++;
+	pack32(run_cnt, buffer);
+
+	for (i = 0; i < cnt; i += reps) {
+		val = _array_get(array, size, i);
+		for (reps = 1; ((i + reps) < cnt) &&
+			       (_array_get(array, size, i + reps) == val);
+		     reps++)
+			;
+		if (size == sizeof(uint16_t))
+			pack16((uint16_t) val, buffer);
+		else
+			pack64(val, buffer);
+		pack32(reps, buffer);
+	}
+}
+
+/* Unpack an array of exactly nhosts elements, or none */
+static int _unpack_array_rle(void **array, int size, uint32_t nhosts,
+			     buf_t *buffer)
+{
+	uint32_t cnt, run_cnt, reps, i = 0, j;
+	uint16_t val16;
+	uint64_t val = 0;
+
+	*array = NULL;
+	safe_unpack32(&cnt, buffer);
+	if (!cnt)
+		return SLURM_SUCCESS;
+	if (cnt != nhosts)
+		goto unpack_error;
+
+	safe_unpack32(&run_cnt, buffer);
+	if (!run_cnt || (run_cnt > cnt))
+		goto unpack_error;
+	*array = xcalloc(cnt, size);
+	while (run_cnt--) {
+		if (size == sizeof(uint16_t)) {
+			safe_unpack16(&val16, buffer);
+			val = val16;
+		} else
+			safe_unpack64(&val, buffer);
+		safe_unpack32(&reps, buffer);
+		if (!reps || (reps > (cnt - i)))
+			goto unpack_error;
+		for (j = 0; j < reps; j++, i++) {
+			if (size == sizeof(uint16_t))
+				((uint16_t *) *array)[i] = val;
+			else
+				((uint64_t *) *array)[i] = val;
+		}
+	}
+	if (i != cnt)
+		goto unpack_error;
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	xfree(*array);
+	return SLURM_ERROR;
+}
 
 /* Create an empty job_resources data structure */
 extern job_resources_t *create_job_resources(void)
@@ -543,7 +632,66 @@ extern void pack_job_resources(job_resources_t *job_resrcs_ptr, buf_t *buffer,
 	int i;
 	uint32_t core_cnt = 0, sock_recs = 0;
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		if (job_resrcs_ptr == NULL) {
+			uint32_t empty = NO_VAL;
+			pack32(empty, buffer);
+			return;
+		}
+
+		pack32(job_resrcs_ptr->nhosts, buffer);
+		pack32(job_resrcs_ptr->ncpus, buffer);
+		pack32(job_resrcs_ptr->node_req, buffer);
+		packstr(job_resrcs_ptr->nodes, buffer);
+		pack8(job_resrcs_ptr->whole_node, buffer);
+
+		if (job_resrcs_ptr->cpu_array_reps)
+			pack32_array(job_resrcs_ptr->cpu_array_reps,
+				     job_resrcs_ptr->cpu_array_cnt, buffer);
+		else
+			pack32_array(job_resrcs_ptr->cpu_array_reps, 0, buffer);
+
+		if (job_resrcs_ptr->cpu_array_value)
+			pack16_array(job_resrcs_ptr->cpu_array_value,
+				     job_resrcs_ptr->cpu_array_cnt, buffer);
+		else
+			pack16_array(job_resrcs_ptr->cpu_array_value,
+				     0, buffer);
+
+		_pack_array_rle(job_resrcs_ptr->cpus, sizeof(uint16_t),
+				job_resrcs_ptr->nhosts, buffer);
+		_pack_array_rle(job_resrcs_ptr->cpus_used, sizeof(uint16_t),
+				job_resrcs_ptr->nhosts, buffer);
+		_pack_array_rle(job_resrcs_ptr->memory_allocated,
+				sizeof(uint64_t), job_resrcs_ptr->nhosts,
+				buffer);
+		_pack_array_rle(job_resrcs_ptr->memory_used, sizeof(uint64_t),
+				job_resrcs_ptr->nhosts, buffer);
+
+		xassert(job_resrcs_ptr->cores_per_socket);
+		xassert(job_resrcs_ptr->sock_core_rep_count);
+		xassert(job_resrcs_ptr->sockets_per_node);
+
+		for (i = 0; i < job_resrcs_ptr->nhosts; i++) {
+			sock_recs += job_resrcs_ptr->sock_core_rep_count[i];
+			if (sock_recs >= job_resrcs_ptr->nhosts)
+				break;
+		}
+		i++;
+		pack16_array(job_resrcs_ptr->sockets_per_node,
+			     (uint32_t) i, buffer);
+		pack16_array(job_resrcs_ptr->cores_per_socket,
+			     (uint32_t) i, buffer);
+		pack32_array(job_resrcs_ptr->sock_core_rep_count,
+			     (uint32_t) i, buffer);
+
+		xassert(job_resrcs_ptr->core_bitmap);
+		xassert(job_resrcs_ptr->core_bitmap_used);
+		pack_bit_str(job_resrcs_ptr->core_bitmap, buffer,
+			     protocol_version);
+		pack_bit_str(job_resrcs_ptr->core_bitmap_used, buffer,
+			     protocol_version);
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		if (job_resrcs_ptr == NULL) {
 			uint32_t empty = NO_VAL;
 			pack32(empty, buffer);
@@ -617,9 +765,10 @@ extern void pack_job_resources(job_resources_t *job_resrcs_ptr, buf_t *buffer,
 
 		xassert(job_resrcs_ptr->core_bitmap);
 		xassert(job_resrcs_ptr->core_bitmap_used);
-		pack_bit_str_hex(job_resrcs_ptr->core_bitmap, buffer);
-		pack_bit_str_hex(job_resrcs_ptr->core_bitmap_used,
-				 buffer);
+		pack_bit_str(job_resrcs_ptr->core_bitmap, buffer,
+			     protocol_version);
+		pack_bit_str(job_resrcs_ptr->core_bitmap_used, buffer,
+			     protocol_version);
 	} else {
 		error("pack_job_resources: protocol_version %hu not supported",
 		      protocol_version);
@@ -634,7 +783,67 @@ extern int unpack_job_resources(job_resources_t **job_resrcs_pptr,
 	job_resources_t *job_resrcs;
 
 	xassert(job_resrcs_pptr);
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		safe_unpack32(&empty, buffer);
+		if (empty == NO_VAL) {
+			*job_resrcs_pptr = NULL;
+			return SLURM_SUCCESS;
+		}
+
+		job_resrcs = xmalloc(sizeof(struct job_resources));
+		job_resrcs->nhosts = empty;
+		safe_unpack32(&job_resrcs->ncpus, buffer);
+		safe_unpack32(&job_resrcs->node_req, buffer);
+		safe_unpackstr_xmalloc(&job_resrcs->nodes, &tmp32, buffer);
+		safe_unpack8(&job_resrcs->whole_node, buffer);
+
+		safe_unpack32_array(&job_resrcs->cpu_array_reps,
+				    &tmp32, buffer);
+		if (tmp32 == 0)
+			xfree(job_resrcs->cpu_array_reps);
+		job_resrcs->cpu_array_cnt = tmp32;
+
+		safe_unpack16_array(&job_resrcs->cpu_array_value,
+				    &tmp32, buffer);
+		if (tmp32 == 0)
+			xfree(job_resrcs->cpu_array_value);
+
+		if (tmp32 != job_resrcs->cpu_array_cnt)
+			goto unpack_error;
+
+		if (_unpack_array_rle((void **) &job_resrcs->cpus,
+				      sizeof(uint16_t), job_resrcs->nhosts,
+				      buffer) ||
+		    (!job_resrcs->cpus && job_resrcs->nhosts) ||
+		    _unpack_array_rle((void **) &job_resrcs->cpus_used,
+				      sizeof(uint16_t), job_resrcs->nhosts,
+				      buffer) ||
+		    _unpack_array_rle((void **) &job_resrcs->memory_allocated,
+				      sizeof(uint64_t), job_resrcs->nhosts,
+				      buffer) ||
+		    _unpack_array_rle((void **) &job_resrcs->memory_used,
+				      sizeof(uint64_t), job_resrcs->nhosts,
+				      buffer))
+			goto unpack_error;
+
+		safe_unpack16_array(&job_resrcs->sockets_per_node,
+				    &tmp32, buffer);
+		if (tmp32 == 0)
+			xfree(job_resrcs->sockets_per_node);
+		safe_unpack16_array(&job_resrcs->cores_per_socket,
+				    &tmp32, buffer);
+		if (tmp32 == 0)
+			xfree(job_resrcs->cores_per_socket);
+		safe_unpack32_array(&job_resrcs->sock_core_rep_count,
+				    &tmp32, buffer);
+		if (tmp32 == 0)
+			xfree(job_resrcs->sock_core_rep_count);
+
+		unpack_bit_str(&job_resrcs->core_bitmap, buffer,
+			       protocol_version);
+		unpack_bit_str(&job_resrcs->core_bitmap_used, buffer,
+			       protocol_version);
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack32(&empty, buffer);
 		if (empty == NO_VAL) {
 			*job_resrcs_pptr = NULL;
@@ -692,9 +901,10 @@ extern int unpack_job_resources(job_resources_t **job_resrcs_pptr,
 		if (tmp32 == 0)
 			xfree(job_resrcs->sock_core_rep_count);
 
-		unpack_bit_str_hex(&job_resrcs->core_bitmap, buffer);
-		unpack_bit_str_hex(&job_resrcs->core_bitmap_used,
-				   buffer);
+		unpack_bit_str(&job_resrcs->core_bitmap, buffer,
+			       protocol_version);
+		unpack_bit_str(&job_resrcs->core_bitmap_used, buffer,
+			       protocol_version);
 	} else {
 		error("unpack_job_resources: protocol_version %hu not "
 		      "supported", protocol_version);
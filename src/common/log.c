@@ -143,6 +143,19 @@ static log_t            *sched_log = NULL;
 static volatile log_level_t highest_log_level = LOG_LEVEL_END;
 static volatile log_level_t highest_sched_log_level = LOG_LEVEL_QUIET;
 
+/*
+ * With log_set_async(), logfile messages are appended to log_queue under
+ * log_lock and written by log_writer_tid in batches. log_write_lock is held
+ * while writing the queue, and while the logfile is changed or closed, so
+ * that the file written to stays open and messages keep their order.
+ */
+static pthread_mutex_t  log_write_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   log_queue_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t        log_writer_tid = 0;
+static bool             log_async = false;
+static char             *log_queue = NULL;
+static char             *log_queue_pos = NULL;
+
 #define LOG_INITIALIZED ((log != NULL) && (log->initialized))
 #define SCHED_LOG_INITIALIZED ((sched_log != NULL) && (sched_log->initialized))
 /* define a default argv0 */
@@ -159,9 +172,25 @@ extern char * program_invocation_name;
 /*
  * pthread_atfork handlers:
  */
-static void _atfork_prep()   { slurm_mutex_lock(&log_lock);   }
-static void _atfork_parent() { slurm_mutex_unlock(&log_lock); }
-static void _atfork_child()  { slurm_mutex_unlock(&log_lock); }
+static void _atfork_prep()
+{
+	slurm_mutex_lock(&log_write_lock);
+	slurm_mutex_lock(&log_lock);
+}
+static void _atfork_parent()
+{
+	slurm_mutex_unlock(&log_lock);
+	slurm_mutex_unlock(&log_write_lock);
+}
+static void _atfork_child()
+{
+	/* The writer thread is not forked, queued messages belong to parent */
+	log_async = false;
+	log_writer_tid = 0;
+	log_queue = log_queue_pos = NULL;
+	slurm_mutex_unlock(&log_lock);
+	slurm_mutex_unlock(&log_write_lock);
+}
 static bool at_forked = false;
 #define atfork_install_handlers()					\
 	while (!at_forked) {						\
@@ -170,6 +199,7 @@ static bool at_forked = false;
 	}
 
 static void _log_flush(log_t *log);
+static void _log_queue_write(void);
 
 static log_level_t _highest_level(log_level_t a, log_level_t b, log_level_t c)
 {
@@ -507,6 +537,7 @@ void log_fini(void)
 	if (!log)
 		return;
 
+	log_set_async(false);
 	slurm_mutex_lock(&log_lock);
 	_log_flush(log);
 	xfree(log->argv0);
@@ -577,9 +608,12 @@ void log_set_argv0(char *argv0)
 int log_alter(log_options_t opt, log_facility_t fac, char *logfile)
 {
 	int rc = 0;
+	slurm_mutex_lock(&log_write_lock);
+	_log_queue_write();
 	slurm_mutex_lock(&log_lock);
 	rc = _log_init(NULL, opt, fac, logfile);
 	slurm_mutex_unlock(&log_lock);
+	slurm_mutex_unlock(&log_write_lock);
 	return rc;
 }
 
@@ -589,6 +623,8 @@ int log_alter(log_options_t opt, log_facility_t fac, char *logfile)
 int log_alter_with_fp(log_options_t opt, log_facility_t fac, FILE *fp_in)
 {
 	int rc = 0;
+	slurm_mutex_lock(&log_write_lock);
+	_log_queue_write();
 	slurm_mutex_lock(&log_lock);
 	rc = _log_init(NULL, opt, fac, NULL);
 	if (log->logfp)
@@ -602,6 +638,7 @@ int log_alter_with_fp(log_options_t opt, log_facility_t fac, FILE *fp_in)
 		 * outside of the logger */
 	}
 	slurm_mutex_unlock(&log_lock);
+	slurm_mutex_unlock(&log_write_lock);
 	return rc;
 }
 
@@ -1176,6 +1213,12 @@ static void _log_msg(log_level_t level, bool sched, bool spank, const char *fmt,
 	char *msgbuf = NULL;
 	int priority = LOG_INFO;
 
+	/*
+	 * Format the message before taking log_lock, so other threads only
+	 * wait for the output of messages and not their formatting.
+	 */
+	buf = vxstrfmt(fmt, args);
+
 	slurm_mutex_lock(&log_lock);
 
 	if (!LOG_INITIALIZED) {
@@ -1185,7 +1228,6 @@ static void _log_msg(log_level_t level, bool sched, bool spank, const char *fmt,
 
 	if (SCHED_LOG_INITIALIZED && sched &&
 	    (highest_sched_log_level > LOG_LEVEL_QUIET)) {
-		buf = vxstrfmt(fmt, args);
 		xlogfmtcat(&msgbuf, "[%M] %s%s%s", sched_log->fpfx, pfx, buf);
 		_log_printf(sched_log, sched_log->fbuf, sched_log->logfp,
 			    "sched: %s\n", msgbuf);
@@ -1251,12 +1293,6 @@ static void _log_msg(log_level_t level, bool sched, bool spank, const char *fmt,
 
 	}
 
-	if (!buf) {
-		/* format the basic message,
-		 * if not already done for scheduling log */
-		buf = vxstrfmt(fmt, args);
-	}
-
 	if (level <= log->opt.stderr_level) {
 
 		fflush(stdout);
@@ -1274,7 +1310,15 @@ static void _log_msg(log_level_t level, bool sched, bool spank, const char *fmt,
 		fflush(stderr);
 	}
 
-	if ((level <= log->opt.logfile_level) && (log->logfp != NULL)) {
+	if ((level <= log->opt.logfile_level) && (log->logfp != NULL) &&
+	    log_async && !log->opt.buffered) {
+		xlogfmtcat(&msgbuf, "[%M] %s%s%s\n", log->fpfx, pfx, buf);
+		xstrfmtcatat(log_queue, &log_queue_pos, "%s", msgbuf);
+		slurm_cond_signal(&log_queue_cond);
+
+		xfree(msgbuf);
+	} else if ((level <= log->opt.logfile_level) &&
+		   (log->logfp != NULL)) {
 
 		xlogfmtcat(&msgbuf, "[%M] %s%s%s", log->fpfx, pfx, buf);
 		_log_printf(log, log->fbuf, log->logfp, "%s\n", msgbuf);
@@ -1327,11 +1371,96 @@ _log_flush(log_t *log)
 void
 log_flush()
 {
+	slurm_mutex_lock(&log_write_lock);
+	_log_queue_write();
+	slurm_mutex_unlock(&log_write_lock);
+
 	slurm_mutex_lock(&log_lock);
 	_log_flush(log);
 	slurm_mutex_unlock(&log_lock);
 }
 
+/* Write queued logfile messages, log_write_lock must be locked */
+static void _log_queue_write(void)
+{
+	char *queue;
+	int fd = -1;
+
+	slurm_mutex_lock(&log_lock);
+	queue = log_queue;
+	log_queue = log_queue_pos = NULL;
+	if (log && log->logfp)
+		fd = fileno(log->logfp);
+	slurm_mutex_unlock(&log_lock);
+
+	if (!queue)
+		return;
+	if (fd >= 0)
+		safe_write(fd, queue, strlen(queue));
+
+rwfail:
+	xfree(queue);
+}
+
+static void *_log_writer(void *arg)
+{
+	slurm_mutex_lock(&log_lock);
+	while (log_async) {
+		if (!log_queue) {
+			slurm_cond_wait(&log_queue_cond, &log_lock);
+			continue;
+		}
+		slurm_mutex_unlock(&log_lock);
+
+		slurm_mutex_lock(&log_write_lock);
+		_log_queue_write();
+		slurm_mutex_unlock(&log_write_lock);
+
+		slurm_mutex_lock(&log_lock);
+	}
+	slurm_mutex_unlock(&log_lock);
+
+	return NULL;
+}
+
+/* Also run at exit() for messages queued without a later log_flush() */
+static void _log_queue_flush(void)
+{
+	slurm_mutex_lock(&log_write_lock);
+	_log_queue_write();
+	slurm_mutex_unlock(&log_write_lock);
+}
+
+void log_set_async(bool async)
+{
+	static bool atexit_set = false;
+	pthread_t tid;
+
+	slurm_mutex_lock(&log_lock);
+	if (log_async == async) {
+		slurm_mutex_unlock(&log_lock);
+		return;
+	}
+	log_async = async;
+	tid = log_writer_tid;
+	if (!async)
+		slurm_cond_signal(&log_queue_cond);
+	slurm_mutex_unlock(&log_lock);
+
+	if (async) {
+		if (!atexit_set) {
+			atexit(_log_queue_flush);
+			atexit_set = true;
+		}
+		slurm_thread_create(&log_writer_tid, _log_writer, NULL);
+	} else {
+		if (tid)
+			pthread_join(tid, NULL);
+		log_writer_tid = 0;
+		_log_queue_flush();
+	}
+}
+
 /*
  * attempt to log message and exit()
  */
@@ -222,6 +222,15 @@ bool log_has_data(void);
  */
 void log_flush(void);
 
+/*
+ * log_set_async() enables or disables writing logfile messages from a
+ * dedicated thread. Messages are formatted by the calling thread and queued,
+ * then written in batches, so that threads logging heavily do not wait for
+ * the logfile. log_flush() and fatal() write any queued messages before
+ * returning. stderr and syslog messages are still written synchronously.
+ */
+void log_set_async(bool async);
+
 /* log_set_debug_flags()
  * Set or reset the debug flags based on the configuration
  * file or the scontrol command.
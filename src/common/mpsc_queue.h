@@ -0,0 +1,117 @@
+/*****************************************************************************\
+ *  mpsc_queue.h - lock-free multiple producer, single consumer queue
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _HAVE_MPSC_QUEUE_H
+#define _HAVE_MPSC_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Intrusive queue: each element embeds an mpsc_link_t, so pushing never
+ * allocates. Any number of threads may push concurrently without locking.
+ * A single consumer takes everything queued at once with mpsc_queue_take(),
+ * oldest first, and walks the links with mpsc_entry().
+ *
+ * Usage:
+ *	typedef struct { ...; mpsc_link_t link; } foo_t;
+ *	static mpsc_queue_t queue = MPSC_QUEUE_INITIALIZER;
+ *
+ *	mpsc_queue_push(&queue, &foo->link);
+ *	...
+ *	mpsc_link_t *link = mpsc_queue_take(&queue);
+ *	while (link) {
+ *		foo_t *foo = mpsc_entry(link, foo_t, link);
+ *		link = link->next;
+ *		...
+ *	}
+ */
+
+typedef struct mpsc_link {
+	struct mpsc_link *next;
+} mpsc_link_t;
+
+typedef struct {
+	mpsc_link_t *head;	/* newest element first */
+} mpsc_queue_t;
+
+#define MPSC_QUEUE_INITIALIZER { NULL }
+
+/* Return the element containing link */
+#define mpsc_entry(link, type, member) \
+	((type *) ((char *) (link) - offsetof(type, member)))
+
+/*
+ * Add an element to the queue
+ * RET true if the queue was empty, so that the consumer may need a wakeup
+ */
+static inline bool mpsc_queue_push(mpsc_queue_t *queue, mpsc_link_t *link)
+{
+	mpsc_link_t *head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+
+	do {
+		link->next = head;
+	} while (!__atomic_compare_exchange_n(&queue->head, &head, link, true,
+					      __ATOMIC_RELEASE,
+					      __ATOMIC_RELAXED));
+
+	return (head == NULL);
+}
+
+/*
+ * Remove all elements from the queue
+ * RET the oldest element, linked to the newer ones through next, or NULL
+ */
+static inline mpsc_link_t *mpsc_queue_take(mpsc_queue_t *queue)
+{
+	mpsc_link_t *link, *next, *prev = NULL;
+
+	link = __atomic_exchange_n(&queue->head, NULL, __ATOMIC_ACQUIRE);
+
+	/* Pushed newest first, reverse to consume in order */
+	while (link) {
+		next = link->next;
+		link->next = prev;
+		prev = link;
+		link = next;
+	}
+
+	return prev;
+}
+
+static inline bool mpsc_queue_is_empty(mpsc_queue_t *queue)
+{
+	return (__atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) == NULL);
+}
+
+#endif
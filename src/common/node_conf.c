@@ -633,6 +633,21 @@ extern config_record_t *create_config_record(void)
  * NOTE: allocates memory at node_record_table_ptr that must be xfreed when
  *	the global node table is no longer required
  */
+/*
+ * Bytes allocated for a node table of node_cnt records. Doubling the table as
+ * it grows keeps the count of xrealloc() and rehash_node() calls logarithmic
+ * in the count of nodes. It depends only on the count, as callers swap tables.
+ */
+static int _node_table_size(int node_cnt)
+{
+	int size = 64;
+
+	while (size < node_cnt)
+		size *= 2;
+
+	return size * sizeof(node_record_t);
+}
+
 extern node_record_t *create_node_record(config_record_t *config_ptr,
 					 char *node_name)
 {
@@ -643,14 +658,8 @@ extern node_record_t *create_node_record(config_record_t *config_ptr,
 	xassert(config_ptr);
 	xassert(node_name);
 
-	/* round up the buffer size to reduce overhead of xrealloc */
-	old_buffer_size = (node_record_count) * sizeof(node_record_t);
-	old_buffer_size =
-		((int) ((old_buffer_size / BUF_SIZE) + 1)) * BUF_SIZE;
-	new_buffer_size =
-		(node_record_count + 1) * sizeof(node_record_t);
-	new_buffer_size =
-		((int) ((new_buffer_size / BUF_SIZE) + 1)) * BUF_SIZE;
+	old_buffer_size = _node_table_size(node_record_count);
+	new_buffer_size = _node_table_size(node_record_count + 1);
 	if (!node_record_table_ptr) {
 		node_record_table_ptr = xmalloc(new_buffer_size);
 	} else if (old_buffer_size != new_buffer_size) {
@@ -833,6 +842,32 @@ extern void node_fini2 (void)
 }
 
 
+typedef struct {
+	bool best_effort;
+	bitstr_t *bitmap;
+	const char *caller;
+	int rc;
+} node_bit_args_t;
+
+/* hostlist_for_each_host() callback, set the bit of the named node */
+static int _set_node_bit(char *name, void *arg)
+{
+	node_bit_args_t *args = arg;
+	node_record_t *node_ptr;
+
+	if ((node_ptr = _find_node_record(name, args->best_effort, true))) {
+		bit_set(args->bitmap,
+			(bitoff_t) (node_ptr - node_record_table_ptr));
+	} else {
+		error("%s: invalid node specified: \"%s\"", args->caller,
+		      name);
+		if (!args->best_effort)
+			args->rc = EINVAL;
+	}
+
+	return 0;
+}
+
 /*
  * node_name2bitmap - given a node name regular expression, build a bitmap
  *	representation
@@ -846,9 +881,9 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 			     bitstr_t **bitmap)
 {
 	int rc = SLURM_SUCCESS;
-	char *this_node_name;
 	bitstr_t *my_bitmap;
 	hostlist_t host_list;
+	node_bit_args_t args;
 
 	my_bitmap = (bitstr_t *) bit_alloc (node_record_count);
 	*bitmap = my_bitmap;
@@ -866,23 +901,14 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 		return rc;
 	}
 
-	while ( (this_node_name = hostlist_shift (host_list)) ) {
-		node_record_t *node_ptr;
-		node_ptr = _find_node_record(this_node_name, best_effort, true);
-		if (node_ptr) {
-			bit_set (my_bitmap, (bitoff_t) (node_ptr -
-							node_record_table_ptr));
-		} else {
-			error("%s: invalid node specified: \"%s\"", __func__,
-			      this_node_name);
-			if (!best_effort)
-				rc = EINVAL;
-		}
-		free (this_node_name);
-	}
+	args.best_effort = best_effort;
+	args.bitmap = my_bitmap;
+	args.caller = __func__;
+	args.rc = rc;
+	hostlist_for_each_host(host_list, _set_node_bit, &args);
 	hostlist_destroy (host_list);
 
-	return rc;
+	return args.rc;
 }
 
 /*
@@ -896,31 +922,19 @@ extern int hostlist2bitmap (hostlist_t hl, bool best_effort, bitstr_t **bitmap)
 {
 	int rc = SLURM_SUCCESS;
 	bitstr_t *my_bitmap;
-	char *name;
-	hostlist_iterator_t hi;
+	node_bit_args_t args;
 
 	FREE_NULL_BITMAP(*bitmap);
 	my_bitmap = (bitstr_t *) bit_alloc (node_record_count);
 	*bitmap = my_bitmap;
 
-	hi = hostlist_iterator_create(hl);
-	while ((name = hostlist_next(hi))) {
-		node_record_t *node_ptr;
-		node_ptr = _find_node_record(name, best_effort, true);
-		if (node_ptr) {
-			bit_set (my_bitmap, (bitoff_t) (node_ptr -
-							node_record_table_ptr));
-		} else {
-			error ("hostlist2bitmap: invalid node specified %s",
-			       name);
-			if (!best_effort)
-				rc = EINVAL;
-		}
-		free (name);
-	}
+	args.best_effort = best_effort;
+	args.bitmap = my_bitmap;
+	args.caller = __func__;
+	args.rc = rc;
+	hostlist_for_each_host(hl, _set_node_bit, &args);
 
-	hostlist_iterator_destroy(hi);
-	return rc;
+	return args.rc;
 
 }
 
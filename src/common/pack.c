@@ -59,14 +59,36 @@
 #include "src/common/log.h"
 #include "src/common/macros.h"
 #include "src/common/pack.h"
-#include "src/common/xmalloc.h"
 #include "src/common/xassert.h"
+#include "src/common/xhash.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
 #include "src/slurmdbd/read_config.h"
 
 #define MAX_ARRAY_LEN_SMALL	10000
 #define MAX_ARRAY_LEN_MEDIUM	1000000
 #define MAX_ARRAY_LEN_LARGE	100000000
 
+/* pack_bit_str_bin() formats */
+#define BIT_PACK_WORDS	0	/* 64 bit words */
+#define BIT_PACK_RUNS	1	/* runs of set bits as first bit and length */
+
+/* packstr_dict() markers, any other value is a dictionary index */
+#define STR_DICT_NEW	NO_VAL		/* new string follows */
+#define STR_DICT_NULL	INFINITE	/* NULL string */
+
+typedef struct {
+	char *str;
+	uint32_t index;
+} str_dict_entry_t;
+
+struct pack_str_dict {
+	uint32_t count;		/* strings in dictionary */
+	xhash_t *hash;		/* str_dict_entry_t by string, packing */
+	uint32_t size;		/* allocated elements of strs */
+	char **strs;		/* strings by index, unpacking */
+};
+
 /*
  * Define slurm-specific aliases for use by plugins, see slurm_xlator.h
  * for details.
@@ -109,6 +131,8 @@ strong_alias(packstr_array,	slurm_packstr_array);
 strong_alias(unpackstr_array,	slurm_unpackstr_array);
 strong_alias(packmem_array,	slurm_packmem_array);
 strong_alias(unpackmem_array,	slurm_unpackmem_array);
+strong_alias(pack_bit_str_bin,	slurm_pack_bit_str_bin);
+strong_alias(unpack_bit_str_bin,	slurm_unpack_bit_str_bin);
 
 /* Basic buffer management routines */
 /* create_buf - create a buffer with the supplied contents, contents must
@@ -162,6 +186,13 @@ buf_t *create_mmap_buf(char *file)
 		return NULL;
 	}
 
+	/*
+	 * Buffers are unpacked front to back, let the kernel read ahead of
+	 * the unpack rather than fault in each page as it is touched.
+	 */
+	(void) madvise(data, f_stat.st_size, MADV_SEQUENTIAL);
+	(void) madvise(data, f_stat.st_size, MADV_WILLNEED);
+
 	my_buf = xmalloc_nz(sizeof(*my_buf));
 	my_buf->magic = BUF_MAGIC;
 	my_buf->size = f_stat.st_size;
@@ -204,6 +235,31 @@ void grow_buf(buf_t *buffer, uint32_t size)
 	xrealloc_nz(buffer->head, buffer->size);
 }
 
+/*
+ * Grow a buffer to hold at least "need" more bytes while packing. The buffer
+ * grows by half its size at a time, so packing a large message costs a
+ * logarithmic rather than linear number of realloc() calls and copies.
+ * RET SLURM_SUCCESS or SLURM_ERROR if the buffer would exceed MAX_BUF_SIZE
+ */
+static int _grow_buf(buf_t *buffer, uint32_t need, const char *caller)
+{
+	uint64_t new_size, min_size;
+
+	min_size = (uint64_t) buffer->size + need + BUF_SIZE;
+	if (min_size > MAX_BUF_SIZE) {
+		error("%s: Buffer size limit exceeded (%"PRIu64" > %u)",
+		      caller, min_size, MAX_BUF_SIZE);
+		return SLURM_ERROR;
+	}
+
+	new_size = MAX(min_size, (uint64_t) buffer->size + (buffer->size / 2));
+	new_size = MIN(new_size, MAX_BUF_SIZE);
+	buffer->size = new_size;
+	xrealloc_nz(buffer->head, buffer->size);
+
+	return SLURM_SUCCESS;
+}
+
 /* init_buf - create an empty buffer of the given size */
 buf_t *init_buf(uint32_t size)
 {
@@ -249,16 +305,9 @@ void pack_time(time_t val, buf_t *buffer)
 {
 	int64_t n64 = HTON_int64((int64_t) val);
 
-	if (remaining_buf(buffer) < sizeof(n64)) {
-		if ((buffer->size + BUF_SIZE) > MAX_BUF_SIZE) {
-			error("%s: Buffer size limit exceeded (%u > %u)",
-			      __func__, (buffer->size + BUF_SIZE),
-			      MAX_BUF_SIZE);
-			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc_nz(buffer->head, buffer->size);
-	}
+	if ((remaining_buf(buffer) < sizeof(n64)) &&
+	    _grow_buf(buffer, sizeof(n64), __func__))
+		return;
 
 	memcpy(&buffer->head[buffer->processed], &n64, sizeof(n64));
 	buffer->processed += sizeof(n64);
@@ -298,16 +347,9 @@ void packdouble(double val, buf_t *buffer)
 	 */
 	uval.d =  (val * FLOAT_MULT);
 	nl =  HTON_uint64(uval.u);
-	if (remaining_buf(buffer) < sizeof(nl)) {
-		if ((buffer->size + BUF_SIZE) > MAX_BUF_SIZE) {
-			error("%s: Buffer size limit exceeded (%u > %u)",
-			      __func__, (buffer->size + BUF_SIZE),
-			      MAX_BUF_SIZE);
-			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc_nz(buffer->head, buffer->size);
-	}
+	if ((remaining_buf(buffer) < sizeof(nl)) &&
+	    _grow_buf(buffer, sizeof(nl), __func__))
+		return;
 
 	memcpy(&buffer->head[buffer->processed], &nl, sizeof(nl));
 	buffer->processed += sizeof(nl);
@@ -434,16 +476,9 @@ void pack64(uint64_t val, buf_t *buffer)
 {
 	uint64_t nl =  HTON_uint64(val);
 
-	if (remaining_buf(buffer) < sizeof(nl)) {
-		if ((buffer->size + BUF_SIZE) > MAX_BUF_SIZE) {
-			error("%s: Buffer size limit exceeded (%u > %u)",
-			      __func__, (buffer->size + BUF_SIZE),
-			      MAX_BUF_SIZE);
-			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc_nz(buffer->head, buffer->size);
-	}
+	if ((remaining_buf(buffer) < sizeof(nl)) &&
+	    _grow_buf(buffer, sizeof(nl), __func__))
+		return;
 
 	memcpy(&buffer->head[buffer->processed], &nl, sizeof(nl));
 	buffer->processed += sizeof(nl);
@@ -473,16 +508,9 @@ void pack32(uint32_t val, buf_t *buffer)
 {
 	uint32_t nl = htonl(val);
 
-	if (remaining_buf(buffer) < sizeof(nl)) {
-		if ((buffer->size + BUF_SIZE) > MAX_BUF_SIZE) {
-			error("%s: Buffer size limit exceeded (%u > %u)",
-			      __func__, (buffer->size + BUF_SIZE),
-			      MAX_BUF_SIZE);
-			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc_nz(buffer->head, buffer->size);
-	}
+	if ((remaining_buf(buffer) < sizeof(nl)) &&
+	    _grow_buf(buffer, sizeof(nl), __func__))
+		return;
 
 	memcpy(&buffer->head[buffer->processed], &nl, sizeof(nl));
 	buffer->processed += sizeof(nl);
@@ -682,16 +710,9 @@ void pack16(uint16_t val, buf_t *buffer)
 {
 	uint16_t ns = htons(val);
 
-	if (remaining_buf(buffer) < sizeof(ns)) {
-		if ((buffer->size + BUF_SIZE) > MAX_BUF_SIZE) {
-			error("%s: Buffer size limit exceeded (%u > %u)",
-			      __func__, (buffer->size + BUF_SIZE),
-			      MAX_BUF_SIZE);
-			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc_nz(buffer->head, buffer->size);
-	}
+	if ((remaining_buf(buffer) < sizeof(ns)) &&
+	    _grow_buf(buffer, sizeof(ns), __func__))
+		return;
 
 	memcpy(&buffer->head[buffer->processed], &ns, sizeof(ns));
 	buffer->processed += sizeof(ns);
@@ -720,16 +741,9 @@ int unpack16(uint16_t *valp, buf_t *buffer)
  */
 void pack8(uint8_t val, buf_t *buffer)
 {
-	if (remaining_buf(buffer) < sizeof(uint8_t)) {
-		if ((buffer->size + BUF_SIZE) > MAX_BUF_SIZE) {
-			error("%s: Buffer size limit exceeded (%u > %u)",
-			      __func__, (buffer->size + BUF_SIZE),
-			      MAX_BUF_SIZE);
-			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc_nz(buffer->head, buffer->size);
-	}
+	if ((remaining_buf(buffer) < sizeof(uint8_t)) &&
+	    _grow_buf(buffer, sizeof(uint8_t), __func__))
+		return;
 
 	memcpy(&buffer->head[buffer->processed], &val, sizeof(uint8_t));
 	buffer->processed += sizeof(uint8_t);
@@ -792,16 +806,9 @@ extern void packmem(void *valp, uint32_t size_val, buf_t *buffer)
 		      __func__, size_val, MAX_PACK_MEM_LEN);
 		return;
 	}
-	if (remaining_buf(buffer) < (sizeof(ns) + size_val)) {
-		if ((buffer->size + size_val + BUF_SIZE) > MAX_BUF_SIZE) {
-			error("%s: Buffer size limit exceeded (%u > %u)",
-			      __func__, (buffer->size + size_val + BUF_SIZE),
-			      MAX_BUF_SIZE);
-			return;
-		}
-		buffer->size += (size_val + BUF_SIZE);
-		xrealloc_nz(buffer->head, buffer->size);
-	}
+	if ((remaining_buf(buffer) < (sizeof(ns) + size_val)) &&
+	    _grow_buf(buffer, (sizeof(ns) + size_val), __func__))
+		return;
 
 	memcpy(&buffer->head[buffer->processed], &ns, sizeof(ns));
 	buffer->processed += sizeof(ns);
@@ -1007,16 +1014,9 @@ void packstr_array(char **valp, uint32_t size_val, buf_t *buffer)
 	int i;
 	uint32_t ns = htonl(size_val);
 
-	if (remaining_buf(buffer) < sizeof(ns)) {
-		if ((buffer->size + BUF_SIZE) > MAX_BUF_SIZE) {
-			error("%s: Buffer size limit exceeded (%u > %u)",
-			      __func__, (buffer->size + BUF_SIZE),
-			      MAX_BUF_SIZE);
-			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc_nz(buffer->head, buffer->size);
-	}
+	if ((remaining_buf(buffer) < sizeof(ns)) &&
+	    _grow_buf(buffer, sizeof(ns), __func__))
+		return;
 
 	memcpy(&buffer->head[buffer->processed], &ns, sizeof(ns));
 	buffer->processed += sizeof(ns);
@@ -1074,16 +1074,9 @@ int unpackstr_array(char ***valp, uint32_t *size_valp, buf_t *buffer)
  */
 void packmem_array(char *valp, uint32_t size_val, buf_t *buffer)
 {
-	if (remaining_buf(buffer) < size_val) {
-		if ((buffer->size + size_val + BUF_SIZE) > MAX_BUF_SIZE) {
-			error("%s: Buffer size limit exceeded (%u > %u)",
-			      __func__, (buffer->size + size_val + BUF_SIZE),
-			      MAX_BUF_SIZE);
-			return;
-		}
-		buffer->size += (size_val + BUF_SIZE);
-		xrealloc_nz(buffer->head, buffer->size);
-	}
+	if ((remaining_buf(buffer) < size_val) &&
+	    _grow_buf(buffer, size_val, __func__))
+		return;
 
 	memcpy(&buffer->head[buffer->processed], valp, size_val);
 	buffer->processed += size_val;
@@ -1104,3 +1097,227 @@ int unpackmem_array(char *valp, uint32_t size_valp, buf_t *buffer)
 		return SLURM_ERROR;
 	}
 }
+
+static void _str_dict_entry_id(void *item, const char **key,
+			       uint32_t *key_len)
+{
+	str_dict_entry_t *entry = item;
+
+	*key = entry->str;
+	*key_len = strlen(entry->str);
+}
+
+static void _str_dict_entry_free(void *item)
+{
+	str_dict_entry_t *entry = item;
+
+	xfree(entry->str);
+	xfree(entry);
+}
+
+extern pack_str_dict_t *pack_str_dict_create(void)
+{
+	return xmalloc(sizeof(pack_str_dict_t));
+}
+
+extern void pack_str_dict_destroy(pack_str_dict_t *dict)
+{
+	if (!dict)
+		return;
+
+	xhash_free(dict->hash);
+	for (uint32_t i = 0; i < dict->count && dict->strs; i++)
+		xfree(dict->strs[i]);
+	xfree(dict->strs);
+	xfree(dict);
+}
+
+/*
+ * Pack a string as a reference to an identical string already packed with
+ * this dictionary, or in full (and add it to the dictionary) otherwise.
+ */
+extern void packstr_dict(const char *str, pack_str_dict_t *dict,
+			 buf_t *buffer)
+{
+	str_dict_entry_t *entry;
+
+	if (!str) {
+		pack32(STR_DICT_NULL, buffer);
+		return;
+	}
+
+	if (!dict->hash)
+		dict->hash = xhash_init(_str_dict_entry_id,
+					_str_dict_entry_free);
+
+	if ((entry = xhash_get_str(dict->hash, str))) {
+		pack32(entry->index, buffer);
+		return;
+	}
+
+	pack32(STR_DICT_NEW, buffer);
+	packstr((char *) str, buffer);
+
+	entry = xmalloc(sizeof(*entry));
+	entry->str = xstrdup(str);
+	entry->index = dict->count++;
+	xhash_add(dict->hash, entry);
+}
+
+/*
+ * Unpack a string packed by packstr_dict() into newly xmalloc()ed memory
+ * at *valp. The dictionary must have been used for every string packed
+ * before this one.
+ */
+extern int unpackstr_dict(char **valp, pack_str_dict_t *dict, buf_t *buffer)
+{
+	uint32_t index, size_val;
+
+	*valp = NULL;
+
+	if (unpack32(&index, buffer))
+		return SLURM_ERROR;
+
+	if (index == STR_DICT_NULL)
+		return SLURM_SUCCESS;
+
+	if (index != STR_DICT_NEW) {
+		if (index >= dict->count)
+			return SLURM_ERROR;
+		*valp = xstrdup(dict->strs[index]);
+		return SLURM_SUCCESS;
+	}
+
+	if (unpackstr_xmalloc_chooser(valp, &size_val, buffer) || !*valp)
+		return SLURM_ERROR;
+
+	if (dict->count >= dict->size) {
+		dict->size = MAX(dict->size * 2, 64);
+		xrecalloc(dict->strs, dict->size, sizeof(char *));
+	}
+	dict->strs[dict->count++] = xstrdup(*valp);
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Walk the runs of set bits in b, packing each as its first bit and length
+ * if buffer is set. RET number of runs
+ */
+static uint32_t _bit_runs(bitstr_t *b, int32_t words, buf_t *buffer)
+{
+	uint64_t w, starts, ends, prev = 0, mask;
+	uint32_t run_cnt = 0, start = 0, pos;
+	int32_t i;
+
+	for (i = 0; i < words; i++) {
+		w = bit_get_word64(b, i);
+		starts = w & ~((w << 1) | prev);
+		ends = ~w & ((w << 1) | prev);
+		prev = w >> 63;
+		run_cnt += __builtin_popcountll(starts);
+		if (!buffer)
+			continue;
+		while (starts | ends) {
+			mask = (starts | ends) & -(starts | ends);
+			pos = (i * 64) + __builtin_ctzll(mask);
+			if (starts & mask) {
+				start = pos;
+			} else {
+				pack32(start, buffer);
+				pack32(pos - start, buffer);
+			}
+			starts &= ~mask;
+			ends &= ~mask;
+		}
+	}
+	if (prev && buffer) {
+		pos = bit_size(b);
+		pack32(start, buffer);
+		pack32(pos - start, buffer);
+	}
+
+	return run_cnt;
+}
+
+/*
+ * Pack a bitmap in binary, as runs of set bits if that is smaller (sparse or
+ * dense bitmaps like node bitmaps) or as 64 bit words otherwise. Half the
+ * size of pack_bit_str_hex() at most and no string formatting.
+ */
+extern void pack_bit_str_bin(bitstr_t *b, buf_t *buffer)
+{
+	uint32_t nbits, run_cnt;
+	int32_t i, words;
+
+	if (!b) {
+		pack32(NO_VAL, buffer);
+		return;
+	}
+
+	nbits = bit_size(b);
+	pack32(nbits, buffer);
+	if (!nbits)
+		return;
+
+	words = (nbits + 63) / 64;
+	run_cnt = _bit_runs(b, words, NULL);
+	if ((sizeof(uint32_t) + (run_cnt * 2 * sizeof(uint32_t))) <
+	    (words * sizeof(uint64_t))) {
+		pack8(BIT_PACK_RUNS, buffer);
+		pack32(run_cnt, buffer);
+		(void) _bit_runs(b, words, buffer);
+	} else {
+		pack8(BIT_PACK_WORDS, buffer);
+		for (i = 0; i < words; i++)
+			pack64(bit_get_word64(b, i), buffer);
+	}
+}
+
+extern int unpack_bit_str_bin(bitstr_t **b, buf_t *buffer)
+{
+	uint32_t nbits, run_cnt, start, len, i;
+	uint64_t w;
+	uint8_t format;
+	int32_t words;
+
+	*b = NULL;
+
+	if (unpack32(&nbits, buffer))
+		return SLURM_ERROR;
+	if ((nbits == NO_VAL) || !nbits)
+		return SLURM_SUCCESS;
+	if ((nbits > 0x40000000) || unpack8(&format, buffer))
+		return SLURM_ERROR;
+
+	*b = bit_alloc(nbits);
+	words = (nbits + 63) / 64;
+	if (format == BIT_PACK_RUNS) {
+		if (unpack32(&run_cnt, buffer) || (run_cnt > ((nbits + 1) / 2)))
+			goto unpack_error;
+		for (i = 0; i < run_cnt; i++) {
+			if (unpack32(&start, buffer) ||
+			    unpack32(&len, buffer) || !len ||
+			    (start >= nbits) || (len > (nbits - start)))
+				goto unpack_error;
+			bit_nset(*b, start, start + len - 1);
+		}
+	} else if (format == BIT_PACK_WORDS) {
+		for (i = 0; i < words; i++) {
+			if (unpack64(&w, buffer))
+				goto unpack_error;
+			/* No bits past the end */
+			if ((i == (words - 1)) && (nbits % 64) &&
+			    (w >> (nbits % 64)))
+				goto unpack_error;
+			bit_set_word64(*b, i, w);
+		}
+	} else
+		goto unpack_error;
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	FREE_NULL_BITMAP(*b);
+	return SLURM_ERROR;
+}
@@ -47,6 +47,7 @@
 #include <string.h>
 
 #include "src/common/bitstring.h"
+#include "src/common/slurm_protocol_common.h"
 #include "src/common/xassert.h"
 
 #define BUF_MAGIC 0x42554545
@@ -141,6 +142,23 @@ extern int unpackstr_array(char ***valp, uint32_t* size_val, buf_t *buffer);
 extern void packmem_array(char *valp, uint32_t size_val, buf_t *buffer);
 extern int unpackmem_array(char *valp, uint32_t size_valp, buf_t *buffer);
 
+extern void pack_bit_str_bin(bitstr_t *b, buf_t *buffer);
+extern int unpack_bit_str_bin(bitstr_t **b, buf_t *buffer);
+
+/*
+ * String dictionary for messages repeating the same strings in many records
+ * (e.g. node features, GRES and OS). The first occurrence of a string is
+ * packed in full and later occurrences as its index. The same dictionary
+ * must be used for every string of a message, in packing order.
+ */
+typedef struct pack_str_dict pack_str_dict_t;
+
+extern pack_str_dict_t *pack_str_dict_create(void);
+extern void pack_str_dict_destroy(pack_str_dict_t *dict);
+extern void packstr_dict(const char *str, pack_str_dict_t *dict,
+			 buf_t *buffer);
+extern int unpackstr_dict(char **valp, pack_str_dict_t *dict, buf_t *buffer);
+
 #define safe_unpack_time(valp,buf) do {			\
 	xassert(sizeof(*valp) == sizeof(time_t));	\
 	xassert(buf->magic == BUF_MAGIC);		\
@@ -291,6 +309,10 @@ extern int unpackmem_array(char *valp, uint32_t size_valp, buf_t *buffer);
 		pack32(NO_VAL, buf);                 	\
 } while (0)
 
+/*
+ * The hex string is only parsed, so it is read in place from the buffer
+ * rather than copied into a new allocation.
+ */
 #define unpack_bit_str_hex(bitmap,buf) do {				\
 	char *tmp_str = NULL;						\
 	uint32_t _size, _tmp_uint32;					\
@@ -298,17 +320,17 @@ extern int unpackmem_array(char *valp, uint32_t size_valp, buf_t *buffer);
 	xassert(buf->magic == BUF_MAGIC);				\
 	safe_unpack32(&_size, buf);					\
 	if (_size != NO_VAL) {						\
-		safe_unpackstr_xmalloc(&tmp_str, &_tmp_uint32, buf);	\
+		if (unpackmem_ptr(&tmp_str, &_tmp_uint32, buf) ||	\
+		    (tmp_str && tmp_str[_tmp_uint32 - 1]))		\
+			goto unpack_error;				\
 		if (_size) {						\
 			*bitmap = bit_alloc(_size);			\
 			if (bit_unfmt_hexmask(*bitmap, tmp_str)) {	\
 				FREE_NULL_BITMAP(*bitmap);		\
-				xfree(tmp_str);				\
 				goto unpack_error;			\
 			}						\
 		} else							\
 			*bitmap = NULL;					\
-		xfree(tmp_str);						\
 	} else								\
 		*bitmap = NULL;						\
 } while (0)
@@ -322,6 +344,33 @@ extern int unpackmem_array(char *valp, uint32_t size_valp, buf_t *buffer);
 	FREE_NULL_BITMAP(b);				\
 } while (0)
 
+/*
+ * Bitmaps are packed in binary with pack_bit_str_bin() from 21.08 on and as
+ * hex strings before.
+ */
+#define pack_bit_str(bitmap, buf, protocol_version) do {		\
+	if ((protocol_version) >= SLURM_21_08_PROTOCOL_VERSION)		\
+		pack_bit_str_bin(bitmap, buf);				\
+	else								\
+		pack_bit_str_hex(bitmap, buf);				\
+} while (0)
+
+#define unpack_bit_str(bitmap, buf, protocol_version) do {		\
+	xassert(*(bitmap) == NULL);					\
+	if ((protocol_version) >= SLURM_21_08_PROTOCOL_VERSION) {	\
+		if (unpack_bit_str_bin(bitmap, buf))			\
+			goto unpack_error;				\
+	} else								\
+		unpack_bit_str_hex(bitmap, buf);			\
+} while (0)
+
+#define unpack_bit_str_as_inx(inx, buf, protocol_version) do {	\
+	bitstr_t *b = NULL;						\
+	unpack_bit_str(&b, buf, protocol_version);			\
+	*inx = bitstr2inx(b);						\
+	FREE_NULL_BITMAP(b);						\
+} while (0)
+
 #define unpackstr_malloc	                        \
         unpackmem_malloc
 
@@ -345,6 +394,12 @@ extern int unpackmem_array(char *valp, uint32_t size_valp, buf_t *buffer);
 		goto unpack_error;		       		\
 } while (0)
 
+#define safe_unpackstr_dict(valp, dict, buf) do {		\
+	xassert(buf->magic == BUF_MAGIC);			\
+	if (unpackstr_dict(valp, dict, buf))			\
+		goto unpack_error;				\
+} while (0)
+
 #define safe_unpackstr_array(valp,size_valp,buf) do {	\
 	xassert(sizeof(*size_valp) == sizeof(uint32_t)); \
 	xassert(buf->magic == BUF_MAGIC);		\
@@ -40,7 +40,6 @@
 \*****************************************************************************/
 
 #include <ctype.h>
-#include <regex.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -86,13 +85,6 @@ strong_alias(transfer_s_p_options,	slurm_transfer_s_p_options);
 
 #define CONF_HASH_LEN 173
 
-static char *keyvalue_pattern =
-	"^[[:space:]]*"
-	"([[:alnum:]_.]+)" /* key */
-	"[[:space:]]*([-*+/]?)=[[:space:]]*"
-	"((\"([^\"]*)\")|([^[:space:]]+))" /* value: quoted with whitespace,
-					    * or unquoted and no whitespace */
-	"([[:space:]]|$)";
 
 struct s_p_values {
 	char *key;
@@ -108,7 +100,6 @@ struct s_p_values {
 };
 
 struct s_p_hashtbl {
-	regex_t keyvalue_re;
 	s_p_values_t *hash[CONF_HASH_LEN];
 };
 
@@ -196,9 +187,6 @@ s_p_hashtbl_t *s_p_hashtbl_create(const s_p_options_t options[])
 		_conf_hashtbl_insert(tbl, value);
 	}
 
-	if (regcomp(&tbl->keyvalue_re, keyvalue_pattern, REG_EXTENDED))
-		fatal("keyvalue regex compilation failed");
-
 	return tbl;
 }
 
@@ -277,13 +265,20 @@ void s_p_hashtbl_destroy(s_p_hashtbl_t *tbl)
 		}
 	}
 
-	regfree(&tbl->keyvalue_re);
-
 	xfree(tbl);
 }
 
 /*
- * IN tbl - table to work off
+ * Find the first key=value pair in a line, which must match the equivalent of
+ * this regular expression:
+ *
+ *	^[[:space:]]*([[:alnum:]_.]+)[[:space:]]*([-*+/]?)=[[:space:]]*
+ *	(("([^"]*)")|([^[:space:]]+))([[:space:]]|$)
+ *
+ * A value is either quoted and may contain whitespace, or unquoted and has no
+ * whitespace. A quoted value is only used if the closing quote is followed by
+ * whitespace or the end of the line, otherwise the whole word is the value.
+ *
  * IN line - string to be search for a key=value pair
  * OUT key - pointer to the key string (caller must free with xfree())
  * OUT value - pointer to the value string (caller must free with xfree())
@@ -291,49 +286,71 @@ void s_p_hashtbl_destroy(s_p_hashtbl_t *tbl)
  *                 of the unsearched portion of the string
  * Return 0 when a key-value pair is found, and -1 otherwise.
  */
-static int _keyvalue_regex(s_p_hashtbl_t *tbl, const char *line,
-			   char **key, char **value, char **remaining,
-			   slurm_parser_operator_t *operator)
+static int _keyvalue_tokenize(const char *line, char **key, char **value,
+			      char **remaining,
+			      slurm_parser_operator_t *operator)
 {
-	size_t nmatch = 8;
-	regmatch_t pmatch[8];
-	char op;
+	const char *key_start, *key_end, *val_start, *val_end, *ptr;
+	slurm_parser_operator_t op = S_P_OPERATOR_SET;
 
 	*key = NULL;
 	*value = NULL;
 	*remaining = (char *)line;
 	*operator = S_P_OPERATOR_SET;
-	memset(pmatch, 0, sizeof(regmatch_t)*nmatch);
 
-	if (regexec(&tbl->keyvalue_re, line, nmatch, pmatch, 0) == REG_NOMATCH)
+	ptr = line;
+	while (isspace((unsigned char) *ptr))
+		ptr++;
+	key_start = ptr;
+	while (isalnum((unsigned char) *ptr) || (*ptr == '_') || (*ptr == '.'))
+		ptr++;
+	if (ptr == key_start)
 		return -1;
-
-	*key = (char *)(xstrndup(line + pmatch[1].rm_so,
-				 pmatch[1].rm_eo - pmatch[1].rm_so));
-	if (pmatch[2].rm_so != -1 &&
-	    (pmatch[2].rm_so != pmatch[2].rm_eo)) {
-		op = *(line + pmatch[2].rm_so);
-		if (op == '+') {
-			*operator = S_P_OPERATOR_ADD;
-		} else if (op == '-') {
-			*operator = S_P_OPERATOR_SUB;
-		} else if (op == '*') {
-			*operator = S_P_OPERATOR_MUL;
-		} else if (op == '/') {
-			*operator = S_P_OPERATOR_DIV;
+	key_end = ptr;
+
+	while (isspace((unsigned char) *ptr))
+		ptr++;
+	if (*ptr == '+') {
+		op = S_P_OPERATOR_ADD;
+		ptr++;
+	} else if (*ptr == '-') {
+		op = S_P_OPERATOR_SUB;
+		ptr++;
+	} else if (*ptr == '*') {
+		op = S_P_OPERATOR_MUL;
+		ptr++;
+	} else if (*ptr == '/') {
+		op = S_P_OPERATOR_DIV;
+		ptr++;
+	}
+	if (*ptr != '=')
+		return -1;
+	ptr++;
+	while (isspace((unsigned char) *ptr))
+		ptr++;
+
+	val_start = NULL;
+	if (*ptr == '"') {
+		const char *quote = strchr(ptr + 1, '"');
+		if (quote && (!quote[1] || isspace((unsigned char) quote[1]))) {
+			val_start = ptr + 1;
+			val_end = quote;
+			ptr = quote + 1;
 		}
 	}
-	if (pmatch[5].rm_so != -1) {
-		*value = (char *)(xstrndup(line + pmatch[5].rm_so,
-					   pmatch[5].rm_eo - pmatch[5].rm_so));
-	} else if (pmatch[6].rm_so != -1) {
-		*value = (char *)(xstrndup(line + pmatch[6].rm_so,
-					   pmatch[6].rm_eo - pmatch[6].rm_so));
-	} else {
-		*value = xstrdup("");
+	if (!val_start) {
+		val_start = ptr;
+		while (*ptr && !isspace((unsigned char) *ptr))
+			ptr++;
+		if (ptr == val_start)
+			return -1;
+		val_end = ptr;
 	}
 
-	*remaining = (char *)(line + pmatch[3].rm_eo);
+	*key = xstrndup(key_start, key_end - key_start);
+	*value = xstrndup(val_start, val_end - val_start);
+	*operator = op;
+	*remaining = (char *)ptr;
 
 	return 0;
 }
@@ -503,13 +520,6 @@ s_p_hashtbl_t *_hashtbl_copy_keys(const s_p_hashtbl_t *from_tbl)
 		}
 	}
 
-	/*
-	 * We cannot copy a regex since a regfree() on either
-	 * the original or the copy can affect the other one.
-	 */
-	if (regcomp(&to_tbl->keyvalue_re, keyvalue_pattern, REG_EXTENDED))
-		fatal("keyvalue regex compilation failed");
-
 	return to_tbl;
 }
 
@@ -978,7 +988,7 @@ int s_p_parse_line(s_p_hashtbl_t *hashtbl, const char *line, char **leftover)
 	char *new_leftover;
 	slurm_parser_operator_t op;
 
-	while (_keyvalue_regex(hashtbl, ptr, &key, &value, &new_leftover, &op) == 0) {
+	while (_keyvalue_tokenize(ptr, &key, &value, &new_leftover, &op) == 0) {
 		if ((p = _conf_hashtbl_lookup(hashtbl, key))) {
 			p->operator = op;
 			if (_handle_keyvalue_match(p, value, new_leftover,
@@ -1015,7 +1025,7 @@ static int _parse_next_key(s_p_hashtbl_t *hashtbl,
 	char *new_leftover;
 	slurm_parser_operator_t op;
 
-	if (_keyvalue_regex(hashtbl, line, &key, &value, &new_leftover, &op) == 0) {
+	if (_keyvalue_tokenize(line, &key, &value, &new_leftover, &op) == 0) {
 		if ((p = _conf_hashtbl_lookup(hashtbl, key))) {
 			p->operator = op;
 			if (_handle_keyvalue_match(p, value, new_leftover,
@@ -1504,13 +1514,6 @@ static s_p_hashtbl_t *_parse_expline_adapt_table(const s_p_hashtbl_t *tbl)
 		}
 	}
 
-	/*
-	 * We cannot copy a regex since a regfree() on either
-	 * the original or the copy can affect the other one.
-	 */
-	if (regcomp(&to_tbl->keyvalue_re, keyvalue_pattern, REG_EXTENDED))
-		fatal("keyvalue regex compilation failed");
-
 	return to_tbl;
 }
 
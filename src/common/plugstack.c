@@ -47,6 +47,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "src/common/macros.h"
+#include "src/common/pack.h"
 #include "src/common/plugin.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
@@ -186,6 +188,8 @@ struct spank_stack {
 	List option_cache;           /*  Cache of plugin options in this ctx */
 	int  spank_optval;           /*  optvalue for next plugin option     */
 	const char * plugin_path;    /*  default path to search for plugins  */
+	buf_t *conf_buf;	     /*  if set, record resolved conf lines  */
+	bool conf_only;		     /*  only record, do not load plugins    */
 };
 
 /*
@@ -193,11 +197,19 @@ struct spank_stack {
  */
 static struct spank_stack *global_spank_stack = NULL;
 
+/*
+ *  plugstack.conf as resolved by slurmd, with includes expanded and plugin
+ *   paths found, sent to slurmstepd in place of reading it again.
+ */
+static buf_t *conf_cache = NULL;
+static pthread_mutex_t conf_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  *  Forward declarations
  */
 static int _spank_plugin_options_cache(struct spank_plugin *p);
 static int _spank_stack_load (struct spank_stack *stack, const char *file);
+static int _spank_stack_load_cache(struct spank_stack *stack, buf_t *buf);
 static void _spank_plugin_destroy (struct spank_plugin *);
 static void _spank_plugin_opt_destroy (struct spank_plugin_opt *);
 static int spank_stack_get_remote_options(struct spank_stack *, job_options_t);
@@ -210,12 +222,22 @@ static void spank_stack_destroy (struct spank_stack *stack)
 {
 	FREE_NULL_LIST (stack->plugin_list);
 	FREE_NULL_LIST (stack->option_cache);
+	FREE_NULL_BUFFER(stack->conf_buf);
 	xfree (stack->plugin_path);
 	xfree (stack);
 }
 
-static struct spank_stack *
-spank_stack_create (const char *file, enum spank_context_type type)
+/* Replace the cached plugstack.conf with the one recorded by stack */
+static void _conf_cache_set(struct spank_stack *stack)
+{
+	slurm_mutex_lock(&conf_cache_mutex);
+	FREE_NULL_BUFFER(conf_cache);
+	conf_cache = stack->conf_buf;
+	stack->conf_buf = NULL;
+	slurm_mutex_unlock(&conf_cache_mutex);
+}
+
+static struct spank_stack *_spank_stack_alloc(enum spank_context_type type)
 {
 	slurm_conf_t *conf;
 	struct spank_stack *stack = xmalloc (sizeof (*stack));
@@ -231,11 +253,35 @@ spank_stack_create (const char *file, enum spank_context_type type)
 	stack->option_cache =
 		list_create ((ListDelF) _spank_plugin_opt_destroy);
 
-	if (_spank_stack_load (stack, file) < 0) {
+	return (stack);
+}
+
+static struct spank_stack *
+spank_stack_create (const char *file, enum spank_context_type type)
+{
+	struct spank_stack *stack = _spank_stack_alloc(type);
+	int rc;
+
+	/*
+	 *  slurmstepd uses the plugin stack resolved by slurmd if it was
+	 *   sent one, and slurmd records the stack it loads to send it.
+	 */
+	if ((type == S_TYPE_REMOTE) && conf_cache) {
+		rc = _spank_stack_load_cache(stack, conf_cache);
+	} else {
+		if (type == S_TYPE_SLURMD)
+			stack->conf_buf = init_buf(BUF_SIZE);
+		rc = _spank_stack_load(stack, file);
+	}
+
+	if (rc < 0) {
 		spank_stack_destroy (stack);
 		return (NULL);
 	}
 
+	if (stack->conf_buf)
+		_conf_cache_set(stack);
+
 	return (stack);
 }
 
@@ -478,6 +524,61 @@ spank_stack_plugin_valid_for_context (struct spank_stack *stack,
 	return (0);
 }
 
+static void _argv_free(char **argv)
+{
+	if (!argv)
+		return;
+	for (int i = 0; argv[i]; i++)
+		xfree(argv[i]);
+	xfree(argv);
+}
+
+/*
+ *  Load the plugin at the resolved path into stack.
+ *  Takes ownership of path and argv.
+ */
+static int _spank_stack_add(struct spank_stack *stack, const char *file,
+			    int line, char *path, int ac, char **argv,
+			    bool required)
+{
+	struct spank_plugin *p;
+
+	if (!(p = _spank_plugin_create(stack, path, ac, argv, required))) {
+		if (required)
+			error ("spank: %s:%d:"
+			       " Failed to load plugin %s. Aborting.",
+			       file, line, path);
+		else
+			verbose ("spank: %s:%d:"
+				 "Failed to load optional plugin %s. Ignored.",
+				 file, line, path);
+		xfree(path);
+		_argv_free(argv);
+		return (required ? -1 : 0);
+	}
+
+	if (plugin_in_list (stack->plugin_list, p)) {
+		error ("spank: %s: cowardly refusing to load a second time",
+			p->fq_path);
+		_spank_plugin_destroy (p);
+		return (0);
+	}
+
+	if (!spank_stack_plugin_valid_for_context (stack, p)) {
+		debug2 ("spank: %s: no callbacks in this context", p->fq_path);
+		_spank_plugin_destroy (p);
+		return (0);
+	}
+
+	debug ("spank: %s:%d: Loaded plugin %s",
+			file, line, xbasename (p->fq_path));
+
+	list_append (stack->plugin_list, p);
+	_spank_plugin_options_cache(p);
+
+	return (0);
+}
+
 static int
 _spank_stack_process_line(struct spank_stack *stack,
 	const char *file, int line, char *buf)
@@ -488,8 +589,6 @@ _spank_stack_process_line(struct spank_stack *stack,
 	cf_line_t type = CF_REQUIRED;
 	bool required;
 
-	struct spank_plugin *p;
-
 	if (_plugin_stack_parse_line(buf, &path, &ac, &argv, &type) < 0) {
 		error("spank: %s:%d: Invalid line. Ignoring.", file, line);
 		return (0);
@@ -514,38 +613,60 @@ _spank_stack_process_line(struct spank_stack *stack,
 	}
 
 	required = (type == CF_REQUIRED);
-	if (!(p = _spank_plugin_create(stack, path, ac, argv, required))) {
-		if (required)
-			error ("spank: %s:%d:"
-			       " Failed to load plugin %s. Aborting.",
-			       file, line, path);
-		else
-			verbose ("spank: %s:%d:"
-				 "Failed to load optional plugin %s. Ignored.",
-				 file, line, path);
-		return (required ? -1 : 0);
-	}
 
-	if (plugin_in_list (stack->plugin_list, p)) {
-		error ("spank: %s: cowardly refusing to load a second time",
-			p->fq_path);
-		_spank_plugin_destroy (p);
-		return (0);
+	if (stack->conf_buf) {
+		packstr((char *) file, stack->conf_buf);
+		pack32(line, stack->conf_buf);
+		packbool(required, stack->conf_buf);
+		packstr(path, stack->conf_buf);
+		packstr_array(argv, ac, stack->conf_buf);
 	}
 
-	if (!spank_stack_plugin_valid_for_context (stack, p)) {
-		debug2 ("spank: %s: no callbacks in this context", p->fq_path);
-		_spank_plugin_destroy (p);
+	if (stack->conf_only) {
+		xfree(path);
+		_argv_free(argv);
 		return (0);
 	}
 
-	debug ("spank: %s:%d: Loaded plugin %s",
-			file, line, xbasename (p->fq_path));
+	return _spank_stack_add(stack, file, line, path, ac, argv, required);
+}
 
-	list_append (stack->plugin_list, p);
-	_spank_plugin_options_cache(p);
+/*
+ *  Load the plugins recorded in buf by a stack with conf_buf set, without
+ *   reading plugstack.conf and its includes or searching the plugin path.
+ */
+static int _spank_stack_load_cache(struct spank_stack *stack, buf_t *buf)
+{
+	char *file = NULL, *path = NULL, **argv = NULL;
+	uint32_t line, ac, uint32_tmp;
+	bool required;
+	int rc = 0;
 
-	return (0);
+	debug("spank: loading plugin stack sent by slurmd");
+
+	set_buf_offset(buf, 0);
+	while ((rc == 0) && remaining_buf(buf)) {
+		safe_unpackstr_xmalloc(&file, &uint32_tmp, buf);
+		safe_unpack32(&line, buf);
+		safe_unpackbool(&required, buf);
+		safe_unpackstr_xmalloc(&path, &uint32_tmp, buf);
+		safe_unpackstr_array(&argv, &ac, buf);
+
+		rc = _spank_stack_add(stack, file, line, path, ac, argv,
+				      required);
+		path = NULL;
+		argv = NULL;
+		xfree(file);
+	}
+
+	return (rc);
+
+unpack_error:
+	error("spank: invalid plugin stack sent by slurmd");
+	xfree(file);
+	xfree(path);
+	xfree(argv);	/* partially unpacked, entries are not terminated */
+	return (-1);
 }
 
 static int _spank_stack_load(struct spank_stack *stack, const char *path)
@@ -769,14 +890,21 @@ static int _do_call_stack(struct spank_stack *stack,
 	return (rc);
 }
 
-struct spank_stack *spank_stack_init(enum spank_context_type context)
+static char *_plugstack_path(void)
 {
 	char *path;
-	struct spank_stack *stack = NULL;
 
 	if (!(path = xstrdup(slurm_conf.plugstack)))
 		path = get_extra_conf_path("plugstack.conf");
 
+	return path;
+}
+
+struct spank_stack *spank_stack_init(enum spank_context_type context)
+{
+	char *path = _plugstack_path();
+	struct spank_stack *stack = NULL;
+
 	stack = spank_stack_create(path, context);
 	xfree(path);
 
@@ -855,6 +983,64 @@ int spank_slurmd_init (void)
 	return _spank_init (S_TYPE_SLURMD, NULL);
 }
 
+extern int spank_slurmd_reconfig(void)
+{
+	struct spank_stack *stack = _spank_stack_alloc(S_TYPE_SLURMD);
+	char *path = _plugstack_path();
+	int rc;
+
+	stack->conf_buf = init_buf(BUF_SIZE);
+	stack->conf_only = true;
+	if ((rc = _spank_stack_load(stack, path)) == 0)
+		_conf_cache_set(stack);
+	else
+		error("spank: keeping previous plugin stack for steps");
+
+	spank_stack_destroy(stack);
+	xfree(path);
+
+	return rc;
+}
+
+extern int spank_stack_write_conf(int fd)
+{
+	int len = -1;
+
+	slurm_mutex_lock(&conf_cache_mutex);
+	if (conf_cache)
+		len = get_buf_offset(conf_cache);
+	safe_write(fd, &len, sizeof(int));
+	if (len > 0)
+		safe_write(fd, get_buf_data(conf_cache), len);
+	slurm_mutex_unlock(&conf_cache_mutex);
+
+	return 0;
+
+rwfail:
+	slurm_mutex_unlock(&conf_cache_mutex);
+	return -1;
+}
+
+extern int spank_stack_read_conf(int fd)
+{
+	int len;
+
+	safe_read(fd, &len, sizeof(int));
+	if (len < 0)
+		return SLURM_SUCCESS;	/* slurmd has none, read the file */
+
+	FREE_NULL_BUFFER(conf_cache);
+	conf_cache = init_buf(len);
+	safe_read(fd, get_buf_data(conf_cache), len);
+	set_buf_offset(conf_cache, len);
+
+	return SLURM_SUCCESS;
+
+rwfail:
+	FREE_NULL_BUFFER(conf_cache);
+	return SLURM_ERROR;
+}
+
 int spank_init_post_opt (void)
 {
 	struct spank_stack *stack = global_spank_stack;
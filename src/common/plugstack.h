@@ -85,6 +85,19 @@ int spank_job_epilog(uint32_t jobid, uid_t uid, gid_t gid);
 
 int spank_slurmd_exit (void);
 
+/*
+ * Parse plugstack.conf again on reconfigure, to be sent to slurmstepd.
+ * Plugins loaded in slurmd itself are unchanged.
+ */
+extern int spank_slurmd_reconfig(void);
+
+/*
+ * Send the plugin stack resolved by slurmd to slurmstepd, with includes
+ * expanded and plugin paths found, so it is not read again for each step.
+ */
+extern int spank_stack_write_conf(int fd);
+extern int spank_stack_read_conf(int fd);
+
 int spank_fini (stepd_step_rec_t *job);
 
 /*
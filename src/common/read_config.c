@@ -5167,6 +5167,12 @@ extern char * prolog_flags2str(uint16_t prolog_flags)
 		xstrcat(rc, "NoHold");
 	}
 
+	if (prolog_flags & PROLOG_FLAG_PARALLEL) {
+		if (rc)
+			xstrcat(rc, ",");
+		xstrcat(rc, "ParallelScripts");
+	}
+
 	if (prolog_flags & PROLOG_FLAG_SERIAL) {
 		if (rc)
 			xstrcat(rc, ",");
@@ -5204,6 +5210,8 @@ extern uint16_t prolog_str2flags(char *prolog_flags)
 			rc |= (PROLOG_FLAG_ALLOC | PROLOG_FLAG_CONTAIN);
 		else if (xstrcasecmp(tok, "NoHold") == 0)
 			rc |= PROLOG_FLAG_NOHOLD;
+		else if (xstrcasecmp(tok, "ParallelScripts") == 0)
+			rc |= PROLOG_FLAG_PARALLEL;
 		else if (xstrcasecmp(tok, "Serial") == 0)
 			rc |= PROLOG_FLAG_SERIAL;
 		else if (xstrcasecmp(tok, "X11") == 0) {
@@ -5479,6 +5487,11 @@ extern char * debug_flags2str(uint64_t debug_flags)
 			xstrcat(rc, ",");
 		xstrcat(rc, "SelectType");
 	}
+	if (debug_flags & DEBUG_FLAG_STACK_SAMPLE) {
+		if (rc)
+			xstrcat(rc, ",");
+		xstrcat(rc, "StackSample");
+	}
 	if (debug_flags & DEBUG_FLAG_STEPS) {
 		if (rc)
 			xstrcat(rc, ",");
@@ -5509,6 +5522,11 @@ extern char * debug_flags2str(uint64_t debug_flags)
 			xstrcat(rc, ",");
 		xstrcat(rc, "TraceJobs");
 	}
+	if (debug_flags & DEBUG_FLAG_TRACE_SPANS) {
+		if (rc)
+			xstrcat(rc, ",");
+		xstrcat(rc, "TraceSpans");
+	}
 	if (debug_flags & DEBUG_FLAG_TRIGGERS) {
 		if (rc)
 			xstrcat(rc, ",");
@@ -5638,6 +5656,8 @@ extern int debug_str2flags(char *debug_flags, uint64_t *flags_out)
 			(*flags_out) |= DEBUG_FLAG_ROUTE;
 		else if (xstrcasecmp(tok, "SelectType") == 0)
 			(*flags_out) |= DEBUG_FLAG_SELECT_TYPE;
+		else if (xstrcasecmp(tok, "StackSample") == 0)
+			(*flags_out) |= DEBUG_FLAG_STACK_SAMPLE;
 		else if (xstrcasecmp(tok, "Steps") == 0)
 			(*flags_out) |= DEBUG_FLAG_STEPS;
 		else if (xstrcasecmp(tok, "Switch") == 0)
@@ -5646,6 +5666,8 @@ extern int debug_str2flags(char *debug_flags, uint64_t *flags_out)
 			(*flags_out) |= DEBUG_FLAG_TASK;
 		else if (xstrcasecmp(tok, "TraceJobs") == 0)
 			(*flags_out) |= DEBUG_FLAG_TRACE_JOBS;
+		else if (xstrcasecmp(tok, "TraceSpans") == 0)
+			(*flags_out) |= DEBUG_FLAG_TRACE_SPANS;
 		else if (xstrcasecmp(tok, "TRESNode") == 0)
 			(*flags_out) |= DEBUG_FLAG_TRES_NODE;
 		else if (xstrcasecmp(tok, "Trigger") == 0)
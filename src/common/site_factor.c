@@ -58,8 +58,17 @@ static const char *syms[] = {
 	"site_factor_p_update",
 };
 
+/*
+ * Optional batched update, called with the pending jobs after "update" so
+ * the plugin need not walk and filter the job list itself.
+ */
+typedef void (*update_pending_f) (job_record_t **jobs, uint32_t job_cnt);
+
 /* Local variables */
 static slurm_ops_t ops;
+static update_pending_f update_pending = NULL;
+static job_record_t **pending_jobs = NULL;
+static uint32_t pending_size = 0;
 static plugin_context_t *g_context = NULL;
 static pthread_mutex_t g_context_lock =	PTHREAD_MUTEX_INITIALIZER;
 static bool init_run = false;
@@ -93,6 +102,9 @@ extern int site_factor_plugin_init(void)
 		goto done;
 	}
 
+	update_pending = plugin_get_sym(g_context->cur_plugin,
+					"site_factor_p_update_pending");
+
 	init_run = true;
 	debug2("%s: plugin %s loaded", __func__, slurm_conf.site_factor_plugin);
 
@@ -113,6 +125,9 @@ extern int site_factor_plugin_fini(void)
 	init_run = false;
 	rc = plugin_context_destroy(g_context);
 	g_context = NULL;
+	update_pending = NULL;
+	xfree(pending_jobs);
+	pending_size = 0;
 	slurm_mutex_unlock(&g_context_lock);
 
 	return rc;
@@ -141,8 +156,26 @@ extern void site_factor_g_set(job_record_t *job_ptr)
 	END_TIMER3(__func__, SITE_FACTOR_TIMER);
 }
 
+static int _add_pending(void *x, void *arg)
+{
+	job_record_t *job_ptr = x;
+	uint32_t *job_cnt = arg;
+
+	if (!IS_JOB_PENDING(job_ptr))
+		return 0;
+
+	if (*job_cnt >= pending_size) {
+		pending_size = MAX(1024, pending_size * 2);
+		xrecalloc(pending_jobs, pending_size, sizeof(job_record_t *));
+	}
+	pending_jobs[(*job_cnt)++] = job_ptr;
+
+	return 0;
+}
+
 extern void site_factor_g_update(void)
 {
+	uint32_t job_cnt = 0;
 	DEF_TIMERS;
 
 	if (site_factor_plugin_init() < 0)
@@ -150,5 +183,11 @@ extern void site_factor_g_update(void)
 
 	START_TIMER;
 	(*(ops.update))();
+	if (update_pending && job_list) {
+		/* Array is kept between calls, job_list is write locked */
+		list_for_each(job_list, _add_pending, &job_cnt);
+		if (job_cnt)
+			(*update_pending)(pending_jobs, job_cnt);
+	}
 	END_TIMER3(__func__, SITE_FACTOR_TIMER);
 }
@@ -54,6 +54,9 @@ extern void site_factor_g_set(job_record_t *job_ptr);
 
 /*
  * Called to periodically update all site_factor values.
+ * Plugins exporting the optional site_factor_p_update_pending() are then
+ * handed all pending jobs as one array.
+ * NOTE: Call with the job write lock held.
  */
 extern void site_factor_g_update(void);
 
@@ -40,9 +40,13 @@
 #  include "config.h"
 #endif
 
+#include <fcntl.h>
 #include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #if HAVE_SYS_PRCTL_H
 #  include <sys/prctl.h>
@@ -97,6 +101,36 @@ static pthread_t watch_node_thread_id = 0;
 static acct_gather_profile_timer_t *profile_timer =
 	&acct_gather_profile_timer[PROFILE_ENERGY];
 
+/*
+ * The slurmd publishes the latest node readings of every plugin context in
+ * a file mapped by the slurmstepds, so steps do not each have to ask the
+ * slurmd (or read the hardware) for the same node counters.
+ */
+#define ENERGY_SHM_MAGIC 0xe4e7a11f
+#define ENERGY_SHM_RETRY 10
+#define PUBLISH_INTERVAL 1	/* seconds */
+
+typedef struct {
+	uint32_t magic;
+	uint32_t seq;		/* odd while the readings are being updated */
+	uint16_t sensor_cnt;
+	acct_gather_energy_t energy[];
+} energy_shm_t;
+
+typedef struct {
+	energy_shm_t *shm;
+	size_t size;
+	time_t poll_time;
+} energy_pub_t;
+
+static char *energy_spooldir = NULL;
+static energy_pub_t *energy_pub = NULL;
+static int energy_pub_cnt = 0;
+static bool publish_run = false;
+static pthread_t publish_thread_id = 0;
+static pthread_cond_t publish_cond = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t publish_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 static void *_watch_node(void *arg)
 {
 	int delta = profile_timer->freq - 1;
@@ -127,6 +161,203 @@ static void *_watch_node(void *arg)
 	return NULL;
 }
 
+static char *_energy_shm_path(int context_id)
+{
+	return xstrdup_printf("%s/acct_gather_energy.%d",
+			      energy_spooldir, context_id);
+}
+
+static energy_shm_t *_map_energy_shm(int context_id, size_t size)
+{
+	char *path = _energy_shm_path(context_id);
+	energy_shm_t *shm;
+	int fd;
+
+	if ((fd = open(path, O_CREAT | O_RDWR | O_CLOEXEC, 0644)) < 0) {
+		error("%s: open(%s): %m", __func__, path);
+		xfree(path);
+		return NULL;
+	}
+	if (ftruncate(fd, size) < 0) {
+		error("%s: ftruncate(%s): %m", __func__, path);
+		close(fd);
+		xfree(path);
+		return NULL;
+	}
+	shm = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shm == MAP_FAILED) {
+		error("%s: mmap(%s): %m", __func__, path);
+		xfree(path);
+		return NULL;
+	}
+	xfree(path);
+
+	return shm;
+}
+
+/* Copy the latest readings of one context into its mapped file */
+static void _publish_context(int context_id)
+{
+	energy_pub_t *pub = &energy_pub[context_id];
+	acct_gather_energy_t *energies;
+	uint16_t sensor_cnt = 0;
+	time_t last_poll = 0;
+	size_t size;
+
+	acct_gather_energy_g_get_data(context_id, ENERGY_DATA_LAST_POLL,
+				      &last_poll);
+	if (!last_poll || (last_poll == pub->poll_time))
+		return;
+	acct_gather_energy_g_get_data(context_id, ENERGY_DATA_SENSOR_CNT,
+				      &sensor_cnt);
+	if (!sensor_cnt)
+		return;
+
+	energies = acct_gather_energy_alloc(sensor_cnt);
+	acct_gather_energy_g_get_data(context_id, ENERGY_DATA_STRUCT,
+				      energies);
+
+	size = sizeof(energy_shm_t) +
+		(sizeof(acct_gather_energy_t) * sensor_cnt);
+	if (pub->size != size) {
+		if (pub->shm)
+			munmap(pub->shm, pub->size);
+		pub->size = 0;
+		if (!(pub->shm = _map_energy_shm(context_id, size))) {
+			acct_gather_energy_destroy(energies);
+			return;
+		}
+		pub->size = size;
+		pub->shm->seq = 0;
+	}
+
+	pub->shm->seq++;
+	__sync_synchronize();
+	pub->shm->magic = ENERGY_SHM_MAGIC;
+	pub->shm->sensor_cnt = sensor_cnt;
+	memcpy(pub->shm->energy, energies,
+	       sizeof(acct_gather_energy_t) * sensor_cnt);
+	__sync_synchronize();
+	pub->shm->seq++;
+
+	pub->poll_time = last_poll;
+	acct_gather_energy_destroy(energies);
+}
+
+static void *_publish_node_energy(void *arg)
+{
+	struct timespec ts = {0, 0};
+
+#if HAVE_SYS_PRCTL_H
+	if (prctl(PR_SET_NAME, "acctg_energy_pub", NULL, NULL, NULL) < 0) {
+		error("%s: cannot set my name to %s %m",
+		      __func__, "acctg_energy_pub");
+	}
+#endif
+
+	slurm_mutex_lock(&publish_mutex);
+	while (publish_run) {
+		slurm_mutex_unlock(&publish_mutex);
+		for (int i = 0; i < energy_pub_cnt; i++)
+			_publish_context(i);
+		slurm_mutex_lock(&publish_mutex);
+
+		ts.tv_sec = time(NULL) + PUBLISH_INTERVAL;
+		if (publish_run)
+			slurm_cond_timedwait(&publish_cond, &publish_mutex,
+					     &ts);
+	}
+	slurm_mutex_unlock(&publish_mutex);
+
+	return NULL;
+}
+
+static void _publish_fini(void)
+{
+	if (!publish_thread_id)
+		return;
+
+	slurm_mutex_lock(&publish_mutex);
+	publish_run = false;
+	slurm_cond_signal(&publish_cond);
+	slurm_mutex_unlock(&publish_mutex);
+	pthread_join(publish_thread_id, NULL);
+	publish_thread_id = 0;
+
+	for (int i = 0; i < energy_pub_cnt; i++) {
+		if (energy_pub[i].shm)
+			munmap(energy_pub[i].shm, energy_pub[i].size);
+	}
+	xfree(energy_pub);
+	energy_pub_cnt = 0;
+}
+
+/*
+ * Read the readings published by the slurmd for a context.
+ * RET SLURM_SUCCESS if all sensors were polled within delta seconds
+ */
+static int _read_energy_shm(uint16_t context_id, uint16_t delta,
+			    uint16_t *sensor_cnt,
+			    acct_gather_energy_t **energy)
+{
+	char *path = _energy_shm_path(context_id);
+	acct_gather_energy_t *energies = NULL;
+	energy_shm_t *shm;
+	struct stat st;
+	uint32_t seq;
+	uint16_t cnt = 0;
+	time_t now = time(NULL);
+	int fd, i, rc = SLURM_ERROR;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	xfree(path);
+	if (fd < 0)
+		return SLURM_ERROR;
+	if ((fstat(fd, &st) < 0) || (st.st_size < sizeof(energy_shm_t))) {
+		close(fd);
+		return SLURM_ERROR;
+	}
+	shm = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shm == MAP_FAILED)
+		return SLURM_ERROR;
+
+	for (int retry = 0; retry < ENERGY_SHM_RETRY; retry++) {
+		if ((seq = shm->seq) & 1)
+			continue;
+		__sync_synchronize();
+		cnt = shm->sensor_cnt;
+		if ((shm->magic != ENERGY_SHM_MAGIC) || !cnt ||
+		    ((sizeof(energy_shm_t) +
+		      (sizeof(acct_gather_energy_t) * cnt)) > st.st_size))
+			break;
+		xfree(energies);
+		energies = acct_gather_energy_alloc(cnt);
+		memcpy(energies, shm->energy,
+		       sizeof(acct_gather_energy_t) * cnt);
+		__sync_synchronize();
+		if (shm->seq == seq) {
+			rc = SLURM_SUCCESS;
+			break;
+		}
+	}
+	munmap(shm, st.st_size);
+
+	for (i = 0; (rc == SLURM_SUCCESS) && (i < cnt); i++) {
+		/* Same rule the slurmd applies to force a new poll */
+		if ((now - energies[i].poll_time) > delta)
+			rc = SLURM_ERROR;
+	}
+
+	if (rc == SLURM_SUCCESS) {
+		*sensor_cnt = cnt;
+		*energy = energies;
+	} else
+		xfree(energies);
+
+	return rc;
+}
 
 extern int slurm_acct_gather_energy_init(void)
 {
@@ -186,6 +417,8 @@ extern int acct_gather_energy_fini(void)
 {
 	int rc2, rc = SLURM_SUCCESS;
 
+	_publish_fini();
+
 	slurm_mutex_lock(&g_context_lock);
 	init_run = false;
 
@@ -422,6 +655,46 @@ extern int acct_gather_energy_startpoll(uint32_t frequency)
 	return retval;
 }
 
+extern void acct_gather_energy_set_spooldir(const char *dir)
+{
+	xfree(energy_spooldir);
+	energy_spooldir = xstrdup(dir);
+}
+
+extern int acct_gather_energy_start_publish(void)
+{
+	if (!energy_spooldir || publish_thread_id)
+		return SLURM_SUCCESS;
+
+	if (!slurm_conf.acct_gather_energy_type ||
+	    xstrcasestr(slurm_conf.acct_gather_energy_type, "none"))
+		return SLURM_SUCCESS;
+
+	if (slurm_acct_gather_energy_init() < 0)
+		return SLURM_ERROR;
+
+	energy_pub_cnt = g_context_num;
+	energy_pub = xcalloc(energy_pub_cnt, sizeof(energy_pub_t));
+	publish_run = true;
+	slurm_thread_create(&publish_thread_id, _publish_node_energy, NULL);
+
+	return SLURM_SUCCESS;
+}
+
+extern int acct_gather_energy_get_node_energy(uint16_t context_id,
+					      uint16_t delta,
+					      uint16_t *sensor_cnt,
+					      acct_gather_energy_t **energy)
+{
+	if (energy_spooldir &&
+	    (_read_energy_shm(context_id, delta, sensor_cnt, energy) ==
+	     SLURM_SUCCESS))
+		return SLURM_SUCCESS;
+
+	return slurm_get_node_energy(NULL, context_id, delta, sensor_cnt,
+				     energy);
+}
+
 extern int acct_gather_energy_g_conf_options(s_p_options_t **full_options,
 					      int *full_options_cnt)
 {
@@ -73,6 +73,31 @@ extern int acct_gather_energy_g_get_data(int context_id,
 extern int acct_gather_energy_g_set_data(enum acct_energy_type data_type,
 					 void *data);
 extern int acct_gather_energy_startpoll(uint32_t frequency);
+
+/*
+ * Set the directory holding the node readings the slurmd shares with its
+ * steps, must be called by slurmd and slurmstepd.
+ */
+extern void acct_gather_energy_set_spooldir(const char *dir);
+
+/* Start publishing the node readings of every plugin, slurmd only */
+extern int acct_gather_energy_start_publish(void);
+
+/*
+ * Get the energy data of all sensors of a plugin context on the local node.
+ * Readings published by the slurmd are used when polled within delta
+ * seconds, otherwise the slurmd is asked for fresh ones.
+ * IN  context_id - plugin context of the caller
+ * IN  delta - seconds a reading may be old
+ * OUT sensor_cnt - number of sensors
+ * OUT energy - array of sensor readings, free with
+ *	acct_gather_energy_destroy()
+ * RET SLURM_SUCCESS or an error code
+ */
+extern int acct_gather_energy_get_node_energy(uint16_t context_id,
+					      uint16_t delta,
+					      uint16_t *sensor_cnt,
+					      acct_gather_energy_t **energy);
 extern int acct_gather_energy_g_conf_options(s_p_options_t **full_options,
 					      int *full_options_cnt);
 extern int acct_gather_energy_g_conf_set(s_p_hashtbl_t *tbl);
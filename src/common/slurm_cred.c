@@ -43,6 +43,7 @@
 #include <fcntl.h>
 #include <pthread.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <sys/time.h>
 
@@ -62,6 +63,7 @@
 #include "src/common/slurm_time.h"
 #include "src/common/uid.h"
 #include "src/common/xassert.h"
+#include "src/common/xhash.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
@@ -87,13 +89,18 @@ typedef struct sbcast_cred sbcast_cred_t;		/* opaque data type */
 /*
  * slurm job credential state
  *
+ * NOTE: ctime and step_id must stay adjacent, together they are the
+ * state_hash key (see CRED_STATE_KEY_LEN).
  */
 typedef struct {
 	time_t   ctime;		/* Time that the cred was created	*/
-	time_t   expiration;    /* Time at which cred is no longer good	*/
 	slurm_step_id_t step_id; /* Slurm step id for this credential	*/
+	time_t   expiration;    /* Time at which cred is no longer good	*/
 } cred_state_t;
 
+#define CRED_STATE_KEY_LEN \
+	(offsetof(cred_state_t, step_id) + sizeof(slurm_step_id_t))
+
 /*
  * slurm job state information
  * tracks jobids for which all future credentials have been revoked
@@ -147,7 +154,9 @@ struct slurm_cred_context {
 	enum ctx_type type;	/* context type (creator or verifier)	*/
 	void *key;		/* private or public key		*/
 	List job_list;		/* List of used jobids (for verifier)	*/
+	xhash_t *job_hash;	/* job_list entries by jobid		*/
 	List state_list;	/* List of cred states (for verifier)	*/
+	xhash_t *state_hash;	/* state_list entries by ctime+step_id	*/
 
 	int expiry_window;	/* expiration window for cached creds	*/
 
@@ -262,7 +271,7 @@ static void           _job_state_destroy(job_state_t   *js);
 
 static job_state_t  * _find_job_state(slurm_cred_ctx_t ctx, uint32_t jobid);
 static job_state_t  * _insert_job_state(slurm_cred_ctx_t ctx,  uint32_t jobid);
-static int _list_find_cred_state(void *x, void *key);
+static cred_state_t * _find_cred_state(slurm_cred_ctx_t ctx, slurm_cred_t *cred);
 
 static void _insert_cred_state(slurm_cred_ctx_t ctx, slurm_cred_t *cred);
 static void _clear_expired_job_states(slurm_cred_ctx_t ctx);
@@ -365,7 +374,7 @@ static int _slurm_cred_fini(void)
 	return rc;
 }
 
-static int _fill_cred_gids(slurm_cred_t *cred, slurm_cred_arg_t *arg)
+static int _fill_cred_gids(slurm_cred_t *cred, char *pw_name)
 {
 	struct passwd pwd, *result;
 	char buffer[PW_BUF_SIZE];
@@ -375,12 +384,11 @@ static int _fill_cred_gids(slurm_cred_t *cred, slurm_cred_arg_t *arg)
 		return SLURM_SUCCESS;
 
 	xassert(cred);
-	xassert(arg);
 
-	rc = slurm_getpwuid_r(arg->uid, &pwd, buffer, PW_BUF_SIZE, &result);
+	rc = slurm_getpwuid_r(cred->uid, &pwd, buffer, PW_BUF_SIZE, &result);
 	if (rc || !result) {
 		error("%s: getpwuid failed for uid=%u",
-		      __func__, arg->uid);
+		      __func__, cred->uid);
 		return SLURM_ERROR;
 	}
 
@@ -389,8 +397,8 @@ static int _fill_cred_gids(slurm_cred_t *cred, slurm_cred_arg_t *arg)
 	cred->pw_dir = xstrdup(result->pw_dir);
 	cred->pw_shell = xstrdup(result->pw_shell);
 
-	cred->ngids = group_cache_lookup(arg->uid, arg->gid,
-					 arg->pw_name, &cred->gids);
+	cred->ngids = group_cache_lookup(cred->uid, cred->gid,
+					 pw_name, &cred->gids);
 
 	return SLURM_SUCCESS;
 }
@@ -477,7 +485,9 @@ slurm_cred_ctx_destroy(slurm_cred_ctx_t ctx)
 		(*(ops.cred_destroy_key))(ctx->exkey);
 	if (ctx->key)
 		(*(ops.cred_destroy_key))(ctx->key);
+	xhash_free(ctx->job_hash);
 	FREE_NULL_LIST(ctx->job_list);
+	xhash_free(ctx->state_hash);
 	FREE_NULL_LIST(ctx->state_list);
 
 	ctx->magic = ~CRED_CTX_MAGIC;
@@ -564,20 +574,17 @@ slurm_cred_ctx_key_update(slurm_cred_ctx_t ctx, const char *path)
 }
 
 
-slurm_cred_t *
-slurm_cred_create(slurm_cred_ctx_t ctx, slurm_cred_arg_t *arg,
-		  uint16_t protocol_version)
+/*
+ * Copy the contents of `arg' into a new credential without resolving the
+ * user's identity or signing it. Neither `arg' nor anything it references
+ * is used after this returns.
+ */
+static slurm_cred_t *_slurm_cred_create_unsigned(slurm_cred_arg_t *arg)
 {
 	slurm_cred_t *cred = NULL;
 	int i = 0, sock_recs = 0;
 
-	xassert(ctx != NULL);
-	xassert(arg != NULL);
-	if (_slurm_cred_init() < 0)
-		return NULL;
-
 	cred = _slurm_cred_alloc();
-	slurm_mutex_lock(&cred->mutex);
 	xassert(cred->magic == CRED_MAGIC);
 
 	memcpy(&cred->step_id, &arg->step_id, sizeof(cred->step_id));
@@ -625,10 +632,21 @@ slurm_cred_create(slurm_cred_ctx_t ctx, slurm_cred_arg_t *arg,
 	cred->job_constraints = xstrdup(arg->job_constraints);
 	cred->job_nhosts      = arg->job_nhosts;
 	cred->job_hostlist    = xstrdup(arg->job_hostlist);
+
+	return cred;
+}
+
+/*
+ * Fill in the user's identity and sign a credential built by
+ * _slurm_cred_create_unsigned(). cred->mutex must be locked.
+ */
+static int _slurm_cred_finish(slurm_cred_ctx_t ctx, slurm_cred_t *cred,
+			      char *pw_name, uint16_t protocol_version)
+{
 	cred->ctime  = time(NULL);
 
-	if (_fill_cred_gids(cred, arg) != SLURM_SUCCESS)
-		goto fail;
+	if (_fill_cred_gids(cred, pw_name) != SLURM_SUCCESS)
+		return SLURM_ERROR;
 
 	if (enable_nss_slurm) {
 		if (cred->ngids) {
@@ -645,18 +663,59 @@ slurm_cred_create(slurm_cred_ctx_t ctx, slurm_cred_arg_t *arg,
 	xassert(ctx->type == SLURM_CRED_CREATOR);
 	if (_slurm_cred_sign(ctx, cred, protocol_version) < 0) {
 		slurm_mutex_unlock(&ctx->mutex);
-		goto fail;
+		return SLURM_ERROR;
 	}
-
 	slurm_mutex_unlock(&ctx->mutex);
+
+	return SLURM_SUCCESS;
+}
+
+slurm_cred_t *
+slurm_cred_create(slurm_cred_ctx_t ctx, slurm_cred_arg_t *arg,
+		  uint16_t protocol_version)
+{
+	slurm_cred_t *cred = NULL;
+
+	xassert(ctx != NULL);
+	xassert(arg != NULL);
+	if (_slurm_cred_init() < 0)
+		return NULL;
+
+	cred = _slurm_cred_create_unsigned(arg);
+	slurm_mutex_lock(&cred->mutex);
+	if (_slurm_cred_finish(ctx, cred, arg->pw_name, protocol_version)) {
+		slurm_mutex_unlock(&cred->mutex);
+		slurm_cred_destroy(cred);
+		return NULL;
+	}
 	slurm_mutex_unlock(&cred->mutex);
 
 	return cred;
+}
 
-fail:
+extern slurm_cred_t *slurm_cred_create_unsigned(slurm_cred_arg_t *arg)
+{
+	xassert(arg != NULL);
+	if (_slurm_cred_init() < 0)
+		return NULL;
+
+	return _slurm_cred_create_unsigned(arg);
+}
+
+extern int slurm_cred_sign(slurm_cred_ctx_t ctx, slurm_cred_t *cred,
+			   uint16_t protocol_version)
+{
+	int rc;
+
+	xassert(ctx != NULL);
+	xassert(cred != NULL);
+
+	slurm_mutex_lock(&cred->mutex);
+	xassert(cred->magic == CRED_MAGIC);
+	rc = _slurm_cred_finish(ctx, cred, NULL, protocol_version);
 	slurm_mutex_unlock(&cred->mutex);
-	slurm_cred_destroy(cred);
-	return NULL;
+
+	return rc;
 }
 
 slurm_cred_t *
@@ -787,7 +846,7 @@ slurm_cred_faker(slurm_cred_arg_t *arg)
 			cred->signature[i] = 'a' + (rand() & 0xf);
 	}
 
-	(void) _fill_cred_gids(cred, arg);
+	(void) _fill_cred_gids(cred, arg->pw_name);
 
 	slurm_mutex_unlock(&cred->mutex);
 	return cred;
@@ -1037,6 +1096,7 @@ slurm_cred_insert_jobid(slurm_cred_ctx_t ctx, uint32_t jobid)
 int
 slurm_cred_rewind(slurm_cred_ctx_t ctx, slurm_cred_t *cred)
 {
+	cred_state_t *s;
 	int rc = 0;
 
 	xassert(ctx != NULL);
@@ -1046,7 +1106,11 @@ slurm_cred_rewind(slurm_cred_ctx_t ctx, slurm_cred_t *cred)
 	xassert(ctx->magic == CRED_CTX_MAGIC);
 	xassert(ctx->type  == SLURM_CRED_VERIFIER);
 
-	rc = list_delete_all(ctx->state_list, _list_find_cred_state, cred);
+	if ((s = _find_cred_state(ctx, cred))) {
+		xhash_pop(ctx->state_hash, (char *) &s->ctime,
+			  CRED_STATE_KEY_LEN);
+		rc = list_delete_ptr(ctx->state_list, s);
+	}
 
 	slurm_mutex_unlock(&ctx->mutex);
 
@@ -1381,8 +1445,10 @@ slurm_cred_t *slurm_cred_unpack(buf_t *buffer, uint16_t protocol_version)
 		safe_unpack16(&cred->x11, buffer);
 		safe_unpack_time(&cred->ctime, buffer);
 		safe_unpack32(&tot_core_cnt, buffer);
-		unpack_bit_str_hex(&cred->job_core_bitmap, buffer);
-		unpack_bit_str_hex(&cred->step_core_bitmap, buffer);
+		unpack_bit_str(&cred->job_core_bitmap, buffer,
+			       protocol_version);
+		unpack_bit_str(&cred->step_core_bitmap, buffer,
+			       protocol_version);
 		safe_unpack16(&cred->core_array_size, buffer);
 		if (cred->core_array_size) {
 			safe_unpack16_array(&cred->cores_per_socket, &len,
@@ -1444,8 +1510,10 @@ slurm_cred_t *slurm_cred_unpack(buf_t *buffer, uint16_t protocol_version)
 		safe_unpack16(&cred->x11, buffer);
 		safe_unpack_time(&cred->ctime, buffer);
 		safe_unpack32(&tot_core_cnt, buffer);
-		unpack_bit_str_hex(&cred->job_core_bitmap, buffer);
-		unpack_bit_str_hex(&cred->step_core_bitmap, buffer);
+		unpack_bit_str(&cred->job_core_bitmap, buffer,
+			       protocol_version);
+		unpack_bit_str(&cred->step_core_bitmap, buffer,
+			       protocol_version);
 		safe_unpack16(&cred->core_array_size, buffer);
 		if (cred->core_array_size) {
 			safe_unpack16_array(&cred->cores_per_socket, &len,
@@ -1567,6 +1635,25 @@ slurm_cred_print(slurm_cred_t *cred)
 
 }
 
+/* Fetch key from job_hash item. Called from function ptr */
+static void _job_state_key_id(void *item, const char **key, uint32_t *key_len)
+{
+	job_state_t *j = item;
+
+	*key = (char *) &j->jobid;
+	*key_len = sizeof(uint32_t);
+}
+
+/* Fetch key from state_hash item. Called from function ptr */
+static void _cred_state_key_id(void *item, const char **key,
+			       uint32_t *key_len)
+{
+	cred_state_t *s = item;
+
+	*key = (char *) &s->ctime;
+	*key_len = CRED_STATE_KEY_LEN;
+}
+
 static void
 _verifier_ctx_init(slurm_cred_ctx_t ctx)
 {
@@ -1575,7 +1662,9 @@ _verifier_ctx_init(slurm_cred_ctx_t ctx)
 	xassert(ctx->type == SLURM_CRED_VERIFIER);
 
 	ctx->job_list   = list_create((ListDelF) _job_state_destroy);
+	ctx->job_hash   = xhash_init(_job_state_key_id, NULL);
 	ctx->state_list = list_create(xfree_ptr);
+	ctx->state_hash = xhash_init(_cred_state_key_id, NULL);
 
 	return;
 }
@@ -1782,8 +1871,8 @@ static void _pack_cred(slurm_cred_t *cred, buf_t *buffer,
 		if (cred->job_core_bitmap)
 			tot_core_cnt = bit_size(cred->job_core_bitmap);
 		pack32(tot_core_cnt, buffer);
-		pack_bit_str_hex(cred->job_core_bitmap, buffer);
-		pack_bit_str_hex(cred->step_core_bitmap, buffer);
+		pack_bit_str(cred->job_core_bitmap, buffer, protocol_version);
+		pack_bit_str(cred->step_core_bitmap, buffer, protocol_version);
 		pack16(cred->core_array_size, buffer);
 		if (cred->core_array_size) {
 			pack16_array(cred->cores_per_socket,
@@ -1825,8 +1914,8 @@ static void _pack_cred(slurm_cred_t *cred, buf_t *buffer,
 		if (cred->job_core_bitmap)
 			tot_core_cnt = bit_size(cred->job_core_bitmap);
 		pack32(tot_core_cnt, buffer);
-		pack_bit_str_hex(cred->job_core_bitmap, buffer);
-		pack_bit_str_hex(cred->step_core_bitmap, buffer);
+		pack_bit_str(cred->job_core_bitmap, buffer, protocol_version);
+		pack_bit_str(cred->step_core_bitmap, buffer, protocol_version);
 		pack16(cred->core_array_size, buffer);
 		if (cred->core_array_size) {
 			pack16_array(cred->cores_per_socket,
@@ -1844,16 +1933,16 @@ static void _pack_cred(slurm_cred_t *cred, buf_t *buffer,
 	}
 }
 
-static int _list_find_cred_state(void *x, void *key)
+static cred_state_t *
+_find_cred_state(slurm_cred_ctx_t ctx, slurm_cred_t *cred)
 {
-	cred_state_t *s = (cred_state_t *) x;
-	slurm_cred_t *cred = (slurm_cred_t *) key;
-
-	if (!memcmp(&s->step_id, &cred->step_id, sizeof(s->step_id)) &&
-	    (s->ctime == cred->ctime))
-		return 1;
+	cred_state_t key = {
+		.ctime = cred->ctime,
+		.step_id = cred->step_id,
+	};
 
-	return 0;
+	return xhash_get(ctx->state_hash, (char *) &key.ctime,
+			 CRED_STATE_KEY_LEN);
 }
 
 
@@ -1864,7 +1953,7 @@ _credential_replayed(slurm_cred_ctx_t ctx, slurm_cred_t *cred)
 
 	_clear_expired_credential_states(ctx);
 
-	s = list_find_first(ctx->state_list, _list_find_cred_state, cred);
+	s = _find_cred_state(ctx, cred);
 
 	/*
 	 * If we found a match, this credential is being replayed.
@@ -1944,31 +2033,20 @@ _credential_revoked(slurm_cred_ctx_t ctx, slurm_cred_t *cred)
 	return false;
 }
 
-static int _list_find_job_state(void *x, void *key)
-{
-	job_state_t *j = (job_state_t *) x;
-	uint32_t jobid = *(uint32_t *) key;
-	if (j->jobid == jobid)
-		return 1;
-	return 0;
-}
-
 static job_state_t *
 _find_job_state(slurm_cred_ctx_t ctx, uint32_t jobid)
 {
-	job_state_t *j =
-		list_find_first(ctx->job_list, _list_find_job_state, &jobid);
-	return j;
+	return xhash_get(ctx->job_hash, (char *) &jobid, sizeof(uint32_t));
 }
 
 static job_state_t *
 _insert_job_state(slurm_cred_ctx_t ctx, uint32_t jobid)
 {
-	job_state_t *j = list_find_first(
-		ctx->job_list, _list_find_job_state, &jobid);;
+	job_state_t *j = _find_job_state(ctx, jobid);
 	if (!j) {
 		j = _job_state_create(jobid);
 		list_append(ctx->job_list, j);
+		xhash_add(ctx->job_hash, j);
 	} else
 		debug2("%s: we already have a job state for job %u.  No big deal, just an FYI.",
 		       __func__, jobid);
@@ -2014,6 +2092,8 @@ _clear_expired_job_states(slurm_cred_ctx_t ctx)
 		debug3("state for jobid %u: ctime:%ld revoked:%ld expires:%ld",
 		       j->jobid, j->ctime, j->revoked, j->expiration);
 		if (j->revoked && (now > j->expiration)) {
+			xhash_pop(ctx->job_hash, (char *) &j->jobid,
+				  sizeof(uint32_t));
 			list_delete_item(i);
 		}
 	}
@@ -2021,27 +2101,27 @@ _clear_expired_job_states(slurm_cred_ctx_t ctx)
 	list_iterator_destroy(i);
 }
 
-static int _list_find_expired(void *x, void *key)
-{
-	cred_state_t *s = (cred_state_t *)x;
-	time_t curr_time = *(time_t *)key;
-
-	if (curr_time > s->expiration)
-		return 1;
-	return 0;
-}
-
 static void
 _clear_expired_credential_states(slurm_cred_ctx_t ctx)
 {
 	static time_t last_scan = 0;
 	time_t        now = time(NULL);
+	ListIterator  i   = NULL;
+	cred_state_t *s   = NULL;
 
 	if ((now - last_scan) < 2)	/* Reduces slurmd overhead */
 		return;
 	last_scan = now;
 
-	list_delete_all(ctx->state_list, _list_find_expired, &now);
+	i = list_iterator_create(ctx->state_list);
+	while ((s = list_next(i))) {
+		if (now > s->expiration) {
+			xhash_pop(ctx->state_hash, (char *) &s->ctime,
+				  CRED_STATE_KEY_LEN);
+			list_delete_item(i);
+		}
+	}
+	list_iterator_destroy(i);
 }
 
 
@@ -2050,6 +2130,7 @@ _insert_cred_state(slurm_cred_ctx_t ctx, slurm_cred_t *cred)
 {
 	cred_state_t *s = _cred_state_create(ctx, cred);
 	list_append(ctx->state_list, s);
+	xhash_add(ctx->state_hash, s);
 }
 
 
@@ -2153,9 +2234,12 @@ static void _cred_state_unpack(slurm_cred_ctx_t ctx, buf_t *buffer)
 		if (!(s = _cred_state_unpack_one(buffer)))
 			goto unpack_error;
 
-		if (now < s->expiration)
+		if ((now < s->expiration) &&
+		    !xhash_get(ctx->state_hash, (char *) &s->ctime,
+			       CRED_STATE_KEY_LEN)) {
 			list_append(ctx->state_list, s);
-		else
+			xhash_add(ctx->state_hash, s);
+		} else
 			xfree(s);
 	}
 
@@ -2196,9 +2280,14 @@ static void _job_state_unpack(slurm_cred_ctx_t ctx, buf_t *buffer)
 		if (!(j = _job_state_unpack_one(buffer)))
 			goto unpack_error;
 
-		if (!j->revoked || (j->revoked && (now < j->expiration)))
+		if (_find_job_state(ctx, j->jobid)) {
+			debug3("not appending duplicate job %u state",
+			       j->jobid);
+			_job_state_destroy(j);
+		} else if (!j->revoked || (j->revoked && (now < j->expiration))) {
 			list_append(ctx->job_list, j);
-		else {
+			xhash_add(ctx->job_hash, j);
+		} else {
 			debug3 ("not appending expired job %u state",
 			        j->jobid);
 			_job_state_destroy(j);
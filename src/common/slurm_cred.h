@@ -194,6 +194,20 @@ int slurm_cred_fini(void);
 slurm_cred_t *slurm_cred_create(slurm_cred_ctx_t ctx, slurm_cred_arg_t *arg,
 				uint16_t protocol_version);
 
+/*
+ * Split form of slurm_cred_create(). slurm_cred_create_unsigned() copies
+ * the values in `arg' and is the only part that needs them to stay valid.
+ * slurm_cred_sign() then resolves the user's identity and signs the
+ * credential, so it can run after the caller drops the locks protecting
+ * `arg'. arg->pw_name is not used.
+ *
+ * slurm_cred_create_unsigned() returns NULL on failure.
+ * slurm_cred_sign() returns SLURM_SUCCESS or SLURM_ERROR.
+ */
+extern slurm_cred_t *slurm_cred_create_unsigned(slurm_cred_arg_t *arg);
+extern int slurm_cred_sign(slurm_cred_ctx_t ctx, slurm_cred_t *cred,
+			   uint16_t protocol_version);
+
 /*
  * Copy a slurm credential.
  * Returns NULL on failure.
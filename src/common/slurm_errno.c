@@ -442,6 +442,8 @@ static slurm_errtab_t slurm_errtab[] = {
 	  "Job step is not currently suspended"                 },
 	{ ESLURMD_INVALID_SOCKET_NAME_LEN,
 	  "Unix socket name exceeded maximum length"		},
+	{ ESLURMD_BCAST_CACHED,
+	  "File broadcast satisfied from node's sbcast cache"	},
 
 	/* slurmd errors in user batch job */
 	{ ESCRIPT_CHDIR_FAILED,
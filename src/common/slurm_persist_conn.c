@@ -455,9 +455,12 @@ extern void slurm_persist_conn_recv_thread_init(slurm_persist_conn_t *persist_co
 	service_conn->conn = persist_conn;
 	service_conn->thread_loc = thread_loc;
 
-	persist_conn->timeout = 0; /* If this isn't zero we won't wait forever
-				      like we want to.
-				   */
+	/*
+	 * If this isn't zero we won't wait forever like we want to. Client
+	 * sessions keep their idle timeout so abandoned ones are reaped.
+	 */
+	if (persist_conn->persist_type != PERSIST_TYPE_CLIENT)
+		persist_conn->timeout = 0;
 
 	//_service_connection(service_conn);
 	slurm_thread_create(&persist_service_conn[thread_loc]->thread_id,
@@ -54,6 +54,7 @@ typedef enum {
 	PERSIST_TYPE_FED,
 	PERSIST_TYPE_HA_CTL,
 	PERSIST_TYPE_HA_DBD,
+	PERSIST_TYPE_CLIENT,	/* client command session to slurmctld */
 } persist_conn_type_t;
 
 typedef struct {
@@ -56,6 +56,10 @@
 #include <time.h>
 #include <unistd.h>
 
+#if HAVE_LIBZ
+#  include <zlib.h>
+#endif
+
 /* PROJECT INCLUDES */
 #include "src/common/assoc_mgr.h"
 #include "src/common/fd.h"
@@ -72,6 +76,7 @@
 #include "src/common/slurm_protocol_pack.h"
 #include "src/common/slurm_route.h"
 #include "src/common/strlcpy.h"
+#include "src/common/timers.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 #include "src/slurmdbd/read_config.h"
@@ -85,9 +90,13 @@ strong_alias(get_unit_type, slurm_get_unit_type);
 /* EXTERNAL VARIABLES */
 
 /* #DEFINES */
+/* Smallest response body worth deflating before it is sent */
+#define COMPRESS_MIN_SIZE (64 * 1024)
 
 /* STATIC VARIABLES */
 static int message_timeout = -1;
+static slurm_persist_conn_t *ctld_session = NULL;
+static pthread_mutex_t ctld_session_lock = PTHREAD_MUTEX_INITIALIZER;
 
 /* STATIC FUNCTIONS */
 static char *_global_auth_key(void);
@@ -890,11 +899,54 @@ fini:	_slurm_api_free_comm_config(proto_conf);
 	return rc;
 }
 
+#if HAVE_LIBZ
+/*
+ * Inflate a message body deflated by _compress_msg_body() in place. Everything
+ * before the current offset (header and auth credential) is kept as is.
+ * RET SLURM_SUCCESS or SLURM_ERROR
+ */
+static int _uncompress_msg_body(header_t *header, buf_t *buffer)
+{
+	uint32_t offset = get_buf_offset(buffer);
+	uint32_t orig_len;
+	char *data;
+	uLongf dest_len;
+
+	if (unpack32(&orig_len, buffer) ||
+	    (orig_len > (MAX_BUF_SIZE - offset)))
+		return SLURM_ERROR;
+
+	data = xmalloc(offset + orig_len);
+	memcpy(data, get_buf_data(buffer), offset);
+	dest_len = orig_len;
+	if ((uncompress((Bytef *) data + offset, &dest_len,
+			(Bytef *) get_buf_data(buffer) + get_buf_offset(buffer),
+			remaining_buf(buffer)) != Z_OK) ||
+	    (dest_len != orig_len)) {
+		error("%s: failed to inflate %s", __func__,
+		      rpc_num2string(header->msg_type));
+		xfree(data);
+		return SLURM_ERROR;
+	}
+
+	xfree(buffer->head);
+	buffer->head = data;
+	buffer->size = offset + orig_len;
+	set_buf_offset(buffer, offset);
+
+	header->body_length = orig_len;
+	header->flags &= ~SLURM_MSG_COMPRESSED;
+
+	return SLURM_SUCCESS;
+}
+#endif
+
 extern int slurm_unpack_received_msg(slurm_msg_t *msg, int fd, buf_t *buffer)
 {
 	header_t header;
 	int rc;
 	void *auth_cred = NULL;
+	struct timeval auth_start;
 
 	if (unpack_header(&header, buffer) == SLURM_ERROR) {
 		rc = SLURM_COMMUNICATIONS_RECEIVE_ERROR;
@@ -939,11 +991,14 @@ extern int slurm_unpack_received_msg(slurm_msg_t *msg, int fd, buf_t *buffer)
 		goto total_return;
 	}
 	msg->auth_index = slurm_auth_index(auth_cred);
+	auth_start.tv_sec = 0;
+	(void) slurm_delta_tv(&auth_start);
 	if (header.flags & SLURM_GLOBAL_AUTH_KEY) {
 		rc = auth_g_verify(auth_cred, _global_auth_key());
 	} else {
 		rc = auth_g_verify(auth_cred, slurm_conf.authinfo);
 	}
+	msg->auth_time = slurm_delta_tv(&auth_start);
 
 	if (rc != SLURM_SUCCESS) {
 		error("%s: auth_g_verify: %s has authentication error: %s",
@@ -957,12 +1012,28 @@ extern int slurm_unpack_received_msg(slurm_msg_t *msg, int fd, buf_t *buffer)
 	msg->auth_uid = auth_g_get_uid(auth_cred);
 	msg->auth_uid_set = true;
 
+	if (header.flags & SLURM_MSG_COMPRESSED) {
+#if HAVE_LIBZ
+		rc = _uncompress_msg_body(&header, buffer);
+#else
+		error("%s: %s is compressed, but zlib support is not available",
+		      __func__, rpc_num2string(header.msg_type));
+		rc = SLURM_ERROR;
+#endif
+		if (rc != SLURM_SUCCESS) {
+			(void) auth_g_destroy(auth_cred);
+			rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
+			goto total_return;
+		}
+	}
+
 	/*
 	 * Unpack message body
 	 */
 	msg->protocol_version = header.version;
 	msg->msg_type = header.msg_type;
 	msg->flags = header.flags;
+	msg->trace_id = header.trace_id;
 
 	msg->body_offset =  get_buf_offset(buffer);
 
@@ -1227,6 +1298,7 @@ List slurm_receive_msgs(int fd, int steps, int timeout)
 	msg.protocol_version = header.version;
 	msg.msg_type = header.msg_type;
 	msg.flags = header.flags;
+	msg.trace_id = header.trace_id;
 
 	if ((header.body_length > remaining_buf(buffer)) ||
 	    (unpack_msg(&msg, buffer) != SLURM_SUCCESS)) {
@@ -1445,6 +1517,7 @@ int slurm_receive_msg_and_forward(int fd, slurm_addr_t *orig_addr,
 	msg->protocol_version = header.version;
 	msg->msg_type = header.msg_type;
 	msg->flags = header.flags;
+	msg->trace_id = header.trace_id;
 
 	if ( (header.body_length > remaining_buf(buffer)) ||
 	     (unpack_msg(msg, buffer) != SLURM_SUCCESS) ) {
@@ -1502,6 +1575,71 @@ static void _pack_msg(slurm_msg_t *msg, header_t *hdr, buf_t *buffer)
 	set_buf_offset(buffer, tmplen);
 }
 
+#if HAVE_LIBZ
+/* Large, highly repetitive responses worth deflating on the wire */
+static bool _compress_msg_type(uint16_t msg_type)
+{
+	switch (msg_type) {
+	case RESPONSE_JOB_INFO:
+	case RESPONSE_JOB_STEP_INFO:
+	case RESPONSE_NODE_INFO:
+	case RESPONSE_PARTITION_INFO:
+	case RESPONSE_RESERVATION_INFO:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Replace the message body in buffer (starting at body_offset) with its
+ * deflated form if that makes it smaller, and update the packed header to
+ * match. The compressed body is the original length followed by the raw
+ * zlib stream, which runs to the end of the message.
+ */
+static void _compress_msg_body(header_t *hdr, buf_t *buffer,
+			       uint32_t body_offset)
+{
+	uint32_t body_len = get_buf_offset(buffer) - body_offset;
+	uint32_t tmplen;
+	uLongf comp_len;
+	Bytef *comp_data;
+
+	if ((body_len < COMPRESS_MIN_SIZE) ||
+	    (hdr->version < SLURM_21_08_PROTOCOL_VERSION) ||
+	    !(hdr->flags & SLURM_MSG_ACCEPT_COMPRESS) ||
+	    !_compress_msg_type(hdr->msg_type))
+		return;
+
+	comp_len = compressBound(body_len);
+	comp_data = xmalloc(comp_len);
+	if ((compress2(comp_data, &comp_len,
+		       (Bytef *) get_buf_data(buffer) + body_offset, body_len,
+		       Z_BEST_SPEED) != Z_OK) ||
+	    ((comp_len + sizeof(uint32_t)) >= body_len)) {
+		xfree(comp_data);
+		return;
+	}
+
+	log_flag(NET, "%s: %s deflated from %u to %lu bytes",
+		 __func__, rpc_num2string(hdr->msg_type), body_len,
+		 (unsigned long) comp_len);
+
+	set_buf_offset(buffer, body_offset);
+	pack32(body_len, buffer);
+	packmem_array((char *) comp_data, comp_len, buffer);
+	xfree(comp_data);
+
+	hdr->flags |= SLURM_MSG_COMPRESSED;
+	update_header(hdr, get_buf_offset(buffer) - body_offset);
+
+	tmplen = get_buf_offset(buffer);
+	set_buf_offset(buffer, 0);
+	pack_header(hdr, buffer);
+	set_buf_offset(buffer, tmplen);
+}
+#endif
+
 /*
  *  Send a slurm message over an open file descriptor `fd'
  *    Returns the size of the message sent in bytes, or -1 on failure.
@@ -1513,6 +1651,9 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 	int      rc;
 	void *   auth_cred;
 	time_t   start_time = time(NULL);
+#if HAVE_LIBZ
+	uint32_t body_offset;
+#endif
 
 	if (msg->conn) {
 		persist_msg_t persist_msg;
@@ -1607,7 +1748,13 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 	/*
 	 * Pack message into buffer
 	 */
+#if HAVE_LIBZ
+	body_offset = get_buf_offset(buffer);
+#endif
 	_pack_msg(msg, &header, buffer);
+#if HAVE_LIBZ
+	_compress_msg_body(&header, buffer, body_offset);
+#endif
 	log_flag_hex(NET_RAW, get_buf_data(buffer), get_buf_offset(buffer),
 		     "%s: packed", __func__);
 
@@ -2077,6 +2224,150 @@ _send_and_recv_msgs(int fd, slurm_msg_t *req, int timeout)
 	return ret_list;
 }
 
+extern bool slurm_ctld_session_rpc(uint16_t msg_type)
+{
+	switch (msg_type) {
+	case REQUEST_BUILD_INFO:
+	case REQUEST_JOB_INFO:
+	case REQUEST_JOB_INFO_SINGLE:
+	case REQUEST_JOB_STEP_INFO:
+	case REQUEST_JOB_USER_INFO:
+	case REQUEST_NODE_INFO:
+	case REQUEST_NODE_INFO_SINGLE:
+	case REQUEST_PARTITION_INFO:
+	case REQUEST_RESERVATION_INFO:
+	case REQUEST_STEP_LAYOUT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+extern int slurm_open_controller_session(void)
+{
+	slurm_persist_conn_t *persist_conn;
+	slurm_conf_t *conf;
+	char **hosts;
+	int i, host_cnt, rc = SLURM_ERROR;
+
+	slurm_mutex_lock(&ctld_session_lock);
+	if (ctld_session) {
+		slurm_mutex_unlock(&ctld_session_lock);
+		return SLURM_SUCCESS;
+	}
+
+	persist_conn = xmalloc(sizeof(slurm_persist_conn_t));
+	persist_conn->cluster_name = xstrdup(slurm_conf.cluster_name);
+	persist_conn->fd = -1;
+	persist_conn->persist_type = PERSIST_TYPE_CLIENT;
+	persist_conn->version = SLURM_PROTOCOL_VERSION;
+
+	conf = slurm_conf_lock();
+	persist_conn->rem_port = conf->slurmctld_port;
+	persist_conn->timeout = conf->msg_timeout * MSEC_IN_SEC;
+	host_cnt = conf->control_cnt;
+	hosts = xcalloc(host_cnt, sizeof(char *));
+	for (i = 0; i < host_cnt; i++)
+		hosts[i] = xstrdup(conf->control_addr[i]);
+	slurm_conf_unlock();
+
+	for (i = 0; (i < host_cnt) && (rc != SLURM_SUCCESS); i++) {
+		xfree(persist_conn->rem_host);
+		persist_conn->rem_host = xstrdup(hosts[i]);
+		rc = slurm_persist_conn_open(persist_conn);
+	}
+	for (i = 0; i < host_cnt; i++)
+		xfree(hosts[i]);
+	xfree(hosts);
+
+	if (rc == SLURM_SUCCESS) {
+		log_flag(NET, "%s: opened session to %s:%u",
+			 __func__, persist_conn->rem_host,
+			 persist_conn->rem_port);
+		ctld_session = persist_conn;
+	} else {
+		slurm_persist_conn_destroy(persist_conn);
+	}
+	slurm_mutex_unlock(&ctld_session_lock);
+
+	return rc;
+}
+
+extern void slurm_close_controller_session(void)
+{
+	slurm_mutex_lock(&ctld_session_lock);
+	slurm_persist_conn_destroy(ctld_session);
+	ctld_session = NULL;
+	slurm_mutex_unlock(&ctld_session_lock);
+}
+
+/*
+ * Send request_msg over the open controller session and wait for the reply.
+ * RET SLURM_SUCCESS, SLURM_ERROR (errno set) or ESLURM_NOT_SUPPORTED if there
+ *	is no usable session and nothing was sent, in which case the caller
+ *	should fall back to a dedicated connection.
+ */
+static int _send_recv_ctld_session(slurm_msg_t *request_msg,
+				   slurm_msg_t *response_msg)
+{
+	persist_msg_t persist_msg;
+	buf_t *buffer;
+	int rc;
+
+	if (!slurm_ctld_session_rpc(request_msg->msg_type))
+		return ESLURM_NOT_SUPPORTED;
+
+	slurm_mutex_lock(&ctld_session_lock);
+	if (!ctld_session) {
+		slurm_mutex_unlock(&ctld_session_lock);
+		return ESLURM_NOT_SUPPORTED;
+	}
+
+	memset(&persist_msg, 0, sizeof(persist_msg_t));
+	persist_msg.msg_type = request_msg->msg_type;
+	persist_msg.data = request_msg->data;
+	persist_msg.data_size = request_msg->data_size;
+
+	if (!(buffer = slurm_persist_msg_pack(ctld_session, &persist_msg))) {
+		slurm_mutex_unlock(&ctld_session_lock);
+		return ESLURM_NOT_SUPPORTED;
+	}
+	rc = slurm_persist_send_msg(ctld_session, buffer);
+	free_buf(buffer);
+	if (rc != SLURM_SUCCESS) {
+		log_flag(NET, "%s: controller session lost, using one connection per RPC",
+			 __func__);
+		slurm_persist_conn_destroy(ctld_session);
+		ctld_session = NULL;
+		slurm_mutex_unlock(&ctld_session_lock);
+		return ESLURM_NOT_SUPPORTED;
+	}
+
+	if (!(buffer = slurm_persist_recv_msg(ctld_session))) {
+		slurm_persist_conn_destroy(ctld_session);
+		ctld_session = NULL;
+		slurm_mutex_unlock(&ctld_session_lock);
+		slurm_seterrno(SLURM_COMMUNICATIONS_RECEIVE_ERROR);
+		return SLURM_ERROR;
+	}
+
+	memset(&persist_msg, 0, sizeof(persist_msg_t));
+	rc = slurm_persist_msg_unpack(ctld_session, &persist_msg, buffer);
+	response_msg->protocol_version = ctld_session->version;
+	slurm_mutex_unlock(&ctld_session_lock);
+	free_buf(buffer);
+
+	if (rc != SLURM_SUCCESS) {
+		slurm_seterrno(SLURM_COMMUNICATIONS_RECEIVE_ERROR);
+		return SLURM_ERROR;
+	}
+
+	response_msg->msg_type = persist_msg.msg_type;
+	response_msg->data = persist_msg.data;
+
+	return SLURM_SUCCESS;
+}
+
 /*
  * slurm_send_recv_controller_msg
  * opens a connection to the controller, sends the controller a message,
@@ -2109,6 +2400,16 @@ extern int slurm_send_recv_controller_msg(slurm_msg_t * request_msg,
 	forward_init(&request_msg->forward);
 	request_msg->ret_list = NULL;
 	request_msg->forward_struct = NULL;
+#if HAVE_LIBZ
+	/* Let the controller deflate large info responses */
+	request_msg->flags |= SLURM_MSG_ACCEPT_COMPRESS;
+#endif
+
+	if (!comm_cluster_rec &&
+	    ((rc = _send_recv_ctld_session(request_msg, response_msg)) !=
+	     ESLURM_NOT_SUPPORTED))
+		return rc;
+	rc = 0;
 
 tryagain:
 	retry = 1;
@@ -485,6 +485,13 @@ extern int slurm_send_recv_controller_msg(slurm_msg_t * request_msg,
 				slurm_msg_t * response_msg,
 				slurmdb_cluster_rec_t *comm_cluster_rec);
 
+/*
+ * slurm_ctld_session_rpc
+ * RET true if msg_type may be sent over a persistent client session to
+ *	slurmctld (see slurm_open_controller_session())
+ */
+extern bool slurm_ctld_session_rpc(uint16_t msg_type);
+
 
 /* slurm_send_recv_node_msg
  * opens a connection to node,
@@ -105,5 +105,8 @@
 #define SLURM_DROP_PRIV		0x0008
 #define USE_BCAST_NETWORK	0x0010
 #define CTLD_QUEUE_PROCESSING	0x0020
+#define SLURM_MSG_ACCEPT_COMPRESS 0x0040 /* sender can inflate responses */
+#define SLURM_MSG_COMPRESSED	0x0080	/* message body is zlib deflated */
+#define SLURM_MSG_AGGREGATE	0x0100	/* forwarders may merge responses */
 
 #endif
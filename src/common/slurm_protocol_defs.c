@@ -991,10 +991,22 @@ extern void slurm_free_job_step_kill_msg(job_step_kill_msg_t * msg)
 	}
 }
 
+extern void slurm_free_info_filter_members(info_filter_t *filter)
+{
+	if (filter) {
+		xfree(filter->accounts);
+		xfree(filter->nodes);
+		xfree(filter->partitions);
+		xfree(filter->states);
+		xfree(filter->users);
+	}
+}
+
 extern void slurm_free_job_info_request_msg(job_info_request_msg_t *msg)
 {
 	if (msg) {
 		FREE_NULL_LIST(msg->job_ids);
+		slurm_free_info_filter_members(&msg->filter);
 		xfree(msg);
 	}
 }
@@ -1012,7 +1024,10 @@ extern void slurm_free_front_end_info_request_msg
 
 extern void slurm_free_node_info_request_msg(node_info_request_msg_t *msg)
 {
-	xfree(msg);
+	if (msg) {
+		slurm_free_info_filter_members(&msg->filter);
+		xfree(msg);
+	}
 }
 
 extern void slurm_free_node_info_single_msg(node_info_single_msg_t *msg)
@@ -1490,6 +1505,17 @@ extern void slurm_free_kill_job_msg(kill_job_msg_t * msg)
 	}
 }
 
+extern void slurm_free_kill_job_list_msg(kill_job_list_msg_t *msg)
+{
+	if (msg) {
+		int i;
+		for (i = 0; i < msg->count; i++)
+			slurm_free_kill_job_msg(msg->kill_msgs[i]);
+		xfree(msg->kill_msgs);
+		xfree(msg);
+	}
+}
+
 extern void slurm_free_task_exit_msg(task_exit_msg_t * msg)
 {
 	if (msg) {
@@ -1745,6 +1771,18 @@ extern void slurm_free_stats_response_msg(stats_info_response_msg_t *msg)
 		xfree(msg->rpc_type_id);
 		xfree(msg->rpc_type_cnt);
 		xfree(msg->rpc_type_time);
+		xfree(msg->rpc_type_auth_time);
+		xfree(msg->rpc_type_lock_time);
+		xfree(msg->rpc_type_max_time);
+		xfree(msg->rpc_type_hist);
+		xfree(msg->job_launch_hist);
+		xfree(msg->job_launch_sum);
+		xfree(msg->job_launch_max);
+		if (msg->job_launch_max_node) {
+			for (i = 0; i < msg->job_launch_stage_cnt; i++)
+				xfree(msg->job_launch_max_node[i]);
+			xfree(msg->job_launch_max_node);
+		}
 		xfree(msg->rpc_user_id);
 		xfree(msg->rpc_user_cnt);
 		xfree(msg->rpc_user_time);
@@ -1755,6 +1793,16 @@ extern void slurm_free_stats_response_msg(stats_info_response_msg_t *msg)
 			xfree(msg->rpc_dump_hostlist[i]);
 		}
 		xfree(msg->rpc_dump_hostlist);
+		xfree(msg->lock_wait_hist);
+		xfree(msg->lock_hold_hist);
+		for (i = 0; i < msg->lock_caller_count; i++)
+			xfree(msg->lock_caller_name[i]);
+		xfree(msg->lock_caller_name);
+		xfree(msg->lock_caller_cnt);
+		xfree(msg->lock_caller_wait);
+		xfree(msg->lock_caller_wait_max);
+		xfree(msg->lock_caller_hold);
+		xfree(msg->lock_caller_hold_max);
 		xfree(msg);
 	}
 }
@@ -2186,6 +2234,31 @@ extern char *job_reason_string(enum job_state_reason inx)
 	}
 }
 
+/* Given a batch job launch stage, return a descriptive string */
+extern char *job_launch_stage_string(enum job_launch_stages inx)
+{
+	switch (inx) {
+	case JOB_LAUNCH_ALLOC:
+		return "Alloc";
+	case JOB_LAUNCH_QUEUED:
+		return "Queued";
+	case JOB_LAUNCH_SENT:
+		return "Sent";
+	case JOB_LAUNCH_RECV:
+		return "Recv";
+	case JOB_LAUNCH_PROLOG_START:
+		return "PrologStart";
+	case JOB_LAUNCH_PROLOG_END:
+		return "PrologEnd";
+	case JOB_LAUNCH_STEPD:
+		return "StepdReady";
+	case JOB_LAUNCH_TASK:
+		return "TaskStart";
+	default:
+		return "Unknown";
+	}
+}
+
 /* Given a job's reason string for waiting, return enum job_state_reason */
 extern enum job_state_reason job_reason_num(char *reason)
 {
@@ -4156,6 +4229,16 @@ extern void slurm_free_submit_response_response_msg(submit_response_msg_t * msg)
 	}
 }
 
+extern void slurm_free_submit_batch_jobs_response_msg(
+	submit_batch_jobs_response_msg_t *msg)
+{
+	if (msg) {
+		xfree(msg->error_code);
+		xfree(msg->job_id);
+		xfree(msg);
+	}
+}
+
 
 /*
  * slurm_free_ctl_conf - free slurm control information response message
@@ -4781,6 +4864,15 @@ extern void slurm_free_control_status_msg(control_status_msg_t *msg)
 	xfree(msg);
 }
 
+extern void slurm_free_state_replica_msg(state_replica_msg_t *msg)
+{
+	if (msg) {
+		xfree(msg->data);
+		xfree(msg->name);
+		xfree(msg);
+	}
+}
+
 extern void slurm_free_bb_status_req_msg(bb_status_req_msg_t *msg)
 {
 	int i;
@@ -4803,6 +4895,42 @@ extern void slurm_free_bb_status_resp_msg(bb_status_resp_msg_t *msg)
 	}
 }
 
+extern void slurm_free_ctld_profile_msg(ctld_profile_msg_t *msg)
+{
+	if (msg) {
+		xfree(msg->folded);
+		xfree(msg);
+	}
+}
+
+extern void slurm_free_ctld_event_req_msg(ctld_event_req_msg_t *msg)
+{
+	if (msg) {
+		xfree(msg->filter.partition);
+		xfree(msg);
+	}
+}
+
+extern void slurm_free_ctld_event_members(ctld_event_t *event)
+{
+	if (event) {
+		xfree(event->node_name);
+		xfree(event->partition);
+	}
+}
+
+extern void slurm_free_ctld_event_msg(ctld_event_msg_t *msg)
+{
+	int i;
+
+	if (msg) {
+		for (i = 0; i < msg->record_count; i++)
+			slurm_free_ctld_event_members(&msg->event_array[i]);
+		xfree(msg->event_array);
+		xfree(msg);
+	}
+}
+
 extern void slurm_free_crontab_request_msg(crontab_request_msg_t *msg)
 {
 	if (!msg)
@@ -4927,6 +5055,9 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case RESPONSE_SUBMIT_BATCH_JOB:
 		slurm_free_submit_response_response_msg(data);
 		break;
+	case RESPONSE_SUBMIT_BATCH_JOBS:
+		slurm_free_submit_batch_jobs_response_msg(data);
+		break;
 	case RESPONSE_ACCT_GATHER_UPDATE:
 		slurm_free_acct_gather_node_resp_msg(data);
 		break;
@@ -5055,6 +5186,9 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case REQUEST_TERMINATE_JOB:
 		slurm_free_kill_job_msg(data);
 		break;
+	case REQUEST_KILL_JOB_LIST:
+		slurm_free_kill_job_list_msg(data);
+		break;
 	case REQUEST_JOB_ID:
 		slurm_free_job_id_request_msg(data);
 		break;
@@ -5082,6 +5216,7 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case REQUEST_RECONFIGURE:
 	case REQUEST_CONTROL:
 	case REQUEST_CONTROL_STATUS:
+	case REQUEST_CTLD_PROFILE:
 	case REQUEST_TAKEOVER:
 	case RESPONSE_FORWARD_FAILED:
 	case REQUEST_DAEMON_STATUS:
@@ -5136,6 +5271,9 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case REQUEST_JOB_NOTIFY:
 		slurm_free_job_notify_msg(data);
 		break;
+	case REQUEST_JOB_WAIT_NOTIFY:
+		slurm_free_job_wait_notify_msg(data);
+		break;
 	case REQUEST_STATS_INFO:
 		slurm_free_stats_info_request_msg(data);
 		break;
@@ -5197,6 +5335,7 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 		break;
 	case REQUEST_HET_JOB_ALLOCATION:
 	case REQUEST_SUBMIT_BATCH_HET_JOB:
+	case REQUEST_SUBMIT_BATCH_JOBS:
 	case RESPONSE_HET_JOB_ALLOCATION:
 		FREE_NULL_LIST(data);
 		break;
@@ -5212,6 +5351,18 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case RESPONSE_BURST_BUFFER_STATUS:
 		slurm_free_bb_status_resp_msg(data);
 		break;
+	case RESPONSE_CTLD_PROFILE:
+		slurm_free_ctld_profile_msg(data);
+		break;
+	case REQUEST_STATE_REPLICA:
+		slurm_free_state_replica_msg(data);
+		break;
+	case REQUEST_CTLD_EVENTS:
+		slurm_free_ctld_event_req_msg(data);
+		break;
+	case RESPONSE_CTLD_EVENTS:
+		slurm_free_ctld_event_msg(data);
+		break;
 	case REQUEST_CRONTAB:
 		slurm_free_crontab_request_msg(data);
 		break;
@@ -5278,6 +5429,14 @@ extern void slurm_free_job_notify_msg(job_notify_msg_t * msg)
 	}
 }
 
+extern void slurm_free_job_wait_notify_msg(job_wait_notify_msg_t *msg)
+{
+	if (msg) {
+		xfree(msg->job_ids);
+		xfree(msg);
+	}
+}
+
 extern void slurm_free_ctld_multi_msg(ctld_list_msg_t *msg)
 {
 	if (msg) {
@@ -5486,6 +5645,16 @@ rpc_num2string(uint16_t opcode)
 		return "REQUEST_BURST_BUFFER_STATUS";
 	case RESPONSE_BURST_BUFFER_STATUS:
 		return "RESPONSE_BURST_BUFFER_STATUS";
+	case REQUEST_CTLD_PROFILE:
+		return "REQUEST_CTLD_PROFILE";
+	case RESPONSE_CTLD_PROFILE:
+		return "RESPONSE_CTLD_PROFILE";
+	case REQUEST_STATE_REPLICA:
+		return "REQUEST_STATE_REPLICA";
+	case REQUEST_CTLD_EVENTS:
+		return "REQUEST_CTLD_EVENTS";
+	case RESPONSE_CTLD_EVENTS:
+		return "RESPONSE_CTLD_EVENTS";
 
 	case REQUEST_CRONTAB:					/* 2200 */
 		return "REQUEST_CRONTAB";
@@ -5574,6 +5743,12 @@ rpc_num2string(uint16_t opcode)
 		return "REQUEST_HET_JOB_ALLOC_INFO";
 	case REQUEST_SUBMIT_BATCH_HET_JOB:
 		return "REQUEST_SUBMIT_BATCH_HET_JOB";
+	case REQUEST_SUBMIT_BATCH_JOBS:
+		return "REQUEST_SUBMIT_BATCH_JOBS";
+	case RESPONSE_SUBMIT_BATCH_JOBS:
+		return "RESPONSE_SUBMIT_BATCH_JOBS";
+	case REQUEST_JOB_WAIT_NOTIFY:
+		return "REQUEST_JOB_WAIT_NOTIFY";
 
 	case REQUEST_JOB_STEP_CREATE:				/* 5001 */
 		return "REQUEST_JOB_STEP_CREATE";
@@ -5671,6 +5846,8 @@ rpc_num2string(uint16_t opcode)
 		return "REQUEST_COMPLETE_PROLOG";
 	case RESPONSE_PROLOG_EXECUTING:				/* 6019 */
 		return "RESPONSE_PROLOG_EXECUTING";
+	case REQUEST_KILL_JOB_LIST:
+		return "REQUEST_KILL_JOB_LIST";
 
 	case SRUN_PING:						/* 7001 */
 		return "SRUN_PING";
@@ -59,6 +59,7 @@
 #include "src/common/job_options.h"
 #include "src/common/list.h"
 #include "src/common/macros.h"
+#include "src/common/mpsc_queue.h"
 #include "src/common/slurm_cred.h"
 #include "src/common/slurm_protocol_common.h"
 #include "src/common/slurm_persist_conn.h"
@@ -297,6 +298,11 @@ typedef enum {
 	RESPONSE_CONTROL_STATUS,
 	REQUEST_BURST_BUFFER_STATUS,
 	RESPONSE_BURST_BUFFER_STATUS,
+	REQUEST_CTLD_PROFILE,
+	RESPONSE_CTLD_PROFILE,
+	REQUEST_STATE_REPLICA,
+	REQUEST_CTLD_EVENTS,
+	RESPONSE_CTLD_EVENTS,
 
 	REQUEST_CRONTAB = 2200,
 	RESPONSE_CRONTAB,
@@ -345,6 +351,9 @@ typedef enum {
 	RESPONSE_HET_JOB_ALLOCATION,
 	REQUEST_HET_JOB_ALLOC_INFO,
 	REQUEST_SUBMIT_BATCH_HET_JOB,
+	REQUEST_SUBMIT_BATCH_JOBS,
+	RESPONSE_SUBMIT_BATCH_JOBS,		/* 4030 */
+	REQUEST_JOB_WAIT_NOTIFY,
 
 	REQUEST_CTLD_MULT_MSG = 4500,
 	RESPONSE_CTLD_MULT_MSG,
@@ -416,6 +425,7 @@ typedef enum {
 	REQUEST_LAUNCH_PROLOG,
 	REQUEST_COMPLETE_PROLOG,
 	RESPONSE_PROLOG_EXECUTING,	/* 6019 */
+	REQUEST_KILL_JOB_LIST,		/* 6020 */
 
 	REQUEST_PERSIST_INIT = 6500,
 
@@ -473,6 +483,7 @@ typedef struct slurm_protocol_header {
 	forward_t forward;
 	slurm_addr_t orig_addr;
 	List ret_list;
+	uint64_t trace_id;	/* see src/common/trace.h */
 } header_t;
 
 typedef struct forward_struct {
@@ -517,6 +528,7 @@ typedef struct slurm_msg {
 				 * slurm_msg_t_init() was not called since
 				 * auth_uid would be root.
 				 */
+	uint32_t auth_time;	/* DON'T PACK: usec spent verifying auth_cred */
 	uint32_t body_offset; /* DON'T PACK: offset in buffer where body part of
 				 buffer starts. */
 	buf_t *buffer;		/* DON'T PACK! ptr to buffer that msg was
@@ -544,6 +556,10 @@ typedef struct slurm_msg {
 	forward_struct_t *forward_struct;
 	slurm_addr_t orig_addr;
 	List ret_list;
+	uint64_t trace_id;	/* DON'T PACK: sent in the header. Trace id of
+				 * the sender, or set by the sender thread
+				 * if zero */
+	mpsc_link_t queue_link;	/* DON'T PACK: link in slurmctld RPC queue */
 } slurm_msg_t;
 
 typedef struct ret_data_info {
@@ -628,12 +644,19 @@ typedef struct job_notify_msg {
 	slurm_step_id_t step_id;
 } job_notify_msg_t;
 
+typedef struct job_wait_notify_msg {
+	uint32_t job_cnt;	/* number of job_ids */
+	uint32_t *job_ids;	/* jobs to be notified about */
+	uint16_t port;		/* port on the sending host to notify */
+} job_wait_notify_msg_t;
+
 typedef struct job_id_msg {
 	uint32_t job_id;
 	uint16_t show_flags;
 } job_id_msg_t;
 
 typedef struct job_user_id_msg {
+	time_t last_update;
 	uint32_t user_id;
 	uint16_t show_flags;
 } job_user_id_msg_t;
@@ -643,6 +666,7 @@ typedef struct job_info_request_msg {
 	uint16_t show_flags;
 	List   job_ids;		/* Optional list of job_ids, otherwise show all
 				 * jobs. */
+	info_filter_t filter;	/* Records to pack when job_ids is NULL */
 } job_info_request_msg_t;
 
 typedef struct job_step_info_request_msg {
@@ -654,6 +678,7 @@ typedef struct job_step_info_request_msg {
 typedef struct node_info_request_msg {
 	time_t last_update;
 	uint16_t show_flags;
+	info_filter_t filter;	/* Nodes to report, others are hidden */
 } node_info_request_msg_t;
 
 typedef struct node_info_single_msg {
@@ -686,6 +711,7 @@ typedef struct complete_batch_script {
 	uint32_t slurm_rc;
 	char *node_name;
 	uint32_t user_id;	/* user the job runs as */
+	uint64_t launch_time[JOB_LAUNCH_STAGE_CNT]; /* node side stages only */
 } complete_batch_script_msg_t;
 
 typedef struct complete_prolog {
@@ -960,6 +986,13 @@ typedef struct control_status_msg {
 	time_t control_time;	/* Time we became primary slurmctld (or 0) */
 } control_status_msg_t;
 
+typedef struct state_replica_msg {
+	char *data;		/* state file contents */
+	time_t mtime;		/* modification time of the state file */
+	char *name;		/* state file name, e.g. "job_state" */
+	uint32_t size;		/* bytes of data */
+} state_replica_msg_t;
+
 /*
  * Note: We include the node list here for reliable cleanup on XCPU systems.
  *
@@ -1000,6 +1033,15 @@ typedef struct kill_job_msg {
 	time_t   time;		/* slurmctld's time of request */
 } kill_job_msg_t;
 
+/* Several kill_job_msg_t of the same type bound for the same nodes */
+typedef struct kill_job_list_msg {
+	uint32_t count;			/* elements in kill_msgs */
+	kill_job_msg_t **kill_msgs;
+	uint16_t kill_msg_type;		/* REQUEST_TERMINATE_JOB,
+					 * REQUEST_KILL_TIMELIMIT or
+					 * REQUEST_KILL_PREEMPTED */
+} kill_job_list_msg_t;
+
 typedef struct reattach_tasks_request_msg {
 	uint16_t     num_resp_port;
 	uint16_t    *resp_port; /* array of available response ports */
@@ -1110,6 +1152,8 @@ typedef struct batch_job_launch_msg {
 	char *tres_bind;	/* task binding to TRES (e.g. GPUs),
 				 * included for possible future use */
 	char *tres_freq;	/* frequency/power for TRES (e.g. GPUs) */
+	uint64_t launch_time[JOB_LAUNCH_STAGE_CNT]; /* set by slurmd for
+				 * slurmstepd, see enum job_launch_stages */
 } batch_job_launch_msg_t;
 
 typedef struct job_id_request_msg {
@@ -1183,6 +1227,7 @@ typedef struct file_bcast_msg {
 	uint32_t uncomp_len;	/* uncompressed length of this data block */
 	char *block;		/* data for this block */
 	uint64_t file_size;	/* file size */
+	uint64_t file_hash;	/* content hash of the whole file, 0 if unset */
 } file_bcast_msg_t;
 
 typedef struct multi_core_data {
@@ -1237,6 +1282,16 @@ typedef struct bb_status_resp_msg {
 	char *status_resp;
 } bb_status_resp_msg_t;
 
+typedef struct ctld_profile_msg {
+	char *folded;	/* folded stacks, see profiler_dump() */
+} ctld_profile_msg_t;
+
+typedef struct ctld_event_req_msg {
+	ctld_event_filter_t filter;
+	uint64_t since_seq;	/* see slurm_load_ctld_events() */
+	uint16_t wait;		/* seconds to wait for a matching event */
+} ctld_event_req_msg_t;
+
 typedef struct {
 	uint32_t uid;
 } crontab_request_msg_t;
@@ -1311,9 +1366,13 @@ typedef struct {
 	uint16_t data_type;	/* date type to unpack */
 	uint16_t data_version;	/* Version that data is packed with */
 	uint64_t fed_siblings;	/* sibling bitmap of job */
+	uint32_t idle_nodes;	/* idle nodes of sending cluster, with
+				 * FED_SIB_LOAD */
 	uint32_t job_id;	/* job_id of job - set in job_desc on receiving
 				 * side */
 	uint32_t job_state;     /* state of job */
+	uint32_t pending_jobs;	/* pending jobs of sending cluster, with
+				 * FED_SIB_LOAD */
 	uint32_t return_code;   /* return code of job */
 	time_t   start_time;    /* time sibling job started */
 	char    *resp_host;     /* response host for interactive allocations */
@@ -1403,6 +1462,7 @@ extern void slurm_free_last_update_msg(last_update_msg_t * msg);
 extern void slurm_free_return_code_msg(return_code_msg_t * msg);
 extern void slurm_free_reroute_msg(reroute_msg_t *msg);
 extern void slurm_free_job_alloc_info_msg(job_alloc_info_msg_t * msg);
+extern void slurm_free_info_filter_members(info_filter_t *filter);
 extern void slurm_free_job_info_request_msg(job_info_request_msg_t *msg);
 extern void slurm_free_job_step_info_request_msg(
 		job_step_info_request_msg_t *msg);
@@ -1494,6 +1554,7 @@ extern void slurm_free_reattach_tasks_request_msg(
 extern void slurm_free_reattach_tasks_response_msg(
 		reattach_tasks_response_msg_t * msg);
 extern void slurm_free_kill_job_msg(kill_job_msg_t * msg);
+extern void slurm_free_kill_job_list_msg(kill_job_list_msg_t *msg);
 extern void slurm_free_job_step_kill_msg(job_step_kill_msg_t * msg);
 extern void slurm_free_epilog_complete_msg(epilog_complete_msg_t * msg);
 extern void slurm_free_srun_job_complete_msg(srun_job_complete_msg_t * msg);
@@ -1518,6 +1579,8 @@ extern void slurm_free_job_step_create_response_msg(
 		job_step_create_response_msg_t * msg);
 extern void slurm_free_submit_response_response_msg(
 		submit_response_msg_t * msg);
+extern void slurm_free_submit_batch_jobs_response_msg(
+		submit_batch_jobs_response_msg_t *msg);
 extern void slurm_free_ctl_conf(slurm_ctl_conf_info_msg_t * config_ptr);
 extern void slurm_free_job_info_msg(job_info_msg_t * job_buffer_ptr);
 extern void slurm_free_job_step_info_response_msg(
@@ -1545,6 +1608,7 @@ extern void slurm_free_acct_gather_node_resp_msg(
 extern void slurm_free_acct_gather_energy_req_msg(
 	acct_gather_energy_req_msg_t *msg);
 extern void slurm_free_job_notify_msg(job_notify_msg_t * msg);
+extern void slurm_free_job_wait_notify_msg(job_wait_notify_msg_t *msg);
 extern void slurm_free_ctld_multi_msg(ctld_list_msg_t *msg);
 
 extern void slurm_free_accounting_update_msg(accounting_update_msg_t *msg);
@@ -1557,9 +1621,13 @@ extern void slurm_free_network_callerid_resp(network_callerid_resp_t *resp);
 extern void slurm_free_set_fs_dampening_factor_msg(
 	set_fs_dampening_factor_msg_t *msg);
 extern void slurm_free_control_status_msg(control_status_msg_t *msg);
+extern void slurm_free_state_replica_msg(state_replica_msg_t *msg);
 
 extern void slurm_free_bb_status_req_msg(bb_status_req_msg_t *msg);
 extern void slurm_free_bb_status_resp_msg(bb_status_resp_msg_t *msg);
+extern void slurm_free_ctld_profile_msg(ctld_profile_msg_t *msg);
+extern void slurm_free_ctld_event_req_msg(ctld_event_req_msg_t *msg);
+extern void slurm_free_ctld_event_members(ctld_event_t *event);
 
 extern void slurm_free_crontab_request_msg(crontab_request_msg_t *msg);
 extern void slurm_free_crontab_response_msg(crontab_response_msg_t *msg);
@@ -1583,6 +1651,7 @@ extern uint16_t bb_state_num(char *tok);
  * Caller must xfree() the return value */
 extern char *health_check_node_state_str(uint32_t node_state);
 
+extern char *job_launch_stage_string(enum job_launch_stages inx);
 extern char *job_reason_string(enum job_state_reason inx);
 extern enum job_state_reason job_reason_num(char *reason);
 extern bool job_state_qos_grp_limit(enum job_state_reason state_reason);
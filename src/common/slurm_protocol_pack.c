@@ -80,6 +80,7 @@
 #define _pack_assoc_mgr_info_msg(msg,buf)      _pack_buffer_msg(msg,buf)
 
 static int _unpack_node_info_members(node_info_t *node, buf_t *buffer,
+				     pack_str_dict_t *dict,
 				     uint16_t protocol_version);
 
 static int _unpack_front_end_info_members(front_end_info_t *front_end,
@@ -143,6 +144,8 @@ void pack_header(header_t *header, buf_t *buffer)
 				       header->version);
 		}
 		slurm_pack_addr(&header->orig_addr, buffer);
+		if (header->version >= SLURM_21_08_PROTOCOL_VERSION)
+			pack64(header->trace_id, buffer);
 	} else if (header->version >= SLURM_MIN_PROTOCOL_VERSION) {
 		pack16(header->flags, buffer);
 		pack16(header->msg_index, buffer);
@@ -200,6 +203,8 @@ int unpack_header(header_t *header, buf_t *buffer)
 			header->ret_list = NULL;
 		}
 		slurm_unpack_addr_no_alloc(&header->orig_addr, buffer);
+		if (header->version >= SLURM_21_08_PROTOCOL_VERSION)
+			safe_unpack64(&header->trace_id, buffer);
 	} else if (header->version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack16(&header->flags, buffer);
 		safe_unpack16(&header->msg_index, buffer);
@@ -1658,11 +1663,56 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static void
+_pack_submit_batch_jobs_response_msg(submit_batch_jobs_response_msg_t *msg,
+				     buf_t *buffer, uint16_t protocol_version)
+{
+	xassert(msg);
+
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		pack32_array(msg->error_code, msg->job_cnt, buffer);
+		pack32_array(msg->job_id, msg->job_cnt, buffer);
+	}
+}
+
+static int
+_unpack_submit_batch_jobs_response_msg(submit_batch_jobs_response_msg_t **msg,
+				       buf_t *buffer,
+				       uint16_t protocol_version)
+{
+	submit_batch_jobs_response_msg_t *tmp_ptr;
+	uint32_t uint32_tmp;
+
+	xassert(msg);
+	tmp_ptr = xmalloc(sizeof(submit_batch_jobs_response_msg_t));
+	*msg = tmp_ptr;
+
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		safe_unpack32_array(&tmp_ptr->error_code, &tmp_ptr->job_cnt,
+				    buffer);
+		safe_unpack32_array(&tmp_ptr->job_id, &uint32_tmp, buffer);
+		if (uint32_tmp != tmp_ptr->job_cnt)
+			goto unpack_error;
+	} else {
+		error("%s: protocol_version %hu not supported", __func__,
+		      protocol_version);
+		goto unpack_error;
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_submit_batch_jobs_response_msg(tmp_ptr);
+	*msg = NULL;
+	return SLURM_ERROR;
+}
+
 static int _unpack_node_info_msg(node_info_msg_t **msg, buf_t *buffer,
 				 uint16_t protocol_version)
 {
 	int i;
 	node_info_msg_t *tmp_ptr;
+	pack_str_dict_t *dict = NULL;
 
 	xassert(msg);
 	tmp_ptr = xmalloc(sizeof(node_info_msg_t));
@@ -1676,10 +1726,13 @@ static int _unpack_node_info_msg(node_info_msg_t **msg, buf_t *buffer,
 		safe_xcalloc(tmp_ptr->node_array, tmp_ptr->record_count,
 			     sizeof(node_info_t));
 
+		if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION)
+			dict = pack_str_dict_create();
+
 		/* load individual job info */
 		for (i = 0; i < tmp_ptr->record_count; i++) {
 			if (_unpack_node_info_members(&tmp_ptr->node_array[i],
-						      buffer,
+						      buffer, dict,
 						      protocol_version))
 				goto unpack_error;
 		}
@@ -1688,9 +1741,11 @@ static int _unpack_node_info_msg(node_info_msg_t **msg, buf_t *buffer,
 		      __func__, protocol_version);
 		goto unpack_error;
 	}
+	pack_str_dict_destroy(dict);
 	return SLURM_SUCCESS;
 
 unpack_error:
+	pack_str_dict_destroy(dict);
 	slurm_free_node_info_msg(tmp_ptr);
 	*msg = NULL;
 	return SLURM_ERROR;
@@ -1698,14 +1753,78 @@ unpack_error:
 
 static int
 _unpack_node_info_members(node_info_t * node, buf_t *buffer,
-			  uint16_t protocol_version)
+			  pack_str_dict_t *dict, uint16_t protocol_version)
 {
 	uint32_t uint32_tmp;
 
 	xassert(node);
 	slurm_init_node_info_t(node, false);
 
-	if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		safe_unpackstr_dict(&node->name, dict, buffer);
+		safe_unpackstr_dict(&node->node_hostname, dict, buffer);
+		safe_unpackstr_dict(&node->node_addr, dict, buffer);
+		safe_unpackstr_dict(&node->bcast_address, dict, buffer);
+		safe_unpack16(&node->port, buffer);
+		safe_unpack32(&node->next_state, buffer);
+		safe_unpack32(&node->node_state, buffer);
+		safe_unpackstr_dict(&node->version, dict, buffer);
+
+		safe_unpack16(&node->cpus, buffer);
+		safe_unpack16(&node->boards, buffer);
+		safe_unpack16(&node->sockets, buffer);
+		safe_unpack16(&node->cores, buffer);
+		safe_unpack16(&node->threads, buffer);
+
+		safe_unpack64(&node->real_memory, buffer);
+		safe_unpack32(&node->tmp_disk, buffer);
+
+		safe_unpackstr_dict(&node->mcs_label, dict, buffer);
+		safe_unpack32(&node->owner, buffer);
+		safe_unpack16(&node->core_spec_cnt, buffer);
+		safe_unpack32(&node->cpu_bind, buffer);
+		safe_unpack64(&node->mem_spec_limit, buffer);
+		safe_unpackstr_dict(&node->cpu_spec_list, dict, buffer);
+
+		safe_unpack32(&node->cpu_load, buffer);
+		safe_unpack64(&node->free_mem, buffer);
+		safe_unpack32(&node->weight, buffer);
+		safe_unpack32(&node->reason_uid, buffer);
+
+		safe_unpack_time(&node->boot_time, buffer);
+		safe_unpack_time(&node->reason_time, buffer);
+		safe_unpack_time(&node->slurmd_start_time, buffer);
+
+		if (select_g_select_nodeinfo_unpack(&node->select_nodeinfo,
+						    buffer, protocol_version)
+		    != SLURM_SUCCESS)
+			goto unpack_error;
+
+		safe_unpackstr_dict(&node->arch, dict, buffer);
+		safe_unpackstr_dict(&node->features, dict, buffer);
+		safe_unpackstr_dict(&node->features_act, dict, buffer);
+		if (!node->features_act)
+			node->features_act = xstrdup(node->features);
+		safe_unpackstr_dict(&node->gres, dict, buffer);
+		safe_unpackstr_dict(&node->gres_drain, dict, buffer);
+		safe_unpackstr_dict(&node->gres_used, dict, buffer);
+		safe_unpackstr_dict(&node->os, dict, buffer);
+		safe_unpackstr_dict(&node->comment, dict, buffer);
+		safe_unpackstr_dict(&node->reason, dict, buffer);
+		if (acct_gather_energy_unpack(&node->energy, buffer,
+					      protocol_version, 1)
+		    != SLURM_SUCCESS)
+			goto unpack_error;
+		if (ext_sensors_data_unpack(&node->ext_sensors, buffer,
+					    protocol_version)
+		    != SLURM_SUCCESS)
+			goto unpack_error;
+		if (power_mgmt_data_unpack(&node->power, buffer,
+					   protocol_version) != SLURM_SUCCESS)
+			goto unpack_error;
+
+		safe_unpackstr_dict(&node->tres_fmt_str, dict, buffer);
+	} else if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
 		safe_unpackstr_xmalloc(&node->name, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&node->node_hostname, &uint32_tmp,
 				       buffer);
@@ -2286,6 +2405,53 @@ extern int slurm_pack_list(List send_list,
 	return rc;
 }
 
+/*
+ * Same as slurm_pack_list(), but each object is removed from send_list and
+ * freed with destroy_function as soon as it has been packed. Used for large
+ * replies so that the list and the packed buffer never both hold the whole
+ * result. Objects left unpacked on error remain in send_list.
+ */
+extern int slurm_pack_list_consume(List send_list,
+				   void (*pack_function) (void *object,
+							  uint16_t protocol_version,
+							  buf_t *buffer),
+				   void (*destroy_function) (void *object),
+				   buf_t *buffer, uint16_t protocol_version)
+{
+	uint32_t count = 0;
+	uint32_t header_position;
+	int rc = SLURM_SUCCESS;
+	void *object;
+
+	if (!send_list) {
+		// to let user know there wasn't a list (error)
+		pack32(NO_VAL, buffer);
+		return rc;
+	}
+
+	header_position = get_buf_offset(buffer);
+
+	count = list_count(send_list);
+	pack32(count, buffer);
+
+	while ((object = list_pop(send_list))) {
+		(*(pack_function))(object, protocol_version, buffer);
+		(*(destroy_function))(object);
+		if (size_buf(buffer) > REASONABLE_BUF_SIZE) {
+			error("%s: size limit exceeded", __func__);
+			/*
+			 * rewind buffer, pack NO_VAL as count instead
+			 */
+			set_buf_offset(buffer, header_position);
+			pack32(NO_VAL, buffer);
+			rc = ESLURM_RESULT_TOO_LARGE;
+			break;
+		}
+	}
+
+	return rc;
+}
+
 extern int slurm_unpack_list(List *recv_list,
 			     int (*unpack_function) (void **object,
 						     uint16_t protocol_version,
@@ -2681,6 +2847,57 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static void _pack_kill_job_list_msg(kill_job_list_msg_t *msg, buf_t *buffer,
+				    uint16_t protocol_version)
+{
+	int i;
+
+	xassert(msg);
+
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		pack16(msg->kill_msg_type, buffer);
+		pack32(msg->count, buffer);
+		for (i = 0; i < msg->count; i++)
+			_pack_kill_job_msg(msg->kill_msgs[i], buffer,
+					   protocol_version);
+	}
+}
+
+static int _unpack_kill_job_list_msg(kill_job_list_msg_t **msg,
+				     buf_t *buffer, uint16_t protocol_version)
+{
+	int i;
+	uint32_t count;
+	kill_job_list_msg_t *tmp_ptr;
+
+	xassert(msg);
+	tmp_ptr = xmalloc(sizeof(kill_job_list_msg_t));
+	*msg = tmp_ptr;
+
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		safe_unpack16(&tmp_ptr->kill_msg_type, buffer);
+		safe_unpack32(&count, buffer);
+		safe_xcalloc(tmp_ptr->kill_msgs, count,
+			     sizeof(kill_job_msg_t *));
+		for (i = 0; i < count; i++) {
+			if (_unpack_kill_job_msg(&tmp_ptr->kill_msgs[i],
+						 buffer, protocol_version))
+				goto unpack_error;
+			tmp_ptr->count++;
+		}
+	} else {
+		error("%s: protocol_version %hu not supported", __func__,
+		      protocol_version);
+		goto unpack_error;
+	}
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_kill_job_list_msg(tmp_ptr);
+	*msg = NULL;
+	return SLURM_ERROR;
+}
+
 static void
 _pack_epilog_comp_msg(epilog_complete_msg_t * msg, buf_t *buffer,
 		      uint16_t protocol_version)
@@ -2911,7 +3128,8 @@ _unpack_partition_info_members(partition_info_t * part, buf_t *buffer,
 				       buffer);
 		safe_unpackstr_xmalloc(&part->nodes, &uint32_tmp, buffer);
 
-		unpack_bit_str_hex_as_inx(&part->node_inx, buffer);
+		unpack_bit_str_as_inx(&part->node_inx, buffer,
+				      protocol_version);
 
 		safe_unpackstr_xmalloc(&part->billing_weights_str, &uint32_tmp,
 				       buffer);
@@ -2999,7 +3217,8 @@ _unpack_reserve_info_members(reserve_info_t * resv, buf_t *buffer,
 		safe_unpackstr_xmalloc(&resv->users,	&uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&resv->groups,	&uint32_tmp, buffer);
 
-		unpack_bit_str_hex_as_inx(&resv->node_inx, buffer);
+		unpack_bit_str_as_inx(&resv->node_inx, buffer,
+				      protocol_version);
 
 		safe_unpack32(&resv->core_spec_cnt,        buffer);
 		if (resv->core_spec_cnt > 0) {
@@ -3032,7 +3251,8 @@ _unpack_reserve_info_members(reserve_info_t * resv, buf_t *buffer,
 		safe_unpackstr_xmalloc(&resv->tres_str, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&resv->users,	&uint32_tmp, buffer);
 
-		unpack_bit_str_hex_as_inx(&resv->node_inx, buffer);
+		unpack_bit_str_as_inx(&resv->node_inx, buffer,
+				      protocol_version);
 
 		safe_unpack32(&resv->core_spec_cnt,        buffer);
 		if (resv->core_spec_cnt > 0) {
@@ -3096,7 +3316,8 @@ _unpack_job_step_info_members(job_step_info_t * step, buf_t *buffer,
 		safe_unpackstr_xmalloc(&step->nodes, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&step->name, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&step->network, &uint32_tmp, buffer);
-		unpack_bit_str_hex_as_inx(&step->node_inx, buffer);
+		unpack_bit_str_as_inx(&step->node_inx, buffer,
+				      protocol_version);
 
 		if (select_g_select_jobinfo_unpack(&step->select_jobinfo,
 						   buffer, protocol_version))
@@ -3148,7 +3369,8 @@ _unpack_job_step_info_members(job_step_info_t * step, buf_t *buffer,
 		safe_unpackstr_xmalloc(&step->nodes, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&step->name, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&step->network, &uint32_tmp, buffer);
-		unpack_bit_str_hex_as_inx(&step->node_inx, buffer);
+		unpack_bit_str_as_inx(&step->node_inx, buffer,
+				      protocol_version);
 
 		if (select_g_select_jobinfo_unpack(&step->select_jobinfo,
 						   buffer, protocol_version))
@@ -3293,6 +3515,28 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/*
+ * Unpack an array of launch stage times packed with pack64_array(), ignoring
+ * any stages unknown to this version
+ * OUT launch_time - array of JOB_LAUNCH_STAGE_CNT elements
+ */
+static int _unpack_launch_time(uint64_t *launch_time, buf_t *buffer)
+{
+	uint64_t *tmp = NULL;
+	uint32_t cnt = 0;
+
+	safe_unpack64_array(&tmp, &cnt, buffer);
+	if (cnt)
+		memcpy(launch_time, tmp,
+		       sizeof(uint64_t) * MIN(cnt, JOB_LAUNCH_STAGE_CNT));
+	xfree(tmp);
+	return SLURM_SUCCESS;
+
+unpack_error:
+	xfree(tmp);
+	return SLURM_ERROR;
+}
+
 /* _unpack_job_info_members
  * unpacks a set of slurm job info for one job
  * OUT job - pointer to the job info buffer
@@ -3397,7 +3641,7 @@ _unpack_job_info_members(job_info_t * job, buf_t *buffer,
 
 		safe_unpackstr_xmalloc(&job->alloc_node, &uint32_tmp, buffer);
 
-		unpack_bit_str_hex_as_inx(&job->node_inx, buffer);
+		unpack_bit_str_as_inx(&job->node_inx, buffer, protocol_version);
 
 		if (select_g_select_jobinfo_unpack(&job->select_jobinfo,
 						   buffer, protocol_version))
@@ -3437,11 +3681,13 @@ _unpack_job_info_members(job_info_t * job, buf_t *buffer,
 		safe_unpack32(&job->pn_min_tmp_disk, buffer);
 		safe_unpackstr_xmalloc(&job->req_nodes, &uint32_tmp, buffer);
 
-		unpack_bit_str_hex_as_inx(&job->req_node_inx, buffer);
+		unpack_bit_str_as_inx(&job->req_node_inx, buffer,
+				      protocol_version);
 
 		safe_unpackstr_xmalloc(&job->exc_nodes, &uint32_tmp, buffer);
 
-		unpack_bit_str_hex_as_inx(&job->exc_node_inx, buffer);
+		unpack_bit_str_as_inx(&job->exc_node_inx, buffer,
+				      protocol_version);
 
 		safe_unpackstr_xmalloc(&job->std_err, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&job->std_in, &uint32_tmp, buffer);
@@ -3494,6 +3740,10 @@ _unpack_job_info_members(job_info_t * job, buf_t *buffer,
 
 		safe_unpack16(&job->mail_type, buffer);
 		safe_unpackstr_xmalloc(&job->mail_user, &uint32_tmp, buffer);
+
+		if ((protocol_version >= SLURM_21_08_PROTOCOL_VERSION) &&
+		    _unpack_launch_time(job->launch_time, buffer))
+			goto unpack_error;
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack32(&job->array_job_id, buffer);
 		safe_unpack32(&job->array_task_id, buffer);
@@ -3585,7 +3835,7 @@ _unpack_job_info_members(job_info_t * job, buf_t *buffer,
 
 		safe_unpackstr_xmalloc(&job->alloc_node, &uint32_tmp, buffer);
 
-		unpack_bit_str_hex_as_inx(&job->node_inx, buffer);
+		unpack_bit_str_as_inx(&job->node_inx, buffer, protocol_version);
 
 		if (select_g_select_jobinfo_unpack(&job->select_jobinfo,
 						   buffer, protocol_version))
@@ -3623,11 +3873,13 @@ _unpack_job_info_members(job_info_t * job, buf_t *buffer,
 		safe_unpack32(&job->pn_min_tmp_disk, buffer);
 		safe_unpackstr_xmalloc(&job->req_nodes, &uint32_tmp, buffer);
 
-		unpack_bit_str_hex_as_inx(&job->req_node_inx, buffer);
+		unpack_bit_str_as_inx(&job->req_node_inx, buffer,
+				      protocol_version);
 
 		safe_unpackstr_xmalloc(&job->exc_nodes, &uint32_tmp, buffer);
 
-		unpack_bit_str_hex_as_inx(&job->exc_node_inx, buffer);
+		unpack_bit_str_as_inx(&job->exc_node_inx, buffer,
+				      protocol_version);
 
 		safe_unpackstr_xmalloc(&job->std_err, &uint32_tmp, buffer);
 		safe_unpackstr_xmalloc(&job->std_in,  &uint32_tmp, buffer);
@@ -5140,6 +5392,10 @@ _pack_sib_msg(sib_msg_t *sib_msg_ptr, buf_t *buffer, uint16_t protocol_version)
 		pack32(sib_msg_ptr->req_uid, buffer);
 		pack16(sib_msg_ptr->sib_msg_type, buffer);
 		packstr(sib_msg_ptr->submit_host, buffer);
+		if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+			pack32(sib_msg_ptr->idle_nodes, buffer);
+			pack32(sib_msg_ptr->pending_jobs, buffer);
+		}
 
 		/* add already packed data_buffer to buffer */
 		if (sib_msg_ptr->data_buffer &&
@@ -5193,6 +5449,10 @@ _unpack_sib_msg(sib_msg_t **sib_msg_buffer_ptr, buf_t *buffer,
 		safe_unpack16(&sib_msg_ptr->sib_msg_type, buffer);
 		safe_unpackstr_xmalloc(&sib_msg_ptr->submit_host, &tmp_uint32,
 				       buffer);
+		if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+			safe_unpack32(&sib_msg_ptr->idle_nodes, buffer);
+			safe_unpack32(&sib_msg_ptr->pending_jobs, buffer);
+		}
 
 		safe_unpack16(&tmp_uint16, buffer);
 		if (tmp_uint16) {
@@ -7871,6 +8131,9 @@ _pack_complete_batch_script_msg(
 		pack32(msg->slurm_rc, buffer);
 		pack32(msg->user_id, buffer);
 		packstr(msg->node_name, buffer);
+		if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION)
+			pack64_array(msg->launch_time, JOB_LAUNCH_STAGE_CNT,
+				     buffer);
 	}
 }
 
@@ -7895,6 +8158,9 @@ _unpack_complete_batch_script_msg(
 		safe_unpack32(&msg->slurm_rc, buffer);
 		safe_unpack32(&msg->user_id, buffer);
 		safe_unpackstr_xmalloc(&msg->node_name, &uint32_tmp, buffer);
+		if ((protocol_version >= SLURM_21_08_PROTOCOL_VERSION) &&
+		    _unpack_launch_time(msg->launch_time, buffer))
+			goto unpack_error;
 	} else {
 		error("_unpack_complete_batch_script_msg: protocol_version "
 		      "%hu not supported", protocol_version);
@@ -8046,6 +8312,30 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static void _pack_info_filter(info_filter_t *filter, buf_t *buffer)
+{
+	packstr(filter->accounts, buffer);
+	packstr(filter->nodes, buffer);
+	packstr(filter->partitions, buffer);
+	packstr(filter->states, buffer);
+	packstr(filter->users, buffer);
+}
+
+static int _unpack_info_filter(info_filter_t *filter, buf_t *buffer)
+{
+	uint32_t uint32_tmp;
+
+	safe_unpackstr_xmalloc(&filter->accounts, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&filter->nodes, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&filter->partitions, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&filter->states, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&filter->users, &uint32_tmp, buffer);
+	return SLURM_SUCCESS;
+
+unpack_error:
+	return SLURM_ERROR;
+}
+
 static void
 _pack_job_info_request_msg(job_info_request_msg_t * msg, buf_t *buffer,
 			   uint16_t protocol_version)
@@ -8072,6 +8362,9 @@ _pack_job_info_request_msg(job_info_request_msg_t * msg, buf_t *buffer,
 			list_iterator_destroy(itr);
 		}
 	}
+
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION)
+		_pack_info_filter(&msg->filter, buffer);
 }
 
 static int
@@ -8103,6 +8396,9 @@ _unpack_job_info_request_msg(job_info_request_msg_t** msg,
 				uint32_ptr = NULL;
 			}
 		}
+		if ((protocol_version >= SLURM_21_08_PROTOCOL_VERSION) &&
+		    _unpack_info_filter(&job_info->filter, buffer))
+			goto unpack_error;
 	} else {
 		error("%s: protocol_version %hu not supported",
 		      __func__, protocol_version);
@@ -8306,6 +8602,8 @@ _pack_node_info_request_msg(node_info_request_msg_t * msg, buf_t *buffer,
 {
 	pack_time(msg->last_update, buffer);
 	pack16(msg->show_flags, buffer);
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION)
+		_pack_info_filter(&msg->filter, buffer);
 }
 
 static int
@@ -8319,6 +8617,9 @@ _unpack_node_info_request_msg(node_info_request_msg_t ** msg, buf_t *buffer,
 
 	safe_unpack_time(&node_info->last_update, buffer);
 	safe_unpack16(&node_info->show_flags, buffer);
+	if ((protocol_version >= SLURM_21_08_PROTOCOL_VERSION) &&
+	    _unpack_info_filter(&node_info->filter, buffer))
+		goto unpack_error;
 	return SLURM_SUCCESS;
 
 unpack_error:
@@ -8651,6 +8952,9 @@ _pack_batch_job_launch_msg(batch_job_launch_msg_t * msg, buf_t *buffer,
 		pack32(msg->profile, buffer);
 		packstr(msg->tres_bind, buffer);
 		packstr(msg->tres_freq, buffer);
+		if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION)
+			pack64_array(msg->launch_time, JOB_LAUNCH_STAGE_CNT,
+				     buffer);
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		pack32(msg->job_id, buffer);
 		pack32(msg->het_job_id, buffer);
@@ -8835,6 +9139,9 @@ _unpack_batch_job_launch_msg(batch_job_launch_msg_t ** msg, buf_t *buffer,
 				       buffer);
 		safe_unpackstr_xmalloc(&launch_msg_ptr->tres_freq, &uint32_tmp,
 				       buffer);
+		if ((protocol_version >= SLURM_21_08_PROTOCOL_VERSION) &&
+		    _unpack_launch_time(launch_msg_ptr->launch_time, buffer))
+			goto unpack_error;
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		char *temp_str;
 
@@ -9406,8 +9713,14 @@ _pack_job_user_msg(job_user_id_msg_t * msg, buf_t *buffer,
 {
 	xassert(msg);
 
-	pack32(msg->user_id  , buffer ) ;
-	pack16(msg->show_flags, buffer);
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		pack_time(msg->last_update, buffer);
+		pack32(msg->user_id, buffer);
+		pack16(msg->show_flags, buffer);
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+		pack32(msg->user_id, buffer);
+		pack16(msg->show_flags, buffer);
+	}
 }
 
 static int
@@ -9420,8 +9733,16 @@ _unpack_job_user_msg(job_user_id_msg_t ** msg_ptr, buf_t *buffer,
 	msg = xmalloc ( sizeof (job_user_id_msg_t) );
 	*msg_ptr = msg ;
 
-	safe_unpack32(&msg->user_id  , buffer ) ;
-	safe_unpack16(&msg->show_flags, buffer);
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		safe_unpack_time(&msg->last_update, buffer);
+		safe_unpack32(&msg->user_id, buffer);
+		safe_unpack16(&msg->show_flags, buffer);
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+		safe_unpack32(&msg->user_id, buffer);
+		safe_unpack16(&msg->show_flags, buffer);
+	} else
+		goto unpack_error;
+
 	return SLURM_SUCCESS;
 
 unpack_error:
@@ -9754,7 +10075,29 @@ static void _pack_file_bcast(file_bcast_msg_t * msg , buf_t *buffer,
 
 	grow_buf(buffer,  msg->block_len);
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		pack32(msg->block_no, buffer);
+		pack16(msg->compress, buffer);
+		pack16(msg->last_block, buffer);
+		pack16(msg->force, buffer);
+		pack16(msg->modes, buffer);
+
+		pack32(msg->uid, buffer);
+		packstr(msg->user_name, buffer);
+		pack32(msg->gid, buffer);
+
+		pack_time(msg->atime, buffer);
+		pack_time(msg->mtime, buffer);
+
+		packstr(msg->fname, buffer);
+		pack32(msg->block_len, buffer);
+		pack32(msg->uncomp_len, buffer);
+		pack64(msg->block_offset, buffer);
+		pack64(msg->file_size, buffer);
+		pack64(msg->file_hash, buffer);
+		packmem (msg->block, msg->block_len, buffer);
+		pack_sbcast_cred(msg->cred, buffer, protocol_version);
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		pack32(msg->block_no, buffer);
 		pack16(msg->compress, buffer);
 		pack16(msg->last_block, buffer);
@@ -9789,7 +10132,34 @@ static int _unpack_file_bcast(file_bcast_msg_t ** msg_ptr , buf_t *buffer,
 	msg = xmalloc ( sizeof (file_bcast_msg_t) ) ;
 	*msg_ptr = msg;
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		safe_unpack32(&msg->block_no, buffer);
+		safe_unpack16(&msg->compress, buffer);
+		safe_unpack16(&msg->last_block, buffer);
+		safe_unpack16(&msg->force, buffer);
+		safe_unpack16(&msg->modes, buffer);
+
+		safe_unpack32(&msg->uid, buffer);
+		safe_unpackstr_xmalloc(&msg->user_name, &uint32_tmp, buffer);
+		safe_unpack32(&msg->gid, buffer);
+
+		safe_unpack_time(&msg->atime, buffer);
+		safe_unpack_time(&msg->mtime, buffer);
+
+		safe_unpackstr_xmalloc(&msg->fname, &uint32_tmp, buffer);
+		safe_unpack32(&msg->block_len, buffer);
+		safe_unpack32(&msg->uncomp_len, buffer);
+		safe_unpack64(&msg->block_offset, buffer);
+		safe_unpack64(&msg->file_size, buffer);
+		safe_unpack64(&msg->file_hash, buffer);
+		safe_unpackmem_xmalloc(&msg->block, &uint32_tmp, buffer);
+		if (uint32_tmp != msg->block_len)
+			goto unpack_error;
+
+		msg->cred = unpack_sbcast_cred(buffer, protocol_version);
+		if (msg->cred == NULL)
+			goto unpack_error;
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack32(&msg->block_no, buffer);
 		safe_unpack16(&msg->compress, buffer);
 		safe_unpack16(&msg->last_block, buffer);
@@ -10190,6 +10560,44 @@ static void _pack_job_notify(job_notify_msg_t *msg, buf_t *buffer,
 	}
 }
 
+static void _pack_job_wait_notify(job_wait_notify_msg_t *msg, buf_t *buffer,
+				  uint16_t protocol_version)
+{
+	xassert(msg);
+
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		pack32_array(msg->job_ids, msg->job_cnt, buffer);
+		pack16(msg->port, buffer);
+	}
+}
+
+static int _unpack_job_wait_notify(job_wait_notify_msg_t **msg_ptr,
+				   buf_t *buffer, uint16_t protocol_version)
+{
+	job_wait_notify_msg_t *msg;
+
+	xassert(msg_ptr);
+
+	msg = xmalloc(sizeof(job_wait_notify_msg_t));
+
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		safe_unpack32_array(&msg->job_ids, &msg->job_cnt, buffer);
+		safe_unpack16(&msg->port, buffer);
+	} else {
+		error("%s: protocol_version %hu not supported",
+		      __func__, protocol_version);
+		goto unpack_error;
+	}
+
+	*msg_ptr = msg;
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_job_wait_notify_msg(msg);
+	*msg_ptr = NULL;
+	return SLURM_ERROR;
+}
+
 static int  _unpack_job_notify(job_notify_msg_t **msg_ptr, buf_t *buffer,
 			       uint16_t protocol_version)
 {
@@ -10559,6 +10967,43 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 
 			safe_unpack32(&msg->bf_active,		buffer);
 			safe_unpack32(&msg->bf_backfilled_het_jobs, buffer);
+
+			if (protocol_version >=
+			    SLURM_21_08_PROTOCOL_VERSION) {
+				safe_unpack64(&msg->bf_phase_queue_last, buffer);
+				safe_unpack64(&msg->bf_phase_queue_sum, buffer);
+				safe_unpack64(&msg->bf_phase_running_last, buffer);
+				safe_unpack64(&msg->bf_phase_running_sum, buffer);
+				safe_unpack64(&msg->bf_phase_resv_last, buffer);
+				safe_unpack64(&msg->bf_phase_resv_sum, buffer);
+				safe_unpack64(&msg->bf_phase_sched_last, buffer);
+				safe_unpack64(&msg->bf_phase_sched_sum, buffer);
+				safe_unpack64(&msg->bf_phase_yield_last, buffer);
+				safe_unpack64(&msg->bf_phase_yield_sum, buffer);
+
+				safe_unpack32(&msg->job_launch_stage_cnt, buffer);
+				safe_unpack32(&msg->job_launch_hist_size, buffer);
+				safe_unpack32_array(&msg->job_launch_hist,
+						    &uint32_tmp, buffer);
+				if (uint32_tmp != (msg->job_launch_stage_cnt *
+						   msg->job_launch_hist_size))
+					goto unpack_error;
+				safe_unpack64_array(&msg->job_launch_sum,
+						    &uint32_tmp, buffer);
+				if (uint32_tmp != msg->job_launch_stage_cnt)
+					goto unpack_error;
+				safe_unpack64_array(&msg->job_launch_max,
+						    &uint32_tmp, buffer);
+				if (uint32_tmp != msg->job_launch_stage_cnt)
+					goto unpack_error;
+				safe_unpackstr_array(&msg->job_launch_max_node,
+						     &uint32_tmp, buffer);
+				if (uint32_tmp != msg->job_launch_stage_cnt) {
+					/* Free only the names unpacked */
+					msg->job_launch_stage_cnt = uint32_tmp;
+					goto unpack_error;
+				}
+			}
 		}
 
 		safe_unpack32(&msg->rpc_type_size,		buffer);
@@ -10587,6 +11032,67 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 				     buffer);
 		if (uint32_tmp != msg->rpc_dump_count)
 			goto unpack_error;
+
+		if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+			uint32_t lock_cnt;
+
+			safe_unpack32(&msg->lock_entity_count, buffer);
+			safe_unpack32(&msg->lock_hist_size, buffer);
+			lock_cnt = msg->lock_entity_count *
+				   msg->lock_hist_size;
+			safe_unpack32_array(&msg->lock_wait_hist, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != lock_cnt)
+				goto unpack_error;
+			safe_unpack32_array(&msg->lock_hold_hist, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != lock_cnt)
+				goto unpack_error;
+
+			safe_unpackstr_array(&msg->lock_caller_name,
+					     &msg->lock_caller_count, buffer);
+			lock_cnt = msg->lock_caller_count *
+				   msg->lock_entity_count;
+			safe_unpack32_array(&msg->lock_caller_cnt, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != lock_cnt)
+				goto unpack_error;
+			safe_unpack64_array(&msg->lock_caller_wait,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != lock_cnt)
+				goto unpack_error;
+			safe_unpack64_array(&msg->lock_caller_wait_max,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != lock_cnt)
+				goto unpack_error;
+			safe_unpack64_array(&msg->lock_caller_hold,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != lock_cnt)
+				goto unpack_error;
+			safe_unpack64_array(&msg->lock_caller_hold_max,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != lock_cnt)
+				goto unpack_error;
+
+			safe_unpack64_array(&msg->rpc_type_auth_time,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->rpc_type_size)
+				goto unpack_error;
+			safe_unpack64_array(&msg->rpc_type_lock_time,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->rpc_type_size)
+				goto unpack_error;
+			safe_unpack64_array(&msg->rpc_type_max_time,
+					    &uint32_tmp, buffer);
+			if (uint32_tmp != msg->rpc_type_size)
+				goto unpack_error;
+			safe_unpack32(&msg->rpc_hist_size, buffer);
+			safe_unpack32_array(&msg->rpc_type_hist, &uint32_tmp,
+					    buffer);
+			if (uint32_tmp != (msg->rpc_type_size *
+					   msg->rpc_hist_size))
+				goto unpack_error;
+		}
 	} else {
 		error("%s: protocol_version %hu not supported",
 		      __func__, protocol_version);
@@ -11000,6 +11506,150 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static void _pack_state_replica_msg(state_replica_msg_t *msg, buf_t *buffer,
+				    uint16_t protocol_version)
+{
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		packstr(msg->name, buffer);
+		pack_time(msg->mtime, buffer);
+		packmem(msg->data, msg->size, buffer);
+	}
+}
+
+static void _pack_ctld_event_req_msg(ctld_event_req_msg_t *msg,
+				     buf_t *buffer, uint16_t protocol_version)
+{
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		pack64(msg->since_seq, buffer);
+		pack16(msg->wait, buffer);
+		packstr(msg->filter.partition, buffer);
+		pack32(msg->filter.type_mask, buffer);
+		pack32(msg->filter.user_id, buffer);
+	}
+}
+
+static int _unpack_ctld_event_req_msg(ctld_event_req_msg_t **msg_ptr,
+				      buf_t *buffer, uint16_t protocol_version)
+{
+	ctld_event_req_msg_t *msg;
+	uint32_t uint32_tmp;
+
+	msg = xmalloc(sizeof(ctld_event_req_msg_t));
+	*msg_ptr = msg;
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		safe_unpack64(&msg->since_seq, buffer);
+		safe_unpack16(&msg->wait, buffer);
+		safe_unpackstr_xmalloc(&msg->filter.partition, &uint32_tmp,
+				       buffer);
+		safe_unpack32(&msg->filter.type_mask, buffer);
+		safe_unpack32(&msg->filter.user_id, buffer);
+	} else {
+		error("%s: protocol_version %hu not supported", __func__,
+		      protocol_version);
+		goto unpack_error;
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_ctld_event_req_msg(msg);
+	*msg_ptr = NULL;
+	return SLURM_ERROR;
+}
+
+static void _pack_ctld_event_msg(ctld_event_msg_t *msg, buf_t *buffer,
+				 uint16_t protocol_version)
+{
+	ctld_event_t *event;
+	int i;
+
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		pack64(msg->first_seq, buffer);
+		pack64(msg->next_seq, buffer);
+		pack32(msg->record_count, buffer);
+		for (i = 0; i < msg->record_count; i++) {
+			event = &msg->event_array[i];
+			pack64(event->seq, buffer);
+			pack_time(event->time, buffer);
+			pack32(event->type, buffer);
+			pack32(event->job_id, buffer);
+			pack32(event->user_id, buffer);
+			pack32(event->state, buffer);
+			packstr(event->node_name, buffer);
+			packstr(event->partition, buffer);
+		}
+	}
+}
+
+static int _unpack_ctld_event_msg(ctld_event_msg_t **msg_ptr, buf_t *buffer,
+				  uint16_t protocol_version)
+{
+	ctld_event_msg_t *msg;
+	ctld_event_t *event;
+	uint32_t count, uint32_tmp;
+	int i;
+
+	msg = xmalloc(sizeof(ctld_event_msg_t));
+	*msg_ptr = msg;
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		safe_unpack64(&msg->first_seq, buffer);
+		safe_unpack64(&msg->next_seq, buffer);
+		safe_unpack32(&count, buffer);
+		safe_xcalloc(msg->event_array, count, sizeof(ctld_event_t));
+		for (i = 0; i < count; i++) {
+			event = &msg->event_array[i];
+			msg->record_count++;
+			safe_unpack64(&event->seq, buffer);
+			safe_unpack_time(&event->time, buffer);
+			safe_unpack32(&event->type, buffer);
+			safe_unpack32(&event->job_id, buffer);
+			safe_unpack32(&event->user_id, buffer);
+			safe_unpack32(&event->state, buffer);
+			safe_unpackstr_xmalloc(&event->node_name, &uint32_tmp,
+					       buffer);
+			safe_unpackstr_xmalloc(&event->partition, &uint32_tmp,
+					       buffer);
+		}
+	} else {
+		error("%s: protocol_version %hu not supported", __func__,
+		      protocol_version);
+		goto unpack_error;
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_ctld_event_msg(msg);
+	*msg_ptr = NULL;
+	return SLURM_ERROR;
+}
+
+static int _unpack_state_replica_msg(state_replica_msg_t **msg_ptr,
+				     buf_t *buffer, uint16_t protocol_version)
+{
+	state_replica_msg_t *msg;
+	uint32_t uint32_tmp;
+
+	msg = xmalloc(sizeof(state_replica_msg_t));
+	*msg_ptr = msg;
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		safe_unpackstr_xmalloc(&msg->name, &uint32_tmp, buffer);
+		safe_unpack_time(&msg->mtime, buffer);
+		safe_unpackmem_xmalloc(&msg->data, &msg->size, buffer);
+	} else {
+		error("%s: protocol_version %hu not supported", __func__,
+		      protocol_version);
+		goto unpack_error;
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_state_replica_msg(msg);
+	*msg_ptr = NULL;
+	return SLURM_ERROR;
+}
+
 static void _pack_bb_status_req_msg(bb_status_req_msg_t *msg, buf_t *buffer,
 				    uint16_t protocol_version)
 {
@@ -11049,6 +11699,31 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static void _pack_ctld_profile_msg(ctld_profile_msg_t *msg, buf_t *buffer,
+				   uint16_t protocol_version)
+{
+	packstr(msg->folded, buffer);
+}
+
+static int _unpack_ctld_profile_msg(ctld_profile_msg_t **msg_ptr,
+				    buf_t *buffer, uint16_t protocol_version)
+{
+	uint32_t uint32_tmp = 0;
+	ctld_profile_msg_t *msg;
+	xassert(msg_ptr);
+
+	msg = xmalloc(sizeof(ctld_profile_msg_t));
+	*msg_ptr = msg;
+
+	safe_unpackstr_xmalloc(&msg->folded, &uint32_tmp, buffer);
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_ctld_profile_msg(msg);
+	*msg_ptr = NULL;
+	return SLURM_ERROR;
+}
+
 static void _pack_crontab_request_msg(const slurm_msg_t *smsg, buf_t *buffer)
 {
 	crontab_request_msg_t *msg = (crontab_request_msg_t *) smsg->data;
@@ -11259,6 +11934,7 @@ pack_msg(slurm_msg_t const *msg, buf_t *buffer)
 		break;
 	case REQUEST_HET_JOB_ALLOCATION:
 	case REQUEST_SUBMIT_BATCH_HET_JOB:
+	case REQUEST_SUBMIT_BATCH_JOBS:
 		_pack_job_desc_list_msg((List) msg->data, buffer,
 					msg->protocol_version);
 		break;
@@ -11306,6 +11982,7 @@ pack_msg(slurm_msg_t const *msg, buf_t *buffer)
 	case REQUEST_PING:
 	case REQUEST_CONTROL:
 	case REQUEST_CONTROL_STATUS:
+	case REQUEST_CTLD_PROFILE:
 	case REQUEST_TAKEOVER:
 	case REQUEST_DAEMON_STATUS:
 	case REQUEST_HEALTH_CHECK:
@@ -11345,6 +12022,11 @@ pack_msg(slurm_msg_t const *msg, buf_t *buffer)
 					  msg->data, buffer,
 					  msg->protocol_version);
 		break;
+	case RESPONSE_SUBMIT_BATCH_JOBS:
+		_pack_submit_batch_jobs_response_msg(
+			(submit_batch_jobs_response_msg_t *) msg->data, buffer,
+			msg->protocol_version);
+		break;
 	case RESPONSE_JOB_ALLOCATION_INFO:
 	case RESPONSE_RESOURCE_ALLOCATION:
 		_pack_resource_allocation_response_msg
@@ -11491,6 +12173,10 @@ pack_msg(slurm_msg_t const *msg, buf_t *buffer)
 		_pack_kill_job_msg((kill_job_msg_t *) msg->data, buffer,
 				   msg->protocol_version);
 		break;
+	case REQUEST_KILL_JOB_LIST:
+		_pack_kill_job_list_msg((kill_job_list_msg_t *) msg->data,
+					buffer, msg->protocol_version);
+		break;
 	case MESSAGE_EPILOG_COMPLETE:
 		_pack_epilog_comp_msg((epilog_complete_msg_t *) msg->data,
 				      buffer,
@@ -11687,6 +12373,10 @@ pack_msg(slurm_msg_t const *msg, buf_t *buffer)
 		_pack_job_notify((job_notify_msg_t *) msg->data, buffer,
 				 msg->protocol_version);
 		break;
+	case REQUEST_JOB_WAIT_NOTIFY:
+		_pack_job_wait_notify((job_wait_notify_msg_t *) msg->data,
+				      buffer, msg->protocol_version);
+		break;
 	case REQUEST_SET_DEBUG_FLAGS:
 		_pack_set_debug_flags_msg(
 			(set_debug_flags_msg_t *)msg->data, buffer,
@@ -11798,6 +12488,22 @@ pack_msg(slurm_msg_t const *msg, buf_t *buffer)
 		_pack_bb_status_resp_msg((bb_status_resp_msg_t *)(msg->data),
 					 buffer, msg->protocol_version);
 		break;
+	case RESPONSE_CTLD_PROFILE:
+		_pack_ctld_profile_msg((ctld_profile_msg_t *)(msg->data),
+				       buffer, msg->protocol_version);
+		break;
+	case REQUEST_STATE_REPLICA:
+		_pack_state_replica_msg((state_replica_msg_t *)(msg->data),
+					buffer, msg->protocol_version);
+		break;
+	case REQUEST_CTLD_EVENTS:
+		_pack_ctld_event_req_msg((ctld_event_req_msg_t *)(msg->data),
+					 buffer, msg->protocol_version);
+		break;
+	case RESPONSE_CTLD_EVENTS:
+		_pack_ctld_event_msg((ctld_event_msg_t *)(msg->data),
+				     buffer, msg->protocol_version);
+		break;
 	case REQUEST_CRONTAB:
 		_pack_crontab_request_msg(msg, buffer);
 		break;
@@ -11904,6 +12610,7 @@ unpack_msg(slurm_msg_t * msg, buf_t *buffer)
 		break;
 	case REQUEST_HET_JOB_ALLOCATION:
 	case REQUEST_SUBMIT_BATCH_HET_JOB:
+	case REQUEST_SUBMIT_BATCH_JOBS:
 		rc = _unpack_job_desc_list_msg((List *) &(msg->data),
 					       buffer, msg->protocol_version);
 		break;
@@ -11953,6 +12660,7 @@ unpack_msg(slurm_msg_t * msg, buf_t *buffer)
 	case REQUEST_PING:
 	case REQUEST_CONTROL:
 	case REQUEST_CONTROL_STATUS:
+	case REQUEST_CTLD_PROFILE:
 	case REQUEST_TAKEOVER:
 	case REQUEST_DAEMON_STATUS:
 	case REQUEST_HEALTH_CHECK:
@@ -11994,6 +12702,11 @@ unpack_msg(slurm_msg_t * msg, buf_t *buffer)
 						 & (msg->data), buffer,
 						 msg->protocol_version);
 		break;
+	case RESPONSE_SUBMIT_BATCH_JOBS:
+		rc = _unpack_submit_batch_jobs_response_msg(
+			(submit_batch_jobs_response_msg_t **) &(msg->data),
+			buffer, msg->protocol_version);
+		break;
 	case RESPONSE_JOB_ALLOCATION_INFO:
 	case RESPONSE_RESOURCE_ALLOCATION:
 		rc = _unpack_resource_allocation_response_msg(
@@ -12149,6 +12862,11 @@ unpack_msg(slurm_msg_t * msg, buf_t *buffer)
 					  buffer,
 					  msg->protocol_version);
 		break;
+	case REQUEST_KILL_JOB_LIST:
+		rc = _unpack_kill_job_list_msg(
+			(kill_job_list_msg_t **) &msg->data, buffer,
+			msg->protocol_version);
+		break;
 	case MESSAGE_EPILOG_COMPLETE:
 		rc = _unpack_epilog_comp_msg((epilog_complete_msg_t **)
 					     & (msg->data), buffer,
@@ -12370,6 +13088,11 @@ unpack_msg(slurm_msg_t * msg, buf_t *buffer)
 					 &msg->data, buffer,
 					 msg->protocol_version);
 		break;
+	case REQUEST_JOB_WAIT_NOTIFY:
+		rc = _unpack_job_wait_notify((job_wait_notify_msg_t **)
+					     &msg->data, buffer,
+					     msg->protocol_version);
+		break;
 	case REQUEST_SET_DEBUG_FLAGS:
 		rc = _unpack_set_debug_flags_msg(
 			(set_debug_flags_msg_t **)&(msg->data), buffer,
@@ -12496,6 +13219,26 @@ unpack_msg(slurm_msg_t * msg, buf_t *buffer)
 			(bb_status_resp_msg_t **)&(msg->data), buffer,
 			msg->protocol_version);
 		break;
+	case RESPONSE_CTLD_PROFILE:
+		rc = _unpack_ctld_profile_msg(
+			(ctld_profile_msg_t **)&(msg->data), buffer,
+			msg->protocol_version);
+		break;
+	case REQUEST_STATE_REPLICA:
+		rc = _unpack_state_replica_msg(
+			(state_replica_msg_t **)&(msg->data), buffer,
+			msg->protocol_version);
+		break;
+	case REQUEST_CTLD_EVENTS:
+		rc = _unpack_ctld_event_req_msg(
+			(ctld_event_req_msg_t **)&(msg->data), buffer,
+			msg->protocol_version);
+		break;
+	case RESPONSE_CTLD_EVENTS:
+		rc = _unpack_ctld_event_msg(
+			(ctld_event_msg_t **)&(msg->data), buffer,
+			msg->protocol_version);
+		break;
 	case REQUEST_CRONTAB:
 		rc = _unpack_crontab_request_msg(msg, buffer);
 		break;
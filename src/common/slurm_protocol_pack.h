@@ -94,6 +94,12 @@ extern int slurm_pack_list(List send_list,
 						  uint16_t rpc_version,
 						  buf_t *buffer),
 			   buf_t *buffer, uint16_t protocol_version);
+extern int slurm_pack_list_consume(List send_list,
+				   void (*pack_function) (void *object,
+							  uint16_t rpc_version,
+							  buf_t *buffer),
+				   void (*destroy_function) (void *object),
+				   buf_t *buffer, uint16_t protocol_version);
 extern int slurm_unpack_list(List *recv_list,
 			     int (*unpack_function) (void **object,
 						     uint16_t protocol_version,
@@ -46,6 +46,7 @@
 #include "src/common/slurm_protocol_defs.h"
 #include "src/common/slurm_protocol_util.h"
 #include "src/common/slurmdbd_defs.h"
+#include "src/common/trace.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
 #include "src/slurmdbd/read_config.h"
@@ -144,6 +145,7 @@ void init_header(header_t *header, slurm_msg_t *msg, uint16_t flags)
 	header->ret_list = msg->ret_list;
 	header->msg_index = msg->msg_index;
 	header->orig_addr = msg->orig_addr;
+	header->trace_id = msg->trace_id ? msg->trace_id : trace_get_id();
 }
 
 /*
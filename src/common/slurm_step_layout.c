@@ -64,6 +64,10 @@ static int _task_layout_plane(slurm_step_layout_t *step_layout,
 static int _task_layout_hostfile(slurm_step_layout_t *step_layout,
 				 const char *arbitrary_nodes);
 
+/* _pack_tids() formats */
+#define TIDS_LIST	0	/* task ids one by one */
+#define TIDS_RUNS	1	/* arithmetic runs of first id, stride, length */
+
 /*
  * slurm_step_layout_create - determine how many tasks of a job will be
  *                    run on each node. Distribution is influenced
@@ -280,12 +284,121 @@ extern void slurm_step_layout_merge(slurm_step_layout_t *step_layout1,
 	hostlist_destroy(hl);
 }
 
+/*
+ * Walk the arithmetic runs of a node's task ids, packing each as its first
+ * id, stride and length if buffer is set. Block, cyclic and plane layouts
+ * give a single run or one per plane. Unsigned arithmetic also covers
+ * decreasing ids. RET number of runs
+ */
+static uint32_t _tid_runs(uint32_t *tids, uint32_t cnt, buf_t *buffer)
+{
+	uint32_t i, j, stride, run_cnt = 0;
+
+	for (i = 0; i < cnt; i = j) {
+		stride = ((i + 1) < cnt) ? (tids[i + 1] - tids[i]) : 1;
+		for (j = i + 1;
+		     (j < cnt) && ((tids[j] - tids[j - 1]) == stride); j++)
+			;
+		run_cnt++;
+		if (buffer) {
+			pack32(tids[i], buffer);
+			pack32(stride, buffer);
+			pack32(j - i, buffer);
+		}
+	}
+
+	return run_cnt;
+}
+
+/* Pack a node's task ids as arithmetic runs if that is smaller */
+static void _pack_tids(uint32_t *tids, uint32_t cnt, buf_t *buffer)
+{
+	uint32_t run_cnt;
+
+	pack32(cnt, buffer);
+	if (!cnt)
+		return;
+
+	run_cnt = _tid_runs(tids, cnt, NULL);
+	if ((1 + (run_cnt * 3)) < cnt) {
+		pack8(TIDS_RUNS, buffer);
+		pack32(run_cnt, buffer);
+		(void) _tid_runs(tids, cnt, buffer);
+	} else {
+		pack8(TIDS_LIST, buffer);
+		for (uint32_t i = 0; i < cnt; i++)
+			pack32(tids[i], buffer);
+	}
+}
+
+static int _unpack_tids(uint32_t **tids, uint32_t *cnt, uint32_t max_cnt,
+			buf_t *buffer)
+{
+	uint32_t i = 0, run_cnt, start, stride, len;
+	uint8_t format;
+
+	*tids = NULL;
+	safe_unpack32(cnt, buffer);
+	if (!*cnt)
+		return SLURM_SUCCESS;
+	if (*cnt > max_cnt)
+		goto unpack_error;
+
+	safe_unpack8(&format, buffer);
+	*tids = xcalloc(*cnt, sizeof(uint32_t));
+	if (format == TIDS_RUNS) {
+		safe_unpack32(&run_cnt, buffer);
+		if (run_cnt > *cnt)
+			goto unpack_error;
+		while (run_cnt--) {
+			safe_unpack32(&start, buffer);
+			safe_unpack32(&stride, buffer);
+			safe_unpack32(&len, buffer);
+			if (!len || (len > (*cnt - i)))
+				goto unpack_error;
+			while (len--) {
+				(*tids)[i++] = start;
+				start += stride;
+			}
+		}
+		if (i != *cnt)
+			goto unpack_error;
+	} else if (format == TIDS_LIST) {
+		for (i = 0; i < *cnt; i++)
+			safe_unpack32(&(*tids)[i], buffer);
+	} else
+		goto unpack_error;
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	xfree(*tids);
+	return SLURM_ERROR;
+}
+
 extern void pack_slurm_step_layout(slurm_step_layout_t *step_layout,
 				   buf_t *buffer, uint16_t protocol_version)
 {
 	uint32_t i = 0;
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		if (step_layout)
+			i = 1;
+
+		pack16(i, buffer);
+		if (!i)
+			return;
+		packstr(step_layout->front_end, buffer);
+		packstr(step_layout->node_list, buffer);
+		pack32(step_layout->node_cnt, buffer);
+		pack16(step_layout->start_protocol_ver, buffer);
+		pack32(step_layout->task_cnt, buffer);
+		pack32(step_layout->task_dist, buffer);
+
+		for (i = 0; i < step_layout->node_cnt; i++)
+			_pack_tids(step_layout->tids[i], step_layout->tasks[i],
+				   buffer);
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		if (step_layout)
 			i = 1;
 
@@ -318,7 +431,32 @@ extern int unpack_slurm_step_layout(slurm_step_layout_t **layout, buf_t *buffer,
 	slurm_step_layout_t *step_layout = NULL;
 	int i;
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		safe_unpack16(&uint16_tmp, buffer);
+		if (!uint16_tmp)
+			return SLURM_SUCCESS;
+
+		step_layout = xmalloc(sizeof(slurm_step_layout_t));
+		*layout = step_layout;
+
+		safe_unpackstr(&step_layout->front_end, buffer);
+		safe_unpackstr(&step_layout->node_list, buffer);
+		safe_unpack32(&step_layout->node_cnt, buffer);
+		safe_unpack16(&step_layout->start_protocol_ver, buffer);
+		safe_unpack32(&step_layout->task_cnt, buffer);
+		safe_unpack32(&step_layout->task_dist, buffer);
+
+		safe_xcalloc(step_layout->tasks, step_layout->node_cnt,
+			     sizeof(uint32_t));
+		safe_xcalloc(step_layout->tids, step_layout->node_cnt,
+			     sizeof(uint32_t *));
+		for (i = 0; i < step_layout->node_cnt; i++) {
+			if (_unpack_tids(&step_layout->tids[i], &num_tids,
+					 step_layout->task_cnt, buffer))
+				goto unpack_error;
+			step_layout->tasks[i] = num_tids;
+		}
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack16(&uint16_tmp, buffer);
 		if (!uint16_tmp)
 			return SLURM_SUCCESS;
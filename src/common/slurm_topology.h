@@ -55,13 +55,18 @@ typedef struct {
 	bitstr_t *node_bitmap;		/* bitmap of all nodes descended from
 					 * this switch */
 	char *nodes;			/* name if direct descendant nodes */
+	uint16_t  num_desc_switches;	/* number of all descendant switches */
 	uint16_t  num_switches;         /* number of descendant switches */
-	uint16_t  parent;		/* index of parent switch */
+	uint16_t  parent;		/* index of parent switch or
+					 * SWITCH_NO_PARENT */
 	char *switches;			/* name of direct descendant switches */
+	uint16_t *switch_desc_index;	/* indexes of all descendant switches */
 	uint16_t *switch_index;		/* indexes of child switches */
 	uint32_t temp;			/* temperature, in celsius */
 } switch_record_t;
 
+#define SWITCH_NO_PARENT 0xffff
+
 extern switch_record_t *switch_record_table;  /* ptr to switch records */
 extern int switch_record_cnt;		/* size of switch_record_table */
 extern int switch_levels;               /* number of switch levels     */
@@ -110,6 +110,8 @@
 #define bit_noc			slurm_bit_noc
 #define bit_nffs		slurm_bit_nffs
 #define bit_copybits		slurm_bit_copybits
+#define bit_get_word64		slurm_bit_get_word64
+#define bit_set_word64		slurm_bit_set_word64
 
 /* fd.[ch] functions */
 #define fd_set_blocking		slurm_fd_set_blocking
@@ -266,6 +268,8 @@
 #define	unpackstr_array		slurm_unpackstr_array
 #define	packmem_array		slurm_packmem_array
 #define	unpackmem_array		slurm_unpackmem_array
+#define	pack_bit_str_bin	slurm_pack_bit_str_bin
+#define	unpack_bit_str_bin	slurm_unpack_bit_str_bin
 
 /* parse_time.[ch] functions */
 #define parse_time              slurm_parse_time
@@ -41,6 +41,15 @@
 #include "src/common/log.h"
 #include "src/common/slurm_time.h"
 
+/* Return the current time in micro-seconds since the Epoch */
+extern uint64_t slurm_time_usec(void)
+{
+	struct timeval now = {0, 0};
+
+	(void) gettimeofday(&now, NULL);
+	return ((uint64_t) now.tv_sec * 1000000) + now.tv_usec;
+}
+
 /* Return the number of micro-seconds between now and argument "tv",
  * Initialize tv to NOW if zero on entry */
 extern int slurm_delta_tv(struct timeval *tv)
@@ -39,6 +39,7 @@
 #ifndef _HAVE_TIMERS_H
 #define _HAVE_TIMERS_H
 
+#include <inttypes.h>
 #include <sys/time.h>
 
 #define DEF_TIMERS	struct timeval tv1, tv2; char tv_str[20] = ""; long delta_t;
@@ -58,6 +59,9 @@
 #define DELTA_TIMER	delta_t
 #define TIME_STR 	tv_str
 
+/* Return the current time in micro-seconds since the Epoch */
+extern uint64_t slurm_time_usec(void);
+
 /* Return the number of micro-seconds between now and argument "tv",
  * Initialize tv to NOW if zero on entry */
 extern int slurm_delta_tv(struct timeval *tv);
@@ -0,0 +1,232 @@
+/*****************************************************************************\
+ *  trace.c - record timing spans of key job events for tracing
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "slurm/slurm.h"
+
+#include "src/common/list.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/read_config.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/trace.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#define TRACE_RING_SIZE 1024
+
+typedef struct {
+	const char *name;
+	uint64_t trace_id;
+	uint64_t start;		/* usec since the Epoch */
+	uint64_t end;
+} trace_span_t;
+
+/*
+ * Rings are returned to the pool when their thread exits, and handed to the
+ * next new thread, so the count of rings is bounded by the count of
+ * concurrent threads rather than the count of threads ever created.
+ */
+typedef struct {
+	pthread_mutex_t mutex;	/* serializes recording with trace_dump() */
+	int inx;		/* reported as the thread id */
+	bool in_use;
+	uint32_t cnt;		/* spans recorded, may exceed TRACE_RING_SIZE */
+	trace_span_t spans[TRACE_RING_SIZE];
+} trace_ring_t;
+
+static pthread_mutex_t ring_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List ring_list = NULL;
+static pthread_key_t ring_key;
+static pthread_once_t ring_key_once = PTHREAD_ONCE_INIT;
+
+static __thread trace_ring_t *thread_ring = NULL;
+static __thread uint64_t thread_trace_id = 0;
+
+static uint64_t _now_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return ((uint64_t) ts.tv_sec * USEC_IN_SEC) + (ts.tv_nsec / 1000);
+}
+
+/* Thread exit, keep the spans but let another thread reuse the ring */
+static void _ring_release(void *x)
+{
+	trace_ring_t *ring = x;
+
+	slurm_mutex_lock(&ring_mutex);
+	ring->in_use = false;
+	slurm_mutex_unlock(&ring_mutex);
+}
+
+static void _ring_key_create(void)
+{
+	if (pthread_key_create(&ring_key, _ring_release))
+		error("%s: pthread_key_create: %m", __func__);
+}
+
+static int _find_free_ring(void *x, void *key)
+{
+	trace_ring_t *ring = x;
+
+	return !ring->in_use;
+}
+
+static trace_ring_t *_get_ring(void)
+{
+	trace_ring_t *ring;
+
+	if (thread_ring)
+		return thread_ring;
+
+	pthread_once(&ring_key_once, _ring_key_create);
+
+	slurm_mutex_lock(&ring_mutex);
+	if (!ring_list)
+		ring_list = list_create(NULL);
+	if (!(ring = list_find_first(ring_list, _find_free_ring, NULL))) {
+		ring = xmalloc(sizeof(*ring));
+		slurm_mutex_init(&ring->mutex);
+		ring->inx = list_count(ring_list);
+		list_append(ring_list, ring);
+	}
+	ring->in_use = true;
+	slurm_mutex_unlock(&ring_mutex);
+
+	(void) pthread_setspecific(ring_key, ring);
+	thread_ring = ring;
+	return ring;
+}
+
+extern uint64_t trace_span_start(void)
+{
+	if (!(slurm_conf.debug_flags & DEBUG_FLAG_TRACE_SPANS))
+		return 0;
+	return _now_usec();
+}
+
+extern void trace_span_end(const char *name, uint64_t start)
+{
+	trace_ring_t *ring;
+	trace_span_t *span;
+
+	if (!start)
+		return;
+
+	ring = _get_ring();
+	slurm_mutex_lock(&ring->mutex);
+	span = &ring->spans[ring->cnt++ % TRACE_RING_SIZE];
+	span->name = name;
+	span->trace_id = thread_trace_id;
+	span->start = start;
+	span->end = _now_usec();
+	slurm_mutex_unlock(&ring->mutex);
+}
+
+extern void trace_set_id(uint64_t trace_id)
+{
+	thread_trace_id = trace_id;
+}
+
+extern uint64_t trace_get_id(void)
+{
+	return thread_trace_id;
+}
+
+static int _dump_ring(void *x, void *arg)
+{
+	trace_ring_t *ring = x;
+	char **str = arg;
+	char *pos = NULL;
+	uint32_t i = 0;
+	pid_t pid = getpid();
+
+	slurm_mutex_lock(&ring->mutex);
+	if (ring->cnt > TRACE_RING_SIZE)
+		i = ring->cnt - TRACE_RING_SIZE;
+	for (; i < ring->cnt; i++) {
+		trace_span_t *span = &ring->spans[i % TRACE_RING_SIZE];
+
+		xstrfmtcatat(*str, &pos,
+			     "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%"PRIu64",\"dur\":%"PRIu64",\"pid\":%d,\"tid\":%d,\"args\":{\"trace_id\":%"PRIu64"}},\n",
+			     span->name, span->start, span->end - span->start,
+			     (int) pid, ring->inx, span->trace_id);
+	}
+	ring->cnt = 0;
+	slurm_mutex_unlock(&ring->mutex);
+
+	return 0;
+}
+
+extern void trace_dump(const char *dir, const char *daemon)
+{
+	char *path = NULL, *str = NULL;
+	struct stat st;
+	int fd;
+
+	slurm_mutex_lock(&ring_mutex);
+	if (ring_list)
+		list_for_each(ring_list, _dump_ring, &str);
+	slurm_mutex_unlock(&ring_mutex);
+
+	if (!str || !dir)
+		goto fini;
+
+	xstrfmtcat(path, "%s/%s.%d.trace.json", dir, daemon, (int) getpid());
+	if ((fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+		       0600)) < 0) {
+		error("%s: open(%s): %m", __func__, path);
+		goto fini;
+	}
+	/* The array is left open so later dumps can be appended */
+	if (!fstat(fd, &st) && !st.st_size)
+		safe_write(fd, "[\n", 2);
+	safe_write(fd, str, strlen(str));
+	close(fd);
+	goto fini;
+
+rwfail:
+	error("%s: write(%s): %m", __func__, path);
+	close(fd);
+fini:
+	xfree(path);
+	xfree(str);
+}
@@ -0,0 +1,76 @@
+/*****************************************************************************\
+ *  trace.h - record timing spans of key job events for tracing
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _HAVE_TRACE_H
+#define _HAVE_TRACE_H
+
+#include <inttypes.h>
+
+/*
+ * Spans are only recorded with DebugFlags=TraceSpans. Each thread records its
+ * spans into its own ring buffer, which keeps the latest TRACE_RING_SIZE
+ * spans until they are written out by trace_dump().
+ *
+ * The trace id of a thread identifies the work it is doing, normally the job
+ * id. It is sent in the header of each RPC and adopted by the receiving
+ * thread, so spans recorded by different daemons for the same job can be
+ * correlated.
+ *
+ * Usage:
+ *	uint64_t start = trace_span_start();
+ *	...
+ *	trace_span_end("launch", start);
+ */
+
+/* Return the span start time, or 0 if tracing is disabled */
+extern uint64_t trace_span_start(void);
+
+/*
+ * Record a span from start until now for the current trace id of this thread
+ * IN name - span name, must be a string constant
+ * IN start - return value of trace_span_start(), nothing is recorded if 0
+ */
+extern void trace_span_end(const char *name, uint64_t start);
+
+/* Set/get the trace id of spans recorded by this thread and RPCs it sends */
+extern void trace_set_id(uint64_t trace_id);
+extern uint64_t trace_get_id(void);
+
+/*
+ * Append the spans recorded since the previous call to
+ * "<dir>/<daemon>.<pid>.trace.json" in the Chrome trace event JSON array
+ * format, then discard them.
+ */
+extern void trace_dump(const char *dir, const char *daemon);
+
+#endif
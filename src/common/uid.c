@@ -51,6 +51,7 @@
 
 #include "src/common/macros.h"
 #include "src/common/uid.h"
+#include "src/common/xhash.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
@@ -60,8 +61,7 @@ typedef struct {
 } uid_cache_entry_t;
 
 static pthread_mutex_t uid_lock = PTHREAD_MUTEX_INITIALIZER;
-static uid_cache_entry_t *uid_cache = NULL;
-static int uid_cache_used = 0;
+static xhash_t *uid_cache = NULL;
 
 static int _getpwnam_r (const char *name, struct passwd *pwd, char *buf,
 		size_t bufsiz, struct passwd **result)
@@ -169,45 +169,44 @@ char *uid_to_string(uid_t uid)
 	return result;
 }
 
-static int _uid_compare(const void *a, const void *b)
+static void _uid_cache_id(void *item, const char **key, uint32_t *key_len)
 {
-	uid_t ua = *(const uid_t *)a;
-	uid_t ub = *(const uid_t *)b;
-	return ua - ub;
+	uid_cache_entry_t *entry = item;
+
+	*key = (const char *) &entry->uid;
+	*key_len = sizeof(entry->uid);
 }
 
-extern void uid_cache_clear(void)
+static void _uid_cache_free(void *item)
 {
-	int i;
+	uid_cache_entry_t *entry = item;
+
+	xfree(entry->username);
+	xfree(entry);
+}
 
+extern void uid_cache_clear(void)
+{
 	slurm_mutex_lock(&uid_lock);
-	for (i = 0; i < uid_cache_used; i++)
-		xfree(uid_cache[i].username);
-	xfree(uid_cache);
-	uid_cache_used = 0;
+	xhash_free(uid_cache);
 	slurm_mutex_unlock(&uid_lock);
 }
 
 extern char *uid_to_string_cached(uid_t uid)
 {
 	uid_cache_entry_t *entry;
-	uid_cache_entry_t target = {uid, NULL};
 
 	slurm_mutex_lock(&uid_lock);
-	entry = bsearch(&target, uid_cache, uid_cache_used,
-			sizeof(uid_cache_entry_t), _uid_compare);
-	if (entry == NULL) {
-		uid_cache_entry_t new_entry = {uid, uid_to_string(uid)};
-		uid_cache_used++;
-		uid_cache = xrealloc(uid_cache,
-				     sizeof(uid_cache_entry_t)*uid_cache_used);
-		uid_cache[uid_cache_used-1] = new_entry;
-		qsort(uid_cache, uid_cache_used, sizeof(uid_cache_entry_t),
-		      _uid_compare);
-		slurm_mutex_unlock(&uid_lock);
-		return new_entry.username;
+	if (!uid_cache)
+		uid_cache = xhash_init(_uid_cache_id, _uid_cache_free);
+	if (!(entry = xhash_get(uid_cache, (char *) &uid, sizeof(uid)))) {
+		entry = xmalloc(sizeof(*entry));
+		entry->uid = uid;
+		entry->username = uid_to_string(uid);
+		xhash_add(uid_cache, entry);
 	}
 	slurm_mutex_unlock(&uid_lock);
+
 	return entry->username;
 }
 
@@ -52,12 +52,72 @@
 #include "src/common/macros.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
 
 strong_alias(xfree_ptr, slurm_xfree_ptr);
 strong_alias(xsize, slurm_xsize);
 
 #define XMALLOC_MAGIC 0x42
 
+#ifdef XMALLOC_PROFILE
+#define XMALLOC_PROFILE_SITES 8192	/* must be a power of 2 */
+
+/*
+ * Allocation counts and bytes by call site. A site is added once under
+ * site_mutex and published by setting "used", after which it is found and
+ * updated without locking.
+ */
+typedef struct {
+	const char *file;
+	int line;
+	const char *func;
+	uint64_t count;
+	uint64_t bytes;
+	int used;
+} xmalloc_site_t;
+
+static pthread_mutex_t site_mutex = PTHREAD_MUTEX_INITIALIZER;
+static xmalloc_site_t sites[XMALLOC_PROFILE_SITES];
+
+static void _profile_alloc(const char *file, int line, const char *func,
+			   size_t size)
+{
+	uint32_t inx = (((uintptr_t) file >> 3) ^ (line * 2654435761U)) &
+		       (XMALLOC_PROFILE_SITES - 1);
+	xmalloc_site_t *site;
+	bool locked = false;
+	int i;
+
+	for (i = 0; i < XMALLOC_PROFILE_SITES; i++) {
+		site = &sites[inx];
+		if (!__atomic_load_n(&site->used, __ATOMIC_ACQUIRE)) {
+			/* Another thread may be adding this site */
+			if (!locked) {
+				pthread_mutex_lock(&site_mutex);
+				locked = true;
+				continue;
+			}
+			site->file = file;
+			site->line = line;
+			site->func = func;
+			__atomic_store_n(&site->used, 1, __ATOMIC_RELEASE);
+		}
+		if ((site->file == file) && (site->line == line)) {
+			__atomic_fetch_add(&site->count, 1, __ATOMIC_RELAXED);
+			__atomic_fetch_add(&site->bytes, size,
+					   __ATOMIC_RELAXED);
+			break;
+		}
+		inx = (inx + 1) & (XMALLOC_PROFILE_SITES - 1);
+	}
+
+	if (locked)
+		pthread_mutex_unlock(&site_mutex);
+}
+#else
+#define _profile_alloc(file, line, func, size)
+#endif
+
 /*
  * "Safe" version of malloc().
  *   size (IN)	number of bytes to malloc
@@ -107,6 +167,7 @@ void *slurm_xcalloc(size_t count, size_t size, bool clear, bool try,
 	}
 	p[0] = XMALLOC_MAGIC;	/* add "secret" magic cookie */
 	p[1] = count_size;	/* store size in buffer */
+	_profile_alloc(file, line, func, count_size);
 
 	return &p[2];
 }
@@ -177,6 +238,7 @@ extern void * slurm_xrecalloc(void **item, size_t count, size_t size,
 
 	p[1] = count_size;
 	*item = &p[2];
+	_profile_alloc(file, line, func, count_size);
 	return *item;
 
 error:
@@ -224,3 +286,26 @@ void xfree_ptr(void *ptr)
 {
 	slurm_xfree(&ptr);
 }
+
+extern char *xmalloc_profile_dump(void)
+{
+	char *str = NULL;
+#ifdef XMALLOC_PROFILE
+	char *pos = NULL;
+	int i;
+
+	for (i = 0; i < XMALLOC_PROFILE_SITES; i++) {
+		xmalloc_site_t *site = &sites[i];
+
+		if (!__atomic_load_n(&site->used, __ATOMIC_ACQUIRE))
+			continue;
+		xstrfmtcatat(str, &pos, "xmalloc_calls;%s;%s:%d %"PRIu64"\n",
+			     site->func, site->file, site->line,
+			     __atomic_load_n(&site->count, __ATOMIC_RELAXED));
+		xstrfmtcatat(str, &pos, "xmalloc_bytes;%s;%s:%d %"PRIu64"\n",
+			     site->func, site->file, site->line,
+			     __atomic_load_n(&site->bytes, __ATOMIC_RELAXED));
+	}
+#endif
+	return str;
+}
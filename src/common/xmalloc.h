@@ -111,4 +111,14 @@ size_t xsize(void *item);
 
 void xfree_ptr(void *);
 
+/*
+ * When built with -DXMALLOC_PROFILE, return the count and bytes of the
+ * allocations made at each call site in folded stack format, two lines per
+ * site: "xmalloc_calls;<func>;<file>:<line> <count>" and
+ * "xmalloc_bytes;<func>;<file>:<line> <bytes>". Reallocations count the new
+ * size. Otherwise return NULL.
+ * RET xmalloc'd string, caller must xfree()
+ */
+extern char *xmalloc_profile_dump(void);
+
 #endif /* !_XMALLOC_H */
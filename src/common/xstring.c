@@ -102,9 +102,11 @@ strong_alias(xstrcasestr,       slurm_xstrcasestr);
  */
 static void _makespace(char **str, int str_len, int needed)
 {
-	if (*str == NULL)
-		*str = xmalloc(needed + 1);
-	else {
+	/* New space is not zeroed, callers always write the terminator */
+	if (*str == NULL) {
+		*str = xmalloc_nz(needed + 1);
+		(*str)[0] = '\0';
+	} else {
 		int actual_size;
 		int used = (str_len < 0) ? strlen(*str) + 1 : str_len + 1;
 		int min_new_size = used + needed;
@@ -116,7 +118,7 @@ static void _makespace(char **str, int str_len, int needed)
 			if (new_size < (cur_size * 2))
 				new_size = cur_size * 2;
 
-			xrealloc(*str, new_size);
+			xrealloc_nz(*str, new_size);
 			actual_size = xsize(*str);
 			if (actual_size)
 				xassert(actual_size == new_size);
@@ -319,7 +321,8 @@ void _xstrfmtcatat(char **str, char **pos, const char *fmt, ...)
 
 	_makespace(str, orig_len, append_len);
 
-	memcpy(*str + orig_len, p, append_len);
+	/* Include the terminator, the new space is not zeroed */
+	memcpy(*str + orig_len, p, append_len + 1);
 	xfree(p);
 
 	/*
@@ -380,7 +383,7 @@ char *xstrdup(const char *str)
 		return NULL;
 
 	siz = strlen(str) + 1;
-	result = xmalloc(siz);
+	result = xmalloc_nz(siz);
 
 	/* includes terminating NUL from source string */
 	(void) memcpy(result, str, siz);
@@ -420,7 +423,7 @@ char * xstrndup(const char *str, size_t n)
 		return NULL;
 
 	siz = strnlen(str, n);
-	result = xmalloc(siz + 1);
+	result = xmalloc_nz(siz + 1);
 
 	(void) memcpy(result, str, siz);
 	result[siz] = '\0';
@@ -651,7 +654,7 @@ static size_t _xstrdup_vprintf(char **str, const char *fmt, va_list ap)
 	/* Start out with a size of 100 bytes. */
 	int n, size = 100;
 	va_list our_ap;
-	char *p = xmalloc(size);
+	char *p = xmalloc_nz(size);
 
 	while (1) {
 		/* Try to print in the allocated space. */
@@ -668,7 +671,7 @@ static size_t _xstrdup_vprintf(char **str, const char *fmt, va_list ap)
 			size = n + 1;           /* precisely what is needed */
 		else                      /* glibc 2.0 */
 			size *= 2;              /* twice the old size */
-		p = xrealloc(p, size);
+		p = xrealloc_nz(p, size);
 	}
 	/* NOTREACHED */
 }
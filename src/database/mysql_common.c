@@ -57,6 +57,30 @@ typedef struct {
 	char *columns;
 } db_key_t;
 
+typedef struct {
+	char *query;
+	MYSQL_STMT *stmt;
+} db_stmt_t;
+
+static void _destroy_db_stmt(void *arg)
+{
+	db_stmt_t *db_stmt = (db_stmt_t *)arg;
+
+	if (db_stmt) {
+		if (db_stmt->stmt)
+			mysql_stmt_close(db_stmt->stmt);
+		xfree(db_stmt->query);
+		xfree(db_stmt);
+	}
+}
+
+static int _find_db_stmt(void *x, void *key)
+{
+	db_stmt_t *db_stmt = (db_stmt_t *)x;
+
+	return !xstrcmp(db_stmt->query, (char *)key);
+}
+
 static void _destroy_db_key(void *arg)
 {
 	db_key_t *db_key = (db_key_t *)arg;
@@ -202,6 +226,39 @@ end_it:
 	return rc;
 }
 
+/* NOTE: Ensure that mysql_conn->lock is set on function entry */
+static MYSQL_STMT *_get_db_stmt(mysql_conn_t *mysql_conn, char *query)
+{
+	db_stmt_t *db_stmt;
+	MYSQL_STMT *stmt;
+
+	if (!mysql_conn->stmt_list)
+		mysql_conn->stmt_list = list_create(_destroy_db_stmt);
+	else if ((db_stmt = list_find_first(mysql_conn->stmt_list,
+					    _find_db_stmt, query)))
+		return db_stmt->stmt;
+
+	if (!(stmt = mysql_stmt_init(mysql_conn->db_conn))) {
+		error("mysql_stmt_init failed: %d %s",
+		      mysql_errno(mysql_conn->db_conn),
+		      mysql_error(mysql_conn->db_conn));
+		return NULL;
+	}
+	if (mysql_stmt_prepare(stmt, query, strlen(query))) {
+		error("mysql_stmt_prepare failed: %d %s\n%s",
+		      mysql_stmt_errno(stmt), mysql_stmt_error(stmt), query);
+		mysql_stmt_close(stmt);
+		return NULL;
+	}
+
+	db_stmt = xmalloc(sizeof(*db_stmt));
+	db_stmt->query = xstrdup(query);
+	db_stmt->stmt = stmt;
+	list_append(mysql_conn->stmt_list, db_stmt);
+
+	return stmt;
+}
+
 /* NOTE: Ensure that mysql_conn->lock is NOT set on function entry */
 static int _mysql_make_table_current(mysql_conn_t *mysql_conn, char *table_name,
 				     storage_field_t *fields, char *ending)
@@ -849,6 +906,8 @@ extern int mysql_db_close_db_connection(mysql_conn_t *mysql_conn)
 {
 	slurm_mutex_lock(&mysql_conn->lock);
 	if (mysql_conn && mysql_conn->db_conn) {
+		/* Statements are only valid for the connection they came from */
+		FREE_NULL_LIST(mysql_conn->stmt_list);
 		if (mysql_thread_safe())
 			mysql_thread_end();
 		mysql_close(mysql_conn->db_conn);
@@ -1034,6 +1093,108 @@ extern uint64_t mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query)
 
 }
 
+extern int mysql_db_stmt_query(mysql_conn_t *mysql_conn, char *query,
+			       MYSQL_BIND *params)
+{
+	MYSQL_STMT *stmt;
+	int rc = SLURM_SUCCESS;
+	int deadlock_attempt = 0;
+	bool reprepared = false;
+
+	if (!mysql_conn || !mysql_conn->db_conn) {
+		fatal("You haven't inited this storage yet.");
+		return 0;	/* For CLANG false positive */
+	}
+
+	slurm_mutex_lock(&mysql_conn->lock);
+	/* clear out the old results so we don't get a 2014 error */
+	_clear_results(mysql_conn->db_conn);
+	if (!(stmt = _get_db_stmt(mysql_conn, query))) {
+		rc = SLURM_ERROR;
+		goto end_it;
+	}
+
+try_again:
+	if (!mysql_stmt_bind_param(stmt, params) && !mysql_stmt_execute(stmt))
+		goto end_it;
+
+	errno = mysql_stmt_errno(stmt);
+	if (errno == ER_LOCK_DEADLOCK) {
+		deadlock_attempt++;
+		if (deadlock_attempt < MAX_DEADLOCK_ATTEMPTS) {
+			error("%s: deadlock detected attempt %u/%u: %d %s",
+			      __func__, deadlock_attempt,
+			      MAX_DEADLOCK_ATTEMPTS, errno,
+			      mysql_stmt_error(stmt));
+			goto try_again;
+		}
+		fatal("%s: unable to resolve deadlock with attempts %u/%u: %d %s\nPlease call 'show engine innodb status;' in MySQL/MariaDB and open a bug report with SchedMD.",
+		      __func__, deadlock_attempt, MAX_DEADLOCK_ATTEMPTS, errno,
+		      mysql_stmt_error(stmt));
+	}
+
+	/*
+	 * An automatic reconnect to the server silently invalidates every
+	 * statement prepared on the old session, so prepare it once more.
+	 */
+	if (!reprepared) {
+		debug2("%s: re-preparing statement after error %d %s",
+		       __func__, errno, mysql_stmt_error(stmt));
+		reprepared = true;
+		list_delete_all(mysql_conn->stmt_list, _find_db_stmt, query);
+		if ((stmt = _get_db_stmt(mysql_conn, query)))
+			goto try_again;
+	} else {
+		error("mysql_stmt_execute failed: %d %s\n%s",
+		      errno, mysql_stmt_error(stmt), query);
+		list_delete_all(mysql_conn->stmt_list, _find_db_stmt, query);
+	}
+	rc = SLURM_ERROR;
+
+end_it:
+	/*
+	 * Starting in MariaDB 10.2 many of the api commands started
+	 * setting errno erroneously.
+	 */
+	if (!rc)
+		errno = 0;
+	slurm_mutex_unlock(&mysql_conn->lock);
+	return rc;
+}
+
+extern void mysql_db_bind_str(MYSQL_BIND *bind, char *str)
+{
+	if (!str)
+		str = "";
+	memset(bind, 0, sizeof(*bind));
+	bind->buffer_type = MYSQL_TYPE_STRING;
+	bind->buffer = str;
+	bind->buffer_length = strlen(str);
+}
+
+extern void mysql_db_bind_int32(MYSQL_BIND *bind, int32_t *val)
+{
+	memset(bind, 0, sizeof(*bind));
+	bind->buffer_type = MYSQL_TYPE_LONG;
+	bind->buffer = val;
+}
+
+extern void mysql_db_bind_uint32(MYSQL_BIND *bind, uint32_t *val)
+{
+	memset(bind, 0, sizeof(*bind));
+	bind->buffer_type = MYSQL_TYPE_LONG;
+	bind->buffer = val;
+	bind->is_unsigned = true;
+}
+
+extern void mysql_db_bind_uint64(MYSQL_BIND *bind, uint64_t *val)
+{
+	memset(bind, 0, sizeof(*bind));
+	bind->buffer_type = MYSQL_TYPE_LONGLONG;
+	bind->buffer = val;
+	bind->is_unsigned = true;
+}
+
 extern int mysql_db_create_table(mysql_conn_t *mysql_conn, char *table_name,
 				 storage_field_t *fields, char *ending)
 {
@@ -67,6 +67,7 @@ typedef struct {
 	bool rollback;
 	List update_list;
 	int conn;
+	List stmt_list; /* prepared statements, see mysql_db_stmt_query() */
 } mysql_conn_t;
 
 typedef struct {
@@ -105,6 +106,21 @@ extern int mysql_db_query_check_after(mysql_conn_t *mysql_conn, char *query);
 
 extern uint64_t mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query);
 
+/*
+ * Execute query as a server side prepared statement with params bound to its
+ * '?' markers. Statements are cached on the connection by their text so the
+ * server only parses a given query once per connection. Values bound as
+ * strings do not need to be escaped.
+ */
+extern int mysql_db_stmt_query(mysql_conn_t *mysql_conn, char *query,
+			       MYSQL_BIND *params);
+
+/* Helpers to fill in a MYSQL_BIND, the value must outlive the query. */
+extern void mysql_db_bind_str(MYSQL_BIND *bind, char *str);
+extern void mysql_db_bind_int32(MYSQL_BIND *bind, int32_t *val);
+extern void mysql_db_bind_uint32(MYSQL_BIND *bind, uint32_t *val);
+extern void mysql_db_bind_uint64(MYSQL_BIND *bind, uint64_t *val);
+
 extern int mysql_db_create_table(mysql_conn_t *mysql_conn, char *table_name,
 				 storage_field_t *fields, char *ending);
 
@@ -1468,6 +1468,7 @@ extern int create_cluster_tables(mysql_conn_t *mysql_conn, char *cluster_name)
 	/*
 	 * sacct_def is the index for query's with state as time_start is used
 	 * in these queries. sacct_def2 is for plain sacct queries.
+	 * mod_time is for sacct queries of recently modified jobs.
 	 */
 	if (mysql_db_create_table(mysql_conn, table_name, job_table_fields,
 				  ", primary key (job_db_inx), "
@@ -1486,7 +1487,8 @@ extern int create_cluster_tables(mysql_conn_t *mysql_conn, char *cluster_name)
 				  "key sacct_def (id_user, time_start, "
 				  "time_end), "
 				  "key sacct_def2 (id_user, time_end, "
-				  "time_eligible))")
+				  "time_eligible), "
+				  "key mod_time (mod_time))")
 	    == SLURM_ERROR)
 		return SLURM_ERROR;
 
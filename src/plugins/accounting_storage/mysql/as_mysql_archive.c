@@ -2849,7 +2849,7 @@ static buf_t *_pack_archive_events(MYSQL_RES *result, char *cluster_name,
 static char *_load_events(uint16_t rpc_version, buf_t *buffer,
 			  char *cluster_name, uint32_t rec_cnt)
 {
-	char *insert = NULL, *format = NULL;
+	char *insert = NULL, *format = NULL, *pos = NULL;
 	local_event_t object;
 	int i = 0;
 
@@ -2874,9 +2874,9 @@ static char *_load_events(uint16_t rpc_version, buf_t *buffer,
 		}
 
 		if (i)
-			xstrcat(insert, ", ");
+			xstrfmtcatat(insert, &pos, ", ");
 
-		xstrfmtcat(insert, format,
+		xstrfmtcatat(insert, &pos, format,
 			   object.period_start,
 			   object.period_end,
 			   object.node_name,
@@ -2978,7 +2978,7 @@ static buf_t *_pack_archive_jobs(MYSQL_RES *result, char *cluster_name,
 static char *_load_jobs(uint16_t rpc_version, buf_t *buffer,
 			char *cluster_name, uint32_t rec_cnt)
 {
-	char *insert = NULL, *format = NULL;
+	char *insert = NULL, *format = NULL, *pos = NULL;
 	int safe_attributes[] = {
 		JOB_REQ_ARRAY_MAX,
 		JOB_REQ_ARRAY_TASK_PENDING,
@@ -3058,7 +3058,7 @@ static char *_load_jobs(uint16_t rpc_version, buf_t *buffer,
 		}
 
 		if (i)
-			xstrcat(insert, ", ");
+			xstrfmtcatat(insert, &pos, ", ");
 
 		xstrcat(format, "('%s'");
 		for(int j = 1; safe_attributes[j] < JOB_REQ_COUNT; j++) {
@@ -3109,7 +3109,7 @@ static char *_load_jobs(uint16_t rpc_version, buf_t *buffer,
 
 		xstrcat(format, ")");
 
-		xstrfmtcat(insert, format,
+		xstrfmtcatat(insert, &pos, format,
 			   object.array_max_tasks,
 			   object.array_task_pending,
 			   object.alloc_nodes,
@@ -3223,7 +3223,7 @@ static buf_t *_pack_archive_resvs(MYSQL_RES *result, char *cluster_name,
 static char *_load_resvs(uint16_t rpc_version, buf_t *buffer,
 			 char *cluster_name, uint32_t rec_cnt)
 {
-	char *insert = NULL, *format = NULL;
+	char *insert = NULL, *format = NULL, *pos = NULL;
 	local_resv_t object;
 	int i = 0;
 
@@ -3247,9 +3247,9 @@ static char *_load_resvs(uint16_t rpc_version, buf_t *buffer,
 		}
 
 		if (i)
-			xstrcat(insert, ", ");
+			xstrfmtcatat(insert, &pos, ", ");
 
-		xstrfmtcat(insert, format,
+		xstrfmtcatat(insert, &pos, format,
 			   object.id,
 			   object.deleted,
 			   object.assocs,
@@ -3353,7 +3353,7 @@ static buf_t *_pack_archive_steps(MYSQL_RES *result, char *cluster_name,
 static char *_load_steps(uint16_t rpc_version, buf_t *buffer,
 			 char *cluster_name, uint32_t rec_cnt)
 {
-	char *insert = NULL, *format = NULL;
+	char *insert = NULL, *format = NULL, *pos = NULL;
 	local_step_t object;
 	int i;
 
@@ -3377,12 +3377,12 @@ static char *_load_steps(uint16_t rpc_version, buf_t *buffer,
 		}
 
 		if (i)
-			xstrcat(insert, ", ");
+			xstrfmtcatat(insert, &pos, ", ");
 
 		if (!object.step_het_comp)
 			object.step_het_comp = xstrdup_printf("%u", NO_VAL);
 
-		xstrfmtcat(insert, format,
+		xstrfmtcatat(insert, &pos, format,
 			   object.job_db_inx,
 			   object.stepid,
 			   object.step_het_comp,
@@ -3472,7 +3472,7 @@ static buf_t *_pack_archive_suspends(MYSQL_RES *result, char *cluster_name,
 static char *_load_suspend(uint16_t rpc_version, buf_t *buffer,
 			   char *cluster_name, uint32_t rec_cnt)
 {
-	char *insert = NULL, *format = NULL;
+	char *insert = NULL, *format = NULL, *pos = NULL;
 	local_suspend_t object;
 	int i = 0;
 
@@ -3496,9 +3496,9 @@ static char *_load_suspend(uint16_t rpc_version, buf_t *buffer,
 		}
 
 		if (i)
-			xstrcat(insert, ", ");
+			xstrfmtcatat(insert, &pos, ", ");
 
-		xstrfmtcat(insert, format,
+		xstrfmtcatat(insert, &pos, format,
 			   object.job_db_inx,
 			   object.associd,
 			   object.period_start,
@@ -3553,7 +3553,7 @@ static buf_t *_pack_archive_txns(MYSQL_RES *result, char *cluster_name,
 static char *_load_txn(uint16_t rpc_version, buf_t *buffer,
 		       char *cluster_name, uint32_t rec_cnt)
 {
-	char *insert = NULL, *format = NULL;
+	char *insert = NULL, *format = NULL, *pos = NULL;
 	local_txn_t object;
 	int i = 0;
 
@@ -3577,9 +3577,9 @@ static char *_load_txn(uint16_t rpc_version, buf_t *buffer,
 		}
 
 		if (i)
-			xstrcat(insert, ", ");
+			xstrfmtcatat(insert, &pos, ", ");
 
-		xstrfmtcat(insert, format,
+		xstrfmtcatat(insert, &pos, format,
 			   object.id,
 			   object.timestamp,
 			   object.action,
@@ -3641,6 +3641,7 @@ static char *_load_usage(uint16_t rpc_version, buf_t *buffer,
 			 uint32_t rec_cnt)
 {
 	char *insert = NULL, *format = NULL, *my_usage_table = NULL;
+	char *pos = NULL;
 	local_usage_t object;
 	int i = 0;
 
@@ -3705,9 +3706,9 @@ static char *_load_usage(uint16_t rpc_version, buf_t *buffer,
 		}
 
 		if (i)
-			xstrcat(insert, ", ");
+			xstrfmtcatat(insert, &pos, ", ");
 
-		xstrfmtcat(insert, format,
+		xstrfmtcatat(insert, &pos, format,
 			   object.id,
 			   object.tres_id,
 			   object.time_start,
@@ -3774,6 +3775,7 @@ static char *_load_cluster_usage(uint16_t rpc_version, buf_t *buffer,
 				 uint32_t rec_cnt)
 {
 	char *insert = NULL, *format = NULL, *my_usage_table = NULL;
+	char *pos = NULL;
 	local_cluster_usage_t object;
 	int i = 0;
 
@@ -3813,9 +3815,9 @@ static char *_load_cluster_usage(uint16_t rpc_version, buf_t *buffer,
 		}
 
 		if (i)
-			xstrcat(insert, ", ");
+			xstrfmtcatat(insert, &pos, ", ");
 
-		xstrfmtcat(insert, format,
+		xstrfmtcatat(insert, &pos, format,
 			   object.tres_id,
 			   object.time_start,
 			   object.tres_cnt,
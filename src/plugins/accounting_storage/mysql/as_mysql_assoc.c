@@ -2414,7 +2414,7 @@ extern int as_mysql_add_assocs(mysql_conn_t *mysql_conn, uint32_t uid,
 	int rc = SLURM_SUCCESS;
 	int i=0;
 	slurmdb_assoc_rec_t *object = NULL;
-	char *cols = NULL, *vals = NULL, *txn_query = NULL;
+	char *cols = NULL, *vals = NULL, *txn_query = NULL, *txn_pos = NULL;
 	char *extra = NULL, *query = NULL, *update = NULL, *tmp_extra = NULL;
 	char *parent = NULL;
 	time_t now = time(NULL);
@@ -2564,7 +2564,13 @@ extern int as_mysql_add_assocs(mysql_conn_t *mysql_conn, uint32_t uid,
 		if (object->is_def != 1)
 			object->is_def = 0;
 
-		list_append(local_cluster_list, object->cluster);
+		/*
+		 * Keep the cluster and user lists unique, the default
+		 * account check below queries once per user per cluster.
+		 */
+		if (!list_find_first(local_cluster_list,
+				     slurm_find_char_in_list, object->cluster))
+			list_append(local_cluster_list, object->cluster);
 
 		if (object->parent_acct) {
 			parent = object->parent_acct;
@@ -2605,7 +2611,10 @@ extern int as_mysql_add_assocs(mysql_conn_t *mysql_conn, uint32_t uid,
 			xstrfmtcat(extra, ", `partition`='%s'", part);
 			if (!added_user_list)
 				added_user_list = list_create(NULL);
-			list_append(added_user_list, object->user);
+			if (!list_find_first(added_user_list,
+					     slurm_find_char_in_list,
+					     object->user))
+				list_append(added_user_list, object->user);
 		}
 
 		if (object->id) {
@@ -2880,22 +2889,22 @@ extern int as_mysql_add_assocs(mysql_conn_t *mysql_conn, uint32_t uid,
 			/* we always have a ', ' as the first 2 chars */
 			tmp_extra = slurm_add_slash_to_quotes(extra+2);
 			if (txn_query)
-				xstrfmtcat(txn_query,
-					   ", (%ld, %d, 'id_assoc=%d', "
-					   "'%s', '%s', '%s')",
-					   now, DBD_ADD_ASSOCS, assoc_id,
-					   user_name,
-					   tmp_extra, object->cluster);
+				xstrfmtcatat(txn_query, &txn_pos,
+					     ", (%ld, %d, 'id_assoc=%d', "
+					     "'%s', '%s', '%s')",
+					     now, DBD_ADD_ASSOCS, assoc_id,
+					     user_name,
+					     tmp_extra, object->cluster);
 			else
-				xstrfmtcat(txn_query,
-					   "insert into %s "
-					   "(timestamp, action, name, actor, "
-					   "info, cluster) values (%ld, %d, "
-					   "'id_assoc=%d', '%s', '%s', '%s')",
-					   txn_table,
-					   now, DBD_ADD_ASSOCS, assoc_id,
-					   user_name,
-					   tmp_extra, object->cluster);
+				xstrfmtcatat(txn_query, &txn_pos,
+					     "insert into %s "
+					     "(timestamp, action, name, actor, "
+					     "info, cluster) values (%ld, %d, "
+					     "'id_assoc=%d', '%s', '%s', '%s')",
+					     txn_table,
+					     now, DBD_ADD_ASSOCS, assoc_id,
+					     user_name,
+					     tmp_extra, object->cluster);
 			xfree(tmp_extra);
 		}
 		xfree(extra);
@@ -1364,11 +1364,121 @@ empty:
 	return ret_list;
 }
 
+/* Condition matching node_name to any of the hosts in hl */
+static char *_node_name_in(hostlist_t hl)
+{
+	hostlist_iterator_t itr = hostlist_iterator_create(hl);
+	char *host, *cond = NULL, *pos = NULL;
+
+	while ((host = hostlist_next(itr))) {
+		xstrfmtcatat(cond, &pos, "%s'%s'",
+			     cond ? "," : "node_name in (", host);
+		free(host);
+	}
+	hostlist_iterator_destroy(itr);
+	xstrfmtcatat(cond, &pos, ")");
+
+	return cond;
+}
+
+/*
+ * as_mysql_node_down() for a range of nodes sharing state, reason and tres,
+ * done with one query of each kind instead of a set per node.
+ */
+static int _nodes_down(mysql_conn_t *mysql_conn, node_record_t *node_ptr,
+		       hostlist_t hl, time_t event_time, char *my_reason,
+		       uint32_t reason_uid)
+{
+	int rc = SLURM_SUCCESS;
+	char *query = NULL, *pos = NULL, *cond, *host, *sep = "";
+	hostlist_t retime_hl;
+	hostlist_iterator_t itr;
+	MYSQL_RES *result = NULL;
+	MYSQL_ROW row;
+
+	cond = _node_name_in(hl);
+	query = xstrdup_printf("select node_name, state, reason, time_start "
+			       "from \"%s_%s\" where time_end=0 and %s;",
+			       mysql_conn->cluster_name, event_table, cond);
+	xfree(cond);
+	result = mysql_db_query_ret(mysql_conn, query, 0);
+	xfree(query);
+
+	if (!result)
+		return SLURM_ERROR;
+
+	/* Same checks as for a single node, see as_mysql_node_down() */
+	retime_hl = hostlist_create(NULL);
+	while ((row = mysql_fetch_row(result))) {
+		if ((node_ptr->node_state == slurm_atoul(row[1])) &&
+		    !xstrcasecmp(my_reason, row[2])) {
+			hostlist_delete_host(hl, row[0]);
+		} else if (event_time == slurm_atoul(row[3])) {
+			hostlist_delete_host(hl, row[0]);
+			hostlist_push_host(retime_hl, row[0]);
+		}
+	}
+	mysql_free_result(result);
+
+	if (hostlist_count(retime_hl)) {
+		cond = _node_name_in(retime_hl);
+		query = xstrdup_printf(
+			"update \"%s_%s\" set reason='%s' where "
+			"time_start=%ld and %s;",
+			mysql_conn->cluster_name, event_table,
+			my_reason, event_time, cond);
+		xfree(cond);
+		DB_DEBUG(DB_EVENT, mysql_conn->conn, "query\n%s", query);
+		rc = mysql_db_query(mysql_conn, query);
+		xfree(query);
+	}
+	hostlist_destroy(retime_hl);
+
+	if ((rc != SLURM_SUCCESS) || !hostlist_count(hl))
+		return rc;
+
+	DB_DEBUG(DB_EVENT, mysql_conn->conn,
+		 "inserting %d nodes (%s) with tres of '%s'",
+		 hostlist_count(hl), mysql_conn->cluster_name,
+		 node_ptr->tres_str);
+
+	cond = _node_name_in(hl);
+	xstrfmtcatat(query, &pos,
+		     "update \"%s_%s\" set time_end=%ld where "
+		     "time_end=0 and %s;",
+		     mysql_conn->cluster_name, event_table, event_time, cond);
+	xfree(cond);
+
+	xstrfmtcatat(query, &pos,
+		     "insert into \"%s_%s\" "
+		     "(node_name, state, tres, time_start, "
+		     "reason, reason_uid) values ",
+		     mysql_conn->cluster_name, event_table);
+	itr = hostlist_iterator_create(hl);
+	while ((host = hostlist_next(itr))) {
+		xstrfmtcatat(query, &pos, "%s('%s', %u, '%s', %ld, '%s', %u)",
+			     sep, host, node_ptr->node_state,
+			     node_ptr->tres_str, event_time, my_reason,
+			     reason_uid);
+		sep = ", ";
+		free(host);
+	}
+	hostlist_iterator_destroy(itr);
+	xstrfmtcatat(query, &pos, " on duplicate key update time_end=0;");
+
+	DB_DEBUG(DB_EVENT, mysql_conn->conn, "query\n%s", query);
+	rc = mysql_db_query(mysql_conn, query);
+	xfree(query);
+
+	return rc;
+}
+
 extern int as_mysql_node_down(mysql_conn_t *mysql_conn,
 			      node_record_t *node_ptr,
 			      time_t event_time, char *reason,
 			      uint32_t reason_uid)
 {
+	hostlist_t hl;
 	int rc = SLURM_SUCCESS;
 	char *query = NULL;
 	char *my_reason;
@@ -1393,6 +1503,17 @@ extern int as_mysql_node_down(mysql_conn_t *mysql_conn,
 		return SLURM_ERROR;
 	}
 
+	/* slurmctld sends nodes changing state together as one range */
+	hl = hostlist_create(node_ptr->name);
+	if (hostlist_count(hl) > 1) {
+		my_reason = reason ? reason : node_ptr->reason;
+		rc = _nodes_down(mysql_conn, node_ptr, hl, event_time,
+				 my_reason ? my_reason : "", reason_uid);
+		hostlist_destroy(hl);
+		return rc;
+	}
+	hostlist_destroy(hl);
+
 	query = xstrdup_printf("select state, reason, time_start from \"%s_%s\" where "
 			       "time_end=0 and node_name='%s';",
 			       mysql_conn->cluster_name, event_table,
@@ -1487,8 +1608,9 @@ extern int as_mysql_node_up(mysql_conn_t *mysql_conn,
 			    node_record_t *node_ptr,
 			    time_t event_time)
 {
-	char* query;
+	char* query, *cond;
 	int rc = SLURM_SUCCESS;
+	hostlist_t hl;
 
 	if (check_connection(mysql_conn) != SLURM_SUCCESS)
 		return ESLURM_DB_CONNECTION;
@@ -1498,11 +1620,20 @@ extern int as_mysql_node_up(mysql_conn_t *mysql_conn,
 		return SLURM_ERROR;
 	}
 
+	/* slurmctld sends nodes changing state together as one range */
+	hl = hostlist_create(node_ptr->name);
+	if (hostlist_count(hl) > 1)
+		cond = _node_name_in(hl);
+	else
+		cond = xstrdup_printf("node_name='%s'", node_ptr->name);
+	hostlist_destroy(hl);
+
 	query = xstrdup_printf(
 		"update \"%s_%s\" set time_end=%ld where "
-		"time_end=0 and node_name='%s';",
+		"time_end=0 and %s;",
 		mysql_conn->cluster_name, event_table,
-		event_time, node_ptr->name);
+		event_time, cond);
+	xfree(cond);
 	DB_DEBUG(DB_EVENT, mysql_conn->conn, "query\n%s", query);
 	rc = mysql_db_query(mysql_conn, query);
 	xfree(query);
@@ -288,6 +288,7 @@ extern int as_mysql_job_start(mysql_conn_t *mysql_conn, job_record_t *job_ptr)
 	char *partition = NULL;
 	char *query = NULL;
 	int reinit = 0;
+	bool need_reroll;
 	time_t begin_time, check_time, start_time, submit_time;
 	uint32_t wckeyid = 0;
 	uint32_t job_state;
@@ -365,8 +366,17 @@ extern int as_mysql_job_start(mysql_conn_t *mysql_conn, job_record_t *job_ptr)
 	else
 		check_time = submit_time;
 
+	/*
+	 * rollup_lock is shared by every cluster this slurmdbd serves, so
+	 * only hold it to look at global_last_rollup and never across a
+	 * query, or one cluster replaying old jobs stalls job ingest for
+	 * all the others.
+	 */
 	slurm_mutex_lock(&rollup_lock);
-	if (check_time < global_last_rollup) {
+	need_reroll = (check_time < global_last_rollup);
+	slurm_mutex_unlock(&rollup_lock);
+
+	if (need_reroll) {
 		MYSQL_RES *result = NULL;
 		MYSQL_ROW row;
 
@@ -384,7 +394,6 @@ extern int as_mysql_job_start(mysql_conn_t *mysql_conn, job_record_t *job_ptr)
 		if (!(result =
 		      mysql_db_query_ret(mysql_conn, query, 0))) {
 			xfree(query);
-			slurm_mutex_unlock(&rollup_lock);
 			return SLURM_ERROR;
 		}
 		xfree(query);
@@ -393,7 +402,6 @@ extern int as_mysql_job_start(mysql_conn_t *mysql_conn, job_record_t *job_ptr)
 			debug4("revieved an update for a "
 			       "job (%u) already known about",
 			       job_ptr->job_id);
-			slurm_mutex_unlock(&rollup_lock);
 			goto no_rollup_change;
 		}
 		mysql_free_result(result);
@@ -417,7 +425,9 @@ extern int as_mysql_job_start(mysql_conn_t *mysql_conn, job_record_t *job_ptr)
 			      slurm_ctime2(&check_time),
 			      job_ptr->job_id, mysql_conn->cluster_name);
 
-		global_last_rollup = check_time;
+		slurm_mutex_lock(&rollup_lock);
+		if (check_time < global_last_rollup)
+			global_last_rollup = check_time;
 		slurm_mutex_unlock(&rollup_lock);
 
 		/* If the times here are later than the daily_rollup
@@ -434,8 +444,7 @@ extern int as_mysql_job_start(mysql_conn_t *mysql_conn, job_record_t *job_ptr)
 		DB_DEBUG(DB_JOB, mysql_conn->conn, "query\n%s", query);
 		rc = mysql_db_query(mysql_conn, query);
 		xfree(query);
-	} else
-		slurm_mutex_unlock(&rollup_lock);
+	}
 
 no_rollup_change:
 
@@ -1118,6 +1127,8 @@ extern int as_mysql_step_start(mysql_conn_t *mysql_conn,
 	char *node_list = NULL;
 	char *node_inx = NULL;
 	time_t start_time, submit_time;
+	int32_t step_id, time_start, state = JOB_RUNNING;
+	MYSQL_BIND params[15];
 	char *query = NULL;
 
 	if (!step_ptr->job_ptr->db_index
@@ -1217,35 +1228,50 @@ extern int as_mysql_step_start(mysql_conn_t *mysql_conn,
 		}
 	}
 
-	/* we want to print a -1 for the requid so leave it a
-	   %d */
-	/* The stepid could be negative so use %d not %u */
+	/*
+	 * This is sent for every step so it is a prepared statement, the
+	 * text only changes with the cluster name.
+	 */
 	query = xstrdup_printf(
 		"insert into \"%s_%s\" (job_db_inx, id_step, step_het_comp, "
 		"time_start, step_name, state, tres_alloc, "
 		"nodes_alloc, task_cnt, nodelist, node_inx, "
 		"task_dist, req_cpufreq, req_cpufreq_min, req_cpufreq_gov) "
-		"values (%"PRIu64", %d, %u, %d, '%s', %d, '%s', %d, %d, "
-		"'%s', '%s', %d, %u, %u, %u) "
+		"values (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?) "
 		"on duplicate key update "
-		"nodes_alloc=%d, task_cnt=%d, time_end=0, state=%d, "
-		"nodelist='%s', node_inx='%s', task_dist=%d, "
-		"req_cpufreq=%u, req_cpufreq_min=%u, req_cpufreq_gov=%u,"
-		"tres_alloc='%s';",
-		mysql_conn->cluster_name, step_table,
-		step_ptr->job_ptr->db_index,
-		step_ptr->step_id.step_id,
-		step_ptr->step_id.step_het_comp,
-		(int)start_time, step_ptr->name,
-		JOB_RUNNING, step_ptr->tres_alloc_str,
-		nodes, tasks, node_list, node_inx, task_dist,
-		step_ptr->cpu_freq_max, step_ptr->cpu_freq_min,
-		step_ptr->cpu_freq_gov, nodes, tasks, JOB_RUNNING,
-		node_list, node_inx, task_dist, step_ptr->cpu_freq_max,
-		step_ptr->cpu_freq_min, step_ptr->cpu_freq_gov,
-		step_ptr->tres_alloc_str);
-	DB_DEBUG(DB_STEP, mysql_conn->conn, "query\n%s", query);
-	rc = mysql_db_query(mysql_conn, query);
+		"nodes_alloc=VALUES(nodes_alloc), task_cnt=VALUES(task_cnt), "
+		"time_end=0, state=VALUES(state), "
+		"nodelist=VALUES(nodelist), node_inx=VALUES(node_inx), "
+		"task_dist=VALUES(task_dist), "
+		"req_cpufreq=VALUES(req_cpufreq), "
+		"req_cpufreq_min=VALUES(req_cpufreq_min), "
+		"req_cpufreq_gov=VALUES(req_cpufreq_gov), "
+		"tres_alloc=VALUES(tres_alloc);",
+		mysql_conn->cluster_name, step_table);
+
+	/* The stepid could be negative so bind it signed */
+	step_id = (int32_t) step_ptr->step_id.step_id;
+	time_start = (int32_t) start_time;
+	mysql_db_bind_uint64(&params[0], &step_ptr->job_ptr->db_index);
+	mysql_db_bind_int32(&params[1], &step_id);
+	mysql_db_bind_uint32(&params[2], &step_ptr->step_id.step_het_comp);
+	mysql_db_bind_int32(&params[3], &time_start);
+	mysql_db_bind_str(&params[4], step_ptr->name);
+	mysql_db_bind_int32(&params[5], &state);
+	mysql_db_bind_str(&params[6], step_ptr->tres_alloc_str);
+	mysql_db_bind_int32(&params[7], &nodes);
+	mysql_db_bind_int32(&params[8], &tasks);
+	mysql_db_bind_str(&params[9], node_list);
+	mysql_db_bind_str(&params[10], node_inx);
+	mysql_db_bind_int32(&params[11], &task_dist);
+	mysql_db_bind_uint32(&params[12], &step_ptr->cpu_freq_max);
+	mysql_db_bind_uint32(&params[13], &step_ptr->cpu_freq_min);
+	mysql_db_bind_uint32(&params[14], &step_ptr->cpu_freq_gov);
+
+	DB_DEBUG(DB_STEP, mysql_conn->conn,
+		 "query\n%s\njob_db_inx=%"PRIu64" id_step=%d",
+		 query, step_ptr->job_ptr->db_index, step_id);
+	rc = mysql_db_stmt_query(mysql_conn, query, params);
 	xfree(query);
 
 	return rc;
@@ -1500,7 +1526,8 @@ extern int as_mysql_step_complete(mysql_conn_t *mysql_conn,
 	/* set the energy for the entire job. */
 	if (step_ptr->job_ptr->tres_alloc_str) {
 		query = xstrdup_printf(
-			"update \"%s_%s\" set tres_alloc='%s' where "
+			"update \"%s_%s\" set tres_alloc='%s', "
+			"mod_time=UNIX_TIMESTAMP() where "
 			"job_db_inx=%"PRIu64,
 			mysql_conn->cluster_name, job_table,
 			step_ptr->job_ptr->tres_alloc_str,
@@ -1568,7 +1595,8 @@ extern int as_mysql_suspend(mysql_conn_t *mysql_conn, uint64_t old_db_inx,
 	*/
 	xstrfmtcat(query,
 		   "update \"%s_%s\" set time_suspended=%d-time_suspended, "
-		   "state=%d where job_db_inx=%"PRIu64";",
+		   "state=%d, mod_time=UNIX_TIMESTAMP() "
+		   "where job_db_inx=%"PRIu64";",
 		   mysql_conn->cluster_name, job_table,
 		   (int)job_ptr->suspend_time,
 		   job_ptr->job_state & JOB_STATE_BASE,
@@ -1661,8 +1689,8 @@ again:
 		xstrfmtcat(suspended_char, ")");
 		xstrfmtcat(query,
 			   "update \"%s_%s\" set "
-			   "time_suspended=%ld-time_suspended "
-			   "where %s;",
+			   "time_suspended=%ld-time_suspended, "
+			   "mod_time=UNIX_TIMESTAMP() where %s;",
 			   mysql_conn->cluster_name, job_table,
 			   event_time, suspended_char);
 		xstrfmtcat(query,
@@ -1681,8 +1709,8 @@ again:
 	if (id_char) {
 		xstrfmtcat(id_char, ")");
 		xstrfmtcat(query,
-			   "update \"%s_%s\" set state=%d, "
-			   "time_end=%ld where %s;",
+			   "update \"%s_%s\" set state=%d, time_end=%ld, "
+			   "mod_time=UNIX_TIMESTAMP() where %s;",
 			   mysql_conn->cluster_name, job_table,
 			   JOB_CANCELLED, event_time, id_char);
 		xstrfmtcat(query,
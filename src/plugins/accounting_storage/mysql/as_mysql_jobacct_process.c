@@ -353,7 +353,8 @@ static void _state_time_string(char **extra, char *cluster_name, uint32_t state,
 {
 	int base_state = state;
 
-	if (!job_cond->usage_start && !job_cond->usage_end) {
+	if ((!job_cond->usage_start && !job_cond->usage_end) ||
+	    (job_cond->flags & JOBCOND_FLAG_MOD_TIME)) {
 		xstrfmtcat(*extra, "t1.state='%u'", state);
 		return;
 	}
@@ -707,7 +708,8 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 				job->start = job->end;
 		}
 
-		if (job_cond && !(job_cond->flags & JOBCOND_FLAG_NO_TRUNC) ){
+		if (job_cond && !(job_cond->flags & JOBCOND_FLAG_NO_TRUNC) &&
+		    !(job_cond->flags & JOBCOND_FLAG_MOD_TIME)) {
 
 			if (!job_cond->usage_end ||
 			    (job_cond->usage_end > now)) {
@@ -887,14 +889,22 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 				xstrcat(extra, ")");
 		}
 
-		query =	xstrdup_printf("select %s from \"%s_%s\" as t1 "
-				       "where t1.job_db_inx=%s && "
-				       "t1.time_start <= %ld && "
-				       "(!t1.time_end || t1.time_end >= %ld)",
-				       step_fields, cluster_name,
-				       step_table, db_inx_char,
-				       job_cond->usage_end,
-				       job_cond->usage_start);
+		/* Report all steps of a job selected by modification time */
+		if (job_cond->flags & JOBCOND_FLAG_MOD_TIME)
+			query = xstrdup_printf("select %s from \"%s_%s\" as t1 "
+					       "where t1.job_db_inx=%s",
+					       step_fields, cluster_name,
+					       step_table, db_inx_char);
+		else
+			query = xstrdup_printf("select %s from \"%s_%s\" as t1 "
+					       "where t1.job_db_inx=%s && "
+					       "t1.time_start <= %ld && "
+					       "(!t1.time_end || "
+					       "t1.time_end >= %ld)",
+					       step_fields, cluster_name,
+					       step_table, db_inx_char,
+					       job_cond->usage_end,
+					       job_cond->usage_start);
 
 		if (extra) {
 			xstrcat(query, extra);
@@ -958,6 +968,7 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 
 			if (job_cond &&
 			    !(job_cond->flags & JOBCOND_FLAG_NO_TRUNC)
+			    && !(job_cond->flags & JOBCOND_FLAG_MOD_TIME)
 			    && job_cond->usage_start) {
 				if (step->start
 				    && (step->start < job_cond->usage_start))
@@ -1604,7 +1615,19 @@ extern int setup_job_cond_limits(slurmdb_job_cond_t *job_cond,
 		}
 	}
 
-	if (!job_cond->state_list || !list_count(job_cond->state_list)) {
+	if (job_cond->flags & JOBCOND_FLAG_MOD_TIME) {
+		/* Jobs whose record changed in the window, whatever state */
+		if (*extra)
+			xstrcat(*extra, " && (");
+		else
+			xstrcat(*extra, " where (");
+
+		xstrfmtcat(*extra, "t1.mod_time >= %ld", job_cond->usage_start);
+		if (job_cond->usage_end)
+			xstrfmtcat(*extra, " && t1.mod_time <= %ld",
+				   job_cond->usage_end);
+		xstrcat(*extra, ")");
+	} else if (!job_cond->state_list || !list_count(job_cond->state_list)) {
 		/*
 		 * There's an explicit list of jobs, so don't hide
 		 * non-eligible ones. Else handle normal time query of only
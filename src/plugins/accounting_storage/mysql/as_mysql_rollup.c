@@ -42,6 +42,7 @@
 #include "as_mysql_archive.h"
 #include "src/common/parse_time.h"
 #include "src/common/slurm_time.h"
+#include "src/common/xhash.h"
 
 enum {
 	TIME_ALLOC,
@@ -89,9 +90,21 @@ typedef struct {
 	List loc_tres;
 	time_t orig_start;
 	time_t start;
+	bool unused_reset; /* reservation started in this hour */
 	double unused_wall;
 } local_resv_usage_t;
 
+typedef struct {
+	char *cluster_name;
+	int conn;
+	time_t end;
+	time_t now;
+	int rc;
+	char *resv_query;
+	time_t start;
+	pthread_t tid;
+} local_hour_rollup_t;
+
 static void _destroy_local_tres_usage(void *object)
 {
 	local_tres_usage_t *a_usage = (local_tres_usage_t *)object;
@@ -139,14 +152,31 @@ static int _find_loc_tres(void *x, void *key)
 	return 0;
 }
 
-static int _find_id_usage(void *x, void *key)
+static void _id_usage_key(void *item, const char **key, uint32_t *key_len)
 {
-	local_id_usage_t *loc = (local_id_usage_t *)x;
-	uint32_t id = *(uint32_t *)key;
+	local_id_usage_t *usage = item;
 
-	if (loc->id == id)
-		return 1;
-	return 0;
+	*key = (const char *) &usage->id;
+	*key_len = sizeof(usage->id);
+}
+
+/*
+ * Find the usage record for id in hash, or create one in both list and hash.
+ * loc_tres of a new record is left NULL for the caller to fill in.
+ */
+static local_id_usage_t *_get_id_usage(List list, xhash_t *hash, int id)
+{
+	local_id_usage_t *usage;
+
+	if ((usage = xhash_get(hash, (const char *) &id, sizeof(id))))
+		return usage;
+
+	usage = xmalloc(sizeof(local_id_usage_t));
+	usage->id = id;
+	list_append(list, usage);
+	xhash_add(hash, usage);
+
+	return usage;
 }
 
 static void _remove_job_tres_time_from_cluster(List c_tres, List j_tres,
@@ -278,17 +308,13 @@ static int _update_unused_wall(local_resv_usage_t *r_usage, List job_tres,
 	 * Here we are converting TRES seconds to wall seconds.  This is needed
 	 * to determine how much time is actually idle in the reservation.
 	 */
+	/*
+	 * This may go below zero, it is clamped when the update query is
+	 * built. Since only job time is subtracted here that gives the same
+	 * result as clamping after every job.
+	 */
 	r_usage->unused_wall -=	(double)job_seconds * tres_ratio;
 
-	if (r_usage->unused_wall < 0) {
-		/*
-		 * With a Flex reservation you can easily have more time than is
-		 * possible.  Just print this debug3 warning if it happens.
-		 */
-		debug3("WARNING: Unused wall is less than zero; this should never happen outside a Flex reservation. Setting it to zero for resv id = %d, start = %ld.",
-		       r_usage->id, r_usage->orig_start);
-		r_usage->unused_wall = 0;
-	}
 	return SLURM_SUCCESS;
 }
 
@@ -1076,12 +1102,16 @@ static local_cluster_usage_t *_setup_cluster_usage(mysql_conn_t *mysql_conn,
 	return c_usage;
 }
 
-extern int _setup_resv_usage(mysql_conn_t *mysql_conn,
+/*
+ * delta IN - don't read the unused_wall stored so far, start counting at 0
+ *	so the caller can add the result to the stored value later
+ */
+static int _setup_resv_usage(mysql_conn_t *mysql_conn,
 			     char *cluster_name,
 			     time_t curr_start,
 			     time_t curr_end,
 			     List resv_usage_list,
-			     int dims)
+			     int dims, bool delta)
 {
 	MYSQL_RES *result = NULL;
 	MYSQL_ROW row;
@@ -1158,6 +1188,7 @@ extern int _setup_resv_usage(mysql_conn_t *mysql_conn,
 		int unused;
 		int resv_seconds;
 		time_t orig_start = row_start;
+		bool unused_reset = false;
 
 		if (row_start >= curr_start) {
 			/*
@@ -1167,7 +1198,10 @@ extern int _setup_resv_usage(mysql_conn_t *mysql_conn,
 			 * rerolling set it back to 0.
 			 */
 			unused = 0;
-		} else
+			unused_reset = true;
+		} else if (delta)
+			unused = 0;
+		else
 			unused = slurm_atoul(row[RESV_REQ_UNUSED]);
 
 		if (row_start <= curr_start)
@@ -1202,6 +1236,7 @@ extern int _setup_resv_usage(mysql_conn_t *mysql_conn,
 		r_usage->orig_start = orig_start;
 		r_usage->start = row_start;
 		r_usage->end = row_end;
+		r_usage->unused_reset = unused_reset;
 		r_usage->unused_wall = unused + resv_seconds;
 		r_usage->hl = hostlist_create_dims(row[RESV_REQ_NODES], dims);
 		list_append(resv_usage_list, r_usage);
@@ -1211,15 +1246,22 @@ extern int _setup_resv_usage(mysql_conn_t *mysql_conn,
 	return SLURM_SUCCESS;
 }
 
-extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
-				  char *cluster_name,
-				  time_t start, time_t end,
-				  uint16_t archive_data)
+/*
+ * Roll up every hour from start to end.
+ * now IN - time to record as creation/mod time of the usage rows
+ * resv_query IN/OUT - if NULL, update the unused time of reservations as
+ *	each hour is done. Otherwise append the updates to *resv_query
+ *	as deltas against the stored unused time. They will have to be run
+ *	in order after any earlier hours have been rolled up.
+ */
+static int _hourly_rollup_range(mysql_conn_t *mysql_conn,
+				char *cluster_name,
+				time_t start, time_t end, time_t now,
+				char **resv_query)
 {
 	int rc = SLURM_SUCCESS;
 	int add_sec = 3600;
 	int i=0, dims;
-	time_t now = time(NULL);
 	time_t curr_start = start;
 	time_t curr_end = curr_start + add_sec;
 	char *query = NULL;
@@ -1232,6 +1274,8 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 	List assoc_usage_list = list_create(_destroy_local_id_usage);
 	List cluster_down_list = list_create(_destroy_local_cluster_usage);
 	List wckey_usage_list = list_create(_destroy_local_id_usage);
+	xhash_t *assoc_usage_hash = xhash_init(_id_usage_key, NULL);
+	xhash_t *wckey_usage_hash = xhash_init(_id_usage_key, NULL);
 	List resv_usage_list = list_create(_destroy_local_resv_usage);
 	uint16_t track_wckey = slurm_get_track_wckey();
 	local_cluster_usage_t *loc_c_usage = NULL;
@@ -1337,7 +1381,8 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 
 		if ((rc = _setup_resv_usage(mysql_conn, cluster_name,
 					    curr_start, curr_end,
-					    resv_usage_list, dims))
+					    resv_usage_list, dims,
+					    (resv_query != NULL)))
 		    != SLURM_SUCCESS)
 			goto end_it;
 
@@ -1447,9 +1492,9 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 			}
 
 			if (last_id != assoc_id) {
-				a_usage = xmalloc(sizeof(local_id_usage_t));
-				a_usage->id = assoc_id;
-				list_append(assoc_usage_list, a_usage);
+				a_usage = _get_id_usage(assoc_usage_list,
+							assoc_usage_hash,
+							assoc_id);
 				last_id = assoc_id;
 				/* a_usage->loc_tres is made later,
 				   don't do it here.
@@ -1462,20 +1507,12 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 
 			/* do the wckey calculation */
 			if (last_wckeyid != wckey_id) {
-				list_iterator_reset(w_itr);
-				while ((w_usage = list_next(w_itr)))
-					if (w_usage->id == wckey_id)
-						break;
-
-				if (!w_usage) {
-					w_usage = xmalloc(
-						sizeof(local_id_usage_t));
-					w_usage->id = wckey_id;
-					list_append(wckey_usage_list,
-						    w_usage);
+				w_usage = _get_id_usage(wckey_usage_list,
+							wckey_usage_hash,
+							wckey_id);
+				if (!w_usage->loc_tres)
 					w_usage->loc_tres = list_create(
 						_destroy_local_tres_usage);
-				}
 				last_wckeyid = wckey_id;
 			}
 
@@ -1684,10 +1721,29 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 			ListIterator t_itr;
 			local_tres_usage_t *loc_tres;
 
-			xstrfmtcat(query, "update \"%s_%s\" set unused_wall=%f where id_resv=%u and time_start=%ld;",
-				   cluster_name, resv_table,
-				   r_usage->unused_wall, r_usage->id,
-				   r_usage->orig_start);
+			if (resv_query && !r_usage->unused_reset) {
+				xstrfmtcat(*resv_query, "update \"%s_%s\" set unused_wall=greatest(unused_wall + %f, 0) where id_resv=%u and time_start=%ld;",
+					   cluster_name, resv_table,
+					   r_usage->unused_wall, r_usage->id,
+					   r_usage->orig_start);
+			} else {
+				if (r_usage->unused_wall < 0) {
+					/*
+					 * With a Flex reservation you can
+					 * easily have more time than is
+					 * possible. Just print this debug3
+					 * warning if it happens.
+					 */
+					debug3("WARNING: Unused wall is less than zero; this should never happen outside a Flex reservation. Setting it to zero for resv id = %d, start = %ld.",
+					       r_usage->id, r_usage->orig_start);
+					r_usage->unused_wall = 0;
+				}
+				xstrfmtcat(*(resv_query ? resv_query : &query),
+					   "update \"%s_%s\" set unused_wall=%f where id_resv=%u and time_start=%ld;",
+					   cluster_name, resv_table,
+					   r_usage->unused_wall, r_usage->id,
+					   r_usage->orig_start);
+			}
 
 			if (!r_usage->loc_tres ||
 			    !list_count(r_usage->loc_tres))
@@ -1721,20 +1777,16 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 					r_usage->local_assocs);
 				while ((assoc = list_next(tmp_itr))) {
 					uint32_t associd = slurm_atoul(assoc);
-					if ((last_id != associd) &&
-					    !(a_usage = list_find_first(
-						      assoc_usage_list,
-						      _find_id_usage,
-						      &associd))) {
-						a_usage = xmalloc(
-							sizeof(local_id_usage_t));
-						a_usage->id = associd;
-						list_append(assoc_usage_list,
-							    a_usage);
+					if (last_id != associd) {
+						a_usage = _get_id_usage(
+							assoc_usage_list,
+							assoc_usage_hash,
+							associd);
 						last_id = associd;
+					}
+					if (!a_usage->loc_tres)
 						a_usage->loc_tres = list_create(
 							_destroy_local_tres_usage);
-					}
 
 					_add_time_tres(a_usage->loc_tres,
 						       TIME_ALLOC, loc_tres->id,
@@ -1823,6 +1875,8 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		a_usage     = NULL;
 		w_usage     = NULL;
 
+		xhash_clear(assoc_usage_hash);
+		xhash_clear(wckey_usage_hash);
 		list_flush(assoc_usage_list);
 		list_flush(cluster_down_list);
 		list_flush(wckey_usage_list);
@@ -1845,6 +1899,8 @@ end_it:
 	if (r_itr)
 		list_iterator_destroy(r_itr);
 
+	xhash_free(assoc_usage_hash);
+	xhash_free(wckey_usage_hash);
 	FREE_NULL_LIST(assoc_usage_list);
 	FREE_NULL_LIST(cluster_down_list);
 	FREE_NULL_LIST(wckey_usage_list);
@@ -1853,15 +1909,127 @@ end_it:
 /* 	info("stop start %s", slurm_ctime2(&curr_start)); */
 /* 	info("stop end %s", slurm_ctime2(&curr_end)); */
 
+	return rc;
+}
+
+static void *_hourly_rollup_thread(void *arg)
+{
+	local_hour_rollup_t *hour_rollup = arg;
+	mysql_conn_t mysql_conn;
+
+	memset(&mysql_conn, 0, sizeof(mysql_conn_t));
+	mysql_conn.rollback = 1;
+	mysql_conn.conn = hour_rollup->conn;
+	slurm_mutex_init(&mysql_conn.lock);
+
+	/* Each thread needs it's own connection */
+	if ((hour_rollup->rc = check_connection(&mysql_conn)) ==
+	    SLURM_SUCCESS) {
+		hour_rollup->rc = _hourly_rollup_range(
+			&mysql_conn, hour_rollup->cluster_name,
+			hour_rollup->start, hour_rollup->end, hour_rollup->now,
+			&hour_rollup->resv_query);
+		if (hour_rollup->rc != SLURM_SUCCESS) {
+			if (mysql_db_rollback(&mysql_conn))
+				error("rollback failed");
+		} else if (mysql_db_commit(&mysql_conn)) {
+			error("Couldn't commit cluster (%s) hour rollup",
+			      hour_rollup->cluster_name);
+			hour_rollup->rc = SLURM_ERROR;
+		}
+	}
+
+	mysql_db_close_db_connection(&mysql_conn);
+	slurm_mutex_destroy(&mysql_conn.lock);
+
+	return NULL;
+}
+
+/*
+ * Split the hours from start to end over up to thread_cnt threads, each
+ * with its own database connection. The usage rows of an hour don't depend
+ * on any other hour, but the unused time of a reservation carries over
+ * from one hour to the next. The threads only collect those updates which
+ * are then applied here in hour order.
+ */
+static int _hourly_rollup_parallel(mysql_conn_t *mysql_conn,
+				   char *cluster_name,
+				   time_t start, time_t end, time_t now,
+				   int thread_cnt)
+{
+	int rc = SLURM_SUCCESS;
+	int hours = (end - start + 3599) / 3600;
+	int hours_per_thread, i;
+	local_hour_rollup_t *hour_rollup;
+
+	thread_cnt = MIN(thread_cnt, hours);
+	hours_per_thread = (hours + thread_cnt - 1) / thread_cnt;
+	thread_cnt = (hours + hours_per_thread - 1) / hours_per_thread;
+	hour_rollup = xcalloc(thread_cnt, sizeof(local_hour_rollup_t));
+
+	debug("%s: rolling up %d hours for cluster %s with %d threads",
+	      __func__, hours, cluster_name, thread_cnt);
+
+	for (i = 0; i < thread_cnt; i++) {
+		hour_rollup[i].cluster_name = cluster_name;
+		hour_rollup[i].conn = mysql_conn->conn;
+		hour_rollup[i].now = now;
+		hour_rollup[i].start = start + (i * hours_per_thread * 3600);
+		hour_rollup[i].end = MIN(end, hour_rollup[i].start +
+					 (hours_per_thread * 3600));
+		slurm_thread_create(&hour_rollup[i].tid,
+				    _hourly_rollup_thread, &hour_rollup[i]);
+	}
+
+	for (i = 0; i < thread_cnt; i++) {
+		pthread_join(hour_rollup[i].tid, NULL);
+		if (hour_rollup[i].rc != SLURM_SUCCESS)
+			rc = hour_rollup[i].rc;
+	}
+
+	for (i = 0; (rc == SLURM_SUCCESS) && (i < thread_cnt); i++) {
+		if (!hour_rollup[i].resv_query)
+			continue;
+		DB_DEBUG(DB_USAGE, mysql_conn->conn, "query\n%s",
+		         hour_rollup[i].resv_query);
+		if ((rc = mysql_db_query(mysql_conn,
+					 hour_rollup[i].resv_query))
+		    != SLURM_SUCCESS)
+			error("couldn't update reservations with unused time");
+	}
+
+	for (i = 0; i < thread_cnt; i++)
+		xfree(hour_rollup[i].resv_query);
+	xfree(hour_rollup);
+
+	return rc;
+}
+
+extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
+				  char *cluster_name,
+				  time_t start, time_t end,
+				  uint16_t archive_data)
+{
+	int rc;
+	int thread_cnt = slurmdbd_conf ? slurmdbd_conf->rollup_threads : 1;
+	time_t now = time(NULL);
+
+	if ((thread_cnt > 1) && ((end - start) > 3600))
+		rc = _hourly_rollup_parallel(mysql_conn, cluster_name,
+					     start, end, now, thread_cnt);
+	else
+		rc = _hourly_rollup_range(mysql_conn, cluster_name,
+					  start, end, now, NULL);
+
 	/* go check to see if we archive and purge */
 
 	if (rc == SLURM_SUCCESS) {
 		if (mysql_db_commit(mysql_conn)) {
-			char start[25], end[25];
+			char start_str[25], end_str[25];
 			error("Couldn't commit cluster (%s) "
 			      "hour rollup for %s - %s",
-			      cluster_name, slurm_ctime2_r(&curr_start, start),
-			      slurm_ctime2_r(&curr_end, end));
+			      cluster_name, slurm_ctime2_r(&start, start_str),
+			      slurm_ctime2_r(&end, end_str));
 			rc = SLURM_ERROR;
 		} else
 			rc = _process_purge(mysql_conn, cluster_name,
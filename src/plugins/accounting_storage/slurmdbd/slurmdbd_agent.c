@@ -39,6 +39,8 @@
 
 #include "src/common/slurm_xlator.h"
 
+#include <dirent.h>
+
 #include "src/common/fd.h"
 #include "src/common/slurmdbd_pack.h"
 #include "src/common/xsignal.h"
@@ -48,7 +50,8 @@
 
 enum {
 	MAX_DBD_ACTION_DISCARD,
-	MAX_DBD_ACTION_EXIT
+	MAX_DBD_ACTION_EXIT,
+	MAX_DBD_ACTION_SPOOL
 };
 
 slurm_persist_conn_t *slurmdbd_conn = NULL;
@@ -71,6 +74,18 @@ static pthread_cond_t  slurmdbd_cond = PTHREAD_COND_INITIALIZER;
 
 static int max_dbd_msg_action = MAX_DBD_DEFAULT_ACTION;
 
+/*
+ * On-disk overflow of agent_list used by max_dbd_msg_action=spool. Segments
+ * are named dbd.spool.<seq> in StateSaveLocation. Segments in
+ * [spool_head, spool_tail) are complete, spool_fd (if open) is appending to
+ * segment spool_tail. All protected by agent_lock.
+ */
+static int      spool_fd       = -1;
+static uint32_t spool_head     = 0;
+static uint32_t spool_tail     = 0;
+static uint32_t spool_tail_cnt = 0;
+static uint32_t spool_cnt      = 0;
+
 static int _unpack_return_code(uint16_t rpc_version, buf_t *buffer)
 {
 	uint16_t msg_type = -1;
@@ -292,14 +307,13 @@ static buf_t *_load_dbd_rec(int fd)
 	return buffer;
 }
 
-static void _load_dbd_state(void)
+/* Append every record in dbd_fname to agent_list, RET count recovered */
+static int _load_dbd_file(char *dbd_fname)
 {
-	char *dbd_fname = NULL;
 	buf_t *buffer;
 	int fd, recovered = 0;
 	uint16_t rpc_version = 0;
 
-	xstrfmtcat(dbd_fname, "%s/dbd.messages", slurm_conf.state_save_location);
 	fd = open(dbd_fname, O_RDONLY);
 	if (fd < 0) {
 		/* don't print an error message if there is no file */
@@ -367,9 +381,20 @@ static void _load_dbd_state(void)
 		}
 
 	end_it:
-		verbose("recovered %d pending RPCs", recovered);
+		verbose("recovered %d pending RPCs from %s",
+			recovered, dbd_fname);
 		(void) close(fd);
 	}
+
+	return recovered;
+}
+
+static void _load_dbd_state(void)
+{
+	char *dbd_fname = NULL;
+
+	xstrfmtcat(dbd_fname, "%s/dbd.messages", slurm_conf.state_save_location);
+	(void) _load_dbd_file(dbd_fname);
 	xfree(dbd_fname);
 }
 
@@ -411,6 +436,23 @@ static int _save_dbd_rec(int fd, buf_t *buffer)
 	return SLURM_SUCCESS;
 }
 
+/* Write the "VER%d" header record every state file starts with */
+static int _save_dbd_ver(int fd)
+{
+	char curr_ver_str[10];
+	buf_t *buffer;
+	int rc;
+
+	snprintf(curr_ver_str, sizeof(curr_ver_str),
+		 "VER%d", SLURM_PROTOCOL_VERSION);
+	buffer = init_buf(strlen(curr_ver_str));
+	packstr(curr_ver_str, buffer);
+	rc = _save_dbd_rec(fd, buffer);
+	free_buf(buffer);
+
+	return rc;
+}
+
 static void _save_dbd_state(void)
 {
 	char *dbd_fname = NULL;
@@ -425,14 +467,7 @@ static void _save_dbd_state(void)
 	if (fd < 0) {
 		error("Creating state save file %s", dbd_fname);
 	} else if (list_count(agent_list)) {
-		char curr_ver_str[10];
-		snprintf(curr_ver_str, sizeof(curr_ver_str),
-			 "VER%d", SLURM_PROTOCOL_VERSION);
-		buffer = init_buf(strlen(curr_ver_str));
-		packstr(curr_ver_str, buffer);
-		rc = _save_dbd_rec(fd, buffer);
-		free_buf(buffer);
-		if (rc != SLURM_SUCCESS)
+		if ((rc = _save_dbd_ver(fd)) != SLURM_SUCCESS)
 			goto end_it;
 
 		while ((buffer = list_dequeue(agent_list))) {
@@ -473,6 +508,128 @@ end_it:
 	xfree(dbd_fname);
 }
 
+static char *_spool_fname(uint32_t seq)
+{
+	char *fname = NULL;
+
+	xstrfmtcat(fname, "%s/dbd.spool.%u",
+		   slurm_conf.state_save_location, seq);
+	return fname;
+}
+
+static bool _spool_empty(void)
+{
+	return ((spool_head == spool_tail) && (spool_fd < 0));
+}
+
+/* Close the segment being appended to, it becomes eligible for loading */
+static void _spool_close(void)
+{
+	if (spool_fd < 0)
+		return;
+
+	if (fsync_and_close(spool_fd, "dbd.spool"))
+		error("error from fsync_and_close");
+	spool_fd = -1;
+	spool_tail++;
+}
+
+/*
+ * Find segments left by a previous slurmctld. New records always start a new
+ * segment as the last one may have been cut short.
+ */
+static void _spool_init(void)
+{
+	DIR *f_dir;
+	struct dirent *dir_ent;
+	uint32_t seq, segs = 0, min_seq = 0, max_seq = 0;
+	char *end_ptr;
+
+	spool_fd = -1;
+	spool_head = spool_tail = spool_tail_cnt = spool_cnt = 0;
+
+	if (!(f_dir = opendir(slurm_conf.state_save_location))) {
+		error("opendir(%s): %m", slurm_conf.state_save_location);
+		return;
+	}
+	while ((dir_ent = readdir(f_dir))) {
+		if (xstrncmp(dir_ent->d_name, "dbd.spool.", 10))
+			continue;
+		seq = strtoul(dir_ent->d_name + 10, &end_ptr, 10);
+		if (end_ptr[0] != '\0')
+			continue;
+		if (!segs || (seq < min_seq))
+			min_seq = seq;
+		if (!segs || (seq > max_seq))
+			max_seq = seq;
+		segs++;
+	}
+	closedir(f_dir);
+
+	if (!segs)
+		return;
+
+	spool_head = min_seq;
+	spool_tail = max_seq + 1;
+	verbose("found %u dbd.spool segments to recover", segs);
+}
+
+/* Append buffer to the tail segment, RET SLURM_SUCCESS or SLURM_ERROR */
+static int _spool_write(buf_t *buffer)
+{
+	char *fname;
+
+	if (spool_fd < 0) {
+		fname = _spool_fname(spool_tail);
+		spool_fd = open(fname, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+				0600);
+		if (spool_fd < 0) {
+			error("Creating spool file %s: %m", fname);
+			xfree(fname);
+			return SLURM_ERROR;
+		}
+		xfree(fname);
+		spool_tail_cnt = 0;
+		if (_save_dbd_ver(spool_fd) != SLURM_SUCCESS) {
+			_spool_close();
+			return SLURM_ERROR;
+		}
+	}
+
+	if (_save_dbd_rec(spool_fd, buffer) != SLURM_SUCCESS)
+		return SLURM_ERROR;
+
+	spool_cnt++;
+	if (++spool_tail_cnt >= MAX(1, slurm_conf.max_dbd_msgs / 2))
+		_spool_close();
+
+	return SLURM_SUCCESS;
+}
+
+/* Move the oldest spooled segment onto the end of agent_list */
+static void _spool_load(void)
+{
+	char *fname;
+	int recovered;
+
+	if (_spool_empty())
+		return;
+	if (spool_head == spool_tail)
+		_spool_close();
+
+	fname = _spool_fname(spool_head);
+	recovered = _load_dbd_file(fname);
+	(void) unlink(fname);
+	xfree(fname);
+
+	spool_head++;
+	spool_cnt -= MIN(spool_cnt, recovered);
+	if (_spool_empty()) {
+		spool_head = spool_tail = spool_cnt = 0;
+		log_flag(AGENT, "dbd.spool drained");
+	}
+}
+
 /* Purge queued step records from the agent queue
  * RET number of records purged */
 static int _purge_step_req(void)
@@ -541,6 +698,10 @@ static void _max_dbd_msg_action(uint32_t *msg_cnt)
 		      *msg_cnt);
 	}
 
+	/* Overflow goes to the spool, nothing to purge */
+	if (max_dbd_msg_action == MAX_DBD_ACTION_SPOOL)
+		return;
+
 	/* MAX_DBD_ACTION_DISCARD */
 	if (*msg_cnt >= (slurm_conf.max_dbd_msgs - 1))
 		*msg_cnt -= _purge_step_req();
@@ -648,6 +809,11 @@ static void *_agent(void *x)
 
 		slurm_mutex_lock(&agent_lock);
 		cnt = list_count(agent_list);
+		if ((slurmdbd_conn->fd >= 0) &&
+		    (cnt < (slurm_conf.max_dbd_msgs / 2)) && !_spool_empty()) {
+			_spool_load();
+			cnt = list_count(agent_list);
+		}
 		if ((cnt == 0) || (slurmdbd_conn->fd < 0) ||
 		    (fail_time && (difftime(time(NULL), fail_time) < 10))) {
 			slurm_mutex_unlock(&slurmdbd_lock);
@@ -774,6 +940,7 @@ static void *_agent(void *x)
 
 	slurm_mutex_lock(&agent_lock);
 	_save_dbd_state();
+	_spool_close();
 
 	log_flag(AGENT, "slurmdbd agent ending with agent_count=%d",
 		 list_count(agent_list));
@@ -794,6 +961,7 @@ static void _create_agent(void)
 	if (agent_list == NULL) {
 		agent_list = list_create(slurmdbd_free_buffer);
 		_load_dbd_state();
+		_spool_init();
 	}
 
 	if (agent_tid == 0) {
@@ -942,6 +1110,21 @@ extern int slurmdbd_agent_send(uint16_t rpc_version, persist_msg_t *req)
 		(slurmdbd_conn->trigger_callbacks.dbd_fail)();
 	}
 
+	/*
+	 * Once anything is spooled new messages must follow it to keep the
+	 * order they are sent to the slurmdbd in.
+	 */
+	if (!_spool_empty() ||
+	    ((max_dbd_msg_action == MAX_DBD_ACTION_SPOOL) &&
+	     (cnt >= slurm_conf.max_dbd_msgs))) {
+		if (_spool_write(buffer) == SLURM_SUCCESS) {
+			free_buf(buffer);
+			goto end_it;
+		}
+		error("unable to spool %s request",
+		      slurmdbd_msg_type_2_str(req->msg_type, 1));
+	}
+
 	/* Handle action */
 	_max_dbd_msg_action(&cnt);
 
@@ -958,6 +1141,7 @@ extern int slurmdbd_agent_send(uint16_t rpc_version, persist_msg_t *req)
 		rc = SLURM_ERROR;
 	}
 
+end_it:
 	slurm_cond_broadcast(&agent_cond);
 	slurm_mutex_unlock(&agent_lock);
 	return rc;
@@ -1001,6 +1185,8 @@ extern void slurmdbd_agent_config_setup(void)
 			max_dbd_msg_action = MAX_DBD_ACTION_DISCARD;
 		else if (!xstrcasecmp(type, "exit"))
 			max_dbd_msg_action = MAX_DBD_ACTION_EXIT;
+		else if (!xstrcasecmp(type, "spool"))
+			max_dbd_msg_action = MAX_DBD_ACTION_SPOOL;
 		else
 			fatal("Unknown SlurmctldParameters option for max_dbd_msg_action '%s'",
 			      type);
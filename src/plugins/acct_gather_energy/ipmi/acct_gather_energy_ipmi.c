@@ -802,8 +802,8 @@ static int _get_joules_task(uint16_t delta)
 
 	xassert(context_id != -1);
 
-	if (slurm_get_node_energy(
-		    NULL, context_id, delta, &sensor_cnt, &energies)) {
+	if (acct_gather_energy_get_node_energy(
+		    context_id, delta, &sensor_cnt, &energies)) {
 		error("_get_joules_task: can't get info from slurmd");
 		return SLURM_ERROR;
 	}
@@ -135,6 +135,13 @@ static int nb_pkg = 0;
 
 static stepd_step_rec_t *job = NULL;
 
+/* Seconds a reading done by the slurmd may be reused by a step */
+#define NODE_ENERGY_DELTA 1
+
+static int context_id = -1;
+static bool slurmd_energy = false; /* step reads node energy via slurmd */
+static pthread_mutex_t rapl_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 extern void acct_gather_energy_p_conf_set(
 	int context_id_in, s_p_hashtbl_t *tbl);
 
@@ -299,7 +306,7 @@ _send_drain_request(void)
 	}
 }
 
-static void _get_joules_task(acct_gather_energy_t *energy)
+static void _get_joules_msr(acct_gather_energy_t *energy)
 {
 	int i;
 	double energy_units;
@@ -379,6 +386,65 @@ static void _get_joules_task(acct_gather_energy_t *energy)
 		 __func__, ret, energy->consumed_energy);
 }
 
+/*
+ * Get the node counters from the slurmd instead of reading the MSRs in every
+ * slurmstepd on the node. Steps polling within NODE_ENERGY_DELTA seconds of
+ * each other share a single reading done by the slurmd.
+ */
+static int _get_joules_slurmd(acct_gather_energy_t *energy)
+{
+	acct_gather_energy_t *node_energy = NULL;
+	uint16_t sensor_cnt = 0;
+	static uint32_t readings = 0;
+
+	if (acct_gather_energy_get_node_energy(context_id, NODE_ENERGY_DELTA,
+					       &sensor_cnt, &node_energy)) {
+		error("%s: can't get info from slurmd", __func__);
+		return SLURM_ERROR;
+	}
+	if (sensor_cnt != 1) {
+		error("%s: received %u sensors, 1 expected",
+		      __func__, sensor_cnt);
+		acct_gather_energy_destroy(node_energy);
+		return SLURM_ERROR;
+	}
+
+	if (node_energy->current_watts == NO_VAL) {
+		energy->current_watts = NO_VAL;
+	} else if (energy->consumed_energy) {
+		energy->consumed_energy = node_energy->consumed_energy -
+			energy->base_consumed_energy;
+		energy->current_watts = node_energy->current_watts;
+		energy->ave_watts = ((energy->ave_watts * readings) +
+				     energy->current_watts) / (readings + 1);
+		readings++;
+	} else {
+		/* Only count what is consumed from now on */
+		energy->consumed_energy = 1;
+		energy->base_consumed_energy = node_energy->consumed_energy;
+		energy->ave_watts = 0;
+		readings++;
+	}
+	energy->previous_consumed_energy = node_energy->consumed_energy;
+	energy->poll_time = node_energy->poll_time;
+
+	log_flag(ENERGY, "%s: consumed %"PRIu64" Joules (received %"PRIu64"(%u watts) from slurmd)",
+		 __func__, energy->consumed_energy,
+		 node_energy->consumed_energy, node_energy->current_watts);
+
+	acct_gather_energy_destroy(node_energy);
+
+	return SLURM_SUCCESS;
+}
+
+static void _get_joules_task(acct_gather_energy_t *energy)
+{
+	if (slurmd_energy)
+		(void) _get_joules_slurmd(energy);
+	else
+		_get_joules_msr(energy);
+}
+
 static int _running_profile(void)
 {
 	static bool run = false;
@@ -443,7 +509,9 @@ extern int acct_gather_energy_p_update_node_energy(void)
 	if (local_energy->current_watts == NO_VAL)
 		return rc;
 
+	slurm_mutex_lock(&rapl_mutex);
 	_get_joules_task(local_energy);
+	slurm_mutex_unlock(&rapl_mutex);
 
 	return rc;
 }
@@ -498,12 +566,18 @@ extern int acct_gather_energy_p_get_data(enum acct_energy_type data_type,
 		acct_gather_energy_p_conf_set(0, NULL);
 	}
 
+	slurm_mutex_lock(&rapl_mutex);
 	switch (data_type) {
 	case ENERGY_DATA_JOULES_TASK:
 	case ENERGY_DATA_NODE_ENERGY_UP:
 		if (local_energy->current_watts == NO_VAL)
 			energy->consumed_energy = NO_VAL64;
-		else
+		else if (running_in_slurmd()) {
+			/* Node counters, also handed to the steps */
+			_get_joules_task(local_energy);
+			memcpy(energy, local_energy,
+			       sizeof(acct_gather_energy_t));
+		} else
 			_get_joules_task(energy);
 		break;
 	case ENERGY_DATA_STRUCT:
@@ -522,6 +596,8 @@ extern int acct_gather_energy_p_get_data(enum acct_energy_type data_type,
 		rc = SLURM_ERROR;
 		break;
 	}
+	slurm_mutex_unlock(&rapl_mutex);
+
 	return rc;
 }
 
@@ -536,7 +612,9 @@ extern int acct_gather_energy_p_set_data(enum acct_energy_type data_type,
 	case ENERGY_DATA_RECONFIG:
 		break;
 	case ENERGY_DATA_PROFILE:
+		slurm_mutex_lock(&rapl_mutex);
 		_get_joules_task(local_energy);
+		slurm_mutex_unlock(&rapl_mutex);
 		_send_profile();
 		break;
 	case ENERGY_DATA_STEP_PTR:
@@ -571,12 +649,25 @@ extern void acct_gather_energy_p_conf_set(int context_id_in,
 	if (local_energy)
 		return;
 
+	local_energy = acct_gather_energy_alloc(1);
+	context_id = context_id_in;
+
+	/*
+	 * The slurmd already reads the package counters of the node, so get
+	 * them from there rather than having every step on the node open and
+	 * read the MSRs on its own.
+	 */
+	if (running_in_slurmstepd() &&
+	    (_get_joules_slurmd(local_energy) == SLURM_SUCCESS)) {
+		slurmd_energy = true;
+		debug("%s loaded, using node energy from slurmd", plugin_name);
+		return;
+	}
+
 	_hardware();
 	for (i = 0; i < nb_pkg; i++)
 		pkg_fd[i] = _open_msr(pkg2cpu[i]);
 
-	local_energy = acct_gather_energy_alloc(1);
-
 	result = _read_msr(pkg_fd[0], MSR_RAPL_POWER_UNIT);
 	if (result == 0)
 		local_energy->current_watts = NO_VAL;
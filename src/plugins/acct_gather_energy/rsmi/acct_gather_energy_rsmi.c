@@ -526,8 +526,8 @@ static int _get_joules_task(uint16_t delta)
 
 	xassert(context_id != -1);
 
-	if (slurm_get_node_energy(
-		    NULL, context_id, delta, &gpu_cnt, &energies)) {
+	if (acct_gather_energy_get_node_energy(
+		    context_id, delta, &gpu_cnt, &energies)) {
 		error("%s: can't get info from slurmd", __func__);
 		return SLURM_ERROR;
 	}
@@ -735,7 +735,8 @@ static int _get_joules_task(uint16_t delta)
 	 * 'delta' parameter means "use cache" if data is newer than delta
 	 * seconds ago, otherwise just inquiry ipmi again.
 	 */
-	if (slurm_get_node_energy(NULL, context_id, delta, &sensor_cnt, &new)) {
+	if (acct_gather_energy_get_node_energy(context_id, delta, &sensor_cnt,
+					       &new)) {
 		error("%s: can't get info from slurmd", __func__);
 		return SLURM_ERROR;
 	}
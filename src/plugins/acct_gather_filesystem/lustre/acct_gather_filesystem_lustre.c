@@ -56,6 +56,7 @@
 #include "src/slurmd/common/proctrack.h"
 #include "src/common/slurm_acct_gather_profile.h"
 
+#include "src/slurmd/common/node_counters.h"
 #include "src/slurmd/slurmd/slurmd.h"
 
 
@@ -66,6 +67,7 @@
 #define _DEBUG 1
 #define _DEBUG_FILESYSTEM 1
 #define FILESYSTEM_DEFAULT_PORT 1
+#define LUSTRE_CACHE_AGE 1	/* seconds a node wide sample is reused */
 
 /*
  * These variables are required by the generic plugin interface.  If they
@@ -108,6 +110,18 @@ typedef struct {
 static lustre_stats_t lstats = {0,0,0,0,0};
 static lustre_stats_t lstats_prev = {0,0,0,0,0};
 
+/* Client counters shared with the other steps through lustre_cache */
+enum {
+	LUSTRE_WRITE_SAMPLES,
+	LUSTRE_READ_SAMPLES,
+	LUSTRE_WRITE_BYTES,
+	LUSTRE_READ_BYTES,
+	LUSTRE_CNT
+};
+
+static node_counters_t *lustre_cache = NULL;
+static bool lustre_cache_tried = false;
+
 static pthread_mutex_t lustre_lock = PTHREAD_MUTEX_INITIALIZER;
 static int tres_pos = -1;
 
@@ -177,9 +191,9 @@ static int _check_lustre_fs(void)
 	return rc;
 }
 
-/* _read_lustre_counters()
+/* _sample_lustre()
  *
- * Read counters from all mounted lustre fs
+ * Sum the counters of all mounted lustre fs
  * from the file stats under the directories:
  *
  * /proc/fs/lustre/llite/lustre-xxxx
@@ -192,14 +206,15 @@ static int _check_lustre_fs(void)
  * write_bytes         9007 samples [bytes] 2 4194304 31008331389
  *
  */
-static int _read_lustre_counters(void)
+static int _sample_lustre(uint64_t *counters, int cnt)
 {
 	char *lustre_dir;
 	DIR *proc_dir;
 	struct dirent *entry;
 	FILE *fff;
 	char buffer[BUFSIZ];
-	static bool first = true;
+
+	xassert(cnt == LUSTRE_CNT);
 
 	lustre_dir = _llite_path();
 	if (!lustre_dir) {
@@ -213,6 +228,7 @@ static int _read_lustre_counters(void)
 		return SLURM_ERROR;
 	}
 
+	memset(counters, 0, sizeof(uint64_t) * cnt);
 	while ((entry = readdir(proc_dir))) {
 		char *path_stats = NULL;
 		bool bread;
@@ -262,17 +278,53 @@ static int _read_lustre_counters(void)
 		}
 		fclose(fff);
 
-		lstats.write_bytes += write_bytes;
-		lstats.read_bytes += read_bytes;
-		lstats.write_samples += write_samples;
-		lstats.read_samples += read_samples;
+		counters[LUSTRE_WRITE_BYTES] += write_bytes;
+		counters[LUSTRE_READ_BYTES] += read_bytes;
+		counters[LUSTRE_WRITE_SAMPLES] += write_samples;
+		counters[LUSTRE_READ_SAMPLES] += read_samples;
 		debug3("%s: write_bytes %"PRIu64" read_bytes %"PRIu64,
-		       __func__, lstats.write_bytes, lstats.read_bytes);
+		       __func__, counters[LUSTRE_WRITE_BYTES],
+		       counters[LUSTRE_READ_BYTES]);
 		debug3("%s: write_samples %"PRIu64" read_samples %"PRIu64,
-		       __func__, lstats.write_samples, lstats.read_samples);
+		       __func__, counters[LUSTRE_WRITE_SAMPLES],
+		       counters[LUSTRE_READ_SAMPLES]);
 	} /* while ((entry = readdir(proc_dir))) */
 	closedir(proc_dir);
 
+	return SLURM_SUCCESS;
+}
+
+/* _read_lustre_counters()
+ *
+ * Update lstats with the node's Lustre client counters. Every step on the
+ * node reads the same stats, so one sample per LUSTRE_CACHE_AGE is shared
+ * between them instead of each step scanning all the llite directories.
+ */
+static int _read_lustre_counters(void)
+{
+	uint64_t counters[LUSTRE_CNT];
+	static bool first = true;
+	int rc;
+
+	if (!lustre_cache_tried) {
+		char *name = xstrdup_printf("%s_lustre", conf->node_name);
+		lustre_cache_tried = true;
+		lustre_cache = node_counters_open(conf->spooldir, name,
+						  LUSTRE_CNT);
+		xfree(name);
+	}
+	if (lustre_cache)
+		rc = node_counters_get(lustre_cache, LUSTRE_CACHE_AGE,
+				       _sample_lustre, counters, NULL);
+	else
+		rc = _sample_lustre(counters, LUSTRE_CNT);
+	if (rc != SLURM_SUCCESS)
+		return rc;
+
+	lstats.write_samples = counters[LUSTRE_WRITE_SAMPLES];
+	lstats.read_samples = counters[LUSTRE_READ_SAMPLES];
+	lstats.write_bytes = counters[LUSTRE_WRITE_BYTES];
+	lstats.read_bytes = counters[LUSTRE_READ_BYTES];
 	lstats.update_time = time(NULL);
 
 	if (first) {
@@ -393,6 +445,9 @@ extern int fini(void)
 	if (!running_in_slurmstepd())
 		return SLURM_SUCCESS;
 
+	node_counters_close(lustre_cache);
+	lustre_cache = NULL;
+
 	log_flag(FILESYSTEM, "lustre: ended");
 
 	return SLURM_SUCCESS;
@@ -54,6 +54,7 @@
 #include "src/slurmd/common/proctrack.h"
 #include "src/common/slurm_acct_gather_profile.h"
 
+#include "src/slurmd/common/node_counters.h"
 #include "src/slurmd/slurmd/slurmd.h"
 #include "acct_gather_interconnect_ofed.h"
 
@@ -73,6 +74,7 @@
 #define _DEBUG_INTERCONNECT 1
 #define TIMEOUT 20
 #define IB_FREQ 4
+#define OFED_CACHE_AGE 1	/* seconds a node wide sample is reused */
 
 /*
  * These variables are required by the generic plugin interface.  If they
@@ -129,6 +131,18 @@ typedef struct {
 
 static ofed_sens_t ofed_sens = {0,0,0,0,0,0,0,0};
 
+/* Port counters shared with the other steps through ofed_cache */
+enum {
+	OFED_XMT_BYTES,
+	OFED_RCV_BYTES,
+	OFED_XMT_PKTS,
+	OFED_RCV_PKTS,
+	OFED_CNT
+};
+
+static node_counters_t *ofed_cache = NULL;
+static bool ofed_cache_tried = false;
+
 static uint8_t pc[1024];
 
 static slurm_ofed_conf_t ofed_conf;
@@ -160,98 +174,118 @@ static uint8_t *_slurm_pma_query_via(void *rcvbuf, ib_portid_t * dest, int port,
 #endif
 }
 
-/*
- * _read_ofed_values read the IB sensor and update last_update values and times
- */
-static int _read_ofed_values(void)
+/* Open the port used for the performance queries, on first use */
+static int _open_port(void)
 {
-	static uint64_t last_update_xmtdata = 0;
-	static uint64_t last_update_rcvdata = 0;
-	static uint64_t last_update_xmtpkts = 0;
-	static uint64_t last_update_rcvpkts = 0;
-	static bool first = true;
+	int mgmt_classes[4] = {IB_SMI_CLASS, IB_SMI_DIRECT_CLASS,
+			       IB_SA_CLASS, IB_PERFORMANCE_CLASS};
 
-	int rc = SLURM_SUCCESS;
-
-	uint16_t cap_mask;
-	uint64_t send_val, recv_val, send_pkts, recv_pkts;
-
-	ofed_sens.last_update_time = ofed_sens.update_time;
-	ofed_sens.update_time = time(NULL);
+	if (srcport)
+		return SLURM_SUCCESS;
 
-	if (first) {
-		int mgmt_classes[4] = {IB_SMI_CLASS, IB_SMI_DIRECT_CLASS,
-				       IB_SA_CLASS, IB_PERFORMANCE_CLASS};
-		srcport = mad_rpc_open_port(NULL, ofed_conf.port,
-					    mgmt_classes, 4);
-		if (!srcport) {
-			debug("%s: Failed to open port '%d'",
-			      __func__, ofed_conf.port);
-			debug("OFED: failed");
-			return SLURM_ERROR;
-		}
+	srcport = mad_rpc_open_port(NULL, ofed_conf.port, mgmt_classes, 4);
+	if (!srcport) {
+		debug("%s: Failed to open port '%d'",
+		      __func__, ofed_conf.port);
+		debug("OFED: failed");
+		return SLURM_ERROR;
+	}
 
-		if (ib_resolve_self_via(&portid, &port, 0, srcport) < 0)
-			error("can't resolve self port %d", port);
+	if (ib_resolve_self_via(&portid, &port, 0, srcport) < 0)
+		error("can't resolve self port %d", port);
 
-		memset(pc, 0, sizeof(pc));
-		if (!_slurm_pma_query_via(pc, &portid, port, ibd_timeout,
-					  CLASS_PORT_INFO, srcport))
-			error("classportinfo query: %m");
+	memset(pc, 0, sizeof(pc));
+	if (!_slurm_pma_query_via(pc, &portid, port, ibd_timeout,
+				  CLASS_PORT_INFO, srcport))
+		error("classportinfo query: %m");
 
-		memcpy(&cap_mask, pc + 2, sizeof(cap_mask));
-		if (!_slurm_pma_query_via(pc, &portid, port, ibd_timeout,
-					  IB_GSI_PORT_COUNTERS_EXT, srcport)) {
-			error("ofed: %m");
-			return SLURM_ERROR;
-		}
+	log_flag(INTERCONNECT, "%s ofed init", plugin_name);
 
-		mad_decode_field(pc, IB_PC_EXT_XMT_BYTES_F,
-				 &last_update_xmtdata);
-		mad_decode_field(pc, IB_PC_EXT_RCV_BYTES_F,
-				 &last_update_rcvdata);
-		mad_decode_field(pc, IB_PC_EXT_XMT_PKTS_F,
-				 &last_update_xmtpkts);
-		mad_decode_field(pc, IB_PC_EXT_RCV_PKTS_F,
-				 &last_update_rcvpkts);
+	return SLURM_SUCCESS;
+}
 
-		log_flag(INTERCONNECT, "%s ofed init", plugin_name);
+/*
+ * Read the cumulative counters of the port, data is counted in 4 octet
+ * words. Called by whichever step on the node takes the shared sample.
+ */
+static int _sample_ofed(uint64_t *counters, int cnt)
+{
+	xassert(cnt == OFED_CNT);
 
-		first = 0;
-		return SLURM_SUCCESS;
-	}
+	if (_open_port() != SLURM_SUCCESS)
+		return SLURM_ERROR;
 
 	memset(pc, 0, sizeof(pc));
-	memcpy(&cap_mask, pc + 2, sizeof(cap_mask));
 	if (!_slurm_pma_query_via(pc, &portid, port, ibd_timeout,
 				  IB_GSI_PORT_COUNTERS_EXT, srcport)) {
 		error("ofed: %m");
 		return SLURM_ERROR;
 	}
 
-	mad_decode_field(pc, IB_PC_EXT_XMT_BYTES_F, &send_val);
-	mad_decode_field(pc, IB_PC_EXT_RCV_BYTES_F, &recv_val);
-	mad_decode_field(pc, IB_PC_EXT_XMT_PKTS_F, &send_pkts);
-	mad_decode_field(pc, IB_PC_EXT_RCV_PKTS_F, &recv_pkts);
+	mad_decode_field(pc, IB_PC_EXT_XMT_BYTES_F, &counters[OFED_XMT_BYTES]);
+	mad_decode_field(pc, IB_PC_EXT_RCV_BYTES_F, &counters[OFED_RCV_BYTES]);
+	mad_decode_field(pc, IB_PC_EXT_XMT_PKTS_F, &counters[OFED_XMT_PKTS]);
+	mad_decode_field(pc, IB_PC_EXT_RCV_PKTS_F, &counters[OFED_RCV_PKTS]);
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * _read_ofed_values read the IB sensor and update last_update values and times
+ */
+static int _read_ofed_values(void)
+{
+	static uint64_t last[OFED_CNT];
+	static bool first = true;
+	uint64_t counters[OFED_CNT];
+	int rc;
 
-	ofed_sens.xmtdata = (send_val - last_update_xmtdata) * 4;
+	ofed_sens.last_update_time = ofed_sens.update_time;
+	ofed_sens.update_time = time(NULL);
+
+	/*
+	 * Every step on the node polls the same port, so share one sample per
+	 * OFED_CACHE_AGE between them instead of querying it from each step.
+	 */
+	if (!ofed_cache_tried) {
+		char *name = xstrdup_printf("%s_ofed_%u", conf->node_name,
+					    ofed_conf.port);
+		ofed_cache_tried = true;
+		ofed_cache = node_counters_open(conf->spooldir, name,
+						OFED_CNT);
+		xfree(name);
+	}
+	if (ofed_cache)
+		rc = node_counters_get(ofed_cache, OFED_CACHE_AGE,
+				       _sample_ofed, counters, NULL);
+	else
+		rc = _sample_ofed(counters, OFED_CNT);
+	if (rc != SLURM_SUCCESS)
+		return rc;
+
+	/* The step's usage is what changed since its own last sample */
+	if (first) {
+		memcpy(last, counters, sizeof(last));
+		first = false;
+		return SLURM_SUCCESS;
+	}
+
+	ofed_sens.xmtdata = (counters[OFED_XMT_BYTES] - last[OFED_XMT_BYTES]) *
+			    4;
 	ofed_sens.total_xmtdata += ofed_sens.xmtdata;
-	ofed_sens.rcvdata = (recv_val - last_update_rcvdata) * 4;
+	ofed_sens.rcvdata = (counters[OFED_RCV_BYTES] - last[OFED_RCV_BYTES]) *
+			    4;
 	ofed_sens.total_rcvdata += ofed_sens.rcvdata;
-	ofed_sens.xmtpkts = send_pkts - last_update_xmtpkts;
+	ofed_sens.xmtpkts = counters[OFED_XMT_PKTS] - last[OFED_XMT_PKTS];
 	ofed_sens.total_xmtpkts += ofed_sens.xmtpkts;
-	ofed_sens.rcvpkts = recv_pkts - last_update_rcvpkts;
+	ofed_sens.rcvpkts = counters[OFED_RCV_PKTS] - last[OFED_RCV_PKTS];
 	ofed_sens.total_rcvpkts += ofed_sens.rcvpkts;
 
-	last_update_xmtdata = send_val;
-	last_update_rcvdata = recv_val;
-	last_update_xmtpkts = send_pkts;
-	last_update_rcvpkts = recv_pkts;
+	memcpy(last, counters, sizeof(last));
 
-	return rc;
+	return SLURM_SUCCESS;
 }
 
-
 /*
  * _thread_update_node_energy calls _read_ipmi_values and updates all values
  * for node consumption
@@ -342,6 +376,8 @@ extern int fini(void)
 
 	if (srcport)
 		mad_rpc_close_port(srcport);
+	node_counters_close(ofed_cache);
+	ofed_cache = NULL;
 
 	log_flag(INTERCONNECT, "ofed: ended");
 
@@ -64,12 +64,10 @@
 #include "src/slurmd/common/proctrack.h"
 #include "hdf5_api.h"
 
-#define HDF5_CHUNK_SIZE 10
-/* Compression level, a value of 0 through 9. Level 0 is faster but offers the
- * least compression; level 9 is slower but offers maximum compression.
- * A setting of -1 indicates that no compression is desired. */
-/* TODO: Make this configurable with a parameter */
-#define HDF5_COMPRESS 0
+/* Number of records per chunk, also the number written at once */
+#define HDF5_CHUNK_SIZE 128
+/* Seconds buffered records may wait for the writer thread */
+#define HDF5_FLUSH_INTERVAL 30
 
 /*
  * These variables are required by the generic plugin interface.  If they
@@ -103,13 +101,29 @@ const uint32_t plugin_version = SLURM_VERSION_NUMBER;
 typedef struct {
 	char *dir;
 	uint32_t def;
+	/*
+	 * Compression level, a value of 0 through 9. Level 1 is faster but
+	 * offers the least compression; level 9 is slower but offers maximum
+	 * compression. A setting of 0 indicates that no compression is
+	 * desired.
+	 */
+	uint16_t compress;
 } slurm_hdf5_conf_t;
 
 typedef struct {
 	hid_t  table_id;
 	size_t type_size;
+	uint8_t *buf;		/* records waiting for the writer thread */
+	size_t buf_cnt;
+	size_t buf_max;
 } table_t;
 
+typedef struct {
+	hid_t table_id;
+	uint8_t *buf;
+	size_t buf_cnt;
+} table_flush_t;
+
 // Global HDF5 Variables
 //	The HDF5 file and base objects will remain open for the duration of the
 //	step. This avoids reconstruction on every acct_gather_sample and
@@ -132,10 +146,23 @@ static table_t *tables = NULL;
 static size_t   tables_max_len = 0;
 static size_t   tables_cur_len = 0;
 
+/*
+ * Samples are buffered per table by the sampling thread and appended to the
+ * file by a writer thread. The HDF5 library is not thread safe, so every
+ * HDF5 call is done under hdf5_lock. When both locks are needed hdf5_lock
+ * is taken first.
+ */
+static pthread_mutex_t hdf5_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t tables_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writer_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t writer_tid = 0;
+static bool writer_shutdown = false;
+
 static void _reset_slurm_profile_conf(void)
 {
 	xfree(hdf5_conf.dir);
 	hdf5_conf.def = ACCT_GATHER_PROFILE_NONE;
+	hdf5_conf.compress = 0;
 }
 
 static uint32_t _determine_profile(void)
@@ -199,6 +226,75 @@ static int _create_directories(void)
 	return SLURM_SUCCESS;
 }
 
+/* Append all buffered records to their table */
+static void _flush_tables(void)
+{
+	table_flush_t *flush = NULL;
+	size_t i, flush_cnt = 0;
+
+	slurm_mutex_lock(&hdf5_lock);
+	slurm_mutex_lock(&tables_lock);
+	for (i = 0; i < tables_cur_len; i++) {
+		if (!tables[i].buf_cnt)
+			continue;
+		if (!flush)
+			flush = xcalloc(tables_cur_len, sizeof(table_flush_t));
+		flush[flush_cnt].table_id = tables[i].table_id;
+		flush[flush_cnt].buf = tables[i].buf;
+		flush[flush_cnt].buf_cnt = tables[i].buf_cnt;
+		flush_cnt++;
+		tables[i].buf = NULL;
+		tables[i].buf_cnt = 0;
+		tables[i].buf_max = 0;
+	}
+	slurm_mutex_unlock(&tables_lock);
+
+	for (i = 0; i < flush_cnt; i++) {
+		if (H5PTappend(flush[i].table_id, flush[i].buf_cnt,
+			       flush[i].buf) < 0)
+			error("PROFILE: Impossible to add %zu records to the table",
+			      flush[i].buf_cnt);
+		xfree(flush[i].buf);
+	}
+	slurm_mutex_unlock(&hdf5_lock);
+
+	xfree(flush);
+}
+
+static void *_writer_thread(void *arg)
+{
+	struct timespec ts = {0, 0};
+
+	slurm_mutex_lock(&tables_lock);
+	while (!writer_shutdown) {
+		ts.tv_sec = time(NULL) + HDF5_FLUSH_INTERVAL;
+		slurm_cond_timedwait(&writer_cond, &tables_lock, &ts);
+		slurm_mutex_unlock(&tables_lock);
+		_flush_tables();
+		slurm_mutex_lock(&tables_lock);
+	}
+	slurm_mutex_unlock(&tables_lock);
+
+	/* Write whatever came in before shutdown */
+	_flush_tables();
+
+	return NULL;
+}
+
+static void _stop_writer(void)
+{
+	if (!writer_tid)
+		return;
+
+	slurm_mutex_lock(&tables_lock);
+	writer_shutdown = true;
+	slurm_cond_signal(&writer_cond);
+	slurm_mutex_unlock(&tables_lock);
+
+	pthread_join(writer_tid, NULL);
+	writer_tid = 0;
+}
+
 /*
  * init() is called when the plugin is loaded, before any other functions
  * are called.  Put global initialization here.
@@ -229,6 +325,7 @@ extern void acct_gather_profile_p_conf_options(s_p_options_t **full_options,
 	s_p_options_t options[] = {
 		{"ProfileHDF5Dir", S_P_STRING},
 		{"ProfileHDF5Default", S_P_STRING},
+		{"ProfileHDF5Compress", S_P_UINT16},
 		{NULL} };
 
 	transfer_s_p_options(full_options, options, full_options_cnt);
@@ -251,6 +348,11 @@ extern void acct_gather_profile_p_conf_set(s_p_hashtbl_t *tbl)
 			}
 			xfree(tmp);
 		}
+		if (s_p_get_uint16(&hdf5_conf.compress, "ProfileHDF5Compress",
+				   tbl) && (hdf5_conf.compress > 9)) {
+			fatal("ProfileHDF5Compress can not be set to %u, please specify a value from 0 to 9",
+			      hdf5_conf.compress);
+		}
 	}
 
 	if (!hdf5_conf.dir)
@@ -364,6 +466,9 @@ extern int acct_gather_profile_p_node_step_start(stepd_step_rec_t* job)
 	put_string_attribute(gid_node, ATTR_STARTTIME,
 			     slurm_ctime2(&step_start_time));
 
+	writer_shutdown = false;
+	slurm_thread_create(&writer_tid, _writer_thread, NULL);
+
 	return rc;
 }
 
@@ -401,9 +506,13 @@ extern int acct_gather_profile_p_node_step_end(void)
 
 	log_flag(PROFILE, "PROFILE: node_step_end (shutdown)");
 
+	/* write the buffered records before closing the tables */
+	_stop_writer();
+
 	/* close tables */
 	for (i = 0; i < tables_cur_len; ++i) {
 		H5PTclose(tables[i].table_id);
+		xfree(tables[i].buf);
 	}
 	/* close groups */
 	for (i = 0; i < groups_len; ++i) {
@@ -451,8 +560,12 @@ extern int acct_gather_profile_p_task_end(pid_t taskpid)
 
 extern int64_t acct_gather_profile_p_create_group(const char* name)
 {
-	hid_t gid_group = make_group(gid_node, name);
+	hid_t gid_group;
+
+	slurm_mutex_lock(&hdf5_lock);
+	gid_group = make_group(gid_node, name);
 	if (gid_group < 0) {
+		slurm_mutex_unlock(&hdf5_lock);
 		return SLURM_ERROR;
 	}
 
@@ -460,25 +573,22 @@ extern int64_t acct_gather_profile_p_create_group(const char* name)
 	groups = xrealloc(groups, (groups_len + 1) * sizeof(hid_t));
 	groups[groups_len] = gid_group;
 	++groups_len;
+	slurm_mutex_unlock(&hdf5_lock);
 
 	return gid_group;
 }
 
-extern int acct_gather_profile_p_create_dataset(
-	const char* name, int64_t parent,
-	acct_gather_profile_dataset_t *dataset)
+static int _create_dataset(const char *name, int64_t parent,
+			   acct_gather_profile_dataset_t *dataset)
 {
 	size_t type_size;
 	size_t offset, field_size;
 	hid_t dtype_id;
 	hid_t field_id;
 	hid_t table_id;
+	int compress = -1, table_inx;
 	acct_gather_profile_dataset_t *dataset_loc = dataset;
-
-	if (g_profile_running <= ACCT_GATHER_PROFILE_NONE)
-		return SLURM_ERROR;
-
-	debug("acct_gather_profile_p_create_dataset %s", name);
+	static bool deflate_warned = false;
 
 	/* compute the size of the type needed to create the table */
 	type_size = sizeof(uint64_t) * 2; /* size for time field */
@@ -539,8 +649,16 @@ extern int acct_gather_profile_p_create_dataset(
 	/* create the table */
 	if (parent < 0)
 		parent = gid_node; /* default parent is the node group */
+	if (hdf5_conf.compress) {
+		if (H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0)
+			compress = hdf5_conf.compress;
+		else if (!deflate_warned) {
+			error("PROFILE: HDF5 library lacks deflate support, ProfileHDF5Compress ignored");
+			deflate_warned = true;
+		}
+	}
 	table_id = H5PTcreate_fl(parent, name, dtype_id, HDF5_CHUNK_SIZE,
-	                         HDF5_COMPRESS);
+	                         compress);
 	if (table_id < 0) {
 		error("PROFILE: Impossible to create the table %s", name);
 		H5Tclose(dtype_id);
@@ -548,6 +666,7 @@ extern int acct_gather_profile_p_create_dataset(
 	}
 	H5Tclose(dtype_id); /* close the datatype since H5PT keeps a copy */
 
+	slurm_mutex_lock(&tables_lock);
 	/* resize the tables array if full */
 	if (tables_cur_len == tables_max_len) {
 		if (tables_max_len == 0)
@@ -557,18 +676,38 @@ extern int acct_gather_profile_p_create_dataset(
 	}
 
 	/* reserve a new table */
+	memset(&tables[tables_cur_len], 0, sizeof(table_t));
 	tables[tables_cur_len].table_id  = table_id;
 	tables[tables_cur_len].type_size = type_size;
-	++tables_cur_len;
+	table_inx = tables_cur_len++;
+	slurm_mutex_unlock(&tables_lock);
 
-	return tables_cur_len - 1;
+	return table_inx;
+}
+
+extern int acct_gather_profile_p_create_dataset(
+	const char* name, int64_t parent,
+	acct_gather_profile_dataset_t *dataset)
+{
+	int rc;
+
+	if (g_profile_running <= ACCT_GATHER_PROFILE_NONE)
+		return SLURM_ERROR;
+
+	debug("acct_gather_profile_p_create_dataset %s", name);
+
+	slurm_mutex_lock(&hdf5_lock);
+	rc = _create_dataset(name, parent, dataset);
+	slurm_mutex_unlock(&hdf5_lock);
+
+	return rc;
 }
 
 extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 						 time_t sample_time)
 {
-	table_t *ds = &tables[table_id];
-	uint8_t send_data[ds->type_size];
+	table_t *ds;
+	uint8_t *send_data;
 	int header_size = 0;
 	debug("acct_gather_profile_p_add_sample_data %d", table_id);
 
@@ -591,6 +730,15 @@ extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 	if (g_profile_running <= ACCT_GATHER_PROFILE_NONE)
 		return SLURM_ERROR;
 
+	slurm_mutex_lock(&tables_lock);
+	ds = &tables[table_id];
+	if (ds->buf_cnt == ds->buf_max) {
+		ds->buf_max = ds->buf_max ? (ds->buf_max * 2) :
+			HDF5_CHUNK_SIZE;
+		xrealloc(ds->buf, ds->buf_max * ds->type_size);
+	}
+	send_data = ds->buf + (ds->buf_cnt * ds->type_size);
+
 	/* prepend timestampe and relative time */
 	((uint64_t *)send_data)[0] = difftime(sample_time, step_start_time);
 	header_size += sizeof(uint64_t);
@@ -599,12 +747,10 @@ extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 
 	memcpy(send_data + header_size, data, ds->type_size - header_size);
 
-	/* append the record to the table */
-	if (H5PTappend(ds->table_id, 1, send_data) < 0) {
-		error("PROFILE: Impossible to add data to the table %d; "
-		      "maybe the table has not been created?", table_id);
-		return SLURM_ERROR;
-	}
+	/* the writer thread appends the records to the table */
+	if (++ds->buf_cnt >= HDF5_CHUNK_SIZE)
+		slurm_cond_signal(&writer_cond);
+	slurm_mutex_unlock(&tables_lock);
 
 	return SLURM_SUCCESS;
 }
@@ -625,6 +771,11 @@ extern void acct_gather_profile_p_conf_values(List *data)
 	key_pair->value = xstrdup(acct_gather_profile_to_string(hdf5_conf.def));
 	list_append(*data, key_pair);
 
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("ProfileHDF5Compress");
+	key_pair->value = xstrdup_printf("%u", hdf5_conf.compress);
+	list_append(*data, key_pair);
+
 	return;
 
 }
@@ -58,6 +58,11 @@
 #include <curl/curl.h>
 
 #include "src/common/slurm_xlator.h"
+
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+
 #include "src/common/fd.h"
 #include "src/common/slurm_acct_gather_profile.h"
 #include "src/common/slurm_protocol_api.h"
@@ -123,6 +128,9 @@ union data_t{
 	double	 d;
 };
 
+#define MAX_SEND_BACKOFF 60	/* seconds */
+#define MAX_SEND_BUFS 64	/* unsent buffers kept per step */
+
 static slurm_influxdb_conf_t influxdb_conf;
 static uint32_t g_profile_running = ACCT_GATHER_PROFILE_NOT_SET;
 static stepd_step_rec_t *g_job = NULL;
@@ -130,6 +138,16 @@ static stepd_step_rec_t *g_job = NULL;
 static char *datastr = NULL;
 static int datastrlen = 0;
 
+static pthread_mutex_t send_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t send_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t send_thread = 0;
+static bool send_shutdown = false;
+static List send_list = NULL;
+
+/* Only used by the sender thread */
+static CURL *curl_handle = NULL;
+static struct curl_slist *curl_headers = NULL;
+
 static table_t *tables = NULL;
 static size_t tables_max_len = 0;
 static size_t tables_cur_len = 0;
@@ -189,73 +207,131 @@ static size_t _write_callback(void *contents, size_t size, size_t nmemb,
 	return realsize;
 }
 
-/* Try to send data to influxdb */
-static int _send_data(const char *data)
+#ifdef HAVE_LIBZ
+/* Compress a buffer into a gzip stream, returns NULL on failure */
+static char *_gzip_data(const char *data, size_t len, size_t *out_len)
+{
+	z_stream strm;
+	char *out;
+
+	memset(&strm, 0, sizeof(strm));
+	if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+			 MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return NULL;
+
+	*out_len = deflateBound(&strm, len);
+	out = xmalloc(*out_len);
+	strm.next_in = (Bytef *) data;
+	strm.avail_in = len;
+	strm.next_out = (Bytef *) out;
+	strm.avail_out = *out_len;
+
+	if (deflate(&strm, Z_FINISH) != Z_STREAM_END) {
+		(void) deflateEnd(&strm);
+		xfree(out);
+		return NULL;
+	}
+	*out_len = strm.total_out;
+	(void) deflateEnd(&strm);
+
+	return out;
+}
+#endif
+
+/*
+ * Set up the curl handle used by the sender thread for the whole step, so
+ * the connection to the influxdb server is kept open between posts.
+ */
+static CURL *_curl_handle_init(void)
+{
+	CURL *handle;
+	char *url = NULL;
+
+	if (!(handle = curl_easy_init())) {
+		error("%s %s: curl_easy_init: %m", plugin_type, __func__);
+		return NULL;
+	}
+
+	xstrfmtcat(url, "%s/write?db=%s&rp=%s&precision=s", influxdb_conf.host,
+		   influxdb_conf.database, influxdb_conf.rt_policy);
+	curl_easy_setopt(handle, CURLOPT_URL, url);
+	/* libcurl keeps its own copy of the URL */
+	xfree(url);
+
+	if (influxdb_conf.password)
+		curl_easy_setopt(handle, CURLOPT_PASSWORD,
+				 influxdb_conf.password);
+	if (influxdb_conf.username)
+		curl_easy_setopt(handle, CURLOPT_USERNAME,
+				 influxdb_conf.username);
+	curl_easy_setopt(handle, CURLOPT_POST, 1);
+	curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+	curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1);
+	curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, _write_callback);
+#ifdef HAVE_LIBZ
+	if (!curl_headers)
+		curl_headers = curl_slist_append(NULL,
+						 "Content-Encoding: gzip");
+	if (curl_headers)
+		curl_easy_setopt(handle, CURLOPT_HTTPHEADER, curl_headers);
+#endif
+
+	return handle;
+}
+
+/*
+ * Post one buffer of line protocol data to influxdb.
+ * IN data - buffer to send
+ * OUT retry - set if the post failed for a reason that may go away, such as
+ *	a connection failure or an overloaded server
+ * RET SLURM_SUCCESS or SLURM_ERROR
+ */
+static int _post_data(const char *data, bool *retry)
 {
-	CURL *curl_handle = NULL;
 	CURLcode res;
 	struct http_response chunk;
 	int rc = SLURM_SUCCESS;
 	long response_code;
 	static int error_cnt = 0;
-	char *url = NULL;
-	size_t length;
+	const char *body = data;
+	char *gzip_body = NULL;
+	size_t length = strlen(data);
 
 	debug3("%s %s called", plugin_type, __func__);
 
-	/*
-	 * Every compute node which is sampling data will try to establish a
-	 * different connection to the influxdb server. In order to reduce the
-	 * number of connections, every time a new sampled data comes in, it
-	 * is saved in the 'datastr' buffer. Once this buffer is full, then we
-	 * try to open the connection and send this buffer, instead of opening
-	 * one per sample.
-	 */
-	if (data && ((datastrlen + strlen(data)) <= BUF_SIZE)) {
-		xstrcat(datastr, data);
-		length = strlen(data);
-		datastrlen += length;
-		log_flag(PROFILE, "%s %s: %zu bytes of data added to buffer. New buffer size: %d",
-			 plugin_type, __func__, length, datastrlen);
-		return rc;
+	*retry = false;
+
+	if (!curl_handle && !(curl_handle = _curl_handle_init())) {
+		*retry = true;
+		return SLURM_ERROR;
 	}
 
 	DEF_TIMERS;
 	START_TIMER;
 
-	if (curl_global_init(CURL_GLOBAL_ALL) != 0) {
-		error("%s %s: curl_global_init: %m", plugin_type, __func__);
-		rc = SLURM_ERROR;
-		goto cleanup_global_init;
-	} else if ((curl_handle = curl_easy_init()) == NULL) {
-		error("%s %s: curl_easy_init: %m", plugin_type, __func__);
-		rc = SLURM_ERROR;
-		goto cleanup_easy_init;
+#ifdef HAVE_LIBZ
+	if ((gzip_body = _gzip_data(data, length, &length))) {
+		body = gzip_body;
+	} else {
+		error("%s %s: unable to compress data", plugin_type, __func__);
+		length = strlen(data);
+		/* Drop the Content-Encoding header for this post */
+		curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, NULL);
 	}
-
-	xstrfmtcat(url, "%s/write?db=%s&rp=%s&precision=s", influxdb_conf.host,
-		   influxdb_conf.database, influxdb_conf.rt_policy);
+#endif
 
 	chunk.message = xmalloc(1);
 	chunk.size = 0;
 
-	curl_easy_setopt(curl_handle, CURLOPT_URL, url);
-	if (influxdb_conf.password)
-		curl_easy_setopt(curl_handle, CURLOPT_PASSWORD,
-				 influxdb_conf.password);
-	curl_easy_setopt(curl_handle, CURLOPT_POST, 1);
-	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, datastr);
-	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE, strlen(datastr));
-	if (influxdb_conf.username)
-		curl_easy_setopt(curl_handle, CURLOPT_USERNAME,
-				 influxdb_conf.username);
-	curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, _write_callback);
+	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, body);
+	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE, length);
 	curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *) &chunk);
 
 	if ((res = curl_easy_perform(curl_handle)) != CURLE_OK) {
 		if ((error_cnt++ % 100) == 0)
-			error("%s %s: curl_easy_perform failed to send data (discarded). Reason: %s",
+			error("%s %s: curl_easy_perform failed to send data. Reason: %s",
 			      plugin_type, __func__, curl_easy_strerror(res));
+		*retry = true;
 		rc = SLURM_ERROR;
 		goto cleanup;
 	}
@@ -280,38 +356,157 @@ static int _send_data(const char *data)
 			error_cnt = 0;
 	} else {
 		rc = SLURM_ERROR;
+		if ((response_code >= 500) || (response_code == 429))
+			*retry = true;
 		debug2("%s %s: data write failed, response code: %ld",
 		       plugin_type, __func__, response_code);
 		if (slurm_conf.debug_flags & DEBUG_FLAG_PROFILE) {
 			/* Strip any trailing newlines. */
-			while (chunk.message[strlen(chunk.message) - 1] == '\n')
-				chunk.message[strlen(chunk.message) - 1] = '\0';
+			while (chunk.size &&
+			       (chunk.message[chunk.size - 1] == '\n'))
+				chunk.message[--chunk.size] = '\0';
 			info("%s %s: JSON response body: %s", plugin_type,
 			     __func__, chunk.message);
 		}
 	}
 
 cleanup:
+#ifdef HAVE_LIBZ
+	if (!gzip_body && curl_headers)
+		curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, curl_headers);
+#endif
+	xfree(gzip_body);
 	xfree(chunk.message);
-	xfree(url);
-cleanup_easy_init:
-	curl_easy_cleanup(curl_handle);
-cleanup_global_init:
-	curl_global_cleanup();
 
 	END_TIMER;
 	log_flag(PROFILE, "%s %s: took %s to send data",
 		 plugin_type, __func__, TIME_STR);
 
-	if (data) {
-		datastr = xstrdup(data);
-		datastrlen = strlen(data);
-	} else {
-		datastr[0] = '\0';
+	return rc;
+}
+
+/*
+ * Sender thread, posts the buffers queued by _send_data() so the sampling
+ * thread never waits on the influxdb server. A buffer which fails for a
+ * transient reason is retried with an exponential backoff. Once the step
+ * ends the remaining buffers get a single try each.
+ */
+static void *_send_thread(void *arg)
+{
+	char *buf = NULL;
+	bool retry = false;
+	int backoff = 0;
+	struct timespec ts = {0, 0};
+	time_t deadline;
+
+	while (true) {
+		slurm_mutex_lock(&send_lock);
+		if (buf) {
+			deadline = time(NULL) + backoff;
+			while (!send_shutdown && (time(NULL) < deadline)) {
+				ts.tv_sec = deadline;
+				slurm_cond_timedwait(&send_cond, &send_lock,
+						     &ts);
+			}
+		} else {
+			while (!(buf = list_dequeue(send_list)) &&
+			       !send_shutdown)
+				slurm_cond_wait(&send_cond, &send_lock);
+		}
+		slurm_mutex_unlock(&send_lock);
+
+		if (!buf)
+			break;
+
+		if ((_post_data(buf, &retry) == SLURM_SUCCESS) || !retry) {
+			backoff = 0;
+		} else if (!send_shutdown) {
+			backoff = backoff ? MIN(backoff * 2, MAX_SEND_BACKOFF) :
+				  1;
+			log_flag(PROFILE, "%s %s: retrying in %ds",
+				 plugin_type, __func__, backoff);
+			continue;
+		} else {
+			/* Server unreachable, do not hold up the step end */
+			slurm_mutex_lock(&send_lock);
+			log_flag(PROFILE, "%s %s: discarding %d buffers",
+				 plugin_type, __func__,
+				 list_count(send_list) + 1);
+			list_flush(send_list);
+			slurm_mutex_unlock(&send_lock);
+		}
+		xfree(buf);
+	}
+
+	if (curl_handle)
+		curl_easy_cleanup(curl_handle);
+	curl_handle = NULL;
+	curl_slist_free_all(curl_headers);
+	curl_headers = NULL;
+
+	return NULL;
+}
+
+/*
+ * Add sampled data to the buffer. Every compute node which is sampling data
+ * would otherwise establish a different connection to the influxdb server
+ * per sample, so samples are saved in the 'datastr' buffer. Once this buffer
+ * is full, or when a flush is requested with data == NULL, it is handed to
+ * the sender thread.
+ */
+static int _send_data(const char *data)
+{
+	static int drop_cnt = 0;
+	size_t length = data ? strlen(data) : 0;
+
+	debug3("%s %s called", plugin_type, __func__);
+
+	slurm_mutex_lock(&send_lock);
+	if (data && ((datastrlen + length) <= BUF_SIZE)) {
+		xstrcat(datastr, data);
+		datastrlen += length;
+		log_flag(PROFILE, "%s %s: %zu bytes of data added to buffer. New buffer size: %d",
+			 plugin_type, __func__, length, datastrlen);
+		slurm_mutex_unlock(&send_lock);
+		return SLURM_SUCCESS;
+	}
+
+	if (datastrlen) {
+		if (list_count(send_list) >= MAX_SEND_BUFS) {
+			/* Keep the newest samples if the server falls behind */
+			xfree_ptr(list_dequeue(send_list));
+			if ((drop_cnt++ % 100) == 0)
+				error("%s %s: influxdb server not keeping up, discarding data",
+				      plugin_type, __func__);
+		}
+		list_enqueue(send_list, datastr);
+		slurm_cond_signal(&send_cond);
+		datastr = xmalloc(BUF_SIZE);
 		datastrlen = 0;
 	}
 
-	return rc;
+	if (data) {
+		xstrcat(datastr, data);
+		datastrlen = length;
+	}
+	slurm_mutex_unlock(&send_lock);
+
+	return SLURM_SUCCESS;
+}
+
+static void _stop_send_thread(void)
+{
+	if (!send_thread)
+		return;
+
+	slurm_mutex_lock(&send_lock);
+	send_shutdown = true;
+	slurm_cond_signal(&send_cond);
+	slurm_mutex_unlock(&send_lock);
+
+	pthread_join(send_thread, NULL);
+	send_thread = 0;
+	curl_global_cleanup();
 }
 
 /*
@@ -326,6 +521,7 @@ extern int init(void)
 		return SLURM_SUCCESS;
 
 	datastr = xmalloc(BUF_SIZE);
+	send_list = list_create(xfree_ptr);
 	return SLURM_SUCCESS;
 }
 
@@ -333,8 +529,10 @@ extern int fini(void)
 {
 	debug3("%s %s called", plugin_type, __func__);
 
+	_stop_send_thread();
 	_free_tables();
 	xfree(datastr);
+	FREE_NULL_LIST(send_list);
 	xfree(influxdb_conf.host);
 	xfree(influxdb_conf.database);
 	xfree(influxdb_conf.password);
@@ -445,6 +643,17 @@ extern int acct_gather_profile_p_node_step_start(stepd_step_rec_t* job)
 	debug2("%s %s: option --profile=%s", plugin_type, __func__,
 	       profile_str);
 	g_profile_running = _determine_profile();
+
+	if (g_profile_running > ACCT_GATHER_PROFILE_NONE) {
+		if (curl_global_init(CURL_GLOBAL_ALL) != 0) {
+			error("%s %s: curl_global_init: %m",
+			      plugin_type, __func__);
+			return SLURM_ERROR;
+		}
+		send_shutdown = false;
+		slurm_thread_create(&send_thread, _send_thread, NULL);
+	}
+
 	return rc;
 }
 
@@ -461,6 +670,10 @@ extern int acct_gather_profile_p_node_step_end(void)
 
 	xassert(running_in_slurmstepd());
 
+	/* Sampling has stopped, hand over what is left and wait for it */
+	_send_data(NULL);
+	_stop_send_thread();
+
 	return rc;
 }
 
@@ -41,6 +41,7 @@
 
 #include <inttypes.h>
 #include <munge.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -55,6 +56,7 @@
 
 #define RETRY_COUNT		20
 #define RETRY_USEC		100000
+#define DECODE_CTX_MAX		32
 
 /*
  * These variables are required by the generic plugin interface.  If they
@@ -88,6 +90,16 @@ const uint32_t plugin_version = SLURM_VERSION_NUMBER;
 
 static int bad_cred_test = -1;
 
+/*
+ * Idle munge contexts available for decoding, so busy daemons do not set up
+ * and tear down a context for every inbound message. Each context is used by
+ * one thread at a time. The socket each was configured for is kept alongside.
+ */
+static pthread_mutex_t decode_ctx_lock = PTHREAD_MUTEX_INITIALIZER;
+static munge_ctx_t decode_ctx[DECODE_CTX_MAX];
+static char *decode_ctx_socket[DECODE_CTX_MAX];
+static int decode_ctx_cnt = 0;
+
 /*
  * The Munge implementation of the slurm AUTH credential
  */
@@ -105,6 +117,8 @@ typedef struct {
 /* Static prototypes */
 
 static int _decode_cred(auth_credential_t *c, char *socket);
+static munge_ctx_t _get_decode_ctx(char *socket);
+static void _put_decode_ctx(munge_ctx_t ctx, char *socket);
 static void _print_cred(munge_ctx_t ctx);
 
 /*
@@ -122,6 +136,19 @@ int init(void)
 	return SLURM_SUCCESS;
 }
 
+extern int fini(void)
+{
+	slurm_mutex_lock(&decode_ctx_lock);
+	while (decode_ctx_cnt) {
+		decode_ctx_cnt--;
+		munge_ctx_destroy(decode_ctx[decode_ctx_cnt]);
+		xfree(decode_ctx_socket[decode_ctx_cnt]);
+	}
+	slurm_mutex_unlock(&decode_ctx_lock);
+
+	return SLURM_SUCCESS;
+}
+
 
 /*
  * Allocate a credential.  This function should return NULL if it cannot
@@ -419,16 +446,8 @@ static int _decode_cred(auth_credential_t *c, char *socket)
 	if (c->verified)
 		return SLURM_SUCCESS;
 
-	if ((ctx = munge_ctx_create()) == NULL) {
-		error("munge_ctx_create failure");
+	if (!(ctx = _get_decode_ctx(socket)))
 		return SLURM_ERROR;
-	}
-	if (socket &&
-	    (munge_ctx_set(ctx, MUNGE_OPT_SOCKET, socket) != EMUNGE_SUCCESS)) {
-		error("munge_ctx_set failure");
-		munge_ctx_destroy(ctx);
-		return SLURM_ERROR;
-	}
 
 again:
 	err = munge_decode(c->m_str, ctx, NULL, NULL, &c->uid, &c->gid);
@@ -477,10 +496,62 @@ again:
 	c->verified = true;
 
 done:
-	munge_ctx_destroy(ctx);
+	_put_decode_ctx(ctx, socket);
 	return err ? SLURM_ERROR : SLURM_SUCCESS;
 }
 
+/* Take an idle decode context for socket from the pool or create one */
+static munge_ctx_t _get_decode_ctx(char *socket)
+{
+	munge_ctx_t ctx = NULL;
+
+	slurm_mutex_lock(&decode_ctx_lock);
+	for (int i = decode_ctx_cnt - 1; i >= 0; i--) {
+		if (xstrcmp(decode_ctx_socket[i], socket))
+			continue;
+		ctx = decode_ctx[i];
+		xfree(decode_ctx_socket[i]);
+		decode_ctx_cnt--;
+		decode_ctx[i] = decode_ctx[decode_ctx_cnt];
+		decode_ctx_socket[i] = decode_ctx_socket[decode_ctx_cnt];
+		decode_ctx_socket[decode_ctx_cnt] = NULL;
+		break;
+	}
+	slurm_mutex_unlock(&decode_ctx_lock);
+
+	if (ctx)
+		return ctx;
+
+	if ((ctx = munge_ctx_create()) == NULL) {
+		error("munge_ctx_create failure");
+		return NULL;
+	}
+	if (socket &&
+	    (munge_ctx_set(ctx, MUNGE_OPT_SOCKET, socket) != EMUNGE_SUCCESS)) {
+		error("munge_ctx_set failure");
+		munge_ctx_destroy(ctx);
+		return NULL;
+	}
+
+	return ctx;
+}
+
+/* Return a decode context to the pool, or destroy it if the pool is full */
+static void _put_decode_ctx(munge_ctx_t ctx, char *socket)
+{
+	slurm_mutex_lock(&decode_ctx_lock);
+	if (decode_ctx_cnt < DECODE_CTX_MAX) {
+		decode_ctx[decode_ctx_cnt] = ctx;
+		decode_ctx_socket[decode_ctx_cnt] = xstrdup(socket);
+		decode_ctx_cnt++;
+		ctx = NULL;
+	}
+	slurm_mutex_unlock(&decode_ctx_lock);
+
+	if (ctx)
+		munge_ctx_destroy(ctx);
+}
+
 /*
  *  Print credential information.
  */
@@ -139,10 +139,61 @@ static char *_print_users(uid_t *buf)
 	return user_str;
 }
 
+/* Hash index of a burst buffer name */
+static int _name_hash(const char *name)
+{
+	int i, inx = 0;
+
+	if (!name)
+		return 0;
+	for (i = 1; *name; name++, i++)
+		inx += (int) *name * i;
+	return inx % BB_HASH_SIZE;
+}
+
+/* Add a burst buffer record to the job_id and name hash tables */
+static void _alloc_hash_add(bb_state_t *state_ptr, bb_alloc_t *bb_alloc)
+{
+	int inx;
+
+	if (bb_alloc->job_id) {
+		inx = bb_alloc->job_id % BB_HASH_SIZE;
+		bb_alloc->job_next = state_ptr->bb_ajhash[inx];
+		state_ptr->bb_ajhash[inx] = bb_alloc;
+	}
+
+	inx = _name_hash(bb_alloc->name);
+	bb_alloc->name_next = state_ptr->bb_anhash[inx];
+	state_ptr->bb_anhash[inx] = bb_alloc;
+}
+
+/* Remove a burst buffer record from the job_id and name hash tables */
+static void _alloc_hash_remove(bb_state_t *state_ptr, bb_alloc_t *bb_alloc)
+{
+	bb_alloc_t **bb_plink;
+
+	if (bb_alloc->job_id) {
+		bb_plink = &state_ptr->bb_ajhash[bb_alloc->job_id %
+						 BB_HASH_SIZE];
+		while (*bb_plink && (*bb_plink != bb_alloc))
+			bb_plink = &(*bb_plink)->job_next;
+		if (*bb_plink)
+			*bb_plink = bb_alloc->job_next;
+	}
+
+	bb_plink = &state_ptr->bb_anhash[_name_hash(bb_alloc->name)];
+	while (*bb_plink && (*bb_plink != bb_alloc))
+		bb_plink = &(*bb_plink)->name_next;
+	if (*bb_plink)
+		*bb_plink = bb_alloc->name_next;
+}
+
 /* Allocate burst buffer hash tables */
 extern void bb_alloc_cache(bb_state_t *state_ptr)
 {
 	state_ptr->bb_ahash = xmalloc(sizeof(bb_alloc_t *) * BB_HASH_SIZE);
+	state_ptr->bb_ajhash = xmalloc(sizeof(bb_alloc_t *) * BB_HASH_SIZE);
+	state_ptr->bb_anhash = xmalloc(sizeof(bb_alloc_t *) * BB_HASH_SIZE);
 	state_ptr->bb_jhash = xmalloc(sizeof(bb_job_t *)   * BB_HASH_SIZE);
 	state_ptr->bb_uhash = xmalloc(sizeof(bb_user_t *)  * BB_HASH_SIZE);
 }
@@ -167,6 +218,8 @@ extern void bb_clear_cache(bb_state_t *state_ptr)
 		}
 		xfree(state_ptr->bb_ahash);
 	}
+	xfree(state_ptr->bb_ajhash);
+	xfree(state_ptr->bb_anhash);
 
 	if (state_ptr->bb_jhash) {
 		for (i = 0; i < BB_HASH_SIZE; i++) {
@@ -244,7 +297,7 @@ extern bb_alloc_t *bb_find_alloc_rec(bb_state_t *state_ptr,
 
 	xassert(job_ptr);
 	xassert(state_ptr);
-	bb_alloc = state_ptr->bb_ahash[job_ptr->user_id % BB_HASH_SIZE];
+	bb_alloc = state_ptr->bb_ajhash[job_ptr->job_id % BB_HASH_SIZE];
 	while (bb_alloc) {
 		if (bb_alloc->job_id == job_ptr->job_id) {
 			if (bb_alloc->user_id == job_ptr->user_id) {
@@ -258,7 +311,7 @@ extern bb_alloc_t *bb_find_alloc_rec(bb_state_t *state_ptr,
 			 * the job state recovered was missing some jobs
 			 * which already had burst buffers configured. */
 		}
-		bb_alloc = bb_alloc->next;
+		bb_alloc = bb_alloc->job_next;
 	}
 	return bb_alloc;
 }
@@ -270,32 +323,22 @@ extern bb_alloc_t *bb_find_alloc_rec(bb_state_t *state_ptr,
 extern bb_alloc_t *bb_find_name_rec(char *bb_name, uint32_t user_id,
 				    bb_state_t *state_ptr)
 {
-	bb_alloc_t *bb_alloc = NULL;
-	int i, hash_inx = user_id % BB_HASH_SIZE;
+	bb_alloc_t *bb_alloc, *bb_other = NULL;
 
-	/* Try this user ID first */
-	bb_alloc = state_ptr->bb_ahash[hash_inx];
+	/* Prefer a buffer of this user ID, else any with this name */
+	bb_alloc = state_ptr->bb_anhash[_name_hash(bb_name)];
 	while (bb_alloc) {
-		if (!xstrcmp(bb_alloc->name, bb_name))
-			return bb_alloc;
-		bb_alloc = bb_alloc->next;
-	}
-
-	/* Now search all other records */
-	for (i = 0; i < BB_HASH_SIZE; i++) {
-		if (i == hash_inx)
-			continue;
-		bb_alloc = state_ptr->bb_ahash[i];
-		while (bb_alloc) {
-			if (!xstrcmp(bb_alloc->name, bb_name)) {
-				xassert(bb_alloc->magic == BB_ALLOC_MAGIC);
+		if (!xstrcmp(bb_alloc->name, bb_name)) {
+			xassert(bb_alloc->magic == BB_ALLOC_MAGIC);
+			if (bb_alloc->user_id == user_id)
 				return bb_alloc;
-			}
-			bb_alloc = bb_alloc->next;
+			if (!bb_other)
+				bb_other = bb_alloc;
 		}
+		bb_alloc = bb_alloc->name_next;
 	}
 
-	return bb_alloc;
+	return bb_other;
 }
 
 /* Find a per-user burst buffer record for a specific user ID */
@@ -1052,6 +1095,7 @@ extern bb_alloc_t *bb_alloc_name_rec(bb_state_t *state_ptr, char *name,
 	bb_alloc->state_time = now;
 	bb_alloc->seen_time = now;
 	bb_alloc->user_id = user_id;
+	_alloc_hash_add(state_ptr, bb_alloc);
 
 	return bb_alloc;
 }
@@ -1088,6 +1132,7 @@ extern bb_alloc_t *bb_alloc_job_rec(bb_state_t *state_ptr,
 	bb_alloc->state_time = time(NULL);
 	bb_alloc->seen_time = time(NULL);
 	bb_alloc->user_id = job_ptr->user_id;
+	_alloc_hash_add(state_ptr, bb_alloc);
 
 	return bb_alloc;
 }
@@ -1141,6 +1186,7 @@ extern bool bb_free_alloc_rec(bb_state_t *state_ptr, bb_alloc_t *bb_alloc)
 		if (bb_link == bb_alloc) {
 			xassert(bb_link->magic == BB_ALLOC_MAGIC);
 			*bb_plink = bb_alloc->next;
+			_alloc_hash_remove(state_ptr, bb_alloc);
 			bb_free_alloc_buf(bb_alloc);
 			state_ptr->last_update_time = time(NULL);
 			return true;
@@ -1151,6 +1197,15 @@ extern bool bb_free_alloc_rec(bb_state_t *state_ptr, bb_alloc_t *bb_alloc)
 	return false;
 }
 
+/* Set the job ID of a burst buffer record, keeping it hashed by job ID */
+extern void bb_set_alloc_job_id(bb_state_t *state_ptr, bb_alloc_t *bb_alloc,
+				uint32_t job_id)
+{
+	_alloc_hash_remove(state_ptr, bb_alloc);
+	bb_alloc->job_id = job_id;
+	_alloc_hash_add(state_ptr, bb_alloc);
+}
+
 /* Allocate a bb_job_t record, hashed by job_id, delete with bb_job_del() */
 extern bb_job_t *bb_job_alloc(bb_state_t *state_ptr, uint32_t job_id)
 {
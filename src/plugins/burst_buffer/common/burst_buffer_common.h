@@ -100,9 +100,11 @@ typedef struct bb_alloc {
 	time_t create_time;	/* Time of creation */
 	time_t end_time;	/* Expected time when use will end */
 	uint32_t id;		/* ID for reservation/accounting */
-	uint32_t job_id;
+	uint32_t job_id;	/* Set with bb_set_alloc_job_id() */
+	struct bb_alloc *job_next; /* Next in bb_state_t.bb_ajhash */
 	uint32_t magic;
-	char *name;		/* For persistent burst buffers */
+	char *name;		/* For persistent burst buffers, constant */
+	struct bb_alloc *name_next; /* Next in bb_state_t.bb_anhash */
 	struct bb_alloc *next;
 	bool orphaned;		/* Job is purged, could not stage-out data */
 	char *partition;	/* Associated partition (for limits) */
@@ -197,7 +199,9 @@ struct preempt_bb_recs {
 /* Current plugin state information */
 typedef struct bb_state {
 	bb_config_t	bb_config;
-	bb_alloc_t **	bb_ahash;	/* Allocation buffers, hash by job_id */
+	bb_alloc_t **	bb_ahash;	/* Allocation buffers, hash by user_id */
+	bb_alloc_t **	bb_ajhash;	/* Allocation buffers, hash by job_id */
+	bb_alloc_t **	bb_anhash;	/* Allocation buffers, hash by name */
 	bb_job_t **	bb_jhash;	/* Job state, hash by job_id */
 	bb_user_t **	bb_uhash;	/* User limit, hash by user_id */
 	pthread_mutex_t	bb_mutex;
@@ -268,6 +272,10 @@ extern bb_user_t *bb_find_user_rec(uint32_t user_id, bb_state_t *state_ptr);
  * RET true if found, false otherwise */
 extern bool bb_free_alloc_rec(bb_state_t *state_ptr, bb_alloc_t *bb_ptr);
 
+/* Set the job ID of a burst buffer record, keeping it hashed by job ID */
+extern void bb_set_alloc_job_id(bb_state_t *state_ptr, bb_alloc_t *bb_alloc,
+				uint32_t job_id);
+
 /* Free memory associated with allocated bb record, caller is responsible for
  * maintaining linked list */
 extern void bb_free_alloc_buf(bb_alloc_t *bb_alloc);
@@ -988,7 +988,8 @@ static void _recover_bb_state(void)
 			bb_alloc->id = id;
 			last_persistent_id = MAX(last_persistent_id, id);
 			if (name && (name[0] >='0') && (name[0] <='9')) {
-				bb_alloc->job_id = strtol(name, &end_ptr, 10);
+				bb_set_alloc_job_id(&bb_state, bb_alloc,
+						    strtol(name, &end_ptr, 10));
 				bb_alloc->array_job_id = bb_alloc->job_id;
 				bb_alloc->array_task_id = NO_VAL;
 			}
@@ -2488,21 +2489,21 @@ static int _test_size_limit(job_record_t *job_ptr, bb_job_t *bb_job)
 			    (bb_ptr->use_time > now) &&
 			    (bb_ptr->use_time > job_ptr->start_time)) {
 				if (!bb_ptr->pool) {
-					bb_ptr->name = xstrdup(
+					bb_ptr->pool = xstrdup(
 						bb_state.bb_config.default_pool);
 				}
 				preempt_ptr = xmalloc(sizeof(
 						struct preempt_bb_recs));
 				preempt_ptr->bb_ptr = bb_ptr;
 				preempt_ptr->job_id = bb_ptr->job_id;
-				preempt_ptr->pool = bb_ptr->name;
+				preempt_ptr->pool = bb_ptr->pool;
 				preempt_ptr->size = bb_ptr->size;
 				preempt_ptr->use_time = bb_ptr->use_time;
 				preempt_ptr->user_id = bb_ptr->user_id;
 				list_push(preempt_list, preempt_ptr);
 
 				for (j = 0; j < ds_len; j++) {
-					if (xstrcmp(bb_ptr->name, pool_name[j]))
+					if (xstrcmp(bb_ptr->pool, pool_name[j]))
 						continue;
 					preempt_ptr->size = bb_granularity(
 								bb_ptr->size,
@@ -2589,7 +2590,7 @@ fini:	xfree(add_space);
  */
 static void _timeout_bb_rec(void)
 {
-	bb_alloc_t **bb_pptr, *bb_alloc = NULL;
+	bb_alloc_t *bb_alloc = NULL;
 	job_record_t *job_ptr;
 	int i;
 
@@ -2597,7 +2598,6 @@ static void _timeout_bb_rec(void)
 		return;
 
 	for (i = 0; i < BB_HASH_SIZE; i++) {
-		bb_pptr = &bb_state.bb_ahash[i];
 		bb_alloc = bb_state.bb_ahash[i];
 		while (bb_alloc) {
 			if (((bb_alloc->seen_time + TIME_SLOP) <
@@ -2629,19 +2629,17 @@ static void _timeout_bb_rec(void)
 				bb_post_persist_delete(bb_alloc, &bb_state);
 				assoc_mgr_unlock(&assoc_locks);
 
-				*bb_pptr = bb_alloc->next;
-				bb_free_alloc_buf(bb_alloc);
+				(void) bb_free_alloc_rec(&bb_state, bb_alloc);
 				break;
 			} else if (bb_alloc->state == BB_STATE_COMPLETE) {
 				job_ptr = find_job_record(bb_alloc->job_id);
 				if (!job_ptr || IS_JOB_PENDING(job_ptr)) {
 					/* Job purged or BB preempted */
-					*bb_pptr = bb_alloc->next;
-					bb_free_alloc_buf(bb_alloc);
+					(void) bb_free_alloc_rec(&bb_state,
+								 bb_alloc);
 					break;
 				}
 			}
-			bb_pptr = &bb_alloc->next;
 			bb_alloc = bb_alloc->next;
 		}
 	}
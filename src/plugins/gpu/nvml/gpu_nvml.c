@@ -751,6 +751,19 @@ static unsigned int _nvml_get_mem_freq(nvmlDevice_t device)
 	return _nvml_get_freq(device, NVML_CLOCK_MEM);
 }
 
+/*
+ * Log the current memory and graphics clock frequencies of the GPU. Each query
+ * is an NVML call, so only make them if debug2 is actually being logged.
+ */
+static void _nvml_log_freqs(nvmlDevice_t device, char *when)
+{
+	if (get_log_level() < LOG_LEVEL_DEBUG2)
+		return;
+
+	debug2("Memory frequency %s: %u", when, _nvml_get_mem_freq(device));
+	debug2("Graphics frequency %s: %u", when, _nvml_get_gfx_freq(device));
+}
+
 /*
  * Convert a frequency value to a string
  * Returned string must be xfree()'ed
@@ -800,15 +813,9 @@ static void _reset_freq(bitstr_t *gpus)
 		if (!_nvml_get_handle(i, &device))
 			continue;
 
-		debug2("Memory frequency before reset: %u",
-		       _nvml_get_mem_freq(device));
-		debug2("Graphics frequency before reset: %u",
-		       _nvml_get_gfx_freq(device));
+		_nvml_log_freqs(device, "before reset");
 		freq_reset =_nvml_reset_freqs(device);
-		debug2("Memory frequency after reset: %u",
-		       _nvml_get_mem_freq(device));
-		debug2("Graphics frequency after reset: %u",
-		       _nvml_get_gfx_freq(device));
+		_nvml_log_freqs(device, "after reset");
 
 		// TODO: Check to make sure that the frequency reset
 
@@ -913,15 +920,9 @@ static void _set_freq(bitstr_t *gpus, char *gpu_freq)
 		debug2("Setting frequency of NVML device %u", i);
 		_nvml_get_nearest_freqs(device, &mem_freq_num, &gpu_freq_num);
 
-		debug2("Memory frequency before set: %u",
-		       _nvml_get_mem_freq(device));
-		debug2("Graphics frequency before set: %u",
-		       _nvml_get_gfx_freq(device));
+		_nvml_log_freqs(device, "before set");
 		freq_set = _nvml_set_freqs(device, mem_freq_num, gpu_freq_num);
-		debug2("Memory frequency after set: %u",
-		       _nvml_get_mem_freq(device));
-		debug2("Graphics frequency after set: %u",
-		       _nvml_get_gfx_freq(device));
+		_nvml_log_freqs(device, "after set");
 
 		if (mem_freq_num) {
 			xstrfmtcat(tmp, "%smemory_freq:%u", sep, mem_freq_num);
@@ -71,6 +71,17 @@ const uint32_t plugin_version   = SLURM_VERSION_NUMBER;
 static slurm_ns_conf_t *ns_conf = NULL;
 static int step_ns_fd = -1;
 
+/*
+ * With Precreate, slurmd keeps one spare namespace under "<basepath>/.spare"
+ * built ahead of time by _build_spare(). container_p_create() renames it to
+ * the job's directory instead of building a namespace on the launch path.
+ */
+static pthread_mutex_t spare_mutex = PTHREAD_MUTEX_INITIALIZER;
+static bool spare_building = false;
+static bool spare_ready = false;
+
+static void _start_spare(void);
+
 static int _create_paths(uint32_t job_id,
 			 char *job_mount,
 			 char *ns_holder,
@@ -257,6 +268,12 @@ extern int container_p_restore(char *dir_name, bool recover)
 #endif
 	debug3("tmpfs: Base namespace created");
 
+	if (ns_conf->precreate) {
+		slurm_mutex_lock(&spare_mutex);
+		_start_spare();
+		slurm_mutex_unlock(&spare_mutex);
+	}
+
 	return SLURM_SUCCESS;
 }
 
@@ -318,12 +335,25 @@ static int _rm_data(const char *path, const struct stat *st_buf,
 	return 0;
 }
 
-extern int container_p_create(uint32_t job_id)
+/* Remove a directory and everything in it, without crossing mounts */
+static int _rm_dir(char *path)
+{
+	if (nftw(path, _rm_data, 64, FTW_DEPTH|FTW_PHYS) < 0) {
+		error("%s: Directory traversal failed: %s: %s",
+		      __func__, path, strerror(errno));
+		return SLURM_ERROR;
+	}
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Construct a private mount namespace with its own /tmp and /dev/shm.
+ * IN job_mount - existing directory to hold the namespace, removed on error
+ * IN ns_holder - file under job_mount to bind the namespace to
+ * IN src_bind - directory under job_mount to mount as /tmp
+ */
+static int _create_ns(char *job_mount, char *ns_holder, char *src_bind)
 {
-	char job_mount[PATH_MAX];
-	char ns_holder[PATH_MAX];
-	char src_bind[PATH_MAX];
-	char active[PATH_MAX];
 	char *result = NULL;
 	int fd;
 	int rc = 0;
@@ -331,42 +361,6 @@ extern int container_p_create(uint32_t job_id)
 	sem_t *sem2 = NULL;
 	pid_t cpid;
 
-#ifdef HAVE_NATIVE_CRAY
-	return 0;
-#endif
-
-	if (_create_paths(job_id, job_mount, ns_holder, src_bind, active)
-	    != SLURM_SUCCESS) {
-		return -1;
-	}
-
-	rc = mkdir(job_mount, 0700);
-	if (rc && errno != EEXIST) {
-		error("%s: mkdir %s failed: %s",
-		      __func__, job_mount, strerror(errno));
-		return -1;
-	} else if (rc && errno == EEXIST) {
-		/* stat to see if .active exists */
-		struct stat st;
-		rc = stat(active, &st);
-		if (rc) {
-			/*
-			 * If .active does not exist, then the directory for
-			 * the job exists but namespace is not active. This
-			 * should not happen normally. Throw error and exit
-			 */
-			error("%s: Dir %s exists but %s was not found, exiting",
-			      __func__, job_mount, active);
-			goto exit2;
-		}
-		/*
-		 * If it exists, this is coming from sbcast likely,
-		 * exit as success
-		 */
-		rc = 0;
-		goto exit2;
-	}
-
 	fd = open(ns_holder, O_CREAT|O_RDWR, S_IRWXU);
 	if (fd == -1) {
 		error("%s: open failed %s: %s",
@@ -498,8 +492,8 @@ extern int container_p_create(uint32_t job_id)
 
 		if (snprintf(proc_path, PATH_MAX, "/proc/%u/ns/mnt", cpid)
 		    >= PATH_MAX) {
-			error("%s: Unable to build job %u /proc path: %m",
-			      __func__, job_id);
+			error("%s: Unable to build %s /proc path: %m",
+			      __func__, job_mount);
 			rc = -1;
 			goto exit1;
 		}
@@ -545,19 +539,169 @@ exit1:
 	munmap(sem2, sizeof(*sem2));
 
 exit2:
-	if (rc) {
-		/* cleanup the job mount */
-		if (nftw(job_mount, _rm_data, 64, FTW_DEPTH|FTW_PHYS) < 0) {
-			error("%s: Directory traversal failed: %s: %s",
-			      __func__, job_mount, strerror(errno));
-			return SLURM_ERROR;
-		}
+	if (rc && _rm_dir(job_mount))
+		return SLURM_ERROR;	/* cleanup the job mount */
+
+	return rc;
+}
 
+static int _spare_paths(char *spare_mount, char *ns_holder, char *spare_tmp)
+{
+	if ((snprintf(spare_mount, PATH_MAX, "%s/.spare", ns_conf->basepath)
+	     >= PATH_MAX) ||
+	    (snprintf(ns_holder, PATH_MAX, "%s/.ns", spare_mount)
+	     >= PATH_MAX) ||
+	    (snprintf(spare_tmp, PATH_MAX, "%s/.tmp", spare_mount)
+	     >= PATH_MAX)) {
+		error("%s: Unable to build spare namespace paths", __func__);
+		return SLURM_ERROR;
 	}
+	return SLURM_SUCCESS;
+}
+
+static void *_build_spare(void *arg)
+{
+	char spare_mount[PATH_MAX];
+	char ns_holder[PATH_MAX];
+	char spare_tmp[PATH_MAX];
+	struct stat st;
+	bool ready = false;
+
+	if (_spare_paths(spare_mount, ns_holder, spare_tmp))
+		goto fini;
+
+	/* Left behind by a previous slurmd */
+	if (!stat(spare_mount, &st)) {
+		(void) umount2(ns_holder, MNT_DETACH);
+		if (_rm_dir(spare_mount))
+			goto fini;
+	}
+
+	if (mkdir(spare_mount, 0700)) {
+		error("%s: mkdir %s failed: %s",
+		      __func__, spare_mount, strerror(errno));
+		goto fini;
+	}
+	if (!_create_ns(spare_mount, ns_holder, spare_tmp)) {
+		debug3("%s: spare namespace ready", __func__);
+		ready = true;
+	}
+
+fini:
+	slurm_mutex_lock(&spare_mutex);
+	spare_building = false;
+	spare_ready = ready;
+	slurm_mutex_unlock(&spare_mutex);
+
+	return NULL;
+}
+
+/* Start building the next spare namespace, call with spare_mutex locked */
+static void _start_spare(void)
+{
+	if (spare_building || spare_ready)
+		return;
+	spare_building = true;
+	slurm_thread_create_detached(NULL, _build_spare, NULL);
+}
+
+/*
+ * Move the spare namespace to the job's directory, which must be empty.
+ * RET SLURM_SUCCESS if the job now has a namespace
+ */
+static int _take_spare(uint32_t job_id, char *job_mount)
+{
+	char spare_mount[PATH_MAX];
+	char ns_holder[PATH_MAX];
+	char spare_tmp[PATH_MAX];
+	char spare_bind[PATH_MAX];
+	int rc = SLURM_ERROR;
+
+	slurm_mutex_lock(&spare_mutex);
+	if (!spare_ready)
+		goto fini;
+	spare_ready = false;
+
+	if (_spare_paths(spare_mount, ns_holder, spare_tmp) ||
+	    (snprintf(spare_bind, PATH_MAX, "%s/.%u", spare_mount, job_id)
+	     >= PATH_MAX))
+		goto fini;
+
+	/*
+	 * Mounts follow the directories they are on, so the namespace /tmp
+	 * and the .ns holder survive both renames.
+	 */
+	if (rename(spare_tmp, spare_bind)) {
+		error("%s: rename %s failed: %s",
+		      __func__, spare_tmp, strerror(errno));
+	} else if (rename(spare_mount, job_mount)) {
+		error("%s: rename %s failed: %s",
+		      __func__, spare_mount, strerror(errno));
+		(void) rename(spare_bind, spare_tmp);
+	} else {
+		debug3("%s: job %u using spare namespace", __func__, job_id);
+		rc = SLURM_SUCCESS;
+	}
+
+fini:
+	_start_spare();
+	slurm_mutex_unlock(&spare_mutex);
 
 	return rc;
 }
 
+extern int container_p_create(uint32_t job_id)
+{
+	char job_mount[PATH_MAX];
+	char ns_holder[PATH_MAX];
+	char src_bind[PATH_MAX];
+	char active[PATH_MAX];
+	int rc = 0;
+
+#ifdef HAVE_NATIVE_CRAY
+	return 0;
+#endif
+
+	if (_create_paths(job_id, job_mount, ns_holder, src_bind, active)
+	    != SLURM_SUCCESS) {
+		return -1;
+	}
+
+	rc = mkdir(job_mount, 0700);
+	if (rc && errno != EEXIST) {
+		error("%s: mkdir %s failed: %s",
+		      __func__, job_mount, strerror(errno));
+		return -1;
+	} else if (rc && errno == EEXIST) {
+		/* stat to see if .active exists */
+		struct stat st;
+		rc = stat(active, &st);
+		if (rc) {
+			/*
+			 * If .active does not exist, then the directory for
+			 * the job exists but namespace is not active. This
+			 * should not happen normally. Throw error and exit
+			 */
+			error("%s: Dir %s exists but %s was not found, exiting",
+			      __func__, job_mount, active);
+			if (_rm_dir(job_mount))
+				return SLURM_ERROR;
+			return rc;
+		}
+		/*
+		 * If it exists, this is coming from sbcast likely,
+		 * exit as success
+		 */
+		return 0;
+	}
+
+	/* The empty job directory is replaced by the spare one */
+	if (ns_conf->precreate && !_take_spare(job_id, job_mount))
+		return 0;
+
+	return _create_ns(job_mount, ns_holder, src_bind);
+}
+
 /* Add a process to a job container, create the proctrack container to add */
 extern int container_p_join_external(uint32_t job_id)
 {
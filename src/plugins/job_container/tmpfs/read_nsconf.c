@@ -51,6 +51,7 @@
 static slurm_ns_conf_t slurm_ns_conf;
 static bool slurm_ns_conf_inited = false;
 static bool auto_basepath_set = false;
+static bool precreate_set = false;
 
 static s_p_hashtbl_t *_create_ns_hashtbl(void)
 {
@@ -58,6 +59,7 @@ static s_p_hashtbl_t *_create_ns_hashtbl(void)
 		{"AutoBasePath", S_P_BOOLEAN},
 		{"BasePath", S_P_STRING},
 		{"InitScript", S_P_STRING},
+		{"Precreate", S_P_BOOLEAN},
 		{NULL}
 	};
 
@@ -90,6 +92,9 @@ static int _parse_ns_conf_internal(void **dest, slurm_parser_enum_t type,
 	if (!s_p_get_string(&slurm_ns_conf.initscript, "InitScript", tbl))
 		debug3("empty init script detected");
 
+	if (s_p_get_boolean(&slurm_ns_conf.precreate, "Precreate", tbl))
+		precreate_set = true;
+
 end_it:
 	s_p_hashtbl_destroy(tbl);
 
@@ -132,6 +137,7 @@ static int _read_slurm_ns_conf(void)
 		{"AutoBasePath", S_P_BOOLEAN},
 		{"BasePath", S_P_ARRAY, _parse_ns_conf_internal, NULL},
 		{"NodeName", S_P_ARRAY, _parse_ns_conf, NULL},
+		{"Precreate", S_P_BOOLEAN},
 		{NULL}
 	};
 
@@ -157,6 +163,8 @@ static int _read_slurm_ns_conf(void)
 	if (!auto_basepath_set)
 		s_p_get_boolean(&slurm_ns_conf.auto_basepath,
 				"AutoBasePath", tbl);
+	if (!precreate_set)
+		s_p_get_boolean(&slurm_ns_conf.precreate, "Precreate", tbl);
 
 	if (!slurm_ns_conf.basepath) {
 		error("Configuration for this node not found in namespace.conf");
@@ -48,6 +48,7 @@ typedef struct slurm_ns_conf {
 	bool auto_basepath;
 	char *basepath;
 	char *initscript;
+	bool precreate;
 } slurm_ns_conf_t;
 
 extern slurm_ns_conf_t *get_slurm_ns_conf(void);
@@ -95,21 +95,34 @@ const char plugin_type[]       	= "job_submit/lua";
 const uint32_t plugin_version   = SLURM_VERSION_NUMBER;
 
 static const char lua_script_path[] = DEFAULT_SCRIPT_DIR "/job_submit.lua";
-static time_t lua_script_last_loaded = (time_t) 0;
-static lua_State *L = NULL;
-static char *user_msg = NULL;
-time_t last_lua_jobs_update = (time_t) 0;
-time_t last_lua_resv_update = (time_t) 0;
 static const char *req_fxns[] = {
 	"slurm_job_submit",
 	"slurm_job_modify",
 	NULL
 };
+
 /*
- *  Mutex for protecting multi-threaded access to this plugin.
- *   (Only 1 thread at a time should be in here)
+ * Each Lua state has its own copy of the loaded script, so calls from
+ * different threads can run concurrently as long as each uses its own state.
+ * The number of states is set by SchedulerParameters=job_submit_lua_states,
+ * default 1. Each state keeps its own Lua globals, so scripts which keep data
+ * between calls should only use one state.
  */
-static pthread_mutex_t lua_lock = PTHREAD_MUTEX_INITIALIZER;
+typedef struct {
+	bool in_use;
+	time_t load_time;	/* mtime of the script loaded in st */
+	time_t resv_update;	/* last_resv_update of slurm.reservations */
+	lua_State *st;
+} lua_pool_state_t;
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_cond = PTHREAD_COND_INITIALIZER;
+static lua_pool_state_t *pool = NULL;
+static int pool_size = 0;
+
+/* The state in use by this thread, and its log_user() messages */
+static __thread lua_State *L = NULL;
+static __thread char *user_msg = NULL;
 
 /* These are defined here so when we link with something other than
  * the slurmctld we will have these symbols defined.  They will get
@@ -190,46 +203,104 @@ static int _job_rec_field_index(lua_State *L)
 	return slurm_lua_job_record_field(L, job_ptr, name);
 }
 
-/* Get the list of existing slurmctld job records. */
-static void _update_jobs_global(lua_State *st)
+static void _push_job_rec(lua_State *st, job_record_t *job_ptr)
 {
-	char job_id_buf[11]; /* Big enough for a uint32_t */
-	ListIterator iter;
-	job_record_t *job_ptr;
+	lua_newtable(st);
 
-	if (last_lua_jobs_update >= last_job_update) {
-		return;
+	lua_newtable(st);
+	lua_pushcfunction(st, _job_rec_field_index);
+	lua_setfield(st, -2, "__index");
+	/* Store the job_ptr in the metatable, so the index
+	 * function knows which struct it's getting data for.
+	 */
+	lua_pushlightuserdata(st, job_ptr);
+	lua_setfield(st, -2, "_job_rec_ptr");
+	lua_setmetatable(st, -2);
+}
+
+/* Look up slurm.jobs[job_id] in the slurmctld job records */
+static int _jobs_index(lua_State *L)
+{
+	job_record_t *job_ptr = NULL;
+
+	if (lua_isnumber(L, 2))
+		job_ptr = find_job_record((uint32_t) lua_tonumber(L, 2));
+	if (!job_ptr) {
+		lua_pushnil(L);
+		return 1;
 	}
 
-	lua_getglobal(st, "slurm");
-	lua_newtable(st);
+	_push_job_rec(L, job_ptr);
+	return 1;
+}
 
-	iter = list_iterator_create(job_list);
-	while ((job_ptr = list_next(iter))) {
-		/* Create an empty table, with a metatable that looks up the
-		 * data for the individual job.
-		 */
-		lua_newtable(st);
+/* Return the next job id and record of the iterator created by _jobs_iter */
+static int _jobs_iter_next(lua_State *L)
+{
+	char job_id_buf[11]; /* Big enough for a uint32_t */
+	int inx = lua_tointeger(L, lua_upvalueindex(2));
+	job_record_t *job_ptr = NULL;
+
+	while (!job_ptr) {
+		lua_rawgeti(L, lua_upvalueindex(1), ++inx);
+		if (lua_isnil(L, -1))
+			return 0;
+		job_ptr = find_job_record((uint32_t) lua_tonumber(L, -1));
+		lua_pop(L, 1);
+	}
+	lua_pushinteger(L, inx);
+	lua_replace(L, lua_upvalueindex(2));
 
-		lua_newtable(st);
-		lua_pushcfunction(st, _job_rec_field_index);
-		lua_setfield(st, -2, "__index");
-		/* Store the job_record in the metatable, so the index
-		 * function knows which job it's getting data for.
-		 */
-		lua_pushlightuserdata(st, job_ptr);
-		lua_setfield(st, -2, "_job_rec_ptr");
-		lua_setmetatable(st, -2);
+	snprintf(job_id_buf, sizeof(job_id_buf), "%u", job_ptr->job_id);
+	lua_pushstring(L, job_id_buf);
+	_push_job_rec(L, job_ptr);
+	return 2;
+}
 
-		/* Lua copies passed strings, so we can reuse the buffer. */
-		snprintf(job_id_buf, sizeof(job_id_buf),
-		         "%d", job_ptr->job_id);
-		lua_setfield(st, -2, job_id_buf);
+/*
+ * slurm.jobs_iter(), or pairs(slurm.jobs) with Lua 5.2+
+ * Walk all jobs, only snapshotting their job ids rather than creating a
+ * table for every job.
+ */
+static int _jobs_iter(lua_State *L)
+{
+	ListIterator iter;
+	job_record_t *job_ptr;
+	int inx = 0;
+
+	lua_createtable(L, list_count(job_list), 0);
+	iter = list_iterator_create(job_list);
+	while ((job_ptr = list_next(iter))) {
+		lua_pushnumber(L, job_ptr->job_id);
+		lua_rawseti(L, -2, ++inx);
 	}
-	last_lua_jobs_update = last_job_update;
 	list_iterator_destroy(iter);
 
+	lua_pushinteger(L, 0);
+	lua_pushcclosure(L, _jobs_iter_next, 2);
+	return 1;
+}
+
+/*
+ * Register slurm.jobs, an empty table whose metatable looks up each job by
+ * id when indexed, so its cost does not grow with the number of jobs.
+ */
+static void _register_jobs_global(lua_State *st)
+{
+	lua_getglobal(st, "slurm");
+
+	lua_newtable(st);
+	lua_newtable(st);
+	lua_pushcfunction(st, _jobs_index);
+	lua_setfield(st, -2, "__index");
+	lua_pushcfunction(st, _jobs_iter);
+	lua_setfield(st, -2, "__pairs");
+	lua_setmetatable(st, -2);
 	lua_setfield(st, -2, "jobs");
+
+	lua_pushcfunction(st, _jobs_iter);
+	lua_setfield(st, -2, "jobs_iter");
+
 	lua_pop(st, 1);
 }
 
@@ -292,12 +363,13 @@ static int _resv_field_index(lua_State *L)
 }
 
 /* Get the list of existing slurmctld reservation records. */
-static void _update_resvs_global(lua_State *st)
+static void _update_resvs_global(lua_pool_state_t *pool_state)
 {
+	lua_State *st = pool_state->st;
 	ListIterator iter;
 	slurmctld_resv_t *resv_ptr;
 
-	if (last_lua_resv_update >= last_resv_update) {
+	if (pool_state->resv_update >= last_resv_update) {
 		return;
 	}
 
@@ -323,7 +395,7 @@ static void _update_resvs_global(lua_State *st)
 
 		lua_setfield(st, -2, resv_ptr->name);
 	}
-	last_lua_resv_update = last_resv_update;
+	pool_state->resv_update = last_resv_update;
 	list_iterator_destroy(iter);
 
 	lua_setfield(st, -2, "reservations");
@@ -998,21 +1070,6 @@ static void _push_job_desc(job_desc_msg_t *job_desc)
 	lua_setmetatable(L, -2);
 }
 
-static void _push_job_rec(job_record_t *job_ptr)
-{
-	lua_newtable(L);
-
-	lua_newtable(L);
-	lua_pushcfunction(L, _job_rec_field_index);
-	lua_setfield(L, -2, "__index");
-	/* Store the job_ptr in the metatable, so the index
-	 * function knows which struct it's getting data for.
-	 */
-	lua_pushlightuserdata(L, job_ptr);
-	lua_setfield(L, -2, "_job_rec_ptr");
-	lua_setmetatable(L, -2);
-}
-
 /* Get fields in an existing slurmctld partition record
  *
  * This is an incomplete list of partition record fields. Add more as needed
@@ -1218,10 +1275,7 @@ static void _register_local_output_functions(lua_State *L)
 	/* Must be always done after we register the slurm_functions */
 	lua_setglobal(L, "slurm");
 
-	last_lua_jobs_update = 0;
-	_update_jobs_global(L);
-	last_lua_resv_update = 0;
-	_update_resvs_global(L);
+	_register_jobs_global(L);
 }
 
 static void _register_lua_slurm_struct_functions(lua_State *st)
@@ -1245,6 +1299,56 @@ static void _loadscript_extra(lua_State *st)
 	_register_lua_slurm_struct_functions(st);
 }
 
+static void _pool_state_put(lua_pool_state_t *pool_state)
+{
+	L = NULL;
+
+	slurm_mutex_lock(&pool_mutex);
+	pool_state->in_use = false;
+	slurm_cond_signal(&pool_cond);
+	slurm_mutex_unlock(&pool_mutex);
+}
+
+/*
+ * Wait for an idle Lua state and make it the state of this thread, reloading
+ * the script into it if it has changed.
+ */
+static lua_pool_state_t *_pool_state_get(void)
+{
+	lua_pool_state_t *pool_state = NULL;
+	time_t load_time;
+	int i;
+
+	slurm_mutex_lock(&pool_mutex);
+	while (!pool_state) {
+		for (i = 0; i < pool_size; i++) {
+			if (!pool[i].in_use) {
+				pool_state = &pool[i];
+				break;
+			}
+		}
+		if (!pool_state)
+			slurm_cond_wait(&pool_cond, &pool_mutex);
+	}
+	pool_state->in_use = true;
+	slurm_mutex_unlock(&pool_mutex);
+
+	load_time = pool_state->load_time;
+	if (slurm_lua_loadscript(&pool_state->st, "job_submit/lua",
+				 lua_script_path, req_fxns,
+				 &pool_state->load_time,
+				 _loadscript_extra) != SLURM_SUCCESS) {
+		_pool_state_put(pool_state);
+		return NULL;
+	}
+	/* A new script has a new Lua state without slurm.reservations */
+	if (pool_state->load_time != load_time)
+		pool_state->resv_update = 0;
+
+	L = pool_state->st;
+	return pool_state;
+}
+
 /*
  *  NOTE: The init callback should never be called multiple times,
  *   let alone called from multiple threads. Therefore, locking
@@ -1253,24 +1357,38 @@ static void _loadscript_extra(lua_State *st)
 int init(void)
 {
 	int rc = SLURM_SUCCESS;
+	char *opt;
 
 	if ((rc = slurm_lua_init()) != SLURM_SUCCESS)
 		return rc;
 
-	return slurm_lua_loadscript(&L, "job_submit/lua",
+	pool_size = 1;
+	/*                      0123456789012345678901 */
+	if ((opt = xstrcasestr(slurm_conf.sched_params,
+			       "job_submit_lua_states=")))
+		pool_size = MAX(atoi(opt + 22), 1);
+	pool = xcalloc(pool_size, sizeof(*pool));
+	debug("%s: using %d Lua state(s)", plugin_type, pool_size);
+
+	/* Load the first state now to report any errors in the script */
+	return slurm_lua_loadscript(&pool[0].st, "job_submit/lua",
 				    lua_script_path, req_fxns,
-				    &lua_script_last_loaded,
+				    &pool[0].load_time,
 				    _loadscript_extra);
 }
 
 int fini(void)
 {
-	if (L) {
-		debug3("%s: Unloading Lua script", __func__);
-		lua_close(L);
-		L = NULL;
-		lua_script_last_loaded = 0;
+	int i;
+
+	for (i = 0; i < pool_size; i++) {
+		if (pool[i].st) {
+			debug3("%s: Unloading Lua script", __func__);
+			lua_close(pool[i].st);
+		}
 	}
+	xfree(pool);
+	pool_size = 0;
 
 	slurm_lua_fini();
 
@@ -1282,15 +1400,11 @@ int fini(void)
 extern int job_submit(job_desc_msg_t *job_desc, uint32_t submit_uid,
 		      char **err_msg)
 {
-	int rc;
-	slurm_mutex_lock (&lua_lock);
-
-	rc = slurm_lua_loadscript(&L, "job_submit/lua",
-				  lua_script_path, req_fxns,
-				  &lua_script_last_loaded, _loadscript_extra);
+	int rc = SLURM_SUCCESS;
+	lua_pool_state_t *pool_state;
 
-	if (rc != SLURM_SUCCESS)
-		goto out;
+	if (!(pool_state = _pool_state_get()))
+		return SLURM_ERROR;
 
 	/*
 	 *  All lua script functions should have been verified during
@@ -1300,8 +1414,7 @@ extern int job_submit(job_desc_msg_t *job_desc, uint32_t submit_uid,
 	if (lua_isnil(L, -1))
 		goto out;
 
-	_update_jobs_global(L);
-	_update_resvs_global(L);
+	_update_resvs_global(pool_state);
 
 	_push_job_desc(job_desc);
 	_push_partition_list(job_desc->user_id, submit_uid);
@@ -1328,7 +1441,7 @@ extern int job_submit(job_desc_msg_t *job_desc, uint32_t submit_uid,
 		user_msg = NULL;
 	}
 
-out:	slurm_mutex_unlock (&lua_lock);
+out:	_pool_state_put(pool_state);
 	return rc;
 }
 
@@ -1336,15 +1449,11 @@ out:	slurm_mutex_unlock (&lua_lock);
 extern int job_modify(job_desc_msg_t *job_desc, job_record_t *job_ptr,
 		      uint32_t submit_uid)
 {
-	int rc;
-	slurm_mutex_lock (&lua_lock);
-
-	rc = slurm_lua_loadscript(&L, "job_submit/lua",
-				  lua_script_path, req_fxns,
-				  &lua_script_last_loaded, _loadscript_extra);
+	int rc = SLURM_SUCCESS;
+	lua_pool_state_t *pool_state;
 
-	if (rc == SLURM_ERROR)
-		goto out;
+	if (!(pool_state = _pool_state_get()))
+		return SLURM_ERROR;
 
 	/*
 	 *  All lua script functions should have been verified during
@@ -1354,11 +1463,10 @@ extern int job_modify(job_desc_msg_t *job_desc, job_record_t *job_ptr,
 	if (lua_isnil(L, -1))
 		goto out;
 
-	_update_jobs_global(L);
-	_update_resvs_global(L);
+	_update_resvs_global(pool_state);
 
 	_push_job_desc(job_desc);
-	_push_job_rec(job_ptr);
+	_push_job_rec(L, job_ptr);
 	_push_partition_list(job_ptr->user_id, submit_uid);
 	lua_pushnumber(L, submit_uid);
 	slurm_lua_stack_dump(
@@ -1384,6 +1492,6 @@ extern int job_modify(job_desc_msg_t *job_desc, job_record_t *job_ptr,
 		xfree(user_msg);
 	}
 
-out:	slurm_mutex_unlock (&lua_lock);
+out:	_pool_state_put(pool_state);
 	return rc;
 }
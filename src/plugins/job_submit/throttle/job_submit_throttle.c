@@ -39,6 +39,7 @@
 \*****************************************************************************/
 
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
@@ -84,6 +85,7 @@ typedef struct thru_put {
 	uint32_t job_count;
 } thru_put_t;
 
+static pthread_mutex_t throttle_mutex = PTHREAD_MUTEX_INITIALIZER;
 static int jobs_per_user_per_hour = 0;
 static time_t last_reset = (time_t) 0;
 static thru_put_t *thru_put_array = NULL;
@@ -149,12 +151,13 @@ extern int fini(void)
 extern int job_submit(job_desc_msg_t *job_desc, uint32_t submit_uid,
 		      char **err_msg)
 {
-	int i;
+	int i, rc = SLURM_SUCCESS;
 
+	slurm_mutex_lock(&throttle_mutex);
 	if (!last_reset)
 		_get_config();
 	if (jobs_per_user_per_hour == 0)
-		return SLURM_SUCCESS;
+		goto fini;
 	_reset_counters();
 
 	for (i = 0; i < thru_put_size; i++) {
@@ -162,18 +165,22 @@ extern int job_submit(job_desc_msg_t *job_desc, uint32_t submit_uid,
 			continue;
 		if (thru_put_array[i].job_count < jobs_per_user_per_hour) {
 			thru_put_array[i].job_count++;
-			return SLURM_SUCCESS;
+			goto fini;
 		}
 		if (err_msg)
 			*err_msg = xstrdup("Reached jobs per hour limit");
-		return ESLURM_ACCOUNTING_POLICY;
+		rc = ESLURM_ACCOUNTING_POLICY;
+		goto fini;
 	}
 	thru_put_size++;
 	thru_put_array = xrealloc(thru_put_array,
 				  (sizeof(thru_put_t) * thru_put_size));
 	thru_put_array[thru_put_size - 1].uid = job_desc->user_id;
 	thru_put_array[thru_put_size - 1].job_count = 1;
-	return SLURM_SUCCESS;
+
+fini:
+	slurm_mutex_unlock(&throttle_mutex);
+	return rc;
 }
 
 extern int job_modify(job_desc_msg_t *job_desc, job_record_t *job_ptr,
@@ -430,19 +430,15 @@ static int _get_process_memory_line(int in, jag_prec_t *prec)
 
 static int _remove_share_data(char *proc_stat_file, jag_prec_t *prec)
 {
-	FILE *statm_fp = NULL;
 	char proc_statm_file[256];	/* Allow ~20x extra length */
 	int rc = 0, fd;
 
 	snprintf(proc_statm_file, sizeof(proc_statm_file), "%sm",
 		 proc_stat_file);
-	if (!(statm_fp = fopen(proc_statm_file, "r")))
+	if ((fd = open(proc_statm_file, O_RDONLY | O_CLOEXEC)) < 0)
 		return rc;  /* Assume the process went away */
-	fd = fileno(statm_fp);
-	if (fcntl(fd, F_SETFD, FD_CLOEXEC) == -1)
-		error("%s: fcntl(%s): %m", __func__, proc_statm_file);
 	rc = _get_process_memory_line(fd, prec);
-	fclose(statm_fp);
+	close(fd);
 	return rc;
 }
 
@@ -475,8 +471,10 @@ static int _get_process_io_data_line(int in, jag_prec_t *prec) {
 	if (nvals < 4)
 		return 0;
 
-	if (_is_a_lwp(prec->pid))
-		return 0;
+	/*
+	 * No _is_a_lwp() check here, _handle_stats() only gets this far after
+	 * _get_process_data_line() has already rejected lightweight processes.
+	 */
 
 	/* keep real value here since we aren't doubles */
 	prec->tres_data[TRES_ARRAY_FS_DISK].size_read = rchar;
@@ -504,9 +502,7 @@ static void _handle_stats(char *proc_stat_file, char *proc_io_file,
 {
 	static int no_share_data = -1;
 	static int use_pss = -1;
-	FILE *stat_fp = NULL;
-	FILE *io_fp = NULL;
-	int fd, fd2;
+	int fd;
 	jag_prec_t *prec = NULL;
 
 	if (no_share_data == -1) {
@@ -521,21 +517,14 @@ static void _handle_stats(char *proc_stat_file, char *proc_io_file,
 			use_pss = 0;
 	}
 
-	if (!(stat_fp = fopen(proc_stat_file, "r")))
-		return;  /* Assume the process went away */
 	/*
-	 * Close the file on exec() of user tasks.
-	 *
-	 * NOTE: If we fork() slurmstepd after the
-	 * fopen() above and before the fcntl() below,
-	 * then the user task may have this extra file
-	 * open, which can cause problems for
-	 * checkpoint/restart, but this should be a very rare
-	 * problem in practice.
+	 * Use open(O_CLOEXEC) rather than fopen() + fcntl(), this is done for
+	 * every process on every poll so skip the stdio buffer allocation and
+	 * the extra syscall. It also closes the window in which a user task
+	 * forked in between could inherit the descriptor.
 	 */
-	fd = fileno(stat_fp);
-	if (fcntl(fd, F_SETFD, FD_CLOEXEC) == -1)
-		error("%s: fcntl(%s): %m", __func__, proc_stat_file);
+	if ((fd = open(proc_stat_file, O_RDONLY | O_CLOEXEC)) < 0)
+		return;  /* Assume the process went away */
 
 	prec = xmalloc(sizeof(jag_prec_t));
 
@@ -555,11 +544,11 @@ static void _handle_stats(char *proc_stat_file, char *proc_io_file,
 	(void)_init_tres(prec, NULL);
 
 	if (!_get_process_data_line(fd, prec)) {
-		fclose(stat_fp);
+		close(fd);
 		goto bail_out;
 	}
 
-	fclose(stat_fp);
+	close(fd);
 
 	if (acct_gather_filesystem_g_get_data(prec->tres_data) < 0) {
 		log_flag(JAG, "problem retrieving filesystem data");
@@ -577,15 +566,12 @@ static void _handle_stats(char *proc_stat_file, char *proc_io_file,
 	if (use_pss && _get_pss(proc_smaps_file, prec) == -1)
 		goto bail_out;
 
-	if ((io_fp = fopen(proc_io_file, "r"))) {
-		fd2 = fileno(io_fp);
-		if (fcntl(fd2, F_SETFD, FD_CLOEXEC) == -1)
-			error("%s: fcntl: %m", __func__);
-		if (!_get_process_io_data_line(fd2, prec)) {
-			fclose(io_fp);
+	if ((fd = open(proc_io_file, O_RDONLY | O_CLOEXEC)) >= 0) {
+		if (!_get_process_io_data_line(fd, prec)) {
+			close(fd);
 			goto bail_out;
 		}
-		fclose(io_fp);
+		close(fd);
 	}
 
 	destroy_jag_prec(list_remove_first(prec_list, _find_prec, &prec->pid));
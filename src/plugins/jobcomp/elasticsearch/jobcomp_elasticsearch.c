@@ -99,6 +99,8 @@ const char plugin_type[] = "jobcomp/elasticsearch";
 const uint32_t plugin_version = SLURM_VERSION_NUMBER;
 
 #define INDEX_RETRY_INTERVAL 30
+#define DEFAULT_BATCH_SIZE 1000
+#define DEFAULT_FLUSH_INTERVAL 1
 #define JOBCOMP_DATA_FORMAT "{\"jobid\":%u,\"username\":\"%s\","	\
 	"\"user_id\":%u,\"groupname\":\"%s\",\"group_id\":%u,"		\
 	"\"@start\":\"%s\",\"@end\":\"%s\",\"elapsed\":%ld,"		\
@@ -138,11 +140,20 @@ static pthread_mutex_t location_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t save_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t pend_jobs_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_t job_handler_thread;
+static pthread_cond_t jobs_cond = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t jobs_mutex = PTHREAD_MUTEX_INITIALIZER;
 static List jobslist = NULL;
 static bool thread_shutdown = false;
 
 static long curl_timeout = 0;
 static long curl_connecttimeout = 0;
+static int batch_size = DEFAULT_BATCH_SIZE;
+static int flush_interval = DEFAULT_FLUSH_INTERVAL;
+
+/* Only used by the job handler thread */
+static CURL *curl_handle = NULL;
+static struct curl_slist *curl_headers = NULL;
+static char *bulk_url = NULL;
 
 /* Get the user name for the give user_id */
 static void _get_user_name(uint32_t user_id, char *user_name, int buf_size)
@@ -283,98 +294,154 @@ static size_t _write_callback(void *contents, size_t size, size_t nmemb,
 	return realsize;
 }
 
-/* Try to index job into elasticsearch */
-static int _index_job(const char *jobcomp)
+/*
+ * Build the _bulk endpoint from JobCompLoc. The configured URL names either
+ * "<index>/_doc" or the pre-8.0 "<index>/<type>", both of which accept the
+ * bulk API once "_doc" is dropped.
+ */
+static char *_bulk_url(const char *url)
+{
+	char *bulk = xstrdup(url), *ptr;
+	int len = strlen(bulk);
+
+	while ((len > 0) && (bulk[len - 1] == '/'))
+		bulk[--len] = '\0';
+	if ((ptr = strrchr(bulk, '/')) && !xstrcmp(ptr, "/_doc"))
+		*ptr = '\0';
+	xstrcat(bulk, "/_bulk");
+
+	return bulk;
+}
+
+/*
+ * Set up the curl handle shared by all bulk requests. libcurl keeps the
+ * connection to the server open between requests done through the same
+ * handle, so indexing no longer pays a TCP (and TLS) handshake per job.
+ */
+static CURL *_curl_handle_init(void)
+{
+	CURL *handle;
+
+	if (!(handle = curl_easy_init())) {
+		error("%s: curl_easy_init: %m", plugin_type);
+		return NULL;
+	}
+
+	if (!curl_headers &&
+	    !(curl_headers = curl_slist_append(NULL,
+			"Content-Type: application/x-ndjson"))) {
+		error("%s: curl_slist_append: %m", plugin_type);
+		curl_easy_cleanup(handle);
+		return NULL;
+	}
+
+	xfree(bulk_url);
+	bulk_url = _bulk_url(log_url);
+
+	curl_easy_setopt(handle, CURLOPT_URL, bulk_url);
+	curl_easy_setopt(handle, CURLOPT_POST, 1);
+	curl_easy_setopt(handle, CURLOPT_HTTPHEADER, curl_headers);
+	curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, _write_callback);
+	curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+	curl_easy_setopt(handle, CURLOPT_TIMEOUT, curl_timeout);
+	curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT, curl_connecttimeout);
+	if ((curl_timeout > 0) || (curl_connecttimeout > 0))
+		curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1);
+
+	return handle;
+}
+
+/*
+ * Walk the "items" array of a _bulk response and flag every document the
+ * server accepted. Items are reported in request order, each one carrying
+ * its own HTTP status.
+ */
+static void _parse_bulk_response(char *response, int cnt, bool *indexed)
+{
+	char *ptr;
+	long status;
+	int i;
+
+	if (!(ptr = xstrstr(response, "\"items\"")))
+		return;
+
+	for (i = 0; i < cnt; i++) {
+		if (!(ptr = xstrstr(ptr, "\"status\":")))
+			break;
+		ptr += 9;
+		status = strtol(ptr, &ptr, 10);
+		/*
+		 * HTTP 200 (OK)	- document updated.
+		 * HTTP 201 (Created)	- document created.
+		 */
+		if ((status == 200) || (status == 201))
+			indexed[i] = true;
+	}
+}
+
+/*
+ * Index a batch of jobs into elasticsearch with a single _bulk request.
+ * indexed[] is set for every job the server stored, any other job has to
+ * be retried later.
+ */
+static int _index_batch(struct job_node **batch, int cnt, bool *indexed)
 {
-	CURL *curl_handle = NULL;
 	CURLcode res;
 	struct http_response chunk;
-	struct curl_slist *slist = NULL;
-	int rc = SLURM_SUCCESS;
-	char *token = NULL;
+	char *body = NULL, *pos = NULL;
+	long status = 0;
+	int i, rc = SLURM_SUCCESS;
+
+	memset(indexed, 0, sizeof(bool) * cnt);
 
 	if (log_url == NULL) {
 		error("%s: JobCompLoc parameter not configured", plugin_type);
 		return SLURM_ERROR;
 	}
 
-	if (curl_global_init(CURL_GLOBAL_ALL) != 0) {
-		error("%s: curl_global_init: %m", plugin_type);
-		rc = SLURM_ERROR;
-		goto cleanup_global_init;
-	} else if ((curl_handle = curl_easy_init()) == NULL) {
-		error("%s: curl_easy_init: %m", plugin_type);
-		rc = SLURM_ERROR;
-		goto cleanup_easy_init;
-	}
-
-	slist = curl_slist_append(slist, "Content-Type: application/json");
+	if (!curl_handle && !(curl_handle = _curl_handle_init()))
+		return SLURM_ERROR;
 
-	if (slist == NULL) {
-		error("%s: curl_slist_append: %m", plugin_type);
-		rc = SLURM_ERROR;
-		goto cleanup_easy_init;
-	}
+	for (i = 0; i < cnt; i++)
+		xstrfmtcatat(body, &pos, "{\"index\":{}}\n%s\n",
+			     batch[i]->serialized_job);
 
 	chunk.message = xmalloc(1);
 	chunk.size = 0;
 
-	curl_easy_setopt(curl_handle, CURLOPT_URL, log_url);
-	curl_easy_setopt(curl_handle, CURLOPT_POST, 1);
-	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, jobcomp);
-	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE, strlen(jobcomp));
-	curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, slist);
-	curl_easy_setopt(curl_handle, CURLOPT_HEADER, 1);
-	curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, _write_callback);
+	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, body);
+	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE, pos - body);
 	curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *) &chunk);
 
 	if ((res = curl_easy_perform(curl_handle)) != CURLE_OK) {
 		log_flag(ESEARCH, "%s: Could not connect to: %s , reason: %s",
-			 plugin_type, log_url, curl_easy_strerror(res));
+			 plugin_type, bulk_url, curl_easy_strerror(res));
 		rc = SLURM_ERROR;
 		goto cleanup;
 	}
 
-	token = strtok(chunk.message, " ");
-	if (token == NULL) {
-		error("%s: Could not receive the HTTP response status code from %s",
-		      plugin_type, log_url);
+	curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &status);
+	if (status != 200) {
+		log_flag(ESEARCH, "%s: HTTP status code %ld received from %s",
+			 plugin_type, status, bulk_url);
+		log_flag(ESEARCH, "%s: HTTP response:\n%s",
+			 plugin_type, chunk.message);
 		rc = SLURM_ERROR;
 		goto cleanup;
 	}
-	token = strtok(NULL, " ");
-
-	/* HTTP 100 (Continue). */
-	if ((xstrcmp(token, "100") == 0)) {
-		(void)  strtok(NULL, " ");
-		token = strtok(NULL, " ");
-	}
 
-	/*
-	 * HTTP 200 (OK)	- request succeed.
-	 * HTTP 201 (Created)	- request succeed and resource created.
-	 */
-	if ((xstrcmp(token, "200") != 0) && (xstrcmp(token, "201") != 0)) {
-		log_flag(ESEARCH, "%s: HTTP status code %s received from %s",
-			 plugin_type, token, log_url);
-		log_flag(ESEARCH, "%s: HTTP response:\n%s",
-			 plugin_type, chunk.message);
-		rc = SLURM_ERROR;
+	if (xstrstr(chunk.message, "\"errors\":false")) {
+		for (i = 0; i < cnt; i++)
+			indexed[i] = true;
 	} else {
-		token = strtok((char *)jobcomp, ",");
-		(void)  strtok(token, ":");
-		token = strtok(NULL, ":");
-		log_flag(ESEARCH, "%s: Job with jobid %s indexed into elasticsearch",
-			 plugin_type, token);
+		_parse_bulk_response(chunk.message, cnt, indexed);
+		log_flag(ESEARCH, "%s: Some jobs were rejected by %s, HTTP response:\n%s",
+			 plugin_type, bulk_url, chunk.message);
 	}
 
 cleanup:
-	curl_slist_free_all(slist);
+	xfree(body);
 	xfree(chunk.message);
-cleanup_easy_init:
-	curl_easy_cleanup(curl_handle);
-cleanup_global_init:
-	curl_global_cleanup();
 	return rc;
 }
 
@@ -863,15 +930,30 @@ extern int slurm_jobcomp_log_record(job_record_t *job_ptr)
 	list_enqueue(jobslist, jnode);
 	json_str = NULL;
 
+	if (list_count(jobslist) >= batch_size) {
+		slurm_mutex_lock(&jobs_mutex);
+		slurm_cond_signal(&jobs_cond);
+		slurm_mutex_unlock(&jobs_mutex);
+	}
+
 	return SLURM_SUCCESS;
 }
 
+static void _jobslist_del(void *x)
+{
+	struct job_node *jnode = (struct job_node *) x;
+	xfree(jnode->serialized_job);
+	xfree(jnode);
+}
+
 extern void *_process_jobs(void *x)
 {
 	ListIterator iter;
-	struct job_node *jnode = NULL;
+	struct job_node *jnode = NULL, **batch;
 	struct timespec ts = {0, 0};
+	bool *indexed;
 	time_t now;
+	int i, cnt;
 
 	/* Wait for slurm_jobcomp_set_location log_url setup. */
 	slurm_mutex_lock(&location_mutex);
@@ -879,41 +961,71 @@ extern void *_process_jobs(void *x)
 	slurm_cond_timedwait(&location_cond, &location_mutex, &ts);
 	slurm_mutex_unlock(&location_mutex);
 
+	batch = xcalloc(batch_size, sizeof(struct job_node *));
+	indexed = xcalloc(batch_size, sizeof(bool));
+
 	while (!thread_shutdown) {
-		int success_cnt = 0, fail_cnt = 0, wait_retry_cnt = 0;
-		sleep(1);
-		iter = list_iterator_create(jobslist);
-		while ((jnode = (struct job_node *)list_next(iter)) &&
-		       !thread_shutdown) {
+		int success_cnt = 0, fail_cnt = 0;
+
+		/* Sleep until a full batch is queued or flush_interval passes */
+		slurm_mutex_lock(&jobs_mutex);
+		if (!thread_shutdown &&
+		    (list_count(jobslist) < batch_size)) {
+			ts.tv_sec = time(NULL) + flush_interval;
+			ts.tv_nsec = 0;
+			slurm_cond_timedwait(&jobs_cond, &jobs_mutex, &ts);
+		}
+		slurm_mutex_unlock(&jobs_mutex);
+
+		do {
 			now = time(NULL);
-			if ((jnode->last_index_retry == 0) ||
-			    (difftime(now, jnode->last_index_retry) >=
-					INDEX_RETRY_INTERVAL)) {
-				if ((_index_job(jnode->serialized_job) ==
-				     SLURM_SUCCESS)) {
-					list_delete_item(iter);
+			cnt = 0;
+			iter = list_iterator_create(jobslist);
+			while ((cnt < batch_size) &&
+			       (jnode = (struct job_node *)list_next(iter)) &&
+			       !thread_shutdown) {
+				if ((jnode->last_index_retry == 0) ||
+				    (difftime(now, jnode->last_index_retry) >=
+				     INDEX_RETRY_INTERVAL))
+					batch[cnt++] = list_remove(iter);
+			}
+			list_iterator_destroy(iter);
+			if (!cnt)
+				break;
+
+			if (thread_shutdown)
+				memset(indexed, 0, sizeof(bool) * cnt);
+			else
+				(void) _index_batch(batch, cnt, indexed);
+
+			for (i = 0; i < cnt; i++) {
+				if (indexed[i]) {
+					_jobslist_del(batch[i]);
 					success_cnt++;
 				} else {
-					jnode->last_index_retry = now;
+					batch[i]->last_index_retry = now;
+					list_append(jobslist, batch[i]);
 					fail_cnt++;
 				}
-			} else
-				wait_retry_cnt++;
-		}
-		list_iterator_destroy(iter);
+			}
+		} while ((cnt == batch_size) && !fail_cnt && !thread_shutdown);
+
 		if ((success_cnt || fail_cnt))
-			log_flag(ESEARCH, "%s: index success:%d fail:%d wait_retry:%d",
+			log_flag(ESEARCH, "%s: index success:%d fail:%d pending:%d",
 				 plugin_type, success_cnt, fail_cnt,
-				 wait_retry_cnt);
+				 list_count(jobslist));
 	}
-	return NULL;
-}
 
-static void _jobslist_del(void *x)
-{
-	struct job_node *jnode = (struct job_node *) x;
-	xfree(jnode->serialized_job);
-	xfree(jnode);
+	xfree(batch);
+	xfree(indexed);
+	if (curl_handle)
+		curl_easy_cleanup(curl_handle);
+	curl_handle = NULL;
+	curl_slist_free_all(curl_headers);
+	curl_headers = NULL;
+	xfree(bulk_url);
+
+	return NULL;
 }
 
 /*
@@ -934,10 +1046,40 @@ extern int init(void)
 	/*			    1234567890123456 */
 	if ((tmp_ptr = xstrcasestr(slurm_conf.job_comp_params,
 	                           "connect_timeout="))) {
-		curl_timeout = xstrntol(tmp_ptr + 16, NULL, 10, 10);
+		curl_connecttimeout = xstrntol(tmp_ptr + 16, NULL, 10, 10);
 
 		log_flag(ESEARCH, "%s: setting curl connect timeout: %lds",
-			 plugin_type, curl_timeout);
+			 plugin_type, curl_connecttimeout);
+	}
+	/*                                                      1234567890*/
+	if ((tmp_ptr = xstrcasestr(slurm_conf.job_comp_params, "batch_size="))) {
+		batch_size = xstrntol(tmp_ptr + 11, NULL, 10, 10);
+		if (batch_size < 1) {
+			error("%s: invalid batch_size, using %d",
+			      plugin_type, DEFAULT_BATCH_SIZE);
+			batch_size = DEFAULT_BATCH_SIZE;
+		}
+
+		log_flag(ESEARCH, "%s: setting bulk batch size: %d",
+			 plugin_type, batch_size);
+	}
+	/*			    123456789012345 */
+	if ((tmp_ptr = xstrcasestr(slurm_conf.job_comp_params,
+				   "flush_interval="))) {
+		flush_interval = xstrntol(tmp_ptr + 15, NULL, 10, 10);
+		if (flush_interval < 1) {
+			error("%s: invalid flush_interval, using %ds",
+			      plugin_type, DEFAULT_FLUSH_INTERVAL);
+			flush_interval = DEFAULT_FLUSH_INTERVAL;
+		}
+
+		log_flag(ESEARCH, "%s: setting bulk flush interval: %ds",
+			 plugin_type, flush_interval);
+	}
+
+	if (curl_global_init(CURL_GLOBAL_ALL) != 0) {
+		error("%s: curl_global_init: %m", plugin_type);
+		return SLURM_ERROR;
 	}
 
 	jobslist = list_create(_jobslist_del);
@@ -951,12 +1093,16 @@ extern int init(void)
 
 extern int fini(void)
 {
+	slurm_mutex_lock(&jobs_mutex);
 	thread_shutdown = true;
+	slurm_cond_signal(&jobs_cond);
+	slurm_mutex_unlock(&jobs_mutex);
 	pthread_join(job_handler_thread, NULL);
 
 	_save_state();
 	list_destroy(jobslist);
 	xfree(log_url);
+	curl_global_cleanup();
 	return SLURM_SUCCESS;
 }
 
@@ -967,7 +1113,7 @@ extern int fini(void)
 extern int slurm_jobcomp_set_location(char *location)
 {
 	int rc = SLURM_SUCCESS;
-	CURL *curl_handle;
+	CURL *handle;
 	CURLcode res;
 
 	if (location == NULL) {
@@ -977,27 +1123,25 @@ extern int slurm_jobcomp_set_location(char *location)
 
 	log_url = xstrdup(location);
 
-	curl_global_init(CURL_GLOBAL_ALL);
-	curl_handle = curl_easy_init();
-	if (curl_handle) {
-		curl_easy_setopt(curl_handle, CURLOPT_URL, log_url);
-		curl_easy_setopt(curl_handle, CURLOPT_NOBODY, 1);
-		curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT, curl_timeout);
-		curl_easy_setopt(curl_handle, CURLOPT_CONNECTTIMEOUT,
+	handle = curl_easy_init();
+	if (handle) {
+		curl_easy_setopt(handle, CURLOPT_URL, log_url);
+		curl_easy_setopt(handle, CURLOPT_NOBODY, 1);
+		curl_easy_setopt(handle, CURLOPT_TIMEOUT, curl_timeout);
+		curl_easy_setopt(handle, CURLOPT_CONNECTTIMEOUT,
 				 curl_connecttimeout);
 
 		if ((curl_timeout > 0) || (curl_connecttimeout > 0))
-			curl_easy_setopt(curl_handle, CURLOPT_NOSIGNAL, 1);
+			curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1);
 
-		res = curl_easy_perform(curl_handle);
+		res = curl_easy_perform(handle);
 		if (res != CURLE_OK) {
 			error("%s: Could not connect to: %s", plugin_type,
 			      log_url);
 			rc = SLURM_ERROR;
 		}
-		curl_easy_cleanup(curl_handle);
+		curl_easy_cleanup(handle);
 	}
-	curl_global_cleanup();
 
 	slurm_mutex_lock(&location_mutex);
 	slurm_cond_broadcast(&location_cond);
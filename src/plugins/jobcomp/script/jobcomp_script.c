@@ -64,6 +64,11 @@
  *  USERNAME		User name of job owner
  *  WORK_DIR		Job's working directory
  *
+ *  With "persistent" in JobCompParams the script is instead started once per
+ *  worker and reads one JSON object per line on stdin, holding the variables
+ *  above as string members, until stdin is closed. JOBCOMP_PERSISTENT=1 is
+ *  set in its environment.
+ *
  *  BlueGene specific environment variables:
  *  BLOCKID		Name of Block ID
  *  CONNECT_TYPE	Connection type: small, torus or mesh
@@ -92,6 +97,7 @@
 #include "slurm/slurm.h"
 #include "slurm/slurm_errno.h"
 
+#include "src/common/fd.h"
 #include "src/common/list.h"
 #include "src/common/macros.h"
 #include "src/common/node_select.h"
@@ -132,15 +138,27 @@ const char plugin_name[]       	= "Job completion logging script plugin";
 const char plugin_type[]       	= "jobcomp/script";
 const uint32_t plugin_version	= SLURM_VERSION_NUMBER;
 
+#define MAX_WORKERS 64
+
 static char * script = NULL;
 static List comp_list = NULL;
 
-static pthread_t script_thread = 0;
+/* JobCompParams=workers=#,persistent */
+static int script_workers = 1;
+static bool script_persistent = false;
+
+static pthread_t *script_threads = NULL;
 static pthread_mutex_t thread_flag_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t comp_list_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t comp_list_cond = PTHREAD_COND_INITIALIZER;
 static int agent_exit = 0;
 
+/* Script run by a worker in persistent mode, fed through fd */
+typedef struct {
+	pid_t pid;
+	int fd;
+} script_proc_t;
+
 /*
  *  Structure for holding job completion information for later
  *   use by script;
@@ -375,6 +393,28 @@ static int _env_append_fmt (char ***envp, const char *name,
 	return (_env_append (envp, name, val));
 }
 
+static const char *_tmp_dir(void)
+{
+#ifdef _PATH_TMP
+	return _PATH_TMP;
+#else
+	return "/tmp";
+#endif
+}
+
+static void _env_append_common (char ***envp)
+{
+	char *tz;
+
+	if ((tz = getenv ("TZ")))
+		_env_append_fmt (envp, "TZ", "%s", tz);
+#ifdef _PATH_STDPATH
+	_env_append (envp, "PATH", _PATH_STDPATH);
+#else
+	_env_append (envp, "PATH", "/bin:/usr/bin");
+#endif
+}
+
 static char ** _create_environment (struct jobcomp_info *job)
 {
 	char **env;
@@ -447,17 +487,73 @@ static char ** _create_environment (struct jobcomp_info *job)
 	mins2time_str(job->limit, time_str, sizeof(time_str));
 	_env_append (&env, "LIMIT", time_str);
 
-	if ((tz = getenv ("TZ")))
-		_env_append_fmt (&env, "TZ", "%s", tz);
-#ifdef _PATH_STDPATH
-	_env_append (&env, "PATH", _PATH_STDPATH);
-#else
-	_env_append (&env, "PATH", "/bin:/usr/bin");
-#endif
+	_env_append_common (&env);
 
 	return (env);
 }
 
+/* Escape characters according to RFC7159 and ECMA-262 11.8.4.2 */
+static char *_json_escape(const char *str)
+{
+	char *ret = NULL, *pos = NULL;
+	const char *p;
+
+	for (p = str; *p; p++) {
+		switch (*p) {
+		case '\\':
+			xstrfmtcatat(ret, &pos, "\\\\");
+			break;
+		case '"':
+			xstrfmtcatat(ret, &pos, "\\\"");
+			break;
+		case '\n':
+			xstrfmtcatat(ret, &pos, "\\n");
+			break;
+		case '\r':
+			xstrfmtcatat(ret, &pos, "\\r");
+			break;
+		case '\t':
+			xstrfmtcatat(ret, &pos, "\\t");
+			break;
+		default:
+			if ((unsigned char) *p < 0x20)
+				xstrfmtcatat(ret, &pos, "\\u%04x", *p);
+			else
+				xstrfmtcatat(ret, &pos, "%c", *p);
+		}
+	}
+
+	return ret ? ret : xstrdup("");
+}
+
+/*
+ * One line JSON object of the variables _create_environment() sets for job,
+ * for a persistent script.
+ */
+static char *_create_json(struct jobcomp_info *job)
+{
+	char **env = _create_environment(job);
+	char *json = NULL, *pos = NULL, *val;
+	int i;
+
+	for (i = 0; env[i]; i++) {
+		char *eq = strchr(env[i], '=');
+
+		*eq = '\0';
+		if (xstrcmp(env[i], "PATH") && xstrcmp(env[i], "TZ")) {
+			val = _json_escape(eq + 1);
+			xstrfmtcatat(json, &pos, "%s\"%s\":\"%s\"",
+				     json ? "," : "{", env[i], val);
+			xfree(val);
+		}
+		xfree(env[i]);
+	}
+	xfree(env);
+	xstrfmtcatat(json, &pos, "%s}\n", json ? "" : "{");
+
+	return json;
+}
+
 static int _redirect_stdio (void)
 {
 	int devnull;
@@ -476,14 +572,9 @@ static int _redirect_stdio (void)
 static void _jobcomp_child (char * script, struct jobcomp_info *job)
 {
 	char * args[] = {script, NULL};
-	const char *tmpdir;
+	const char *tmpdir = _tmp_dir();
 	char **env;
 
-#ifdef _PATH_TMP
-	tmpdir = _PATH_TMP;
-#else
-	tmpdir = "/tmp";
-#endif
 	/*
 	 * Reinitialize log so we can log any errors for
 	 *  diagnosis
@@ -542,12 +633,123 @@ static int _jobcomp_exec_child (char *script, struct jobcomp_info *job)
 	return (0);
 }
 
+static int _persistent_start(script_proc_t *proc)
+{
+	char *args[] = {script, NULL};
+	char **env;
+	int pfd[2];
+
+	if (pipe(pfd) < 0) {
+		error("jobcomp/script: pipe: %m");
+		return SLURM_ERROR;
+	}
+	fd_set_close_on_exec(pfd[0]);
+	fd_set_close_on_exec(pfd[1]);
+
+	if ((proc->pid = fork()) < 0) {
+		error("jobcomp/script: fork: %m");
+		close(pfd[0]);
+		close(pfd[1]);
+		return SLURM_ERROR;
+	}
+
+	if (proc->pid == 0) {
+		log_reinit();
+		if ((_redirect_stdio() < 0) ||
+		    (dup2(pfd[0], STDIN_FILENO) < 0))
+			_exit(1);
+		if (chdir(_tmp_dir()) != 0) {
+			error("jobcomp/script: chdir (%s): %m", _tmp_dir());
+			_exit(1);
+		}
+		env = xmalloc(sizeof(*env));
+		_env_append(&env, "JOBCOMP_PERSISTENT", "1");
+		_env_append_common(&env);
+		execve(script, args, env);
+		error("jobcomp/script: execve(%s): %m", script);
+		_exit(1);
+	}
+
+	close(pfd[0]);
+	proc->fd = pfd[1];
+	debug("jobcomp/script: started persistent %s, pid %d",
+	      script, (int) proc->pid);
+
+	return SLURM_SUCCESS;
+}
+
+/* Close the script's stdin and reap it, killing it if it does not exit */
+static void _persistent_stop(script_proc_t *proc)
+{
+	int i, status = 0;
+	pid_t rc = 0;
+
+	if (proc->fd < 0)
+		return;
+
+	close(proc->fd);
+	proc->fd = -1;
+
+	for (i = 0; i < 50; i++) {
+		if ((rc = waitpid(proc->pid, &status, WNOHANG)))
+			break;
+		usleep(100000);
+	}
+	if (!rc) {
+		error("jobcomp/script: persistent %s did not exit, killing it",
+		      script);
+		kill(proc->pid, SIGKILL);
+		rc = waitpid(proc->pid, &status, 0);
+	}
+
+	if (rc < 0)
+		error("jobcomp/script: waitpid: %m");
+	else if (WEXITSTATUS(status))
+		error("jobcomp/script: script %s exited with status %d",
+		      script, WEXITSTATUS(status));
+}
+
+static int _write_line(int fd, char *line)
+{
+	int size = strlen(line);
+
+	safe_write(fd, line, size);
+	return SLURM_SUCCESS;
+
+rwfail:
+	return SLURM_ERROR;
+}
+
+static int _persistent_send(script_proc_t *proc, struct jobcomp_info *job)
+{
+	char *json = _create_json(job);
+	int try, rc = SLURM_ERROR;
+
+	/* Restart the script once if it went away */
+	for (try = 0; try < 2; try++) {
+		if ((proc->fd < 0) &&
+		    (_persistent_start(proc) != SLURM_SUCCESS))
+			break;
+		if ((rc = _write_line(proc->fd, json)) == SLURM_SUCCESS)
+			break;
+		error("jobcomp/script: write to %s failed: %m", script);
+		_persistent_stop(proc);
+	}
+	xfree(json);
+
+	if (rc != SLURM_SUCCESS)
+		error("jobcomp/script: JobId=%u not logged", job->jobid);
+
+	return rc;
+}
 
 /*
- * Thread function that executes a script
+ * Thread function that executes a script, one per worker
  */
 static void * _script_agent (void *args)
 {
+	script_proc_t proc = { .fd = -1 };
+
 	while (1) {
 		struct jobcomp_info *job;
 
@@ -563,7 +765,10 @@ static void * _script_agent (void *args)
 		slurm_mutex_unlock(&comp_list_mutex);
 
 		if ((job = list_pop(comp_list))) {
-			_jobcomp_exec_child (script, job);
+			if (script_persistent)
+				(void) _persistent_send(&proc, job);
+			else
+				_jobcomp_exec_child (script, job);
 			_jobcomp_info_destroy (job);
 		}
 
@@ -574,6 +779,8 @@ static void * _script_agent (void *args)
 			break;
 	}
 
+	_persistent_stop(&proc);
+
 	return NULL;
 }
 
@@ -583,6 +790,9 @@ static void * _script_agent (void *args)
  */
 extern int init(void)
 {
+	char *tmp_ptr = NULL;
+	int i;
+
 	verbose("jobcomp/script plugin loaded init");
 
 	slurm_mutex_lock(&thread_flag_mutex);
@@ -592,9 +802,24 @@ extern int init(void)
 		return SLURM_ERROR;
 	}
 
+	/*                                                      12345678 */
+	if ((tmp_ptr = xstrcasestr(slurm_conf.job_comp_params, "workers="))) {
+		script_workers = xstrntol(tmp_ptr + 8, NULL, 10, 10);
+		if ((script_workers < 1) || (script_workers > MAX_WORKERS)) {
+			error("jobcomp/script: invalid workers, using 1");
+			script_workers = 1;
+		}
+	}
+	if (xstrcasestr(slurm_conf.job_comp_params, "persistent"))
+		script_persistent = true;
+	debug("jobcomp/script: %d workers%s", script_workers,
+	      script_persistent ? ", persistent script" : "");
+
 	comp_list = list_create(_jobcomp_info_destroy);
 
-	slurm_thread_create(&script_thread, _script_agent, NULL);
+	script_threads = xcalloc(script_workers, sizeof(pthread_t));
+	for (i = 0; i < script_workers; i++)
+		slurm_thread_create(&script_threads[i], _script_agent, NULL);
 
 	slurm_mutex_unlock(&thread_flag_mutex);
 
@@ -637,15 +862,18 @@ int slurm_jobcomp_log_record(job_record_t *record)
 /* Called when script unloads */
 extern int fini ( void )
 {
+	int i;
+
 	slurm_mutex_lock(&thread_flag_mutex);
-	if (script_thread) {
+	if (script_threads) {
 		verbose("Script Job Completion plugin shutting down");
 		agent_exit = 1;
 		slurm_mutex_lock(&comp_list_mutex);
 		slurm_cond_broadcast(&comp_list_cond);
 		slurm_mutex_unlock(&comp_list_mutex);
-		pthread_join(script_thread, NULL);
-		script_thread = 0;
+		for (i = 0; i < script_workers; i++)
+			pthread_join(script_threads[i], NULL);
+		xfree(script_threads);
 	}
 	slurm_mutex_unlock(&thread_flag_mutex);
 
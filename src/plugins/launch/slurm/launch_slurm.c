@@ -100,6 +100,17 @@ static pthread_mutex_t start_mutex = PTHREAD_MUTEX_INITIALIZER;
 static slurm_opt_t *opt_save = NULL;
 
 static List task_state_list = NULL;
+
+/* task ID to node index map of a step, see _get_task_node_map() */
+typedef struct {
+	slurm_step_id_t step_id;
+	uint32_t task_cnt;
+	uint32_t *node_inx;	/* node index of each task, NO_VAL if unknown */
+	hostlist_t hl;		/* node names of the step */
+} task_node_map_t;
+
+static List task_node_maps = NULL;
+static pthread_mutex_t task_node_lock = PTHREAD_MUTEX_INITIALIZER;
 static time_t launch_start_time;
 static bool retry_step_begin = false;
 static int  retry_step_cnt = 0;
@@ -126,6 +137,66 @@ static char *_hostset_to_string(hostset_t hs)
 	return str;
 }
 
+static void _task_node_map_del(void *x)
+{
+	task_node_map_t *map = x;
+
+	if (!map)
+		return;
+
+	xfree(map->node_inx);
+	hostlist_destroy(map->hl);
+	xfree(map);
+}
+
+static int _find_task_node_map(void *x, void *key)
+{
+	task_node_map_t *map = x;
+
+	return verify_step_id(&map->step_id, key);
+}
+
+/*
+ * Return the task ID to node index map of a step, built on first use.
+ * slurm_step_layout_host_name() searches the whole layout and parses the
+ * node list for every task, which is quadratic in the step size when
+ * reporting the exit of every task of a large step.
+ * Must hold task_node_lock.
+ */
+static task_node_map_t *_get_task_node_map(srun_job_t *my_srun_job,
+					   slurm_step_layout_t *sl)
+{
+	task_node_map_t *map;
+	int i, j;
+
+	if (!task_node_maps)
+		task_node_maps = list_create(_task_node_map_del);
+
+	map = list_find_first(task_node_maps, _find_task_node_map,
+			      &my_srun_job->step_id);
+	if (map && (map->task_cnt == sl->task_cnt))
+		return map;
+	if (map)	/* tasks were added to the step */
+		list_delete_ptr(task_node_maps, map);
+
+	map = xmalloc(sizeof(*map));
+	memcpy(&map->step_id, &my_srun_job->step_id, sizeof(map->step_id));
+	map->task_cnt = sl->task_cnt;
+	map->node_inx = xcalloc(sl->task_cnt, sizeof(uint32_t));
+	for (i = 0; i < sl->task_cnt; i++)
+		map->node_inx[i] = NO_VAL;
+	for (i = 0; i < sl->node_cnt; i++) {
+		for (j = 0; j < sl->tasks[i]; j++) {
+			if (sl->tids[i][j] < sl->task_cnt)
+				map->node_inx[sl->tids[i][j]] = i;
+		}
+	}
+	map->hl = hostlist_create(sl->node_list);
+	list_append(task_node_maps, map);
+
+	return map;
+}
+
 /*
  * Convert an array of task IDs into a list of host names
  * RET: the string, caller must xfree() this value
@@ -133,38 +204,45 @@ static char *_hostset_to_string(hostset_t hs)
 static char *_task_ids_to_host_list(int ntasks, uint32_t *taskids,
 				    srun_job_t *my_srun_job)
 {
-	int i, task_cnt = 0;
+	int i, first, last;
 	hostset_t hs;
 	char *hosts;
 	slurm_step_layout_t *sl;
+	task_node_map_t *map;
+	bitstr_t *nodes;
 
 	if ((sl = launch_common_get_slurm_step_layout(my_srun_job)) == NULL)
 		return (xstrdup("Unknown"));
-
-	/*
-	 * If overhead of determining the hostlist is too high then srun
-	 * communications will timeout and fail, so return "Unknown" instead.
-	 *
-	 * See slurm_step_layout_host_id() in src/common/slurm_step_layout.c
-	 * for details.
-	 */
-	for (i = 0; i < sl->node_cnt; i++) {
-		task_cnt += sl->tasks[i];
-	}
-	if (task_cnt > 100000)
+	if (!sl->tasks || !sl->tids || !sl->node_cnt)
 		return (xstrdup("Unknown"));
 
-	hs = hostset_create(NULL);
+	slurm_mutex_lock(&task_node_lock);
+	map = _get_task_node_map(my_srun_job, sl);
+
+	nodes = bit_alloc(sl->node_cnt);
 	for (i = 0; i < ntasks; i++) {
-		char *host = slurm_step_layout_host_name(sl, taskids[i]);
-		if (host) {
-			hostset_insert(hs, host);
-			free(host);
-		} else {
+		if ((taskids[i] >= map->task_cnt) ||
+		    (map->node_inx[taskids[i]] == NO_VAL)) {
 			error("Could not identify host name for task %u",
 			      taskids[i]);
+			continue;
 		}
+		bit_set(nodes, map->node_inx[taskids[i]]);
+	}
+
+	hs = hostset_create(NULL);
+	first = bit_ffs(nodes);
+	last = bit_fls(nodes);
+	for (i = first; (first >= 0) && (i <= last); i++) {
+		char *host;
+
+		if (!bit_test(nodes, i) || !(host = hostlist_nth(map->hl, i)))
+			continue;
+		hostset_insert(hs, host);
+		free(host);
 	}
+	slurm_mutex_unlock(&task_node_lock);
+	FREE_NULL_BITMAP(nodes);
 
 	hosts = _hostset_to_string(hs);
 	hostset_destroy(hs);
@@ -549,6 +627,7 @@ extern int init(void)
 extern int fini(void)
 {
 	FREE_NULL_LIST(task_state_list);
+	FREE_NULL_LIST(task_node_maps);
 
 	return SLURM_SUCCESS;
 }
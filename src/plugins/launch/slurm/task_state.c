@@ -198,8 +198,11 @@ extern void task_state_update(task_state_t *ts, int task_id,
 		break;
 	}
 
-	xassert((bit_set_count(ts->abnormal_exit) +
-		 bit_set_count(ts->normal_exit)) == ts->n_exited);
+	/*
+	 * Counting the exit bitmaps here would make reporting the exit of
+	 * every task of a large step quadratic, only check the counter.
+	 */
+	xassert(ts->n_exited <= ts->n_tasks);
 }
 
 /*
@@ -61,10 +61,9 @@ typedef struct kvs_bucket {
 
 static kvs_bucket_t *kvs_hash = NULL;
 static uint32_t hash_size = 0;
+static uint32_t kvs_count = 0;
 
-static char *temp_kvs_buf = NULL;
-static int temp_kvs_cnt = 0;
-static int temp_kvs_size = 0;
+static buf_t *temp_kvs_buf = NULL;
 
 static int no_dup_keys = 0;
 
@@ -75,17 +74,15 @@ static int no_dup_keys = 0;
 #define VAL_INDEX(i) (i * 2 + 1)
 #define HASH(key) ( _hash(key) % hash_size)
 
+/* FNV-1a, keys commonly differ only in a few digits of an embedded rank */
 inline static uint32_t
 _hash(char *key)
 {
-	int len, i;
-	uint32_t hash = 0;
-	uint8_t shift;
-
-	len = strlen(key);
-	for (i = 0; i < len; i ++) {
-		shift = (uint8_t)(hash >> 24);
-		hash = (hash << 8) | (uint32_t)(shift ^ (uint8_t)key[i]);
+	uint32_t hash = 2166136261U;
+
+	for (; *key; key++) {
+		hash ^= (uint8_t) *key;
+		hash *= 16777619U;
 	}
 	return hash;
 }
@@ -94,13 +91,10 @@ extern int
 temp_kvs_init(void)
 {
 	uint16_t cmd;
-	uint32_t nodeid, num_children, size;
-	buf_t *buf = NULL;
+	uint32_t nodeid, num_children;
 
-	xfree(temp_kvs_buf);
-	temp_kvs_cnt = 0;
-	temp_kvs_size = TEMP_KVS_SIZE_INC;
-	temp_kvs_buf = xmalloc(temp_kvs_size);
+	FREE_NULL_BUFFER(temp_kvs_buf);
+	temp_kvs_buf = init_buf(TEMP_KVS_SIZE_INC);
 
 	/* put the tree cmd here to simplify message sending */
 	if (in_stepd()) {
@@ -109,28 +103,19 @@ temp_kvs_init(void)
 		cmd = TREE_CMD_KVS_FENCE_RESP;
 	}
 
-	buf = init_buf(1024);
-	pack16(cmd, buf);
+	pack16(cmd, temp_kvs_buf);
 	if (in_stepd()) {
 		nodeid = job_info.nodeid;
 		/* XXX: TBC */
 		num_children = tree_info.num_children + 1;
 
-		pack32(nodeid, buf); /* from_nodeid */
-		packstr(tree_info.this_node, buf); /* from_node */
-		pack32(num_children, buf); /* num_children */
-		pack32(kvs_seq, buf);
+		pack32(nodeid, temp_kvs_buf); /* from_nodeid */
+		packstr(tree_info.this_node, temp_kvs_buf); /* from_node */
+		pack32(num_children, temp_kvs_buf); /* num_children */
+		pack32(kvs_seq, temp_kvs_buf);
 	} else {
-		pack32(kvs_seq, buf);
-	}
-	size = get_buf_offset(buf);
-	if (temp_kvs_cnt + size > temp_kvs_size) {
-		temp_kvs_size += TEMP_KVS_SIZE_INC;
-		xrealloc(temp_kvs_buf, temp_kvs_size);
+		pack32(kvs_seq, temp_kvs_buf);
 	}
-	memcpy(&temp_kvs_buf[temp_kvs_cnt], get_buf_data(buf), size);
-	temp_kvs_cnt += size;
-	free_buf(buf);
 
 	tasks_to_wait = 0;
 	children_to_wait = 0;
@@ -141,23 +126,11 @@ temp_kvs_init(void)
 extern int
 temp_kvs_add(char *key, char *val)
 {
-	buf_t *buf;
-	uint32_t size;
-
 	if ( key == NULL || val == NULL )
 		return SLURM_SUCCESS;
 
-	buf = init_buf(PMI2_MAX_KEYLEN + PMI2_MAX_VALLEN + 2 * sizeof(uint32_t));
-	packstr(key, buf);
-	packstr(val, buf);
-	size = get_buf_offset(buf);
-	if (temp_kvs_cnt + size > temp_kvs_size) {
-		temp_kvs_size += TEMP_KVS_SIZE_INC;
-		xrealloc(temp_kvs_buf, temp_kvs_size);
-	}
-	memcpy(&temp_kvs_buf[temp_kvs_cnt], get_buf_data(buf), size);
-	temp_kvs_cnt += size;
-	free_buf(buf);
+	packstr(key, temp_kvs_buf);
+	packstr(val, temp_kvs_buf);
 
 	return SLURM_SUCCESS;
 }
@@ -174,12 +147,14 @@ extern int temp_kvs_merge(buf_t *buf)
 	data = get_buf_data(buf);
 	offset = get_buf_offset(buf);
 
-	if (temp_kvs_cnt + size > temp_kvs_size) {
-		temp_kvs_size += size;
-		xrealloc(temp_kvs_buf, temp_kvs_size);
-	}
-	memcpy(&temp_kvs_buf[temp_kvs_cnt], &data[offset], size);
-	temp_kvs_cnt += size;
+	/* grow geometrically, children of a wide tree merge one by one */
+	if (remaining_buf(temp_kvs_buf) < size)
+		grow_buf(temp_kvs_buf, MAX(size, size_buf(temp_kvs_buf)));
+	if (remaining_buf(temp_kvs_buf) < size)
+		return SLURM_ERROR;
+	memcpy(get_buf_data(temp_kvs_buf) + get_buf_offset(temp_kvs_buf),
+	       &data[offset], size);
+	set_buf_offset(temp_kvs_buf, get_buf_offset(temp_kvs_buf) + size);
 
 	return SLURM_SUCCESS;
 }
@@ -207,10 +182,11 @@ temp_kvs_send(void)
 			/* srun or non-first-level stepds */
 			rc = slurm_forward_data(&nodelist,
 						tree_sock_addr,
-						temp_kvs_cnt,
-						temp_kvs_buf);
+						get_buf_offset(temp_kvs_buf),
+						get_buf_data(temp_kvs_buf));
 		else		/* first level stepds */
-			rc = tree_msg_to_srun(temp_kvs_cnt, temp_kvs_buf);
+			rc = tree_msg_to_srun(get_buf_offset(temp_kvs_buf),
+					      get_buf_data(temp_kvs_buf));
 
 		if (rc == SLURM_SUCCESS)
 			break;
@@ -230,6 +206,48 @@ temp_kvs_send(void)
 
 /**************************************************************/
 
+static void
+_bucket_add(kvs_bucket_t *bucket, char *key, char *val)
+{
+	int i;
+
+	if (bucket->count * 2 >= bucket->size) {
+		bucket->size += (TASKS_PER_BUCKET * 2);
+		xrealloc(bucket->pairs, bucket->size * sizeof(char *));
+	}
+	i = bucket->count;
+	bucket->pairs[KEY_INDEX(i)] = key;
+	bucket->pairs[VAL_INDEX(i)] = val;
+	bucket->count ++;
+}
+
+/*
+ * Grow the table once buckets average more than twice the expected number
+ * of pairs, so lookups stay short when tasks put many keys each.
+ */
+static void
+_kvs_rehash(uint32_t new_size)
+{
+	kvs_bucket_t *old_hash = kvs_hash;
+	uint32_t old_size = hash_size;
+	int i, j;
+
+	debug3("mpi/pmi2: kvs rehash %u -> %u buckets", old_size, new_size);
+
+	hash_size = new_size;
+	kvs_hash = xmalloc(hash_size * sizeof(kvs_bucket_t));
+	for (i = 0; i < old_size; i ++) {
+		kvs_bucket_t *bucket = &old_hash[i];
+		for (j = 0; j < bucket->count; j ++) {
+			char *key = bucket->pairs[KEY_INDEX(j)];
+			_bucket_add(&kvs_hash[HASH(key)], key,
+				    bucket->pairs[VAL_INDEX(j)]);
+		}
+		xfree(bucket->pairs);
+	}
+	xfree(old_hash);
+}
+
 extern int
 kvs_init(void)
 {
@@ -293,15 +311,13 @@ kvs_put(char *key, char *val)
 			}
 		}
 	}
-	if (bucket->count * 2 >= bucket->size) {
-		bucket->size += (TASKS_PER_BUCKET * 2);
-		xrealloc(bucket->pairs, bucket->size * sizeof(char *));
+	if (kvs_count >= (hash_size * TASKS_PER_BUCKET * 2)) {
+		_kvs_rehash(hash_size * 2);
+		bucket = &kvs_hash[HASH(key)];
 	}
 	/* add the k-v pair */
-	i = bucket->count;
-	bucket->pairs[KEY_INDEX(i)] = xstrdup(key);
-	bucket->pairs[VAL_INDEX(i)] = xstrdup(val);
-	bucket->count ++;
+	_bucket_add(bucket, xstrdup(key), xstrdup(val));
+	kvs_count++;
 
 	debug3("mpi/pmi2: put kvs %s=%s", key, val);
 	return SLURM_SUCCESS;
@@ -319,8 +335,10 @@ kvs_clear(void)
 			xfree (bucket->pairs[KEY_INDEX(j)]);
 			xfree (bucket->pairs[VAL_INDEX(j)]);
 		}
+		xfree(bucket->pairs);
 	}
 	xfree(kvs_hash);
+	kvs_count = 0;
 
 	return SLURM_SUCCESS;
 }
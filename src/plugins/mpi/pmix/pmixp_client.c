@@ -768,20 +768,9 @@ extern int pmixp_lib_fence(const pmixp_proc_t procs[], size_t nprocs,
 	/* Chooses the coll algorithm defined by user
 	 * thru the env variable: SLURM_PMIXP_FENCE.
 	 * By default: PMIXP_COLL_TYPE_FENCE_AUTO
-	 * is used the both fence algorithms */
-	pmixp_coll_type_t type = pmixp_info_srv_fence_coll_type();
-
-	if (PMIXP_COLL_TYPE_FENCE_MAX == type) {
-		type = PMIXP_COLL_TYPE_FENCE_TREE;
-		/*
-		 * Practice shows the Tree algorithm has better performance
-		 * performance for fence with zero data. Only use the Ring
-		 * algorithm if there is data to collect.
-		 */
-		if (collect && (ndata > 0)) {
-			type = PMIXP_COLL_TYPE_FENCE_RING;
-		}
-	}
+	 * picks the algorithm per fence */
+	pmixp_coll_type_t type = pmixp_coll_fence_select(procs, nprocs,
+							 collect, ndata);
 
 	coll = pmixp_state_coll_get(type, procs, nprocs);
 	if (!coll) {
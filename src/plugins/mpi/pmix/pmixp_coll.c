@@ -151,6 +151,8 @@ int pmixp_coll_contrib_local(pmixp_coll_t *coll, pmixp_coll_type_t type,
 	PMIXP_DEBUG("%p: %s seq=%d, size=%lu", coll, pmixp_coll_type2str(type),
 		    coll->seq, ndata);
 #endif
+	gettimeofday(&coll->stats.tv_start, NULL);
+
 	switch (type) {
 	case PMIXP_COLL_TYPE_FENCE_TREE:
 		ret = pmixp_coll_tree_local(coll, data, ndata,
@@ -217,10 +219,101 @@ exit:
 	return rc;
 }
 
+/*
+ * Count the nodes participating in a fence. The common case of a single
+ * wildcard over a known namespace is answered without building a hostlist.
+ */
+static int _fence_nodes_cnt(const pmixp_proc_t *procs, size_t nprocs)
+{
+	hostlist_t hl;
+	int cnt;
+
+	if ((nprocs == 1) && pmixp_lib_is_wildcard(procs[0].rank)) {
+		pmixp_namespace_t *nsptr = pmixp_nspaces_find(procs[0].nspace);
+		if (nsptr)
+			return nsptr->nnodes;
+	}
+
+	if (pmixp_hostset_from_ranges(procs, nprocs, &hl))
+		return -1;
+	cnt = hostlist_count(hl);
+	hostlist_destroy(hl);
+
+	return cnt;
+}
+
+/*
+ * Choose the fence algorithm for the auto (mixed) mode.
+ *
+ * Every node of the fence must take the same decision, so only inputs that
+ * are identical on all participants are used: the node count and whether
+ * data is collected. The ring moves the least data per link but needs one
+ * step per node, so past SLURM_PMIX_FENCE_RING_MAX_NODES its latency loses
+ * to the logarithmic depth of the tree.
+ */
+pmixp_coll_type_t pmixp_coll_fence_select(const pmixp_proc_t *procs,
+					  size_t nprocs, bool collect,
+					  size_t ndata)
+{
+	pmixp_coll_type_t type = pmixp_info_srv_fence_coll_type();
+	int nodes;
+
+	if (PMIXP_COLL_TYPE_FENCE_MAX != type)
+		return type;
+
+	/*
+	 * Practice shows the Tree algorithm has better performance
+	 * for fence with zero data. Only use the Ring algorithm
+	 * if there is data to collect.
+	 */
+	if (!collect || !ndata)
+		return PMIXP_COLL_TYPE_FENCE_TREE;
+
+	nodes = _fence_nodes_cnt(procs, nprocs);
+	if ((nodes < 0) ||
+	    ((uint32_t) nodes > pmixp_info_srv_fence_ring_max()))
+		type = PMIXP_COLL_TYPE_FENCE_TREE;
+	else
+		type = PMIXP_COLL_TYPE_FENCE_RING;
+
+#ifdef PMIXP_COLL_DEBUG
+	PMIXP_DEBUG("nodes=%d size=%lu: selected %s",
+		    nodes, ndata, pmixp_coll_type2str(type));
+#endif
+	return type;
+}
+
+/* Account a completed fence, called on local delivery of the result */
+void pmixp_coll_stats_done(pmixp_coll_t *coll, size_t size)
+{
+	struct timeval tv;
+	double elapsed;
+
+	gettimeofday(&tv, NULL);
+	elapsed = (tv.tv_sec - coll->stats.tv_start.tv_sec) +
+		  1E-6 * (tv.tv_usec - coll->stats.tv_start.tv_usec);
+
+	coll->stats.count++;
+	coll->stats.bytes += size;
+	coll->stats.time_total += elapsed;
+	if (elapsed > coll->stats.time_max)
+		coll->stats.time_max = elapsed;
+}
+
 void pmixp_coll_free(pmixp_coll_t *coll)
 {
 	pmixp_coll_sanity_check(coll);
 
+	if (coll->stats.count) {
+		PMIXP_DEBUG("%p: %s peers=%d fences=%u bytes=%"PRIu64
+			    " time total=%.6lf avg=%.6lf max=%.6lf",
+			    coll, pmixp_coll_type2str(coll->type),
+			    coll->peers_cnt, coll->stats.count,
+			    coll->stats.bytes, coll->stats.time_total,
+			    coll->stats.time_total / coll->stats.count,
+			    coll->stats.time_max);
+	}
+
 	if (NULL != coll->pset.procs) {
 		xfree(coll->pset.procs);
 	}
@@ -283,6 +283,15 @@ typedef struct pmixp_coll_s {
 	/* timestamp for stale collectives detection */
 	time_t ts, ts_next;
 
+	/* per-collective fence statistics, reported when freed */
+	struct {
+		struct timeval tv_start;
+		uint32_t count;
+		uint64_t bytes;
+		double time_total;
+		double time_max;
+	} stats;
+
 	/* coll states */
 	union {
 		pmixp_coll_tree_t tree;
@@ -343,6 +352,10 @@ int pmixp_coll_contrib_local(pmixp_coll_t *coll, pmixp_coll_type_t type,
 			     char *data, size_t ndata,
 			     void *cbfunc, void *cbdata);
 void pmixp_coll_free(pmixp_coll_t *coll);
+pmixp_coll_type_t pmixp_coll_fence_select(const pmixp_proc_t *procs,
+					  size_t nprocs, bool collect,
+					  size_t ndata);
+void pmixp_coll_stats_done(pmixp_coll_t *coll, size_t size);
 void pmixp_coll_localcb_nodata(pmixp_coll_t *coll, int status);
 int pmixp_coll_belong_chk(const pmixp_proc_t *procs, size_t nprocs);
 void pmixp_coll_log(pmixp_coll_t *coll);
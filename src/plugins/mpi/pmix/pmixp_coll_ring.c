@@ -347,6 +347,7 @@ static void _invoke_callback(pmixp_coll_ring_ctx_t *coll_ctx)
 
 	data = get_buf_data(coll_ctx->ring_buf);
 	data_sz = get_buf_offset(coll_ctx->ring_buf);
+	pmixp_coll_stats_done(coll, data_sz);
 	cbdata = xmalloc(sizeof(pmixp_coll_ring_cbdata_t));
 
 	cbdata->coll = coll;
@@ -542,7 +543,8 @@ inline static int _pmixp_coll_contrib(pmixp_coll_ring_ctx_t *coll_ctx,
 			_ring_remain_contrib(coll_ctx);
 		grow_buf(coll_ctx->ring_buf, new_size);
 	}
-	grow_buf(coll_ctx->ring_buf, size);
+	if (remaining_buf(coll_ctx->ring_buf) < size)
+		grow_buf(coll_ctx->ring_buf, size);
 	data_ptr = get_buf_data(coll_ctx->ring_buf) +
 		get_buf_offset(coll_ctx->ring_buf);
 	memcpy(data_ptr, data, size);
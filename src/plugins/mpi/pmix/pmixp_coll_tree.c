@@ -525,6 +525,18 @@ static int _progress_collect(pmixp_coll_t *coll)
 		tree->ufwd_status = PMIXP_COLL_TREE_SND_ACTIVE;
 		PMIXP_DEBUG("%p: send data to %s:%d",
 			    coll, tree->prnt_host, tree->prnt_peerid);
+	} else if (tree->ufwd_offset == tree->dfwd_offset) {
+		/* Both buffers carry the same service header, so the
+		 * aggregated data becomes the broadcast message as is.
+		 * The former output buffer is reset as the input for
+		 * the next collective when we leave UPFWD. */
+		buf_t *buf = tree->dfwd_buf;
+		tree->dfwd_buf = tree->ufwd_buf;
+		tree->ufwd_buf = buf;
+		/* no need to send */
+		tree->ufwd_status = PMIXP_COLL_TREE_SND_DONE;
+		/* this is root */
+		tree->contrib_prnt = true;
 	} else {
 		/* move data from input buffer to the output */
 		char *dst, *src = get_buf_data(tree->ufwd_buf) +
@@ -692,6 +704,7 @@ static int _progress_ufwd(pmixp_coll_t *coll)
 		size_t size = get_buf_offset(tree->dfwd_buf) -
 			tree->dfwd_offset;
 		tree->dfwd_cb_wait++;
+		pmixp_coll_stats_done(coll, size);
 		pmixp_lib_modex_invoke(coll->cbfunc, SLURM_SUCCESS,
 				       data, size, coll->cbdata,
 				       _libpmix_cb, (void*)cbdata);
@@ -782,6 +795,7 @@ static int _progress_ufwd_wpc(pmixp_coll_t *coll)
 		char *data = get_buf_data(tree->dfwd_buf) + tree->dfwd_offset;
 		size_t size = get_buf_offset(tree->dfwd_buf) -
 			tree->dfwd_offset;
+		pmixp_coll_stats_done(coll, size);
 		pmixp_lib_modex_invoke(coll->cbfunc, SLURM_SUCCESS, data, size,
 				       coll->cbdata, _libpmix_cb,
 				       (void *)cbdata);
@@ -154,6 +154,9 @@
 #define PMIXP_CPERF_BOUND "SLURM_PMIX_COLL_PERF_LARGE_PWR2"
 /* The prefered fence type, values:[auto|tree|ring] */
 #define PMIXP_COLL_FENCE "SLURM_PMIX_FENCE"
+/* Largest node count for which the auto fence mode uses the ring */
+#define PMIXP_COLL_FENCE_RING_MAX "SLURM_PMIX_FENCE_RING_MAX_NODES"
+#define PMIXP_COLL_FENCE_RING_MAX_DEF 256
 #define SLURM_PMIXP_FENCE_BARRIER "SLURM_PMIX_FENCE_BARRIER"
 
 typedef enum {
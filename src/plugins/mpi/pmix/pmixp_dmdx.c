@@ -51,15 +51,21 @@ typedef enum {
 typedef struct {
 	uint32_t seq_num;
 	time_t ts;
-#ifndef NDEBUG
-	/* we need this only for verification */
-	char nspace[PMIXP_MAX_NSLEN];
+	/* used to coalesce concurrent requests for the same process */
+	char nspace[PMIXP_MAX_NSLEN + 1];
 	int rank;
-#endif
+	/* false if this request waits on the message of another one */
+	bool sent;
 	void *cbfunc;
 	void *cbdata;
 } dmdx_req_info_t;
 
+/* response buffer shared by all requests coalesced under one message */
+typedef struct {
+	buf_t *buf;
+	int refcnt;
+} dmdx_resp_ref_t;
+
 typedef struct {
 	uint32_t seq_num;
 	pmixp_proc_t proc;
@@ -82,6 +88,8 @@ void _dmdx_free_caddy(dmdx_caddy_t *caddy)
 
 static List _dmdx_requests;
 static uint32_t _dmdx_seq_num = 1;
+/* keeps lookup and insertion of coalesced requests atomic with responses */
+static pthread_mutex_t _dmdx_lock = PTHREAD_MUTEX_INITIALIZER;
 
 static void _respond_with_error(int seq_num, int nodeid,
 				char *sender_ns, int status);
@@ -232,37 +240,111 @@ static void _dmdx_pmix_cb(int status, char *data, size_t sz,
 	_dmdx_free_caddy(caddy);
 }
 
+static int _dmdx_req_cmp(void *x, void *key)
+{
+	dmdx_req_info_t *req = (dmdx_req_info_t *)x;
+	uint32_t seq_num = *((uint32_t *)key);
+	return (req->seq_num == seq_num);
+}
+
+/* Remove and return all requests waiting on message seq_num */
+static List _dmdx_take(uint32_t seq_num)
+{
+	List reqs = list_create(xfree_ptr);
+	dmdx_req_info_t *req;
+
+	slurm_mutex_lock(&_dmdx_lock);
+	while ((req = list_remove_first(_dmdx_requests, _dmdx_req_cmp,
+					&seq_num)))
+		list_append(reqs, req);
+	slurm_mutex_unlock(&_dmdx_lock);
+
+	return reqs;
+}
+
+/* Notify libpmix about the failure of every request in reqs */
+static void _dmdx_fail(List reqs, int status)
+{
+	dmdx_req_info_t *req;
+
+	while ((req = list_pop(reqs))) {
+		pmixp_lib_modex_invoke(req->cbfunc, status, NULL, 0,
+				       req->cbdata, NULL, NULL);
+		xfree(req);
+	}
+	list_destroy(reqs);
+}
+
+static void _dmdx_resp_release(void *x)
+{
+	dmdx_resp_ref_t *ref = (dmdx_resp_ref_t *)x;
+	bool last;
+
+	slurm_mutex_lock(&_dmdx_lock);
+	last = !(--ref->refcnt);
+	slurm_mutex_unlock(&_dmdx_lock);
+
+	if (last) {
+		FREE_NULL_BUFFER(ref->buf);
+		xfree(ref);
+	}
+}
+
+static int _dmdx_req_inflight(void *x, void *key)
+{
+	dmdx_req_info_t *req = (dmdx_req_info_t *)x;
+	dmdx_req_info_t *new = (dmdx_req_info_t *)key;
+
+	return (req->sent && (req->rank == new->rank) &&
+		!xstrcmp(req->nspace, new->nspace));
+}
+
 int pmixp_dmdx_get(const char *nspace, int rank,
 		   void *cbfunc, void *cbdata)
 {
-	dmdx_req_info_t *req;
+	dmdx_req_info_t *req, *inflight;
 	buf_t *buf;
 	int rc;
 	uint32_t seq;
 	pmixp_ep_t ep;
 
-	/* need to send the request */
-	ep.type = PMIXP_EP_NOIDEID;
-	ep.ep.nodeid = pmixp_nspace_resolve(nspace, rank);
-
-	buf = pmixp_server_buf_new();
-	/* setup message header */
-	_setup_header(buf, DMDX_REQUEST, nspace, rank, SLURM_SUCCESS);
-
-	/* store cur seq. num and move to the next request */
-	seq = _dmdx_seq_num++;
-
 	/* track this request */
 	req = xmalloc(sizeof(dmdx_req_info_t));
-	req->seq_num = seq;
 	req->cbfunc = cbfunc;
 	req->cbdata = cbdata;
 	req->ts = time(NULL);
-#ifndef NDEBUG
-	strncpy(req->nspace, nspace, PMIXP_MAX_NSLEN);
+	strlcpy(req->nspace, nspace, sizeof(req->nspace));
 	req->rank = rank;
-#endif
+
+	slurm_mutex_lock(&_dmdx_lock);
+	/*
+	 * Several local ranks asking for the same remote process at once
+	 * (typical for all-to-all connection setup) share one message.
+	 */
+	inflight = list_find_first(_dmdx_requests, _dmdx_req_inflight, req);
+	if (inflight) {
+		req->seq_num = inflight->seq_num;
+		list_append(_dmdx_requests, req);
+		slurm_mutex_unlock(&_dmdx_lock);
+		PMIXP_DEBUG("coalesce ns=%s, rank=%d into seq=%u",
+			    nspace, rank, req->seq_num);
+		return SLURM_SUCCESS;
+	}
+
+	/* store cur seq. num and move to the next request */
+	seq = _dmdx_seq_num++;
+	req->seq_num = seq;
+	req->sent = true;
 	list_append(_dmdx_requests, req);
+	slurm_mutex_unlock(&_dmdx_lock);
+
+	/* need to send the request */
+	ep.type = PMIXP_EP_NOIDEID;
+	ep.ep.nodeid = pmixp_nspace_resolve(nspace, rank);
+
+	buf = pmixp_server_buf_new();
+	/* setup message header */
+	_setup_header(buf, DMDX_REQUEST, nspace, rank, SLURM_SUCCESS);
 
 	/* send the request */
 	rc = pmixp_server_send_nb(&ep, PMIXP_MSG_DMDX, seq, buf,
@@ -274,8 +356,7 @@ int pmixp_dmdx_get(const char *nspace, int rank,
 		PMIXP_ERROR("Cannot send direct modex request to %s, size %d",
 			    nodename, get_buf_offset(buf));
 		xfree(nodename);
-		pmixp_lib_modex_invoke(cbfunc, SLURM_ERROR, NULL, 0,
-				       cbdata, NULL, NULL);
+		_dmdx_fail(_dmdx_take(seq), SLURM_ERROR);
 		rc = SLURM_ERROR;
 	}
 
@@ -359,31 +440,25 @@ exit:
 	 * anyway. We've notified libpmix, that's enough */
 }
 
-static int _dmdx_req_cmp(void *x, void *key)
-{
-	dmdx_req_info_t *req = (dmdx_req_info_t *)x;
-	uint32_t seq_num = *((uint32_t *)key);
-	return (req->seq_num == seq_num);
-}
-
 static void _dmdx_resp(buf_t *buf, int nodeid, uint32_t seq_num)
 {
 	dmdx_req_info_t *req;
+	dmdx_resp_ref_t *ref;
 	int rank, rc = SLURM_SUCCESS;
 	int status;
 	char *ns = NULL, *sender_ns = NULL;
 	char *data = NULL;
 	uint32_t size = 0;
+	List reqs;
 
-	/* find the request tracker */
-	ListIterator it = list_iterator_create(_dmdx_requests);
-	req = (dmdx_req_info_t *)list_find(it, _dmdx_req_cmp, &seq_num);
-	if (NULL == req) {
+	/* find the request trackers */
+	reqs = _dmdx_take(seq_num);
+	if (!list_count(reqs)) {
 		char *nodename = pmixp_info_job_host(nodeid);
 		/* We haven't sent this request! */
 		PMIXP_ERROR("Received DMDX response with bad seq_num=%d from %s!",
 			    seq_num, nodename);
-		list_iterator_destroy(it);
+		list_destroy(reqs);
 		rc = SLURM_ERROR;
 		xfree(nodename);
 		goto exit;
@@ -393,27 +468,39 @@ static void _dmdx_resp(buf_t *buf, int nodeid, uint32_t seq_num)
 	rc = _read_info(buf, &ns, &rank, &sender_ns, &status);
 	if (SLURM_SUCCESS != rc) {
 		/* notify libpmix about an error */
-		pmixp_lib_modex_invoke(req->cbfunc, SLURM_ERROR, NULL, 0,
-				       req->cbdata, NULL, NULL);
+		_dmdx_fail(reqs, SLURM_ERROR);
 		goto exit;
 	}
 
 	/* get the modex blob */
 	if (SLURM_SUCCESS != (rc = unpackmem_ptr(&data, &size, buf))) {
 		/* notify libpmix about an error */
-		pmixp_lib_modex_invoke(req->cbfunc, SLURM_ERROR, NULL, 0,
-				       req->cbdata, NULL, NULL);
+		_dmdx_fail(reqs, SLURM_ERROR);
 		goto exit;
 	}
 
-	/* call back to libpmix-server */
-	pmixp_lib_modex_invoke(req->cbfunc, status, data, size,
-			       req->cbdata, pmixp_free_buf, (void *)buf);
+	if (list_count(reqs) == 1) {
+		/* call back to libpmix-server */
+		req = list_pop(reqs);
+		pmixp_lib_modex_invoke(req->cbfunc, status, data, size,
+				       req->cbdata, pmixp_free_buf,
+				       (void *)buf);
+		xfree(req);
+		list_destroy(reqs);
+		goto exit;
+	}
 
-	/* release tracker & list iterator */
-	req = NULL;
-	list_delete_item(it);
-	list_iterator_destroy(it);
+	/* the blob is released after the last coalesced request is done */
+	ref = xmalloc(sizeof(*ref));
+	ref->buf = buf;
+	ref->refcnt = list_count(reqs);
+	while ((req = list_pop(reqs))) {
+		pmixp_lib_modex_invoke(req->cbfunc, status, data, size,
+				       req->cbdata, _dmdx_resp_release,
+				       (void *)ref);
+		xfree(req);
+	}
+	list_destroy(reqs);
 exit:
 	if (SLURM_SUCCESS != rc) {
 		/* we are not expect libpmix to call the callback
@@ -447,33 +534,39 @@ void pmixp_dmdx_process(buf_t *buf, int nodeid, uint32_t seq)
 
 void pmixp_dmdx_timeout_cleanup(void)
 {
-	ListIterator it = list_iterator_create(_dmdx_requests);
+	ListIterator it;
 	dmdx_req_info_t *req = NULL;
 	time_t ts = time(NULL);
+	List stale = list_create(xfree_ptr);
 
 	/* run through all requests and discard stale one's */
+	slurm_mutex_lock(&_dmdx_lock);
+	it = list_iterator_create(_dmdx_requests);
 	while ((req = list_next(it))) {
 		if ((ts - req->ts) > pmixp_info_timeout()) {
-#ifndef NDEBUG
-			/* respond with the timeout to libpmix */
-			int nodeid = pmixp_nspace_resolve(req->nspace,
-							  req->rank);
-			char *nodename = pmixp_info_job_host(nodeid);
-			xassert(NULL != nodename);
-			PMIXP_ERROR("timeout: ns=%s, rank=%d, host=%s, ts=%lu",
-				    req->nspace, req->rank,
-				    (NULL != nodename) ? nodename : "unknown",
-				    ts);
-			if (NULL != nodename) {
-				xfree(nodename);
-			}
-#endif
-			/* PMIX_ERR_TIMEOUT */
-			pmixp_lib_modex_invoke(req->cbfunc, SLURM_ERROR, NULL, 0,
-					       req->cbdata, NULL, NULL);
-			/* release tracker & list iterator */
-			list_delete_item(it);
+			list_append(stale, list_remove(it));
 		}
 	}
 	list_iterator_destroy(it);
+	slurm_mutex_unlock(&_dmdx_lock);
+
+	while ((req = list_pop(stale))) {
+#ifndef NDEBUG
+		/* respond with the timeout to libpmix */
+		int nodeid = pmixp_nspace_resolve(req->nspace, req->rank);
+		char *nodename = pmixp_info_job_host(nodeid);
+		xassert(NULL != nodename);
+		PMIXP_ERROR("timeout: ns=%s, rank=%d, host=%s, ts=%lu",
+			    req->nspace, req->rank,
+			    (NULL != nodename) ? nodename : "unknown", ts);
+		if (NULL != nodename) {
+			xfree(nodename);
+		}
+#endif
+		/* PMIX_ERR_TIMEOUT */
+		pmixp_lib_modex_invoke(req->cbfunc, SLURM_ERROR, NULL, 0,
+				       req->cbdata, NULL, NULL);
+		xfree(req);
+	}
+	list_destroy(stale);
 }
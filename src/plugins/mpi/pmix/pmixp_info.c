@@ -59,6 +59,7 @@ static bool _srv_use_direct_conn_ucx = false;
 #endif
 static int _srv_fence_coll_type = PMIXP_COLL_TYPE_FENCE_MAX;
 static bool _srv_fence_coll_barrier = false;
+static uint32_t _srv_fence_ring_max = PMIXP_COLL_FENCE_RING_MAX_DEF;
 
 pmix_jobinfo_t _pmixp_job_info;
 
@@ -118,6 +119,11 @@ int pmixp_info_srv_fence_coll_type(void)
 	return _srv_fence_coll_type;
 }
 
+uint32_t pmixp_info_srv_fence_ring_max(void)
+{
+	return _srv_fence_ring_max;
+}
+
 bool pmixp_info_srv_fence_coll_barrier(void)
 {
 	return _srv_fence_coll_barrier;
@@ -503,6 +509,10 @@ static int _env_set(char ***env)
 			_srv_fence_coll_type = PMIXP_COLL_CPERF_RING;
 		}
 	}
+	p = getenvp(*env, PMIXP_COLL_FENCE_RING_MAX);
+	if (p) {
+		_srv_fence_ring_max = slurm_atoul(p);
+	}
 	p = getenvp(*env, SLURM_PMIXP_FENCE_BARRIER);
 	if (p) {
 		if (!xstrcmp("1",p) || !xstrcasecmp("true", p) ||
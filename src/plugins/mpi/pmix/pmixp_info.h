@@ -92,6 +92,7 @@ bool pmixp_info_srv_direct_conn(void);
 bool pmixp_info_srv_direct_conn_early(void);
 bool pmixp_info_srv_direct_conn_ucx(void);
 int pmixp_info_srv_fence_coll_type(void);
+uint32_t pmixp_info_srv_fence_ring_max(void);
 bool pmixp_info_srv_fence_coll_barrier(void);
 
 
@@ -121,11 +121,19 @@ void pmixp_server_run_cperf(void);
 #define pmixp_server_run_cperf();
 #endif
 
+/*
+ * Make room for size more bytes. Grow at least by the current buffer size
+ * so that appending many contributions does not realloc (and copy the data
+ * collected so far) on every append.
+ */
 static inline void pmixp_server_buf_reserve(buf_t *buf, uint32_t size)
 {
 	if (remaining_buf(buf) < size) {
 		uint32_t to_reserve = size - remaining_buf(buf);
-		grow_buf(buf, to_reserve);
+		uint32_t to_grow = MAX(to_reserve, size_buf(buf));
+		if ((uint64_t) size_buf(buf) + to_grow > MAX_BUF_SIZE)
+			to_grow = to_reserve;
+		grow_buf(buf, to_grow);
 	}
 }
 
@@ -93,7 +93,8 @@ extern int slurmd_script(job_env_t *job_env, slurm_cred_t *cred,
 	if ((is_epilog && spank_has_epilog()) ||
 	    (!is_epilog && spank_has_prolog()))
 		status = _run_spank_job_script(name, env, jobid);
-	if ((rc = run_script(name, path, jobid, timeout, env, job_env->uid)))
+	if ((rc = run_script(name, path, jobid, timeout, env, job_env->uid,
+			     (slurm_conf.prolog_flags & PROLOG_FLAG_PARALLEL))))
 		status = rc;
 
 	env_array_free(env);
@@ -44,27 +44,67 @@
 
 #include "fair_tree.h"
 
+/*
+ * Fair Tree results for one association. The tree is ranked from these
+ * copies under the assoc read lock, then the results are stored in the
+ * association usage records under a short write lock.
+ */
+typedef struct ft_assoc ft_assoc_t;
+struct ft_assoc {
+	slurmdb_assoc_rec_t *assoc;
+	ft_assoc_t **children;	/* NULL terminated, NULL if none */
+	uint32_t id;
+	bool is_user;
+	long double level_fs;
+	long double usage_efctv;
+	long double usage_norm;
+	double fs_factor;
+};
+
+typedef struct {
+	ft_assoc_t *recs;
+	uint32_t rec_cnt;
+	uint32_t rec_max;
+} ft_snapshot_t;
+
 static int  _ft_decay_apply_new_usage(job_record_t *job, time_t *start);
-static void _apply_priority_fs(void);
+static void _apply_priority_fs(ft_snapshot_t *snap);
+static void _store_priority_fs(ft_snapshot_t *snap);
 
 /* Fair Tree code called from the decay thread loop */
 extern void fair_tree_decay(List jobs, time_t start)
 {
 	slurmctld_lock_t job_write_lock =
 		{ NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
-	assoc_mgr_lock_t locks =
+	assoc_mgr_lock_t read_locks =
+		{ READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
+		  NO_LOCK, NO_LOCK, NO_LOCK };
+	assoc_mgr_lock_t write_locks =
 		{ WRITE_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
 		  NO_LOCK, NO_LOCK, NO_LOCK };
+	ft_snapshot_t snap = { 0 };
+	uint32_t i;
 
 	/* apply decayed usage */
 	lock_slurmctld(job_write_lock);
 	list_for_each(jobs, (ListForF) _ft_decay_apply_new_usage, &start);
 	unlock_slurmctld(job_write_lock);
 
-	/* calculate fs factor for associations */
-	assoc_mgr_lock(&locks);
-	_apply_priority_fs();
-	assoc_mgr_unlock(&locks);
+	/*
+	 * calculate fs factor for associations, readers such as job
+	 * submission are not blocked while the tree is ranked
+	 */
+	assoc_mgr_lock(&read_locks);
+	_apply_priority_fs(&snap);
+	assoc_mgr_unlock(&read_locks);
+
+	assoc_mgr_lock(&write_locks);
+	_store_priority_fs(&snap);
+	assoc_mgr_unlock(&write_locks);
+
+	for (i = 0; i < snap.rec_cnt; i++)
+		xfree(snap.recs[i].children);
+	xfree(snap.recs);
 
 	/* assign job priorities */
 	lock_slurmctld(job_write_lock);
@@ -74,17 +114,36 @@ extern void fair_tree_decay(List jobs, time_t start)
 
 
 /* In Fair Tree, usage_efctv is the normalized usage within the account */
-static void _ft_set_assoc_usage_efctv(slurmdb_assoc_rec_t *assoc)
+static void _ft_set_assoc_usage_efctv(ft_assoc_t *ft)
 {
-	slurmdb_assoc_rec_t *parent = assoc->usage->fs_assoc_ptr;
+	slurmdb_assoc_rec_t *parent = ft->assoc->usage->fs_assoc_ptr;
 
 	if (!parent || !parent->usage->usage_raw) {
-		assoc->usage->usage_efctv = 0L;
+		ft->usage_efctv = 0L;
 		return;
 	}
 
-	assoc->usage->usage_efctv =
-		assoc->usage->usage_raw / parent->usage->usage_raw;
+	ft->usage_efctv = ft->assoc->usage->usage_raw / parent->usage->usage_raw;
+}
+
+
+/* Fair Tree doesn't use usage_norm but we will set it anyway */
+static void _ft_set_assoc_usage_norm(ft_assoc_t *ft)
+{
+	/* If root usage is 0, there is no usage anywhere. */
+	if (!assoc_mgr_root_assoc->usage->usage_raw) {
+		ft->usage_norm = 0L;
+		return;
+	}
+
+	ft->usage_norm = ft->assoc->usage->usage_raw /
+		assoc_mgr_root_assoc->usage->usage_raw;
+
+	/* This is needed in case someone changes the half-life on the
+	 * fly and now we have used more time than is available under
+	 * the new config */
+	if (ft->usage_norm > 1L)
+		ft->usage_norm = 1L;
 }
 
 
@@ -100,12 +159,12 @@ static int _ft_decay_apply_new_usage(job_record_t *job, time_t *start)
 }
 
 
-static void _ft_debug(slurmdb_assoc_rec_t *assoc,
-		      uint16_t assoc_level, bool tied)
+static void _ft_debug(ft_assoc_t *ft, uint16_t assoc_level, bool tied)
 {
 	int spaces;
 	char *name;
 	int tie_char_count = tied ? 1 : 0;
+	slurmdb_assoc_rec_t *assoc = ft->assoc;
 
 	spaces = (assoc_level + 1) * 4;
 	name = assoc->user ? assoc->user : assoc->acct;
@@ -126,7 +185,7 @@ static void _ft_debug(slurmdb_assoc_rec_t *assoc,
 		     "=",
 		     name,
 		     assoc->acct,
-		     assoc->usage->level_fs);
+		     ft->level_fs);
 	}
 
 }
@@ -141,21 +200,21 @@ static int _cmp_level_fs(const void *x,
 	 *  2. Prioritize users over accounts (required for tie breakers when
 	 *     comparing users and accounts)
 	 */
-	slurmdb_assoc_rec_t **a = (slurmdb_assoc_rec_t **)x;
-	slurmdb_assoc_rec_t **b = (slurmdb_assoc_rec_t **)y;
+	ft_assoc_t **a = (ft_assoc_t **)x;
+	ft_assoc_t **b = (ft_assoc_t **)y;
 
 	/* 1. level_fs value */
-	if ((*a)->usage->level_fs != (*b)->usage->level_fs)
-		return (*a)->usage->level_fs < (*b)->usage->level_fs ? 1 : -1;
+	if ((*a)->level_fs != (*b)->level_fs)
+		return (*a)->level_fs < (*b)->level_fs ? 1 : -1;
 
 	/* 2. Prioritize users over accounts */
 
 	/* a and b are both users or both accounts */
-	if (!(*a)->user == !(*b)->user)
+	if ((*a)->is_user == (*b)->is_user)
 		return 0;
 
 	/* -1 if a is user, 1 if b is user */
-	return (*a)->user ? -1 : 1;
+	return (*a)->is_user ? -1 : 1;
 }
 
 
@@ -168,27 +227,25 @@ static int _cmp_level_fs(const void *x,
  * If LF > 1.0, the association is under-served.
  * If LF < 1.0, the association is over-served.
  */
-static void _calc_assoc_fs(slurmdb_assoc_rec_t *assoc)
+static void _calc_assoc_fs(ft_assoc_t *ft)
 {
 	long double U; /* long double U != long W */
 	long double S;
 
-	_ft_set_assoc_usage_efctv(assoc);
-
-	/* Fair Tree doesn't use usage_norm but we will set it anyway */
-	set_assoc_usage_norm(assoc);
+	_ft_set_assoc_usage_efctv(ft);
+	_ft_set_assoc_usage_norm(ft);
 
-	U = assoc->usage->usage_efctv;
-	S = assoc->usage->shares_norm;
+	U = ft->usage_efctv;
+	S = ft->assoc->usage->shares_norm;
 
 	/* Users marked as USE_PARENT are assigned the maximum level_fs so they
 	 * rank highest in their account, subject to ties.
 	 * Accounts marked as USE_PARENT do not use level_fs */
-	if (assoc->shares_raw == SLURMDB_FS_USE_PARENT) {
-		if (assoc->user)
-			assoc->usage->level_fs = INFINITY;
+	if (ft->assoc->shares_raw == SLURMDB_FS_USE_PARENT) {
+		if (ft->is_user)
+			ft->level_fs = INFINITY;
 		else
-			assoc->usage->level_fs = (long double) NO_VAL;
+			ft->level_fs = (long double) NO_VAL;
 		return;
 	}
 
@@ -200,20 +257,21 @@ static void _calc_assoc_fs(slurmdb_assoc_rec_t *assoc)
 	 *
 	 * NOT A BUG: U can be 0. The result is infinity, a valid value. */
 	if (S == 0L)
-		assoc->usage->level_fs = 0L;
+		ft->level_fs = 0L;
 	else
-		assoc->usage->level_fs = S / U;
+		ft->level_fs = S / U;
 }
 
-/* Append list of associations to array
+/* Append list of associations to array, using a snapshot record for each
  * IN list - list of associations
- * IN merged - array of associations to append to
- * IN/OUT merged_size - number of associations in merged array
+ * IN merged - array of snapshot records to append to
+ * IN/OUT merged_size - number of records in merged array
+ * IN snap - snapshot the records are taken from
  * RET - New array. Must be freed.
  */
-static slurmdb_assoc_rec_t** _append_list_to_array(
-	List list, slurmdb_assoc_rec_t** merged,
-	size_t *merged_size)
+static ft_assoc_t **_append_list_to_array(List list, ft_assoc_t **merged,
+					  size_t *merged_size,
+					  ft_snapshot_t *snap)
 {
 	ListIterator itr;
 	slurmdb_assoc_rec_t *next;
@@ -230,37 +288,62 @@ static slurmdb_assoc_rec_t** _append_list_to_array(
 	*merged_size += list_count(list);
 
 	/* must be null-terminated, so add one extra slot */
-	bytes = sizeof(slurmdb_assoc_rec_t*) * (*merged_size + 1);
+	bytes = sizeof(ft_assoc_t *) * (*merged_size + 1);
 	merged = xrealloc(merged, bytes);
 
 	itr = list_iterator_create(list);
-	while ((next = list_next(itr)))
-		merged[i++] = next;
+	while ((next = list_next(itr))) {
+		ft_assoc_t *ft;
+
+		if (snap->rec_cnt >= snap->rec_max) {
+			error("%s: association tree larger than association list",
+			      __func__);
+			break;
+		}
+		ft = &snap->recs[snap->rec_cnt++];
+		ft->assoc = next;
+		ft->id = next->id;
+		ft->is_user = (next->user != NULL);
+		merged[i++] = ft;
+	}
 	list_iterator_destroy(itr);
 
 	/* null terminate the array */
+	*merged_size = i;
 	merged[*merged_size] = NULL;
 	return merged;
 }
 
+/* Returns the (NULL terminated) children of an account, taking snapshot
+ * records for them on first use. NULL if the account has no children. */
+static ft_assoc_t **_get_children(ft_assoc_t *ft, ft_snapshot_t *snap)
+{
+	List children = ft->assoc->usage->children_list;
+	size_t child_count = 0;
+
+	if (!ft->children && children && !list_is_empty(children))
+		ft->children = _append_list_to_array(children, NULL,
+						     &child_count, snap);
+	return ft->children;
+}
+
 /* Returns number of tied sibling accounts.
  * IN assocs - array of siblings, sorted by level_fs
  * IN begin_ndx - begin looking for ties at this index
  * RET - number of sibling accounts with equal level_fs values
  */
-static size_t _count_tied_accounts(slurmdb_assoc_rec_t** assocs,
-				   size_t begin_ndx)
+static size_t _count_tied_accounts(ft_assoc_t **assocs, size_t begin_ndx)
 {
-	slurmdb_assoc_rec_t* next_assoc;
-	slurmdb_assoc_rec_t* assoc = assocs[begin_ndx];
+	ft_assoc_t *next_assoc;
+	ft_assoc_t *assoc = assocs[begin_ndx];
 	size_t i = begin_ndx;
 	size_t tied_accounts = 0;
 	while ((next_assoc = assocs[++i])) {
 		/* Users are sorted to the left of accounts, so no user we
 		 * encounter here will be equal to this account */
-		if (!next_assoc->user)
+		if (!next_assoc->is_user)
 			break;
-		if (assoc->usage->level_fs != next_assoc->usage->level_fs)
+		if (assoc->level_fs != next_assoc->level_fs)
 			break;
 		tied_accounts++;
 	}
@@ -273,32 +356,38 @@ static size_t _count_tied_accounts(slurmdb_assoc_rec_t** assocs,
  * IN begin - index of first account to merge
  * IN end - index of last account to merge
  * IN assoc_level - depth in the tree (root is 0)
+ * IN snap - snapshot the records are taken from
  * RET - Array of the children. Must be freed.
  */
-static slurmdb_assoc_rec_t** _merge_accounts(
-	slurmdb_assoc_rec_t** siblings,
-	size_t begin, size_t end, uint16_t assoc_level)
+static ft_assoc_t **_merge_accounts(ft_assoc_t **siblings,
+				    size_t begin, size_t end,
+				    uint16_t assoc_level, ft_snapshot_t *snap)
 {
-	size_t i;
+	size_t i, j;
 	/* number of associations in merged array */
 	size_t merged_size = 0;
 	/* merged is a null terminated array */
-	slurmdb_assoc_rec_t** merged = (slurmdb_assoc_rec_t **)
-		xmalloc(sizeof(slurmdb_assoc_rec_t *));
+	ft_assoc_t **merged = xmalloc(sizeof(ft_assoc_t *));
 	merged[0] = NULL;
 
 	for (i = begin; i <= end; i++) {
-		List children = siblings[i]->usage->children_list;
+		ft_assoc_t **children;
 
 		/* the first account's debug was already printed */
 		if ((slurm_conf.debug_flags & DEBUG_FLAG_PRIO) && i > begin)
 			_ft_debug(siblings[i], assoc_level, true);
 
-		if (!children || list_is_empty(children)) {
+		if (!(children = _get_children(siblings[i], snap)))
 			continue;
-		}
 
-		merged = _append_list_to_array(children, merged, &merged_size);
+		for (j = 0; children[j]; j++)
+			;
+		merged = xrealloc(merged, sizeof(ft_assoc_t *) *
+					  (merged_size + j + 1));
+		memcpy(&merged[merged_size], children,
+		       sizeof(ft_assoc_t *) * j);
+		merged_size += j;
+		merged[merged_size] = NULL;
 	}
 	return merged;
 }
@@ -323,12 +412,14 @@ static slurmdb_assoc_rec_t** _merge_accounts(
  * IN/OUT rank - current user ranking, starting at g_user_assoc_count
  * IN/OUT rnt - rank, no ties (what rank would be if no tie exists)
  * IN account_tied - is this account tied with the previous user
+ * IN snap - snapshot the results are written to
  */
-static void _calc_tree_fs(slurmdb_assoc_rec_t** siblings,
+static void _calc_tree_fs(ft_assoc_t **siblings,
 			  uint16_t assoc_level, uint32_t *rank,
-			  uint32_t *rnt, bool account_tied)
+			  uint32_t *rnt, bool account_tied,
+			  ft_snapshot_t *snap)
 {
-	slurmdb_assoc_rec_t *assoc = NULL;
+	ft_assoc_t *assoc = NULL;
 	long double prev_level_fs = (long double) NO_VAL;
 	bool tied = false;
 	size_t i;
@@ -344,7 +435,7 @@ static void _calc_tree_fs(slurmdb_assoc_rec_t** siblings,
 		_calc_assoc_fs(assoc);
 
 	/* Sort children by level_fs */
-	qsort(siblings, i, sizeof(slurmdb_assoc_rec_t *), _cmp_level_fs);
+	qsort(siblings, i, sizeof(ft_assoc_t *), _cmp_level_fs);
 
 	/* Iterate through children in sorted order. If it's a user, calculate
 	 * fs_factor, otherwise recurse. */
@@ -355,7 +446,7 @@ static void _calc_tree_fs(slurmdb_assoc_rec_t** siblings,
 			/* The parent was tied so this level starts out tied */
 			tied = true;
 		} else {
-			tied = prev_level_fs == assoc->usage->level_fs;
+			tied = prev_level_fs == assoc->level_fs;
 		}
 
 		if (slurm_conf.debug_flags & DEBUG_FLAG_PRIO)
@@ -365,58 +456,90 @@ static void _calc_tree_fs(slurmdb_assoc_rec_t** siblings,
 		 * handle ranking.
 		 * If account, merge any tied accounts then recurse with the
 		 * merged children array. */
-		if (assoc->user) {
+		if (assoc->is_user) {
 			if (!tied)
 				*rank = *rnt;
 
-			assoc->usage->fs_factor =
-				*rank / (double) g_user_assoc_count;
+			assoc->fs_factor = *rank / (double) g_user_assoc_count;
 
 			(*rnt)--;
 		} else {
-			slurmdb_assoc_rec_t** children;
+			ft_assoc_t **children;
 			size_t merge_count = _count_tied_accounts(siblings, i);
 
 			/* Merging does not affect child level_fs calculations
 			 * since the necessary information is stored on each
-			 * assoc's usage struct */
+			 * snapshot record */
 			children = _merge_accounts(siblings, i,
 						   i + merge_count,
-						   assoc_level);
+						   assoc_level, snap);
 
 			_calc_tree_fs(children, assoc_level+1,
-				      rank, rnt, tied);
+				      rank, rnt, tied, snap);
 
 			/* Skip over any merged accounts */
 			i += merge_count;
 
 			xfree(children);
 		}
-		prev_level_fs = assoc->usage->level_fs;
+		prev_level_fs = assoc->level_fs;
 	}
 
 }
 
 
-/* Start fairshare calculations at root. Call assoc_mgr_lock before this. */
-static void _apply_priority_fs(void)
+/*
+ * Start fairshare calculations at root, storing the results in snap.
+ * Call assoc_mgr_lock with at least a READ_LOCK on associations before this.
+ */
+static void _apply_priority_fs(ft_snapshot_t *snap)
 {
-	slurmdb_assoc_rec_t** children = NULL;
+	ft_assoc_t **children = NULL;
 	uint32_t rank = g_user_assoc_count;
 	uint32_t rnt = rank;
 	size_t child_count = 0;
 
 	log_flag(PRIO, "Fair Tree fairshare algorithm, starting at root:");
 
-	assoc_mgr_root_assoc->usage->level_fs = (long double) NO_VAL;
+	snap->rec_max = list_count(assoc_mgr_assoc_list);
+	snap->rec_cnt = 0;
+	snap->recs = xcalloc(snap->rec_max, sizeof(ft_assoc_t));
 
 	/* _calc_tree_fs requires an array instead of List */
 	children = _append_list_to_array(
 		assoc_mgr_root_assoc->usage->children_list,
 		children,
-		&child_count);
+		&child_count,
+		snap);
 
-	_calc_tree_fs(children, 0, &rank, &rnt, false);
+	_calc_tree_fs(children, 0, &rank, &rnt, false, snap);
 
 	xfree(children);
 }
+
+
+/*
+ * Store the results of _apply_priority_fs() in the association records.
+ * Associations removed since the snapshot was taken are skipped.
+ * Call assoc_mgr_lock with a WRITE_LOCK on associations before this.
+ */
+static void _store_priority_fs(ft_snapshot_t *snap)
+{
+	slurmdb_assoc_rec_t *assoc;
+	ft_assoc_t *ft;
+	uint32_t i;
+
+	if (assoc_mgr_root_assoc)
+		assoc_mgr_root_assoc->usage->level_fs = (long double) NO_VAL;
+
+	for (i = 0, ft = snap->recs; i < snap->rec_cnt; i++, ft++) {
+		if (!(assoc = assoc_mgr_find_assoc_rec_id(ft->id)) ||
+		    (assoc != ft->assoc))
+			continue;
+		assoc->usage->usage_efctv = ft->usage_efctv;
+		assoc->usage->usage_norm = ft->usage_norm;
+		assoc->usage->level_fs = ft->level_fs;
+		if (ft->is_user)
+			assoc->usage->fs_factor = ft->fs_factor;
+	}
+}
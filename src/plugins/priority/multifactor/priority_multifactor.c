@@ -64,6 +64,7 @@
 #include "src/common/slurm_mcs.h"
 #include "src/common/slurm_priority.h"
 #include "src/common/slurm_time.h"
+#include "src/common/xhash.h"
 #include "src/common/xstring.h"
 #include "src/common/gres.h"
 
@@ -147,9 +148,38 @@ static uint32_t flags;       /* Priority Flags */
 static time_t g_last_ran = 0; /* when the last poll ran */
 static double decay_factor = 1; /* The decay factor when decaying time. */
 
+/* Last fairshare factor calculated, see _get_fairshare_priority() */
+static __thread uint16_t fs_last_damp_factor = 0;
+static __thread long double fs_last_usage_efctv = 0.0;
+static __thread double fs_last_shares_norm = 0.0;
+static __thread double fs_last_factor = 0.0;
+
 /* variables defined in priority_multifactor.h */
 
+/*
+ * Results of the classic effective usage pass. The tree is walked under the
+ * assoc read lock, reading the new values of associations already visited
+ * from here, and only the results are stored under the write lock.
+ */
+typedef struct {
+	slurmdb_assoc_rec_t *assoc;
+	long double usage_norm;
+	long double usage_efctv;
+} usage_rec_t;
+
+typedef struct {
+	usage_rec_t *recs;
+	uint32_t rec_cnt;
+	uint32_t rec_max;
+	xhash_t *hash;
+} usage_snapshot_t;
+
+/* Set while the decay thread walks the tree, NULL otherwise */
+static __thread usage_snapshot_t *usage_snap = NULL;
+
 static void _priority_p_set_assoc_usage_debug(slurmdb_assoc_rec_t *assoc);
+static long double _calc_assoc_usage_efctv(slurmdb_assoc_rec_t *assoc);
+static long double _calc_assoc_usage_norm(slurmdb_assoc_rec_t *assoc);
 static void _set_assoc_usage_efctv(slurmdb_assoc_rec_t *assoc);
 
 /*
@@ -378,29 +408,111 @@ static int _write_last_decay_ran(time_t last_ran, time_t last_reset)
  * to calculate a bunch of things that will never be used. (Fair Tree calls a
  * different function.)
  *
- * NOTE: acct_mgr_assoc_lock must be locked before this is called.
+ * The results go into usage_snap, see _set_usage_efctv_all().
+ *
+ * NOTE: acct_mgr_assoc_lock must be read locked before this is called.
  */
 static int _set_children_usage_efctv(List children_list)
 {
 	slurmdb_assoc_rec_t *assoc = NULL;
 	ListIterator itr = NULL;
+	usage_rec_t *rec;
 
 	if (!children_list || !list_count(children_list))
 		return SLURM_SUCCESS;
 
 	itr = list_iterator_create(children_list);
 	while ((assoc = list_next(itr))) {
+		xassert(usage_snap->rec_cnt < usage_snap->rec_max);
+		rec = &usage_snap->recs[usage_snap->rec_cnt++];
+		rec->assoc = assoc;
 		if (assoc->user) {
-			assoc->usage->usage_efctv = (long double)NO_VAL;
+			rec->usage_norm = assoc->usage->usage_norm;
+			rec->usage_efctv = (long double)NO_VAL;
+			xhash_add(usage_snap->hash, rec);
 			continue;
 		}
-		priority_p_set_assoc_usage(assoc);
+		/* our own new usage_norm is used for usage_efctv */
+		rec->usage_norm = _calc_assoc_usage_norm(assoc);
+		xhash_add(usage_snap->hash, rec);
+		rec->usage_efctv = _calc_assoc_usage_efctv(assoc);
 		_set_children_usage_efctv(assoc->usage->children_list);
 	}
 	list_iterator_destroy(itr);
 	return SLURM_SUCCESS;
 }
 
+static void _usage_rec_id(void *item, const char **key, uint32_t *key_len)
+{
+	usage_rec_t *rec = (usage_rec_t *) item;
+
+	*key = (char *) &rec->assoc;
+	*key_len = sizeof(rec->assoc);
+}
+
+static usage_rec_t *_get_usage_rec(slurmdb_assoc_rec_t *assoc)
+{
+	if (!usage_snap)
+		return NULL;
+
+	return xhash_get(usage_snap->hash, (char *) &assoc, sizeof(assoc));
+}
+
+/* usage_norm of assoc, as updated by the pass in progress if any */
+static long double _get_usage_norm(slurmdb_assoc_rec_t *assoc)
+{
+	usage_rec_t *rec = _get_usage_rec(assoc);
+
+	return rec ? rec->usage_norm : assoc->usage->usage_norm;
+}
+
+/* usage_efctv of assoc, as updated by the pass in progress if any */
+static long double _get_usage_efctv(slurmdb_assoc_rec_t *assoc)
+{
+	usage_rec_t *rec = _get_usage_rec(assoc);
+
+	return rec ? rec->usage_efctv : assoc->usage->usage_efctv;
+}
+
+/*
+ * Calculate usage_norm and usage_efctv of every association below root.
+ * Other readers of the association tree are only held off while the
+ * results are stored.
+ */
+static void _set_usage_efctv_all(void)
+{
+	assoc_mgr_lock_t read_locks = { READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
+					NO_LOCK, NO_LOCK, NO_LOCK };
+	assoc_mgr_lock_t write_locks = { WRITE_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
+					 NO_LOCK, NO_LOCK, NO_LOCK };
+	usage_snapshot_t snap = { 0 };
+	usage_rec_t *rec;
+	uint32_t i;
+
+	assoc_mgr_lock(&read_locks);
+	snap.rec_max = list_count(assoc_mgr_assoc_list);
+	snap.recs = xcalloc(snap.rec_max, sizeof(usage_rec_t));
+	snap.hash = xhash_init(_usage_rec_id, NULL);
+	usage_snap = &snap;
+	_set_children_usage_efctv(assoc_mgr_root_assoc->usage->children_list);
+	usage_snap = NULL;
+	assoc_mgr_unlock(&read_locks);
+
+	assoc_mgr_lock(&write_locks);
+	for (i = 0; i < snap.rec_cnt; i++) {
+		rec = &snap.recs[i];
+		rec->assoc->usage->usage_norm = rec->usage_norm;
+		rec->assoc->usage->usage_efctv = rec->usage_efctv;
+		if (!rec->assoc->user &&
+		    (slurm_conf.debug_flags & DEBUG_FLAG_PRIO))
+			_priority_p_set_assoc_usage_debug(rec->assoc);
+	}
+	assoc_mgr_unlock(&write_locks);
+
+	xhash_free(snap.hash);
+	xfree(snap.recs);
+}
+
 
 /* job_ptr should already have the partition priority and such added here
  * before had we will be adding to it
@@ -443,9 +555,22 @@ static double _get_fairshare_priority(job_record_t *job_ptr)
 			 job_ptr->job_id, job_assoc->user, job_assoc->acct,
 			 priority_fs);
 	} else {
-		priority_fs = priority_p_calc_fs_factor(
-			fs_assoc->usage->usage_efctv,
-			(long double)fs_assoc->usage->shares_norm);
+		/*
+		 * Consecutive jobs in job_list commonly share an association
+		 * (job arrays, bulk submissions), so only redo the pow() when
+		 * the inputs changed since the previous job.
+		 */
+		if ((fs_last_damp_factor != damp_factor) ||
+		    (fs_last_usage_efctv != fs_assoc->usage->usage_efctv) ||
+		    (fs_last_shares_norm != fs_assoc->usage->shares_norm)) {
+			fs_last_damp_factor = damp_factor;
+			fs_last_usage_efctv = fs_assoc->usage->usage_efctv;
+			fs_last_shares_norm = fs_assoc->usage->shares_norm;
+			fs_last_factor = priority_p_calc_fs_factor(
+				fs_last_usage_efctv,
+				(long double) fs_last_shares_norm);
+		}
+		priority_fs = fs_last_factor;
 		log_flag(PRIO, "Fairshare priority of job %u for user %s in acct %s is 2**(-%Lf/%f) = %f",
 			 job_ptr->job_id, job_assoc->user, job_assoc->acct,
 			 fs_assoc->usage->usage_efctv,
@@ -456,22 +581,36 @@ static double _get_fairshare_priority(job_record_t *job_ptr)
 	return priority_fs;
 }
 
-static void _get_tres_factors(job_record_t *job_ptr, part_record_t *part_ptr,
-			      double *tres_factors)
+/* Fill values with the job's allocated TRES, or requested if not allocated */
+static void _get_job_tres_values(job_record_t *job_ptr, double *values)
 {
 	int i;
 
-	xassert(tres_factors);
-
 	/* can't memcpy because of different types
 	 * uint64_t vs. double */
 	for (i = 0; i < slurmctld_tres_cnt; i++) {
-		uint64_t value = 0;
 		if (job_ptr->tres_alloc_cnt &&
 		    (job_ptr->tres_alloc_cnt[i] != NO_CONSUME_VAL64))
-			value = job_ptr->tres_alloc_cnt[i];
+			values[i] = job_ptr->tres_alloc_cnt[i];
 		else if (job_ptr->tres_req_cnt)
-			value = job_ptr->tres_req_cnt[i];
+			values[i] = job_ptr->tres_req_cnt[i];
+		else
+			values[i] = 0;
+	}
+}
+
+static void _get_tres_factors(job_record_t *job_ptr, part_record_t *part_ptr,
+			      double *tres_factors)
+{
+	int i;
+	double values[slurmctld_tres_cnt];
+
+	xassert(tres_factors);
+
+	_get_job_tres_values(job_ptr, values);
+
+	for (i = 0; i < slurmctld_tres_cnt; i++) {
+		double value = values[i];
 
 		if (flags & PRIORITY_FLAGS_NO_NORMAL_TRES)
 			tres_factors[i] = value;
@@ -484,6 +623,34 @@ static void _get_tres_factors(job_record_t *job_ptr, part_record_t *part_ptr,
 	}
 }
 
+/*
+ * Weighted TRES priority of a job in a partition, the sum of what
+ * _get_tres_factors() and _get_tres_prio_weighted() would give, without
+ * building the per-TRES factor array. The job's TRES values are taken once
+ * by the caller for all the partitions the job was submitted to.
+ */
+static double _get_part_tres_prio_weighted(double *job_tres,
+					   part_record_t *part_ptr)
+{
+	int i;
+	double tmp_tres = 0.0;
+
+	if (flags & PRIORITY_FLAGS_NO_NORMAL_TRES) {
+		for (i = 0; i < slurmctld_tres_cnt; i++)
+			tmp_tres += job_tres[i] * weight_tres[i];
+	} else if (part_ptr && part_ptr->tres_cnt) {
+		for (i = 0; i < slurmctld_tres_cnt; i++) {
+			if (!part_ptr->tres_cnt[i])
+				continue;
+			tmp_tres += (job_tres[i] /
+				     (double) part_ptr->tres_cnt[i]) *
+				    weight_tres[i];
+		}
+	}
+
+	return tmp_tres;
+}
+
 static double _get_tres_prio_weighted(double *tres_factors)
 {
 	int i;
@@ -510,6 +677,7 @@ static uint32_t _get_priority_internal(time_t start_time,
 	priority_factors_object_t pre_factors;
 	uint64_t tmp_64;
 	double tmp_tres = 0.0;
+	double *job_tres = NULL;
 	char *multi_part_str = NULL;
 
 	if (job_ptr->direct_set_prio && (job_ptr->priority > 0)) {
@@ -599,20 +767,18 @@ static uint32_t _get_priority_internal(time_t start_time,
 		}
 
 		i = 0;
+		if (weight_tres) {
+			job_tres = xcalloc(slurmctld_tres_cnt, sizeof(double));
+			_get_job_tres_values(job_ptr, job_tres);
+		}
 		list_sort(job_ptr->part_ptr_list, priority_sort_part_tier);
 		part_iterator = list_iterator_create(job_ptr->part_ptr_list);
 		while ((part_ptr = list_next(part_iterator))) {
 			double part_tres = 0.0;
 
-			if (weight_tres) {
-				double part_tres_factors[slurmctld_tres_cnt];
-				memset(part_tres_factors, 0,
-				       sizeof(double) * slurmctld_tres_cnt);
-				_get_tres_factors(job_ptr, part_ptr,
-						  part_tres_factors);
-				part_tres = _get_tres_prio_weighted(
-							part_tres_factors);
-			}
+			if (job_tres)
+				part_tres = _get_part_tres_prio_weighted(
+							job_tres, part_ptr);
 
 			priority_part =
 				((flags & PRIORITY_FLAGS_NO_NORMAL_PART) ?
@@ -661,6 +827,7 @@ static uint32_t _get_priority_internal(time_t start_time,
 			 job_ptr, multi_part_str);
 		xfree(multi_part_str);
 		list_iterator_destroy(part_iterator);
+		xfree(job_tres);
 	}
 
 	if (slurm_conf.debug_flags & DEBUG_FLAG_PRIO) {
@@ -1194,8 +1361,6 @@ static void *_decay_thread(void *no_data)
 	/* Write lock on jobs, read lock on nodes and partitions */
 	slurmctld_lock_t job_write_lock =
 		{ NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
-	assoc_mgr_lock_t locks = { WRITE_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
-				   NO_LOCK, NO_LOCK, NO_LOCK };
 
 #if HAVE_SYS_PRCTL_H
 	if (prctl(PR_SET_NAME, "decay", NULL, NULL, NULL) < 0) {
@@ -1310,12 +1475,8 @@ static void *_decay_thread(void *no_data)
 
 		/* Calculate all the normalized usage unless this is Fair Tree;
 		 * it handles these calculations during its tree traversal */
-		if (!(flags & PRIORITY_FLAGS_FAIR_TREE)) {
-			assoc_mgr_lock(&locks);
-			_set_children_usage_efctv(
-				assoc_mgr_root_assoc->usage->children_list);
-			assoc_mgr_unlock(&locks);
-		}
+		if (!(flags & PRIORITY_FLAGS_FAIR_TREE))
+			_set_usage_efctv_all();
 
 		if (!g_last_ran)
 			goto get_usage;
@@ -1561,9 +1722,11 @@ static void _set_norm_shares(List children_list)
 }
 
 
-static void _depth_oblivious_set_usage_efctv(slurmdb_assoc_rec_t *assoc)
+static long double _depth_oblivious_usage_efctv(slurmdb_assoc_rec_t *assoc)
 {
-	long double ratio_p, ratio_l, k, f, ratio_s;
+	long double ratio_p, ratio_l, k, f, ratio_s, usage_efctv;
+	long double usage_norm = _get_usage_norm(assoc);
+	long double parent_efctv;
 	slurmdb_assoc_rec_t *parent_assoc = NULL;
 	ListIterator sib_itr = NULL;
 	slurmdb_assoc_rec_t *sibling = NULL;
@@ -1605,26 +1768,25 @@ static void _depth_oblivious_set_usage_efctv(slurmdb_assoc_rec_t *assoc)
 		    (higher f means more impact when parent consumption
 		    is inadequate) */
 	parent_assoc =  assoc->usage->fs_assoc_ptr;
+	parent_efctv = _get_usage_efctv(parent_assoc);
 
 	if (assoc->usage->shares_norm &&
 	    parent_assoc->usage->shares_norm &&
-	    parent_assoc->usage->usage_efctv &&
-	    assoc->usage->usage_norm) {
-		ratio_p = (parent_assoc->usage->usage_efctv /
-			   parent_assoc->usage->shares_norm);
+	    parent_efctv &&
+	    usage_norm) {
+		ratio_p = (parent_efctv / parent_assoc->usage->shares_norm);
 
 		ratio_s = 0;
 		sib_itr = list_iterator_create(
 			parent_assoc->usage->children_list);
 		while ((sibling = list_next(sib_itr))) {
 			if(sibling->shares_raw != SLURMDB_FS_USE_PARENT)
-				ratio_s += sibling->usage->usage_norm;
+				ratio_s += _get_usage_norm(sibling);
 		}
 		list_iterator_destroy(sib_itr);
 		ratio_s /= parent_assoc->usage->shares_norm;
 
-		ratio_l = (assoc->usage->usage_norm /
-			   assoc->usage->shares_norm) / ratio_s;
+		ratio_l = (usage_norm / assoc->usage->shares_norm) / ratio_s;
 #if defined(__FreeBSD__)
 		if (!ratio_p || !ratio_l
 		    || log(ratio_p) * log(ratio_l) >= 0) {
@@ -1633,7 +1795,7 @@ static void _depth_oblivious_set_usage_efctv(slurmdb_assoc_rec_t *assoc)
 			k = 1 / (1 + pow(f * log(ratio_p), 2));
 		}
 
-		assoc->usage->usage_efctv =
+		usage_efctv =
 			ratio_p * pow(ratio_l, k) *
 			assoc->usage->shares_norm;
 #else
@@ -1644,7 +1806,7 @@ static void _depth_oblivious_set_usage_efctv(slurmdb_assoc_rec_t *assoc)
 			k = 1 / (1 + powl(f * logl(ratio_p), 2));
 		}
 
-		assoc->usage->usage_efctv =
+		usage_efctv =
 			ratio_p * pow(ratio_l, k) *
 			assoc->usage->shares_norm;
 #endif
@@ -1652,33 +1814,33 @@ static void _depth_oblivious_set_usage_efctv(slurmdb_assoc_rec_t *assoc)
 		log_flag(PRIO, "Effective usage for %s %s off %s(%s) (%Lf * %Lf ^ %Lf) * %f  = %Lf",
 			 child, child_str, assoc->usage->parent_assoc_ptr->acct,
 			 assoc->usage->fs_assoc_ptr->acct, ratio_p, ratio_l, k,
-			 assoc->usage->shares_norm, assoc->usage->usage_efctv);
+			 assoc->usage->shares_norm, usage_efctv);
 	} else {
-		assoc->usage->usage_efctv = assoc->usage->usage_norm;
+		usage_efctv = usage_norm;
 		log_flag(PRIO, "Effective usage for %s %s off %s(%s) %Lf",
 			 child, child_str, assoc->usage->parent_assoc_ptr->acct,
 			 assoc->usage->fs_assoc_ptr->acct,
-			 assoc->usage->usage_efctv);
+			 usage_efctv);
 	}
+
+	return usage_efctv;
 }
 
-static void _set_usage_efctv(slurmdb_assoc_rec_t *assoc)
+static long double _classic_usage_efctv(slurmdb_assoc_rec_t *assoc)
 {
 	/* Variable names taken from HTML documentation */
-	long double ua_child = assoc->usage->usage_norm;
-	long double ue_parent =
-		assoc->usage->fs_assoc_ptr->usage->usage_efctv;
+	long double ua_child = _get_usage_norm(assoc);
+	long double ue_parent = _get_usage_efctv(assoc->usage->fs_assoc_ptr);
 	uint32_t s_child = assoc->shares_raw;
 	uint32_t s_all_siblings = assoc->usage->level_shares;
 
 	/* If no user in the account has shares, avoid division by zero by
 	 * setting usage_efctv to the parent's usage_efctv */
 	if (!s_all_siblings)
-		assoc->usage->usage_efctv = ue_parent;
-	else
-		assoc->usage->usage_efctv = ua_child +
-			(ue_parent - ua_child) *
-			(s_child / (long double) s_all_siblings);
+		return ue_parent;
+
+	return ua_child + (ue_parent - ua_child) *
+		(s_child / (long double) s_all_siblings);
 }
 
 
@@ -1838,23 +2000,29 @@ extern void priority_p_reconfig(bool assoc_clear)
 }
 
 
-extern void set_assoc_usage_norm(slurmdb_assoc_rec_t *assoc)
+static long double _calc_assoc_usage_norm(slurmdb_assoc_rec_t *assoc)
 {
+	long double usage_norm;
+
 	/* If root usage is 0, there is no usage anywhere. */
-	if (!assoc_mgr_root_assoc->usage->usage_raw) {
-		assoc->usage->usage_norm = 0L;
-		return;
-	}
+	if (!assoc_mgr_root_assoc->usage->usage_raw)
+		return 0L;
 
-	assoc->usage->usage_norm = assoc->usage->usage_raw
+	usage_norm = assoc->usage->usage_raw
 		/ assoc_mgr_root_assoc->usage->usage_raw;
 
-
 	/* This is needed in case someone changes the half-life on the
 	 * fly and now we have used more time than is available under
 	 * the new config */
-	if (assoc->usage->usage_norm > 1L)
-		assoc->usage->usage_norm = 1L;
+	if (usage_norm > 1L)
+		usage_norm = 1L;
+
+	return usage_norm;
+}
+
+extern void set_assoc_usage_norm(slurmdb_assoc_rec_t *assoc)
+{
+	assoc->usage->usage_norm = _calc_assoc_usage_norm(assoc);
 }
 
 
@@ -1889,6 +2057,59 @@ extern double priority_p_calc_fs_factor(long double usage_efctv,
 	return priority_fs;
 }
 
+/* Add the priority factors of one job to ret_list, if it may be shown */
+static void _get_job_factors(job_record_t *job_ptr, time_t start_time,
+			     uid_t uid, priority_factors_request_msg_t *req_msg,
+			     List part_filter_list, List ret_list)
+{
+	time_t use_time;
+
+	if (!(flags & PRIORITY_FLAGS_CALCULATE_RUNNING) &&
+	    !IS_JOB_PENDING(job_ptr))
+		return;
+
+	/* Job is not active on this cluster. */
+	if (IS_JOB_REVOKED(job_ptr))
+		return;
+
+	/*
+	 * This means the job is not eligible yet
+	 */
+	if (flags & PRIORITY_FLAGS_ACCRUE_ALWAYS)
+		use_time = job_ptr->details->submit_time;
+	else
+		use_time = job_ptr->details->begin_time;
+
+	if (!use_time || (use_time > start_time))
+		return;
+
+	/*
+	 * 0 means the job is held
+	 */
+	if (job_ptr->priority == 0)
+		return;
+
+	if ((slurm_conf.private_data & PRIVATE_DATA_JOBS) &&
+	    (job_ptr->user_id != uid) &&
+	    !validate_operator(uid) &&
+	    (((slurm_mcs_get_privatedata() == 0) &&
+	      !assoc_mgr_is_user_acct_coord(acct_db_conn, uid,
+					    job_ptr->account))||
+	     ((slurm_mcs_get_privatedata() == 1) &&
+	      (mcs_g_check_mcs_label(uid, job_ptr->mcs_label) != 0))))
+		return;
+
+	_filter_job(job_ptr, req_msg, part_filter_list, ret_list);
+}
+
+static int _find_job_id(void *x, void *key)
+{
+	uint32_t *job_id = x;
+	uint32_t *key_job_id = key;
+
+	return (*job_id == *key_job_id);
+}
+
 extern List priority_p_get_priority_factors_list(
 	priority_factors_request_msg_t *req_msg, uid_t uid)
 {
@@ -1898,6 +2119,7 @@ extern List priority_p_get_priority_factors_list(
 	part_record_t *part_ptr;
 	time_t start_time = time(NULL);
 	char *part_str, *tok, *last = NULL;
+	uint32_t *job_id;
 	/* Read lock on jobs, nodes, and partitions */
 	slurmctld_lock_t job_read_lock =
 		{ NO_LOCK, READ_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
@@ -1918,51 +2140,33 @@ extern List priority_p_get_priority_factors_list(
 	}
 
 	if (job_list && list_count(job_list)) {
-		time_t use_time;
-
 		ret_list = list_create(slurm_destroy_priority_factors_object);
-		itr = list_iterator_create(job_list);
-		while ((job_ptr = list_next(itr))) {
-			if (!(flags & PRIORITY_FLAGS_CALCULATE_RUNNING) &&
-			    !IS_JOB_PENDING(job_ptr))
-				continue;
-
-			/* Job is not active on this cluster. */
-			if (IS_JOB_REVOKED(job_ptr))
-				continue;
-
-			/*
-			 * This means the job is not eligible yet
-			 */
-			if (flags & PRIORITY_FLAGS_ACCRUE_ALWAYS)
-				use_time = job_ptr->details->submit_time;
-			else
-				use_time = job_ptr->details->begin_time;
-
-			if (!use_time || (use_time > start_time))
-				continue;
-
-			/*
-			 * 0 means the job is held
-			 */
-			if (job_ptr->priority == 0)
-				continue;
-
-			if ((slurm_conf.private_data & PRIVATE_DATA_JOBS) &&
-			    (job_ptr->user_id != uid) &&
-			    !validate_operator(uid) &&
-			    (((slurm_mcs_get_privatedata() == 0) &&
-			      !assoc_mgr_is_user_acct_coord(acct_db_conn, uid,
-			                                    job_ptr->account))||
-			     ((slurm_mcs_get_privatedata() == 1) &&
-			      (mcs_g_check_mcs_label(uid, job_ptr->mcs_label)
-			       != 0))))
-				continue;
-
-			_filter_job(job_ptr, req_msg, part_filter_list,
-				    ret_list);
+		if (req_msg->job_id_list) {
+			/* Look up the requested jobs rather than scan them all */
+			List seen_list = list_create(NULL);
+
+			itr = list_iterator_create(req_msg->job_id_list);
+			while ((job_id = list_next(itr))) {
+				if (list_find_first(seen_list, _find_job_id,
+						    job_id))
+					continue;
+				list_append(seen_list, job_id);
+				if (!(job_ptr = find_job_record(*job_id)))
+					continue;
+				_get_job_factors(job_ptr, start_time, uid,
+						 req_msg, part_filter_list,
+						 ret_list);
+			}
+			list_iterator_destroy(itr);
+			FREE_NULL_LIST(seen_list);
+		} else {
+			itr = list_iterator_create(job_list);
+			while ((job_ptr = list_next(itr)))
+				_get_job_factors(job_ptr, start_time, uid,
+						 req_msg, part_filter_list,
+						 ret_list);
+			list_iterator_destroy(itr);
 		}
-		list_iterator_destroy(itr);
 		if (!list_count(ret_list))
 			FREE_NULL_LIST(ret_list);
 	}
@@ -2043,10 +2247,23 @@ extern void set_priority_factors(time_t start_time, job_record_t *job_ptr)
 		job_ptr->prio_factors =
 			xmalloc(sizeof(priority_factors_object_t));
 	} else {
-		xfree(job_ptr->prio_factors->tres_weights);
-		xfree(job_ptr->prio_factors->priority_tres);
+		/* Reuse the TRES arrays from the last calculation */
+		double *priority_tres = job_ptr->prio_factors->priority_tres;
+		double *tres_weights = job_ptr->prio_factors->tres_weights;
+		uint32_t tres_cnt = job_ptr->prio_factors->tres_cnt;
+
 		memset(job_ptr->prio_factors, 0,
 		       sizeof(priority_factors_object_t));
+		if (weight_tres && priority_tres && tres_weights &&
+		    (tres_cnt == slurmctld_tres_cnt)) {
+			memset(priority_tres, 0, sizeof(double) * tres_cnt);
+			job_ptr->prio_factors->priority_tres = priority_tres;
+			job_ptr->prio_factors->tres_weights = tres_weights;
+			job_ptr->prio_factors->tres_cnt = tres_cnt;
+		} else {
+			xfree(tres_weights);
+			xfree(priority_tres);
+		}
 	}
 
 	if (weight_age && job_ptr->details->accrue_time) {
@@ -2173,10 +2390,10 @@ extern void set_priority_factors(time_t start_time, job_record_t *job_ptr)
 				xcalloc(slurmctld_tres_cnt, sizeof(double));
 			job_ptr->prio_factors->tres_weights =
 				xcalloc(slurmctld_tres_cnt, sizeof(double));
-			memcpy(job_ptr->prio_factors->tres_weights, weight_tres,
-			       sizeof(double) * slurmctld_tres_cnt);
 			job_ptr->prio_factors->tres_cnt = slurmctld_tres_cnt;
 		}
+		memcpy(job_ptr->prio_factors->tres_weights, weight_tres,
+		       sizeof(double) * slurmctld_tres_cnt);
 
 		_get_tres_factors(job_ptr, job_ptr->part_ptr,
 				  job_ptr->prio_factors->priority_tres);
@@ -2187,20 +2404,21 @@ extern void set_priority_factors(time_t start_time, job_record_t *job_ptr)
 /* Set usage_efctv based on algorithm-specific code. Fair Tree sets this
  * elsewhere.
  */
-static void _set_assoc_usage_efctv(slurmdb_assoc_rec_t *assoc)
+static long double _calc_assoc_usage_efctv(slurmdb_assoc_rec_t *assoc)
 {
 	if (assoc->usage->fs_assoc_ptr == assoc_mgr_root_assoc)
-		assoc->usage->usage_efctv = assoc->usage->usage_norm;
-	else if (assoc->shares_raw == SLURMDB_FS_USE_PARENT) {
-		slurmdb_assoc_rec_t *parent_assoc =
-			assoc->usage->fs_assoc_ptr;
-
-		assoc->usage->usage_efctv =
-			parent_assoc->usage->usage_efctv;
-	} else if (flags & PRIORITY_FLAGS_DEPTH_OBLIVIOUS)
-		_depth_oblivious_set_usage_efctv(assoc);
+		return _get_usage_norm(assoc);
+	else if (assoc->shares_raw == SLURMDB_FS_USE_PARENT)
+		return _get_usage_efctv(assoc->usage->fs_assoc_ptr);
+	else if (flags & PRIORITY_FLAGS_DEPTH_OBLIVIOUS)
+		return _depth_oblivious_usage_efctv(assoc);
 	else
-		_set_usage_efctv(assoc);
+		return _classic_usage_efctv(assoc);
+}
+
+static void _set_assoc_usage_efctv(slurmdb_assoc_rec_t *assoc)
+{
+	assoc->usage->usage_efctv = _calc_assoc_usage_efctv(assoc);
 }
 
 
@@ -2242,7 +2460,7 @@ static void _priority_p_set_assoc_usage_debug(slurmdb_assoc_rec_t *assoc)
 		     parent_assoc->usage->usage_efctv);
 	} else if (flags & PRIORITY_FLAGS_DEPTH_OBLIVIOUS) {
 		/* Unfortunately, this must be handled inside of
-		 * _depth_oblivious_set_usage_efctv */
+		 * _depth_oblivious_usage_efctv */
 	} else {
 		info("Effective usage for %s %s off %s(%s) "
 		     "%Lf + ((%Lf - %Lf) * %d / %d) = %Lf",
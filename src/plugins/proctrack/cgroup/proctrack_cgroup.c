@@ -367,27 +367,35 @@ extern int proctrack_p_signal (uint64_t id, int signal)
 	int npids;
 	int i;
 	int slurm_task;
+	bool log_tasks = (get_log_level() >= LOG_LEVEL_DEBUG2);
+
+	/* directly manage SIGSTOP using cgroup freezer subsystem */
+	if (signal == SIGSTOP) {
+		if (*jobstep_cgroup_path == '\0')
+			return SLURM_SUCCESS;
+		return _slurm_cgroup_suspend(id);
+	}
+
+	/*
+	 * Freeze the step before reading its pids in case of SIGKILL, so that
+	 * nothing forked in the meantime escapes this pass and has to wait for
+	 * the next proctrack_p_wait() retry. The kills are delivered when the
+	 * step is thawed below, which also resumes a suspended step.
+	 */
+	if (signal == SIGKILL)
+		_slurm_cgroup_suspend(id);
 
 	/* get all the pids associated with the step */
 	if (_slurm_cgroup_get_pids(id, &pids, &npids) !=
 	    SLURM_SUCCESS) {
 		debug3("unable to get pids list for cont_id=%"PRIu64"", id);
+		if (signal == SIGKILL)
+			_slurm_cgroup_resume(id);
 		/* that could mean that all the processes already exit */
 		/* the container so return success */
 		return SLURM_SUCCESS;
 	}
 
-	/* directly manage SIGSTOP using cgroup freezer subsystem */
-	if (signal == SIGSTOP) {
-		xfree(pids);
-		return _slurm_cgroup_suspend(id);
-	}
-
-	/* start by resuming in case of SIGKILL */
-	if (signal == SIGKILL) {
-		_slurm_cgroup_resume(id);
-	}
-
 	for (i = 0 ; i<npids ; i++) {
 		/* do not kill slurmstepd (it should not be part
 		 * of the list, but just to not forget about that ;))
@@ -395,6 +403,15 @@ extern int proctrack_p_signal (uint64_t id, int signal)
 		if (pids[i] == (pid_t)id)
 			continue;
 
+		/*
+		 * SIGKILL goes to every pid, so only look up the parent to
+		 * tell slurm tasks apart when it will be logged.
+		 */
+		if ((signal == SIGKILL) && !log_tasks) {
+			kill(pids[i], signal);
+			continue;
+		}
+
 		/* only signal slurm tasks unless signal is SIGKILL */
 		slurm_task = _slurm_cgroup_is_pid_a_slurm_task(id, pids[i]);
 		if (slurm_task == 1 || signal == SIGKILL) {
@@ -407,6 +424,9 @@ extern int proctrack_p_signal (uint64_t id, int signal)
 
 	xfree(pids);
 
+	if (signal == SIGKILL)
+		_slurm_cgroup_resume(id);
+
 	/* resume tasks after signaling slurm tasks with SIGCONT to be sure */
 	/* that SIGTSTP received at suspend time is removed */
 	if (signal == SIGCONT) {
@@ -91,55 +91,114 @@ const char plugin_name[]        = "route topology plugin";
 const char plugin_type[]        = "route/topology";
 const uint32_t plugin_version   = SLURM_VERSION_NUMBER;
 
+/*
+ * Recent splits, since the same node lists (e.g. all nodes for a ping or
+ * reconfigure) are split again and again.
+ */
+#define SPLIT_CACHE_SIZE 8
+typedef struct {
+	int count;
+	char *hl_str;		/* ranged string of the hostlist split */
+	hostlist_t *sp_hl;
+	uint16_t tree_width;
+} split_cache_t;
+
 /* Global data */
 static pthread_mutex_t route_lock = PTHREAD_MUTEX_INITIALIZER;
 static bool run_in_slurmctld = false;
+static split_cache_t split_cache[SPLIT_CACHE_SIZE];
+static int split_cache_next = 0;
 
-/*****************************************************************************\
- *  Functions required of all plugins
-\*****************************************************************************/
-/*
- * init() is called when the plugin is loaded, before any other functions
- *	are called.  Put global initialization here.
- */
-extern int init(void)
+static void _split_cache_clear(void)
 {
-	if (xstrcmp(slurm_conf.topology_plugin, "topology/tree"))
-		fatal("ROUTE: route/topology requires topology/tree");
+	int i, j;
 
-	run_in_slurmctld = running_in_slurmctld();
-	verbose("%s loaded", plugin_name);
-	return SLURM_SUCCESS;
+	slurm_mutex_lock(&route_lock);
+	for (i = 0; i < SPLIT_CACHE_SIZE; i++) {
+		for (j = 0; j < split_cache[i].count; j++)
+			hostlist_destroy(split_cache[i].sp_hl[j]);
+		xfree(split_cache[i].sp_hl);
+		xfree(split_cache[i].hl_str);
+		split_cache[i].count = 0;
+	}
+	slurm_mutex_unlock(&route_lock);
 }
-/*
- * fini() is called when the plugin is removed. Clear any allocated
- *	storage here.
- */
-extern int fini(void)
+
+/* Copy a cached split of hl_str into sp_hl, route_lock must be locked */
+static bool _split_cache_get(char *hl_str, uint16_t tree_width,
+			     hostlist_t **sp_hl, int *count)
 {
-	return SLURM_SUCCESS;
+	int i, j;
+
+	for (i = 0; i < SPLIT_CACHE_SIZE; i++) {
+		if ((split_cache[i].tree_width != tree_width) ||
+		    xstrcmp(split_cache[i].hl_str, hl_str))
+			continue;
+		*count = split_cache[i].count;
+		*sp_hl = xcalloc(*count, sizeof(hostlist_t));
+		for (j = 0; j < *count; j++)
+			(*sp_hl)[j] = hostlist_copy(split_cache[i].sp_hl[j]);
+		return true;
+	}
+	return false;
+}
+
+/* Save a copy of a split of hl_str, route_lock must be locked */
+static void _split_cache_add(char *hl_str, uint16_t tree_width,
+			     hostlist_t *sp_hl, int count)
+{
+	split_cache_t *cache = &split_cache[split_cache_next];
+	int j;
+
+	split_cache_next = (split_cache_next + 1) % SPLIT_CACHE_SIZE;
+	for (j = 0; j < cache->count; j++)
+		hostlist_destroy(cache->sp_hl[j]);
+	xfree(cache->sp_hl);
+	xfree(cache->hl_str);
+
+	cache->hl_str = xstrdup(hl_str);
+	cache->tree_width = tree_width;
+	cache->count = count;
+	cache->sp_hl = xcalloc(count, sizeof(hostlist_t));
+	for (j = 0; j < count; j++)
+		cache->sp_hl[j] = hostlist_copy(sp_hl[j]);
 }
 
-/*****************************************************************************\
- *  API Implementations
-\*****************************************************************************/
 /*
- * route_p_split_hostlist - logic to split an input hostlist into
- *                           a set of hostlists to forward to.
- *
- * IN: hl        - hostlist_t   - list of every node to send message to
- *                                will be empty on return;
- * OUT: sp_hl    - hostlist_t** - the array of hostlists that will be malloced
- * OUT: count    - int*         - the count of created hostlists
- * RET: SLURM_SUCCESS - int
- *
- * Note: created hostlist will have to be freed independently using
- *       hostlist_destroy by the caller.
- * Note: the hostlist_t array will have to be xfree.
+ * Find the lowest level switch containing every node in nodes_bitmap by
+ * walking up from the leaf switches of its first node.
+ * RET switch index or -1 if none found
  */
-extern int route_p_split_hostlist(hostlist_t hl,
-				  hostlist_t** sp_hl,
-				  int* count, uint16_t tree_width)
+static int _find_lowest_switch(bitstr_t *nodes_bitmap)
+{
+	int i, j, best = -1, first = bit_ffs(nodes_bitmap);
+
+	if (first < 0)
+		return -1;
+
+	for (i = 0; i < switch_record_cnt; i++) {
+		if ((switch_record_table[i].level != 0) ||
+		    !bit_test(switch_record_table[i].node_bitmap, first))
+			continue;
+		for (j = i; j != SWITCH_NO_PARENT;
+		     j = switch_record_table[j].parent) {
+			if (!bit_super_set(nodes_bitmap,
+					   switch_record_table[j].node_bitmap))
+				continue;
+			if ((best == -1) ||
+			    (switch_record_table[j].level <
+			     switch_record_table[best].level))
+				best = j;
+			break;
+		}
+	}
+
+	return best;
+}
+
+/* Split hl by the child switches of the lowest switch containing all of it */
+static int _split_hostlist(hostlist_t hl, hostlist_t **sp_hl, int *count,
+			   uint16_t tree_width)
 {
 	int i, j, k, hl_ndx, msg_count, sw_count, lst_count;
 	char  *buf;
@@ -148,25 +207,6 @@ extern int route_p_split_hostlist(hostlist_t hl,
 	slurmctld_lock_t node_read_lock = { .node = READ_LOCK };
 
 	msg_count = hostlist_count(hl);
-	slurm_mutex_lock(&route_lock);
-	if (switch_record_cnt == 0) {
-		if (run_in_slurmctld)
-			fatal_abort("%s: Somehow we have 0 for switch_record_cnt and we are here in the slurmctld.  This should never happen.", __func__);
-		/* configs have not already been processed */
-		slurm_conf_init(NULL);
-		if (init_node_conf()) {
-			fatal("ROUTE: Failed to init slurm config");
-		}
-		if (build_all_nodeline_info(false, 0)) {
-			fatal("ROUTE: Failed to build node config");
-		}
-		rehash_node();
-
-		if (slurm_topo_build_config() != SLURM_SUCCESS) {
-			fatal("ROUTE: Failed to build topology config");
-		}
-	}
-	slurm_mutex_unlock(&route_lock);
 	*sp_hl = (hostlist_t*) xmalloc(switch_record_cnt * sizeof(hostlist_t));
 	/* Only acquire the slurmctld lock if running as the slurmctld. */
 	if (run_in_slurmctld)
@@ -180,25 +220,7 @@ extern int route_p_split_hostlist(hostlist_t hl,
 		unlock_slurmctld(node_read_lock);
 
 	/* Find lowest level switch containing all the nodes in the list */
-	j = 0;
-	for (i = 0; i <= switch_levels; i++) {
-		for (j=0; j<switch_record_cnt; j++) {
-			if (switch_record_table[j].level == i) {
-				if (bit_super_set(nodes_bitmap,
-						  switch_record_table[j].
-						  node_bitmap)) {
-					/* All nodes in message list are in
-					 * this switch */
-					break;
-				}
-			}
-		}
-		if (j < switch_record_cnt) {
-			/* Got here via break after bit_super_set */
-			break; // 'j' is our switch
-		} /* else, no switches at this level reach all nodes */
-	}
-	if (i > switch_levels) {
+	if ((j = _find_lowest_switch(nodes_bitmap)) < 0) {
 		/* This can only happen if trying to schedule multiple physical
 		 * clusters as a single logical cluster under the control of a
 		 * single slurmctld daemon, and sending something like a
@@ -241,7 +263,7 @@ extern int route_p_split_hostlist(hostlist_t hl,
 		if (slurm_conf.debug_flags & DEBUG_FLAG_ROUTE) {
 			buf = hostlist_ranged_string_xmalloc((*sp_hl)[hl_ndx]);
 			debug("ROUTE: ... sublist[%d] switch=%s :: %s",
-			      i, switch_record_table[i].name, buf);
+			      i, switch_record_table[k].name, buf);
 			xfree(buf);
 		}
 		hl_ndx++;
@@ -256,6 +278,95 @@ extern int route_p_split_hostlist(hostlist_t hl,
 
 }
 
+/*****************************************************************************\
+ *  Functions required of all plugins
+\*****************************************************************************/
+/*
+ * init() is called when the plugin is loaded, before any other functions
+ *	are called.  Put global initialization here.
+ */
+extern int init(void)
+{
+	if (xstrcmp(slurm_conf.topology_plugin, "topology/tree"))
+		fatal("ROUTE: route/topology requires topology/tree");
+
+	run_in_slurmctld = running_in_slurmctld();
+	verbose("%s loaded", plugin_name);
+	return SLURM_SUCCESS;
+}
+/*
+ * fini() is called when the plugin is removed. Clear any allocated
+ *	storage here.
+ */
+extern int fini(void)
+{
+	_split_cache_clear();
+	return SLURM_SUCCESS;
+}
+
+/*****************************************************************************\
+ *  API Implementations
+\*****************************************************************************/
+/*
+ * route_p_split_hostlist - logic to split an input hostlist into
+ *                           a set of hostlists to forward to.
+ *
+ * IN: hl        - hostlist_t   - list of every node to send message to
+ *                                will be empty on return;
+ * OUT: sp_hl    - hostlist_t** - the array of hostlists that will be malloced
+ * OUT: count    - int*         - the count of created hostlists
+ * RET: SLURM_SUCCESS - int
+ *
+ * Note: created hostlist will have to be freed independently using
+ *       hostlist_destroy by the caller.
+ * Note: the hostlist_t array will have to be xfree.
+ */
+extern int route_p_split_hostlist(hostlist_t hl,
+				  hostlist_t** sp_hl,
+				  int* count, uint16_t tree_width)
+{
+	char *hl_str;
+	int rc;
+
+	slurm_mutex_lock(&route_lock);
+	if (switch_record_cnt == 0) {
+		if (run_in_slurmctld)
+			fatal_abort("%s: Somehow we have 0 for switch_record_cnt and we are here in the slurmctld.  This should never happen.", __func__);
+		/* configs have not already been processed */
+		slurm_conf_init(NULL);
+		if (init_node_conf()) {
+			fatal("ROUTE: Failed to init slurm config");
+		}
+		if (build_all_nodeline_info(false, 0)) {
+			fatal("ROUTE: Failed to build node config");
+		}
+		rehash_node();
+
+		if (slurm_topo_build_config() != SLURM_SUCCESS) {
+			fatal("ROUTE: Failed to build topology config");
+		}
+	}
+
+	hl_str = hostlist_ranged_string_xmalloc(hl);
+	if (_split_cache_get(hl_str, tree_width, sp_hl, count)) {
+		slurm_mutex_unlock(&route_lock);
+		xfree(hl_str);
+		return SLURM_SUCCESS;
+	}
+	slurm_mutex_unlock(&route_lock);
+
+	rc = _split_hostlist(hl, sp_hl, count, tree_width);
+
+	if (rc == SLURM_SUCCESS) {
+		slurm_mutex_lock(&route_lock);
+		_split_cache_add(hl_str, tree_width, *sp_hl, *count);
+		slurm_mutex_unlock(&route_lock);
+	}
+	xfree(hl_str);
+
+	return rc;
+}
+
 /*
  * route_g_reconfigure - reset during reconfigure
  *
@@ -263,5 +374,7 @@ extern int route_p_split_hostlist(hostlist_t hl,
  */
 extern int route_p_reconfigure (void)
 {
+	/* Node and switch indexes may have changed */
+	_split_cache_clear();
 	return SLURM_SUCCESS;
 }
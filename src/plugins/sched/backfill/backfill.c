@@ -79,6 +79,7 @@
 #include "src/common/slurm_accounting_storage.h"
 #include "src/common/slurm_mcs.h"
 #include "src/common/slurm_protocol_api.h"
+#include "src/common/trace.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
@@ -95,6 +96,7 @@
 #include "src/slurmctld/reservation.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/srun_comm.h"
+#include "src/slurmctld/time_event.h"
 #include "backfill.h"
 
 #define BACKFILL_INTERVAL	30
@@ -132,10 +134,64 @@ typedef struct node_space_map {
 	int next;	/* next record, by time, zero termination */
 } node_space_map_t;
 
-typedef struct node_space_handler {
+/*
+ * Running job reservation cache (bf_running_job_reserve)
+ * Running whole node jobs are grouped by their (rounded) end time and the
+ * groups are preserved between backfill cycles. Each cycle only patches the
+ * groups for jobs which started, ended or changed since the previous cycle,
+ * then adds one reservation per group rather than one per running job.
+ */
+typedef struct bf_running_bucket {
+	time_t end_time;
+	List job_list;		/* bf_running_job_t records, not owned */
+	bitstr_t *node_bitmap;	/* union of node_bitmap of jobs in job_list */
+	bool rebuild;		/* node_bitmap must be recomputed */
+} bf_running_bucket_t;
+
+typedef struct bf_running_job {
+	bf_running_bucket_t *bucket;
+	uint32_t generation;	/* last cycle in which job was seen */
+	uint32_t job_id;
+	bitstr_t *node_bitmap;
+	uint32_t node_cnt;
+	time_t start_time;
+} bf_running_job_t;
+
+/*
+ * Partitions which share no nodes (and no pending jobs) are placed in
+ * different groups when bf_disjoint_parts is configured, each group with its
+ * own node space table. Jobs are then only tested against the reservations
+ * made for jobs of their own group.
+ */
+typedef struct bf_part_group {
+	bitstr_t *node_bitmap;	/* nodes in the group's partitions */
 	node_space_map_t *node_space;
-	int *node_space_recs;
-} node_space_handler_t;
+	int node_space_recs;
+} bf_part_group_t;
+
+typedef struct bf_part_groups {
+	int group_cnt;
+	bf_part_group_t *groups;
+	int part_cnt;
+	int *part_group;	/* index into groups for each of parts */
+	part_record_t **parts;
+} bf_part_groups_t;
+
+/* usec spent in each phase of the current backfill cycle */
+typedef struct bf_phase_time {
+	uint64_t queue;		/* build and prepare the job queue */
+	uint64_t running;	/* reserve resources of running jobs */
+	uint64_t resv;		/* test advanced reservations */
+	uint64_t sched;		/* _try_sched(), mostly select_g_job_test() */
+	uint64_t yield;		/* locks released, including sleep */
+} bf_phase_time_t;
+
+/* Jobs tested and usec spent testing them by partition, for logging */
+typedef struct bf_part_stat {
+	char *name;
+	uint32_t tested;
+	uint64_t usec;
+} bf_part_stat_t;
 
 /*
  * HetJob scheduling structures
@@ -163,12 +219,16 @@ typedef struct deadlock_job_struct {
 
 typedef struct deadlock_part_struct {
 	List deadlock_job_list;
+	xhash_t *deadlock_job_map;	/* deadlock_job_list by het_job_id */
 	part_record_t *part_ptr;
 } deadlock_part_struct_t;
 
 /* Diagnostic  statistics */
 extern diag_stats_t slurmctld_diag_stats;
 uint32_t bf_sleep_usec = 0;
+static bf_phase_time_t bf_phase;
+static bf_part_stat_t *bf_part_stats = NULL;
+static int bf_part_stat_cnt = 0;
 
 typedef struct backfill_user_usage {
 	slurmdb_bf_usage_t bf_usage;
@@ -190,6 +250,7 @@ static int bf_job_part_count_reserve = 0;
 static int bf_max_job_array_resv = BF_MAX_JOB_ARRAY_RESV;
 static int bf_min_age_reserve = 0;
 static bool bf_running_job_reserve = false;
+static bool bf_disjoint_parts = false;
 static uint32_t bf_min_prio_reserve = 0;
 static List deadlock_global_list;
 static bool bf_hetjob_immediate = false;
@@ -208,7 +269,13 @@ static int max_rpc_cnt = 0;
 static int yield_interval = YIELD_INTERVAL;
 static int yield_sleep   = YIELD_SLEEP;
 static List het_job_list = NULL;
+static xhash_t *het_job_map = NULL;	/* het_job_list by het_job_id */
 static xhash_t *user_usage_map = NULL; /* look up user usage when no assoc */
+static xhash_t *running_job_map = NULL;	/* bf_running_job_t by job_id */
+static List running_bucket_list = NULL;	/* bf_running_bucket_t by end_time */
+static uint32_t running_generation = 0;
+static int running_node_cnt = 0;	/* node_record_count of cached bitmaps */
+static bool running_bucket_sort = false;
 
 /*********************** local functions *********************/
 static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
@@ -235,8 +302,9 @@ static bool _more_work(time_t last_backfill_time);
 static uint32_t _my_sleep(int64_t usec);
 static int  _num_feature_count(job_record_t *job_ptr, bool *has_xand,
 			       bool *has_xor);
-static int  _het_job_find_map(void *x, void *key);
 static void _het_job_map_del(void *x);
+static void _het_job_map_key_id(void *item, const char **key,
+				uint32_t *key_len);
 static void _het_job_start_clear(void);
 static time_t _het_job_start_find(job_record_t *job_ptr);
 static void _het_job_start_set(job_record_t *job_ptr, time_t latest_start,
@@ -259,6 +327,7 @@ static int  _try_sched(job_record_t *job_ptr, bitstr_t **avail_bitmap,
 static int  _yield_locks(int64_t usec);
 static void _bf_map_key_id(void *item, const char **key, uint32_t *key_len);
 static void _bf_map_free(void *item);
+static void _bf_running_cache_fini(void);
 
 /* Log resources to be allocated to a pending job */
 static void _dump_job_sched(job_record_t *job_ptr, time_t end_time,
@@ -932,10 +1001,17 @@ static void _load_config(void)
 	else
 		bf_one_resv_per_job = false;
 
+	if (xstrcasestr(sched_params, "bf_disjoint_parts"))
+		bf_disjoint_parts = true;
+	else
+		bf_disjoint_parts = false;
+
 	if (xstrcasestr(sched_params, "bf_running_job_reserve"))
 		bf_running_job_reserve = true;
 	else
 		bf_running_job_reserve = false;
+	/* Node table may have changed, cached node bitmaps would be invalid */
+	_bf_running_cache_fini();
 
 	if ((tmp_ptr = xstrcasestr(sched_params, "max_rpc_cnt=")))
 		max_rpc_cnt = atoi(tmp_ptr + 12);
@@ -987,6 +1063,17 @@ static void _do_diag_stats(struct timeval *tv1, struct timeval *tv2,
 	}
 	slurmctld_diag_stats.bf_table_size = node_space_recs;
 	slurmctld_diag_stats.bf_table_size_sum += node_space_recs;
+
+	slurmctld_diag_stats.bf_phase_queue_last = bf_phase.queue;
+	slurmctld_diag_stats.bf_phase_queue_sum += bf_phase.queue;
+	slurmctld_diag_stats.bf_phase_running_last = bf_phase.running;
+	slurmctld_diag_stats.bf_phase_running_sum += bf_phase.running;
+	slurmctld_diag_stats.bf_phase_resv_last = bf_phase.resv;
+	slurmctld_diag_stats.bf_phase_resv_sum += bf_phase.resv;
+	slurmctld_diag_stats.bf_phase_sched_last = bf_phase.sched;
+	slurmctld_diag_stats.bf_phase_sched_sum += bf_phase.sched;
+	slurmctld_diag_stats.bf_phase_yield_last = bf_phase.yield;
+	slurmctld_diag_stats.bf_phase_yield_sum += bf_phase.yield;
 }
 
 /* backfill_agent - detached thread periodically attempts to backfill jobs */
@@ -1010,6 +1097,7 @@ extern void *backfill_agent(void *args)
 	_load_config();
 	last_backfill_time = time(NULL);
 	het_job_list = list_create(_het_job_map_del);
+	het_job_map = xhash_init(_het_job_map_key_id, NULL);
 	while (!stop_backfill) {
 		if (short_sleep)
 			_my_sleep(USEC_IN_SEC);
@@ -1021,6 +1109,7 @@ extern void *backfill_agent(void *args)
 		if (slurmctld_config.scheduling_disabled)
 			continue;
 
+		xhash_clear(het_job_map);
 		list_flush(het_job_list);
 		slurm_mutex_lock(&config_lock);
 		if (config_flag) {
@@ -1059,8 +1148,10 @@ extern void *backfill_agent(void *args)
 
 		short_sleep = false;
 	}
+	xhash_free(het_job_map);
 	FREE_NULL_LIST(het_job_list);
 	xhash_free(user_usage_map); /* May have been init'ed if used */
+	_bf_running_cache_fini();
 
 	return NULL;
 }
@@ -1091,7 +1182,9 @@ static int _yield_locks(int64_t usec)
 	time_t job_update, node_update, part_update;
 	bool load_config = false;
 	int yield_rpc_cnt;
+	struct timeval yield_tv;
 
+	gettimeofday(&yield_tv, NULL);
 	yield_rpc_cnt = MAX((max_rpc_cnt / 10), 20);
 	job_update  = last_job_update;
 	node_update = last_node_update;
@@ -1111,6 +1204,7 @@ static int _yield_locks(int64_t usec)
 		slurm_mutex_unlock(&slurmctld_config.thread_count_lock);
 	}
 	lock_slurmctld(all_locks);
+	bf_phase.yield += slurm_delta_tv(&yield_tv);
 	slurm_mutex_lock(&config_lock);
 	if (config_flag)
 		load_config = true;
@@ -1332,16 +1426,115 @@ static int _foreach_het_job_details(void *x, void *arg)
 	return SLURM_SUCCESS;
 }
 
-static int _bf_reserve_running(void *x, void *arg)
+/* Fetch key from xhash_t item. Called from function ptr */
+static void _bf_running_key_id(void *item, const char **key,
+			       uint32_t *key_len)
+{
+	bf_running_job_t *running = (bf_running_job_t *) item;
+
+	xassert(running);
+
+	*key = (char *) &running->job_id;
+	*key_len = sizeof(uint32_t);
+}
+
+/* Free item from xhash_t. Called from function ptr */
+static void _bf_running_free(void *item)
+{
+	bf_running_job_t *running = (bf_running_job_t *) item;
+
+	if (!running)
+		return;
+
+	FREE_NULL_BITMAP(running->node_bitmap);
+	xfree(running);
+}
+
+static void _bf_running_bucket_free(void *x)
+{
+	bf_running_bucket_t *bucket = (bf_running_bucket_t *) x;
+
+	if (!bucket)
+		return;
+
+	FREE_NULL_LIST(bucket->job_list);
+	FREE_NULL_BITMAP(bucket->node_bitmap);
+	xfree(bucket);
+}
+
+static int _bf_running_bucket_find(void *x, void *key)
+{
+	bf_running_bucket_t *bucket = (bf_running_bucket_t *) x;
+	time_t *end_time = (time_t *) key;
+
+	if (bucket->end_time == *end_time)
+		return 1;
+	return 0;
+}
+
+static int _bf_running_bucket_sort(void *x, void *y)
+{
+	bf_running_bucket_t *bucket1 = *(bf_running_bucket_t **) x;
+	bf_running_bucket_t *bucket2 = *(bf_running_bucket_t **) y;
+
+	if (bucket1->end_time < bucket2->end_time)
+		return -1;
+	if (bucket1->end_time > bucket2->end_time)
+		return 1;
+	return 0;
+}
+
+/* Release all records of the running job reservation cache */
+static void _bf_running_cache_fini(void)
+{
+	FREE_NULL_LIST(running_bucket_list);
+	xhash_free(running_job_map);
+	running_node_cnt = 0;
+}
+
+/* Remove a cached job from its bucket, the bucket must then be rebuilt */
+static void _bf_running_bucket_remove(bf_running_job_t *running)
+{
+	if (!running->bucket)
+		return;
+
+	list_delete_ptr(running->bucket->job_list, running);
+	running->bucket->rebuild = true;
+	running->bucket = NULL;
+}
+
+static void _bf_running_bucket_add(bf_running_job_t *running,
+				   time_t end_time)
+{
+	bf_running_bucket_t *bucket;
+
+	if (!(bucket = list_find_first(running_bucket_list,
+				       _bf_running_bucket_find, &end_time))) {
+		bucket = xmalloc(sizeof(bf_running_bucket_t));
+		bucket->end_time = end_time;
+		bucket->job_list = list_create(NULL);
+		bucket->node_bitmap = bit_alloc(node_record_count);
+		list_append(running_bucket_list, bucket);
+		running_bucket_sort = true;
+	}
+
+	list_append(bucket->job_list, running);
+	if (!bucket->rebuild)
+		bit_or(bucket->node_bitmap, running->node_bitmap);
+	running->bucket = bucket;
+}
+
+/*
+ * Record a running job in the cache. Jobs which are unchanged since the
+ * previous cycle are only marked as seen.
+ */
+static int _bf_running_cache_job(void *x, void *arg)
 {
 	job_record_t *job_ptr = (job_record_t *) x;
-	node_space_handler_t *ns_h = (node_space_handler_t *) arg;
-	node_space_map_t *node_space = ns_h->node_space;
-	int *ns_recs_ptr = ns_h->node_space_recs;
-	time_t start_time = job_ptr->start_time;
-	time_t end_time = job_ptr->end_time;
+	bf_running_job_t *running;
+	time_t end_time;
 
-	if (!job_ptr || ! IS_JOB_RUNNING(job_ptr))
+	if (!job_ptr || !IS_JOB_RUNNING(job_ptr) || !job_ptr->node_bitmap)
 		return SLURM_SUCCESS;
 	if (!job_ptr->job_resrcs || !(job_ptr->job_resrcs->whole_node ==
 				      WHOLE_NODE_REQUIRED))
@@ -1349,19 +1542,347 @@ static int _bf_reserve_running(void *x, void *arg)
 	if (slurm_job_preempt_mode(job_ptr) != PREEMPT_MODE_OFF)
 		return SLURM_SUCCESS;
 
-	bitstr_t *tmp_bitmap = bit_copy(job_ptr->node_bitmap);
-
-	bit_not(tmp_bitmap);
-	end_time = (end_time / backfill_resolution) * backfill_resolution;
+	end_time = (job_ptr->end_time / backfill_resolution) *
+		   backfill_resolution;
 
-	_add_reservation(start_time, end_time, tmp_bitmap, node_space,
-			 ns_recs_ptr);
+	running = xhash_get(running_job_map, (char *) &job_ptr->job_id,
+			    sizeof(uint32_t));
+	if (running && running->bucket &&
+	    (running->bucket->end_time == end_time) &&
+	    (running->start_time == job_ptr->start_time) &&
+	    (running->node_cnt == job_ptr->node_cnt)) {
+		running->generation = running_generation;
+		return SLURM_SUCCESS;
+	}
 
-	FREE_NULL_BITMAP(tmp_bitmap);
+	if (running) {
+		/* Job was requeued, resized or its time limit changed */
+		_bf_running_bucket_remove(running);
+		FREE_NULL_BITMAP(running->node_bitmap);
+	} else {
+		running = xmalloc(sizeof(bf_running_job_t));
+		running->job_id = job_ptr->job_id;
+		xhash_add(running_job_map, running);
+	}
+	running->generation = running_generation;
+	running->node_bitmap = bit_copy(job_ptr->node_bitmap);
+	running->node_cnt = job_ptr->node_cnt;
+	running->start_time = job_ptr->start_time;
+	_bf_running_bucket_add(running, end_time);
 
 	return SLURM_SUCCESS;
 }
 
+/* Purge jobs not seen this cycle and rebuild modified buckets */
+static int _bf_running_bucket_purge(void *x, void *arg)
+{
+	bf_running_bucket_t *bucket = (bf_running_bucket_t *) x;
+	bf_running_job_t *running;
+	ListIterator iter;
+
+	iter = list_iterator_create(bucket->job_list);
+	while ((running = list_next(iter))) {
+		if (running->generation == running_generation)
+			continue;
+		list_delete_item(iter);
+		bucket->rebuild = true;
+		xhash_delete(running_job_map, (char *) &running->job_id,
+			     sizeof(uint32_t));
+	}
+	list_iterator_destroy(iter);
+
+	if (list_is_empty(bucket->job_list))
+		return 1;	/* Delete the bucket */
+
+	if (bucket->rebuild) {
+		bit_clear_all(bucket->node_bitmap);
+		iter = list_iterator_create(bucket->job_list);
+		while ((running = list_next(iter)))
+			bit_or(bucket->node_bitmap, running->node_bitmap);
+		list_iterator_destroy(iter);
+		bucket->rebuild = false;
+	}
+
+	return 0;
+}
+
+/*
+ * Bring the running job reservation cache up to date with job_list.
+ * RET count of buckets (distinct end times) in the cache
+ */
+static int _bf_running_cache_update(void)
+{
+	if (running_job_map && (running_node_cnt != node_record_count))
+		_bf_running_cache_fini();	/* Node table changed */
+
+	if (!running_job_map) {
+		running_job_map = xhash_init(_bf_running_key_id,
+					     _bf_running_free);
+		running_bucket_list = list_create(_bf_running_bucket_free);
+		running_node_cnt = node_record_count;
+	}
+
+	running_generation++;
+	list_for_each(job_list, _bf_running_cache_job, NULL);
+	list_delete_all(running_bucket_list, _bf_running_bucket_purge, NULL);
+
+	if (running_bucket_sort) {
+		list_sort(running_bucket_list, _bf_running_bucket_sort);
+		running_bucket_sort = false;
+	}
+
+	return list_count(running_bucket_list);
+}
+
+/*
+ * Add one backfill reservation for each end time of running jobs
+ * IN node_bitmap - only consider jobs on these nodes, NULL for all nodes
+ */
+static void _bf_reserve_running(node_space_map_t *node_space,
+				int *node_space_recs, bitstr_t *node_bitmap)
+{
+	bf_running_bucket_t *bucket;
+	bitstr_t *tmp_bitmap;
+	ListIterator iter;
+
+	iter = list_iterator_create(running_bucket_list);
+	while ((bucket = list_next(iter))) {
+		/* Jobs past their end time are expected to end now */
+		if (bucket->end_time <= node_space[0].begin_time)
+			continue;
+		if (node_bitmap &&
+		    !bit_overlap_any(bucket->node_bitmap, node_bitmap))
+			continue;
+		tmp_bitmap = bit_copy(bucket->node_bitmap);
+		bit_not(tmp_bitmap);
+		_add_reservation(node_space[0].begin_time, bucket->end_time,
+				 tmp_bitmap, node_space, node_space_recs);
+		FREE_NULL_BITMAP(tmp_bitmap);
+	}
+	list_iterator_destroy(iter);
+}
+
+static int _bf_part_group_root(int *parent, int inx)
+{
+	while (parent[inx] != inx) {
+		parent[inx] = parent[parent[inx]];
+		inx = parent[inx];
+	}
+	return inx;
+}
+
+static void _bf_part_group_join(int *parent, int inx1, int inx2)
+{
+	inx1 = _bf_part_group_root(parent, inx1);
+	inx2 = _bf_part_group_root(parent, inx2);
+	if (inx1 != inx2)
+		parent[MAX(inx1, inx2)] = MIN(inx1, inx2);
+}
+
+static int _bf_part_inx(bf_part_groups_t *part_groups, part_record_t *part_ptr)
+{
+	for (int i = 0; i < part_groups->part_cnt; i++) {
+		if (part_groups->parts[i] == part_ptr)
+			return i;
+	}
+	return -1;
+}
+
+/*
+ * Find the group of a partition. Partitions not known when the groups were
+ * built (none expected) are placed in the first group.
+ */
+static bf_part_group_t *_bf_part_group_find(bf_part_groups_t *part_groups,
+					    part_record_t *part_ptr)
+{
+	int inx = _bf_part_inx(part_groups, part_ptr);
+
+	if (inx < 0)
+		return &part_groups->groups[0];
+	return &part_groups->groups[part_groups->part_group[inx]];
+}
+
+/*
+ * Place partitions into groups which share no nodes. Partitions of a pending
+ * job submitted to multiple partitions are placed in the same group and a
+ * single group is used if any pending job is a hetjob component, since its
+ * components are tested together.
+ * OUT part_groups - filled in, free with _bf_part_groups_free()
+ */
+static void _bf_part_groups_build(bf_part_groups_t *part_groups,
+				  List job_queue)
+{
+	part_record_t *part_ptr;
+	job_queue_rec_t *job_queue_rec;
+	ListIterator iter;
+	bool single_group = !bf_disjoint_parts;
+	int *parent, *group_inx;
+	int i, j, inx, part_cnt = 0;
+
+	memset(part_groups, 0, sizeof(bf_part_groups_t));
+
+	if (!single_group)
+		part_cnt = list_count(part_list);
+	part_groups->parts = xcalloc(part_cnt + 1, sizeof(part_record_t *));
+	part_groups->part_group = xcalloc(part_cnt + 1, sizeof(int));
+	parent = xcalloc(part_cnt + 1, sizeof(int));
+
+	if (!single_group) {
+		iter = list_iterator_create(part_list);
+		while ((part_ptr = list_next(iter)) &&
+		       (part_groups->part_cnt < part_cnt))
+			part_groups->parts[part_groups->part_cnt++] = part_ptr;
+		list_iterator_destroy(iter);
+		part_cnt = part_groups->part_cnt;
+	}
+	for (i = 0; i < part_cnt; i++)
+		parent[i] = i;
+
+	for (i = 0; i < part_cnt; i++) {
+		if (!part_groups->parts[i]->node_bitmap)
+			continue;
+		for (j = i + 1; j < part_cnt; j++) {
+			if (!part_groups->parts[j]->node_bitmap)
+				continue;
+			if (bit_overlap_any(part_groups->parts[i]->node_bitmap,
+					    part_groups->parts[j]->node_bitmap))
+				_bf_part_group_join(parent, i, j);
+		}
+	}
+
+	if (part_cnt > 1) {
+		iter = list_iterator_create(job_queue);
+		while (!single_group && (job_queue_rec = list_next(iter))) {
+			job_record_t *job_ptr = job_queue_rec->job_ptr;
+			ListIterator part_iter;
+			int first_inx;
+
+			if (job_ptr->het_job_id) {
+				single_group = true;
+				break;
+			}
+			if (!job_ptr->part_ptr_list)
+				continue;
+			first_inx = _bf_part_inx(part_groups,
+						 job_queue_rec->part_ptr);
+			if (first_inx < 0)
+				continue;
+			part_iter = list_iterator_create(job_ptr->part_ptr_list);
+			while ((part_ptr = list_next(part_iter))) {
+				if ((inx = _bf_part_inx(part_groups,
+							part_ptr)) >= 0)
+					_bf_part_group_join(parent, first_inx,
+							    inx);
+			}
+			list_iterator_destroy(part_iter);
+		}
+		list_iterator_destroy(iter);
+	}
+
+	group_inx = xcalloc(part_cnt + 1, sizeof(int));
+	for (i = 0; i < part_cnt; i++) {
+		if (single_group) {
+			part_groups->part_group[i] = 0;
+			continue;
+		}
+		inx = _bf_part_group_root(parent, i);
+		if (inx == i)
+			group_inx[i] = part_groups->group_cnt++;
+		part_groups->part_group[i] = group_inx[inx];
+	}
+	xfree(group_inx);
+	xfree(parent);
+
+	if (single_group || (part_groups->group_cnt < 2)) {
+		/* One group using all nodes */
+		part_groups->group_cnt = 1;
+		part_groups->groups = xcalloc(1, sizeof(bf_part_group_t));
+		for (i = 0; i < part_cnt; i++)
+			part_groups->part_group[i] = 0;
+		return;
+	}
+
+	part_groups->groups = xcalloc(part_groups->group_cnt,
+				      sizeof(bf_part_group_t));
+	for (i = 0; i < part_groups->group_cnt; i++)
+		part_groups->groups[i].node_bitmap =
+			bit_alloc(node_record_count);
+	for (i = 0; i < part_cnt; i++) {
+		if (!part_groups->parts[i]->node_bitmap)
+			continue;
+		bit_or(part_groups->groups[part_groups->part_group[i]].
+		       node_bitmap, part_groups->parts[i]->node_bitmap);
+	}
+	log_flag(BACKFILL, "%d partitions in %d disjoint groups",
+		 part_cnt, part_groups->group_cnt);
+}
+
+static void _bf_part_groups_free(bf_part_groups_t *part_groups)
+{
+	bf_part_group_t *group;
+	int i, j;
+
+	for (i = 0; i < part_groups->group_cnt; i++) {
+		group = &part_groups->groups[i];
+		if (group->node_space) {
+			for (j = 0; ; ) {
+				FREE_NULL_BITMAP(group->node_space[j].
+						 avail_bitmap);
+				if ((j = group->node_space[j].next) == 0)
+					break;
+			}
+			xfree(group->node_space);
+		}
+		FREE_NULL_BITMAP(group->node_bitmap);
+	}
+	xfree(part_groups->groups);
+	xfree(part_groups->part_group);
+	xfree(part_groups->parts);
+}
+
+/*
+ * Add the time spent testing a job to its partition's statistics. Only
+ * collected with DebugFlags=Backfill, for _bf_phase_log().
+ */
+static void _bf_part_stat_add(part_record_t *part_ptr, uint64_t usec)
+{
+	int i;
+
+	if (!(slurm_conf.debug_flags & DEBUG_FLAG_BACKFILL) || !part_ptr)
+		return;
+
+	for (i = 0; i < bf_part_stat_cnt; i++) {
+		if (!xstrcmp(bf_part_stats[i].name, part_ptr->name))
+			break;
+	}
+	if (i == bf_part_stat_cnt) {
+		xrecalloc(bf_part_stats, ++bf_part_stat_cnt,
+			  sizeof(bf_part_stat_t));
+		bf_part_stats[i].name = xstrdup(part_ptr->name);
+	}
+	bf_part_stats[i].tested++;
+	bf_part_stats[i].usec += usec;
+}
+
+/* Log where the time of this backfill cycle went */
+static void _bf_phase_log(void)
+{
+	if (slurm_conf.debug_flags & DEBUG_FLAG_BACKFILL) {
+		info("cycle phases: queue=%"PRIu64" running=%"PRIu64" resv=%"PRIu64" sched=%"PRIu64" yield=%"PRIu64" usec",
+		     bf_phase.queue, bf_phase.running, bf_phase.resv,
+		     bf_phase.sched, bf_phase.yield);
+		for (int i = 0; i < bf_part_stat_cnt; i++) {
+			info("partition %s: tested %u jobs in %"PRIu64" usec",
+			     bf_part_stats[i].name, bf_part_stats[i].tested,
+			     bf_part_stats[i].usec);
+		}
+	}
+	for (int i = 0; i < bf_part_stat_cnt; i++)
+		xfree(bf_part_stats[i].name);
+	xfree(bf_part_stats);
+	bf_part_stat_cnt = 0;
+}
+
 static int _set_hetjob_details(void *x, void *arg)
 {
 	job_record_t *job_ptr = (job_record_t *) x;
@@ -1554,7 +2075,7 @@ static int _attempt_backfill(void)
 	DEF_TIMERS;
 	List job_queue;
 	job_queue_rec_t *job_queue_rec;
-	int bb, i, j, node_space_recs, mcs_select = 0;
+	int bb, i, j, node_space_recs, mcs_select = 0, running_bucket_cnt = 0;
 	slurmdb_qos_rec_t *qos_ptr = NULL;
 	job_record_t *job_ptr = NULL;
 	part_record_t *part_ptr;
@@ -1567,6 +2088,8 @@ static int _attempt_backfill(void)
 	time_t now, sched_start, later_start, start_res, resv_end, window_end;
 	time_t het_job_time, orig_sched_start, orig_start_time = (time_t) 0;
 	node_space_map_t *node_space;
+	bf_part_groups_t part_groups;
+	bf_part_group_t *part_group;
 	struct timeval bf_time1, bf_time2;
 	int rc = 0, error_code;
 	int job_test_count = 0, test_time_count = 0, pend_time;
@@ -1576,7 +2099,8 @@ static int _attempt_backfill(void)
 	uint32_t start_time;
 	time_t config_update = slurm_conf.last_update;
 	time_t part_update = last_part_update;
-	struct timeval start_tv;
+	struct timeval start_tv, phase_tv, job_tv;
+	uint64_t job_usec, resv_usec;
 	uint32_t test_array_job_id = 0;
 	uint32_t test_array_count = 0;
 	uint32_t job_no_reserve;
@@ -1595,6 +2119,7 @@ static int _attempt_backfill(void)
 
 	bf_sleep_usec = 0;
 	job_start_cnt = 0;
+	memset(&bf_phase, 0, sizeof(bf_phase));
 
 	if (!fed_mgr_sibs_synced()) {
 		info("returning, federation siblings not synced yet");
@@ -1628,6 +2153,7 @@ static int _attempt_backfill(void)
 	if (bf_hetjob_prio)
 		list_for_each(job_list, _set_hetjob_details, NULL);
 
+	bf_phase.queue = slurm_delta_tv(&start_tv);
 	gettimeofday(&bf_time1, NULL);
 
 	slurmctld_diag_stats.bf_queue_len = job_test_count;
@@ -1639,30 +2165,46 @@ static int _attempt_backfill(void)
 	slurmctld_diag_stats.bf_last_depth_try = 0;
 	slurmctld_diag_stats.bf_when_last_cycle = now;
 
-	node_space = xmalloc(sizeof(node_space_map_t) *
-			     (max_backfill_job_cnt * 2 + 1));
-	node_space[0].begin_time = sched_start;
-	window_end = sched_start + backfill_window;
-	node_space[0].end_time = window_end;
-
-	node_space[0].avail_bitmap = bit_copy(avail_node_bitmap);
-	/* Make "resuming" nodes available to be scheduled in backfill */
-	bit_or(node_space[0].avail_bitmap, rs_node_bitmap);
-
-	node_space[0].next = 0;
-	node_space_recs = 1;
+	gettimeofday(&phase_tv, NULL);
+	if (bf_running_job_reserve)
+		running_bucket_cnt = _bf_running_cache_update();
+	else if (running_job_map)
+		_bf_running_cache_fini();
 
-	if (bf_running_job_reserve) {
-		node_space_handler_t node_space_handler;
-		node_space_handler.node_space = node_space;
-		node_space_handler.node_space_recs = &node_space_recs;
+	window_end = sched_start + backfill_window;
+	_bf_part_groups_build(&part_groups, job_queue);
+	node_space_recs = 0;
+	for (i = 0; i < part_groups.group_cnt; i++) {
+		part_group = &part_groups.groups[i];
+		node_space = xmalloc(sizeof(node_space_map_t) *
+				     ((max_backfill_job_cnt +
+				       running_bucket_cnt) * 2 + 1));
+		node_space[0].begin_time = sched_start;
+		node_space[0].end_time = window_end;
+
+		node_space[0].avail_bitmap = bit_copy(avail_node_bitmap);
+		/* Make "resuming" nodes available to be scheduled in backfill */
+		bit_or(node_space[0].avail_bitmap, rs_node_bitmap);
+		if (part_group->node_bitmap)
+			bit_and(node_space[0].avail_bitmap,
+				part_group->node_bitmap);
+
+		node_space[0].next = 0;
+		part_group->node_space = node_space;
+		part_group->node_space_recs = 1;
+
+		if (bf_running_job_reserve)
+			_bf_reserve_running(node_space,
+					    &part_group->node_space_recs,
+					    part_group->node_bitmap);
 
-		list_for_each(job_list, _bf_reserve_running,
-			      &node_space_handler);
+		if (slurm_conf.debug_flags & DEBUG_FLAG_BACKFILL_MAP)
+			_dump_node_space_table(node_space);
+		node_space_recs += part_group->node_space_recs;
 	}
-
-	if (slurm_conf.debug_flags & DEBUG_FLAG_BACKFILL_MAP)
-		_dump_node_space_table(node_space);
+	/* Only count the initial record once, as with a single table */
+	node_space_recs -= (part_groups.group_cnt - 1);
+	bf_phase.running = slurm_delta_tv(&phase_tv);
 
 	if (assoc_limit_stop) {
 		assoc_mgr_lock(&qos_read_lock);
@@ -1701,11 +2243,14 @@ static int _attempt_backfill(void)
 		bf_job_priority  = job_queue_rec->priority;
 		bf_array_task_id = job_queue_rec->array_task_id;
 
+		part_group = _bf_part_group_find(&part_groups, part_ptr);
+		node_space = part_group->node_space;
+
 		if (job_ptr->resv_list)
 			job_queue_rec_resv_list(job_queue_rec);
 		else
 			job_queue_rec_magnetic_resv(job_queue_rec);
-		xfree(job_queue_rec);
+		job_queue_rec_free(job_queue_rec);
 		if (slurmctld_config.shutdown_time ||
 		    (difftime(time(NULL),orig_sched_start) >= bf_max_time)){
 			break;
@@ -2100,8 +2645,10 @@ next_task:
 		resv_end = 0;
 		later_start = 0;
 		/* Determine impact of any advance reservations */
+		gettimeofday(&phase_tv, NULL);
 		j = job_test_resv(job_ptr, &start_res, true, &avail_bitmap,
 				  &exc_core_bitmap, &resv_overlap, false);
+		bf_phase.resv += slurm_delta_tv(&phase_tv);
 		if (j != SLURM_SUCCESS) {
 			log_flag(BACKFILL, "%pJ reservation defer",
 				 job_ptr);
@@ -2218,6 +2765,8 @@ next_task:
 		job_ptr->bit_flags |= BACKFILL_TEST;
 		job_ptr->bit_flags |= job_no_reserve;	/* 0 or TEST_NOW_ONLY */
 
+		gettimeofday(&job_tv, NULL);
+		resv_usec = bf_phase.resv;
 		if (active_bitmap) {
 			j = _try_sched(job_ptr, &active_bitmap, min_nodes,
 				       max_nodes, req_nodes, exc_core_bitmap);
@@ -2250,9 +2799,11 @@ next_task:
 			       job_ptr);
 			/* Determine impact of any advance reservations */
 			resv_end = 0;
+			gettimeofday(&phase_tv, NULL);
 			j = job_test_resv(job_ptr, &start_res, false,
 					  &tmp_node_bitmap, &tmp_core_bitmap,
 					  &resv_overlap, true);
+			bf_phase.resv += slurm_delta_tv(&phase_tv);
 			if (resv_overlap)
 				resv_end = find_resv_end(start_res,
 							 backfill_resolution);
@@ -2299,6 +2850,11 @@ next_task:
 		job_ptr->bit_flags &= ~BACKFILL_TEST;
 		job_ptr->bit_flags &= ~BF_WHOLE_NODE_TEST;
 		job_ptr->bit_flags &= ~TEST_NOW_ONLY;
+		/* Reservation tests above are accounted separately */
+		job_usec = slurm_delta_tv(&job_tv) -
+			   (bf_phase.resv - resv_usec);
+		bf_phase.sched += job_usec;
+		_bf_part_stat_add(part_ptr, job_usec);
 
 		now = time(NULL);
 		if (j != SLURM_SUCCESS) {
@@ -2700,8 +3256,11 @@ skip_start:
 		bit_not(avail_bitmap);
 		if ((!bf_one_resv_per_job || !orig_start_time) &&
 		    !(job_ptr->bit_flags & JOB_MAGNETIC)) {
+			node_space_recs -= part_group->node_space_recs;
 			_add_reservation(start_time, end_reserve, avail_bitmap,
-					 node_space, &node_space_recs);
+					 node_space,
+					 &part_group->node_space_recs);
+			node_space_recs += part_group->node_space_recs;
 		}
 		if (slurm_conf.debug_flags & DEBUG_FLAG_BACKFILL_MAP)
 			_dump_node_space_table(node_space);
@@ -2746,22 +3305,18 @@ skip_start:
 	if (!bf_hetjob_immediate &&
 	    (!max_backfill_jobs_start ||
 	     (job_start_cnt < max_backfill_jobs_start)))
-		_het_job_start_test(node_space, 0);
+		_het_job_start_test(part_groups.groups[0].node_space, 0);
 
 	FREE_NULL_BITMAP(avail_bitmap);
 	FREE_NULL_BITMAP(exc_core_bitmap);
 	FREE_NULL_BITMAP(resv_bitmap);
 
-	for (i = 0; ; ) {
-		FREE_NULL_BITMAP(node_space[i].avail_bitmap);
-		if ((i = node_space[i].next) == 0)
-			break;
-	}
-	xfree(node_space);
+	_bf_part_groups_free(&part_groups);
 	FREE_NULL_LIST(job_queue);
 
 	gettimeofday(&bf_time2, NULL);
 	_do_diag_stats(&bf_time1, &bf_time2, node_space_recs);
+	_bf_phase_log();
 	if (slurm_conf.debug_flags & DEBUG_FLAG_BACKFILL) {
 		END_TIMER;
 		info("completed testing %u(%d) jobs, %s",
@@ -2787,6 +3342,7 @@ static int _start_job(job_record_t *job_ptr, bitstr_t *resv_bitmap)
 	bitstr_t *orig_exc_nodes = NULL;
 	bool is_job_array_head = false;
 	static uint32_t fail_jobid = 0;
+	uint64_t span;
 
 	if (job_ptr->details->exc_node_bitmap) {
 		orig_exc_nodes = bit_copy(job_ptr->details->exc_node_bitmap);
@@ -2795,8 +3351,12 @@ static int _start_job(job_record_t *job_ptr, bitstr_t *resv_bitmap)
 		job_ptr->details->exc_node_bitmap = bit_copy(resv_bitmap);
 	if (job_ptr->array_recs)
 		is_job_array_head = true;
+	trace_set_id(job_ptr->job_id);
+	span = trace_span_start();
 	rc = select_nodes(job_ptr, false, NULL, NULL, false,
 			  SLURMDB_JOB_FLAG_BACKFILL);
+	trace_span_end("backfill", span);
+	trace_set_id(0);
 	if (is_job_array_head && job_ptr->details) {
 		job_record_t *base_job_ptr;
 		base_job_ptr = find_job_record(job_ptr->array_job_id);
@@ -3048,9 +3608,11 @@ static bool _test_resv_overlap(node_space_map_t *node_space,
 	bool overlap = false;
 	int j;
 
+	/* node_space records are linked in order of begin_time */
 	for (j=0; ; ) {
+		if (node_space[j].begin_time >= end_reserve)
+			break;
 		if ((node_space[j].end_time   > start_time) &&
-		    (node_space[j].begin_time < end_reserve) &&
 		    (!bit_super_set(use_bitmap, node_space[j].avail_bitmap))) {
 			overlap = true;
 			break;
@@ -3071,19 +3633,20 @@ static void _het_job_map_del(void *x)
 	xfree(map);
 }
 
-/*
- * Return 1 if a het_job_map_t record with a specific het_job_id is found.
- * Always return 1 if "key" is zero.
- */
-static int _het_job_find_map(void *x, void *key)
+/* Fetch key from xhash_t item. Called from function ptr */
+static void _het_job_map_key_id(void *item, const char **key,
+				uint32_t *key_len)
 {
-	het_job_map_t *map = (het_job_map_t *) x;
-	uint32_t *het_job_id = (uint32_t *) key;
+	het_job_map_t *map = (het_job_map_t *) item;
 
-	if ((het_job_id == NULL) ||
-	    (map->het_job_id == *het_job_id))
-		return 1;
-	return 0;
+	*key = (char *) &map->het_job_id;
+	*key_len = sizeof(uint32_t);
+}
+
+/* Return the het_job_map_t record with a specific het_job_id, or NULL */
+static het_job_map_t *_het_job_find_map(uint32_t het_job_id)
+{
+	return xhash_get(het_job_map, (char *) &het_job_id, sizeof(uint32_t));
 }
 
 /*
@@ -3113,6 +3676,8 @@ static void _het_job_start_clear(void)
 	iter = list_iterator_create(het_job_list);
 	while ((map = (het_job_map_t *) list_next(iter))) {
 		if (map->prev_start == 0) {
+			xhash_delete(het_job_map, (char *) &map->het_job_id,
+				     sizeof(uint32_t));
 			list_delete_item(iter);
 		} else {
 			map->prev_start = 0;
@@ -3159,9 +3724,7 @@ static time_t _het_job_start_find(job_record_t *job_ptr)
 	time_t latest_start = (time_t) 0;
 
 	if (job_ptr->het_job_id) {
-		map = (het_job_map_t *) list_find_first(het_job_list,
-							_het_job_find_map,
-							 &job_ptr->het_job_id);
+		map = _het_job_find_map(job_ptr->het_job_id);
 		if (map) {
 			latest_start = _het_job_start_compute(map,
 							      job_ptr->job_id);
@@ -3189,9 +3752,7 @@ static void _het_job_start_set(job_record_t *job_ptr, time_t latest_start,
 	if (comp_time_limit == NO_VAL)
 		comp_time_limit = job_ptr->time_limit;
 	if (job_ptr->het_job_id) {
-		map = (het_job_map_t *) list_find_first(het_job_list,
-							_het_job_find_map,
-							 &job_ptr->het_job_id);
+		map = _het_job_find_map(job_ptr->het_job_id);
 		if (map) {
 			if (!map->comp_time_limit) {
 				map->comp_time_limit = comp_time_limit;
@@ -3231,6 +3792,7 @@ static void _het_job_start_set(job_record_t *job_ptr, time_t latest_start,
 			map->het_job_rec_list = list_create(xfree_ptr);
 			list_append(map->het_job_rec_list, rec);
 			list_append(het_job_list, map);
+			xhash_add(het_job_map, map);
 		}
 
 		log_flag(HETJOB, "%pJ in partition %s set to start in %ld secs",
@@ -3503,6 +4065,7 @@ static void _het_job_kill_now(het_job_map_t *map)
 		info("Deallocate %pJ due to hetjob start failure",
 		     job_ptr);
 		job_ptr->details->begin_time = now + cred_lifetime + 1;
+		time_event_job_add(job_ptr);
 		job_ptr->end_time   = now;
 		job_ptr->job_state  = JOB_PENDING | JOB_COMPLETING;
 		last_job_update     = now;
@@ -3605,9 +4168,7 @@ static void _het_job_start_test(node_space_map_t *node_space, uint32_t het_job_i
 				    _het_job_start_test_list, node_space);
 	} else {
 		/* Test single map. */
-		map = (het_job_map_t *)list_find_first(het_job_list,
-						       _het_job_find_map,
-							&het_job_id);
+		map = _het_job_find_map(het_job_id);
 		_het_job_start_test_single(node_space, map, true);
 	}
 }
@@ -3615,26 +4176,26 @@ static void _het_job_start_test(node_space_map_t *node_space, uint32_t het_job_i
 static void _deadlock_global_list_del(void *x)
 {
 	deadlock_part_struct_t *dl_part_ptr = (deadlock_part_struct_t *) x;
+	xhash_free(dl_part_ptr->deadlock_job_map);
 	FREE_NULL_LIST(dl_part_ptr->deadlock_job_list);
 	xfree(dl_part_ptr);
 }
 
-static int _deadlock_part_list_srch(void *x, void *key)
+/* Fetch key from xhash_t item. Called from function ptr */
+static void _deadlock_job_key_id(void *item, const char **key,
+				 uint32_t *key_len)
 {
-	deadlock_job_struct_t *dl_job = (deadlock_job_struct_t *) x;
-	job_record_t *job_ptr = (job_record_t *) key;
-	if (dl_job->het_job_id == job_ptr->het_job_id)
-		return 1;
-	return 0;
+	deadlock_job_struct_t *dl_job = (deadlock_job_struct_t *) item;
+
+	*key = (char *) &dl_job->het_job_id;
+	*key_len = sizeof(uint32_t);
 }
 
-static int _deadlock_part_list_srch2(void *x, void *key)
+static deadlock_job_struct_t *_deadlock_job_find(
+	deadlock_part_struct_t *dl_part_ptr, uint32_t het_job_id)
 {
-	deadlock_job_struct_t *dl_job = (deadlock_job_struct_t *) x;
-	deadlock_job_struct_t *dl_job2 = (deadlock_job_struct_t *) key;
-	if (dl_job->het_job_id == dl_job2->het_job_id)
-		return 1;
-	return 0;
+	return xhash_get(dl_part_ptr->deadlock_job_map, (char *) &het_job_id,
+			 sizeof(uint32_t));
 }
 
 static int _deadlock_global_list_srch(void *x, void *key)
@@ -3670,8 +4231,9 @@ static void _het_job_deadlock_fini(void)
  * job_ptr IN - job to test, set reason to "HET_JOB_DEADLOCK" if it will deadlock
  * RET true if the job can not run due to possible deadlock with other hetjob
  *
- * NOTE: If there are a large number of hetjobs this will be painfully slow
- *       as the algorithm must be order n^2
+ * NOTE: If there are a large number of hetjobs this will be slow as the
+ *       algorithm must be order n^2, each partition's hetjobs are hashed by
+ *       het_job_id so at least the lookups within that are constant time.
  */
 static bool _het_job_deadlock_test(job_record_t *job_ptr)
 {
@@ -3679,7 +4241,7 @@ static bool _het_job_deadlock_test(job_record_t *job_ptr)
 	deadlock_job_struct_t  *dl_job_ptr3 = NULL;
 	deadlock_part_struct_t *dl_part_ptr = NULL, *dl_part_ptr2 = NULL;
 	ListIterator job_iter, part_iter;
-	bool have_deadlock = false;
+	bool have_deadlock = false, resort = true;
 
 	if (!job_ptr->het_job_id || !job_ptr->part_ptr)
 		return false;
@@ -3698,22 +4260,28 @@ static bool _het_job_deadlock_test(job_record_t *job_ptr)
 	if (!dl_part_ptr) {
 		dl_part_ptr = xmalloc(sizeof(deadlock_part_struct_t));
 		dl_part_ptr->deadlock_job_list = list_create(xfree_ptr);
+		dl_part_ptr->deadlock_job_map =
+			xhash_init(_deadlock_job_key_id, NULL);
 		dl_part_ptr->part_ptr = job_ptr->part_ptr;
 		list_append(deadlock_global_list, dl_part_ptr);
 	} else {
-		dl_job_ptr = list_find_first(dl_part_ptr->deadlock_job_list,
-					     _deadlock_part_list_srch,
-					     job_ptr);
+		dl_job_ptr = _deadlock_job_find(dl_part_ptr,
+						job_ptr->het_job_id);
 	}
 	if (!dl_job_ptr) {
 		dl_job_ptr = xmalloc(sizeof(deadlock_job_struct_t));
 		dl_job_ptr->het_job_id = job_ptr->het_job_id;
 		dl_job_ptr->start_time = job_ptr->start_time;
 		list_append(dl_part_ptr->deadlock_job_list, dl_job_ptr);
+		xhash_add(dl_part_ptr->deadlock_job_map, dl_job_ptr);
 	} else if (dl_job_ptr->start_time < job_ptr->start_time) {
 		dl_job_ptr->start_time = job_ptr->start_time;
+	} else {
+		resort = false;	/* Already in order */
 	}
-	list_sort(dl_part_ptr->deadlock_job_list, _deadlock_job_list_sort);
+	if (resort)
+		list_sort(dl_part_ptr->deadlock_job_list,
+			  _deadlock_job_list_sort);
 
 	/*
 	 * Log current table of hetjob start times by partition
@@ -3746,9 +4314,8 @@ static bool _het_job_deadlock_test(job_record_t *job_ptr)
 	while ((dl_part_ptr2 = (deadlock_part_struct_t *)list_next(part_iter))){
 		if (dl_part_ptr2 == dl_part_ptr) /* Current partition, skip it */
 			continue;
-		dl_job_ptr2 = list_find_first(dl_part_ptr2->deadlock_job_list,
-					      _deadlock_part_list_srch,
-					      job_ptr);
+		dl_job_ptr2 = _deadlock_job_find(dl_part_ptr2,
+						 job_ptr->het_job_id);
 		if (!dl_job_ptr2) /* Hetjob not in this partition, no check */
 			continue;
 		job_iter = list_iterator_create(dl_part_ptr->deadlock_job_list);
@@ -3756,10 +4323,9 @@ static bool _het_job_deadlock_test(job_record_t *job_ptr)
 				      list_next(job_iter))) {
 			if (dl_job_ptr2->het_job_id == dl_job_ptr->het_job_id)
 				break;	/* Self */
-			dl_job_ptr3 = list_find_first(
-						dl_part_ptr2->deadlock_job_list,
-						_deadlock_part_list_srch2,
-						dl_job_ptr2);
+			dl_job_ptr3 = _deadlock_job_find(
+						dl_part_ptr2,
+						dl_job_ptr2->het_job_id);
 			if (dl_job_ptr3 &&
 			    (dl_job_ptr3->start_time < dl_job_ptr->start_time)){
 				have_deadlock = true;
@@ -156,7 +156,7 @@ static void _compute_start_times(void)
 	while ((job_queue_rec = (job_queue_rec_t *) list_pop(job_queue))) {
 		job_ptr  = job_queue_rec->job_ptr;
 		part_ptr = job_queue_rec->part_ptr;
-		xfree(job_queue_rec);
+		job_queue_rec_free(job_queue_rec);
 		if (part_ptr != job_ptr->part_ptr)
 			continue;	/* Only test one partition */
 
@@ -106,7 +106,7 @@ extern void core_array_and(bitstr_t **core_array1, bitstr_t **core_array2)
 			s1 = bit_size(core_array1[n]);
 			s2 = bit_size(core_array2[n]);
 			if (s1 > s2)
-				core_array2[n] = bit_realloc(core_array1[n],s1);
+				core_array2[n] = bit_realloc(core_array2[n],s1);
 			else if (s1 < s2)
 				core_array1[n] = bit_realloc(core_array1[n],s2);
 			bit_and(core_array1[n], core_array2[n]);
@@ -127,7 +127,7 @@ extern void core_array_and_not(bitstr_t **core_array1, bitstr_t **core_array2)
 			s1 = bit_size(core_array1[n]);
 			s2 = bit_size(core_array2[n]);
 			if (s1 > s2)
-				core_array2[n] = bit_realloc(core_array1[n],s1);
+				core_array2[n] = bit_realloc(core_array2[n],s1);
 			else if (s1 < s2)
 				core_array1[n] = bit_realloc(core_array1[n],s2);
 			bit_and_not(core_array1[n], core_array2[n]);
@@ -146,7 +146,7 @@ extern void core_array_or(bitstr_t **core_array1, bitstr_t **core_array2)
 			s1 = bit_size(core_array1[n]);
 			s2 = bit_size(core_array2[n]);
 			if (s1 > s2)
-				core_array2[n] = bit_realloc(core_array1[n],s1);
+				core_array2[n] = bit_realloc(core_array2[n],s1);
 			else if (s1 < s2)
 				core_array1[n] = bit_realloc(core_array1[n],s2);
 			bit_or(core_array1[n], core_array2[n]);
@@ -206,7 +206,7 @@ extern bitstr_t *core_array_to_bitmap(bitstr_t **core_array)
 {
 	bitstr_t *core_bitmap = NULL;
 	int i;
-	int c, core_offset;
+	int c, c_first, c_last, core_offset;
 #if _DEBUG
 	char tmp[128];
 #endif
@@ -233,11 +233,13 @@ extern bitstr_t *core_array_to_bitmap(bitstr_t **core_array)
 	core_bitmap =
 		bit_alloc(select_node_record[select_node_cnt-1].cume_cores);
 	for (i = 0; i < core_array_size; i++) {
-		if (!core_array[i])
+		if (!core_array[i] || ((c_first = bit_ffs(core_array[i])) == -1))
 			continue;
+		c_last = MIN(bit_fls(core_array[i]),
+			     select_node_record[i].tot_cores - 1);
 		core_offset = select_node_record[i].cume_cores -
 			      select_node_record[i].tot_cores;
-		for (c = 0; c < select_node_record[i].tot_cores; c++) {
+		for (c = c_first; c <= c_last; c++) {
 			if (bit_test(core_array[i], c))
 				bit_set(core_bitmap, core_offset + c);
 		}
@@ -255,7 +257,7 @@ extern bitstr_t *core_array_to_bitmap(bitstr_t **core_array)
 extern bitstr_t **core_bitmap_to_array(bitstr_t *core_bitmap)
 {
 	bitstr_t **core_array = NULL;
-	int i, i_first, i_last, j, c;
+	int i, i_first, i_last, i_node, j, c, c_last;
 	int node_inx = 0, core_offset;
 	char tmp[128];
 
@@ -283,6 +285,7 @@ extern bitstr_t **core_bitmap_to_array(bitstr_t *core_bitmap)
 	for (i = i_first; i <= i_last; i++) {
 		if (!bit_test(core_bitmap, i))
 			continue;
+		i_node = i;
 		for (j = node_inx; j < select_node_cnt; j++) {
 			if (i < select_node_record[j].cume_cores) {
 				node_inx = j;
@@ -296,12 +299,16 @@ extern bitstr_t **core_bitmap_to_array(bitstr_t *core_bitmap)
 			      tmp);
 			break;
 		}
-		/* Copy all core bitmaps for this node here */
+		/*
+		 * Copy all core bitmaps for this node here, starting from the
+		 * first set core found above
+		 */
 		core_array[node_inx] =
 			bit_alloc(select_node_record[node_inx].tot_cores);
 		core_offset = select_node_record[node_inx].cume_cores -
 			      select_node_record[node_inx].tot_cores;
-		for (c = 0; c < select_node_record[node_inx].tot_cores; c++) {
+		c_last = MIN(i, i_last) - core_offset;
+		for (c = i_node - core_offset; c <= c_last; c++) {
 			if (bit_test(core_bitmap, core_offset + c))
 				bit_set(core_array[node_inx], c);
 		}
@@ -103,6 +103,8 @@ static int _handle_job_res(job_resources_t *job_resrcs_ptr,
 			return 1;
 		core_array = build_core_array();
 		r_ptr->row_bitmap = core_array;
+		r_ptr->node_set_count = xcalloc(select_node_cnt,
+						sizeof(uint16_t));
 		r_ptr->row_set_count = 0;
 		for (int i = 0; i < core_array_size; i++)
 			core_array[i] = _create_core_bitmap(i);
@@ -143,27 +145,29 @@ static int _handle_job_res(job_resources_t *job_resrcs_ptr,
 				bit_nset(use_core_array,
 					 core_begin, core_end-1);
 				r_ptr->row_set_count += (core_end - core_begin);
+				r_ptr->node_set_count[i] =
+					core_end - core_begin;
 				break;
 			case HANDLE_JOB_RES_REM:
 				bit_nclear(use_core_array,
 					   core_begin, core_end-1);
 				r_ptr->row_set_count -= (core_end - core_begin);
+				r_ptr->node_set_count[i] = 0;
 				break;
 			case HANDLE_JOB_RES_TEST:
-				if (is_cons_tres) {
-					if (bit_ffs(use_core_array) != -1)
-						return 0;
-				} else {
-					for (c = 0; c < cores_per_node; c++)
-						if (bit_test(use_core_array,
-							     core_begin + c))
-							return 0;
-				}
+				if (r_ptr->node_set_count[i])
+					return 0;    /* Core conflict on node */
 				break;
 			}
 			continue;	/* Move to next node */
 		}
 
+		if ((type == HANDLE_JOB_RES_TEST) &&
+		    !r_ptr->node_set_count[i]) {
+			c_off += cores_per_node;
+			continue;	/* No cores in use on node */
+		}
+
 		for (c = 0; c < cores_per_node; c++) {
 			if (!bit_test(job_resrcs_ptr->core_bitmap, c_off + c))
 				continue;
@@ -175,10 +179,14 @@ static int _handle_job_res(job_resources_t *job_resrcs_ptr,
 			}
 			switch (type) {
 			case HANDLE_JOB_RES_ADD:
+				if (!bit_test(use_core_array, core_begin + c))
+					r_ptr->node_set_count[i]++;
 				bit_set(use_core_array, core_begin + c);
 			        r_ptr->row_set_count++;
 				break;
 			case HANDLE_JOB_RES_REM:
+				if (bit_test(use_core_array, core_begin + c))
+					r_ptr->node_set_count[i]--;
 				bit_clear(use_core_array, core_begin + c);
 				r_ptr->row_set_count--;
 				break;
@@ -87,6 +87,9 @@ static void _swap_rows(part_row_data_t *a, part_row_data_t *b)
 static void _reset_part_row_bitmap(part_row_data_t *r_ptr)
 {
 	clear_core_array(r_ptr->row_bitmap);
+	if (r_ptr->node_set_count)
+		memset(r_ptr->node_set_count, 0,
+		       sizeof(uint16_t) * select_node_cnt);
 	r_ptr->row_set_count = 0;
 }
 
@@ -386,6 +389,7 @@ extern void part_data_destroy_row(part_row_data_t *row, uint16_t num_rows)
 
 	for (r = 0; r < num_rows; r++) {
 		free_core_array(&row[r].row_bitmap);
+		xfree(row[r].node_set_count);
 		xfree(row[r].job_list);
 	}
 
@@ -503,6 +507,11 @@ extern part_row_data_t *part_data_dup_row(part_row_data_t *orig_row,
 				new_row[i].row_bitmap[n] =
 					bit_copy(orig_row[i].row_bitmap[n]);
 			}
+			new_row[i].node_set_count =
+				xcalloc(select_node_cnt, sizeof(uint16_t));
+			memcpy(new_row[i].node_set_count,
+			       orig_row[i].node_set_count,
+			       sizeof(uint16_t) * select_node_cnt);
 			new_row[i].row_set_count = orig_row[i].row_set_count;
 		}
 		if (new_row[i].job_list_size == 0)
@@ -49,6 +49,9 @@ typedef struct {
 					 * In cons_res only the first ptr is
 					 * used.
 					 */
+	uint16_t *node_set_count;	/* count of bits set in row_bitmap for
+					 * each node, allocated with row_bitmap
+					 */
 	uint32_t row_set_count;
 } part_row_data_t;
 
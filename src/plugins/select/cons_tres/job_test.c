@@ -54,6 +54,15 @@ typedef struct topo_weight_info {
 	uint64_t weight;
 } topo_weight_info_t;
 
+/*
+ * All nodes grouped by weight, kept between calls of
+ * _build_node_weight_list() and rebuilt when node data changes
+ */
+static pthread_mutex_t weight_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List weight_groups = NULL;
+static time_t weight_groups_time = 0;
+static int weight_groups_node_cnt = 0;
+
 /* Local functions */
 static List _build_node_weight_list(bitstr_t *node_bitmap);
 static void _cpus_to_use(uint16_t *avail_cpus, int64_t rem_cpus, int rem_nodes,
@@ -139,27 +148,19 @@ static int _node_weight_sort(void *x, void *y)
 }
 
 /*
- * Given a bitmap of available nodes, return a list of node_weight_type
- * records in order of increasing "weight" (priority)
+ * Build a list of node_weight_type records for all nodes, one per node weight,
+ * in order of increasing "weight" (priority)
  */
-static List _build_node_weight_list(bitstr_t *node_bitmap)
+static List _build_node_weight_groups(void)
 {
-	int i, i_first, i_last;
+	int i;
 	List node_list;
 	node_record_t *node_ptr;
 	node_weight_type *nwt;
 
-	xassert(node_bitmap);
-	/* Build list of node_weight_type records, one per node weight */
 	node_list = list_create(_node_weight_free);
-	i_first = bit_ffs(node_bitmap);
-	if (i_first == -1)
-		return node_list;
-	i_last = bit_fls(node_bitmap);
-	for (i = i_first; i <= i_last; i++) {
-		if (!bit_test(node_bitmap, i))
-			continue;
-		node_ptr = node_record_table_ptr + i;
+	for (i = 0, node_ptr = node_record_table_ptr; i < select_node_cnt;
+	     i++, node_ptr++) {
 		nwt = list_find_first(node_list, _node_weight_find,
 				      node_ptr->config_ptr);
 		if (!nwt) {
@@ -177,6 +178,50 @@ static List _build_node_weight_list(bitstr_t *node_bitmap)
 	return node_list;
 }
 
+/*
+ * Given a bitmap of available nodes, return a list of node_weight_type
+ * records in order of increasing "weight" (priority)
+ *
+ * The grouping of all nodes by weight only changes with the node
+ * configuration, so it is cached in weight_groups and each call only needs
+ * one bitmap AND per weight.
+ */
+static List _build_node_weight_list(bitstr_t *node_bitmap)
+{
+	List node_list;
+	ListIterator iter;
+	node_weight_type *group, *nwt;
+
+	xassert(node_bitmap);
+	node_list = list_create(_node_weight_free);
+	if (bit_ffs(node_bitmap) == -1)
+		return node_list;
+
+	slurm_mutex_lock(&weight_mutex);
+	if (!weight_groups || (last_node_update >= weight_groups_time) ||
+	    (weight_groups_node_cnt != select_node_cnt)) {
+		FREE_NULL_LIST(weight_groups);
+		weight_groups = _build_node_weight_groups();
+		weight_groups_time = time(NULL);
+		weight_groups_node_cnt = select_node_cnt;
+	}
+
+	iter = list_iterator_create(weight_groups);
+	while ((group = list_next(iter))) {
+		if (!bit_overlap_any(group->node_bitmap, node_bitmap))
+			continue;
+		nwt = xmalloc(sizeof(node_weight_type));
+		nwt->node_bitmap = bit_copy(group->node_bitmap);
+		bit_and(nwt->node_bitmap, node_bitmap);
+		nwt->weight = group->weight;
+		list_append(node_list, nwt);
+	}
+	list_iterator_destroy(iter);
+	slurm_mutex_unlock(&weight_mutex);
+
+	return node_list;
+}
+
 /* Log avail_res_t information for a given node */
 static void _avail_res_log(avail_res_t *avail_res, char *node_name)
 {
@@ -2101,6 +2146,7 @@ static int _eval_nodes_topo(job_record_t *job_ptr,
 	bitstr_t **switch_node_bitmap = NULL;	/* nodes on this switch */
 	int       *switch_node_cnt = NULL;	/* total nodes on switch */
 	int       *switch_required = NULL;	/* set if has required node */
+	bool      *switch_desc = NULL;		/* below top level switch */
 	bitstr_t  *avail_nodes_bitmap = NULL;	/* nodes on any switch */
 	bitstr_t  *req_nodes_bitmap   = NULL;	/* required node bitmap */
 	bitstr_t  *req2_nodes_bitmap  = NULL;	/* required+lowest prio nodes */
@@ -2302,14 +2348,20 @@ static int _eval_nodes_topo(job_record_t *job_ptr,
 
 	/*
 	 * Remove nodes from consideration that can not be reached from this
-	 * top level switch.
+	 * top level switch. The nodes of its descendant switches are already
+	 * a subset of its nodes.
 	 */
+	switch_desc = xcalloc(switch_record_cnt, sizeof(bool));
+	switch_ptr = &switch_record_table[top_switch_inx];
+	for (i = 0; i < switch_ptr->num_desc_switches; i++)
+		switch_desc[switch_ptr->switch_desc_index[i]] = true;
 	for (i = 0; i < switch_record_cnt; i++) {
-		if (top_switch_inx != i) {
+		if ((top_switch_inx != i) && !switch_desc[i]) {
 			  bit_and(switch_node_bitmap[i],
 				  switch_node_bitmap[top_switch_inx]);
 		}
 	}
+	xfree(switch_desc);
 
 	if (req_nodes_bitmap) {
 		bit_and(node_map, req_nodes_bitmap);
@@ -3450,3 +3502,11 @@ extern avail_res_t *can_job_run_on_node(job_record_t *job_ptr,
 
 	return avail_res;
 }
+
+/* Release the cached grouping of nodes by weight */
+extern void job_test_fini(void)
+{
+	slurm_mutex_lock(&weight_mutex);
+	FREE_NULL_LIST(weight_groups);
+	slurm_mutex_unlock(&weight_mutex);
+}
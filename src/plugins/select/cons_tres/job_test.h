@@ -83,4 +83,7 @@ extern int choose_nodes(job_record_t *job_ptr, bitstr_t *node_map,
 			avail_res_t **avail_res_array, uint16_t cr_type,
 			bool prefer_alloc_nodes, gres_mc_data_t *tres_mc_ptr);
 
+/* Release memory cached by the job test logic */
+extern void job_test_fini(void);
+
 #endif /* !_CONS_TRES_JOB_TEST_H */
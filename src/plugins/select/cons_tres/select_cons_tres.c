@@ -428,6 +428,7 @@ extern int init(void)
 extern int fini(void)
 {
 	common_fini();
+	job_test_fini();
 
 	free_core_array(&spec_core_res);
 
@@ -0,0 +1,278 @@
+/*****************************************************************************\
+ *  site_factor_table.c - site_factor from a memory-mapped table
+*****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "src/common/slurm_xlator.h"
+#include "src/common/log.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+#include "src/slurmctld/slurmctld.h"
+
+/*
+ * These variables are required by the generic plugin interface.  If they
+ * are not found in the plugin, the plugin loader will ignore it.
+ *
+ * plugin_name - A string giving a human-readable description of the
+ * plugin.  There is no maximum length, but the symbol must refer to
+ * a valid string.
+ *
+ * plugin_type - A string suggesting the type of the plugin or its
+ * applicability to a particular form of data or method of data handling.
+ * If the low-level plugin API is used, the contents of this string are
+ * unimportant and may be anything.  Slurm uses the higher-level plugin
+ * interface which requires this string to be of the form
+ *
+ *	<application>/<method>
+ *
+ * where <application> is a description of the intended application of
+ * the plugin (e.g., "auth" for Slurm authentication) and <method> is a
+ * description of how this plugin satisfies that application.  Slurm will
+ * only load authentication plugins if the plugin_type string has a prefix
+ * of "auth/".
+ *
+ * plugin_version - an unsigned 32-bit integer containing the Slurm version
+ * (major.minor.micro combined into a single number).
+ */
+const char	*plugin_name		= "Table site_factor plugin";
+const char	plugin_type[]		= "site_factor/table";
+const uint32_t	plugin_version		= SLURM_VERSION_NUMBER;
+
+/*
+ * Table written by an external daemon, in host byte order:
+ * a header followed by "count" entries sorted by job_id. The daemon is
+ * expected to write a new file and rename() it over the old one, which is
+ * picked up on the next update without ever reading a partial table.
+ */
+#define SF_TABLE_MAGIC "SLURMSF"
+#define SF_TABLE_VERSION 1
+
+typedef struct {
+	char magic[8];
+	uint32_t version;
+	uint32_t count;
+	uint64_t generation;
+} sf_table_hdr_t;
+
+typedef struct {
+	uint32_t job_id;
+	int32_t factor;		/* added to NICE_OFFSET */
+} sf_table_ent_t;
+
+static pthread_mutex_t table_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char *table_path = NULL;
+static void *table_map = NULL;
+static size_t table_len = 0;
+static struct stat table_stat;
+static sf_table_ent_t *table_ent = NULL;
+static uint32_t table_cnt = 0;
+
+static void _table_unmap(void)
+{
+	if (table_map)
+		munmap(table_map, table_len);
+	table_map = NULL;
+	table_len = 0;
+	table_ent = NULL;
+	table_cnt = 0;
+	memset(&table_stat, 0, sizeof(table_stat));
+}
+
+/* Map the table again if it was replaced since last checked */
+static void _table_refresh(void)
+{
+	sf_table_hdr_t *hdr;
+	struct stat st;
+	void *map;
+	int fd;
+
+	if (!table_path)
+		return;
+
+	if (stat(table_path, &st) < 0) {
+		if (table_map)
+			error("%s: stat(%s): %m", plugin_type, table_path);
+		_table_unmap();
+		return;
+	}
+	if (table_map && (st.st_ino == table_stat.st_ino) &&
+	    (st.st_dev == table_stat.st_dev) &&
+	    (st.st_size == table_stat.st_size) &&
+	    (st.st_mtime == table_stat.st_mtime))
+		return;
+
+	_table_unmap();
+	if (st.st_size < (off_t) sizeof(sf_table_hdr_t)) {
+		error("%s: %s is too short", plugin_type, table_path);
+		return;
+	}
+	if ((fd = open(table_path, O_RDONLY | O_CLOEXEC)) < 0) {
+		error("%s: open(%s): %m", plugin_type, table_path);
+		return;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		error("%s: mmap(%s): %m", plugin_type, table_path);
+		return;
+	}
+
+	hdr = map;
+	if (memcmp(hdr->magic, SF_TABLE_MAGIC, sizeof(SF_TABLE_MAGIC)) ||
+	    (hdr->version != SF_TABLE_VERSION) ||
+	    (hdr->count > ((st.st_size - sizeof(*hdr)) /
+			   sizeof(sf_table_ent_t)))) {
+		error("%s: %s is not a valid site factor table",
+		      plugin_type, table_path);
+		munmap(map, st.st_size);
+		return;
+	}
+
+	table_map = map;
+	table_len = st.st_size;
+	table_stat = st;
+	table_ent = (sf_table_ent_t *) (hdr + 1);
+	table_cnt = hdr->count;
+	debug("%s: mapped %s generation %"PRIu64" with %u entries",
+	      plugin_type, table_path, hdr->generation, table_cnt);
+}
+
+static sf_table_ent_t *_table_find(uint32_t job_id)
+{
+	uint32_t lo = 0, hi = table_cnt;
+
+	while (lo < hi) {
+		uint32_t mid = lo + ((hi - lo) / 2);
+
+		if (table_ent[mid].job_id == job_id)
+			return &table_ent[mid];
+		if (table_ent[mid].job_id < job_id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return NULL;
+}
+
+static void _set_job(job_record_t *job_ptr)
+{
+	sf_table_ent_t *ent;
+
+	/* Jobs not in the table keep any value set by job_submit/scontrol */
+	if (!(ent = _table_find(job_ptr->job_id)))
+		return;
+
+	job_ptr->site_factor = (int64_t) NICE_OFFSET + ent->factor;
+}
+
+static void _load_config(void)
+{
+	char *tmp, *end;
+
+	xfree(table_path);
+	if ((tmp = xstrcasestr(slurm_conf.site_factor_params, "table="))) {
+		table_path = xstrdup(tmp + strlen("table="));
+		if ((end = strchr(table_path, ',')))
+			*end = '\0';
+	}
+	if (!table_path)
+		error("%s: no table= set in PrioritySiteFactorParameters",
+		      plugin_type);
+
+	_table_unmap();
+	_table_refresh();
+}
+
+extern int init(void)
+{
+	slurm_mutex_lock(&table_mutex);
+	_load_config();
+	slurm_mutex_unlock(&table_mutex);
+
+	debug("%s: %s loaded", __func__, plugin_name);
+
+	return SLURM_SUCCESS;
+}
+
+extern int fini(void)
+{
+	slurm_mutex_lock(&table_mutex);
+	_table_unmap();
+	xfree(table_path);
+	slurm_mutex_unlock(&table_mutex);
+
+	debug("%s: unloading %s", __func__, plugin_name);
+
+	return SLURM_SUCCESS;
+}
+
+extern void site_factor_p_reconfig(void)
+{
+	slurm_mutex_lock(&table_mutex);
+	_load_config();
+	slurm_mutex_unlock(&table_mutex);
+}
+
+extern void site_factor_p_set(job_record_t *job_ptr)
+{
+	/* The daemon may not know about a job this new, use what is mapped */
+	slurm_mutex_lock(&table_mutex);
+	_set_job(job_ptr);
+	slurm_mutex_unlock(&table_mutex);
+}
+
+extern void site_factor_p_update(void)
+{
+	/* All work is done in site_factor_p_update_pending() */
+	return;
+}
+
+extern void site_factor_p_update_pending(job_record_t **jobs,
+					 uint32_t job_cnt)
+{
+	uint32_t i;
+
+	slurm_mutex_lock(&table_mutex);
+	_table_refresh();
+	if (table_cnt) {
+		for (i = 0; i < job_cnt; i++)
+			_set_job(jobs[i]);
+	}
+	slurm_mutex_unlock(&table_mutex);
+}
@@ -44,7 +44,9 @@
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_resource_info.h"
 #include "src/common/strlcpy.h"
+#include "src/common/xhash.h"
 #include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
 #include "src/slurmd/slurmd/slurmd.h"
 
 #ifdef HAVE_NUMA
@@ -52,6 +54,8 @@
 #endif
 
 static char *_alloc_mask(launch_tasks_request_msg_t *req,
+			 bitstr_t *avail_map, uint16_t sockets,
+			 uint16_t cores, uint16_t threads,
 			 int *whole_node_cnt, int *whole_socket_cnt,
 			 int *whole_core_cnt, int *whole_thread_cnt,
 			 int *part_socket_cnt, int *part_core_cnt);
@@ -62,9 +66,13 @@ static int _get_local_node_info(slurm_cred_arg_t *arg, int job_node_id,
 				uint16_t *sockets, uint16_t *cores);
 
 static int _task_layout_lllp_block(launch_tasks_request_msg_t *req,
-				   uint32_t node_id, bitstr_t ***masks_p);
+				   uint32_t node_id, bitstr_t *avail_map,
+				   uint16_t hw_sockets, uint16_t hw_cores,
+				   uint16_t hw_threads, bitstr_t ***masks_p);
 static int _task_layout_lllp_cyclic(launch_tasks_request_msg_t *req,
-				    uint32_t node_id, bitstr_t ***masks_p);
+				    uint32_t node_id, bitstr_t *avail_map,
+				    uint16_t hw_sockets, uint16_t hw_cores,
+				    uint16_t hw_threads, bitstr_t ***masks_p);
 
 static void _lllp_map_abstract_masks(const uint32_t maxtasks,
 				     bitstr_t **masks);
@@ -72,6 +80,24 @@ static void _lllp_generate_cpu_bind(launch_tasks_request_msg_t *req,
 				    const uint32_t maxtasks,
 				    bitstr_t **masks);
 
+/*
+ * Bindings are cached by the shape of the launch: the CPUs available to the
+ * step on this node, the hardware counts and every request field read while
+ * laying out the masks. Later steps of the same shape reuse the resulting
+ * cpu_bind rather than laying out the masks again.
+ */
+#define BIND_CACHE_MAX 256
+
+typedef struct {
+	char *key;
+	uint16_t cpu_bind_type;
+	char *cpu_bind;
+	uint16_t cpus_per_task;
+} bind_cache_t;
+
+static pthread_mutex_t bind_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static xhash_t *bind_cache = NULL;
+
 /*     BLOCK_MAP     physical machine LLLP index to abstract block LLLP index
  *     BLOCK_MAP_INV physical abstract block LLLP index to machine LLLP index
  */
@@ -350,7 +376,7 @@ static void _validate_mask(launch_tasks_request_msg_t *req, char *avail_mask)
 }
 
 /*
- * lllp_distribution
+ * _lllp_distribution
  *
  * Note: lllp stands for Lowest Level of Logical Processors.
  *
@@ -364,8 +390,12 @@ static void _validate_mask(launch_tasks_request_msg_t *req, char *avail_mask)
  *
  * IN/OUT- job launch request (cpu_bind_type and cpu_bind updated)
  * IN- global task id array
+ * IN- avail_map and hardware counts from _get_avail_map()
  */
-void lllp_distribution(launch_tasks_request_msg_t *req, uint32_t node_id)
+static void _lllp_distribution(launch_tasks_request_msg_t *req,
+			       uint32_t node_id, bitstr_t *avail_map,
+			       uint16_t hw_sockets, uint16_t hw_cores,
+			       uint16_t hw_threads)
 {
 	int rc = SLURM_SUCCESS;
 	bitstr_t **masks = NULL;
@@ -399,7 +429,8 @@ void lllp_distribution(launch_tasks_request_msg_t *req, uint32_t node_id)
 
 	if (req->cpu_bind_type & bind_mode) {
 		/* Explicit step binding specified by user */
-		char *avail_mask = _alloc_mask(req,
+		char *avail_mask = _alloc_mask(req, avail_map, hw_sockets,
+					       hw_cores, hw_threads,
 					       &whole_nodes,  &whole_sockets,
 					       &whole_cores,  &whole_threads,
 					       &part_sockets, &part_cores);
@@ -437,7 +468,8 @@ void lllp_distribution(launch_tasks_request_msg_t *req, uint32_t node_id)
 		int spec_thread_cnt = 0;
 		int max_tasks = req->tasks_to_launch[(int)node_id] *
 			req->cpus_per_task;
-		char *avail_mask = _alloc_mask(req,
+		char *avail_mask = _alloc_mask(req, avail_map, hw_sockets,
+					       hw_cores, hw_threads,
 					       &whole_nodes,  &whole_sockets,
 					       &whole_cores,  &whole_threads,
 					       &part_sockets, &part_cores);
@@ -514,7 +546,9 @@ void lllp_distribution(launch_tasks_request_msg_t *req, uint32_t node_id)
 		debug2("JobId=%u will use lllp_block",
 		       req->step_id.job_id);
 		/* tasks are distributed in blocks within a plane */
-		rc = _task_layout_lllp_block(req, node_id, &masks);
+		rc = _task_layout_lllp_block(req, node_id, avail_map,
+					     hw_sockets, hw_cores, hw_threads,
+					     &masks);
 		break;
 	case SLURM_DIST_ARBITRARY:
 	case SLURM_DIST_BLOCK:
@@ -523,7 +557,9 @@ void lllp_distribution(launch_tasks_request_msg_t *req, uint32_t node_id)
 		if (slurm_conf.select_type_param & CR_CORE_DEFAULT_DIST_BLOCK) {
 			debug2("JobId=%u will use lllp_block because of SelectTypeParameters",
 			       req->step_id.job_id);
-			rc = _task_layout_lllp_block(req, node_id, &masks);
+			rc = _task_layout_lllp_block(req, node_id, avail_map,
+						     hw_sockets, hw_cores,
+						     hw_threads, &masks);
 			break;
 		}
 		/*
@@ -533,7 +569,9 @@ void lllp_distribution(launch_tasks_request_msg_t *req, uint32_t node_id)
 	default:
 		debug2("JobId=%u will use lllp_cyclic because of SelectTypeParameters",
 		       req->step_id.job_id);
-		rc = _task_layout_lllp_cyclic(req, node_id, &masks);
+		rc = _task_layout_lllp_cyclic(req, node_id, avail_map,
+					      hw_sockets, hw_cores, hw_threads,
+					      &masks);
 		break;
 	}
 
@@ -557,7 +595,8 @@ void lllp_distribution(launch_tasks_request_msg_t *req, uint32_t node_id)
 	    	 /* convert masks into cpu_bind mask string */
 		 _lllp_generate_cpu_bind(req, maxtasks, masks);
 	} else {
-		char *avail_mask = _alloc_mask(req,
+		char *avail_mask = _alloc_mask(req, avail_map, hw_sockets,
+					       hw_cores, hw_threads,
 					       &whole_nodes,  &whole_sockets,
 					       &whole_cores,  &whole_threads,
 					       &part_sockets, &part_cores);
@@ -576,6 +615,117 @@ void lllp_distribution(launch_tasks_request_msg_t *req, uint32_t node_id)
 		_lllp_free_masks(maxtasks, masks);
 }
 
+static void _bind_cache_id(void *item, const char **key, uint32_t *key_len)
+{
+	bind_cache_t *entry = item;
+
+	*key = entry->key;
+	*key_len = strlen(entry->key);
+}
+
+static void _bind_cache_free(void *item)
+{
+	bind_cache_t *entry = item;
+
+	xfree(entry->key);
+	xfree(entry->cpu_bind);
+	xfree(entry);
+}
+
+static char *_bind_cache_key(launch_tasks_request_msg_t *req,
+			     uint32_t node_id, bitstr_t *avail_map,
+			     uint16_t hw_sockets, uint16_t hw_cores,
+			     uint16_t hw_threads)
+{
+	char *mask = bit_fmt_hexmask(avail_map);
+	char *key = xstrdup_printf("%s:%u:%u:%u:%u:%s:%u:%u:%u:%u:%u:%u:%u:%u:%u",
+				   mask, hw_sockets, hw_cores, hw_threads,
+				   req->cpu_bind_type,
+				   req->cpu_bind ? req->cpu_bind : "",
+				   req->task_dist,
+				   req->tasks_to_launch[(int)node_id],
+				   req->cpus_per_task, req->job_core_spec,
+				   req->ntasks_per_core, req->ntasks_per_socket,
+				   req->threads_per_core,
+				   slurm_conf.task_plugin_param,
+				   slurm_conf.select_type_param);
+	xfree(mask);
+	return key;
+}
+
+/*
+ * lllp_distribution
+ *
+ * Set the cpu_bind type and string of a launch request, reusing the binding
+ * of an earlier step of the same shape when there is one.
+ *
+ * IN/OUT- job launch request (cpu_bind_type and cpu_bind updated)
+ * IN- index of this node in the launch request
+ */
+void lllp_distribution(launch_tasks_request_msg_t *req, uint32_t node_id)
+{
+	uint16_t hw_sockets, hw_cores, hw_threads;
+	bitstr_t *avail_map;
+	bind_cache_t *entry;
+	char *key = NULL, buf_type[100];
+
+	avail_map = _get_avail_map(req, &hw_sockets, &hw_cores, &hw_threads);
+	if (avail_map) {
+		key = _bind_cache_key(req, node_id, avail_map,
+				      hw_sockets, hw_cores, hw_threads);
+		slurm_mutex_lock(&bind_cache_mutex);
+		if ((entry = xhash_get_str(bind_cache, key))) {
+			req->cpu_bind_type = entry->cpu_bind_type;
+			xfree(req->cpu_bind);
+			req->cpu_bind = xstrdup(entry->cpu_bind);
+			req->cpus_per_task = entry->cpus_per_task;
+			slurm_mutex_unlock(&bind_cache_mutex);
+
+			slurm_sprint_cpu_bind_type(buf_type,
+						   req->cpu_bind_type);
+			info("JobId=%u cached binding: %s",
+			     req->step_id.job_id, buf_type);
+			goto fini;
+		}
+		slurm_mutex_unlock(&bind_cache_mutex);
+	}
+
+	_lllp_distribution(req, node_id, avail_map,
+			   hw_sockets, hw_cores, hw_threads);
+
+	if (key) {
+		entry = xmalloc(sizeof(*entry));
+		entry->key = key;
+		entry->cpu_bind_type = req->cpu_bind_type;
+		entry->cpu_bind = xstrdup(req->cpu_bind);
+		entry->cpus_per_task = req->cpus_per_task;
+		key = NULL;
+
+		slurm_mutex_lock(&bind_cache_mutex);
+		if (!bind_cache)
+			bind_cache = xhash_init(_bind_cache_id,
+						_bind_cache_free);
+		else if (xhash_count(bind_cache) >= BIND_CACHE_MAX)
+			xhash_clear(bind_cache);
+		if (xhash_get_str(bind_cache, entry->key))
+			_bind_cache_free(entry); /* added by another launch */
+		else
+			xhash_add(bind_cache, entry);
+		slurm_mutex_unlock(&bind_cache_mutex);
+	}
+
+fini:
+	xfree(key);
+	FREE_NULL_BITMAP(avail_map);
+}
+
+extern void lllp_distribution_fini(void)
+{
+	slurm_mutex_lock(&bind_cache_mutex);
+	xhash_free(bind_cache);
+	slurm_mutex_unlock(&bind_cache_mutex);
+}
+
 
 /*
  * _get_local_node_info - get job allocation details for this node
@@ -610,6 +760,8 @@ static int _get_local_node_info(slurm_cred_arg_t *arg, int job_node_id,
 
 /*
  * Determine which CPUs a job step can use.
+ * IN alloc_bitmap - return of _get_avail_map(), NULL is an error
+ * IN sockets, cores, threads - hardware counts from _get_avail_map()
  * OUT whole_<entity>_count - returns count of whole <entities> in this
  *                            allocation for this node
  * OUT part__<entity>_count - returns count of partial <entities> in this
@@ -618,14 +770,14 @@ static int _get_local_node_info(slurm_cred_arg_t *arg, int job_node_id,
  * NOTE: Caller must xfree() the return value.
  */
 static char *_alloc_mask(launch_tasks_request_msg_t *req,
+			 bitstr_t *alloc_bitmap, uint16_t sockets,
+			 uint16_t cores, uint16_t threads,
 			 int *whole_node_cnt,  int *whole_socket_cnt,
 			 int *whole_core_cnt,  int *whole_thread_cnt,
 			 int *part_socket_cnt, int *part_core_cnt)
 {
-	uint16_t sockets, cores, threads;
 	int c, s, t, i;
 	int c_miss, s_miss, t_miss, c_hit, t_hit;
-	bitstr_t *alloc_bitmap;
 	char *str_mask;
 	bitstr_t *alloc_mask;
 
@@ -636,7 +788,6 @@ static char *_alloc_mask(launch_tasks_request_msg_t *req,
 	*part_socket_cnt  = 0;
 	*part_core_cnt    = 0;
 
-	alloc_bitmap = _get_avail_map(req, &sockets, &cores, &threads);
 	if (!alloc_bitmap)
 		return NULL;
 
@@ -680,7 +831,6 @@ static char *_alloc_mask(launch_tasks_request_msg_t *req,
 	}
 	if (!s_miss)
 		(*whole_node_cnt)++;
-	FREE_NULL_BITMAP(alloc_bitmap);
 
 	if ((req->job_core_spec != NO_VAL16) &&
 	    (req->job_core_spec &  CORE_SPEC_THREAD)  &&
@@ -940,14 +1090,15 @@ static void _expand_masks(uint16_t cpu_bind_type, const uint32_t maxtasks,
  *
  */
 static int _task_layout_lllp_cyclic(launch_tasks_request_msg_t *req,
-				    uint32_t node_id, bitstr_t ***masks_p)
+				    uint32_t node_id, bitstr_t *avail_map,
+				    uint16_t hw_sockets, uint16_t hw_cores,
+				    uint16_t hw_threads, bitstr_t ***masks_p)
 {
 	int last_taskcount = -1, taskcount = 0;
-	uint16_t i, s, hw_sockets = 0, hw_cores = 0, hw_threads = 0;
+	uint16_t i, s;
 	uint16_t offset = 0, p = 0;
 	int size, max_tasks = req->tasks_to_launch[(int)node_id];
 	int max_cpus = max_tasks * req->cpus_per_task;
-	bitstr_t *avail_map;
 	bitstr_t **masks = NULL;
 	int *socket_last_pu = NULL;
 	int core_inx, pu_per_core, *core_tasks = NULL, *core_threads = NULL;
@@ -955,7 +1106,6 @@ static int _task_layout_lllp_cyclic(launch_tasks_request_msg_t *req,
 
 	info ("_task_layout_lllp_cyclic ");
 
-	avail_map = _get_avail_map(req, &hw_sockets, &hw_cores, &hw_threads);
 	if (!avail_map)
 		return SLURM_ERROR;
 
@@ -972,14 +1122,12 @@ static int _task_layout_lllp_cyclic(launch_tasks_request_msg_t *req,
 			      size,
 			      (req->cpus_per_task * (hw_threads /
 						     req_threads_per_core)));
-			FREE_NULL_BITMAP(avail_map);
 			return SLURM_ERROR;
 		}
 	}
 	if (size < max_tasks) {
 		error("only %d bits in avail_map for %d tasks!",
 		      size, max_tasks);
-		FREE_NULL_BITMAP(avail_map);
 		return SLURM_ERROR;
 	}
 	if (size < max_cpus) {
@@ -1005,7 +1153,6 @@ static int _task_layout_lllp_cyclic(launch_tasks_request_msg_t *req,
 	while (taskcount < max_tasks) {
 		if (taskcount == last_taskcount) {
 			error("_task_layout_lllp_cyclic failure");
-			FREE_NULL_BITMAP(avail_map);
 			xfree(core_tasks);
 			xfree(core_threads);
 			xfree(socket_last_pu);
@@ -1117,7 +1264,6 @@ static int _task_layout_lllp_cyclic(launch_tasks_request_msg_t *req,
 	 * to the requested resource */
 	_expand_masks(req->cpu_bind_type, max_tasks, masks,
 		      hw_sockets, hw_cores, hw_threads, avail_map);
-	FREE_NULL_BITMAP(avail_map);
 	xfree(core_tasks);
 	xfree(core_threads);
 	xfree(socket_last_pu);
@@ -1148,13 +1294,13 @@ static int _task_layout_lllp_cyclic(launch_tasks_request_msg_t *req,
  *
  */
 static int _task_layout_lllp_block(launch_tasks_request_msg_t *req,
-				   uint32_t node_id, bitstr_t ***masks_p)
+				   uint32_t node_id, bitstr_t *avail_map,
+				   uint16_t hw_sockets, uint16_t hw_cores,
+				   uint16_t hw_threads, bitstr_t ***masks_p)
 {
 	int c, i, size, last_taskcount = -1, taskcount = 0;
-	uint16_t hw_sockets = 0, hw_cores = 0, hw_threads = 0;
 	int max_tasks = req->tasks_to_launch[(int)node_id];
 	int max_cpus = max_tasks * req->cpus_per_task;
-	bitstr_t *avail_map;
 	bitstr_t **masks = NULL;
 	int core_inx, pu_per_core, *core_tasks = NULL, *core_threads = NULL;
 	int sock_inx, pu_per_socket, *socket_tasks = NULL;
@@ -1162,7 +1308,6 @@ static int _task_layout_lllp_block(launch_tasks_request_msg_t *req,
 
 	info("_task_layout_lllp_block ");
 
-	avail_map = _get_avail_map(req, &hw_sockets, &hw_cores, &hw_threads);
 	if (!avail_map) {
 		return SLURM_ERROR;
 	}
@@ -1180,14 +1325,12 @@ static int _task_layout_lllp_block(launch_tasks_request_msg_t *req,
 			      size,
 			      (req->cpus_per_task * (hw_threads /
 						     req_threads_per_core)));
-			FREE_NULL_BITMAP(avail_map);
 			return SLURM_ERROR;
 		}
 	}
 	if (size < max_tasks) {
 		error("only %d bits in avail_map for %d tasks!",
 		      size, max_tasks);
-		FREE_NULL_BITMAP(avail_map);
 		return SLURM_ERROR;
 	}
 	if (size < max_cpus) {
@@ -1213,7 +1356,6 @@ static int _task_layout_lllp_block(launch_tasks_request_msg_t *req,
 	while (taskcount < max_tasks) {
 		if (taskcount == last_taskcount) {
 			error("_task_layout_lllp_block infinite loop");
-			FREE_NULL_BITMAP(avail_map);
 			xfree(core_tasks);
 			xfree(core_threads);
 			xfree(socket_tasks);
@@ -1289,7 +1431,6 @@ static int _task_layout_lllp_block(launch_tasks_request_msg_t *req,
 	 * to the requested resource */
 	_expand_masks(req->cpu_bind_type, max_tasks, masks,
 			hw_sockets, hw_cores, hw_threads, avail_map);
-	FREE_NULL_BITMAP(avail_map);
 
 	return SLURM_SUCCESS;
 }
@@ -211,6 +211,29 @@ static int _handle_device_access(void *x, void *arg)
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Return true if the cgroup allows all devices but its deny exceptions,
+ * which is the case unless all were denied: devices.list then only shows
+ * "a *:* rwm". Writing devices.allow there only removes a deny exception,
+ * so the default allowed devices need not be written. GRES devices are
+ * still allowed and denied explicitly after them.
+ */
+static bool _cgroup_allows_all(xcgroup_t *devices_cg)
+{
+	char *list = NULL;
+	size_t size = 0;
+	bool rc;
+
+	if (xcgroup_get_param(devices_cg, "devices.list", &list, &size) !=
+	    XCGROUP_SUCCESS)
+		return false;
+	rc = (size >= 9) && !xstrncmp(list, "a *:* rwm", 9) &&
+	     ((size == 9) || !xstrcmp(list + 9, "\n"));
+	xfree(list);
+
+	return rc;
+}
+
 static int _cgroup_create_callback(const char *calling_func,
 				   xcgroup_ns_t *ns,
 				   void *callback_arg)
@@ -224,20 +247,31 @@ static int _cgroup_create_callback(const char *calling_func,
 	List device_list = NULL;
 	char *allowed_devices[PATH_MAX], *allowed_dev_major[PATH_MAX];
 	int k, rc, allow_lines = 0;
+	bool step_devices = ((job->step_id.step_id != SLURM_BATCH_SCRIPT) &&
+			     (job->step_id.step_id != SLURM_EXTERN_CONT) &&
+			     (job->step_id.step_id != SLURM_INTERACTIVE_STEP));
+	bool job_defaults = !_cgroup_allows_all(&job_devices_cg);
+	bool step_defaults = step_devices &&
+			     !_cgroup_allows_all(&step_devices_cg);
 
 	/*
          * create the entry with major minor for the default allowed devices
-         * read from the file
+         * read from the file, unless neither cgroup needs them
          */
-	allow_lines = _read_allowed_devices_file(allowed_devices);
-	_calc_device_major(allowed_devices, allowed_dev_major, allow_lines);
+	if (job_defaults || step_defaults) {
+		allow_lines = _read_allowed_devices_file(allowed_devices);
+		_calc_device_major(allowed_devices, allowed_dev_major,
+				   allow_lines);
+	} else
+		debug2("Devices allowed by default, skipping %s",
+		       cgroup_allowed_devices_file);
 
 	/*
 	 * with the current cgroup devices subsystem design (whitelist only
 	 * supported) we need to allow all different devices that are supposed
 	 * to be allowed by* default.
 	 */
-	for (k = 0; k < allow_lines; k++) {
+	for (k = 0; job_defaults && (k < allow_lines); k++) {
 		debug2("Default access allowed to device %s(%s) for job",
 		       allowed_dev_major[k], allowed_devices[k]);
 		xcgroup_set_param(&job_devices_cg, "devices.allow",
@@ -255,15 +289,13 @@ static int _cgroup_create_callback(const char *calling_func,
 		FREE_NULL_LIST(device_list);
 	}
 
-	if ((job->step_id.step_id != SLURM_BATCH_SCRIPT) &&
-	    (job->step_id.step_id != SLURM_EXTERN_CONT) &&
-	    (job->step_id.step_id != SLURM_INTERACTIVE_STEP)) {
+	if (step_devices) {
 		/*
 		 * with the current cgroup devices subsystem design (whitelist
 		 * only supported) we need to allow all different devices that
 		 * are supposed to be allowed by default.
 		 */
-		for (k = 0; k < allow_lines; k++) {
+		for (k = 0; step_defaults && (k < allow_lines); k++) {
 			debug2("Default access allowed to device %s(%s) for step",
 			       allowed_dev_major[k], allowed_devices[k]);
 			xcgroup_set_param(&step_devices_cg, "devices.allow",
@@ -274,6 +274,45 @@ static void _find_child_switches (int sw)
 	hostlist_destroy(swlist);
 }
 
+/* Return true if switch sw is below switch anc in the tree */
+static bool _is_desc_switch(int anc, int sw)
+{
+	int p;
+
+	for (p = switch_record_table[sw].parent; p != SWITCH_NO_PARENT;
+	     p = switch_record_table[p].parent) {
+		if (p == anc)
+			return true;
+	}
+	return false;
+}
+
+/*
+ * _find_desc_switches creates an array of indexes to all descendants of
+ * switch sw, so that subtrees can be walked without testing every switch.
+ */
+static void _find_desc_switches(int sw)
+{
+	switch_record_t *switch_ptr = &switch_record_table[sw];
+	int i;
+
+	for (i = 0; i < switch_record_cnt; i++) {
+		if (_is_desc_switch(sw, i))
+			switch_ptr->num_desc_switches++;
+	}
+	if (!switch_ptr->num_desc_switches)
+		return;
+
+	switch_ptr->switch_desc_index =
+		xcalloc(switch_ptr->num_desc_switches, sizeof(uint16_t));
+	switch_ptr->num_desc_switches = 0;
+	for (i = 0; i < switch_record_cnt; i++) {
+		if (_is_desc_switch(sw, i))
+			switch_ptr->switch_desc_index[
+				switch_ptr->num_desc_switches++] = i;
+	}
+}
+
 static void _validate_switches(void)
 {
 	slurm_conf_switches_t *ptr, **ptr_array;
@@ -311,6 +350,7 @@ static void _validate_switches(void)
 			}
 		}
 		switch_ptr->link_speed = ptr->link_speed;
+		switch_ptr->parent = SWITCH_NO_PARENT;
 		if (ptr->nodes) {
 			switch_ptr->level = 0;	/* leaf switch */
 			switch_ptr->nodes = xstrdup(ptr->nodes);
@@ -444,6 +484,9 @@ static void _validate_switches(void)
 		}
 	}
 
+	for (i = 0; i < switch_record_cnt; i++)
+		_find_desc_switches(i);
+
 	if (!have_root && running_in_daemon())
 		info("TOPOLOGY: warning -- no switch can reach all nodes through its descendants. If this is not intentional, fix the topology.conf file.");
 
@@ -493,6 +536,7 @@ static void _free_switch_record_table(void)
 			xfree(switch_record_table[i].name);
 			xfree(switch_record_table[i].nodes);
 			xfree(switch_record_table[i].switches);
+			xfree(switch_record_table[i].switch_desc_index);
 			xfree(switch_record_table[i].switch_index);
 			FREE_NULL_BITMAP(switch_record_table[i].node_bitmap);
 		}
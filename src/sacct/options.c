@@ -55,6 +55,7 @@
 #define OPT_LONG_FEDR      0x105
 #define OPT_LONG_WHETJOB   0x106
 #define OPT_LONG_LOCAL_UID 0x107
+#define OPT_LONG_MODIFIED  0x108
 
 #define JOB_HASH_SIZE 1000
 
@@ -403,6 +404,10 @@ sacct [<OPTION>]                                                            \n \
      -M, --clusters:                                                        \n\
                    Only send data about these clusters. Use \"all\" for all \n\
                    clusters.\n\
+     --modified:                                                            \n\
+                   Select jobs whose accounting record was modified         \n\
+                   between --starttime and --endtime, whatever their state. \n\
+                   Useful to refresh a copy of earlier results.             \n\
      -n, --noheader:                                                        \n\
 	           No header will be added to the beginning of output.      \n\
                    The default is to print a header.                        \n\
@@ -720,6 +725,7 @@ extern void parse_command_line(int argc, char **argv)
                 {"allclusters",    no_argument,       0,    'L'},
                 {"cluster",        required_argument, 0,    'M'},
                 {"clusters",       required_argument, 0,    'M'},
+                {"modified",       no_argument,       0,    OPT_LONG_MODIFIED},
                 {"nodelist",       required_argument, 0,    'N'},
                 {"noconvert",      no_argument,       0,    OPT_LONG_NOCONVERT},
                 {"units",          required_argument, 0,    OPT_LONG_UNITS},
@@ -895,6 +901,9 @@ extern void parse_command_line(int argc, char **argv)
 			params.opt_local = true;
 			all_clusters = false;
 			break;
+		case OPT_LONG_MODIFIED:
+			job_cond->flags |= JOBCOND_FLAG_MOD_TIME;
+			break;
 		case OPT_LONG_NOCONVERT:
 			params.convert_flags |= CONVERT_NUM_UNIT_NO;
 			break;
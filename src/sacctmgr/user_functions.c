@@ -694,9 +694,9 @@ extern int sacctmgr_add_user(int argc, char **argv)
 	List local_acct_list = NULL;
 	List local_user_list = NULL;
 	List local_wckey_list = NULL;
-	char *user_str = NULL;
-	char *assoc_str = NULL;
-	char *wckey_str = NULL;
+	char *user_str = NULL, *user_pos = NULL;
+	char *assoc_str = NULL, *assoc_pos = NULL;
+	char *wckey_str = NULL, *wckey_pos = NULL;
 	int limit_set = 0;
 	int first = 1;
 	int acct_first = 1;
@@ -884,8 +884,17 @@ extern int sacctmgr_add_user(int argc, char **argv)
 		       sizeof(slurmdb_assoc_cond_t));
 		query_assoc_cond.acct_list = assoc_cond->acct_list;
 		query_assoc_cond.cluster_list = assoc_cond->cluster_list;
+		/*
+		 * Only the associations of the users being added and of the
+		 * accounts themselves (user '') are looked at, so don't get
+		 * every other user of the accounts.
+		 */
+		query_assoc_cond.user_list =
+			list_shallow_copy(assoc_cond->user_list);
+		list_append(query_assoc_cond.user_list, "");
 		local_assoc_list = slurmdb_associations_get(
 			db_conn, &query_assoc_cond);
+		FREE_NULL_LIST(query_assoc_cond.user_list);
 
 		if (!local_assoc_list) {
 			xfree(default_acct);
@@ -1013,7 +1022,7 @@ extern int sacctmgr_add_user(int argc, char **argv)
 
 			user->admin_level = admin_level;
 
-			xstrfmtcat(user_str, "  %s\n", name);
+			xstrfmtcatat(user_str, &user_pos, "  %s\n", name);
 
 			list_append(user_list, user);
 		}
@@ -1107,14 +1116,14 @@ extern int sacctmgr_add_user(int argc, char **argv)
 							    assoc);
 					else
 						list_append(assoc_list, assoc);
-					xstrfmtcat(assoc_str,
-						   "  U = %-9.9s"
-						   " A = %-10.10s"
-						   " C = %-10.10s"
-						   " P = %-10.10s\n",
-						   assoc->user, assoc->acct,
-						   assoc->cluster,
-						   assoc->partition);
+					xstrfmtcatat(assoc_str, &assoc_pos,
+						     "  U = %-9.9s"
+						     " A = %-10.10s"
+						     " C = %-10.10s"
+						     " P = %-10.10s\n",
+						     assoc->user, assoc->acct,
+						     assoc->cluster,
+						     assoc->partition);
 				}
 				list_iterator_destroy(itr_p);
 				if (partition_set) {
@@ -1152,12 +1161,12 @@ extern int sacctmgr_add_user(int argc, char **argv)
 					list_append(user->assoc_list, assoc);
 				else
 					list_append(assoc_list, assoc);
-				xstrfmtcat(assoc_str,
-					   "  U = %-9.9s"
-					   " A = %-10.10s"
-					   " C = %-10.10s\n",
-					   assoc->user, assoc->acct,
-					   assoc->cluster);
+				xstrfmtcatat(assoc_str, &assoc_pos,
+					     "  U = %-9.9s"
+					     " A = %-10.10s"
+					     " C = %-10.10s\n",
+					     assoc->user, assoc->acct,
+					     assoc->cluster);
 				if (!default_acct && local_def_acct)
 					xfree(local_def_acct);
 			}
@@ -1207,12 +1216,12 @@ extern int sacctmgr_add_user(int argc, char **argv)
 					list_append(user->wckey_list, wckey);
 				else
 					list_append(wckey_list, wckey);
-				xstrfmtcat(wckey_str,
-					   "  U = %-9.9s"
-					   " W = %-10.10s"
-					   " C = %-10.10s\n",
-					   wckey->user, wckey->name,
-					   wckey->cluster);
+				xstrfmtcatat(wckey_str, &wckey_pos,
+					     "  U = %-9.9s"
+					     " W = %-10.10s"
+					     " C = %-10.10s\n",
+					     wckey->user, wckey->name,
+					     wckey->cluster);
 				if (!default_wckey && local_def_wckey)
 					xfree(local_def_wckey);
 			}
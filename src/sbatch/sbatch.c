@@ -39,6 +39,7 @@
 \*****************************************************************************/
 
 #include <fcntl.h>
+#include <poll.h>
 #include <pwd.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -60,6 +61,7 @@
 #include "src/common/proc_args.h"
 #include "src/common/read_config.h"
 #include "src/common/slurm_auth.h"
+#include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_rlimits_info.h"
 #include "src/common/xstring.h"
 #include "src/common/xmalloc.h"
@@ -68,6 +70,7 @@
 
 #define MAX_RETRIES 15
 #define MAX_WAIT_SLEEP_TIME 32
+#define MAX_WAIT_NOTIFY_TIME 300	/* poll this often if notified */
 
 static void  _add_bb_to_script(char **script_body, char *burst_buffer_file);
 static void  _env_merge_filter(job_desc_msg_t *desc);
@@ -405,6 +408,58 @@ static void  _add_bb_to_script(char **script_body, char *burst_buffer_file)
 }
 
 /* Wait for specified job ID to terminate, return it's exit code */
+/* Open the socket slurmctld sends the job end notification to */
+static int _wait_notify_open(uint16_t *port)
+{
+	slurm_addr_t addr;
+	uint16_t *ports;
+	int fd;
+
+	if ((ports = slurm_get_srun_port_range()))
+		fd = slurm_init_msg_engine_ports(ports);
+	else
+		fd = slurm_init_msg_engine_port(0);
+	if (fd < 0) {
+		debug("%s: slurm_init_msg_engine_port: %m", __func__);
+		return -1;
+	}
+	if (slurm_get_stream_addr(fd, &addr) < 0) {
+		debug("%s: slurm_get_stream_addr: %m", __func__);
+		close(fd);
+		return -1;
+	}
+	*port = slurm_get_port(&addr);
+
+	return fd;
+}
+
+/* Wait for slurmctld to tell us that the job ended, or for the timeout */
+static void _wait_notify(int listen_fd)
+{
+	struct pollfd pfd = { .fd = listen_fd, .events = POLLIN };
+	slurm_addr_t cli_addr;
+	slurm_msg_t msg;
+	uid_t uid;
+	int fd;
+
+	if (poll(&pfd, 1, MAX_WAIT_NOTIFY_TIME * 1000) <= 0)
+		return;
+	if ((fd = slurm_accept_msg_conn(listen_fd, &cli_addr)) < 0)
+		return;
+
+	slurm_msg_t_init(&msg);
+	if (!slurm_receive_msg(fd, &msg, 0)) {
+		uid = auth_g_get_uid(msg.auth_cred);
+		if ((uid != slurm_conf.slurm_user_id) && (uid != 0))
+			error("Security violation, slurm message from uid %u",
+			      uid);
+		else if (msg.msg_type == SRUN_JOB_COMPLETE)
+			slurm_send_rc_msg(&msg, SLURM_SUCCESS);
+	}
+	slurm_free_msg_members(&msg);
+	close(fd);
+}
+
 static int _job_wait(uint32_t job_id)
 {
 	slurm_job_info_t *job_ptr;
@@ -412,18 +467,36 @@ static int _job_wait(uint32_t job_id)
 	int ec = 0, ec2, i, rc;
 	int sleep_time = 2;
 	bool complete = false;
+	uint16_t port = 0;
+	int listen_fd;
+
+	/*
+	 * Have slurmctld push us the end of the job instead of polling it,
+	 * checking the job state after each registration and notification.
+	 * Fall back to polling if it can not.
+	 */
+	listen_fd = _wait_notify_open(&port);
 
 	while (!complete) {
+		if ((listen_fd >= 0) &&
+		    slurm_job_wait_register(&job_id, 1, port)) {
+			debug("Unable to register for job end notification, polling: %m");
+			close(listen_fd);
+			listen_fd = -1;
+		}
 		complete = true;
-		sleep(sleep_time);
-		/*
-		 * min_job_age is factored into this to ensure the job can't
-		 * run, complete quickly, and be purged from slurmctld before
-		 * we've woken up and queried the job again.
-		 */
-		if ((sleep_time < (slurm_conf.min_job_age / 2)) &&
-		    (sleep_time < MAX_WAIT_SLEEP_TIME))
-			sleep_time *= 4;
+		if (listen_fd < 0) {
+			sleep(sleep_time);
+			/*
+			 * min_job_age is factored into this to ensure the job
+			 * can't run, complete quickly, and be purged from
+			 * slurmctld before we've woken up and queried the job
+			 * again.
+			 */
+			if ((sleep_time < (slurm_conf.min_job_age / 2)) &&
+			    (sleep_time < MAX_WAIT_SLEEP_TIME))
+				sleep_time *= 4;
+		}
 
 		rc = slurm_load_job(&resp, job_id, SHOW_ALL);
 		if (rc == SLURM_SUCCESS) {
@@ -449,8 +522,14 @@ static int _job_wait(uint32_t job_id)
 			complete = false;
 			error("Currently unable to load job state information, retrying: %m");
 		}
+
+		if (!complete && (listen_fd >= 0))
+			_wait_notify(listen_fd);
 	}
 
+	if (listen_fd >= 0)
+		close(listen_fd);
+
 	return ec;
 }
 
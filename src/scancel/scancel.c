@@ -62,11 +62,14 @@
 #include "src/scancel/scancel.h"
 
 #define MAX_CANCEL_RETRY 10
+#define MAX_JOBS_PER_RPC 500
 #define MAX_THREADS 10
 
 static void  _add_delay(void);
 static int   _cancel_jobs(void);
 static void *_cancel_job_id (void *cancel_info);
+static void  _flush_job_list(int *rc);
+static void  _queue_cancel_job_id(char *job_id_str, int *rc);
 static void *_cancel_step_id (void *cancel_info);
 static int  _confirmation(job_info_t *job_ptr, uint32_t step_id);
 static void _filter_job_records(void);
@@ -82,6 +85,7 @@ typedef struct job_cancel_info {
 	uint32_t array_job_id;
 	uint32_t array_task_id;
 	bool     array_flag;
+	bool     list_flag;	/* job_id_str is a space separated list */
 /* Note: Either set job_id_str OR job_id */
 	char *   job_id_str;
 	uint32_t job_id;
@@ -99,6 +103,9 @@ static	pthread_cond_t   num_active_threads_cond;
 static	pthread_mutex_t  max_delay_lock;
 static	uint32_t max_resp_time = 0;
 static	int request_count = 0;
+static	char *job_list_str = NULL;	/* jobs to signal with one RPC */
+static	char *job_list_pos = NULL;
+static	int job_list_cnt = 0;
 opt_t opt;
 
 int
@@ -502,31 +509,30 @@ static void _cancel_jobid_by_state(uint32_t job_state, int *rc)
 				continue;
 			}
 
-			slurm_mutex_lock(&num_active_threads_lock);
-			num_active_threads++;
-			while (num_active_threads > MAX_THREADS) {
-				slurm_cond_wait(&num_active_threads_cond,
+			if (opt.step_id[j] == SLURM_BATCH_SCRIPT) {
+				_queue_cancel_job_id(_build_jobid_str(job_ptr),
+						     rc);
+				job_ptr->job_id = 0;
+			} else {
+				slurm_mutex_lock(&num_active_threads_lock);
+				num_active_threads++;
+				while (num_active_threads > MAX_THREADS) {
+					slurm_cond_wait(
+						&num_active_threads_cond,
 						&num_active_threads_lock);
-			}
-			slurm_mutex_unlock(&num_active_threads_lock);
+				}
+				slurm_mutex_unlock(&num_active_threads_lock);
 
-			cancel_info = (job_cancel_info_t *)
-				      xmalloc(sizeof(job_cancel_info_t));
-			cancel_info->rc      = rc;
-			cancel_info->sig     = opt.signal;
-			cancel_info->num_active_threads = &num_active_threads;
-			cancel_info->num_active_threads_lock =
+				cancel_info = (job_cancel_info_t *)
+					xmalloc(sizeof(job_cancel_info_t));
+				cancel_info->rc      = rc;
+				cancel_info->sig     = opt.signal;
+				cancel_info->num_active_threads =
+					&num_active_threads;
+				cancel_info->num_active_threads_lock =
 					&num_active_threads_lock;
-			cancel_info->num_active_threads_cond =
+				cancel_info->num_active_threads_cond =
 					&num_active_threads_cond;
-			if (opt.step_id[j] == SLURM_BATCH_SCRIPT) {
-				cancel_info->job_id_str =
-					_build_jobid_str(job_ptr);
-				slurm_thread_create_detached(NULL,
-							     _cancel_job_id,
-							     cancel_info);
-				job_ptr->job_id = 0;
-			} else {
 				cancel_info->job_id = job_ptr->job_id;
 				cancel_info->step_id = opt.step_id[j];
 				slurm_thread_create_detached(NULL,
@@ -552,7 +558,6 @@ static void
 _cancel_jobs_by_state(uint32_t job_state, int *rc)
 {
 	int i;
-	job_cancel_info_t *cancel_info;
 	job_info_t *job_ptr = job_buffer_ptr->job_array;
 
 	/* Spawn a thread to cancel each job or job step marked for
@@ -578,26 +583,7 @@ _cancel_jobs_by_state(uint32_t job_state, int *rc)
 			continue;
 		}
 
-		cancel_info = (job_cancel_info_t *)
-			xmalloc(sizeof(job_cancel_info_t));
-		cancel_info->job_id_str = _build_jobid_str(job_ptr);
-		cancel_info->rc      = rc;
-		cancel_info->sig     = opt.signal;
-		cancel_info->num_active_threads = &num_active_threads;
-		cancel_info->num_active_threads_lock =
-			&num_active_threads_lock;
-		cancel_info->num_active_threads_cond =
-			&num_active_threads_cond;
-
-		slurm_mutex_lock(&num_active_threads_lock);
-		num_active_threads++;
-		while (num_active_threads > MAX_THREADS) {
-			slurm_cond_wait(&num_active_threads_cond,
-					&num_active_threads_lock);
-		}
-		slurm_mutex_unlock(&num_active_threads_lock);
-
-		slurm_thread_create_detached(NULL, _cancel_job_id, cancel_info);
+		_queue_cancel_job_id(_build_jobid_str(job_ptr), rc);
 		job_ptr->job_id = 0;
 
 		if (opt.interactive) {
@@ -622,6 +608,7 @@ static int _cancel_jobs(void)
 	slurm_cond_init(&num_active_threads_cond, NULL);
 
 	_cancel_jobs_by_state(JOB_PENDING, &rc);
+	_flush_job_list(&rc);
 	/* Wait for any cancel of pending jobs to complete before starting
 	 * cancellation of running jobs so that we don't have a race condition
 	 * with pending jobs getting scheduled while running jobs are also
@@ -634,6 +621,7 @@ static int _cancel_jobs(void)
 	slurm_mutex_unlock(&num_active_threads_lock);
 
 	_cancel_jobs_by_state(JOB_END, &rc);
+	_flush_job_list(&rc);
 	/* Wait for any spawned threads that have not finished */
 	slurm_mutex_lock( &num_active_threads_lock );
 	while (num_active_threads > 0) {
@@ -683,15 +671,124 @@ static void _add_delay(void)
 	return;
 }
 
+/* Spawn a thread to signal the job(s) of job_id_str, which it frees */
+static void _spawn_cancel_job_id(char *job_id_str, bool list_flag, int *rc)
+{
+	job_cancel_info_t *cancel_info;
+
+	cancel_info = (job_cancel_info_t *)
+		xmalloc(sizeof(job_cancel_info_t));
+	cancel_info->job_id_str = job_id_str;
+	cancel_info->list_flag = list_flag;
+	cancel_info->rc      = rc;
+	cancel_info->sig     = opt.signal;
+	cancel_info->num_active_threads = &num_active_threads;
+	cancel_info->num_active_threads_lock = &num_active_threads_lock;
+	cancel_info->num_active_threads_cond = &num_active_threads_cond;
+
+	slurm_mutex_lock(&num_active_threads_lock);
+	num_active_threads++;
+	while (num_active_threads > MAX_THREADS) {
+		slurm_cond_wait(&num_active_threads_cond,
+				&num_active_threads_lock);
+	}
+	slurm_mutex_unlock(&num_active_threads_lock);
+
+	slurm_thread_create_detached(NULL, _cancel_job_id, cancel_info);
+}
+
+/* Signal the jobs queued by _queue_cancel_job_id() */
+static void _flush_job_list(int *rc)
+{
+	if (!job_list_cnt)
+		return;
+
+	_spawn_cancel_job_id(job_list_str, (job_list_cnt > 1), rc);
+	job_list_str = job_list_pos = NULL;
+	job_list_cnt = 0;
+}
+
+/*
+ * Signal the job(s) of job_id_str, which is consumed. Unless each job must be
+ * confirmed or a sibling is given, the jobs are queued and signaled up to
+ * MAX_JOBS_PER_RPC at a time with one RPC, which slurmctld processes under
+ * one lock. Call _flush_job_list() to signal the remaining jobs.
+ */
+static void _queue_cancel_job_id(char *job_id_str, int *rc)
+{
+	if (opt.interactive || opt.sibling) {
+		_spawn_cancel_job_id(job_id_str, false, rc);
+		return;
+	}
+
+	xstrfmtcatat(job_list_str, &job_list_pos, "%s%s",
+		     job_list_cnt ? " " : "", job_id_str);
+	xfree(job_id_str);
+	if (++job_list_cnt >= MAX_JOBS_PER_RPC)
+		_flush_job_list(rc);
+}
+
+/* Send the kill RPC, retrying while jobs are in a transitional state */
+static int _kill_job_str(char *job_id_str, uint16_t sig, uint16_t flags)
+{
+	int error_code = SLURM_SUCCESS, i;
+	DEF_TIMERS;
+
+	for (i = 0; i < MAX_CANCEL_RETRY; i++) {
+		_add_delay();
+		START_TIMER;
+
+		error_code = slurm_kill_job2(job_id_str, sig, flags,
+					     opt.sibling);
+
+		END_TIMER;
+		slurm_mutex_lock(&max_delay_lock);
+		max_resp_time = MAX(max_resp_time, DELTA_TIMER);
+		slurm_mutex_unlock(&max_delay_lock);
+
+		if ((error_code == 0) ||
+		    (errno != ESLURM_TRANSITION_STATE_NO_UPDATE))
+			break;
+		verbose("Job is in transitional state, retrying");
+		sleep(5 + i);
+	}
+	if (error_code)
+		error_code = slurm_get_errno();
+
+	return error_code;
+}
+
+/* Report the error of signaling job_id_str, RET the error to exit with */
+static int _kill_job_error(char *job_id_str, uint16_t sig, int error_code)
+{
+	if (!error_code)
+		return error_code;
+
+	if ((opt.verbose > 0) ||
+	    ((error_code != ESLURM_ALREADY_DONE) &&
+	     (error_code != ESLURM_INVALID_JOB_ID) &&
+	     ((error_code != ESLURM_NOT_WHOLE_HET_JOB) ||
+	      (opt.job_cnt != 0)))) {
+		error("Kill job error on job id %s: %s",
+		      job_id_str, slurm_strerror(error_code));
+	}
+	if (((error_code == ESLURM_ALREADY_DONE) ||
+	     (error_code == ESLURM_INVALID_JOB_ID)) &&
+	    (sig == SIGKILL)) {
+		error_code = 0;	/* Ignore error if job done */
+	}
+
+	return error_code;
+}
+
 static void *
 _cancel_job_id (void *ci)
 {
-	int error_code = SLURM_SUCCESS, i;
+	int error_code = SLURM_SUCCESS;
 	job_cancel_info_t *cancel_info = (job_cancel_info_t *)ci;
 	bool sig_set = true;
 	uint16_t flags = 0;
 	char *job_type = "";
-	DEF_TIMERS;
 
 	if (cancel_info->sig == NO_VAL16) {
 		cancel_info->sig = SIGKILL;
@@ -733,41 +830,31 @@ _cancel_job_id (void *ci)
 			cancel_info->job_id_str);
 	}
 
-	for (i = 0; i < MAX_CANCEL_RETRY; i++) {
-		_add_delay();
-		START_TIMER;
-
-		error_code = slurm_kill_job2(cancel_info->job_id_str,
-					     cancel_info->sig, flags,
-					     opt.sibling);
-
-		END_TIMER;
-		slurm_mutex_lock(&max_delay_lock);
-		max_resp_time = MAX(max_resp_time, DELTA_TIMER);
-		slurm_mutex_unlock(&max_delay_lock);
-
-		if ((error_code == 0) ||
-		    (errno != ESLURM_TRANSITION_STATE_NO_UPDATE))
-			break;
-		verbose("Job is in transitional state, retrying");
-		sleep(5 + i);
+	if (cancel_info->list_flag) {
+		error_code = _kill_job_str(cancel_info->job_id_str,
+					   cancel_info->sig,
+					   flags | KILL_JOB_LIST);
+	} else {
+		error_code = _kill_job_str(cancel_info->job_id_str,
+					   cancel_info->sig, flags);
 	}
-	if (error_code) {
-		error_code = slurm_get_errno();
-		if ((opt.verbose > 0) ||
-		    ((error_code != ESLURM_ALREADY_DONE) &&
-		     (error_code != ESLURM_INVALID_JOB_ID) &&
-		     ((error_code != ESLURM_NOT_WHOLE_HET_JOB) ||
-		      (opt.job_cnt != 0)))) {
-			error("Kill job error on job id %s: %s",
-			      cancel_info->job_id_str,
-			      slurm_strerror(slurm_get_errno()));
+
+	if (cancel_info->list_flag && (error_code == ESLURM_NOT_SUPPORTED)) {
+		/* Federated cluster, signal the jobs one at a time */
+		char *tok, *save_ptr = NULL;
+		int rc;
+
+		error_code = SLURM_SUCCESS;
+		tok = strtok_r(cancel_info->job_id_str, " ", &save_ptr);
+		while (tok) {
+			rc = _kill_job_str(tok, cancel_info->sig, flags);
+			rc = _kill_job_error(tok, cancel_info->sig, rc);
+			error_code = MAX(error_code, rc);
+			tok = strtok_r(NULL, " ", &save_ptr);
 		}
-		if (((error_code == ESLURM_ALREADY_DONE) ||
-		     (error_code == ESLURM_INVALID_JOB_ID)) &&
-		    (cancel_info->sig == SIGKILL)) {
-			error_code = 0;	/* Ignore error if job done */
-		}	
+	} else {
+		error_code = _kill_job_error(cancel_info->job_id_str,
+					     cancel_info->sig, error_code);
 	}
 
 	/* Purposely free the struct passed in here, so the caller doesn't have
@@ -903,34 +990,14 @@ _confirmation(job_info_t *job_ptr, uint32_t step_id)
 
 static int _signal_job_by_str(void)
 {
-	job_cancel_info_t *cancel_info;
 	int i, rc = 0;
 
 	slurm_mutex_init(&num_active_threads_lock);
 	slurm_cond_init(&num_active_threads_cond, NULL);
 
-	for (i = 0; opt.job_list[i]; i++) {
-		cancel_info = (job_cancel_info_t *)
-			xmalloc(sizeof(job_cancel_info_t));
-		cancel_info->job_id_str = xstrdup(opt.job_list[i]);
-		cancel_info->rc      = &rc;
-		cancel_info->sig     = opt.signal;
-		cancel_info->num_active_threads = &num_active_threads;
-		cancel_info->num_active_threads_lock =
-			&num_active_threads_lock;
-		cancel_info->num_active_threads_cond =
-			&num_active_threads_cond;
-
-		slurm_mutex_lock(&num_active_threads_lock);
-		num_active_threads++;
-		while (num_active_threads > MAX_THREADS) {
-			slurm_cond_wait(&num_active_threads_cond,
-					&num_active_threads_lock);
-		}
-		slurm_mutex_unlock(&num_active_threads_lock);
-
-		slurm_thread_create_detached(NULL, _cancel_job_id, cancel_info);
-	}
+	for (i = 0; opt.job_list[i]; i++)
+		_queue_cancel_job_id(xstrdup(opt.job_list[i]), &rc);
+	_flush_job_list(&rc);
 
 	/* Wait all spawned threads to finish */
 	slurm_mutex_lock( &num_active_threads_lock );
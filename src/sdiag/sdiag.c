@@ -58,6 +58,9 @@ struct sdiag_parameters params;
 stats_info_response_msg_t *buf;
 uint32_t *rpc_type_ave_time = NULL, *rpc_user_ave_time = NULL;
 
+static void _print_job_launch(void);
+static void _print_lock_stats(void);
+static void _print_rpc_latency(void);
 static int  _print_stats(void);
 static void _sort_rpc(void);
 
@@ -72,7 +75,19 @@ int main(int argc, char **argv)
 	slurm_conf_init(NULL);
 	parse_command_line(argc, argv);
 
-	if (params.mode == STAT_COMMAND_RESET) {
+	if (params.profile) {
+		char *folded = NULL;
+
+		rc = slurm_get_ctld_profile(&folded);
+		if (rc != SLURM_SUCCESS)
+			slurm_perror("slurm_get_ctld_profile");
+		else if (folded)
+			printf("%s", folded);
+		else
+			printf("No stack samples, set DebugFlags=StackSample "
+			       "to collect them\n");
+		xfree(folded);
+	} else if (params.mode == STAT_COMMAND_RESET) {
 		req.command_id = STAT_COMMAND_RESET;
 		rc = slurm_reset_statistics((stats_info_request_msg_t *)&req);
 		if (rc == SLURM_SUCCESS)
@@ -192,19 +207,46 @@ static int _print_stats(void)
 		printf("\tMean table size: %u\n",
 		       buf->bf_table_size_sum / buf->bf_cycle_counter);
 	}
+	printf("\tLast cycle phases: queue:%"PRIu64" running:%"PRIu64
+	       " resv:%"PRIu64" sched:%"PRIu64" yield:%"PRIu64"\n",
+	       buf->bf_phase_queue_last, buf->bf_phase_running_last,
+	       buf->bf_phase_resv_last, buf->bf_phase_sched_last,
+	       buf->bf_phase_yield_last);
+	if (buf->bf_cycle_counter > 0) {
+		uint32_t cnt = buf->bf_cycle_counter;
+
+		printf("\tMean cycle phases: queue:%"PRIu64" running:%"PRIu64
+		       " resv:%"PRIu64" sched:%"PRIu64" yield:%"PRIu64"\n",
+		       buf->bf_phase_queue_sum / cnt,
+		       buf->bf_phase_running_sum / cnt,
+		       buf->bf_phase_resv_sum / cnt,
+		       buf->bf_phase_sched_sum / cnt,
+		       buf->bf_phase_yield_sum / cnt);
+	}
+
+	_print_job_launch();
 
 	printf("\nLatency for 1000 calls to gettimeofday(): %d microseconds\n",
 	       buf->gettimeofday_latency);
 
 	printf("\nRemote Procedure Call statistics by message type\n");
 	for (i = 0; i < buf->rpc_type_size; i++) {
+		uint64_t ave_auth = 0;
+
+		if (buf->rpc_type_cnt[i])
+			ave_auth = buf->rpc_type_auth_time[i] /
+				   buf->rpc_type_cnt[i];
 		printf("\t%-40s(%5u) count:%-6u "
-		       "ave_time:%-6u total_time:%"PRIu64"\n",
+		       "ave_time:%-6u total_time:%-10"PRIu64" "
+		       "ave_auth_time:%"PRIu64"\n",
 		       rpc_num2string(buf->rpc_type_id[i]),
 		       buf->rpc_type_id[i], buf->rpc_type_cnt[i],
-		       rpc_type_ave_time[i], buf->rpc_type_time[i]);
+		       rpc_type_ave_time[i], buf->rpc_type_time[i],
+		       ave_auth);
 	}
 
+	_print_rpc_latency();
+
 	printf("\nRemote Procedure Call statistics by user\n");
 	for (i = 0; i < buf->rpc_user_size; i++) {
 		char *user = uid_to_string_or_null(buf->rpc_user_id[i]);
@@ -240,18 +282,256 @@ static int _print_stats(void)
 		       buf->rpc_dump_hostlist[i]);
 	}
 
+	_print_lock_stats();
+
 	return 0;
 }
 
+static const char *lock_entity_names[] = {
+	"conf", "job", "node", "part", "fed"
+};
+
+static const char *_lock_entity_name(int inx)
+{
+	if (inx < ARRAY_SIZE(lock_entity_names))
+		return lock_entity_names[inx];
+	return "unknown";
+}
+
+static void _print_lock_hist(char *title, uint32_t *hist)
+{
+	int i, j;
+	uint64_t limit;
+
+	printf("\n%s\n\t%-6s", title, "");
+	for (j = 0, limit = 10; j < buf->lock_hist_size; j++, limit *= 10) {
+		char label[32];
+		uint64_t val = limit;
+		char *unit = "us";
+
+		if (j == (buf->lock_hist_size - 1))
+			val /= 10;
+		if (val >= USEC_IN_SEC) {
+			val /= USEC_IN_SEC;
+			unit = "s";
+		} else if (val >= 1000) {
+			val /= 1000;
+			unit = "ms";
+		}
+		snprintf(label, sizeof(label), "%s%"PRIu64"%s",
+			 (j == (buf->lock_hist_size - 1)) ? ">=" : "<",
+			 val, unit);
+		printf(" %10s", label);
+	}
+	printf("\n");
+
+	for (i = 0; i < buf->lock_entity_count; i++) {
+		printf("\t%-6s", _lock_entity_name(i));
+		for (j = 0; j < buf->lock_hist_size; j++)
+			printf(" %10u", hist[(i * buf->lock_hist_size) + j]);
+		printf("\n");
+	}
+}
+
+/*
+ * Return the upper bound in msec of the histogram bucket holding the given
+ * percentile of batch job launches for stage inx
+ */
+static uint64_t _launch_percentile(uint32_t inx, uint32_t cnt, uint32_t pct)
+{
+	uint32_t *hist = buf->job_launch_hist + (inx * buf->job_launch_hist_size);
+	uint64_t sum = 0, target;
+	uint32_t i;
+
+	target = (((uint64_t) cnt * pct) + 99) / 100;
+	for (i = 0; i < (buf->job_launch_hist_size - 1); i++) {
+		sum += hist[i];
+		if (sum >= target)
+			break;
+	}
+	if (i == (buf->job_launch_hist_size - 1))
+		return buf->job_launch_max[inx];
+	return MIN((uint64_t) 2 << i, buf->job_launch_max[inx]);
+}
+
+static void _print_job_launch(void)
+{
+	uint32_t i, j;
+
+	if (!buf->job_launch_stage_cnt || !buf->job_launch_hist_size)
+		return;
+
+	printf("\nBatch job launch latency (milliseconds)\n");
+	for (i = 0; i < buf->job_launch_stage_cnt; i++) {
+		uint32_t *hist = buf->job_launch_hist +
+				 (i * buf->job_launch_hist_size);
+		uint32_t cnt = 0;
+
+		for (j = 0; j < buf->job_launch_hist_size; j++)
+			cnt += hist[j];
+		if (!cnt)
+			continue;
+		printf("\t%-12s count:%-6u mean:%-8"PRIu64" p50:%-8"PRIu64
+		       " p99:%-8"PRIu64" max:%-8"PRIu64" max_node:%s\n",
+		       (i == JOB_LAUNCH_ALLOC) ?
+		       "Total" : job_launch_stage_string(i),
+		       cnt, buf->job_launch_sum[i] / cnt,
+		       _launch_percentile(i, cnt, 50),
+		       _launch_percentile(i, cnt, 99),
+		       buf->job_launch_max[i],
+		       buf->job_launch_max_node[i] ?
+		       buf->job_launch_max_node[i] : "N/A");
+	}
+}
+
+/*
+ * Return the upper bound in usec of the histogram bucket holding the given
+ * percentile of RPCs of type inx
+ */
+static uint64_t _rpc_percentile(uint32_t inx, uint32_t pct)
+{
+	uint32_t *hist = buf->rpc_type_hist + (inx * buf->rpc_hist_size);
+	uint64_t sum = 0, target;
+	uint32_t i;
+
+	target = (((uint64_t) buf->rpc_type_cnt[inx] * pct) + 99) / 100;
+	for (i = 0; i < (buf->rpc_hist_size - 1); i++) {
+		sum += hist[i];
+		if (sum >= target)
+			break;
+	}
+	if (i == (buf->rpc_hist_size - 1))
+		return buf->rpc_type_max_time[inx];
+	return MIN((uint64_t) 2 << i, buf->rpc_type_max_time[inx]);
+}
+
+static void _print_rpc_latency(void)
+{
+	uint32_t i;
+
+	if (!buf->rpc_hist_size)
+		return;
+
+	printf("\nRemote Procedure Call latency by message type "
+	       "(microseconds)\n");
+	for (i = 0; i < buf->rpc_type_size; i++) {
+		uint32_t cnt = buf->rpc_type_cnt[i];
+		uint64_t ave_lock;
+
+		if (!cnt)
+			continue;
+		ave_lock = buf->rpc_type_lock_time[i] / cnt;
+		printf("\t%-40s(%5u) ave_lock_wait:%-8"PRIu64
+		       " ave_process:%-8"PRIu64" p50:%-8"PRIu64
+		       " p99:%-8"PRIu64" max:%"PRIu64"\n",
+		       rpc_num2string(buf->rpc_type_id[i]),
+		       buf->rpc_type_id[i], ave_lock,
+		       (rpc_type_ave_time[i] > ave_lock) ?
+		       (rpc_type_ave_time[i] - ave_lock) : 0,
+		       _rpc_percentile(i, 50), _rpc_percentile(i, 99),
+		       buf->rpc_type_max_time[i]);
+	}
+}
+
+/* Print lock statistics with callers in order of total lock hold time */
+static void _print_lock_stats(void)
+{
+	uint32_t i, j, k, inx, *order;
+	uint64_t *hold_sum;
+
+	if (!buf->lock_entity_count)
+		return;
+
+	_print_lock_hist("Lock wait time histogram", buf->lock_wait_hist);
+	_print_lock_hist("Lock hold time histogram", buf->lock_hold_hist);
+
+	if (!buf->lock_caller_count)
+		return;
+
+	order = xcalloc(buf->lock_caller_count, sizeof(uint32_t));
+	hold_sum = xcalloc(buf->lock_caller_count, sizeof(uint64_t));
+	for (i = 0; i < buf->lock_caller_count; i++) {
+		order[i] = i;
+		for (j = 0; j < buf->lock_entity_count; j++) {
+			hold_sum[i] += buf->lock_caller_hold[
+				(i * buf->lock_entity_count) + j];
+		}
+	}
+	for (i = 0; i < buf->lock_caller_count; i++) {
+		for (j = i + 1; j < buf->lock_caller_count; j++) {
+			if (hold_sum[order[i]] >= hold_sum[order[j]])
+				continue;
+			k = order[i];
+			order[i] = order[j];
+			order[j] = k;
+		}
+	}
+
+	printf("\nLock statistics by caller (microseconds)\n");
+	for (i = 0; i < buf->lock_caller_count; i++) {
+		for (j = 0; j < buf->lock_entity_count; j++) {
+			uint32_t cnt;
+
+			inx = (order[i] * buf->lock_entity_count) + j;
+			if (!(cnt = buf->lock_caller_cnt[inx]))
+				continue;
+			printf("\t%-40s %-4s count:%-8u ave_wait:%-8"PRIu64
+			       " max_wait:%-10"PRIu64" ave_hold:%-8"PRIu64
+			       " max_hold:%-10"PRIu64"\n",
+			       buf->lock_caller_name[order[i]],
+			       _lock_entity_name(j), cnt,
+			       buf->lock_caller_wait[inx] / cnt,
+			       buf->lock_caller_wait_max[inx],
+			       buf->lock_caller_hold[inx] / cnt,
+			       buf->lock_caller_hold_max[inx]);
+		}
+	}
+
+	xfree(order);
+	xfree(hold_sum);
+}
+
+/* Swap the latency statistics of RPC types i and j */
+static void _swap_rpc_latency(int i, int j)
+{
+	uint64_t tmp64;
+	uint32_t tmp32, *hist_i, *hist_j;
+
+	tmp64 = buf->rpc_type_lock_time[i];
+	buf->rpc_type_lock_time[i] = buf->rpc_type_lock_time[j];
+	buf->rpc_type_lock_time[j] = tmp64;
+	tmp64 = buf->rpc_type_max_time[i];
+	buf->rpc_type_max_time[i] = buf->rpc_type_max_time[j];
+	buf->rpc_type_max_time[j] = tmp64;
+
+	hist_i = buf->rpc_type_hist + (i * buf->rpc_hist_size);
+	hist_j = buf->rpc_type_hist + (j * buf->rpc_hist_size);
+	for (int k = 0; k < buf->rpc_hist_size; k++) {
+		tmp32 = hist_i[k];
+		hist_i[k] = hist_j[k];
+		hist_j[k] = tmp32;
+	}
+}
+
 static void _sort_rpc(void)
 {
 	int i, j;
 	uint16_t type_id;
 	uint32_t type_ave, type_cnt, user_ave, user_cnt, user_id;
-	uint64_t type_time, user_time;
+	uint64_t type_auth, type_time, user_time;
 
 	rpc_type_ave_time = xmalloc(sizeof(uint32_t) * buf->rpc_type_size);
 	rpc_user_ave_time = xmalloc(sizeof(uint32_t) * buf->rpc_user_size);
+	/* Not reported by older slurmctld */
+	if (!buf->rpc_type_auth_time)
+		buf->rpc_type_auth_time = xcalloc(buf->rpc_type_size,
+						  sizeof(uint64_t));
+	if (!buf->rpc_type_lock_time)
+		buf->rpc_type_lock_time = xcalloc(buf->rpc_type_size,
+						  sizeof(uint64_t));
+	if (!buf->rpc_type_max_time)
+		buf->rpc_type_max_time = xcalloc(buf->rpc_type_size,
+						 sizeof(uint64_t));
 
 	if (params.sort == SORT_ID) {
 		for (i = 0; i < buf->rpc_type_size; i++) {
@@ -261,12 +541,17 @@ static void _sort_rpc(void)
 				type_id   = buf->rpc_type_id[i];
 				type_cnt  = buf->rpc_type_cnt[i];
 				type_time = buf->rpc_type_time[i];
+				type_auth = buf->rpc_type_auth_time[i];
 				buf->rpc_type_id[i]   = buf->rpc_type_id[j];
 				buf->rpc_type_cnt[i]  = buf->rpc_type_cnt[j];
 				buf->rpc_type_time[i] = buf->rpc_type_time[j];
+				buf->rpc_type_auth_time[i] =
+					buf->rpc_type_auth_time[j];
 				buf->rpc_type_id[j]   = type_id;
 				buf->rpc_type_cnt[j]  = type_cnt;
 				buf->rpc_type_time[j] = type_time;
+				buf->rpc_type_auth_time[j] = type_auth;
+				_swap_rpc_latency(i, j);
 			}
 			if (buf->rpc_type_cnt[i]) {
 				rpc_type_ave_time[i] = buf->rpc_type_time[i] /
@@ -300,12 +585,17 @@ static void _sort_rpc(void)
 				type_id   = buf->rpc_type_id[i];
 				type_cnt  = buf->rpc_type_cnt[i];
 				type_time = buf->rpc_type_time[i];
+				type_auth = buf->rpc_type_auth_time[i];
 				buf->rpc_type_id[i]   = buf->rpc_type_id[j];
 				buf->rpc_type_cnt[i]  = buf->rpc_type_cnt[j];
 				buf->rpc_type_time[i] = buf->rpc_type_time[j];
+				buf->rpc_type_auth_time[i] =
+					buf->rpc_type_auth_time[j];
 				buf->rpc_type_id[j]   = type_id;
 				buf->rpc_type_cnt[j]  = type_cnt;
 				buf->rpc_type_time[j] = type_time;
+				buf->rpc_type_auth_time[j] = type_auth;
+				_swap_rpc_latency(i, j);
 			}
 			if (buf->rpc_type_cnt[i]) {
 				rpc_type_ave_time[i] = buf->rpc_type_time[i] /
@@ -346,14 +636,19 @@ static void _sort_rpc(void)
 				type_id   = buf->rpc_type_id[i];
 				type_cnt  = buf->rpc_type_cnt[i];
 				type_time = buf->rpc_type_time[i];
+				type_auth = buf->rpc_type_auth_time[i];
 				rpc_type_ave_time[i]  = rpc_type_ave_time[j];
 				buf->rpc_type_id[i]   = buf->rpc_type_id[j];
 				buf->rpc_type_cnt[i]  = buf->rpc_type_cnt[j];
 				buf->rpc_type_time[i] = buf->rpc_type_time[j];
+				buf->rpc_type_auth_time[i] =
+					buf->rpc_type_auth_time[j];
 				rpc_type_ave_time[j]  = type_ave;
 				buf->rpc_type_id[j]   = type_id;
 				buf->rpc_type_cnt[j]  = type_cnt;
 				buf->rpc_type_time[j] = type_time;
+				buf->rpc_type_auth_time[j] = type_auth;
+				_swap_rpc_latency(i, j);
 			}
 		}
 		for (i = 0; i < buf->rpc_user_size; i++) {
@@ -388,12 +683,17 @@ static void _sort_rpc(void)
 				type_id   = buf->rpc_type_id[i];
 				type_cnt  = buf->rpc_type_cnt[i];
 				type_time = buf->rpc_type_time[i];
+				type_auth = buf->rpc_type_auth_time[i];
 				buf->rpc_type_id[i]   = buf->rpc_type_id[j];
 				buf->rpc_type_cnt[i]  = buf->rpc_type_cnt[j];
 				buf->rpc_type_time[i] = buf->rpc_type_time[j];
+				buf->rpc_type_auth_time[i] =
+					buf->rpc_type_auth_time[j];
 				buf->rpc_type_id[j]   = type_id;
 				buf->rpc_type_cnt[j]  = type_cnt;
 				buf->rpc_type_time[j] = type_time;
+				buf->rpc_type_auth_time[j] = type_auth;
+				_swap_rpc_latency(i, j);
 			}
 			if (buf->rpc_type_cnt[i]) {
 				rpc_type_ave_time[i] = buf->rpc_type_time[i] /
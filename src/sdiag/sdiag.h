@@ -40,6 +40,7 @@
 
 struct sdiag_parameters {
 	int mode;
+	bool profile;
 	int sort;
 	List clusters;
 };
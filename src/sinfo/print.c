@@ -195,10 +195,10 @@ static int _print_str(const char *str, int width, bool right, bool cut_output)
 			return printed;
 	}
 
-	while (printed++ < width)
-		printf(" ");
+	if (printed < width)
+		printf("%*s", width - printed, "");
 
-	return printed;
+	return MAX(printed, width) + 1;
 }
 
 static int _print_secs(long time, int width, bool right, bool cut_output)
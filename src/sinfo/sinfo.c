@@ -43,9 +43,12 @@
 #include "src/common/macros.h"
 #include "src/common/node_select.h"
 #include "src/common/slurm_time.h"
+#include "src/common/xhash.h"
 #include "src/sinfo/sinfo.h"
 #include "src/sinfo/print.h"
 
+#define STDOUT_BUF_SIZE (1024 * 1024)
+
 /********************
  * Global Variables *
  ********************/
@@ -54,8 +57,19 @@ typedef struct build_part_info {
 	uint16_t part_num;
 	partition_info_t *part_ptr;
 	List sinfo_list;
+	xhash_t *sinfo_hash;
 } build_part_info_t;
 
+/*
+ * sinfo records indexed by a key of the fields _match_part_data() and
+ * _match_node_data() compare, so a node finds its record without testing
+ * every record in sinfo_list
+ */
+typedef struct sinfo_key {
+	char *key;
+	sinfo_data_t *sinfo_ptr;
+} sinfo_key_t;
+
 /* Data structures for pthreads used to gather node/partition information from
  * multiple clusters in parallel */
 typedef struct load_info_struct {
@@ -71,6 +85,7 @@ static int sinfo_cnt;	/* thread count */
 static pthread_mutex_t sinfo_cnt_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  sinfo_cnt_cond  = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t sinfo_list_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t sinfo_hash_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 /*************
  * Functions *
@@ -87,7 +102,8 @@ static int  _find_part_list(void *x, void *key);
 static bool _filter_out(node_info_t *node_ptr);
 static int  _get_info(bool clear_old, slurmdb_federation_rec_t *fed,
 		      char *cluster_name);
-static int  _insert_node_ptr(List sinfo_list, uint16_t part_num,
+static int  _insert_node_ptr(List sinfo_list, xhash_t *sinfo_hash,
+			     uint16_t part_num,
 			     partition_info_t *part_ptr,
 			     node_info_t *node_ptr);
 static int  _load_resv(reserve_info_msg_t ** reserv_pptr, bool clear_old);
@@ -103,7 +119,13 @@ static List _query_fed_servers(slurmdb_federation_rec_t *fed,
 static List _query_server(bool clear_old);
 static int  _reservation_report(reserve_info_msg_t *resv_ptr);
 static bool _serial_part_data(void);
+static void _sinfo_key_add(xhash_t *sinfo_hash, char *key,
+			   sinfo_data_t *sinfo_ptr);
+static void _sinfo_key_free(void *data);
+static void _sinfo_key_id(void *item, const char **key, uint32_t *key_len);
 static void _sinfo_list_delete(void *data);
+static char *_sinfo_match_key(partition_info_t *part_ptr,
+			      node_info_t *node_ptr);
 static void _sort_hostlist(List sinfo_list);
 static void _update_sinfo(sinfo_data_t *sinfo_ptr, node_info_t *node_ptr);
 
@@ -121,6 +143,8 @@ int main(int argc, char **argv)
 		opts.stderr_level += params.verbose;
 		log_alter(opts, SYSLOG_FACILITY_USER, NULL);
 	}
+	/* Write rows out in large chunks rather than a line at a time */
+	setvbuf(stdout, NULL, _IOFBF, STDOUT_BUF_SIZE);
 
 	while (1) {
 		if ((!params.no_header) &&
@@ -134,6 +158,7 @@ int main(int argc, char **argv)
 			rc = 1;
 		if (params.iterate) {
 			printf("\n");
+			fflush(stdout);
 			sleep(params.iterate);
 		} else
 			break;
@@ -332,6 +357,7 @@ static List _query_server(bool clear_old)
 	uint16_t show_flags = 0;
 	int cc;
 	node_info_t *node_ptr;
+	info_filter_t filter;
 	List sinfo_list = NULL;
 
 	if (params.all_flag)
@@ -362,6 +388,13 @@ static List _query_server(bool clear_old)
 	if (params.match_flags.gres_used_flag)
 		show_flags |= SHOW_DETAIL;
 
+	/* Have slurmctld hide nodes which _build_sinfo_data() would skip */
+	memset(&filter, 0, sizeof(filter));
+	if (params.filtering) {
+		filter.nodes = params.nodes;
+		filter.partitions = params.partition;
+	}
+
 	if (old_node_ptr) {
 		if (clear_old)
 			old_node_ptr->last_update = 0;
@@ -370,8 +403,9 @@ static List _query_server(bool clear_old)
 							    params.nodes,
 							    show_flags);
 		} else {
-			error_code = slurm_load_node(old_node_ptr->last_update,
-						     &new_node_ptr, show_flags);
+			error_code = slurm_load_node_filter(
+				old_node_ptr->last_update, &new_node_ptr,
+				show_flags, &filter);
 		}
 		if (error_code == SLURM_SUCCESS)
 			slurm_free_node_info_msg(old_node_ptr);
@@ -383,8 +417,9 @@ static List _query_server(bool clear_old)
 		error_code = slurm_load_node_single(&new_node_ptr, params.nodes,
 						    show_flags);
 	} else {
-		error_code = slurm_load_node((time_t) NULL, &new_node_ptr,
-					     show_flags);
+		error_code = slurm_load_node_filter((time_t) NULL,
+						    &new_node_ptr, show_flags,
+						    &filter);
 	}
 	if (error_code) {
 		slurm_perror("slurm_load_node");
@@ -578,8 +613,9 @@ void *_build_part_info(void *args)
 			if (node_ptr->name == NULL)
 				continue;
 
-			_insert_node_ptr(sinfo_list, part_num,
-					 part_ptr, node_ptr);
+			_insert_node_ptr(sinfo_list,
+					 build_struct_ptr->sinfo_hash,
+					 part_num, part_ptr, node_ptr);
 		}
 		j += 2;
 	}
@@ -614,8 +650,12 @@ static int _build_sinfo_data(List sinfo_list,
 	build_part_info_t *build_struct_ptr;
 	node_info_t *node_ptr = NULL;
 	partition_info_t *part_ptr = NULL;
+	sinfo_data_t *sinfo_ptr;
+	xhash_t *sinfo_hash;
 	int j;
 
+	sinfo_hash = xhash_init(_sinfo_key_id, _sinfo_key_free);
+
 	/* by default every partition is shown, even if no nodes */
 	if ((!params.node_flag) && params.match_flags.partition_flag) {
 		part_ptr = partition_msg->partition_array;
@@ -624,9 +664,12 @@ static int _build_sinfo_data(List sinfo_list,
 			    (list_find_first(params.part_list,
 					     _find_part_list,
 					     part_ptr->name))) {
-				list_append(sinfo_list, _create_sinfo(
-						    part_ptr, (uint16_t) j,
-						    NULL));
+				sinfo_ptr = _create_sinfo(part_ptr,
+							  (uint16_t) j, NULL);
+				list_append(sinfo_list, sinfo_ptr);
+				_sinfo_key_add(sinfo_hash,
+					       _sinfo_match_key(part_ptr, NULL),
+					       sinfo_ptr);
 			}
 		}
 	}
@@ -661,7 +704,7 @@ static int _build_sinfo_data(List sinfo_list,
 			hostlist_destroy(hl);
 			if (pos < 0)
 				continue;
-			_insert_node_ptr(sinfo_list, (uint16_t) j,
+			_insert_node_ptr(sinfo_list, sinfo_hash, (uint16_t) j,
 					 part_ptr, node_ptr);
 			continue;
 		}
@@ -672,6 +715,7 @@ static int _build_sinfo_data(List sinfo_list,
 		build_struct_ptr->part_num   = (uint16_t) j;
 		build_struct_ptr->part_ptr   = part_ptr;
 		build_struct_ptr->sinfo_list = sinfo_list;
+		build_struct_ptr->sinfo_hash = sinfo_hash;
 
 		slurm_mutex_lock(&sinfo_cnt_mutex);
 		sinfo_cnt++;
@@ -687,6 +731,7 @@ static int _build_sinfo_data(List sinfo_list,
 	}
 	slurm_mutex_unlock(&sinfo_cnt_mutex);
 
+	xhash_free(sinfo_hash);
 	_sort_hostlist(sinfo_list);
 	return SLURM_SUCCESS;
 }
@@ -1128,13 +1173,180 @@ static void _update_sinfo(sinfo_data_t *sinfo_ptr, node_info_t *node_ptr)
 		sinfo_ptr->cpus_idle += total_cpus;
 }
 
-static int _insert_node_ptr(List sinfo_list, uint16_t part_num,
-			    partition_info_t *part_ptr,
+static void _key_str(char **key, const char *str)
+{
+	if (str)
+		xstrfmtcat(*key, "%zu:%s|", strlen(str), str);
+	else
+		xstrcat(*key, "-|");
+}
+
+/*
+ * Return a key which is equal for two nodes exactly when _match_part_data()
+ * and _match_node_data() would place them in the same sinfo record, or NULL
+ * if that matching is not an equality test (e.g. node names or addresses are
+ * matched by hostlist membership). With a NULL node_ptr, return the key of a
+ * partition record which does not have any nodes yet.
+ */
+static char *_sinfo_match_key(partition_info_t *part_ptr,
+			      node_info_t *node_ptr)
+{
+	char *key = NULL;
+	uint64_t alloc_mem = 0;
+
+	if (params.node_flag || params.match_flags.hostnames_flag ||
+	    params.match_flags.node_addr_flag)
+		return NULL;
+	/* Empty partition records would not be told apart */
+	if (params.list_reasons && params.match_flags.partition_flag)
+		return NULL;
+
+	xstrcat(key, node_ptr ? "N|" : "E|");
+	if (!params.list_reasons) {
+		if (params.match_flags.partition_flag)
+			_key_str(&key, part_ptr->name);
+		if (params.match_flags.avail_flag)
+			xstrfmtcat(key, "%u|", part_ptr->state_up);
+		if (params.match_flags.groups_flag)
+			_key_str(&key, part_ptr->allow_groups);
+		if (params.match_flags.job_size_flag)
+			xstrfmtcat(key, "%u-%u|",
+				   part_ptr->min_nodes, part_ptr->max_nodes);
+		if (params.match_flags.default_time_flag)
+			xstrfmtcat(key, "%u|", part_ptr->default_time);
+		if (params.match_flags.max_time_flag)
+			xstrfmtcat(key, "%u|", part_ptr->max_time);
+		if (params.match_flags.root_flag)
+			xstrfmtcat(key, "%u|",
+				   part_ptr->flags & PART_FLAG_ROOT_ONLY);
+		if (params.match_flags.oversubscribe_flag)
+			xstrfmtcat(key, "%u|", part_ptr->max_share);
+		if (params.match_flags.preempt_mode_flag)
+			xstrfmtcat(key, "%u|", part_ptr->preempt_mode);
+		if (params.match_flags.priority_tier_flag)
+			xstrfmtcat(key, "%u|", part_ptr->priority_tier);
+		if (params.match_flags.priority_job_factor_flag)
+			xstrfmtcat(key, "%u|", part_ptr->priority_job_factor);
+		if (params.match_flags.max_cpus_per_node_flag)
+			xstrfmtcat(key, "%u|", part_ptr->max_cpus_per_node);
+	}
+	if (!node_ptr)
+		return key;
+
+	if (params.match_flags.features_flag)
+		_key_str(&key, node_ptr->features);
+	if (params.match_flags.features_act_flag)
+		_key_str(&key, node_ptr->features_act);
+	if (params.match_flags.gres_flag)
+		_key_str(&key, node_ptr->gres);
+	if (params.match_flags.gres_used_flag)
+		_key_str(&key, node_ptr->gres_used);
+	if (params.match_flags.comment_flag)
+		_key_str(&key, node_ptr->comment);
+	if (params.match_flags.reason_flag)
+		_key_str(&key, node_ptr->reason);
+	if (params.match_flags.reason_timestamp_flag)
+		xstrfmtcat(key, "%ld|", (long) node_ptr->reason_time);
+	if (params.match_flags.reason_user_flag)
+		xstrfmtcat(key, "%u|", node_ptr->reason_uid);
+	if (params.match_flags.state_flag)
+		_key_str(&key, node_state_string(node_ptr->node_state));
+	if (params.match_flags.alloc_mem_flag) {
+		select_g_select_nodeinfo_get(node_ptr->select_nodeinfo,
+					     SELECT_NODEDATA_MEM_ALLOC,
+					     NODE_STATE_ALLOCATED,
+					     &alloc_mem);
+		xstrfmtcat(key, "%"PRIu64"|", alloc_mem);
+	}
+
+	if (!params.exact_match)
+		return key;
+
+	if (params.match_flags.cpus_flag)
+		xstrfmtcat(key, "%u|", node_ptr->cpus);
+	if (params.match_flags.sockets_flag || params.match_flags.sct_flag)
+		xstrfmtcat(key, "%u|", node_ptr->sockets);
+	if (params.match_flags.cores_flag || params.match_flags.sct_flag)
+		xstrfmtcat(key, "%u|", node_ptr->cores);
+	if (params.match_flags.threads_flag || params.match_flags.sct_flag)
+		xstrfmtcat(key, "%u|", node_ptr->threads);
+	if (params.match_flags.disk_flag)
+		xstrfmtcat(key, "%u|", node_ptr->tmp_disk);
+	if (params.match_flags.memory_flag)
+		xstrfmtcat(key, "%"PRIu64"|", node_ptr->real_memory);
+	if (params.match_flags.weight_flag)
+		xstrfmtcat(key, "%u|", node_ptr->weight);
+	if (params.match_flags.cpu_load_flag)
+		xstrfmtcat(key, "%u|", node_ptr->cpu_load);
+	if (params.match_flags.free_mem_flag)
+		xstrfmtcat(key, "%"PRIu64"|", node_ptr->free_mem);
+	if (params.match_flags.port_flag)
+		xstrfmtcat(key, "%u|", node_ptr->port);
+	if (params.match_flags.version_flag)	/* compared by address */
+		xstrfmtcat(key, "%p|", node_ptr->version);
+
+	return key;
+}
+
+/* Index sinfo_ptr by key, which is consumed. A NULL key is ignored. */
+static void _sinfo_key_add(xhash_t *sinfo_hash, char *key,
+			   sinfo_data_t *sinfo_ptr)
+{
+	sinfo_key_t *sinfo_key;
+
+	if (!key)
+		return;
+
+	sinfo_key = xmalloc(sizeof(sinfo_key_t));
+	sinfo_key->key = key;
+	sinfo_key->sinfo_ptr = sinfo_ptr;
+	slurm_mutex_lock(&sinfo_hash_mutex);
+	xhash_add(sinfo_hash, sinfo_key);
+	slurm_mutex_unlock(&sinfo_hash_mutex);
+}
+
+static sinfo_data_t *_sinfo_key_find(xhash_t *sinfo_hash, char *key)
+{
+	sinfo_key_t *sinfo_key;
+
+	slurm_mutex_lock(&sinfo_hash_mutex);
+	sinfo_key = xhash_get_str(sinfo_hash, key);
+	slurm_mutex_unlock(&sinfo_hash_mutex);
+
+	return sinfo_key ? sinfo_key->sinfo_ptr : NULL;
+}
+
+static int _insert_node_ptr(List sinfo_list, xhash_t *sinfo_hash,
+			    uint16_t part_num, partition_info_t *part_ptr,
 			    node_info_t *node_ptr)
 {
 	int rc = SLURM_SUCCESS;
 	sinfo_data_t *sinfo_ptr = NULL;
 	ListIterator itr = NULL;
+	char *key, *part_key;
+
+	if ((key = _sinfo_match_key(part_ptr, node_ptr))) {
+		if (!(sinfo_ptr = _sinfo_key_find(sinfo_hash, key))) {
+			/* Partition record still without nodes? */
+			part_key = _sinfo_match_key(part_ptr, NULL);
+			sinfo_ptr = _sinfo_key_find(sinfo_hash, part_key);
+			xfree(part_key);
+			if (sinfo_ptr && sinfo_ptr->nodes_total)
+				sinfo_ptr = NULL;
+			if (sinfo_ptr)
+				_update_sinfo(sinfo_ptr, node_ptr);
+			else {
+				sinfo_ptr = _create_sinfo(part_ptr, part_num,
+							  node_ptr);
+				list_append(sinfo_list, sinfo_ptr);
+			}
+			_sinfo_key_add(sinfo_hash, key, sinfo_ptr);
+		} else {
+			_update_sinfo(sinfo_ptr, node_ptr);
+			xfree(key);
+		}
+		return rc;
+	}
 
 	itr = list_iterator_create(sinfo_list);
 	while ((sinfo_ptr = list_next(itr))) {
@@ -1197,6 +1409,23 @@ static void _part_list_delete(void *data)
 	slurm_free_partition_info_msg(old_part_ptr);
 }
 
+/* Fetch key from xhash_t item. Called from function ptr */
+static void _sinfo_key_id(void *item, const char **key, uint32_t *key_len)
+{
+	sinfo_key_t *sinfo_key = item;
+
+	*key = sinfo_key->key;
+	*key_len = strlen(sinfo_key->key);
+}
+
+static void _sinfo_key_free(void *data)
+{
+	sinfo_key_t *sinfo_key = data;
+
+	xfree(sinfo_key->key);
+	xfree(sinfo_key);
+}
+
 static void _sinfo_list_delete(void *data)
 {
 	sinfo_data_t *sinfo_ptr = data;
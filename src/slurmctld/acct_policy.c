@@ -95,12 +95,18 @@ static void _apply_limit_factor(uint64_t *limit, double limit_factor)
 /*
  * Update a job's allocated node count to reflect only nodes that are not
  * already allocated to this association.  Needed to enforce GrpNode limit.
+ * The count is only compared against node_limit, so the bitmap work is
+ * skipped when no node limit is set.
  */
 static void _get_unique_job_node_cnt(job_record_t *job_ptr,
 				     bitstr_t *grp_node_bitmap,
+				     uint64_t node_limit,
 				     uint64_t *node_cnt)
 {
 	xassert(node_cnt);
+
+	if (node_limit == INFINITE64)
+		return;
 #if _DEBUG
 	char node_bitstr[64];
 	if (job_ptr->job_resrcs && job_ptr->job_resrcs->node_bitmap) {
@@ -2225,6 +2231,7 @@ static int _qos_job_runnable_post_select(job_record_t *job_ptr,
 	 */
 	orig_node_cnt = tres_req_cnt[TRES_ARRAY_NODE];
 	_get_unique_job_node_cnt(job_ptr, qos_ptr->usage->grp_node_bitmap,
+				 qos_ptr->grp_tres_ctld[TRES_ARRAY_NODE],
 				 &tres_req_cnt[TRES_ARRAY_NODE]);
 	tres_usage = _validate_tres_usage_limits_for_qos(
 		&tres_pos,
@@ -2397,6 +2404,7 @@ static int _qos_job_runnable_post_select(job_record_t *job_ptr,
 
 	orig_node_cnt = tres_req_cnt[TRES_ARRAY_NODE];
 	_get_unique_job_node_cnt(job_ptr, used_limits_a->node_bitmap,
+				 qos_ptr->max_tres_pa_ctld[TRES_ARRAY_NODE],
 				 &tres_req_cnt[TRES_ARRAY_NODE]);
 	tres_usage = _validate_tres_usage_limits_for_qos(
 		&tres_pos,
@@ -2449,6 +2457,7 @@ static int _qos_job_runnable_post_select(job_record_t *job_ptr,
 
 	orig_node_cnt = tres_req_cnt[TRES_ARRAY_NODE];
 	_get_unique_job_node_cnt(job_ptr, used_limits->node_bitmap,
+				 qos_ptr->max_tres_pu_ctld[TRES_ARRAY_NODE],
 				 &tres_req_cnt[TRES_ARRAY_NODE]);
 	tres_usage = _validate_tres_usage_limits_for_qos(
 		&tres_pos,
@@ -3869,6 +3878,7 @@ extern bool acct_policy_job_runnable_post_select(job_record_t *job_ptr,
 		orig_node_cnt = tres_req_cnt[TRES_ARRAY_NODE];
 		_get_unique_job_node_cnt(job_ptr,
 					 assoc_ptr->usage->grp_node_bitmap,
+					 grp_tres_ctld[TRES_ARRAY_NODE],
 					 &tres_req_cnt[TRES_ARRAY_NODE]);
 		tres_usage = _validate_tres_usage_limits_for_assoc(
 			&tres_pos,
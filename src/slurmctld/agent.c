@@ -51,15 +51,18 @@
  *  be possible to execute the agent as an pthread, process, or even a daemon
  *  on some other computer.
  *
- *  The main agent thread creates a separate thread for each node to be
- *  communicated with up to AGENT_THREAD_COUNT. A special watchdog thread
- *  sends SIGLARM to any threads that have been active (in DSH_ACTIVE state)
- *  for more than MessageTimeout seconds.
+ *  The main agent thread creates a separate thread for each group of nodes
+ *  to be communicated with up to AGENT_THREAD_COUNT. Most RPCs are sent to a
+ *  single group and forwarded by slurmd, so only one communication thread is
+ *  required. The main agent thread then acts as the watchdog: it starts the
+ *  remaining threads as earlier ones complete and sends SIGUSR1 to any
+ *  threads that have been active (in DSH_ACTIVE state) for more than
+ *  MessageTimeout seconds.
  *  The agent responds to slurmctld via a function call or an RPC as required.
  *  For example, informing slurmctld that some node is not responding.
  *
  *  All the state for each thread is maintained in thd_t struct, which is
- *  used by the watchdog thread as well as the communication threads.
+ *  used by the watchdog as well as the communication threads.
 \*****************************************************************************/
 
 #include "config.h"
@@ -74,6 +77,7 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -86,6 +90,7 @@
 #include "src/common/parse_time.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_protocol_interface.h"
+#include "src/common/timers.h"
 #include "src/common/uid.h"
 #include "src/common/xsignal.h"
 #include "src/common/xassert.h"
@@ -105,6 +110,7 @@
 #define RPC_PACK_MAX_AGE	30	/* Rebuild data over 30 seconds old */
 #define DUMP_RPC_COUNT 		25
 #define HOSTLIST_MAX_SIZE 	80
+#define KILL_JOB_LIST_MAX	50	/* kill requests sent in one RPC */
 
 typedef enum {
 	DSH_NEW,        /* Request not yet started */
@@ -174,9 +180,12 @@ typedef struct mail_info {
 	char *message;
 } mail_info_t;
 
-static void _agent_defer(void);
+static void _agent_defer(bool nodes_ready);
 static void _agent_retry(int min_wait, bool wait_too);
-static int  _batch_launch_defer(queued_request_t *queued_req_ptr);
+static int  _batch_launch_defer(queued_request_t *queued_req_ptr,
+				bool retest_now);
+static void _coalesce_kill_reqs(agent_arg_t *agent_arg_ptr,
+				ListIterator retry_iter);
 static void _reboot_from_ctld(agent_arg_t *agent_arg_ptr);
 static int  _signal_defer(queued_request_t *queued_req_ptr);
 static inline int _comm_err(char *node_name, slurm_msg_type_t msg_type);
@@ -193,7 +202,7 @@ static int  _setup_requeue(agent_arg_t *agent_arg_ptr, thd_t *thread_ptr,
 static void _sig_handler(int dummy);
 static void *_thread_per_group_rpc(void *args);
 static int   _valid_agent_arg(agent_arg_t *agent_arg_ptr);
-static void *_wdog(void *args);
+static void  _wdog(agent_info_t *agent_ptr);
 
 static mail_info_t *_mail_alloc(void);
 static void  _mail_free(void *arg);
@@ -221,6 +230,7 @@ static pthread_mutex_t pending_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  pending_cond = PTHREAD_COND_INITIALIZER;
 static int pending_wait_time = NO_VAL16;
 static bool pending_mail = false;
+static bool pending_nodes_ready = false;
 static bool pending_thread_running = false;
 
 static bool run_scheduler    = false;
@@ -242,15 +252,12 @@ static time_t cache_build_time = 0;
  */
 void *agent(void *args)
 {
-	int i, delay;
-	pthread_t thread_wdog = 0;
+	int delay;
 	agent_arg_t *agent_arg_ptr = args;
 	agent_info_t *agent_info_ptr = NULL;
-	thd_t *thread_ptr;
-	task_info_t *task_specific_ptr;
 	time_t begin_time;
 	bool spawn_retry_agent = false;
-	int rpc_thread_cnt;
+	int rpc_thread_cnt = 0;
 	static time_t sched_update = 0;
 	static bool reboot_from_ctld = false;
 
@@ -278,21 +285,8 @@ void *agent(void *args)
 #endif
 		sched_update = slurm_conf.last_update;
 	}
-
-	rpc_thread_cnt = 2 + MIN(agent_arg_ptr->node_count, AGENT_THREAD_COUNT);
-	while (1) {
-		if (slurmctld_config.shutdown_time ||
-		    ((agent_thread_cnt+rpc_thread_cnt) <= MAX_SERVER_THREADS)) {
-			agent_cnt++;
-			agent_thread_cnt += rpc_thread_cnt;
-			break;
-		} else {	/* wait for state change and retry */
-			slurm_cond_wait(&agent_cnt_cond, &agent_cnt_mutex);
-		}
-	}
+	agent_cnt++;
 	slurm_mutex_unlock(&agent_cnt_mutex);
-	if (slurmctld_config.shutdown_time)
-		goto cleanup;
 
 	/* basic argument value tests */
 	begin_time = time(NULL);
@@ -307,10 +301,28 @@ void *agent(void *args)
 
 	/* initialize the agent data structures */
 	agent_info_ptr = _make_agent_info(agent_arg_ptr);
-	thread_ptr = agent_info_ptr->thread_struct;
 
-	/* start the watchdog thread */
-	slurm_thread_create(&thread_wdog, _wdog, agent_info_ptr);
+	/*
+	 * Reserve this thread plus one per concurrently active group of
+	 * nodes. Forwarded RPCs typically use a single group regardless of
+	 * node count.
+	 */
+	slurm_mutex_lock(&agent_cnt_mutex);
+	while (!slurmctld_config.shutdown_time &&
+	       ((agent_thread_cnt + 1 +
+		 MIN(agent_info_ptr->thread_count, AGENT_THREAD_COUNT)) >
+		MAX_SERVER_THREADS)) {
+		/* wait for state change and retry */
+		slurm_cond_wait(&agent_cnt_cond, &agent_cnt_mutex);
+	}
+	if (!slurmctld_config.shutdown_time) {
+		rpc_thread_cnt = 1 + MIN(agent_info_ptr->thread_count,
+					 AGENT_THREAD_COUNT);
+		agent_thread_cnt += rpc_thread_cnt;
+	}
+	slurm_mutex_unlock(&agent_cnt_mutex);
+	if (slurmctld_config.shutdown_time)
+		goto cleanup;
 
 	log_flag(AGENT, "%s: New agent thread_count:%d threads_active:%d retry:%c get_reply:%c msg_type:%s protocol_version:%hu",
 		 __func__, agent_info_ptr->thread_count,
@@ -320,31 +332,8 @@ void *agent(void *args)
 		 rpc_num2string(agent_arg_ptr->msg_type),
 		 agent_info_ptr->protocol_version);
 
-	/* start all the other threads (up to AGENT_THREAD_COUNT active) */
-	for (i = 0; i < agent_info_ptr->thread_count; i++) {
-		/* wait until "room" for another thread */
-		slurm_mutex_lock(&agent_info_ptr->thread_mutex);
-		while (agent_info_ptr->threads_active >=
-		       AGENT_THREAD_COUNT) {
-			slurm_cond_wait(&agent_info_ptr->thread_cond,
-					&agent_info_ptr->thread_mutex);
-		}
-
-		/*
-		 * create thread specific data,
-		 * NOTE: freed from _thread_per_group_rpc()
-		 */
-		task_specific_ptr = _make_task_data(agent_info_ptr, i);
-
-		slurm_thread_create_detached(&thread_ptr[i].thread,
-					     _thread_per_group_rpc,
-					     task_specific_ptr);
-		agent_info_ptr->threads_active++;
-		slurm_mutex_unlock(&agent_info_ptr->thread_mutex);
-	}
-
-	/* Wait for termination of remaining threads */
-	pthread_join(thread_wdog, NULL);
+	/* start the threads and wait for their termination */
+	_wdog(agent_info_ptr);
 	delay = (int) difftime(time(NULL), begin_time);
 	if (delay > (slurm_conf.msg_timeout * 2)) {
 		info("agent msg_type=%u ran for %d seconds",
@@ -380,14 +369,16 @@ cleanup:
 		error("agent_cnt underflow");
 		agent_cnt = 0;
 	}
-	if (agent_thread_cnt >= rpc_thread_cnt) {
+	if (!rpc_thread_cnt) {
+		;	/* no threads reserved */
+	} else if (agent_thread_cnt >= rpc_thread_cnt) {
 		agent_thread_cnt -= rpc_thread_cnt;
 	} else {
 		error("agent_thread_cnt underflow");
 		agent_thread_cnt = 0;
 	}
 
-	if ((agent_thread_cnt + AGENT_THREAD_COUNT + 2) < MAX_SERVER_THREADS)
+	if ((agent_thread_cnt + AGENT_THREAD_COUNT + 1) < MAX_SERVER_THREADS)
 		spawn_retry_agent = true;
 
 	slurm_cond_broadcast(&agent_cnt_cond);
@@ -562,18 +553,22 @@ static void _update_wdog_state(thd_t *thread_ptr,
 }
 
 /*
- * _wdog - Watchdog thread. Send SIGUSR1 to threads which have been active
- *	for too long.
- * IN args - pointer to agent_info_t with info on threads to watch
- * Sleep between polls with exponential times (from 0.005 to 1.0 second)
+ * _wdog - Watchdog, run by the main agent thread. Start threads for each
+ *	group of nodes (up to AGENT_THREAD_COUNT active) and send SIGUSR1 to
+ *	threads which have been active for too long.
+ * IN agent_ptr - pointer to agent_info_t with info on threads to watch
+ * Wait between polls with exponential times (from 0.005 to 1.0 second),
+ * waking early whenever a thread completes.
  */
-static void *_wdog(void *args)
+static void _wdog(agent_info_t *agent_ptr)
 {
 	bool srun_agent = false;
-	int i;
-	agent_info_t *agent_ptr = (agent_info_t *) args;
+	int i, next_thread = 0;
 	thd_t *thread_ptr = agent_ptr->thread_struct;
 	unsigned long usec = 5000;
+	struct timeval now;
+	struct timespec ts;
+	task_info_t *task_specific_ptr;
 	ListIterator itr;
 	thd_complete_t thd_comp;
 	ret_data_info_t *ret_data_info = NULL;
@@ -593,17 +588,39 @@ static void *_wdog(void *args)
 
 	thd_comp.max_delay = 0;
 
+	slurm_mutex_lock(&agent_ptr->thread_mutex);
 	while (1) {
+		/* start more threads if there is "room" for them */
+		while ((next_thread < agent_ptr->thread_count) &&
+		       (agent_ptr->threads_active < AGENT_THREAD_COUNT)) {
+			/*
+			 * create thread specific data,
+			 * NOTE: freed from _thread_per_group_rpc()
+			 */
+			task_specific_ptr = _make_task_data(agent_ptr,
+							    next_thread);
+			slurm_thread_create_detached(
+				&thread_ptr[next_thread].thread,
+				_thread_per_group_rpc, task_specific_ptr);
+			agent_ptr->threads_active++;
+			next_thread++;
+		}
+
+		/* a completing thread signals thread_cond to wake us */
+		gettimeofday(&now, NULL);
+		now.tv_usec += usec;
+		ts.tv_sec = now.tv_sec + (now.tv_usec / 1000000);
+		ts.tv_nsec = (now.tv_usec % 1000000) * 1000;
+		slurm_cond_timedwait(&agent_ptr->thread_cond,
+				     &agent_ptr->thread_mutex, &ts);
+		usec = MIN((usec * 2), 1000000);
+
 		thd_comp.work_done   = true;/* assume all threads complete */
 		thd_comp.fail_cnt    = 0;   /* assume no threads failures */
 		thd_comp.no_resp_cnt = 0;   /* assume all threads respond */
 		thd_comp.retry_cnt   = 0;   /* assume no required retries */
 		thd_comp.now         = time(NULL);
 
-		usleep(usec);
-		usec = MIN((usec * 2), 1000000);
-
-		slurm_mutex_lock(&agent_ptr->thread_mutex);
 		for (i = 0; i < agent_ptr->thread_count; i++) {
 			//info("thread name %s",thread_ptr[i].node_name);
 			if (!thread_ptr[i].ret_list) {
@@ -623,8 +640,6 @@ static void *_wdog(void *args)
 		}
 		if (thd_comp.work_done)
 			break;
-
-		slurm_mutex_unlock(&agent_ptr->thread_mutex);
 	}
 
 	if (srun_agent) {
@@ -645,7 +660,6 @@ static void *_wdog(void *args)
 			 __func__, thd_comp.max_delay);
 
 	slurm_mutex_unlock(&agent_ptr->thread_mutex);
-	return (void *) NULL;
 }
 
 static void _notify_slurmctld_jobs(agent_info_t *agent_ptr)
@@ -978,23 +992,38 @@ static void *_thread_per_group_rpc(void *args)
 		goto cleanup;
 	}
 
+	/*
+	 * SPECIAL CASE: Record the load and energy data of every node that
+	 * responded to this group under a single node write lock, rather than
+	 * locking once per node
+	 */
+	if ((msg_type == REQUEST_PING) ||
+	    (msg_type == REQUEST_ACCT_GATHER_UPDATE)) {
+		lock_slurmctld(node_write_lock);
+		itr = list_iterator_create(ret_list);
+		while ((ret_data_info = list_next(itr))) {
+			if (ret_data_info->type == RESPONSE_PING_SLURMD) {
+				ping_slurmd_resp_msg_t *ping_resp =
+					ret_data_info->data;
+				reset_node_load(ret_data_info->node_name,
+						ping_resp->cpu_load);
+				reset_node_free_mem(ret_data_info->node_name,
+						    ping_resp->free_mem);
+			} else if (ret_data_info->type ==
+				   RESPONSE_ACCT_GATHER_UPDATE) {
+				update_node_record_acct_gather_data(
+					ret_data_info->data);
+			}
+		}
+		list_iterator_destroy(itr);
+		unlock_slurmctld(node_write_lock);
+	}
+
 	//info("got %d messages back", list_count(ret_list));
 	itr = list_iterator_create(ret_list);
 	while ((ret_data_info = list_next(itr))) {
 		rc = slurm_get_return_code(ret_data_info->type,
 					   ret_data_info->data);
-		/* SPECIAL CASE: Record node's CPU load */
-		if (ret_data_info->type == RESPONSE_PING_SLURMD) {
-			ping_slurmd_resp_msg_t *ping_resp;
-			ping_resp = (ping_slurmd_resp_msg_t *)
-				    ret_data_info->data;
-			lock_slurmctld(node_write_lock);
-			reset_node_load(ret_data_info->node_name,
-					ping_resp->cpu_load);
-			reset_node_free_mem(ret_data_info->node_name,
-					    ping_resp->free_mem);
-			unlock_slurmctld(node_write_lock);
-		}
 		/* SPECIAL CASE: Mark node as IDLE if job already complete */
 		if (is_kill_msg &&
 		    (rc == ESLURMD_KILL_JOB_ALREADY_COMPLETE)) {
@@ -1009,14 +1038,6 @@ static void *_thread_per_group_rpc(void *args)
 			unlock_slurmctld(job_write_lock);
 		}
 
-		/* SPECIAL CASE: Record node's CPU load */
-		if (ret_data_info->type == RESPONSE_ACCT_GATHER_UPDATE) {
-			lock_slurmctld(node_write_lock);
-			update_node_record_acct_gather_data(
-				ret_data_info->data);
-			unlock_slurmctld(node_write_lock);
-		}
-
 		/* SPECIAL CASE: Requeue/hold non-startable batch job,
 		 * Requeue job prolog failure or duplicate job ID */
 		if ((msg_type == REQUEST_BATCH_JOB_LAUNCH) &&
@@ -1365,7 +1386,7 @@ static void _list_delete_retry(void *retry_entry)
 static void *_agent_init(void *arg)
 {
 	int min_wait;
-	bool mail_too;
+	bool mail_too, nodes_ready;
 	struct timespec ts = {0, 0};
 	time_t last_defer_attempt = (time_t) 0;
 
@@ -1383,13 +1404,15 @@ static void *_agent_init(void *arg)
 		}
 		mail_too = pending_mail;
 		min_wait = pending_wait_time;
+		nodes_ready = pending_nodes_ready;
 		pending_mail = false;
 		pending_wait_time = NO_VAL16;
+		pending_nodes_ready = false;
 		slurm_mutex_unlock(&pending_mutex);
 
-		if (last_defer_attempt + 2 < last_job_update) {
+		if (nodes_ready || (last_defer_attempt + 2 < last_job_update)) {
 			last_defer_attempt = time(NULL);
-			_agent_defer();
+			_agent_defer(nodes_ready);
 		}
 
 		_agent_retry(min_wait, mail_too);
@@ -1439,6 +1462,21 @@ extern void agent_trigger(int min_wait, bool mail_too)
 	slurm_mutex_unlock(&pending_mutex);
 }
 
+/*
+ * agent_nodes_ready - Note that nodes being powered up or rebooted have
+ *	registered, so that deferred batch job launches are tested now rather
+ *	than at their next periodic test
+ */
+extern void agent_nodes_ready(void)
+{
+	slurm_mutex_lock(&pending_mutex);
+	pending_nodes_ready = true;
+	if (pending_wait_time == NO_VAL16)
+		pending_wait_time = RPC_RETRY_INTERVAL;
+	slurm_cond_broadcast(&pending_cond);
+	slurm_mutex_unlock(&pending_mutex);
+}
+
 /* agent_pack_pending_rpc_stats - pack counts of pending RPCs into a buffer */
 extern void agent_pack_pending_rpc_stats(buf_t *buffer)
 {
@@ -1511,7 +1549,7 @@ pack_it:
 	packstr_array(rpc_host_list, rpc_count, buffer);
 }
 
-static void _agent_defer(void)
+static void _agent_defer(bool nodes_ready)
 {
 	int rc = -1;
 	queued_request_t *queued_req_ptr = NULL;
@@ -1528,7 +1566,8 @@ static void _agent_defer(void)
 			agent_arg_ptr = queued_req_ptr->agent_arg_ptr;
 			if (agent_arg_ptr->msg_type ==
 			    REQUEST_BATCH_JOB_LAUNCH)
-				rc = _batch_launch_defer(queued_req_ptr);
+				rc = _batch_launch_defer(queued_req_ptr,
+							 nodes_ready);
 			else if (agent_arg_ptr->msg_type ==
 				 REQUEST_SIGNAL_TASKS)
 				rc = _signal_defer(queued_req_ptr);
@@ -1621,6 +1660,9 @@ static void _agent_retry(int min_wait, bool mail_too)
 		while ((queued_req_ptr = list_next(retry_iter))) {
  			if (queued_req_ptr->last_attempt == 0) {
 				list_remove(retry_iter);
+				_coalesce_kill_reqs(
+					queued_req_ptr->agent_arg_ptr,
+					retry_iter);
 				break;		/* Process this request now */
 			}
 		}
@@ -1674,6 +1716,82 @@ static void _agent_retry(int min_wait, bool mail_too)
 	return;
 }
 
+static bool _is_kill_list_msg(agent_arg_t *agent_arg_ptr)
+{
+	if (agent_arg_ptr->addr ||
+	    (agent_arg_ptr->protocol_version &&
+	     (agent_arg_ptr->protocol_version < SLURM_21_08_PROTOCOL_VERSION)))
+		return false;
+
+	return ((agent_arg_ptr->msg_type == REQUEST_TERMINATE_JOB) ||
+		(agent_arg_ptr->msg_type == REQUEST_KILL_TIMELIMIT) ||
+		(agent_arg_ptr->msg_type == REQUEST_KILL_PREEMPTED));
+}
+
+/*
+ * Merge never tried kill requests in the retry_list of the same type and to
+ * the same nodes as agent_arg_ptr into one REQUEST_KILL_JOB_LIST, so a backlog
+ * of job terminations takes one connection per node rather than one per job.
+ * IN/OUT agent_arg_ptr - request being dispatched, converted to
+ *	REQUEST_KILL_JOB_LIST if any other requests are merged into it
+ * IN retry_iter - retry_list iterator positioned after agent_arg_ptr
+ * NOTE: Caller must hold retry_mutex
+ */
+static void _coalesce_kill_reqs(agent_arg_t *agent_arg_ptr,
+				ListIterator retry_iter)
+{
+	queued_request_t *queued_req_ptr;
+	agent_arg_t *other;
+	kill_job_list_msg_t *kill_list = NULL;
+	char *hosts, *other_hosts;
+
+	if (!_is_kill_list_msg(agent_arg_ptr))
+		return;
+
+	hosts = hostlist_ranged_string_xmalloc(agent_arg_ptr->hostlist);
+	while ((queued_req_ptr = list_next(retry_iter))) {
+		other = queued_req_ptr->agent_arg_ptr;
+		if ((queued_req_ptr->last_attempt != 0) || !other ||
+		    (other->msg_type != agent_arg_ptr->msg_type) ||
+		    (other->protocol_version !=
+		     agent_arg_ptr->protocol_version) ||
+		    (other->retry != agent_arg_ptr->retry) ||
+		    (other->node_count != agent_arg_ptr->node_count) ||
+		    !_is_kill_list_msg(other))
+			continue;
+		other_hosts = hostlist_ranged_string_xmalloc(other->hostlist);
+		if (xstrcmp(hosts, other_hosts)) {
+			xfree(other_hosts);
+			continue;
+		}
+		xfree(other_hosts);
+
+		if (!kill_list) {
+			kill_list = xmalloc(sizeof(*kill_list));
+			kill_list->kill_msg_type = agent_arg_ptr->msg_type;
+			kill_list->kill_msgs = xcalloc(KILL_JOB_LIST_MAX,
+						       sizeof(kill_job_msg_t *));
+			kill_list->kill_msgs[kill_list->count++] =
+				agent_arg_ptr->msg_args;
+		}
+		kill_list->kill_msgs[kill_list->count++] = other->msg_args;
+		other->msg_args = NULL;
+		list_remove(retry_iter);
+		_list_delete_retry(queued_req_ptr);
+		if (kill_list->count >= KILL_JOB_LIST_MAX)
+			break;
+	}
+
+	if (kill_list) {
+		log_flag(AGENT, "%s: merged %u %s requests to %s",
+			 __func__, kill_list->count,
+			 rpc_num2string(kill_list->kill_msg_type), hosts);
+		agent_arg_ptr->msg_type = REQUEST_KILL_JOB_LIST;
+		agent_arg_ptr->msg_args = kill_list;
+	}
+	xfree(hosts);
+}
+
 /*
  * agent_queue_request - put a new request on the queue for execution or
  * 	execute now if not too busy
@@ -1703,7 +1821,7 @@ void agent_queue_request(agent_arg_t *agent_arg_ptr)
 /*	queued_req_ptr->last_attempt  = 0; Implicit */
 
 	if (((agent_arg_ptr->msg_type == REQUEST_BATCH_JOB_LAUNCH) &&
-	     (_batch_launch_defer(queued_req_ptr) != 0)) ||
+	     (_batch_launch_defer(queued_req_ptr, false) != 0)) ||
 	    ((agent_arg_ptr->msg_type == REQUEST_SIGNAL_TASKS) &&
 	     (_signal_defer(queued_req_ptr) != 0))) {
 		slurm_mutex_lock(&defer_mutex);
@@ -1804,6 +1922,8 @@ static void _purge_agent_args(agent_arg_t *agent_arg_ptr)
 			 (agent_arg_ptr->msg_type == REQUEST_KILL_PREEMPTED) ||
 			 (agent_arg_ptr->msg_type == REQUEST_KILL_TIMELIMIT))
 			slurm_free_kill_job_msg(agent_arg_ptr->msg_args);
+		else if (agent_arg_ptr->msg_type == REQUEST_KILL_JOB_LIST)
+			slurm_free_kill_job_list_msg(agent_arg_ptr->msg_args);
 		else if (agent_arg_ptr->msg_type == SRUN_USER_MSG)
 			slurm_free_srun_user_msg(agent_arg_ptr->msg_args);
 		else if (agent_arg_ptr->msg_type == SRUN_EXEC)
@@ -2101,11 +2221,13 @@ extern void mail_job_info(job_record_t *job_ptr, uint16_t mail_type)
 }
 
 /* Test if a batch launch request should be defered
+ * IN retest_now - booting nodes registered, test even if recently tested
  * RET -1: abort the request, pending job cancelled
  *      0: execute the request now
  *      1: defer the request
  */
-static int _batch_launch_defer(queued_request_t *queued_req_ptr)
+static int _batch_launch_defer(queued_request_t *queued_req_ptr,
+			       bool retest_now)
 {
 	agent_arg_t *agent_arg_ptr;
 	batch_job_launch_msg_t *launch_msg_ptr;
@@ -2114,7 +2236,8 @@ static int _batch_launch_defer(queued_request_t *queued_req_ptr)
 	int nodes_ready = 0, tmp = 0;
 
 	agent_arg_ptr = queued_req_ptr->agent_arg_ptr;
-	if (difftime(now, queued_req_ptr->last_attempt) < 10) {
+	if (!retest_now &&
+	    (difftime(now, queued_req_ptr->last_attempt) < 10)) {
 		/* Reduce overhead by only testing once every 10 secs */
 		return 1;
 	}
@@ -2176,6 +2299,7 @@ static int _batch_launch_defer(queued_request_t *queued_req_ptr)
 	if (nodes_ready) {
 		if (IS_JOB_CONFIGURING(job_ptr))
 			job_config_fini(job_ptr);
+		job_ptr->launch_time[JOB_LAUNCH_SENT] = slurm_time_usec();
 		queued_req_ptr->last_attempt = (time_t) 0;
 		return 0;
 	}
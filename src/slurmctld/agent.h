@@ -92,6 +92,13 @@ extern void agent_queue_request(agent_arg_t *agent_arg_ptr);
  */
 extern void agent_trigger(int min_wait, bool mail_too);
 
+/*
+ * agent_nodes_ready - Note that nodes being powered up or rebooted have
+ *	registered, so that deferred batch job launches are tested now rather
+ *	than at their next periodic test
+ */
+extern void agent_nodes_ready(void);
+
 /* agent_purge - purge all pending RPC requests */
 extern void agent_purge (void);
 
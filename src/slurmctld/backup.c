@@ -65,6 +65,7 @@
 #include "src/slurmctld/proc_req.h"
 #include "src/slurmctld/read_config.h"
 #include "src/slurmctld/slurmctld.h"
+#include "src/slurmctld/state_replica.h"
 #include "src/slurmctld/trigger_mgr.h"
 
 #define _DEBUG		0
@@ -258,6 +259,7 @@ void run_backup(void)
 		error("Unable to recover slurm state");
 		abort();
 	}
+	state_replica_fini();
 	slurmctld_config.shutdown_time = (time_t) 0;
 	unlock_slurmctld(config_write_lock);
 	select_g_select_nodeinfo_set_all();
@@ -435,6 +437,11 @@ static int _background_process_msg(slurm_msg_t *msg)
 			debug3("Ignoring RPC: REQUEST_CONTROL");
 			error_code = ESLURM_DISABLED;
 			last_controller_response = time(NULL);
+		} else if (super_user &&
+			   (msg->msg_type == REQUEST_STATE_REPLICA)) {
+			state_replica_store(msg->data);
+			msg->data = NULL;
+			last_controller_response = time(NULL);
 		} else if (msg->msg_type == REQUEST_CONTROL_STATUS) {
 			slurm_rpc_control_status(msg);
 			send_rc = false;
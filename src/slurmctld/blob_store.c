@@ -0,0 +1,353 @@
+/*****************************************************************************\
+ *  blob_store.c - content addressed store for batch scripts and environments
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "src/common/list.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/read_config.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/xhash.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "src/slurmctld/blob_store.h"
+
+#define BLOB_DIR_CNT 16
+
+typedef struct {
+	char *key;
+	uint32_t ref_cnt;
+} blob_t;
+
+/*
+ * Only blobs referenced by job records (or released and waiting to be
+ * purged) are in blob_table, the content itself lives on disk.
+ */
+static pthread_mutex_t blob_mutex = PTHREAD_MUTEX_INITIALIZER;
+static xhash_t *blob_table = NULL;
+static List purge_list = NULL;
+static uint16_t dirs_made = 0;
+
+static void _blob_id(void *item, const char **key, uint32_t *key_len)
+{
+	blob_t *blob = item;
+
+	*key = blob->key;
+	*key_len = strlen(blob->key);
+}
+
+static void _blob_free(void *item)
+{
+	blob_t *blob = item;
+
+	xfree(blob->key);
+	xfree(blob);
+}
+
+static void _init(void)
+{
+	if (blob_table)
+		return;
+	blob_table = xhash_init(_blob_id, _blob_free);
+	purge_list = list_create(xfree_ptr);
+}
+
+/* 64-bit FNV-1a, the size is part of the key as well */
+static char *_make_key(const char *data, uint32_t size)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+
+	for (uint32_t i = 0; i < size; i++) {
+		hash ^= (unsigned char) data[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return xstrdup_printf("%016"PRIx64"%08x", hash, size);
+}
+
+static int _dir_inx(const char *key)
+{
+	return slurm_char_to_hex(key[0]) & (BLOB_DIR_CNT - 1);
+}
+
+extern char *blob_store_path(const char *key)
+{
+	return xstrdup_printf("%s/blob.%x/%s", slurm_conf.state_save_location,
+			      _dir_inx(key), key);
+}
+
+extern bool blob_store_exists(const char *key)
+{
+	struct stat sbuf;
+	char *path = blob_store_path(key);
+	int rc = stat(path, &sbuf);
+
+	xfree(path);
+	return (rc == 0);
+}
+
+/* Return true if the blob at path holds exactly data */
+static bool _blob_match(const char *path, const char *data, uint32_t size)
+{
+	struct stat sbuf;
+	char *buf;
+	bool match;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY)) < 0)
+		return false;
+	if (fstat(fd, &sbuf) || (sbuf.st_size != size)) {
+		close(fd);
+		return false;
+	}
+
+	buf = xmalloc(size);
+	safe_read(fd, buf, size);
+	match = !memcmp(buf, data, size);
+	xfree(buf);
+	close(fd);
+	return match;
+
+rwfail:
+	xfree(buf);
+	close(fd);
+	return false;
+}
+
+/* Write through a temporary file so a blob is never seen partially written */
+static int _blob_write(const char *path, const char *data, uint32_t size)
+{
+	char *tmp = xstrdup_printf("%s.new", path);
+	int fd, rc = SLURM_SUCCESS;
+
+	if ((fd = creat(tmp, 0600)) < 0) {
+		error("Error creating file %s, %m", tmp);
+		xfree(tmp);
+		return ESLURM_WRITING_TO_FILE;
+	}
+
+	safe_write(fd, data, size);
+	close(fd);
+
+	if (rename(tmp, path)) {
+		error("Error renaming file %s to %s, %m", tmp, path);
+		rc = ESLURM_WRITING_TO_FILE;
+	}
+	if (rc)
+		(void) unlink(tmp);
+	xfree(tmp);
+	return rc;
+
+rwfail:
+	error("Error writing file %s, %m", tmp);
+	close(fd);
+	(void) unlink(tmp);
+	xfree(tmp);
+	return ESLURM_WRITING_TO_FILE;
+}
+
+extern int blob_store_put(const char *data, uint32_t size, char **key)
+{
+	blob_t *blob;
+	char *path = NULL;
+	int inx, rc = SLURM_SUCCESS;
+
+	*key = _make_key(data, size);
+
+	slurm_mutex_lock(&blob_mutex);
+	_init();
+
+	path = blob_store_path(*key);
+	if ((blob = xhash_get_str(blob_table, *key))) {
+		/* Stored by another job, make sure it is not a collision */
+		if (!_blob_match(path, data, size)) {
+			debug("%s: key %s collides with a stored blob",
+			      __func__, *key);
+			rc = SLURM_ERROR;
+			goto fini;
+		}
+		blob->ref_cnt++;
+		goto fini;
+	}
+
+	/* Not referenced, but possibly left over from an earlier job */
+	if (!_blob_match(path, data, size)) {
+		inx = _dir_inx(*key);
+		if (!(dirs_made & (1 << inx))) {
+			char *dir = xstrdup_printf("%s/blob.%x",
+						   slurm_conf.state_save_location,
+						   inx);
+			if (mkdir(dir, 0700) && (errno != EEXIST))
+				error("mkdir(%s) error %m", dir);
+			else
+				dirs_made |= (1 << inx);
+			xfree(dir);
+		}
+		if ((rc = _blob_write(path, data, size)))
+			goto fini;
+	}
+
+	blob = xmalloc(sizeof(*blob));
+	blob->key = xstrdup(*key);
+	blob->ref_cnt = 1;
+	xhash_add(blob_table, blob);
+
+fini:
+	slurm_mutex_unlock(&blob_mutex);
+	xfree(path);
+	if (rc)
+		xfree(*key);
+	return rc;
+}
+
+extern void blob_store_ref(const char *key)
+{
+	blob_t *blob;
+
+	if (!key)
+		return;
+
+	slurm_mutex_lock(&blob_mutex);
+	_init();
+	if ((blob = xhash_get_str(blob_table, key))) {
+		blob->ref_cnt++;
+	} else {
+		blob = xmalloc(sizeof(*blob));
+		blob->key = xstrdup(key);
+		blob->ref_cnt = 1;
+		xhash_add(blob_table, blob);
+	}
+	slurm_mutex_unlock(&blob_mutex);
+}
+
+extern void blob_store_unref(const char *key, bool purge)
+{
+	blob_t *blob;
+
+	if (!key)
+		return;
+
+	slurm_mutex_lock(&blob_mutex);
+	if (!blob_table || !(blob = xhash_get_str(blob_table, key))) {
+		error("%s: blob %s is not referenced", __func__, key);
+	} else if (blob->ref_cnt && --blob->ref_cnt) {
+		;	/* still in use */
+	} else if (purge) {
+		/* Keep the entry so a new reference can still claim it */
+		list_append(purge_list, xstrdup(key));
+	} else {
+		xhash_delete_str(blob_table, key);
+	}
+	slurm_mutex_unlock(&blob_mutex);
+}
+
+extern void blob_store_purge(void)
+{
+	blob_t *blob;
+	char *key, *path;
+
+	slurm_mutex_lock(&blob_mutex);
+	if (!purge_list) {
+		slurm_mutex_unlock(&blob_mutex);
+		return;
+	}
+	while ((key = list_dequeue(purge_list))) {
+		if ((blob = xhash_get_str(blob_table, key)) &&
+		    !blob->ref_cnt) {
+			path = blob_store_path(key);
+			debug2("%s: removing %s", __func__, path);
+			(void) unlink(path);
+			xfree(path);
+			xhash_delete_str(blob_table, key);
+		}
+		xfree(key);
+	}
+	slurm_mutex_unlock(&blob_mutex);
+}
+
+extern void blob_store_sync(void)
+{
+	DIR *dir;
+	struct dirent *ent;
+	blob_t *blob;
+	char *dir_name = NULL, *path = NULL;
+	int purged = 0;
+
+	slurm_mutex_lock(&blob_mutex);
+	_init();
+	for (int inx = 0; inx < BLOB_DIR_CNT; inx++) {
+		dir_name = xstrdup_printf("%s/blob.%x",
+					  slurm_conf.state_save_location, inx);
+		if (!(dir = opendir(dir_name))) {
+			xfree(dir_name);
+			continue;
+		}
+		dirs_made |= (1 << inx);
+		while ((ent = readdir(dir))) {
+			if (ent->d_name[0] == '.')
+				continue;
+			if ((blob = xhash_get_str(blob_table, ent->d_name)) &&
+			    blob->ref_cnt)
+				continue;
+			xstrfmtcat(path, "%s/%s", dir_name, ent->d_name);
+			(void) unlink(path);
+			xfree(path);
+			purged++;
+		}
+		closedir(dir);
+		xfree(dir_name);
+	}
+	slurm_mutex_unlock(&blob_mutex);
+
+	if (purged)
+		info("Purged %d unreferenced batch script and environment files",
+		     purged);
+}
+
+extern void blob_store_fini(void)
+{
+	slurm_mutex_lock(&blob_mutex);
+	xhash_free(blob_table);
+	FREE_NULL_LIST(purge_list);
+	dirs_made = 0;
+	slurm_mutex_unlock(&blob_mutex);
+}
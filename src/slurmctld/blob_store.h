@@ -0,0 +1,82 @@
+/*****************************************************************************\
+ *  blob_store.h - content addressed store for batch scripts and environments
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _HAVE_BLOB_STORE_H
+#define _HAVE_BLOB_STORE_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+/*
+ * Batch scripts and environments are stored once per distinct content in
+ * StateSaveLocation/blob.[0-f]/<key> and shared between the job records
+ * which reference them, rather than in a job.<id> directory per job.
+ */
+
+/*
+ * Store data, reusing an identical blob if one is already present.
+ * The caller holds one reference on the blob on success.
+ * IN data - content to store
+ * IN size - bytes of data
+ * OUT key - xmalloc'd key of the blob, NULL on error
+ * RET SLURM_SUCCESS or error code. An error is also returned if a different
+ *     blob with the same key is referenced, the caller then has to store the
+ *     data elsewhere.
+ */
+extern int blob_store_put(const char *data, uint32_t size, char **key);
+
+/* Take a reference on a stored blob (job array split, state recovery) */
+extern void blob_store_ref(const char *key);
+
+/*
+ * Drop a reference on a stored blob.
+ * IN purge - remove the blob from disk once no longer referenced, by the next
+ *	      blob_store_purge(). Otherwise it is left for blob_store_sync().
+ */
+extern void blob_store_unref(const char *key, bool purge);
+
+/* Return the xmalloc'd pathname of a blob */
+extern char *blob_store_path(const char *key);
+
+/* Return true if a blob is present on disk */
+extern bool blob_store_exists(const char *key);
+
+/* Remove blobs released with purge set, called without slurmctld locks */
+extern void blob_store_purge(void);
+
+/* Remove all blobs without any reference from the state save directory */
+extern void blob_store_sync(void);
+
+extern void blob_store_fini(void);
+
+#endif /* !_HAVE_BLOB_STORE_H */
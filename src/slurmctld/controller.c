@@ -88,6 +88,7 @@
 #include "src/common/slurm_topology.h"
 #include "src/common/switch.h"
 #include "src/common/timers.h"
+#include "src/common/trace.h"
 #include "src/common/track_script.h"
 #include "src/common/uid.h"
 #include "src/common/xcgroup_read_config.h"
@@ -96,6 +97,7 @@
 
 #include "src/slurmctld/acct_policy.h"
 #include "src/slurmctld/agent.h"
+#include "src/slurmctld/blob_store.h"
 #include "src/slurmctld/burst_buffer.h"
 #include "src/slurmctld/fed_mgr.h"
 #include "src/slurmctld/front_end.h"
@@ -110,6 +112,7 @@
 #include "src/slurmctld/power_save.h"
 #include "src/slurmctld/preempt.h"
 #include "src/slurmctld/proc_req.h"
+#include "src/slurmctld/profiler.h"
 #include "src/slurmctld/read_config.h"
 #include "src/slurmctld/reservation.h"
 #include "src/slurmctld/rpc_queue.h"
@@ -118,6 +121,7 @@
 #include "src/slurmctld/slurmctld_plugstack.h"
 #include "src/slurmctld/srun_comm.h"
 #include "src/slurmctld/state_save.h"
+#include "src/slurmctld/time_event.h"
 #include "src/slurmctld/trigger_mgr.h"
 
 
@@ -210,6 +214,17 @@ static int	recover   = DEFAULT_RECOVER;
 static pthread_mutex_t sched_cnt_mutex = PTHREAD_MUTEX_INITIALIZER;
 static char *	slurm_conf_filename;
 
+/*
+ * Connection service threads are kept for reuse rather than exiting after
+ * each RPC. Accepted connections are queued in srvcn_queue and picked up by
+ * an idle thread, or a new thread is created if none are idle.
+ */
+#define SRVCN_IDLE_TIMEOUT 60	/* seconds before an idle thread exits */
+static int	srvcn_idle_cnt = 0;
+static pthread_cond_t srvcn_cond = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t srvcn_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List	srvcn_queue = NULL;
+
 /*
  * Static list of signals to block in this process
  * *Must be zero-terminated*
@@ -242,7 +257,9 @@ static void *       _purge_files_thread(void *no_data);
 static void         _remove_assoc(slurmdb_assoc_rec_t *rec);
 static void         _remove_qos(slurmdb_qos_rec_t *rec);
 static void         _run_primary_prog(bool primary_on);
+static void         _queue_connection(int *newsockfd);
 static void *       _service_connection(void *arg);
+static void *       _service_thread(void *no_data);
 static void         _set_work_dir(void);
 static int          _shutdown_backup_controller(void);
 static void *       _slurmctld_background(void *no_data);
@@ -344,6 +361,9 @@ int main(int argc, char **argv)
 			error("daemon(): %m");
 		log_set_timefmt(slurm_conf.log_fmt);
 		log_alter(log_opts, LOG_DAEMON, slurm_conf.slurmctld_logfile);
+		/* The log writer thread does not survive xdaemon() */
+		log_set_async(xstrcasestr(slurm_conf.slurmctld_params,
+					  "async_logging"));
 		sched_log_alter(sched_log_opts, LOG_DAEMON,
 		                slurm_conf.sched_logfile);
 		sched_debug("slurmctld starting");
@@ -734,6 +754,7 @@ int main(int argc, char **argv)
 			fatal("failed to initialize power management plugin");
 		if (slurm_mcs_init() != SLURM_SUCCESS)
 			fatal("failed to initialize mcs plugin");
+		profiler_reconfig();
 
 		/*
 		 * create attached thread to process RPCs
@@ -852,6 +873,8 @@ int main(int argc, char **argv)
 			slurm_conf.slurmctld_pidfile);
 	}
 
+	profiler_fini();
+	trace_dump(slurm_conf.state_save_location, "slurmctld");
 
 #ifdef MEMORY_LEAK_DEBUG
 {
@@ -881,7 +904,9 @@ int main(int argc, char **argv)
 	configless_clear();
 	xcgroup_fini_slurm_cgroup_conf();
 	power_save_fini();
+	time_event_fini();
 	job_fini();
+	blob_store_fini();
 	part_fini();	/* part_fini() must precede node_fini() */
 	node_fini();
 	node_features_g_fini();
@@ -1029,6 +1054,8 @@ static void _reconfigure_slurm(void)
 	trigger_reconfig();
 	priority_g_reconfig(true);	/* notify priority plugin too */
 	save_all_state();		/* Has own locking */
+	trace_dump(slurm_conf.state_save_location, "slurmctld");
+	profiler_reconfig();
 	queue_job_scheduler();
 }
 
@@ -1210,8 +1237,7 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 			slurmctld_diag_stats.proc_req_raw++;
 			_service_connection(newsockfd);
 		} else {
-			slurm_thread_create_detached(NULL, _service_connection,
-						     newsockfd);
+			_queue_connection(newsockfd);
 		}
 	}
 
@@ -1220,6 +1246,11 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 		close(fds[i].fd);
 	xfree(fds);
 
+	/* Wake idle service threads so they notice the shutdown */
+	slurm_mutex_lock(&srvcn_mutex);
+	slurm_cond_broadcast(&srvcn_cond);
+	slurm_mutex_unlock(&srvcn_mutex);
+
 	rpc_queue_shutdown();
 
 	server_thread_decr();
@@ -1227,6 +1258,54 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 	return NULL;
 }
 
+/*
+ * _queue_connection - hand an accepted connection to an idle service thread,
+ *	creating a new one if every existing thread is busy
+ * IN newsockfd - the connection's file descriptor, freed upon completion
+ */
+static void _queue_connection(int *newsockfd)
+{
+	slurm_mutex_lock(&srvcn_mutex);
+	if (!srvcn_queue)
+		srvcn_queue = list_create(NULL);
+	list_enqueue(srvcn_queue, newsockfd);
+	if (srvcn_idle_cnt >= list_count(srvcn_queue))
+		slurm_cond_signal(&srvcn_cond);
+	else
+		slurm_thread_create_detached(NULL, _service_thread, NULL);
+	slurm_mutex_unlock(&srvcn_mutex);
+}
+
+/*
+ * _service_thread - service queued connections until idle for
+ *	SRVCN_IDLE_TIMEOUT seconds or shutdown
+ */
+static void *_service_thread(void *no_data)
+{
+	struct timespec ts = {0, 0};
+	int *newsockfd;
+
+	while (true) {
+		slurm_mutex_lock(&srvcn_mutex);
+		ts.tv_sec = time(NULL) + SRVCN_IDLE_TIMEOUT;
+		while (!(newsockfd = list_dequeue(srvcn_queue))) {
+			if (slurmctld_config.shutdown_time ||
+			    (time(NULL) >= ts.tv_sec))
+				break;
+			srvcn_idle_cnt++;
+			slurm_cond_timedwait(&srvcn_cond, &srvcn_mutex, &ts);
+			srvcn_idle_cnt--;
+		}
+		slurm_mutex_unlock(&srvcn_mutex);
+
+		if (!newsockfd)
+			break;
+		_service_connection(newsockfd);
+	}
+
+	return NULL;
+}
+
 /*
  * _service_connection - service the RPC
  * IN/OUT arg - really just the connection's file descriptor, freed
@@ -1880,7 +1959,7 @@ static void *_slurmctld_background(void *no_data)
 	static time_t last_ctld_bu_ping;
 	static time_t last_uid_update;
 	static time_t last_reboot_msg_time;
-	time_t now;
+	time_t now, next_event;
 	int no_resp_msg_interval, ping_interval, purge_job_interval;
 	int i;
 	DEF_TIMERS;
@@ -2021,6 +2100,13 @@ static void *_slurmctld_background(void *no_data)
 			unlock_slurmctld(node_write_lock);
 		}
 
+		/* Reboots of the jobs started since the last pass */
+		if (reboot_nodes_queued()) {
+			lock_slurmctld(node_write_lock2);
+			reboot_nodes_flush();
+			unlock_slurmctld(node_write_lock2);
+		}
+
 		if (difftime(now, last_no_resp_msg_time) >=
 		    no_resp_msg_interval) {
 			lock_slurmctld(node_write_lock2);
@@ -2032,6 +2118,12 @@ static void *_slurmctld_background(void *no_data)
 
 		validate_all_reservations(true);
 
+		if ((next_event = time_event_next()) && (next_event <= now)) {
+			lock_slurmctld(job_write_lock);
+			time_event_run();
+			unlock_slurmctld(job_write_lock);
+		}
+
 		if (difftime(now, last_timelimit_time) >= PERIODIC_TIMEOUT) {
 			lock_slurmctld(job_write_lock);
 			now = time(NULL);
@@ -2850,6 +2942,8 @@ void update_logging(void)
 	          slurm_conf.slurmctld_logfile);
 
 	log_set_timefmt(slurm_conf.log_fmt);
+	log_set_async(xstrcasestr(slurm_conf.slurmctld_params,
+				  "async_logging"));
 
 	debug("Log file re-opened");
 
@@ -3395,6 +3489,7 @@ static void *_purge_files_thread(void *no_data)
 			delete_job_desc_files(*job_id);
 			xfree(job_id);
 		}
+		blob_store_purge();
 	}
 	slurm_mutex_unlock(&purge_thread_lock);
 	return NULL;
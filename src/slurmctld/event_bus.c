@@ -0,0 +1,239 @@
+/*****************************************************************************\
+ *  event_bus.c - bounded ring of job and node state change events
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#include <pthread.h>
+
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "src/slurmctld/event_bus.h"
+#include "src/slurmctld/slurmctld.h"
+
+#define EVENT_BUS_SIZE 65536	/* default SlurmctldParameters=event_bus_size */
+#define EVENT_BUS_MAX_RESP 10000	/* events per response */
+#define EVENT_BUS_MAX_WAIT 60	/* longest wait for an event, seconds */
+#define EVENT_BUS_MAX_WAITERS 64	/* RPC threads waiting at once */
+
+/*
+ * Event i is at ring[i % ring_size]. Sequence numbers start at 1 and the
+ * oldest events are overwritten once the ring is full; consumers see the
+ * gap in the sequence numbers.
+ */
+static pthread_mutex_t event_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t event_cond = PTHREAD_COND_INITIALIZER;
+static ctld_event_t *ring = NULL;
+static uint32_t ring_size = 0;
+static uint64_t next_seq = 1;
+static int waiters = 0;
+static bool configured = false;
+
+static void _config(void)
+{
+	char *tmp;
+
+	configured = true;
+	ring_size = EVENT_BUS_SIZE;
+	if ((tmp = xstrcasestr(slurm_conf.slurmctld_params,
+			       "event_bus_size=")))
+		ring_size = strtoul(tmp + strlen("event_bus_size="), NULL, 10);
+	if (ring_size)
+		ring = xcalloc(ring_size, sizeof(ctld_event_t));
+}
+
+static uint64_t _first_seq(void)
+{
+	if (next_seq > ring_size)
+		return next_seq - ring_size;
+	return 1;
+}
+
+static ctld_event_t *_record(uint32_t type)
+{
+	ctld_event_t *event;
+
+	if (!configured)
+		_config();
+	if (!ring_size)
+		return NULL;
+
+	event = &ring[next_seq % ring_size];
+	slurm_free_ctld_event_members(event);
+	memset(event, 0, sizeof(*event));
+	event->seq = next_seq++;
+	event->time = time(NULL);
+	event->type = type;
+
+	return event;
+}
+
+extern void event_bus_job(job_record_t *job_ptr, uint32_t type)
+{
+	ctld_event_t *event;
+
+	slurm_mutex_lock(&event_mutex);
+	if ((event = _record(type))) {
+		event->job_id = job_ptr->job_id;
+		event->user_id = job_ptr->user_id;
+		event->state = job_ptr->job_state;
+		event->partition = xstrdup(job_ptr->partition);
+		slurm_cond_broadcast(&event_cond);
+	}
+	slurm_mutex_unlock(&event_mutex);
+}
+
+extern void event_bus_node(node_record_t *node_ptr, uint32_t type)
+{
+	ctld_event_t *event;
+
+	slurm_mutex_lock(&event_mutex);
+	if ((event = _record(type))) {
+		event->user_id = NO_VAL;
+		event->state = node_ptr->node_state;
+		event->node_name = xstrdup(node_ptr->name);
+		slurm_cond_broadcast(&event_cond);
+	}
+	slurm_mutex_unlock(&event_mutex);
+}
+
+/* Match a partition name against the job's comma separated partitions */
+static bool _part_match(char *part_list, char *part)
+{
+	char *tmp, *tok, *save_ptr = NULL;
+	bool match = false;
+
+	if (!part_list)
+		return false;
+
+	tmp = xstrdup(part_list);
+	tok = strtok_r(tmp, ",", &save_ptr);
+	while (tok && !(match = !xstrcmp(tok, part)))
+		tok = strtok_r(NULL, ",", &save_ptr);
+	xfree(tmp);
+
+	return match;
+}
+
+static bool _filter_match(ctld_event_filter_t *filter, ctld_event_t *event)
+{
+	if (filter->type_mask && !(filter->type_mask & event->type))
+		return false;
+	if (event->node_name)
+		return true;
+	if ((filter->user_id != NO_VAL) && (filter->user_id != event->user_id))
+		return false;
+	if (filter->partition && !_part_match(event->partition,
+					      filter->partition))
+		return false;
+
+	return true;
+}
+
+/* Copy the events after *since matching the filter, advancing *since */
+static void _collect(ctld_event_req_msg_t *req, uint64_t *since,
+		     ctld_event_msg_t *resp)
+{
+	ctld_event_t *event, *copy;
+	uint64_t seq;
+
+	if ((*since + 1) < _first_seq())
+		*since = _first_seq() - 1;
+
+	for (seq = *since + 1;
+	     (seq < next_seq) && (resp->record_count < EVENT_BUS_MAX_RESP);
+	     seq++) {
+		event = &ring[seq % ring_size];
+		*since = seq;
+		if (!_filter_match(&req->filter, event))
+			continue;
+		xrecalloc(resp->event_array, resp->record_count + 1,
+			  sizeof(ctld_event_t));
+		copy = &resp->event_array[resp->record_count++];
+		*copy = *event;
+		copy->node_name = xstrdup(event->node_name);
+		copy->partition = xstrdup(event->partition);
+	}
+}
+
+extern void event_bus_get(ctld_event_req_msg_t *req, ctld_event_msg_t *resp)
+{
+	time_t end = time(NULL) + MIN(req->wait, EVENT_BUS_MAX_WAIT);
+	struct timespec ts = { 0, 0 };
+	uint64_t since;
+
+	slurm_mutex_lock(&event_mutex);
+	if (!configured)
+		_config();
+	if (!ring_size) {
+		slurm_mutex_unlock(&event_mutex);
+		return;
+	}
+
+	if (!req->since_seq)
+		since = next_seq - 1;
+	else if (req->since_seq >= next_seq)
+		since = 0;	/* slurmctld restarted, send all we have */
+	else
+		since = req->since_seq;
+
+	while (true) {
+		_collect(req, &since, resp);
+		if (resp->record_count || (time(NULL) >= end) ||
+		    slurmctld_config.shutdown_time ||
+		    (waiters >= EVENT_BUS_MAX_WAITERS))
+			break;
+		/* Wake up every second to notice shutdown */
+		ts.tv_sec = MIN(time(NULL) + 1, end);
+		waiters++;
+		slurm_cond_timedwait(&event_cond, &event_mutex, &ts);
+		waiters--;
+	}
+	resp->first_seq = _first_seq();
+	resp->next_seq = since + 1;
+	slurm_mutex_unlock(&event_mutex);
+}
+
+extern void event_bus_fini(void)
+{
+	uint32_t i;
+
+	slurm_mutex_lock(&event_mutex);
+	for (i = 0; i < ring_size; i++)
+		slurm_free_ctld_event_members(&ring[i]);
+	xfree(ring);
+	ring_size = 0;
+	configured = false;
+	slurm_mutex_unlock(&event_mutex);
+}
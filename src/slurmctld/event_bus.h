@@ -0,0 +1,61 @@
+/*****************************************************************************\
+ *  event_bus.h - bounded ring of job and node state change events
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#ifndef _HAVE_EVENT_BUS_H
+#define _HAVE_EVENT_BUS_H
+
+#include "src/common/slurm_protocol_defs.h"
+#include "src/slurmctld/slurmctld.h"
+
+/*
+ * Record a job state change, type is one of the CTLD_EVENT_JOB_* values.
+ * NOTE: Call with the job write lock held.
+ */
+extern void event_bus_job(job_record_t *job_ptr, uint32_t type);
+
+/*
+ * Record a node state change, type is one of the CTLD_EVENT_NODE_* values.
+ * NOTE: Call with the node write lock held.
+ */
+extern void event_bus_node(node_record_t *node_ptr, uint32_t type);
+
+/*
+ * Fill resp with the events matching req, waiting up to req->wait seconds
+ * for one if there are none yet. Needs no slurmctld locks.
+ */
+extern void event_bus_get(ctld_event_req_msg_t *req, ctld_event_msg_t *resp);
+
+extern void event_bus_fini(void);
+
+#endif /* !_HAVE_EVENT_BUS_H */
@@ -48,6 +48,7 @@
 #include "src/common/parse_time.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurmdbd_defs.h"
+#include "src/common/xhash.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 #include "src/slurmctld/fed_mgr.h"
@@ -62,6 +63,7 @@
 #define FED_MGR_STATE_FILE       "fed_mgr_state"
 #define FED_MGR_CLUSTER_ID_BEGIN 26
 #define TEST_REMOTE_DEP_FREQ 30 /* seconds */
+#define FED_SIB_LOAD_FREQ 30 /* seconds */
 
 #define FED_SIBLING_BIT(x) ((uint64_t)1 << (x - 1))
 
@@ -83,7 +85,7 @@ static pthread_mutex_t open_send_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t init_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t update_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-static List fed_job_list        = NULL;
+static xhash_t *fed_job_hash     = NULL;
 static List fed_job_update_list = NULL;
 static pthread_t       fed_job_update_thread_id = (pthread_t) 0;
 static pthread_mutex_t fed_job_list_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -104,6 +106,20 @@ static pthread_t origin_dep_thread_id = (pthread_t) 0;
 static pthread_cond_t origin_dep_cond = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t origin_dep_update_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/*
+ * Latest load summary of each cluster, indexed by cluster id. Used to route
+ * new sibling jobs with FederationParameters=sibling_submit_limit.
+ */
+typedef struct {
+	uint32_t idle_nodes;
+	uint32_t pending_jobs;
+	time_t   start_time;	/* expected start of a job submitted now */
+	time_t   update_time;	/* when the summary was received */
+} sib_load_t;
+
+static sib_load_t sib_load[MAX_FED_CLUSTERS + 1];
+static pthread_mutex_t sib_load_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 typedef struct {
 	buf_t *buffer;
 	uint32_t   job_id;
@@ -126,6 +142,7 @@ enum fed_job_update_type {
 	FED_JOB_UPDATE,
 	FED_JOB_UPDATE_RESPONSE,
 	FED_SEND_JOB_SYNC,
+	FED_SIB_LOAD,
 };
 
 typedef struct {
@@ -205,6 +222,8 @@ static char *_job_update_type_str(enum fed_job_update_type type)
 		return "FED_JOB_UPDATE_RESPONSE";
 	case FED_SEND_JOB_SYNC:
 		return "FED_SEND_JOB_SYNC";
+	case FED_SIB_LOAD:
+		return "FED_SIB_LOAD";
 	default:
 		return "?";
 	}
@@ -1245,53 +1264,43 @@ extern void add_fed_job_info(job_record_t *job_ptr)
 	job_info->siblings_viable = job_ptr->fed_details->siblings_viable;
 
 	slurm_mutex_lock(&fed_job_list_mutex);
-	if (fed_job_list)
-		list_append(fed_job_list, job_info);
+	if (fed_job_hash)
+		xhash_add(fed_job_hash, job_info);
 	else
 		xfree(job_info);
 	slurm_mutex_unlock(&fed_job_list_mutex);
 }
 
-static int _delete_fed_job_info_by_id(void *object, void *arg)
+static void _fed_job_info_idfunc(void *item, const char **key,
+				 uint32_t *key_len)
 {
-	fed_job_info_t *job_info = (fed_job_info_t *)object;
-	uint32_t job_id          = *(uint32_t *)arg;
-
-	if (job_info->job_id == job_id)
-		return true;
+	fed_job_info_t *job_info = item;
 
-	return false;
+	*key = (const char *) &job_info->job_id;
+	*key_len = sizeof(job_info->job_id);
 }
 
 extern void fed_mgr_remove_fed_job_info(uint32_t job_id)
 {
+	fed_job_info_t *job_info;
+
 	slurm_mutex_lock(&fed_job_list_mutex);
 
-	if (fed_job_list)
-		list_delete_all(fed_job_list, _delete_fed_job_info_by_id,
-				&job_id);
+	/* Called on every job purge, so avoid scanning all fed jobs */
+	while (fed_job_hash &&
+	       (job_info = xhash_pop(fed_job_hash, (char *) &job_id,
+				     sizeof(job_id))))
+		xfree(job_info);
 
 	slurm_mutex_unlock(&fed_job_list_mutex);
 }
 
-static int _list_find_fed_job_info_by_jobid(void *x, void *key)
-{
-	fed_job_info_t *job_info = (fed_job_info_t *)x;
-	uint32_t        job_id   = *(uint32_t *)key;
-
-	if (job_info->job_id == job_id)
-		return 1;
-
-	return 0;
-}
-
 /* Must have fed_job_mutex before entering */
 static fed_job_info_t *_find_fed_job_info(uint32_t job_id)
 {
-	if (!fed_job_list)
+	if (!fed_job_hash)
 		return NULL;
-	return list_find_first(fed_job_list, _list_find_fed_job_info_by_jobid,
-			       &job_id);
+	return xhash_get(fed_job_hash, (char *) &job_id, sizeof(job_id));
 }
 
 static void _destroy_fed_job_update_info(void *object)
@@ -2530,6 +2539,109 @@ static void *_fed_job_update_thread(void *arg)
 }
 
 /* Start a thread to manage queued agent requests */
+/*
+ * Return the maximum count of siblings, besides the origin, that a federated
+ * job is submitted to, or 0 to submit to all viable siblings.
+ */
+static int _get_sib_submit_limit(void)
+{
+	char *tmp_ptr;
+
+	if ((tmp_ptr = xstrcasestr(slurm_conf.fed_params,
+				   "sibling_submit_limit=")))
+		return atoi(tmp_ptr + strlen("sibling_submit_limit="));
+
+	return 0;
+}
+
+static void _set_sib_load(uint32_t cluster_id, uint32_t idle_nodes,
+			  uint32_t pending_jobs, time_t start_time)
+{
+	if (!cluster_id || (cluster_id > MAX_FED_CLUSTERS)) {
+		error("%s: invalid cluster id %u", __func__, cluster_id);
+		return;
+	}
+
+	log_flag(FEDR, "%s: cluster %u idle_nodes:%u pending_jobs:%u start_time:%ld",
+		 __func__, cluster_id, idle_nodes, pending_jobs,
+		 (long) start_time);
+
+	slurm_mutex_lock(&sib_load_mutex);
+	sib_load[cluster_id].idle_nodes = idle_nodes;
+	sib_load[cluster_id].pending_jobs = pending_jobs;
+	sib_load[cluster_id].start_time = start_time;
+	sib_load[cluster_id].update_time = time(NULL);
+	slurm_mutex_unlock(&sib_load_mutex);
+}
+
+/*
+ * Summarize the load of this cluster and send it to the siblings. The
+ * expected start of a new job is the latest start time estimated by the
+ * backfill scheduler for the jobs already pending here.
+ */
+static void _send_sib_load(void)
+{
+	ListIterator itr;
+	job_record_t *job_ptr;
+	slurmdb_cluster_rec_t *sibling;
+	sib_msg_t sib_msg = {0};
+	slurm_msg_t req_msg;
+	time_t now = time(NULL);
+
+	slurmctld_lock_t load_read_lock = {
+		NO_LOCK, READ_LOCK, READ_LOCK, NO_LOCK, READ_LOCK };
+
+	lock_slurmctld(load_read_lock);
+	if (!fed_mgr_fed_rec || !fed_mgr_fed_rec->cluster_list ||
+	    !fed_mgr_cluster_rec)
+		goto fini;
+
+	if (avail_node_bitmap && idle_node_bitmap)
+		sib_msg.idle_nodes = bit_overlap(avail_node_bitmap,
+						 idle_node_bitmap);
+
+	itr = list_iterator_create(job_list);
+	while ((job_ptr = list_next(itr))) {
+		if (!IS_JOB_PENDING(job_ptr) || IS_JOB_REVOKED(job_ptr))
+			continue;
+		sib_msg.pending_jobs++;
+		if (job_ptr->start_time > sib_msg.start_time)
+			sib_msg.start_time = job_ptr->start_time;
+	}
+	list_iterator_destroy(itr);
+	if (sib_msg.start_time < now)
+		sib_msg.start_time = now;
+
+	sib_msg.sib_msg_type = FED_SIB_LOAD;
+	sib_msg.cluster_id   = fed_mgr_cluster_rec->fed.id;
+	_set_sib_load(sib_msg.cluster_id, sib_msg.idle_nodes,
+		      sib_msg.pending_jobs, sib_msg.start_time);
+
+	slurm_msg_t_init(&req_msg);
+	req_msg.msg_type = REQUEST_SIB_MSG;
+	req_msg.data     = &sib_msg;
+
+	itr = list_iterator_create(fed_mgr_fed_rec->cluster_list);
+	while ((sibling = list_next(itr))) {
+		if ((sibling == fed_mgr_cluster_rec) ||
+		    (sibling->rpc_version < SLURM_21_08_PROTOCOL_VERSION) ||
+		    !sibling->fed.send ||
+		    (((slurm_persist_conn_t *)sibling->fed.send)->fd < 0))
+			continue;
+
+		/* Don't pile summaries up behind RPCs that are failing */
+		if (sibling->send_rpc && list_count(sibling->send_rpc))
+			continue;
+
+		req_msg.protocol_version = sibling->rpc_version;
+		(void) _queue_rpc(sibling, &req_msg, 0, false);
+	}
+	list_iterator_destroy(itr);
+
+fini:
+	unlock_slurmctld(load_read_lock);
+}
+
 static void *_agent_thread(void *arg)
 {
 	slurmdb_cluster_rec_t *cluster;
@@ -2540,6 +2652,7 @@ static void *_agent_thread(void *arg)
 	ctld_list_msg_t ctld_req_msg;
 	bitstr_t *success_bits;
 	int rc, resp_inx, success_size;
+	time_t last_load = 0;
 
 	slurmctld_lock_t fed_read_lock = {
 		NO_LOCK, NO_LOCK, NO_LOCK, NO_LOCK, READ_LOCK };
@@ -2562,6 +2675,12 @@ static void *_agent_thread(void *arg)
 		if (slurmctld_config.shutdown_time)
 			break;
 
+		if (_get_sib_submit_limit() &&
+		    ((time(NULL) - last_load) >= FED_SIB_LOAD_FREQ)) {
+			_send_sib_load();
+			last_load = time(NULL);
+		}
+
 		lock_slurmctld(fed_read_lock);
 		if (!fed_mgr_fed_rec || !fed_mgr_fed_rec->cluster_list) {
 			unlock_slurmctld(fed_read_lock);
@@ -2779,8 +2898,8 @@ extern int fed_mgr_init(void *db_conn)
 		goto end_it;
 
 	slurm_mutex_lock(&fed_job_list_mutex);
-	if (!fed_job_list)
-		fed_job_list = list_create(xfree_ptr);
+	if (!fed_job_hash)
+		fed_job_hash = xhash_init(_fed_job_info_idfunc, xfree_ptr);
 	slurm_mutex_unlock(&fed_job_list_mutex);
 
 	/*
@@ -2955,7 +3074,7 @@ extern int fed_mgr_fini(void)
 	_remove_job_watch_thread();
 
 	slurm_mutex_lock(&fed_job_list_mutex);
-	FREE_NULL_LIST(fed_job_list);
+	xhash_free(fed_job_hash);
 	slurm_mutex_unlock(&fed_job_list_mutex);
 
 	FREE_NULL_LIST(fed_job_update_list);
@@ -3122,10 +3241,25 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+typedef struct {
+	buf_t *buffer;
+	uint16_t protocol_version;
+} pack_fed_job_info_args_t;
+
+static void _pack_fed_job_info_walk(void *item, void *arg)
+{
+	pack_fed_job_info_args_t *args = arg;
+
+	_pack_fed_job_info(item, args->buffer, args->protocol_version);
+}
+
 static void _dump_fed_job_list(buf_t *buffer, uint16_t protocol_version)
 {
 	uint32_t count = NO_VAL;
-	fed_job_info_t *fed_job_info;
+	pack_fed_job_info_args_t args = {
+		.buffer = buffer,
+		.protocol_version = protocol_version,
+	};
 
 	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		/*
@@ -3133,20 +3267,15 @@ static void _dump_fed_job_list(buf_t *buffer, uint16_t protocol_version)
 		 * the count and actually looping on the list.
 		 */
 		slurm_mutex_lock(&fed_job_list_mutex);
-		if (fed_job_list)
-			count = list_count(fed_job_list);
+		if (fed_job_hash)
+			count = xhash_count(fed_job_hash);
 		else
 			count = NO_VAL;
 
 		pack32(count, buffer);
-		if (count && (count != NO_VAL)) {
-			ListIterator itr = list_iterator_create(fed_job_list);
-			while ((fed_job_info = list_next(itr))) {
-				_pack_fed_job_info(fed_job_info, buffer,
-						   protocol_version);
-			}
-			list_iterator_destroy(itr);
-		}
+		if (count && (count != NO_VAL))
+			xhash_walk(fed_job_hash, _pack_fed_job_info_walk,
+				   &args);
 		slurm_mutex_unlock(&fed_job_list_mutex);
 	} else {
 		error("%s: protocol_version %hu not supported.",
@@ -3461,11 +3590,11 @@ static slurmdb_federation_rec_t *_state_load(char *state_save_location)
 		fed_job_info_t *tmp_info;
 
 		slurm_mutex_lock(&fed_job_list_mutex);
-		if (fed_job_list) {
+		if (fed_job_hash) {
 			lock_slurmctld(job_read_lock);
 			while ((tmp_info = list_pop(tmp_list))) {
 				if (find_job_record(tmp_info->job_id))
-					list_append(fed_job_list, tmp_info);
+					xhash_add(fed_job_hash, tmp_info);
 				else
 					xfree(tmp_info);
 			}
@@ -3721,9 +3850,76 @@ extern int fed_mgr_update_job(uint32_t job_id, job_desc_msg_t *job_specs,
  * 	fails, then the successful siblings will be updated with the correct
  * 	sibling bitmap.
  */
+typedef struct {
+	uint32_t cluster_id;
+	bool     known;		/* a recent load summary was received */
+	uint32_t idle_nodes;
+	uint32_t pending_jobs;
+	time_t   start_time;
+} sib_rank_t;
+
+/* Sort siblings expected to start a new job soonest first */
+static int _cmp_sib_rank(const void *x, const void *y)
+{
+	const sib_rank_t *sib1 = x, *sib2 = y;
+
+	if (sib1->known != sib2->known)
+		return sib1->known ? -1 : 1;
+	if (sib1->start_time != sib2->start_time)
+		return (sib1->start_time < sib2->start_time) ? -1 : 1;
+	if (sib1->idle_nodes != sib2->idle_nodes)
+		return (sib1->idle_nodes > sib2->idle_nodes) ? -1 : 1;
+	if (sib1->pending_jobs != sib2->pending_jobs)
+		return (sib1->pending_jobs < sib2->pending_jobs) ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Reduce dest_sibs to the siblings expected to start the job soonest, so that
+ * including the siblings already running a sibling job at most "limit"
+ * siblings besides this cluster get the job.
+ */
+static uint64_t _route_sibs(uint64_t dest_sibs, uint64_t active_sibs,
+			    int limit)
+{
+	sib_rank_t ranks[MAX_FED_CLUSTERS];
+	uint64_t route_sibs = 0, sib_bit;
+	time_t stale = time(NULL) - (FED_SIB_LOAD_FREQ * 3);
+	int cnt = 0, i;
+
+	slurm_mutex_lock(&sib_load_mutex);
+	for (i = 1; i <= MAX_FED_CLUSTERS; i++) {
+		if (i == fed_mgr_cluster_rec->fed.id)
+			continue;
+		sib_bit = FED_SIBLING_BIT(i);
+		if (active_sibs & sib_bit) {
+			limit--;
+			continue;
+		}
+		if (!(dest_sibs & sib_bit))
+			continue;
+
+		ranks[cnt].cluster_id = i;
+		ranks[cnt].known = (sib_load[i].update_time > stale);
+		ranks[cnt].idle_nodes = sib_load[i].idle_nodes;
+		ranks[cnt].pending_jobs = sib_load[i].pending_jobs;
+		ranks[cnt].start_time = sib_load[i].start_time;
+		cnt++;
+	}
+	slurm_mutex_unlock(&sib_load_mutex);
+
+	if (cnt > limit)
+		qsort(ranks, cnt, sizeof(sib_rank_t), _cmp_sib_rank);
+	for (i = 0; (i < cnt) && (i < limit); i++)
+		route_sibs |= FED_SIBLING_BIT(ranks[i].cluster_id);
+
+	return route_sibs;
+}
+
 static int _submit_sibling_jobs(job_desc_msg_t *job_desc, slurm_msg_t *msg,
 				bool alloc_only, uint64_t dest_sibs)
 {
+	int limit;
 	int ret_rc = SLURM_SUCCESS;
 	ListIterator sib_itr;
 	sib_msg_t sib_msg = {0};
@@ -3735,6 +3931,18 @@ static int _submit_sibling_jobs(job_desc_msg_t *job_desc, slurm_msg_t *msg,
 	xassert(job_desc);
 	xassert(msg);
 
+	if ((limit = _get_sib_submit_limit())) {
+		dest_sibs = _route_sibs(dest_sibs,
+					job_desc->fed_siblings_active, limit);
+		if (slurm_conf.debug_flags & DEBUG_FLAG_FEDR) {
+			char *sib_names = fed_mgr_cluster_ids_to_names(
+				dest_sibs);
+			log_flag(FEDR, "%s: JobId=%u routed to siblings %s",
+				 __func__, job_desc->job_id, sib_names);
+			xfree(sib_names);
+		}
+	}
+
 	sib_msg.data_buffer  = msg->buffer;
 	sib_msg.data_offset  = msg->body_offset;
 	sib_msg.data_type    = msg->msg_type;
@@ -5432,9 +5640,21 @@ extern int fed_mgr_update_job_cluster_features(job_record_t *job_ptr,
 	return rc;
 }
 
+static int _cmp_job_info_by_id(const void *x, const void *y)
+{
+	const slurm_job_info_t *job1 = x, *job2 = y;
+
+	if (job1->job_id < job2->job_id)
+		return -1;
+	if (job1->job_id > job2->job_id)
+		return 1;
+	return 0;
+}
+
+/* job_info_msg->job_array must be sorted with _cmp_job_info_by_id() */
 static int _reconcile_fed_job(job_record_t *job_ptr, reconcile_sib_t *rec_sib)
 {
-	int i;
+	slurm_job_info_t key;
 	bool found_job = false;
 	job_info_msg_t *remote_jobs_ptr = rec_sib->job_info_msg;
 	uint32_t origin_id    = fed_mgr_get_cluster_id(job_ptr->job_id);
@@ -5463,13 +5683,12 @@ static int _reconcile_fed_job(job_record_t *job_ptr, reconcile_sib_t *rec_sib)
 		return SLURM_SUCCESS;
 	}
 
-	for (i = 0; i < remote_jobs_ptr->record_count; i++) {
-		remote_job = &remote_jobs_ptr->job_array[i];
-		if (job_ptr->job_id == remote_job->job_id) {
-			found_job = true;
-			break;
-		}
-	}
+	key.job_id = job_ptr->job_id;
+	if ((remote_job = bsearch(&key, remote_jobs_ptr->job_array,
+				  remote_jobs_ptr->record_count,
+				  sizeof(slurm_job_info_t),
+				  _cmp_job_info_by_id)))
+		found_job = true;
 
 	/* Jobs that originated on the remote sibling */
 	if (origin_id == sibling_id) {
@@ -5722,6 +5941,11 @@ static int _sync_jobs(const char *sib_name, job_info_msg_t *job_info_msg,
 	rec_sib.job_info_msg = job_info_msg;
 	rec_sib.sync_time    = sync_time;
 
+	/* Sort once so each local job is found with a binary search */
+	if (job_info_msg->record_count)
+		qsort(job_info_msg->job_array, job_info_msg->record_count,
+		      sizeof(slurm_job_info_t), _cmp_job_info_by_id);
+
 	itr = list_iterator_create(job_list);
 	while ((job_ptr = list_next(itr)))
 		_reconcile_fed_job(job_ptr, &rec_sib);
@@ -6077,6 +6301,10 @@ extern int fed_mgr_q_sib_msg(slurm_msg_t *msg, uint32_t rpc_uid)
 	case FED_JOB_UPDATE_RESPONSE:
 		_q_sib_job_update_response(msg);
 		break;
+	case FED_SIB_LOAD:
+		_set_sib_load(sib_msg->cluster_id, sib_msg->idle_nodes,
+			      sib_msg->pending_jobs, sib_msg->start_time);
+		break;
 	default:
 		error("%s: invalid sib_msg_type: %d",
 		      __func__, sib_msg->sib_msg_type);
@@ -56,6 +56,7 @@
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/slurmctld.h"
+#include "src/slurmctld/state_replica.h"
 #include "src/slurmctld/state_save.h"
 #include "src/slurmctld/trigger_mgr.h"
 
@@ -96,6 +97,9 @@ static buf_t *_open_front_end_state_file(char **state_file)
 	*state_file = xstrdup(slurm_conf.state_save_location);
 	xstrcat(*state_file, "/front_end_state");
 
+	if ((buf = state_replica_open(*state_file)))
+		return buf;
+
 	if (!(buf = create_mmap_buf(*state_file)))
 		error("Could not open front_end state file %s: %m",
 		      *state_file);
@@ -742,6 +746,8 @@ extern int dump_all_front_end_state(void)
 	xfree (new_file);
 	unlock_state_files ();
 
+	if (!error_code)
+		state_replica_send("front_end_state", buffer);
 	free_buf (buffer);
 	END_TIMER2("dump_all_front_end_state");
 	return error_code;
@@ -89,6 +89,7 @@ struct gs_job {
 	job_record_t *job_ptr;
 	uint16_t sig_state;
 	uint16_t row_state;
+	bool shadow_cast;	/* in shadow[] of all lower priority parts */
 };
 
 struct gs_part {
@@ -674,6 +675,14 @@ static void _cast_shadow(struct gs_job *j_ptr, uint16_t priority)
 	struct gs_part *p_ptr;
 	int i;
 
+	/*
+	 * Partition priorities only change on reconfig, which rebuilds every
+	 * gs_job, so a job cast once is already in every shadow[] it belongs in.
+	 */
+	if (j_ptr->shadow_cast)
+		return;
+	j_ptr->shadow_cast = true;
+
 	part_iterator = list_iterator_create(gs_part_list);
 	while ((p_ptr = list_next(part_iterator))) {
 		if (p_ptr->priority >= priority)
@@ -714,6 +723,10 @@ static void _clear_shadow(struct gs_job *j_ptr)
 	struct gs_part *p_ptr;
 	int i;
 
+	if (!j_ptr->shadow_cast)
+		return;
+	j_ptr->shadow_cast = false;
+
 	part_iterator = list_iterator_create(gs_part_list);
 	while ((p_ptr = list_next(part_iterator))) {
 		if (!p_ptr->shadow)
@@ -1429,26 +1442,28 @@ static void _build_active_row(struct gs_part *p_ptr)
  */
 static void _cycle_job_list(struct gs_part *p_ptr)
 {
-	int i, j;
-	struct gs_job *j_ptr;
+	int i, j, k;
+	struct gs_job *j_ptr, **active_list;
 	uint16_t preempt_mode;
 
 	log_flag(GANG, "gang: entering %s", __func__);
-	/* re-prioritize the job_list and set all row_states to GS_NO_ACTIVE */
-	for (i = 0; i < p_ptr->num_jobs; i++) {
-		while (p_ptr->job_list[i]->row_state == GS_ACTIVE) {
-			/* move this job to the back row and "deactivate" it */
-			j_ptr = p_ptr->job_list[i];
-			j_ptr->row_state = GS_NO_ACTIVE;
-			for (j = i; j+1 < p_ptr->num_jobs; j++) {
-				p_ptr->job_list[j] = p_ptr->job_list[j+1];
-			}
-			p_ptr->job_list[j] = j_ptr;
+	/*
+	 * re-prioritize the job_list and set all row_states to GS_NO_ACTIVE.
+	 * Active jobs move to the back of the list preserving their order
+	 * among each other, done as a single stable partition pass.
+	 */
+	active_list = xcalloc(p_ptr->num_jobs + 1, sizeof(struct gs_job *));
+	for (i = 0, j = 0, k = 0; i < p_ptr->num_jobs; i++) {
+		j_ptr = p_ptr->job_list[i];
+		if (j_ptr->row_state == GS_ACTIVE) {
+			active_list[k++] = j_ptr;
+		} else {
+			p_ptr->job_list[j++] = j_ptr;
 		}
-		if (p_ptr->job_list[i]->row_state == GS_FILLER)
-			p_ptr->job_list[i]->row_state = GS_NO_ACTIVE;
-
+		j_ptr->row_state = GS_NO_ACTIVE;
 	}
+	memcpy(p_ptr->job_list + j, active_list, k * sizeof(struct gs_job *));
+	xfree(active_list);
 	log_flag(GANG, "gang: %s reordered job list:", __func__);
 	/* Rebuild the active row. */
 	_build_active_row(p_ptr);
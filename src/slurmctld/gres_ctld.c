@@ -2091,11 +2091,15 @@ void gres_ctld_step_state_rebase(List gres_list,
 	return;
 }
 
-static void _gres_2_tres_str_internal(char **tres_str,
+/*
+ * Set count on the TRES of gres_name and of gres_name:gres_type, unless
+ * already set by an earlier GRES of the list.
+ */
+static void _gres_2_tres_cnt_internal(uint64_t *tres_cnt,
 				      char *gres_name, char *gres_type,
 				      uint64_t count)
 {
-	slurmdb_tres_rec_t *tres_rec;
+	int tres_pos;
 	static bool first_run = 1;
 	static slurmdb_tres_rec_t tres_req;
 
@@ -2108,18 +2112,14 @@ static void _gres_2_tres_str_internal(char **tres_str,
 
 	xassert(verify_assoc_lock(TRES_LOCK, READ_LOCK));
 	xassert(gres_name);
-	xassert(tres_str);
+	xassert(tres_cnt);
 
 	tres_req.name = gres_name;
-	tres_rec = assoc_mgr_find_tres_rec(&tres_req);
+	tres_pos = assoc_mgr_find_tres_pos(&tres_req, true);
 
-	if (tres_rec &&
-	    slurmdb_find_tres_count_in_string(
-		    *tres_str, tres_rec->id) == INFINITE64)
+	if ((tres_pos != -1) && !tres_cnt[tres_pos])
 		/* New gres */
-		xstrfmtcat(*tres_str, "%s%u=%"PRIu64,
-			   *tres_str ? "," : "",
-			   tres_rec->id, count);
+		tres_cnt[tres_pos] = count;
 
 	if (gres_type) {
 		/*
@@ -2129,7 +2129,7 @@ static void _gres_2_tres_str_internal(char **tres_str,
 		 * want to track both as TRES.
 		 */
 		tres_req.name = xstrdup_printf("%s:%s", gres_name, gres_type);
-		tres_rec = assoc_mgr_find_tres_rec(&tres_req);
+		tres_pos = assoc_mgr_find_tres_pos(&tres_req, true);
 		xfree(tres_req.name);
 	} else {
 		/*
@@ -2140,39 +2140,33 @@ static void _gres_2_tres_str_internal(char **tres_str,
 		 * Although the reported "type" may not be
 		 * accurate, it is better than nothing...
 		 */
-		tres_rec = assoc_mgr_find_tres_rec2(&tres_req);
+		tres_pos = assoc_mgr_find_tres_pos2(&tres_req, true);
 	}
 
-	if (tres_rec &&
-	    slurmdb_find_tres_count_in_string(
-		    *tres_str, tres_rec->id) == INFINITE64)
+	if ((tres_pos != -1) && !tres_cnt[tres_pos])
 		/* New GRES */
-		xstrfmtcat(*tres_str, "%s%u=%"PRIu64,
-			   *tres_str ? "," : "",
-			   tres_rec->id, count);
+		tres_cnt[tres_pos] = count;
 }
 
 /*
- * Given a job's GRES data structure, return a simple tres string of gres
+ * Given a job's GRES data structure, fill in tres_cnt with the gres
  * allocated on the node_inx requested
  * IN job_gres_list  - job's GRES data structure
  * IN node_inx - position of node in job_state_ptr->gres_cnt_node_alloc
+ * IN/OUT tres_cnt - gres spots filled in with the count on the node
  * IN locked - if the assoc_mgr tres read locked is locked or not
- *
- * RET - simple string containing gres this job is allocated on the node
- * requested.
  */
-extern char *gres_ctld_gres_on_node_as_tres(List job_gres_list,
-					    int node_inx,
-					    bool locked)
+extern void gres_ctld_gres_on_node_as_tres_cnt(List job_gres_list,
+					       int node_inx,
+					       uint64_t *tres_cnt,
+					       bool locked)
 {
 	ListIterator job_gres_iter;
 	gres_state_t *job_gres_ptr;
-	char *tres_str = NULL;
 	assoc_mgr_lock_t locks = { .tres = READ_LOCK };
 
-	if (!job_gres_list)	/* No GRES allocated */
-		return NULL;
+	if (!job_gres_list || !tres_cnt)	/* No GRES allocated */
+		return;
 
 	/* must be locked first before gres_contrex_lock!!! */
 	if (!locked)
@@ -2194,14 +2188,14 @@ extern char *gres_ctld_gres_on_node_as_tres(List job_gres_list,
 			continue;
 		}
 
-		/* If we are no_consume, print a 0 */
+		/* If we are no_consume, this prints as 0 */
 		if (job_state_ptr->total_gres == NO_CONSUME_VAL64)
-			count = 0;
+			count = NO_CONSUME_VAL64;
 		else if (job_state_ptr->gres_cnt_node_alloc[node_inx])
 			count = job_state_ptr->gres_cnt_node_alloc[node_inx];
 		else /* If this gres isn't on the node skip it */
 			continue;
-		_gres_2_tres_str_internal(&tres_str,
+		_gres_2_tres_cnt_internal(tres_cnt,
 					  job_state_ptr->gres_name,
 					  job_state_ptr->type_name,
 					  count);
@@ -2210,21 +2204,19 @@ extern char *gres_ctld_gres_on_node_as_tres(List job_gres_list,
 
 	if (!locked)
 		assoc_mgr_unlock(&locks);
-
-	return tres_str;
 }
 
-extern char *gres_ctld_gres_2_tres_str(List gres_list, bool locked)
+extern void gres_ctld_gres_2_tres_cnt(List gres_list, uint64_t *tres_cnt,
+				      bool locked)
 {
 	ListIterator itr;
 	gres_state_t *gres_state_ptr;
 	uint64_t count;
 	char *col_name = NULL;
-	char *tres_str = NULL;
 	assoc_mgr_lock_t locks = { .tres = READ_LOCK };
 
-	if (!gres_list)
-		return NULL;
+	if (!gres_list || !tres_cnt)
+		return;
 
 	/* must be locked first before gres_contrex_lock!!! */
 	if (!locked)
@@ -2255,11 +2247,7 @@ extern char *gres_ctld_gres_2_tres_str(List gres_list, bool locked)
 			continue;
 		}
 
-		/* If we are no_consume, print a 0 */
-		if (count == NO_CONSUME_VAL64)
-			count = 0;
-
-		_gres_2_tres_str_internal(&tres_str,
+		_gres_2_tres_cnt_internal(tres_cnt,
 					  gres_state_ptr->gres_name,
 					  col_name, count);
 	}
@@ -2267,6 +2255,4 @@ extern char *gres_ctld_gres_2_tres_str(List gres_list, bool locked)
 
 	if (!locked)
 		assoc_mgr_unlock(&locks);
-
-	return tres_str;
 }
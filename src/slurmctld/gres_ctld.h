@@ -211,25 +211,27 @@ extern void gres_ctld_step_state_rebase(List gres_list,
 					bitstr_t *new_job_node_bitmap);
 
 /*
- * Given a job's GRES data structure, return a simple tres string of gres
+ * Given a job's GRES data structure, fill in tres_cnt with the gres
  * allocated on the node_inx requested
  * IN job_gres_list  - job's GRES data structure
  * IN node_inx - position of node in job_state_ptr->gres_cnt_node_alloc
- *
- * RET - simple string containing gres this job is allocated on the node
- * requested.
+ * IN/OUT tres_cnt - gres spots not yet set are filled in with the count
+ *                   allocated on the node, no_consume as NO_CONSUME_VAL64
+ * IN locked - if the assoc_mgr tres read locked is locked or not
  */
-extern char *gres_ctld_gres_on_node_as_tres(List job_gres_list,
-					    int node_inx,
-					    bool locked);
+extern void gres_ctld_gres_on_node_as_tres_cnt(List job_gres_list,
+					       int node_inx,
+					       uint64_t *tres_cnt,
+					       bool locked);
 
 /*
- * Translate a gres_list into a tres_str
+ * Translate a gres_list into TRES counts
  * IN gres_list - filled in with gres_job_state_t or gres_step_state_t's
+ * IN/OUT tres_cnt - gres spots not yet set are filled in with the total
+ *                   count, no_consume as NO_CONSUME_VAL64
  * IN locked - if the assoc_mgr tres read locked is locked or not
- * RET char * in a simple TRES format
  */
-extern char *gres_ctld_gres_2_tres_str(
-	List gres_list, bool locked);
+extern void gres_ctld_gres_2_tres_cnt(List gres_list, uint64_t *tres_cnt,
+				      bool locked);
 
 #endif /* _GRES_CTLD_H */
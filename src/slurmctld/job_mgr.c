@@ -89,7 +89,9 @@
 
 #include "src/slurmctld/acct_policy.h"
 #include "src/slurmctld/agent.h"
+#include "src/slurmctld/blob_store.h"
 #include "src/slurmctld/burst_buffer.h"
+#include "src/slurmctld/event_bus.h"
 #include "src/slurmctld/fed_mgr.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/gang.h"
@@ -106,7 +108,9 @@
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/slurmctld_plugstack.h"
 #include "src/slurmctld/srun_comm.h"
+#include "src/slurmctld/state_replica.h"
 #include "src/slurmctld/state_save.h"
+#include "src/slurmctld/time_event.h"
 #include "src/slurmctld/trigger_mgr.h"
 
 #define ARRAY_ID_BUF_SIZE 32
@@ -115,6 +119,7 @@
 #define SLURM_CREATE_JOB_FLAG_NO_ALLOCATE_0 0
 #define TOP_PRIORITY 0xffff0000	/* large, but leave headroom for higher */
 #define PURGE_OLD_JOB_IN_SEC 2592000 /* 30 days in seconds */
+#define PURGE_FULL_INTERVAL 600	/* seconds between full job list scans */
 
 #define JOB_HASH_INX(_job_id)	(_job_id % hash_table_size)
 #define JOB_ARRAY_HASH_INX(_job_id, _task_id) \
@@ -124,6 +129,10 @@
 #define JOB_STATE_VERSION     "PROTOCOL_VERSION"
 #define JOB_CKPT_VERSION      "PROTOCOL_VERSION"
 
+/* Jobs packed per thread when saving state, and maximum thread count */
+#define JOB_STATE_PACK_MIN	10000
+#define JOB_STATE_PACK_THREADS	4
+
 typedef enum {
 	JOB_HASH_JOB,
 	JOB_HASH_ARRAY_JOB,
@@ -137,8 +146,18 @@ typedef struct {
 	bitstr_t **resp_array_task_id;
 } resp_array_struct_t;
 
+/* info_filter_t of a REQUEST_JOB_INFO parsed once for _pack_job() */
+typedef struct {
+	List accounts;		/* char * account names */
+	hostset_t nodes;
+	List partitions;	/* char * partition names */
+	List states;		/* uint32_t * job states */
+	List uids;		/* uint32_t * user IDs */
+} job_filter_t;
+
 typedef struct {
 	buf_t *buffer;
+	job_filter_t *filter;
 	uint32_t  filter_uid;
 	uint32_t *jobs_packed;
 	uint16_t  protocol_version;
@@ -151,6 +170,30 @@ typedef struct {
 	int rc;
 } job_overlap_args_t;
 
+typedef struct {
+	buf_t *buffer;
+	int job_cnt;
+	job_record_t **jobs;
+} dump_job_args_t;
+
+/*
+ * Most recent pack_all_jobs() response. Packed job records include values
+ * derived from the current time (e.g. expected start times), so the cache
+ * is only reused within the same second and while no job or partition
+ * update has been recorded.
+ */
+typedef struct {
+	char *buffer;
+	int buffer_size;
+	uint32_t filter_uid;
+	time_t job_update;
+	time_t pack_time;
+	time_t part_update;
+	uint16_t protocol_version;
+	uint16_t show_flags;
+	uid_t uid;
+} job_pack_cache_t;
+
 /* Global variables */
 List   job_list = NULL;		/* job_record list */
 time_t last_job_update;		/* time of last update to job records */
@@ -166,6 +209,7 @@ static int      hash_table_size = 0;
 static int      job_count = 0;		/* job's in the system */
 static uint32_t job_id_sequence = 0;	/* first job_id to assign new job */
 static struct   job_record **job_hash = NULL;
+static struct   job_record **job_name_hash = NULL;
 static struct   job_record **job_array_hash_j = NULL;
 static struct   job_record **job_array_hash_t = NULL;
 static bool     kill_invalid_dep;
@@ -174,11 +218,16 @@ static uint32_t max_array_size = NO_VAL;
 static bitstr_t *requeue_exit = NULL;
 static bitstr_t *requeue_exit_hold = NULL;
 static bool     validate_cfgd_licenses = true;
+static job_pack_cache_t job_pack_cache = { 0 };
+static pthread_mutex_t job_pack_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 /* Local functions */
 static void _add_job_hash(job_record_t *job_ptr);
+static void _add_job_name_hash(job_record_t *job_ptr);
 static void _add_job_array_hash(job_record_t *job_ptr);
 static void _clear_job_gres_details(job_record_t *job_ptr);
+static int  _copy_job_desc_to_blob(job_desc_msg_t *job_desc,
+				   job_record_t *job_ptr);
 static int  _copy_job_desc_to_file(job_desc_msg_t * job_desc,
 				   uint32_t job_id);
 static int  _copy_job_desc_to_job_record(job_desc_msg_t * job_desc,
@@ -229,6 +278,7 @@ static int  _read_data_array_from_file(int fd, char *file_name, char ***data,
 				       uint32_t *size, job_record_t *job_ptr);
 static void _remove_defunct_batch_dirs(List batch_dirs);
 static void _remove_job_hash(job_record_t *job_ptr, job_hash_type_t type);
+static void _remove_job_name_hash(job_record_t *job_entry);
 static int  _reset_detail_bitmaps(job_record_t *job_ptr);
 static void _reset_step_bitmaps(job_record_t *job_ptr);
 static void _resp_array_add(resp_array_struct_t **resp, job_record_t *job_ptr,
@@ -646,6 +696,10 @@ static void _delete_job_details(job_record_t *job_entry)
 		*job_id = job_entry->job_id;
 		list_enqueue(purge_files_list, job_id);
 	}
+	blob_store_unref(job_entry->details->env_blob,
+			 IS_JOB_FINISHED(job_entry));
+	blob_store_unref(job_entry->details->script_blob,
+			 IS_JOB_FINISHED(job_entry));
 
 	xfree(job_entry->details->acctg_freq);
 	for (i=0; i<job_entry->details->argc; i++)
@@ -656,6 +710,7 @@ static void _delete_job_details(job_record_t *job_entry)
 	FREE_NULL_LIST(job_entry->details->depend_list);
 	xfree(job_entry->details->dependency);
 	xfree(job_entry->details->orig_dependency);
+	xfree(job_entry->details->env_blob);
 	for (i=0; i<job_entry->details->env_cnt; i++)
 		xfree(job_entry->details->env_sup[i]);
 	xfree(job_entry->details->env_sup);
@@ -672,6 +727,7 @@ static void _delete_job_details(job_record_t *job_entry)
 	xfree(job_entry->details->std_out);
 	FREE_NULL_BITMAP(job_entry->details->req_node_bitmap);
 	xfree(job_entry->details->req_nodes);
+	xfree(job_entry->details->script_blob);
 	xfree(job_entry->details->work_dir);
 	xfree(job_entry->details->x11_magic_cookie);
 	xfree(job_entry->details->x11_target);
@@ -798,6 +854,83 @@ static slurmdb_qos_rec_t *_determine_and_validate_qos(
  *	load_all_job_state().
  * RET 0 or error code
  */
+static void *_dump_job_state_thread(void *arg)
+{
+	dump_job_args_t *args = arg;
+	int i;
+
+	for (i = 0; i < args->job_cnt; i++)
+		_dump_job_state(args->jobs[i], args->buffer);
+
+	return NULL;
+}
+
+/*
+ * Pack the records of all jobs into buffer. Large job lists are split into
+ * contiguous slices packed concurrently, reducing how long the job read
+ * lock is held. Records are appended to buffer in job_list order.
+ * NOTE: Caller must hold a job read lock, the lock is not needed on return.
+ */
+static void _dump_all_job_records(buf_t *buffer)
+{
+	int i, job_cnt, per_thread, thread_cnt;
+	job_record_t **jobs, *job_ptr;
+	dump_job_args_t *args;
+	pthread_t *threads;
+	ListIterator job_iterator;
+
+	job_cnt = list_count(job_list);
+	thread_cnt = MIN(JOB_STATE_PACK_THREADS, job_cnt / JOB_STATE_PACK_MIN);
+	if (thread_cnt <= 1) {
+		job_iterator = list_iterator_create(job_list);
+		while ((job_ptr = list_next(job_iterator)))
+			_dump_job_state(job_ptr, buffer);
+		list_iterator_destroy(job_iterator);
+		return;
+	}
+
+	jobs = xcalloc(job_cnt, sizeof(job_record_t *));
+	i = 0;
+	job_iterator = list_iterator_create(job_list);
+	while ((job_ptr = list_next(job_iterator)))
+		jobs[i++] = job_ptr;
+	list_iterator_destroy(job_iterator);
+
+	/* Slice 0 is packed by this thread directly into buffer */
+	per_thread = (job_cnt + thread_cnt - 1) / thread_cnt;
+	args = xcalloc(thread_cnt, sizeof(dump_job_args_t));
+	threads = xcalloc(thread_cnt, sizeof(pthread_t));
+	for (i = 0; i < thread_cnt; i++) {
+		args[i].jobs = jobs + (i * per_thread);
+		args[i].job_cnt = MIN(per_thread, job_cnt - (i * per_thread));
+		if (i == 0) {
+			args[i].buffer = buffer;
+			continue;
+		}
+		args[i].buffer = init_buf(size_buf(buffer) / thread_cnt);
+		slurm_thread_create(&threads[i], _dump_job_state_thread,
+				    &args[i]);
+	}
+	_dump_job_state_thread(&args[0]);
+
+	for (i = 1; i < thread_cnt; i++) {
+		uint32_t len;
+
+		pthread_join(threads[i], NULL);
+		len = get_buf_offset(args[i].buffer);
+		if (remaining_buf(buffer) < len)
+			grow_buf(buffer, len);
+		memcpy(get_buf_data(buffer) + get_buf_offset(buffer),
+		       get_buf_data(args[i].buffer), len);
+		set_buf_offset(buffer, get_buf_offset(buffer) + len);
+		free_buf(args[i].buffer);
+	}
+
+	xfree(args);
+	xfree(jobs);
+	xfree(threads);
+}
+
 int dump_all_job_state(void)
 {
 	/* Save high-water mark to avoid buffer growth with copies */
@@ -808,8 +941,6 @@ int dump_all_job_state(void)
 	/* Locks: Read config and job */
 	slurmctld_lock_t job_read_lock =
 		{ READ_LOCK, READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK };
-	ListIterator job_iterator;
-	job_record_t *job_ptr;
 	buf_t *buffer = init_buf(high_buffer_size);
 	time_t now = time(NULL);
 	time_t last_state_file_time;
@@ -852,12 +983,7 @@ int dump_all_job_state(void)
 
 	/* write individual job records */
 	lock_slurmctld(job_read_lock);
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = list_next(job_iterator))) {
-		_dump_job_state(job_ptr, buffer);
-	}
-	list_iterator_destroy(job_iterator);
-
+	_dump_all_job_records(buffer);
 
 	/* write the buffer to file */
 	old_file = xstrdup(slurm_conf.state_save_location);
@@ -930,6 +1056,8 @@ int dump_all_job_state(void)
 	xfree(new_file);
 	unlock_state_files();
 
+	if (!error_code)
+		state_replica_send("job_state", buffer);
 	free_buf(buffer);
 	END_TIMER2("dump_all_job_state");
 	return error_code;
@@ -992,6 +1120,9 @@ static buf_t *_open_job_state_file(char **state_file)
 	*state_file = xstrdup_printf("%s/job_state",
 	                             slurm_conf.state_save_location);
 
+	if ((buf = state_replica_open(*state_file)))
+		return buf;
+
 	if (!(buf = create_mmap_buf(*state_file)))
 		error("Could not open job state file %s: %m", *state_file);
 	else
@@ -1153,8 +1284,10 @@ extern int load_all_job_state(void)
 	char *ver_str = NULL;
 	uint32_t ver_str_len;
 	uint16_t protocol_version = NO_VAL16;
+	DEF_TIMERS;
 
 	/* read the file */
+	START_TIMER;
 	lock_state_files();
 	if (!(buffer = _open_job_state_file(&state_file))) {
 		info("No job state file (%s) to recover", state_file);
@@ -1205,7 +1338,11 @@ extern int load_all_job_state(void)
 	debug3("Set job_id_sequence to %u", job_id_sequence);
 
 	free_buf(buffer);
-	info("Recovered information about %d jobs", job_cnt);
+	END_TIMER;
+	info("Recovered information about %d jobs in %s (%"PRIu64" jobs/sec)",
+	     job_cnt, TIME_STR,
+	     DELTA_TIMER ? ((uint64_t) job_cnt * USEC_IN_SEC) / DELTA_TIMER :
+	     (uint64_t) job_cnt);
 	return error_code;
 
 unpack_error:
@@ -2263,6 +2400,7 @@ static int _load_job_state(buf_t *buffer, uint16_t protocol_version)
 	job_ptr->start_protocol_ver = start_protocol_ver;
 
 	_add_job_hash(job_ptr);
+	_add_job_name_hash(job_ptr);
 	_add_job_array_hash(job_ptr);
 
 	memset(&assoc_rec, 0, sizeof(assoc_rec));
@@ -2366,6 +2504,8 @@ static int _load_job_state(buf_t *buffer, uint16_t protocol_version)
 				    &job_ptr->gres_used);
 	job_ptr->clusters     = clusters;
 	job_ptr->fed_details  = job_fed_details;
+	time_event_job_add(job_ptr);
+	time_event_purge_add(job_ptr);
 	return SLURM_SUCCESS;
 
 unpack_error:
@@ -2501,6 +2641,9 @@ void _dump_job_details(struct job_details *detail_ptr, buf_t *buffer)
 
 	pack_cron_entry(detail_ptr->crontab_entry, SLURM_PROTOCOL_VERSION,
 			buffer);
+
+	packstr(detail_ptr->env_blob, buffer);
+	packstr(detail_ptr->script_blob, buffer);
 }
 
 /* _load_job_details - Unpack a job details information from buffer */
@@ -2511,6 +2654,7 @@ static int _load_job_details(job_record_t *job_ptr, buf_t *buffer,
 	char *features = NULL, *cpu_bind = NULL, *dependency = NULL;
 	char *orig_dependency = NULL, *mem_bind, *cluster_features = NULL;
 	char *err = NULL, *in = NULL, *out = NULL, *work_dir = NULL;
+	char *env_blob = NULL, *script_blob = NULL;
 	char **argv = (char **) NULL, **env_sup = (char **) NULL;
 	uint32_t min_nodes, max_nodes;
 	uint32_t min_cpus = 1, max_cpus = NO_VAL;
@@ -2592,6 +2736,12 @@ static int _load_job_details(job_record_t *job_ptr, buf_t *buffer,
 		if (unpack_cron_entry((void **) &crontab_entry,
 				      protocol_version, buffer))
 			goto unpack_error;
+
+		if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+			safe_unpackstr_xmalloc(&env_blob, &name_len, buffer);
+			safe_unpackstr_xmalloc(&script_blob, &name_len,
+					       buffer);
+		}
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack32(&min_cpus, buffer);
 		safe_unpack32(&max_cpus, buffer);
@@ -2692,6 +2842,10 @@ static int _load_job_details(job_record_t *job_ptr, buf_t *buffer,
 	xfree(job_ptr->details->std_out);
 	xfree(job_ptr->details->req_nodes);
 	xfree(job_ptr->details->work_dir);
+	blob_store_unref(job_ptr->details->env_blob, false);
+	xfree(job_ptr->details->env_blob);
+	blob_store_unref(job_ptr->details->script_blob, false);
+	xfree(job_ptr->details->script_blob);
 
 	/* now put the details into the job record */
 	job_ptr->details->acctg_freq = acctg_freq;
@@ -2715,6 +2869,8 @@ static int _load_job_details(job_record_t *job_ptr, buf_t *buffer,
 	job_ptr->details->depend_list = depend_list;
 	job_ptr->details->dependency = dependency;
 	job_ptr->details->orig_dependency = orig_dependency;
+	job_ptr->details->env_blob = env_blob;
+	blob_store_ref(env_blob);
 	job_ptr->details->env_cnt = env_cnt;
 	job_ptr->details->env_sup = env_sup;
 	job_ptr->details->std_err = err;
@@ -2746,6 +2902,8 @@ static int _load_job_details(job_record_t *job_ptr, buf_t *buffer,
 	job_ptr->details->prolog_running = prolog_running;
 	job_ptr->details->req_nodes = req_nodes;
 	job_ptr->details->requeue = requeue;
+	job_ptr->details->script_blob = script_blob;
+	blob_store_ref(script_blob);
 	job_ptr->details->share_res = share_res;
 	job_ptr->details->submit_time = submit_time;
 	job_ptr->details->task_dist = task_dist;
@@ -2764,6 +2922,7 @@ unpack_error:
 	free_cron_entry(crontab_entry);
 	xfree(dependency);
 	xfree(orig_dependency);
+	xfree(env_blob);
 /*	for (i=0; i<env_cnt; i++)
 	xfree(env_sup[i]);  Don't trust this on unpack error */
 	xfree(env_sup);
@@ -2775,6 +2934,7 @@ unpack_error:
 	xfree(mem_bind);
 	xfree(out);
 	xfree(req_nodes);
+	xfree(script_blob);
 	xfree(work_dir);
 	return SLURM_ERROR;
 }
@@ -2793,6 +2953,71 @@ static void _add_job_hash(job_record_t *job_ptr)
 	job_hash[inx] = job_ptr;
 }
 
+static int _job_name_hash_inx(uint32_t user_id, const char *name)
+{
+	uint32_t hash = user_id;
+
+	while (name && *name)
+		hash = (hash * 31) + (unsigned char) *name++;
+	return hash % hash_table_size;
+}
+
+/* _add_job_name_hash - add a user/name hash entry for given job record,
+ *	user_id and name must already be set
+ * IN job_ptr - pointer to job record
+ * Globals: hash table updated
+ */
+static void _add_job_name_hash(job_record_t *job_ptr)
+{
+	int inx;
+
+	inx = _job_name_hash_inx(job_ptr->user_id, job_ptr->name);
+	job_ptr->job_name_next = job_name_hash[inx];
+	job_name_hash[inx] = job_ptr;
+}
+
+/* _remove_job_name_hash - remove a user/name hash entry for given job record
+ * IN job_ptr - pointer to job record
+ * Globals: hash table updated
+ */
+static void _remove_job_name_hash(job_record_t *job_entry)
+{
+	job_record_t **job_pptr;
+
+	job_pptr = &job_name_hash[_job_name_hash_inx(job_entry->user_id,
+						     job_entry->name)];
+	while (*job_pptr && (*job_pptr != job_entry))
+		job_pptr = &(*job_pptr)->job_name_next;
+	if (*job_pptr)
+		*job_pptr = job_entry->job_name_next;
+	job_entry->job_name_next = NULL;
+}
+
+extern job_record_t *find_user_name_job(uint32_t user_id, const char *name,
+					ListFindF match, void *key)
+{
+	job_record_t *job_ptr;
+	int inx, null_inx;
+
+	inx = _job_name_hash_inx(user_id, name);
+	for (job_ptr = job_name_hash[inx]; job_ptr;
+	     job_ptr = job_ptr->job_name_next) {
+		if (match(job_ptr, key))
+			return job_ptr;
+	}
+
+	null_inx = _job_name_hash_inx(user_id, NULL);
+	if (null_inx == inx)
+		return NULL;
+	for (job_ptr = job_name_hash[null_inx]; job_ptr;
+	     job_ptr = job_ptr->job_name_next) {
+		if (!job_ptr->name && match(job_ptr, key))
+			return job_ptr;
+	}
+
+	return NULL;
+}
+
 /* _remove_job_hash - remove a job hash entry for given job record, job_id must
  *	already be set
  * IN job_ptr - pointer to job record
@@ -2810,8 +3035,19 @@ static void _remove_job_hash(job_record_t *job_entry, job_hash_type_t type)
 		job_pptr = &job_hash[JOB_HASH_INX(job_entry->job_id)];
 		break;
 	case JOB_HASH_ARRAY_JOB:
-		job_pptr = &job_array_hash_j[
-			JOB_HASH_INX(job_entry->array_job_id)];
+		/*
+		 * All tasks of an array share this list, so avoid walking it
+		 * when purging the tasks of a large array.
+		 */
+		if (job_entry->job_array_prev_j &&
+		    (job_entry->job_array_prev_j->job_array_next_j ==
+		     job_entry)) {
+			job_pptr =
+				&job_entry->job_array_prev_j->job_array_next_j;
+		} else {
+			job_pptr = &job_array_hash_j[
+				JOB_HASH_INX(job_entry->array_job_id)];
+		}
 		break;
 	case JOB_HASH_ARRAY_TASK:
 		job_pptr = &job_array_hash_t[
@@ -2869,7 +3105,11 @@ static void _remove_job_hash(job_record_t *job_entry, job_hash_type_t type)
 		break;
 	case JOB_HASH_ARRAY_JOB:
 		*job_pptr = job_entry->job_array_next_j;
+		if (job_entry->job_array_next_j)
+			job_entry->job_array_next_j->job_array_prev_j =
+				job_entry->job_array_prev_j;
 		job_entry->job_array_next_j = NULL;
+		job_entry->job_array_prev_j = NULL;
 		break;
 	case JOB_HASH_ARRAY_TASK:
 		*job_pptr = job_entry->job_array_next_t;
@@ -2892,6 +3132,9 @@ void _add_job_array_hash(job_record_t *job_ptr)
 
 	inx = JOB_HASH_INX(job_ptr->array_job_id);
 	job_ptr->job_array_next_j = job_array_hash_j[inx];
+	job_ptr->job_array_prev_j = NULL;
+	if (job_array_hash_j[inx])
+		job_array_hash_j[inx]->job_array_prev_j = job_ptr;
 	job_array_hash_j[inx] = job_ptr;
 
 	inx = JOB_ARRAY_HASH_INX(job_ptr->array_job_id,job_ptr->array_task_id);
@@ -4224,6 +4467,46 @@ int init_job_conf(void)
 	return SLURM_SUCCESS;
 }
 
+/*
+ * _rebuild_job_hash - Grow the job hash tables and re-link every job record
+ *	in job_list into them.
+ * IN new_size - new size of the hash tables
+ */
+static void _rebuild_job_hash(int new_size)
+{
+	ListIterator job_iterator;
+	job_record_t *job_ptr;
+
+	debug("%s: growing job hash tables from %d to %d entries",
+	      __func__, hash_table_size, new_size);
+
+	xfree(job_hash);
+	xfree(job_name_hash);
+	xfree(job_array_hash_j);
+	xfree(job_array_hash_t);
+	hash_table_size = new_size;
+	job_hash = xcalloc(hash_table_size, sizeof(job_record_t *));
+	job_name_hash = xcalloc(hash_table_size, sizeof(job_record_t *));
+	job_array_hash_j = xcalloc(hash_table_size, sizeof(job_record_t *));
+	job_array_hash_t = xcalloc(hash_table_size, sizeof(job_record_t *));
+
+	if (!job_list)
+		return;
+
+	job_iterator = list_iterator_create(job_list);
+	while ((job_ptr = list_next(job_iterator))) {
+		job_ptr->job_next = NULL;
+		job_ptr->job_name_next = NULL;
+		job_ptr->job_array_next_j = NULL;
+		job_ptr->job_array_prev_j = NULL;
+		job_ptr->job_array_next_t = NULL;
+		_add_job_hash(job_ptr);
+		_add_job_name_hash(job_ptr);
+		_add_job_array_hash(job_ptr);
+	}
+	list_iterator_destroy(job_iterator);
+}
+
 /*
  * rehash_jobs - Create or rebuild the job hash table.
  */
@@ -4235,17 +4518,16 @@ extern void rehash_jobs(void)
 	if (job_hash == NULL) {
 		hash_table_size = slurm_conf.max_job_cnt;
 		job_hash = xcalloc(hash_table_size, sizeof(job_record_t *));
+		job_name_hash = xcalloc(hash_table_size,
+					sizeof(job_record_t *));
 		job_array_hash_j = xcalloc(hash_table_size,
 					   sizeof(job_record_t *));
 		job_array_hash_t = xcalloc(hash_table_size,
 					   sizeof(job_record_t *));
 	} else if (hash_table_size < (slurm_conf.max_job_cnt / 2)) {
 		/* If the MaxJobCount grows by too much, the hash table will
-		 * be ineffective without rebuilding. We don't presently bother
-		 * to rebuild the hash table, but cut MaxJobCount back as
-		 * needed. */
-		error ("MaxJobCount reset too high, restart slurmctld");
-		slurm_conf.max_job_cnt = hash_table_size;
+		 * be ineffective without rebuilding. */
+		_rebuild_job_hash(slurm_conf.max_job_cnt);
 	}
 }
 
@@ -4352,6 +4634,7 @@ extern job_record_t *job_array_split(job_record_t *job_ptr)
 	job_ptr_pend->mail_user = xstrdup(job_ptr->mail_user);
 	job_ptr_pend->mcs_label = xstrdup(job_ptr->mcs_label);
 	job_ptr_pend->name = xstrdup(job_ptr->name);
+	_add_job_name_hash(job_ptr_pend);
 	job_ptr_pend->network = xstrdup(job_ptr->network);
 	job_ptr_pend->node_addr = NULL;
 	job_ptr_pend->node_bitmap = NULL;
@@ -4419,6 +4702,9 @@ extern job_record_t *job_array_split(job_record_t *job_ptr)
 	 * for a period before preempting more jobs.
 	 */
 	details_new->preempt_start_time = 0;
+	/* Job IDs changed, register both records again when next tested */
+	details_new->depend_cached = false;
+	job_details->depend_cached = false;
 
 	details_new->acctg_freq = xstrdup(job_details->acctg_freq);
 	if (job_details->argc) {
@@ -4436,6 +4722,8 @@ extern job_record_t *job_array_split(job_record_t *job_ptr)
 	details_new->depend_list = depended_list_copy(job_details->depend_list);
 	details_new->dependency = xstrdup(job_details->dependency);
 	details_new->orig_dependency = xstrdup(job_details->orig_dependency);
+	details_new->env_blob = xstrdup(job_details->env_blob);
+	blob_store_ref(details_new->env_blob);
 	if (job_details->env_cnt) {
 		details_new->env_sup =
 			xcalloc((job_details->env_cnt + 1), sizeof(char *));
@@ -4465,6 +4753,8 @@ extern job_record_t *job_array_split(job_record_t *job_ptr)
 			bit_copy(job_details->req_node_bitmap);
 	}
 	details_new->req_nodes = xstrdup(job_details->req_nodes);
+	details_new->script_blob = xstrdup(job_details->script_blob);
+	blob_store_ref(details_new->script_blob);
 	details_new->std_err = xstrdup(job_details->std_err);
 	details_new->std_in = xstrdup(job_details->std_in);
 	details_new->std_out = xstrdup(job_details->std_out);
@@ -4891,6 +5181,9 @@ extern int job_allocate(job_desc_msg_t * job_specs, int immediate,
 		return error_code;
 	}
 	xassert(job_ptr);
+	time_event_job_add(job_ptr);
+	if (!will_run)
+		event_bus_job(job_ptr, CTLD_EVENT_JOB_SUBMIT);
 	if (job_specs->array_bitmap)
 		independent = false;
 	else
@@ -5761,6 +6054,53 @@ endit:
 	return rc;
 }
 
+static bool _job_gone_rc(int rc)
+{
+	return ((rc == ESLURM_ALREADY_DONE) || (rc == ESLURM_INVALID_JOB_ID));
+}
+
+/*
+ * job_str_signal_list - signal the jobs of a list
+ * IN job_id_list - space separated list of job ids, each of a format accepted
+ *	by job_str_signal()
+ * IN signal - signal to send, SIGKILL == cancel the job
+ * IN flags  - see KILL_JOB_* flags in slurm.h
+ * IN uid - uid of requesting user
+ * OUT signaled_cnt - count of job ids signaled without error
+ * RET 0 on success, otherwise the first ESLURM error code other than
+ *	ESLURM_ALREADY_DONE and ESLURM_INVALID_JOB_ID, or one of those if only
+ *	they occurred
+ */
+extern int job_str_signal_list(char *job_id_list, uint16_t signal,
+			       uint16_t flags, uid_t uid,
+			       uint32_t *signaled_cnt)
+{
+	char *tmp, *tok, *save_ptr = NULL;
+	int rc = SLURM_SUCCESS, rc2;
+
+	*signaled_cnt = 0;
+	tmp = xstrdup(job_id_list);
+	tok = strtok_r(tmp, " ", &save_ptr);
+	while (tok) {
+		rc2 = job_str_signal(tok, signal, flags, uid, false);
+		if (rc2 == SLURM_SUCCESS) {
+			(*signaled_cnt)++;
+		} else {
+			if (!_job_gone_rc(rc2))
+				info("%s: JobId=%s sig %d returned %s",
+				     __func__, tok, signal,
+				     slurm_strerror(rc2));
+			if ((rc == SLURM_SUCCESS) ||
+			    (_job_gone_rc(rc) && !_job_gone_rc(rc2)))
+				rc = rc2;
+		}
+		tok = strtok_r(NULL, " ", &save_ptr);
+	}
+	xfree(tmp);
+
+	return rc;
+}
+
 static void _signal_batch_job(job_record_t *job_ptr, uint16_t signal,
 			      uint16_t flags)
 {
@@ -7133,7 +7473,8 @@ static int _job_create(job_desc_msg_t *job_desc, int allocate, int will_run,
 
 	if (job_desc->script
 	    &&  (!will_run)) {	/* don't bother with copy if just a test */
-		if ((error_code = _copy_job_desc_to_file(job_desc,
+		if (_copy_job_desc_to_blob(job_desc, job_ptr) &&
+		    (error_code = _copy_job_desc_to_file(job_desc,
 							 job_ptr->job_id))) {
 			error_code = ESLURM_WRITING_TO_FILE;
 			goto cleanup_fail;
@@ -7464,6 +7805,51 @@ extern int validate_job_create_req(job_desc_msg_t * job_desc, uid_t submit_uid,
 	return SLURM_SUCCESS;
 }
 
+/*
+ * _copy_job_desc_to_blob - store the job script and environment from the RPC
+ *	structure in the blob store, shared with identical jobs
+ * RET 0 on success, otherwise use _copy_job_desc_to_file()
+ */
+static int _copy_job_desc_to_blob(job_desc_msg_t *job_desc,
+				  job_record_t *job_ptr)
+{
+	struct job_details *detail_ptr = job_ptr->details;
+	char *data, *pos;
+	uint32_t size = sizeof(uint32_t);
+	int error_code;
+	DEF_TIMERS;
+
+	if (!job_desc->environment || job_desc->env_size == 0)
+		return ESLURM_ENVIRONMENT_MISSING;
+
+	START_TIMER;
+
+	/* Same format as _write_data_array_to_file() */
+	for (int i = 0; i < job_desc->env_size; i++)
+		size += strlen(job_desc->environment[i]) + 1;
+	pos = data = xmalloc(size);
+	memcpy(pos, &job_desc->env_size, sizeof(uint32_t));
+	pos += sizeof(uint32_t);
+	for (int i = 0; i < job_desc->env_size; i++)
+		pos = stpcpy(pos, job_desc->environment[i]) + 1;
+
+	error_code = blob_store_put(data, size, &detail_ptr->env_blob);
+	xfree(data);
+
+	if (!error_code) {
+		error_code = blob_store_put(job_desc->script,
+					    strlen(job_desc->script) + 1,
+					    &detail_ptr->script_blob);
+		if (error_code) {
+			blob_store_unref(detail_ptr->env_blob, true);
+			xfree(detail_ptr->env_blob);
+		}
+	}
+
+	END_TIMER2("_copy_job_desc_to_blob");
+	return error_code;
+}
+
 /* _copy_job_desc_to_file - copy the job script and environment from the RPC
  *	structure into a file */
 static int
@@ -7640,12 +8026,16 @@ char **get_job_env(job_record_t *job_ptr, uint32_t *env_size)
 	int cc, fd = -1, hash;
 	uint32_t use_id;
 
-	use_id = (job_ptr->array_task_id != NO_VAL) ?
-		job_ptr->array_job_id : job_ptr->job_id;
-	hash = use_id % 10;
-	file_name = xstrdup_printf("%s/hash.%d/job.%u/environment",
-	                           slurm_conf.state_save_location,
-	                           hash, use_id);
+	if (job_ptr->details->env_blob) {
+		file_name = blob_store_path(job_ptr->details->env_blob);
+	} else {
+		use_id = (job_ptr->array_task_id != NO_VAL) ?
+			job_ptr->array_job_id : job_ptr->job_id;
+		hash = use_id % 10;
+		file_name = xstrdup_printf("%s/hash.%d/job.%u/environment",
+					   slurm_conf.state_save_location,
+					   hash, use_id);
+	}
 	fd = open(file_name, 0);
 
 	if (fd >= 0) {
@@ -7677,12 +8067,16 @@ buf_t *get_job_script(const job_record_t *job_ptr)
 	if (!job_ptr->batch_flag)
 		return NULL;
 
-	use_id = (job_ptr->array_task_id != NO_VAL) ?
-		job_ptr->array_job_id : job_ptr->job_id;
-	hash = use_id % 10;
-	file_name = xstrdup_printf("%s/hash.%d/job.%u/script",
-	                           slurm_conf.state_save_location,
-	                           hash, use_id);
+	if (job_ptr->details && job_ptr->details->script_blob) {
+		file_name = blob_store_path(job_ptr->details->script_blob);
+	} else {
+		use_id = (job_ptr->array_task_id != NO_VAL) ?
+			job_ptr->array_job_id : job_ptr->job_id;
+		hash = use_id % 10;
+		file_name = xstrdup_printf("%s/hash.%d/job.%u/script",
+					   slurm_conf.state_save_location,
+					   hash, use_id);
+	}
 
 	if (!(buf = create_mmap_buf(file_name)))
 		error("Could not open script file for %pJ", job_ptr);
@@ -7970,6 +8364,7 @@ static int _copy_job_desc_to_job_record(job_desc_msg_t *job_desc,
 	_add_job_hash(job_ptr);
 
 	job_ptr->user_id    = (uid_t) job_desc->user_id;
+	_add_job_name_hash(job_ptr);
 	job_ptr->group_id   = (gid_t) job_desc->group_id;
 	job_ptr->job_state  = JOB_PENDING;
 	job_ptr->time_limit = job_desc->time_limit;
@@ -9221,6 +9616,10 @@ static void _delete_job_common(job_record_t *job_ptr)
 
 	/* Remove the record from job hash table */
 	_remove_job_hash(job_ptr, JOB_HASH_JOB);
+	_remove_job_name_hash(job_ptr);
+
+	/* Jobs depending upon this one see it is gone */
+	depend_notify_job(job_ptr);
 
 	/* Remove the record from job array hash tables, if applicable */
 	if (job_ptr->array_task_id != NO_VAL) {
@@ -9494,6 +9893,175 @@ static bool _hide_job(job_record_t *job_ptr, uid_t uid, uint16_t show_flags)
 	return false;
 }
 
+static void _free_job_filter(job_filter_t *filter)
+{
+	if (!filter)
+		return;
+
+	FREE_NULL_LIST(filter->accounts);
+	if (filter->nodes)
+		hostset_destroy(filter->nodes);
+	FREE_NULL_LIST(filter->partitions);
+	FREE_NULL_LIST(filter->states);
+	FREE_NULL_LIST(filter->uids);
+	xfree(filter);
+}
+
+/*
+ * Parse a job info_filter_t. Any field which can not be fully parsed is
+ * ignored so that the client still receives every job it may be looking
+ * for and can do the final filtering itself.
+ * RET filter to test jobs against or NULL to pack all jobs
+ */
+static job_filter_t *_build_job_filter(info_filter_t *info_filter)
+{
+	job_filter_t *filter;
+	char *tmp, *tok, *save_ptr = NULL;
+	uint32_t *state_ptr, *uid_ptr;
+	uid_t uid;
+
+	if (!info_filter ||
+	    (!info_filter->accounts && !info_filter->nodes &&
+	     !info_filter->partitions && !info_filter->states &&
+	     !info_filter->users))
+		return NULL;
+
+	filter = xmalloc(sizeof(*filter));
+
+	if (info_filter->accounts) {
+		filter->accounts = list_create(xfree_ptr);
+		tmp = xstrdup(info_filter->accounts);
+		tok = strtok_r(tmp, ",", &save_ptr);
+		while (tok) {
+			list_append(filter->accounts, xstrdup(tok));
+			tok = strtok_r(NULL, ",", &save_ptr);
+		}
+		xfree(tmp);
+	}
+
+	if (info_filter->nodes &&
+	    !(filter->nodes = hostset_create(info_filter->nodes)))
+		debug("%s: ignoring invalid node filter %s",
+		      __func__, info_filter->nodes);
+
+	if (info_filter->partitions) {
+		filter->partitions = list_create(xfree_ptr);
+		tmp = xstrdup(info_filter->partitions);
+		tok = strtok_r(tmp, ",", &save_ptr);
+		while (tok) {
+			list_append(filter->partitions, xstrdup(tok));
+			tok = strtok_r(NULL, ",", &save_ptr);
+		}
+		xfree(tmp);
+	}
+
+	if (info_filter->states) {
+		filter->states = list_create(xfree_ptr);
+		tmp = xstrdup(info_filter->states);
+		tok = strtok_r(tmp, ",", &save_ptr);
+		while (tok) {
+			state_ptr = xmalloc(sizeof(*state_ptr));
+			*state_ptr = job_state_num(tok);
+			list_append(filter->states, state_ptr);
+			if (*state_ptr == NO_VAL) {
+				debug("%s: ignoring invalid job state %s",
+				      __func__, tok);
+				FREE_NULL_LIST(filter->states);
+				break;
+			}
+			tok = strtok_r(NULL, ",", &save_ptr);
+		}
+		xfree(tmp);
+	}
+
+	if (info_filter->users) {
+		filter->uids = list_create(xfree_ptr);
+		tmp = xstrdup(info_filter->users);
+		tok = strtok_r(tmp, ",", &save_ptr);
+		while (tok) {
+			if (uid_from_string(tok, &uid) < 0) {
+				debug("%s: ignoring invalid user %s",
+				      __func__, tok);
+				FREE_NULL_LIST(filter->uids);
+				break;
+			}
+			uid_ptr = xmalloc(sizeof(*uid_ptr));
+			*uid_ptr = uid;
+			list_append(filter->uids, uid_ptr);
+			tok = strtok_r(NULL, ",", &save_ptr);
+		}
+		xfree(tmp);
+	}
+
+	return filter;
+}
+
+static int _find_job_state(void *x, void *key)
+{
+	uint32_t filter_state = *(uint32_t *) x;
+	uint32_t job_state = *(uint32_t *) key;
+
+	if (filter_state & JOB_STATE_FLAGS)
+		return (filter_state & job_state) ? 1 : 0;
+
+	return ((job_state & JOB_STATE_BASE) == filter_state) ? 1 : 0;
+}
+
+static int _find_uint32(void *x, void *key)
+{
+	return (*(uint32_t *) x == *(uint32_t *) key) ? 1 : 0;
+}
+
+static bool _job_in_filter_parts(job_record_t *job_ptr, List partitions)
+{
+	char *tmp, *tok, *save_ptr = NULL;
+	bool match = false;
+
+	if (!job_ptr->partition)
+		return false;
+
+	tmp = xstrdup(job_ptr->partition);
+	tok = strtok_r(tmp, ",", &save_ptr);
+	while (tok && !match) {
+		if (list_find_first(partitions, slurm_find_char_in_list, tok))
+			match = true;
+		tok = strtok_r(NULL, ",", &save_ptr);
+	}
+	xfree(tmp);
+
+	return match;
+}
+
+/* RET true if the job matches every field of the filter */
+static bool _job_filter_match(job_record_t *job_ptr, job_filter_t *filter)
+{
+	if (filter->uids &&
+	    !list_find_first(filter->uids, _find_uint32, &job_ptr->user_id))
+		return false;
+
+	if (filter->states &&
+	    !list_find_first(filter->states, _find_job_state,
+			     &job_ptr->job_state))
+		return false;
+
+	if (filter->accounts &&
+	    (!job_ptr->account ||
+	     !list_find_first(filter->accounts, slurm_find_char_in_list,
+			      job_ptr->account)))
+		return false;
+
+	if (filter->partitions &&
+	    !_job_in_filter_parts(job_ptr, filter->partitions))
+		return false;
+
+	if (filter->nodes &&
+	    (!job_ptr->nodes ||
+	     !hostset_intersects(filter->nodes, job_ptr->nodes)))
+		return false;
+
+	return true;
+}
+
 static int _pack_job(void *object, void *arg)
 {
 	job_record_t *job_ptr = (job_record_t *)object;
@@ -9505,6 +10073,10 @@ static int _pack_job(void *object, void *arg)
 	    (pack_info->filter_uid != job_ptr->user_id))
 		return SLURM_SUCCESS;
 
+	if (pack_info->filter &&
+	    !_job_filter_match(job_ptr, pack_info->filter))
+		return SLURM_SUCCESS;
+
 	if (((pack_info->show_flags & SHOW_ALL) == 0) &&
 	    (pack_info->uid != 0) &&
 	    _all_parts_hidden(job_ptr, pack_info->uid))
@@ -9533,6 +10105,65 @@ static int _foreach_pack_jobid(void *object, void *arg)
 	return _pack_job(job_ptr, info);
 }
 
+/*
+ * Copy the cached pack_all_jobs() response into buffer_ptr if it was built
+ * for the same request during the current second and no job or partition
+ * changes have been recorded since.
+ * RET true if buffer_ptr and buffer_size were set from the cache
+ */
+static bool _get_job_pack_cache(char **buffer_ptr, int *buffer_size,
+				time_t now, uint16_t show_flags, uid_t uid,
+				uint32_t filter_uid, uint16_t protocol_version)
+{
+	bool found = false;
+
+	slurm_mutex_lock(&job_pack_cache_mutex);
+	if (job_pack_cache.buffer &&
+	    (job_pack_cache.pack_time == now) &&
+	    (job_pack_cache.job_update == last_job_update) &&
+	    (job_pack_cache.part_update == last_part_update) &&
+	    (job_pack_cache.protocol_version == protocol_version) &&
+	    (job_pack_cache.show_flags == show_flags) &&
+	    (job_pack_cache.uid == uid) &&
+	    (job_pack_cache.filter_uid == filter_uid)) {
+		buffer_ptr[0] = xmalloc_nz(job_pack_cache.buffer_size);
+		memcpy(buffer_ptr[0], job_pack_cache.buffer,
+		       job_pack_cache.buffer_size);
+		*buffer_size = job_pack_cache.buffer_size;
+		found = true;
+	}
+	slurm_mutex_unlock(&job_pack_cache_mutex);
+
+	return found;
+}
+
+/* Save a copy of a pack_all_jobs() response for _get_job_pack_cache() */
+static void _set_job_pack_cache(char *buffer, int buffer_size, time_t now,
+				uint16_t show_flags, uid_t uid,
+				uint32_t filter_uid, uint16_t protocol_version)
+{
+	/*
+	 * An update recorded later in this same second would leave the
+	 * update times unchanged, so only cache data older than now.
+	 */
+	if ((last_job_update >= now) || (last_part_update >= now))
+		return;
+
+	slurm_mutex_lock(&job_pack_cache_mutex);
+	xfree(job_pack_cache.buffer);
+	job_pack_cache.buffer = xmalloc_nz(buffer_size);
+	memcpy(job_pack_cache.buffer, buffer, buffer_size);
+	job_pack_cache.buffer_size = buffer_size;
+	job_pack_cache.filter_uid = filter_uid;
+	job_pack_cache.job_update = last_job_update;
+	job_pack_cache.pack_time = now;
+	job_pack_cache.part_update = last_part_update;
+	job_pack_cache.protocol_version = protocol_version;
+	job_pack_cache.show_flags = show_flags;
+	job_pack_cache.uid = uid;
+	slurm_mutex_unlock(&job_pack_cache_mutex);
+}
+
 /*
  * pack_all_jobs - dump all job information for all jobs in
  *	machine independent form (for network transmission)
@@ -9541,6 +10172,7 @@ static int _foreach_pack_jobid(void *object, void *arg)
  * IN show_flags - job filtering options
  * IN uid - uid of user making request (for partition filtering)
  * IN filter_uid - pack only jobs belonging to this user if not NO_VAL
+ * IN info_filter - pack only jobs matching this filter if not NULL
  * global: job_list - global list of job records
  * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
  * NOTE: change _unpack_job_desc_msg() in common/slurm_protocol_pack.c
@@ -9548,24 +10180,35 @@ static int _foreach_pack_jobid(void *object, void *arg)
  */
 extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid, uint32_t filter_uid,
+			  info_filter_t *info_filter,
 			  uint16_t protocol_version)
 {
 	uint32_t jobs_packed = 0, tmp_offset;
 	_foreach_pack_job_info_t pack_info = {0};
 	buf_t *buffer;
+	job_filter_t *filter;
+	time_t now = time(NULL);
 
 	buffer_ptr[0] = NULL;
 	*buffer_size = 0;
 
+	/* Filtered responses are specific to one request, don't cache them */
+	filter = _build_job_filter(info_filter);
+	if (!filter &&
+	    _get_job_pack_cache(buffer_ptr, buffer_size, now, show_flags, uid,
+				filter_uid, protocol_version))
+		return;
+
 	buffer = init_buf(BUF_SIZE);
 
 	/* write message body header : size and time */
 	/* put in a place holder job record count of 0 for now */
 	pack32(jobs_packed, buffer);
-	pack_time(time(NULL), buffer);
+	pack_time(now, buffer);
 
 	/* write individual job records */
 	pack_info.buffer           = buffer;
+	pack_info.filter           = filter;
 	pack_info.filter_uid       = filter_uid;
 	pack_info.jobs_packed      = &jobs_packed;
 	pack_info.protocol_version = protocol_version;
@@ -9582,6 +10225,13 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 
 	*buffer_size = get_buf_offset(buffer);
 	buffer_ptr[0] = xfer_buf_data(buffer);
+
+	if (filter)
+		_free_job_filter(filter);
+	else
+		_set_job_pack_cache(buffer_ptr[0], *buffer_size, now,
+				    show_flags, uid, filter_uid,
+				    protocol_version);
 }
 
 /*
@@ -9961,9 +10611,11 @@ void pack_job(job_record_t *dump_job_ptr, uint16_t show_flags, buf_t *buffer,
 
 		packstr(dump_job_ptr->alloc_node, buffer);
 		if (!IS_JOB_COMPLETING(dump_job_ptr))
-			pack_bit_str_hex(dump_job_ptr->node_bitmap, buffer);
+			pack_bit_str(dump_job_ptr->node_bitmap, buffer,
+				     protocol_version);
 		else
-			pack_bit_str_hex(dump_job_ptr->node_bitmap_cg, buffer);
+			pack_bit_str(dump_job_ptr->node_bitmap_cg, buffer,
+				     protocol_version);
 
 		select_g_select_jobinfo_pack(dump_job_ptr->select_jobinfo,
 					     buffer, protocol_version);
@@ -10014,6 +10666,10 @@ void pack_job(job_record_t *dump_job_ptr, uint16_t show_flags, buf_t *buffer,
 
 		pack16(dump_job_ptr->mail_type, buffer);
 		packstr(dump_job_ptr->mail_user, buffer);
+
+		if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION)
+			pack64_array(dump_job_ptr->launch_time,
+				     JOB_LAUNCH_STAGE_CNT, buffer);
 	} else {
 		error("pack_job: protocol_version "
 		      "%hu not supported", protocol_version);
@@ -10396,9 +11052,11 @@ static void _pack_pending_job_details(struct job_details *detail_ptr,
 			pack32(detail_ptr->pn_min_tmp_disk, buffer);
 
 			packstr(detail_ptr->req_nodes, buffer);
-			pack_bit_str_hex(detail_ptr->req_node_bitmap, buffer);
+			pack_bit_str(detail_ptr->req_node_bitmap, buffer,
+				     protocol_version);
 			packstr(detail_ptr->exc_nodes, buffer);
-			pack_bit_str_hex(detail_ptr->exc_node_bitmap, buffer);
+			pack_bit_str(detail_ptr->exc_node_bitmap, buffer,
+				     protocol_version);
 
 			packstr(detail_ptr->std_err, buffer);
 			packstr(detail_ptr->std_in, buffer);
@@ -10514,6 +11172,72 @@ void handle_invalid_dependency(job_record_t *job_ptr)
 	fed_mgr_remove_remote_dependencies(job_ptr);
 }
 
+static int _ptr_cmp(const void *a, const void *b)
+{
+	uintptr_t x = (uintptr_t) *(void **) a, y = (uintptr_t) *(void **) b;
+
+	return (x > y) - (x < y);
+}
+
+typedef struct {
+	job_record_t **jobs;
+	int cnt;
+} purge_set_t;
+
+static int _list_find_job_purge(void *x, void *key)
+{
+	purge_set_t *set = key;
+
+	return bsearch(&x, set->jobs, set->cnt, sizeof(job_record_t *),
+		       _ptr_cmp) ? 1 : 0;
+}
+
+/*
+ * Purge the jobs queued by time_event_purge_add() which are now due, rather
+ * than testing every record in the job list.
+ * RET count of jobs purged
+ */
+static int _purge_due_jobs(time_t now)
+{
+	purge_set_t set = { 0 };
+	job_record_t *job_ptr, **retry = NULL;
+	int retry_cnt = 0, size = 0, retry_size = 0, i;
+	uint32_t job_id;
+
+	while ((job_id = time_event_purge_pop(now))) {
+		if (!(job_ptr = find_job_record(job_id)))
+			continue;	/* Already purged */
+		if (_list_find_job_old(job_ptr, "")) {
+			if (set.cnt >= size) {
+				size = MAX(64, size * 2);
+				xrecalloc(set.jobs, size, sizeof(*set.jobs));
+			}
+			set.jobs[set.cnt++] = job_ptr;
+		} else {
+			/* Queued again after the loop, else it is due now */
+			if (retry_cnt >= retry_size) {
+				retry_size = MAX(64, retry_size * 2);
+				xrecalloc(retry, retry_size, sizeof(*retry));
+			}
+			retry[retry_cnt++] = job_ptr;
+		}
+	}
+
+	for (i = 0; i < retry_cnt; i++)
+		time_event_purge_add(retry[i]);
+	xfree(retry);
+
+	if (set.cnt) {
+		/* A job id may have been queued more than once */
+		qsort(set.jobs, set.cnt, sizeof(*set.jobs), _ptr_cmp);
+		i = list_delete_all(job_list, _list_find_job_purge, &set);
+	} else
+		i = 0;
+	xfree(set.jobs);
+
+	return i;
+}
+
 /*
  * purge_old_job - purge old job records.
  *	The jobs must have completed at least MIN_JOB_AGE minutes ago.
@@ -10522,9 +11246,11 @@ void handle_invalid_dependency(job_record_t *job_ptr)
  */
 void purge_old_job(void)
 {
+	static time_t last_full_purge = 0;
 	ListIterator job_iterator;
 	job_record_t *job_ptr;
 	int i, purge_job_count;
+	time_t now = time(NULL);
 
 	xassert(verify_lock(CONF_LOCK, READ_LOCK));
 	xassert(verify_lock(JOB_LOCK, WRITE_LOCK));
@@ -10557,7 +11283,15 @@ void purge_old_job(void)
 	list_iterator_destroy(job_iterator);
 	fed_mgr_test_remote_dependencies();
 
-	i = list_delete_all(job_list, &_list_find_job_old, "");
+	/*
+	 * Finished jobs are queued by the time they become purgeable, a full
+	 * scan of the job list only catches those which were missed.
+	 */
+	if (difftime(now, last_full_purge) >= PURGE_FULL_INTERVAL) {
+		last_full_purge = now;
+		i = list_delete_all(job_list, &_list_find_job_old, "");
+	} else
+		i = _purge_due_jobs(now);
 	if (i) {
 		debug2("purge_old_job: purged %d old job records", i);
 		last_job_update = time(NULL);
@@ -12920,8 +13654,10 @@ static int _update_job(job_record_t *job_ptr, job_desc_msg_t *job_specs,
 			sched_debug("%s: new name identical to old name %pJ",
 				    __func__, job_ptr);
 		} else {
+			_remove_job_name_hash(job_ptr);
 			xfree(job_ptr->name);
 			job_ptr->name = xstrdup(job_specs->name);
+			_add_job_name_hash(job_ptr);
 
 			sched_info("%s: setting name to %s for %pJ",
 				   __func__, job_ptr->name, job_ptr);
@@ -13631,6 +14367,11 @@ fini:
 	    xstrcmp(slurm_conf.priority_type, "priority/basic"))
 		set_job_prio(job_ptr);
 
+	if (job_specs->begin_time || job_specs->deadline ||
+	    (job_specs->time_limit != NO_VAL) ||
+	    (job_specs->time_min != NO_VAL))
+		time_event_job_add(job_ptr);
+
 	if ((error_code == SLURM_SUCCESS) &&
 	    fed_mgr_fed_rec &&
 	    job_ptr->fed_details && fed_mgr_is_origin_job(job_ptr)) {
@@ -14640,6 +15381,7 @@ int sync_job_files(void)
 	_validate_job_files(batch_dirs);
 	_remove_defunct_batch_dirs(batch_dirs);
 	FREE_NULL_LIST(batch_dirs);
+	blob_store_sync();
 	return SLURM_SUCCESS;
 }
 
@@ -14709,6 +15451,11 @@ static int _test_state_dir_flag(void *x, void *arg)
 		return 0;
 	}
 
+	if (job_ptr->details && job_ptr->details->script_blob &&
+	    blob_store_exists(job_ptr->details->script_blob) &&
+	    blob_store_exists(job_ptr->details->env_blob))
+		return 0;
+
 	if (!job_ptr->batch_flag || !IS_JOB_PENDING(job_ptr) ||
 	    (job_ptr->het_job_offset > 0))
 		return 0;	/* No files expected */
@@ -14974,6 +15721,7 @@ void batch_requeue_fini(job_record_t *job_ptr)
 						  SLURM_CRED_OPT_EXPIRY_WINDOW,
 						  &cred_lifetime);
 			job_ptr->details->begin_time = now + cred_lifetime + 1;
+			time_event_job_add(job_ptr);
 		}
 
 		/* Since this could happen on a launch we need to make sure the
@@ -15041,9 +15789,17 @@ void batch_requeue_fini(job_record_t *job_ptr)
 void job_fini (void)
 {
 	FREE_NULL_LIST(job_list);
+	depend_fini();
+	job_queue_rec_fini();
+	srun_job_wait_fini();
+	event_bus_fini();
 	xfree(job_hash);
+	xfree(job_name_hash);
 	xfree(job_array_hash_j);
 	xfree(job_array_hash_t);
+	slurm_mutex_lock(&job_pack_cache_mutex);
+	xfree(job_pack_cache.buffer);
+	slurm_mutex_unlock(&job_pack_cache_mutex);
 	FREE_NULL_LIST(purge_files_list);
 	FREE_NULL_BITMAP(requeue_exit);
 	FREE_NULL_BITMAP(requeue_exit_hold);
@@ -15136,6 +15892,10 @@ extern void job_completion_logger(job_record_t *job_ptr, bool requeue)
 
 	xassert(job_ptr);
 
+	time_event_purge_add(job_ptr);
+	depend_notify_job(job_ptr);
+	srun_job_wait_notify(job_ptr);
+	event_bus_job(job_ptr, CTLD_EVENT_JOB_END);
 	acct_policy_remove_job_submit(job_ptr);
 	if (job_ptr->nodes && ((job_ptr->bit_flags & JOB_KILL_HURRY) == 0)
 	    && !IS_JOB_RESIZING(job_ptr)) {
@@ -15275,7 +16035,11 @@ extern bool job_independent(job_record_t *job_ptr)
 
 	/* Test dependencies first so we can cancel jobs before dependent
 	 * job records get purged (e.g. afterok, afternotok) */
-	depend_rc = test_job_dependency(job_ptr, NULL);
+	if (detail_ptr && detail_ptr->depend_cached &&
+	    (job_ptr->bit_flags & JOB_DEPENDENT))
+		depend_rc = LOCAL_DEPEND;	/* none changed state */
+	else
+		depend_rc = test_job_dependency(job_ptr, NULL);
 	if ((depend_rc == LOCAL_DEPEND) || (depend_rc == REMOTE_DEPEND)) {
 		/* start_time has passed but still has dependency which
 		 * makes it ineligible */
@@ -15667,10 +16431,8 @@ static int _resume_job_nodes(job_record_t *job_ptr, bool indf_susp)
 				bit_clear(share_node_bitmap, i);
 		}
 
-		if (slurm_mcs_get_select(job_ptr) == 1) {
-			xfree(node_ptr->mcs_label);
-			node_ptr->mcs_label = xstrdup(job_ptr->mcs_label);
-		}
+		if (slurm_mcs_get_select(job_ptr) == 1)
+			node_set_mcs(node_ptr, job_ptr->mcs_label);
 
 		bit_clear(idle_node_bitmap, i);
 		node_flags = node_ptr->node_state & NODE_STATE_FLAGS;
@@ -17246,6 +18008,7 @@ extern bool job_hold_requeue(job_record_t *job_ptr)
 		job_ptr->job_state |= JOB_REQUEUE;
 		job_ptr->details->begin_time =
 			calc_next_cron_start(job_ptr->details->crontab_entry);
+		time_event_job_add(job_ptr);
 	} else if (job_ptr->bit_flags & CRON_JOB) {
 		/*
 		 * Skip requeuing this instead of crashing.
@@ -69,9 +69,11 @@
 #include "src/common/strlcpy.h"
 #include "src/common/parse_time.h"
 #include "src/common/timers.h"
+#include "src/common/trace.h"
 #include "src/common/track_script.h"
 #include "src/common/uid.h"
 #include "src/common/xassert.h"
+#include "src/common/xhash.h"
 #include "src/common/xstring.h"
 
 #include "src/slurmctld/acct_policy.h"
@@ -93,18 +95,35 @@
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/srun_comm.h"
 #include "src/slurmctld/state_save.h"
+#include "src/slurmctld/time_event.h"
 
 #ifndef CORRESPOND_ARRAY_TASK_CNT
 #  define CORRESPOND_ARRAY_TASK_CNT 10
 #endif
 #define BUILD_TIMEOUT 2000000	/* Max build_job_queue() run time in usec */
 #define MAX_FAILED_RESV 10
+#define MAX_FAILED_CLASS 64
+
+/*
+ * A job that failed to start in this scheduling pass, used to skip later
+ * pending jobs with an identical resource request (the same "class").
+ */
+typedef struct sched_class {
+	uint32_t hash;
+	job_record_t *job_ptr;
+} sched_class_t;
 
 typedef struct wait_boot_arg {
 	uint32_t job_id;
 	bitstr_t *node_bitmap;
 } wait_boot_arg_t;
 
+typedef struct {
+	char *features;		/* NULL if rebooting without feature change */
+	bitstr_t *node_bitmap;	/* nodes still to be sent the request */
+	uint16_t protocol_version;
+} reboot_batch_t;
+
 static batch_job_launch_msg_t *_build_launch_job_msg(job_record_t *job_ptr,
 						     uint16_t protocol_version);
 static void	_job_queue_append(List job_queue, job_record_t *job_ptr,
@@ -136,6 +155,40 @@ static int sched_min_interval = 2;
 static int bb_array_stage_cnt = 10;
 extern diag_stats_t slurmctld_diag_stats;
 
+#ifndef HAVE_FRONT_END
+static List reboot_batch_list = NULL;	/* reboot_batch_t, by features */
+#endif
+
+/*
+ * Pool of job_queue_rec_t, so that building the job queue for every main
+ * and backfill scheduling cycle does not malloc and free a record per
+ * job and partition pair. Records are carved from chunks which are only
+ * freed by job_queue_rec_fini(), and freed records are kept on a list
+ * for the next cycle. The schedulers can run at once, hence the mutex.
+ */
+#define JOB_QUEUE_REC_CHUNK 4096
+
+typedef union job_queue_slot {
+	job_queue_rec_t rec;
+	union job_queue_slot *next;	/* While on the free list */
+} job_queue_slot_t;
+
+static pthread_mutex_t job_queue_rec_mutex = PTHREAD_MUTEX_INITIALIZER;
+static job_queue_slot_t *job_queue_rec_avail = NULL;
+static job_queue_slot_t **job_queue_rec_chunk = NULL;
+static int job_queue_rec_chunk_cnt = 0;
+
+/*
+ * Reverse dependency index, from a job to the IDs of the jobs whose cached
+ * dependency test result depends upon its state.
+ */
+typedef struct {
+	uint32_t job_id;	/* job depended upon */
+	List dependents;	/* uint32_t job IDs */
+} depend_rev_t;
+
+static xhash_t *depend_rev_hash = NULL;
+
 static int _find_singleton_job (void *x, void *key)
 {
 	struct job_record *qjob_ptr = (struct job_record *) x;
@@ -164,6 +217,87 @@ static int _find_singleton_job (void *x, void *key)
 	return 0;
 }
 
+static void _depend_rev_id(void *item, const char **key, uint32_t *key_len)
+{
+	depend_rev_t *rev = item;
+
+	*key = (const char *) &rev->job_id;
+	*key_len = sizeof(rev->job_id);
+}
+
+static void _depend_rev_free(void *item)
+{
+	depend_rev_t *rev = item;
+
+	FREE_NULL_LIST(rev->dependents);
+	xfree(rev);
+}
+
+static void _depend_rev_add(uint32_t job_id, uint32_t dependent_id)
+{
+	depend_rev_t *rev;
+	uint32_t *id_ptr;
+
+	if (!depend_rev_hash)
+		depend_rev_hash = xhash_init(_depend_rev_id, _depend_rev_free);
+
+	if (!(rev = xhash_get(depend_rev_hash, (char *) &job_id,
+			      sizeof(job_id)))) {
+		rev = xmalloc(sizeof(*rev));
+		rev->job_id = job_id;
+		rev->dependents = list_create(xfree_ptr);
+		xhash_add(depend_rev_hash, rev);
+	}
+	id_ptr = xmalloc(sizeof(*id_ptr));
+	*id_ptr = dependent_id;
+	list_append(rev->dependents, id_ptr);
+}
+
+extern void depend_notify_job(job_record_t *job_ptr)
+{
+	depend_rev_t *rev;
+	job_record_t *dep_job_ptr;
+	uint32_t *id_ptr;
+
+	if (!depend_rev_hash ||
+	    !(rev = xhash_pop(depend_rev_hash, (char *) &job_ptr->job_id,
+			      sizeof(job_ptr->job_id))))
+		return;
+
+	while ((id_ptr = list_pop(rev->dependents))) {
+		if ((dep_job_ptr = find_job_record(*id_ptr)) &&
+		    dep_job_ptr->details)
+			dep_job_ptr->details->depend_cached = false;
+		xfree(id_ptr);
+	}
+	_depend_rev_free(rev);
+}
+
+extern void depend_fini(void)
+{
+	xhash_free(depend_rev_hash);
+}
+
+/*
+ * Return true if the result of this unfulfilled local dependency can only
+ * change when the state of dep_ptr->job_id changes
+ */
+static bool _depend_cacheable(depend_spec_t *dep_ptr)
+{
+	if ((dep_ptr->array_task_id != NO_VAL) || dep_ptr->depend_time)
+		return false;
+
+	switch (dep_ptr->depend_type) {
+	case SLURM_DEPEND_AFTER:
+	case SLURM_DEPEND_AFTER_ANY:
+	case SLURM_DEPEND_AFTER_NOT_OK:
+	case SLURM_DEPEND_AFTER_OK:
+		return true;
+	default:
+		return false;
+	}
+}
+
 /*
  * Calculate how busy the system is by figuring out how busy each node is.
  */
@@ -425,6 +559,101 @@ extern void job_queue_rec_resv_list(job_queue_rec_t *job_queue_rec)
 	job_ptr->resv_id = job_ptr->resv_ptr->resv_id;
 }
 
+/* Split out a job array task that needs burst buffer staging */
+static void _split_bb_array(job_record_t *job_ptr)
+{
+	job_record_t *new_job_ptr;
+	int i, pend_cnt;
+
+	if ((i = bit_ffs(job_ptr->array_recs->task_id_bitmap)) < 0)
+		return;
+	pend_cnt = num_pending_job_array_tasks(job_ptr->array_job_id);
+	if (pend_cnt >= bb_array_stage_cnt)
+		return;
+	if (job_ptr->array_recs->task_cnt < 1)
+		return;
+	if (job_ptr->array_recs->task_cnt == 1) {
+		job_ptr->array_task_id = i;
+		(void) job_array_post_sched(job_ptr);
+		if (job_ptr->details && job_ptr->details->dependency &&
+		    job_ptr->details->depend_list)
+			fed_mgr_submit_remote_dependencies(job_ptr, false,
+							   false);
+		return;
+	}
+	job_ptr->array_task_id = i;
+	new_job_ptr = job_array_split(job_ptr);
+	if (new_job_ptr) {
+		debug("%s: Split out %pJ for burst buffer use",
+		      __func__, job_ptr);
+		new_job_ptr->job_state = JOB_PENDING;
+		new_job_ptr->start_time = (time_t) 0;
+		/* Do NOT clear db_index here, it is handled when
+		 * task_id_str is created elsewhere */
+		(void) bb_g_job_validate2(job_ptr, NULL);
+	} else {
+		error("%s: Unable to copy record for %pJ",
+		      __func__, job_ptr);
+	}
+}
+
+/*
+ * Split out a job array task with depend_type ==
+ * SLURM_DEPEND_AFTER_CORRESPOND
+ */
+static void _split_correspond_array(job_record_t *job_ptr)
+{
+	job_record_t *new_job_ptr;
+	ListIterator depend_iter;
+	depend_spec_t *dep_ptr;
+	int i, pend_cnt, dep_corr;
+
+	if ((i = bit_ffs(job_ptr->array_recs->task_id_bitmap)) < 0)
+		return;
+	if ((job_ptr->details == NULL) ||
+	    (job_ptr->details->depend_list == NULL) ||
+	    (list_count(job_ptr->details->depend_list) == 0))
+		return;
+	depend_iter = list_iterator_create(job_ptr->details->depend_list);
+	dep_corr = 0;
+	while ((dep_ptr = list_next(depend_iter))) {
+		if (dep_ptr->depend_type == SLURM_DEPEND_AFTER_CORRESPOND) {
+			dep_corr = 1;
+			break;
+		}
+	}
+	list_iterator_destroy(depend_iter);
+	if (!dep_corr)
+		return;
+	pend_cnt = num_pending_job_array_tasks(job_ptr->array_job_id);
+	if (pend_cnt >= correspond_after_task_cnt)
+		return;
+	if (job_ptr->array_recs->task_cnt < 1)
+		return;
+	if (job_ptr->array_recs->task_cnt == 1) {
+		job_ptr->array_task_id = i;
+		(void) job_array_post_sched(job_ptr);
+		if (job_ptr->details && job_ptr->details->dependency &&
+		    job_ptr->details->depend_list)
+			fed_mgr_submit_remote_dependencies(job_ptr, false,
+							   false);
+		return;
+	}
+	job_ptr->array_task_id = i;
+	new_job_ptr = job_array_split(job_ptr);
+	if (new_job_ptr) {
+		info("%s: Split out %pJ for SLURM_DEPEND_AFTER_CORRESPOND use",
+		     __func__, job_ptr);
+		new_job_ptr->job_state = JOB_PENDING;
+		new_job_ptr->start_time = (time_t) 0;
+		/* Do NOT clear db_index here, it is handled when
+		 * task_id_str is created elsewhere */
+	} else {
+		error("%s: Unable to copy record for %pJ",
+		      __func__, job_ptr);
+	}
+}
+
 /*
  * build_job_queue - build (non-priority ordered) list of pending jobs
  * IN clear_start - if set then clear the start_time for pending jobs,
@@ -437,11 +666,10 @@ extern List build_job_queue(bool clear_start, bool backfill)
 {
 	static time_t last_log_time = 0;
 	List job_queue;
-	ListIterator depend_iter, job_iterator, part_iterator;
-	job_record_t *job_ptr = NULL, *new_job_ptr;
+	ListIterator job_iterator, part_iterator;
+	job_record_t *job_ptr = NULL;
 	part_record_t *part_ptr;
-	depend_spec_t *dep_ptr;
-	int i, pend_cnt, reason, dep_corr;
+	int reason;
 	struct timeval start_tv = {0, 0};
 	int tested_jobs = 0;
 	int job_part_pairs = 0;
@@ -449,13 +677,16 @@ extern List build_job_queue(bool clear_start, bool backfill)
 
 	/* init the timer */
 	(void) slurm_delta_tv(&start_tv);
-	job_queue = list_create(xfree_ptr);
+	job_queue = list_create(job_queue_rec_free);
 
 	/*
 	 * Create individual job records for job arrays that need burst buffer
-	 * staging
+	 * staging or have depend_type == SLURM_DEPEND_AFTER_CORRESPOND.
+	 * Both only apply to pending job array meta records, so do them in
+	 * one pass over job_list. Records split out here are appended to
+	 * job_list and are seen later in this same pass.
 	 *
-	 * NOTE: You can not use list_for_each for these loops here because
+	 * NOTE: You can not use list_for_each for this loop here because
 	 * job_array_post_sched and job_array_split could eventually call
 	 * _create_job_record which appends to job_list causing deadlock.  The
 	 * last one calls job_independent from _job_runnable_test1 which
@@ -463,101 +694,16 @@ extern List build_job_queue(bool clear_start, bool backfill)
 	 * either.
 	 */
 	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = list_next(job_iterator))) {
-		if (!IS_JOB_PENDING(job_ptr) ||
-		    !job_ptr->burst_buffer || !job_ptr->array_recs ||
-		    !job_ptr->array_recs->task_id_bitmap ||
-		    (job_ptr->array_task_id != NO_VAL))
-			continue;
-
-		if ((i = bit_ffs(job_ptr->array_recs->task_id_bitmap)) < 0)
-			continue;
-		pend_cnt = num_pending_job_array_tasks(job_ptr->array_job_id);
-		if (pend_cnt >= bb_array_stage_cnt)
-			continue;
-		if (job_ptr->array_recs->task_cnt < 1)
-			continue;
-		if (job_ptr->array_recs->task_cnt == 1) {
-			job_ptr->array_task_id = i;
-			(void) job_array_post_sched(job_ptr);
-			if (job_ptr->details && job_ptr->details->dependency &&
-			    job_ptr->details->depend_list)
-				fed_mgr_submit_remote_dependencies(job_ptr,
-								   false,
-								   false);
-			continue;
-		}
-		job_ptr->array_task_id = i;
-		new_job_ptr = job_array_split(job_ptr);
-		if (new_job_ptr) {
-			debug("%s: Split out %pJ for burst buffer use",
-			      __func__, job_ptr);
-			new_job_ptr->job_state = JOB_PENDING;
-			new_job_ptr->start_time = (time_t) 0;
-			/* Do NOT clear db_index here, it is handled when
-			 * task_id_str is created elsewhere */
-			(void) bb_g_job_validate2(job_ptr, NULL);
-		} else {
-			error("%s: Unable to copy record for %pJ",
-			      __func__, job_ptr);
-		}
-	}
-
-	/* Create individual job records for job arrays with
-	 * depend_type == SLURM_DEPEND_AFTER_CORRESPOND */
-	list_iterator_reset(job_iterator);
 	while ((job_ptr = list_next(job_iterator))) {
 		if (!IS_JOB_PENDING(job_ptr) ||
 		    !job_ptr->array_recs ||
 		    !job_ptr->array_recs->task_id_bitmap ||
 		    (job_ptr->array_task_id != NO_VAL))
 			continue;
-		if ((i = bit_ffs(job_ptr->array_recs->task_id_bitmap)) < 0)
-			continue;
-		if ((job_ptr->details == NULL) ||
-		    (job_ptr->details->depend_list == NULL) ||
-		    (list_count(job_ptr->details->depend_list) == 0))
-			continue;
-		depend_iter = list_iterator_create(
-			job_ptr->details->depend_list);
-		dep_corr = 0;
-		while ((dep_ptr = list_next(depend_iter))) {
-			if (dep_ptr->depend_type ==
-			    SLURM_DEPEND_AFTER_CORRESPOND) {
-				dep_corr = 1;
-				break;
-			}
-		}
-		if (!dep_corr)
-			continue;
-		pend_cnt = num_pending_job_array_tasks(job_ptr->array_job_id);
-		if (pend_cnt >= correspond_after_task_cnt)
-			continue;
-		if (job_ptr->array_recs->task_cnt < 1)
-			continue;
-		if (job_ptr->array_recs->task_cnt == 1) {
-			job_ptr->array_task_id = i;
-			(void) job_array_post_sched(job_ptr);
-			if (job_ptr->details && job_ptr->details->dependency &&
-			    job_ptr->details->depend_list)
-				fed_mgr_submit_remote_dependencies(job_ptr,
-								   false,
-								   false);
-			continue;
-		}
-		job_ptr->array_task_id = i;
-		new_job_ptr = job_array_split(job_ptr);
-		if (new_job_ptr) {
-			info("%s: Split out %pJ for SLURM_DEPEND_AFTER_CORRESPOND use",
-			     __func__, job_ptr);
-			new_job_ptr->job_state = JOB_PENDING;
-			new_job_ptr->start_time = (time_t) 0;
-			/* Do NOT clear db_index here, it is handled when
-			 * task_id_str is created elsewhere */
-		} else {
-			error("%s: Unable to copy record for %pJ",
-			      __func__, job_ptr);
-		}
+		if (job_ptr->burst_buffer)
+			_split_bb_array(job_ptr);
+		if (job_ptr->array_task_id == NO_VAL)
+			_split_correspond_array(job_ptr);
 	}
 
 	list_iterator_reset(job_iterator);
@@ -750,6 +896,116 @@ static bool _failed_partition(part_record_t *part_ptr,
 	return false;
 }
 
+/*
+ * Hash the fields of a job's request which determine whether select_nodes()
+ * can start it. Returns 0 if the job can not share the outcome of an
+ * other job's scheduling attempt (its result depends upon per-job state).
+ */
+static uint32_t _job_sched_class_hash(job_record_t *job_ptr)
+{
+	struct job_details *detail_ptr = job_ptr->details;
+	uint32_t hash;
+
+	if (!detail_ptr || job_ptr->het_job_id || job_ptr->array_recs ||
+	    (job_ptr->array_task_id != NO_VAL) || job_ptr->burst_buffer ||
+	    (job_ptr->deadline && (job_ptr->deadline != NO_VAL)) ||
+	    job_ptr->req_switch || detail_ptr->expanding_jobid)
+		return 0;
+
+	hash = job_ptr->user_id;
+	hash = (hash * 31) + job_ptr->assoc_id;
+	hash = (hash * 31) + job_ptr->qos_id;
+	hash = (hash * 31) + (uint32_t) (uintptr_t) job_ptr->part_ptr;
+	hash = (hash * 31) + job_ptr->time_limit;
+	hash = (hash * 31) + detail_ptr->min_nodes;
+	hash = (hash * 31) + detail_ptr->min_cpus;
+	hash = (hash * 31) + (uint32_t) detail_ptr->pn_min_memory;
+
+	return hash ? hash : 1;
+}
+
+/* Return true if both jobs request identical resources */
+static bool _job_sched_class_match(job_record_t *job_ptr,
+				   job_record_t *class_ptr)
+{
+	struct job_details *d1 = job_ptr->details, *d2 = class_ptr->details;
+
+	if ((job_ptr->user_id != class_ptr->user_id) ||
+	    (job_ptr->group_id != class_ptr->group_id) ||
+	    (job_ptr->assoc_id != class_ptr->assoc_id) ||
+	    (job_ptr->qos_id != class_ptr->qos_id) ||
+	    (job_ptr->part_ptr != class_ptr->part_ptr) ||
+	    (job_ptr->resv_ptr != class_ptr->resv_ptr) ||
+	    (job_ptr->bit_flags != class_ptr->bit_flags) ||
+	    (job_ptr->delay_boot != class_ptr->delay_boot) ||
+	    (job_ptr->power_flags != class_ptr->power_flags) ||
+	    (job_ptr->reboot != class_ptr->reboot) ||
+	    (job_ptr->time_limit != class_ptr->time_limit) ||
+	    (job_ptr->time_min != class_ptr->time_min))
+		return false;
+
+	if ((d1->contiguous != d2->contiguous) ||
+	    (d1->core_spec != d2->core_spec) ||
+	    (d1->cpus_per_task != d2->cpus_per_task) ||
+	    (d1->max_cpus != d2->max_cpus) ||
+	    (d1->max_nodes != d2->max_nodes) ||
+	    (d1->min_cpus != d2->min_cpus) ||
+	    (d1->min_nodes != d2->min_nodes) ||
+	    (d1->ntasks_per_node != d2->ntasks_per_node) ||
+	    (d1->ntasks_per_tres != d2->ntasks_per_tres) ||
+	    (d1->num_tasks != d2->num_tasks) ||
+	    (d1->overcommit != d2->overcommit) ||
+	    (d1->plane_size != d2->plane_size) ||
+	    (d1->pn_min_cpus != d2->pn_min_cpus) ||
+	    (d1->pn_min_memory != d2->pn_min_memory) ||
+	    (d1->pn_min_tmp_disk != d2->pn_min_tmp_disk) ||
+	    (d1->share_res != d2->share_res) ||
+	    (d1->task_dist != d2->task_dist) ||
+	    (d1->whole_node != d2->whole_node))
+		return false;
+
+	if ((!d1->mc_ptr != !d2->mc_ptr) ||
+	    (d1->mc_ptr &&
+	     memcmp(d1->mc_ptr, d2->mc_ptr, sizeof(multi_core_data_t))))
+		return false;
+
+	if (xstrcmp(d1->features, d2->features) ||
+	    xstrcmp(d1->cluster_features, d2->cluster_features) ||
+	    xstrcmp(d1->req_nodes, d2->req_nodes) ||
+	    xstrcmp(d1->exc_nodes, d2->exc_nodes) ||
+	    xstrcmp(job_ptr->tres_req_str, class_ptr->tres_req_str) ||
+	    xstrcmp(job_ptr->tres_per_job, class_ptr->tres_per_job) ||
+	    xstrcmp(job_ptr->tres_per_node, class_ptr->tres_per_node) ||
+	    xstrcmp(job_ptr->tres_per_socket, class_ptr->tres_per_socket) ||
+	    xstrcmp(job_ptr->tres_per_task, class_ptr->tres_per_task) ||
+	    xstrcmp(job_ptr->cpus_per_tres, class_ptr->cpus_per_tres) ||
+	    xstrcmp(job_ptr->mem_per_tres, class_ptr->mem_per_tres) ||
+	    xstrcmp(job_ptr->licenses, class_ptr->licenses) ||
+	    xstrcmp(job_ptr->network, class_ptr->network) ||
+	    xstrcmp(job_ptr->mcs_label, class_ptr->mcs_label))
+		return false;
+
+	return true;
+}
+
+/*
+ * Return the job of the same class which already failed to start in this
+ * pass or NULL if none.
+ */
+static job_record_t *_failed_class(job_record_t *job_ptr, uint32_t hash,
+				   sched_class_t *failed_class,
+				   int failed_class_cnt)
+{
+	int i;
+
+	for (i = 0; i < failed_class_cnt; i++) {
+		if ((failed_class[i].hash == hash) &&
+		    _job_sched_class_match(job_ptr, failed_class[i].job_ptr))
+			return failed_class[i].job_ptr;
+	}
+	return NULL;
+}
+
 static void _do_diag_stats(long delta_t)
 {
 	if (delta_t > slurmctld_diag_stats.schedule_cycle_max)
@@ -986,6 +1242,55 @@ extern void fill_array_reasons(job_record_t *job_ptr,
 	}
 }
 
+extern job_queue_rec_t *job_queue_rec_alloc(void)
+{
+	job_queue_slot_t *slot;
+	int i;
+
+	slurm_mutex_lock(&job_queue_rec_mutex);
+	if (!job_queue_rec_avail) {
+		slot = xcalloc(JOB_QUEUE_REC_CHUNK, sizeof(job_queue_slot_t));
+		xrecalloc(job_queue_rec_chunk, job_queue_rec_chunk_cnt + 1,
+			  sizeof(job_queue_slot_t *));
+		job_queue_rec_chunk[job_queue_rec_chunk_cnt++] = slot;
+		for (i = 0; i < (JOB_QUEUE_REC_CHUNK - 1); i++)
+			slot[i].next = &slot[i + 1];
+		job_queue_rec_avail = slot;
+	}
+	slot = job_queue_rec_avail;
+	job_queue_rec_avail = slot->next;
+	slurm_mutex_unlock(&job_queue_rec_mutex);
+
+	memset(&slot->rec, 0, sizeof(slot->rec));
+	return &slot->rec;
+}
+
+extern void job_queue_rec_free(void *x)
+{
+	job_queue_slot_t *slot = x;
+
+	if (!slot)
+		return;
+
+	slurm_mutex_lock(&job_queue_rec_mutex);
+	slot->next = job_queue_rec_avail;
+	job_queue_rec_avail = slot;
+	slurm_mutex_unlock(&job_queue_rec_mutex);
+}
+
+extern void job_queue_rec_fini(void)
+{
+	int i;
+
+	slurm_mutex_lock(&job_queue_rec_mutex);
+	for (i = 0; i < job_queue_rec_chunk_cnt; i++)
+		xfree(job_queue_rec_chunk[i]);
+	xfree(job_queue_rec_chunk);
+	job_queue_rec_chunk_cnt = 0;
+	job_queue_rec_avail = NULL;
+	slurm_mutex_unlock(&job_queue_rec_mutex);
+}
+
 extern void job_queue_append_internal(job_queue_req_t *job_queue_req)
 {
 	job_queue_rec_t *job_queue_rec;
@@ -995,7 +1300,7 @@ extern void job_queue_append_internal(job_queue_req_t *job_queue_req)
 	xassert(job_queue_req->job_queue);
 	xassert(job_queue_req->part_ptr);
 
-	job_queue_rec = xmalloc(sizeof(job_queue_rec_t));
+	job_queue_rec = job_queue_rec_alloc();
 	job_queue_rec->array_task_id = job_queue_req->job_ptr->array_task_id;
 	job_queue_rec->job_id   = job_queue_req->job_ptr->job_id;
 	job_queue_rec->job_ptr  = job_queue_req->job_ptr;
@@ -1010,15 +1315,18 @@ static int _schedule(bool full_queue)
 	ListIterator job_iterator = NULL, part_iterator = NULL;
 	List job_queue = NULL;
 	int failed_part_cnt = 0, failed_resv_cnt = 0, job_cnt = 0;
+	int failed_class_cnt = 0;
 	int error_code, i, j, part_cnt, time_limit, pend_time;
-	uint32_t job_depth = 0, array_task_id;
+	uint32_t job_depth = 0, array_task_id, class_hash;
 	job_queue_rec_t *job_queue_rec;
-	job_record_t *job_ptr = NULL;
+	job_record_t *job_ptr = NULL, *class_ptr;
+	sched_class_t *failed_class = NULL;
 	part_record_t *part_ptr, **failed_parts = NULL, *skip_part_ptr = NULL;
 	struct slurmctld_resv **failed_resv = NULL;
 	bitstr_t *save_avail_node_bitmap;
 	part_record_t **sched_part_ptr = NULL;
 	int *sched_part_jobs = NULL, bb_wait_cnt = 0;
+	uint64_t span, trace_id;
 	/* Locks: Read config, write job, write node, read partition */
 	slurmctld_lock_t job_write_lock =
 		{ READ_LOCK, WRITE_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK };
@@ -1027,6 +1335,7 @@ static int _schedule(bool full_queue)
 	static bool fifo_sched = false;
 	static bool assoc_limit_stop = false;
 	static int sched_timeout = 0;
+	static int sched_timeout_usec = 0;
 	static int sched_max_job_start = 0;
 	static int bf_min_age_reserve = 0;
 	static uint32_t bf_min_prio_reserve = 0;
@@ -1035,6 +1344,8 @@ static int _schedule(bool full_queue)
 	static int defer_rpc_cnt = 0;
 	static bool reduce_completing_frag = false;
 	time_t now, last_job_sched_start, sched_start;
+	struct timeval sched_start_tv = { 0, 0 };
+	bool carry_over = false;
 	job_record_t *reject_array_job = NULL;
 	part_record_t *reject_array_part = NULL;
 	bool fail_by_part, wait_on_resv;
@@ -1223,6 +1534,19 @@ static int _schedule(bool full_queue)
 			sched_timeout = MIN(sched_timeout, 2);
 		}
 
+		sched_timeout_usec = 0;
+		if ((tmp_ptr = xstrcasestr(slurm_conf.sched_params,
+		                           "max_sched_usec="))) {
+			sched_timeout_usec = atoi(tmp_ptr + 15);
+			if ((sched_timeout_usec <= 0) ||
+			    (sched_timeout_usec >
+			     (sched_timeout * USEC_IN_SEC))) {
+				error("Invalid max_sched_usec: %d",
+				      sched_timeout_usec);
+				sched_timeout_usec = 0;
+			}
+		}
+
 		if ((tmp_ptr = xstrcasestr(slurm_conf.sched_params,
 		                           "sched_interval="))) {
 			sched_interval = atoi(tmp_ptr + 15);
@@ -1260,11 +1584,12 @@ static int _schedule(bool full_queue)
 
 		sched_update = slurm_conf.last_update;
 		info("SchedulerParameters=default_queue_depth=%d,"
-		     "max_rpc_cnt=%d,max_sched_time=%d,partition_job_depth=%d,"
-		     "sched_max_job_start=%d,sched_min_interval=%d",
+		     "max_rpc_cnt=%d,max_sched_time=%d,max_sched_usec=%d,"
+		     "partition_job_depth=%d,sched_max_job_start=%d,"
+		     "sched_min_interval=%d",
 		     def_job_limit, defer_rpc_cnt, sched_timeout,
-		     max_jobs_per_part, sched_max_job_start,
-		     sched_min_interval);
+		     sched_timeout_usec, max_jobs_per_part,
+		     sched_max_job_start, sched_min_interval);
 	}
 
 	slurm_mutex_lock(&slurmctld_config.thread_count_lock);
@@ -1284,6 +1609,7 @@ static int _schedule(bool full_queue)
 	lock_slurmctld(job_write_lock);
 	now = time(NULL);
 	sched_start = now;
+	(void) slurm_delta_tv(&sched_start_tv);
 	last_job_sched_start = now;
 	START_TIMER;
 	if (!avail_front_end(NULL)) {
@@ -1314,6 +1640,7 @@ static int _schedule(bool full_queue)
 	part_cnt = list_count(part_list);
 	failed_parts = xcalloc(part_cnt, sizeof(part_record_t *));
 	failed_resv = xmalloc(sizeof(struct slurmctld_resv*) * MAX_FAILED_RESV);
+	failed_class = xcalloc(MAX_FAILED_CLASS, sizeof(sched_class_t));
 	save_avail_node_bitmap = bit_copy(avail_node_bitmap);
 	bit_or(avail_node_bitmap, rs_node_bitmap);
 
@@ -1452,7 +1779,7 @@ next_part:
 				job_queue_rec_resv_list(job_queue_rec);
 			else
 				job_queue_rec_magnetic_resv(job_queue_rec);
-			xfree(job_queue_rec);
+			job_queue_rec_free(job_queue_rec);
 
 			if (!avail_front_end(job_ptr)) {
 				job_ptr->state_reason = WAIT_FRONT_END;
@@ -1493,6 +1820,13 @@ next_part:
 next_task:
 		if ((time(NULL) - sched_start) >= sched_timeout) {
 			sched_debug("loop taking too long, breaking out");
+			carry_over = true;
+			break;
+		}
+		if (sched_timeout_usec &&
+		    (slurm_delta_tv(&sched_start_tv) >= sched_timeout_usec)) {
+			sched_debug("max_sched_usec reached, breaking out");
+			carry_over = true;
 			break;
 		}
 		if (sched_max_job_start && (job_cnt >= sched_max_job_start)) {
@@ -1737,6 +2071,30 @@ next_task:
 			continue;
 		}
 
+		/*
+		 * Resources only shrink during a pass, so a job identical to
+		 * one which already failed to start can not start either.
+		 */
+		class_hash = _job_sched_class_hash(job_ptr);
+		if (class_hash &&
+		    (class_ptr = _failed_class(job_ptr, class_hash,
+					       failed_class,
+					       failed_class_cnt))) {
+			if (job_ptr->state_reason != class_ptr->state_reason) {
+				job_ptr->state_reason =
+					class_ptr->state_reason;
+				xfree(job_ptr->state_desc);
+				job_ptr->state_desc =
+					xstrdup(class_ptr->state_desc);
+				last_job_update = now;
+			}
+			sched_debug3("%pJ. State=PENDING. Reason=%s. Priority=%u. Same request as %pJ.",
+				     job_ptr,
+				     job_reason_string(job_ptr->state_reason),
+				     job_ptr->priority, class_ptr);
+			continue;
+		}
+
 		last_job_sched_start = MAX(last_job_sched_start,
 					   job_ptr->start_time);
 		if (deadline_time_limit) {
@@ -1750,8 +2108,13 @@ next_task:
 			goto skip_start;
 		}
 
+		trace_id = trace_get_id();
+		trace_set_id(job_ptr->job_id);
+		span = trace_span_start();
 		error_code = select_nodes(job_ptr, false, NULL, NULL, false,
 					  SLURMDB_JOB_FLAG_SCHED);
+		trace_span_end("schedule", span);
+		trace_set_id(trace_id);
 
 		if (error_code == SLURM_SUCCESS) {
 			/*
@@ -1879,6 +2242,19 @@ skip_start:
 			       slurm_strerror(error_code));
 		}
 
+		if (class_hash && IS_JOB_PENDING(job_ptr) &&
+		    !job_ptr->preempt_in_progress &&
+		    (failed_class_cnt < MAX_FAILED_CLASS) &&
+		    ((error_code == ESLURM_NODES_BUSY) ||
+		     (error_code == ESLURM_ACCOUNTING_POLICY) ||
+		     (error_code == ESLURM_RESERVATION_BUSY) ||
+		     (error_code == ESLURM_RESERVATION_NOT_USABLE) ||
+		     (error_code == ESLURM_REQUESTED_NODE_CONFIG_UNAVAILABLE) ||
+		     (error_code == ESLURM_NODE_NOT_AVAIL))) {
+			failed_class[failed_class_cnt].hash = class_hash;
+			failed_class[failed_class_cnt++].job_ptr = job_ptr;
+		}
+
 		if (job_ptr->details && job_ptr->details->req_node_bitmap &&
 		    (bit_set_count(job_ptr->details->req_node_bitmap) >=
 		     job_ptr->details->min_nodes)) {
@@ -1948,6 +2324,7 @@ fail_this_part:	if (fail_by_part) {
 	avail_node_bitmap = save_avail_node_bitmap;
 	xfree(failed_parts);
 	xfree(failed_resv);
+	xfree(failed_class);
 	if (fifo_sched) {
 		if (job_iterator)
 			list_iterator_destroy(job_iterator);
@@ -1970,6 +2347,13 @@ fail_this_part:	if (fail_by_part) {
 
 	_do_diag_stats(DELTA_TIMER);
 
+	/*
+	 * The pass ran out of time with jobs left to test, run again soon
+	 * rather than waiting for the next event or sched_interval.
+	 */
+	if (carry_over)
+		queue_job_scheduler();
+
 out:
 #if HAVE_SYS_PRCTL_H
 	if (prctl(PR_SET_NAME, get_name, NULL, NULL, NULL) < 0) {
@@ -2203,6 +2587,7 @@ static batch_job_launch_msg_t *_build_launch_job_msg(job_record_t *job_ptr,
 		slurm_free_job_launch_msg(launch_msg_ptr);
 		job_ptr->batch_flag = 1;	/* Allow repeated requeue */
 		job_ptr->details->begin_time = time(NULL) + 120;
+		time_event_job_add(job_ptr);
 		job_complete(job_ptr->job_id, slurm_conf.slurm_user_id,
 		             true, false, 0);
 		return NULL;
@@ -2583,6 +2968,7 @@ extern void launch_job(job_record_t *job_ptr)
 		return;
 	if (launch_job_ptr->het_job_id)
 		_set_het_job_env(launch_job_ptr, launch_msg_ptr);
+	launch_job_ptr->launch_time[JOB_LAUNCH_QUEUED] = slurm_time_usec();
 
 	agent_arg_ptr = xmalloc(sizeof(agent_arg_t));
 	agent_arg_ptr->protocol_version = protocol_version;
@@ -2952,11 +3338,13 @@ extern int test_job_dependency(job_record_t *job_ptr, bool *was_changed)
 	job_record_t  *djob_ptr;
 	bool is_complete, is_completed, is_pending;
 	bool or_satisfied = false, and_failed = false, or_flag = false,
-	     has_unfulfilled = false, changed = false;
+	     has_unfulfilled = false, changed = false, cacheable = true;
 
 	if ((job_ptr->details == NULL) ||
 	    (job_ptr->details->depend_list == NULL) ||
 	    (list_count(job_ptr->details->depend_list) == 0)) {
+		if (job_ptr->details)
+			job_ptr->details->depend_cached = false;
 		job_ptr->bit_flags &= ~JOB_DEPENDENT;
 		if (was_changed)
 			*was_changed = changed;
@@ -2970,6 +3358,8 @@ extern int test_job_dependency(job_record_t *job_ptr, bool *was_changed)
 
 		remote = (dep_ptr->depend_flags & SLURM_FLAGS_REMOTE) ?
 			true : false;
+		if (remote)
+			cacheable = false;
 		/*
 		 * If the job id is for a cluster that's not in the federation
 		 * (it's likely the cluster left the federation), then set
@@ -2997,13 +3387,17 @@ extern int test_job_dependency(job_record_t *job_ptr, bool *was_changed)
 
 		/* Test local, unfulfilled dependency: */
 		has_local_depend = true;
+		if (!_depend_cacheable(dep_ptr))
+			cacheable = false;
 		dep_ptr->job_ptr = find_job_array_rec(dep_ptr->job_id,
 						      dep_ptr->array_task_id);
 		djob_ptr = dep_ptr->job_ptr;
 		if ((dep_ptr->depend_type == SLURM_DEPEND_SINGLETON) &&
 		    job_ptr->name) {
-			if (list_find_first(job_list, _find_singleton_job,
-					    job_ptr) ||
+			if (find_user_name_job(job_ptr->user_id,
+					       job_ptr->name,
+					       _find_singleton_job,
+					       job_ptr) ||
 			    !fed_mgr_is_singleton_satisfied(job_ptr,
 							    dep_ptr, true)) {
 				/* Still depends */
@@ -3095,6 +3489,24 @@ extern int test_job_dependency(job_record_t *job_ptr, bool *was_changed)
 				REMOTE_DEPEND;
 	}
 
+	/*
+	 * Until one of the jobs it depends upon changes state, the result
+	 * will be the same, so job_independent() can skip testing it again.
+	 */
+	if ((results != LOCAL_DEPEND) || !cacheable) {
+		job_ptr->details->depend_cached = false;
+	} else if (!job_ptr->details->depend_cached) {
+		depend_iter = list_iterator_create(
+			job_ptr->details->depend_list);
+		while ((dep_ptr = list_next(depend_iter))) {
+			if (dep_ptr->depend_state == DEPEND_NOT_FULFILLED)
+				_depend_rev_add(dep_ptr->job_id,
+						job_ptr->job_id);
+		}
+		list_iterator_destroy(depend_iter);
+		job_ptr->details->depend_cached = true;
+	}
+
 	if (was_changed)
 		*was_changed = changed;
 	return results;
@@ -3490,6 +3902,7 @@ extern bool update_job_dependency_list(job_record_t *job_ptr,
 	xassert(job_ptr->details);
 	xassert(job_ptr->details->depend_list);
 
+	job_ptr->details->depend_cached = false;
 	job_depend_list = job_ptr->details->depend_list;
 
 	itr = list_iterator_create(new_depend_list);
@@ -3629,6 +4042,7 @@ extern int update_job_dependency(job_record_t *job_ptr, char *new_depend)
 
 	if (job_ptr->details == NULL)
 		return EINVAL;
+	job_ptr->details->depend_cached = false;
 
 	if (select_hetero == -1) {
 		/*
@@ -4207,14 +4621,163 @@ extern int reboot_job_nodes(job_record_t *job_ptr)
 {
 	return SLURM_SUCCESS;
 }
+
+extern bool reboot_nodes_queued(void)
+{
+	return false;
+}
+
+extern void reboot_nodes_flush(void)
+{
+	return;
+}
 #else
+static void _reboot_batch_free(void *x)
+{
+	reboot_batch_t *batch = x;
+
+	FREE_NULL_BITMAP(batch->node_bitmap);
+	xfree(batch->features);
+	xfree(batch);
+}
+
+static int _reboot_batch_find(void *x, void *key)
+{
+	reboot_batch_t *batch = x;
+
+	return !xstrcmp(batch->features, key);
+}
+
+/*
+ * Queue nodes to be rebooted into features (NULL for no change) by the next
+ * reboot_nodes_flush(), together with those of other jobs started meanwhile.
+ * Takes ownership of features.
+ */
+static void _reboot_batch_add(bitstr_t *node_bitmap, char *features,
+			      uint16_t protocol_version)
+{
+	reboot_batch_t *batch;
+
+	if (!reboot_batch_list)
+		reboot_batch_list = list_create(_reboot_batch_free);
+
+	if ((batch = list_find_first(reboot_batch_list, _reboot_batch_find,
+				     features))) {
+		bit_or(batch->node_bitmap, node_bitmap);
+		batch->protocol_version = MIN(batch->protocol_version,
+					      protocol_version);
+		xfree(features);
+		return;
+	}
+
+	batch = xmalloc(sizeof(*batch));
+	batch->features = features;
+	batch->node_bitmap = bit_copy(node_bitmap);
+	batch->protocol_version = protocol_version;
+	list_append(reboot_batch_list, batch);
+}
+
+static void _reboot_batch_send(reboot_batch_t *batch, bitstr_t *node_bitmap)
+{
+	agent_arg_t *reboot_agent_args;
+	reboot_msg_t *reboot_msg;
+	char *nodes;
+
+	reboot_agent_args = xmalloc(sizeof(agent_arg_t));
+	reboot_agent_args->msg_type = REQUEST_REBOOT_NODES;
+	reboot_agent_args->retry = 0;
+	reboot_agent_args->protocol_version = batch->protocol_version;
+	reboot_agent_args->hostlist = bitmap2hostlist(node_bitmap);
+	reboot_agent_args->node_count = bit_set_count(node_bitmap);
+	reboot_msg = xmalloc(sizeof(reboot_msg_t));
+	slurm_init_reboot_msg(reboot_msg, false);
+	reboot_msg->features = xstrdup(batch->features);
+	reboot_agent_args->msg_args = reboot_msg;
+
+	nodes = bitmap2node_name(node_bitmap);
+	if (batch->features)
+		info("%s: reboot nodes %s features %s",
+		     __func__, nodes, batch->features);
+	else
+		info("%s: reboot nodes %s", __func__, nodes);
+	xfree(nodes);
+
+	agent_queue_request(reboot_agent_args);
+}
+
+extern bool reboot_nodes_queued(void)
+{
+	return (reboot_batch_list && list_count(reboot_batch_list));
+}
+
+extern void reboot_nodes_flush(void)
+{
+	static time_t wave_start = 0;
+	static int wave_cnt = 0;
+	ListIterator iter;
+	reboot_batch_t *batch;
+	bitstr_t *send_bitmap;
+	node_record_t *node_ptr;
+	time_t now = time(NULL);
+	int i, cnt;
+
+	xassert(verify_lock(NODE_LOCK, WRITE_LOCK));
+
+	if (!reboot_batch_list || !list_count(reboot_batch_list))
+		return;
+
+	/* ResumeRate is nodes per minute, also used for reboot waves */
+	if (difftime(now, wave_start) >= 60) {
+		wave_start = now;
+		wave_cnt = 0;
+	}
+
+	iter = list_iterator_create(reboot_batch_list);
+	while ((batch = list_next(iter))) {
+		cnt = bit_set_count(batch->node_bitmap);
+		if (slurm_conf.resume_rate)
+			cnt = MIN(cnt, (int) slurm_conf.resume_rate - wave_cnt);
+		if (cnt <= 0) {
+			send_bitmap = NULL;
+		} else {
+			send_bitmap = bit_pick_cnt(batch->node_bitmap, cnt);
+			bit_and_not(batch->node_bitmap, send_bitmap);
+			wave_cnt += cnt;
+		}
+
+		/*
+		 * Reboot timeouts count from when the request is sent, so
+		 * nodes held back for the next wave are not timed out.
+		 */
+		for (i = 0, node_ptr = node_record_table_ptr;
+		     i < node_record_count; i++, node_ptr++) {
+			if (!bit_test(batch->node_bitmap, i) &&
+			    (!send_bitmap || !bit_test(send_bitmap, i)))
+				continue;
+			node_ptr->boot_req_time = now;
+			node_ptr->last_response = now +
+						  slurm_conf.resume_timeout;
+		}
+
+		if (send_bitmap) {
+			_reboot_batch_send(batch, send_bitmap);
+			FREE_NULL_BITMAP(send_bitmap);
+		}
+		if (bit_ffs(batch->node_bitmap) == -1)
+			list_delete_item(iter);
+	}
+	list_iterator_destroy(iter);
+
+	if (list_count(reboot_batch_list))
+		debug("%s: %d reboot requests deferred by ResumeRate",
+		      __func__, list_count(reboot_batch_list));
+}
+
 /* NOTE: See power_job_reboot() in power_save.c for similar logic */
 extern int reboot_job_nodes(job_record_t *job_ptr)
 {
 	int rc = SLURM_SUCCESS;
 	int i, i_first, i_last;
-	agent_arg_t *reboot_agent_args = NULL;
-	reboot_msg_t *reboot_msg;
 	node_record_t *node_ptr;
 	time_t now = time(NULL);
 	bitstr_t *boot_node_bitmap = NULL, *feature_node_bitmap = NULL;
@@ -4291,66 +4854,23 @@ extern int reboot_job_nodes(job_record_t *job_ptr)
 
 	if (feature_node_bitmap) {
 		/* Reboot nodes to change KNL NUMA and/or MCDRAM mode */
-		reboot_agent_args = xmalloc(sizeof(agent_arg_t));
-		reboot_agent_args->msg_type = REQUEST_REBOOT_NODES;
-		reboot_agent_args->retry = 0;
-		reboot_agent_args->node_count = 0;
-		reboot_agent_args->protocol_version = protocol_version;
-		reboot_agent_args->hostlist = hostlist_create(NULL);
-		reboot_msg = xmalloc(sizeof(reboot_msg_t));
-		slurm_init_reboot_msg(reboot_msg, false);
-		reboot_agent_args->msg_args = reboot_msg;
-		reboot_msg->features = reboot_features;	/* Move, not copy */
-		for (i = i_first; i <= i_last; i++) {
-			if (!bit_test(feature_node_bitmap, i))
-				continue;
-			node_ptr = node_record_table_ptr + i;
-			hostlist_push_host(reboot_agent_args->hostlist,
-					   node_ptr->name);
-			reboot_agent_args->node_count++;
-		}
 		nodes = bitmap2node_name(feature_node_bitmap);
-		if (nodes) {
-			info("%s: reboot nodes %s features %s",
-			     __func__, nodes, reboot_features);
-		} else {
-			error("%s: bitmap2nodename", __func__);
-			rc = SLURM_ERROR;
-		}
+		info("%s: %pJ reboot nodes %s features %s",
+		     __func__, job_ptr, nodes, reboot_features);
 		xfree(nodes);
-		agent_queue_request(reboot_agent_args);
+		_reboot_batch_add(feature_node_bitmap, reboot_features,
+				  protocol_version);
+		reboot_features = NULL;	/* Moved */
 	}
 
 	if (boot_node_bitmap) {
 		/* Reboot nodes with no feature changes */
-		reboot_agent_args = xmalloc(sizeof(agent_arg_t));
-		reboot_agent_args->msg_type = REQUEST_REBOOT_NODES;
-		reboot_agent_args->retry = 0;
-		reboot_agent_args->node_count = 0;
-		reboot_agent_args->protocol_version = protocol_version;
-		reboot_agent_args->hostlist = hostlist_create(NULL);
-		reboot_msg = xmalloc(sizeof(reboot_msg_t));
-		slurm_init_reboot_msg(reboot_msg, false);
-		reboot_agent_args->msg_args = reboot_msg;
-		/* reboot_msg->features = NULL; */
-		for (i = i_first; i <= i_last; i++) {
-			if (!bit_test(boot_node_bitmap, i))
-				continue;
-			node_ptr = node_record_table_ptr + i;
-			hostlist_push_host(reboot_agent_args->hostlist,
-					   node_ptr->name);
-			reboot_agent_args->node_count++;
-		}
 		nodes = bitmap2node_name(boot_node_bitmap);
-		if (nodes) {
-			info("%s: reboot nodes %s", __func__, nodes);
-		} else {
-			error("%s: bitmap2nodename", __func__);
-			rc = SLURM_ERROR;
-		}
+		info("%s: %pJ reboot nodes %s", __func__, job_ptr, nodes);
 		xfree(nodes);
-		agent_queue_request(reboot_agent_args);
+		_reboot_batch_add(boot_node_bitmap, NULL, protocol_version);
 	}
+	xfree(reboot_features);
 
 	job_ptr->details->prolog_running++;
 	slurm_thread_create(&tid, _wait_boot, wait_boot_arg);
@@ -4372,8 +4892,8 @@ static void *_wait_boot(void *arg)
 	slurmctld_lock_t node_write_lock = {
 		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK, READ_LOCK };
 	node_record_t *node_ptr;
-	time_t start_time = time(NULL);
-	int i, total_node_cnt, wait_node_cnt;
+	time_t start_time = time(NULL), now;
+	int i, total_node_cnt, wait_node_cnt, late_node_cnt;
 	bool job_timeout = false;
 
 	/*
@@ -4383,7 +4903,7 @@ static void *_wait_boot(void *arg)
 
 	do {
 		sleep(5);
-		total_node_cnt = wait_node_cnt = 0;
+		total_node_cnt = wait_node_cnt = late_node_cnt = 0;
 		lock_slurmctld(job_write_lock);
 		if (!(job_ptr = find_job_record(wait_boot_arg->job_id))) {
 			error("%s: JobId=%u vanished while waiting for node boot",
@@ -4406,8 +4926,13 @@ static void *_wait_boot(void *arg)
 			if (!bit_test(boot_node_bitmap, i))
 				continue;
 			total_node_cnt++;
-			if (node_ptr->boot_time < start_time)
-				wait_node_cnt++;
+			if (node_ptr->boot_time >= start_time)
+				continue;
+			wait_node_cnt++;
+			/* Sent when its reboot_nodes_flush() wave came */
+			if (difftime(time(NULL), node_ptr->boot_req_time) >=
+			    slurm_conf.resume_timeout)
+				late_node_cnt++;
 		}
 		if (wait_node_cnt) {
 			debug("%pJ still waiting for %d of %d nodes to boot",
@@ -4416,8 +4941,9 @@ static void *_wait_boot(void *arg)
 			info("%pJ boot complete for all %d nodes",
 			     job_ptr, total_node_cnt);
 		}
-		i = (int) difftime(time(NULL), start_time);
-		if (i >= slurm_conf.resume_timeout) {
+		now = time(NULL);
+		if (late_node_cnt &&
+		    (difftime(now, start_time) >= slurm_conf.resume_timeout)) {
 			error("%pJ timeout waiting for node %d of %d boots",
 			      job_ptr, wait_node_cnt, total_node_cnt);
 			wait_node_cnt = 0;
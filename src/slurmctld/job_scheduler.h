@@ -44,16 +44,20 @@
 
 #include "src/slurmctld/slurmctld.h"
 
+/*
+ * Records are taken from a recycled pool, see job_queue_rec_alloc(). Keep
+ * the layout compact, the fields used when popping a record come first.
+ */
 typedef struct job_queue_rec {
-	uint32_t array_task_id;		/* Job array, task ID */
-	uint32_t job_id;		/* Job ID */
 	job_record_t *job_ptr;		/* Pointer to job record */
 	part_record_t *part_ptr;	/* Pointer to partition record. Each
 					 * job may have multiple partitions. */
-	uint32_t priority;		/* Job priority in THIS partition */
 	slurmctld_resv_t *resv_ptr;     /* If job didn't ask for a reservation,
 					 * this reservation is one it can run
 					 * in without requesting */
+	uint32_t priority;		/* Job priority in THIS partition */
+	uint32_t job_id;		/* Job ID */
+	uint32_t array_task_id;		/* Job array, task ID */
 } job_queue_rec_t;
 
 /* Use as return values for test_job_dependency. */
@@ -72,6 +76,18 @@ enum {
  */
 extern int build_feature_list(job_record_t *job_ptr);
 
+/*
+ * Get a zeroed job_queue_rec_t from the pool of recycled records.
+ * Release it with job_queue_rec_free(), never xfree().
+ */
+extern job_queue_rec_t *job_queue_rec_alloc(void);
+
+/* Return a job_queue_rec_t to the pool, usable as a ListDelF */
+extern void job_queue_rec_free(void *x);
+
+/* Free the pool of job_queue_rec_t */
+extern void job_queue_rec_fini(void);
+
 /*
  * Set up job_queue_rec->job_ptr to use a magnetic reservation if the
  * job_queue_rec has resv_name filled in.
@@ -89,7 +105,8 @@ extern void job_queue_rec_resv_list(job_queue_rec_t *job_queue_rec);
  * IN clear_start - if set then clear the start_time for pending jobs
  * IN backfill - true if running backfill scheduler, enforce min time limit
  * RET the job queue
- * NOTE: the caller must call list_destroy() on RET value to free memory
+ * NOTE: the caller must call list_destroy() on RET value to free memory,
+ *	 records popped from it are released with job_queue_rec_free()
  */
 extern List build_job_queue(bool clear_start, bool backfill);
 
@@ -125,6 +142,15 @@ extern void feature_list_delete(void *x);
 extern depend_spec_t *find_dependency(job_record_t *job_ptr,
 				      depend_spec_t *dep_ptr);
 
+/*
+ * A job started, ended or was purged. Jobs whose dependency on it was cached
+ * by test_job_dependency() have their dependencies tested again.
+ */
+extern void depend_notify_job(job_record_t *job_ptr);
+
+/* Free the reverse dependency index */
+extern void depend_fini(void);
+
 /*
  * Update a job's state_reason, state_desc, and dependency string based on the
  * states of its dependencies.
@@ -208,6 +234,16 @@ extern void prolog_slurmctld(job_record_t *job_ptr);
  */
 extern int reboot_job_nodes(job_record_t *job_ptr);
 
+/*
+ * Send the reboot requests queued by reboot_job_nodes() since the last call,
+ * one per set of features, at most ResumeRate nodes per minute.
+ * NOTE: Call with the node write lock held.
+ */
+extern void reboot_nodes_flush(void);
+
+/* Return true if reboot_nodes_flush() has requests to send */
+extern bool reboot_nodes_queued(void);
+
 /* If a job can run in multiple partitions, make sure that the one 
  * actually used is first in the string. Needed for job state save/restore */
 extern void rebuild_job_part_list(job_record_t *job_ptr);
@@ -48,6 +48,7 @@
 #include "src/common/list.h"
 #include "src/common/log.h"
 #include "src/common/macros.h"
+#include "src/common/xhash.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 #include "src/slurmctld/licenses.h"
@@ -55,9 +56,24 @@
 #include "src/slurmctld/slurmctld.h"
 #include "src/common/slurm_accounting_storage.h"
 
+/*
+ * License names are interned to ids which are never reused, so a job's
+ * license requests resolve to license_list records with an array index once
+ * the id has been cached in the request, rather than a search by name.
+ */
+typedef struct {
+	char *name;
+	uint32_t id;
+} license_id_t;
+
 List license_list = (List) NULL;
 time_t last_license_update = 0;
 static pthread_mutex_t license_mutex = PTHREAD_MUTEX_INITIALIZER;
+static xhash_t *license_id_map = NULL;	/* license_id_t by name */
+static uint32_t license_id_next = 1;
+static licenses_t **license_array = NULL; /* license_list records by id */
+static uint32_t license_array_size = 0;
+
 static void _pack_license(struct licenses *lic, buf_t *buffer,
 			  uint16_t protocol_version);
 
@@ -111,6 +127,84 @@ static int _license_find_rec(void *x, void *key)
 	return 1;
 }
 
+/* Fetch key from xhash_t item. Called from function ptr */
+static void _license_id_key(void *item, const char **key, uint32_t *key_len)
+{
+	license_id_t *lic_id = (license_id_t *) item;
+
+	*key = lic_id->name;
+	*key_len = strlen(lic_id->name);
+}
+
+static void _license_id_free(void *x)
+{
+	license_id_t *lic_id = (license_id_t *) x;
+
+	xfree(lic_id->name);
+	xfree(lic_id);
+}
+
+/*
+ * Index license_list by id, interning any new license names.
+ * Call after any record is added to or removed from license_list.
+ * license_mutex should be locked before calling this.
+ */
+static void _license_index_rebuild(void)
+{
+	ListIterator iter;
+	licenses_t *license_entry;
+	license_id_t *lic_id;
+
+	if (!license_id_map)
+		license_id_map = xhash_init(_license_id_key, _license_id_free);
+	if (license_array_size)
+		memset(license_array, 0,
+		       sizeof(licenses_t *) * license_array_size);
+	if (!license_list)
+		return;
+
+	iter = list_iterator_create(license_list);
+	while ((license_entry = list_next(iter))) {
+		if (!(lic_id = xhash_get_str(license_id_map,
+					     license_entry->name))) {
+			lic_id = xmalloc(sizeof(license_id_t));
+			lic_id->name = xstrdup(license_entry->name);
+			lic_id->id = license_id_next++;
+			xhash_add(license_id_map, lic_id);
+		}
+		license_entry->id = lic_id->id;
+		if (lic_id->id >= license_array_size) {
+			license_array_size = lic_id->id + 16;
+			xrecalloc(license_array, license_array_size,
+				  sizeof(licenses_t *));
+		}
+		/* Like list_find_first(), the first record of a name wins */
+		if (!license_array[lic_id->id])
+			license_array[lic_id->id] = license_entry;
+	}
+	list_iterator_destroy(iter);
+}
+
+/*
+ * Return the license_list record matching a requested license, caching its
+ * id in the request, or NULL if no such license is configured.
+ * license_mutex should be locked before calling this.
+ */
+static licenses_t *_license_find(licenses_t *license_req)
+{
+	license_id_t *lic_id;
+
+	if (!license_req->id) {
+		if (!(lic_id = xhash_get_str(license_id_map,
+					     license_req->name)))
+			return NULL;
+		license_req->id = lic_id->id;
+	}
+	if (license_req->id >= license_array_size)
+		return NULL;
+	return license_array[license_req->id];
+}
+
 /* Find a license_t record by license name (for use by list_find_first) */
 static int _license_find_remote_rec(void *x, void *key)
 {
@@ -218,6 +312,7 @@ static void _add_res_rec_2_lic_list(slurmdb_res_rec_t *rec, bool sync)
 	license_entry->remote = sync ? 2 : 1;
 
 	list_push(license_list, license_entry);
+	_license_index_rebuild();
 	last_license_update = time(NULL);
 }
 
@@ -236,6 +331,7 @@ extern int license_init(char *licenses)
 	if (!valid)
 		fatal("Invalid configured licenses: %s", licenses);
 
+	_license_index_rebuild();
 	_licenses_print("init_license", license_list, NULL);
 	slurm_mutex_unlock(&license_mutex);
 	return SLURM_SUCCESS;
@@ -257,6 +353,7 @@ extern int license_update(char *licenses)
         slurm_mutex_lock(&license_mutex);
         if (!license_list) {        /* no licenses before now */
                 license_list = new_list;
+                _license_index_rebuild();
                 slurm_mutex_unlock(&license_mutex);
                 return SLURM_SUCCESS;
         }
@@ -293,6 +390,7 @@ extern int license_update(char *licenses)
 
         FREE_NULL_LIST(license_list);
         license_list = new_list;
+        _license_index_rebuild();
         _licenses_print("update_license", license_list, NULL);
         slurm_mutex_unlock(&license_mutex);
         return SLURM_SUCCESS;
@@ -402,6 +500,7 @@ extern void license_remove_remote(slurmdb_res_rec_t *rec)
 			     "removed with %u in use",
 			     license_entry->name, license_entry->used);
 			list_delete_item(iter);
+			_license_index_rebuild();
 			last_license_update = time(NULL);
 			break;
 		}
@@ -475,6 +574,7 @@ extern void license_sync_remote(List res_list)
 			license_entry->remote = 1;
 	}
 	list_iterator_destroy(iter);
+	_license_index_rebuild();
 
 	slurm_mutex_unlock(&license_mutex);
 }
@@ -484,6 +584,9 @@ extern void license_free(void)
 {
 	slurm_mutex_lock(&license_mutex);
 	FREE_NULL_LIST(license_list);
+	xhash_free(license_id_map);
+	xfree(license_array);
+	license_array_size = 0;
 	slurm_mutex_unlock(&license_mutex);
 }
 
@@ -527,12 +630,7 @@ extern List license_validate(char *licenses, bool validate_configured,
 	_licenses_print("request_license", job_license_list, NULL);
 	iter = list_iterator_create(job_license_list);
 	while ((license_entry = list_next(iter))) {
-		if (license_list) {
-			match = list_find_first(license_list,
-						_license_find_rec,
-						license_entry->name);
-		} else
-			match = NULL;
+		match = _license_find(license_entry);
 		if (!match) {
 			debug("License name requested (%s) does not exist",
 			      license_entry->name);
@@ -603,8 +701,7 @@ extern int license_job_test(job_record_t *job_ptr, time_t when, bool reboot)
 	slurm_mutex_lock(&license_mutex);
 	iter = list_iterator_create(job_ptr->license_list);
 	while ((license_entry = list_next(iter))) {
-		match = list_find_first(license_list, _license_find_rec,
-			license_entry->name);
+		match = _license_find(license_entry);
 		if (!match) {
 			error("could not find license %s for job %u",
 			      license_entry->name, job_ptr->job_id);
@@ -657,6 +754,7 @@ extern List license_job_copy(List license_list_src)
 		license_entry_dest = xmalloc(sizeof(licenses_t));
 		license_entry_dest->name = xstrdup(license_entry_src->name);
 		license_entry_dest->total = license_entry_src->total;
+		license_entry_dest->id = license_entry_src->id;
 		list_push(license_list_dest, license_entry_dest);
 	}
 	list_iterator_destroy(iter);
@@ -682,8 +780,7 @@ extern int license_job_get(job_record_t *job_ptr)
 	slurm_mutex_lock(&license_mutex);
 	iter = list_iterator_create(job_ptr->license_list);
 	while ((license_entry = list_next(iter))) {
-		match = list_find_first(license_list, _license_find_rec,
-			license_entry->name);
+		match = _license_find(license_entry);
 		if (match) {
 			match->used += license_entry->total;
 			license_entry->used += license_entry->total;
@@ -718,8 +815,7 @@ extern int license_job_return(job_record_t *job_ptr)
 	slurm_mutex_lock(&license_mutex);
 	iter = list_iterator_create(job_ptr->license_list);
 	while ((license_entry = list_next(iter))) {
-		match = list_find_first(license_list, _license_find_rec,
-			license_entry->name);
+		match = _license_find(license_entry);
 		if (match) {
 			if (match->used >= license_entry->total)
 				match->used -= license_entry->total;
@@ -828,16 +924,11 @@ get_all_license_info(char **buffer_ptr,
 extern uint32_t get_total_license_cnt(char *name)
 {
 	uint32_t count = 0;
-	licenses_t *lic;
+	licenses_t *lic, lic_req = { .name = name };
 
 	slurm_mutex_lock(&license_mutex);
-	if (license_list) {
-		lic = list_find_first(
-			license_list, _license_find_rec, name);
-
-		if (lic)
-			count = lic->total;
-	}
+	if ((lic = _license_find(&lic_req)))
+		count = lic->total;
 	slurm_mutex_unlock(&license_mutex);
 
 	return count;
@@ -848,40 +939,19 @@ extern uint32_t get_total_license_cnt(char *name)
  */
 extern char *licenses_2_tres_str(List license_list)
 {
-	ListIterator itr;
-	slurmdb_tres_rec_t *tres_rec;
-	licenses_t *license_entry;
-	char *tres_str = NULL;
-	static bool first_run = 1;
-	static slurmdb_tres_rec_t tres_req;
+	uint64_t *tres_cnt;
+	char *tres_str;
 	assoc_mgr_lock_t locks = { .tres = READ_LOCK };
 
 	if (!license_list)
 		return NULL;
 
-	/* we only need to init this once */
-	if (first_run) {
-		first_run = 0;
-		memset(&tres_req, 0, sizeof(slurmdb_tres_rec_t));
-		tres_req.type = "license";
-	}
-
 	assoc_mgr_lock(&locks);
-	itr = list_iterator_create(license_list);
-	while ((license_entry = list_next(itr))) {
-		tres_req.name = license_entry->name;
-		if (!(tres_rec = assoc_mgr_find_tres_rec(&tres_req)))
-			continue; /* not tracked */
-
-		if (slurmdb_find_tres_count_in_string(
-			    tres_str, tres_rec->id) != INFINITE64)
-			continue; /* already handled */
-		/* New license */
-		xstrfmtcat(tres_str, "%s%u=%"PRIu64,
-			   tres_str ? "," : "",
-			   tres_rec->id, (uint64_t)license_entry->total);
-	}
-	list_iterator_destroy(itr);
+	tres_cnt = xcalloc(g_tres_count, sizeof(uint64_t));
+	license_set_job_tres_cnt(license_list, tres_cnt, true);
+	tres_str = assoc_mgr_make_tres_str_from_array(
+		tres_cnt, TRES_STR_FLAG_SIMPLE, true);
+	xfree(tres_cnt);
 	assoc_mgr_unlock(&locks);
 
 	return tres_str;
@@ -48,6 +48,8 @@ typedef struct licenses {
 	uint32_t	used;		/* used licenses */
 	uint32_t	reserved;	/* currently reserved licenses */
 	uint8_t         remote;	        /* non-zero if remote (from database) */
+	uint32_t	id;		/* interned name, zero if not resolved
+					 * yet, internal use only */
 } licenses_t;
 
 extern List license_list;
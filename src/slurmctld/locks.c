@@ -41,14 +41,45 @@
 #include <pthread.h>
 #include <string.h>
 #include <sys/types.h>
+#include <time.h>
 
+#include "src/common/xmalloc.h"
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/slurmctld.h"
 
+/* Count of distinct callers of lock_slurmctld() tracked */
+#define LOCK_CALLER_SIZE	200
+/* Histogram buckets, bucket N holds times under 10^(N+1) usec */
+#define LOCK_HIST_SIZE		8
+
+typedef struct {
+	const char *caller;
+	uint32_t count[ENTITY_COUNT];
+	uint64_t hold_max[ENTITY_COUNT];
+	uint64_t hold_time[ENTITY_COUNT];
+	uint64_t wait_max[ENTITY_COUNT];
+	uint64_t wait_time[ENTITY_COUNT];
+} lock_caller_stats_t;
+
 static pthread_mutex_t state_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static pthread_rwlock_t slurmctld_locks[ENTITY_COUNT];
 
+static pthread_mutex_t lock_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static lock_caller_stats_t lock_caller_stats[LOCK_CALLER_SIZE];
+static uint32_t lock_hold_hist[ENTITY_COUNT][LOCK_HIST_SIZE];
+static uint32_t lock_wait_hist[ENTITY_COUNT][LOCK_HIST_SIZE];
+
+/*
+ * Locks can not be nested, so one set of timers per thread is enough to
+ * carry the acquisition times from lock_slurmctld() to unlock_slurmctld().
+ */
+static __thread const char *thread_lock_caller = NULL;
+static __thread uint64_t thread_lock_acquired[ENTITY_COUNT];
+static __thread uint64_t thread_lock_wait[ENTITY_COUNT];
+/* Total lock wait since the last get_thread_lock_wait() call */
+static __thread uint64_t thread_lock_wait_total = 0;
+
 #ifndef NDEBUG
 /*
  * Used to protect against double-locking within a single thread. Calling
@@ -102,8 +133,83 @@ extern bool verify_lock(lock_datatype_t datatype, lock_level_t level)
 }
 #endif
 
+/* Monotonic time in microseconds */
+static uint64_t _lock_time_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t) ts.tv_sec * USEC_IN_SEC) + (ts.tv_nsec / 1000);
+}
+
+static int _lock_hist_inx(uint64_t usec)
+{
+	int inx;
+	uint64_t limit = 10;
+
+	for (inx = 0; inx < (LOCK_HIST_SIZE - 1); inx++, limit *= 10) {
+		if (usec < limit)
+			break;
+	}
+	return inx;
+}
+
+static void _lock_entity(lock_datatype_t datatype, lock_level_t level)
+{
+	uint64_t start;
+
+	if (level == NO_LOCK)
+		return;
+
+	start = _lock_time_usec();
+	if (level == READ_LOCK)
+		slurm_rwlock_rdlock(&slurmctld_locks[datatype]);
+	else
+		slurm_rwlock_wrlock(&slurmctld_locks[datatype]);
+	thread_lock_acquired[datatype] = _lock_time_usec();
+	thread_lock_wait[datatype] = thread_lock_acquired[datatype] - start;
+	thread_lock_wait_total += thread_lock_wait[datatype];
+}
+
+/* Record wait and hold times of the locks being released by this thread */
+static void _record_lock_stats(slurmctld_lock_t lock_levels)
+{
+	lock_level_t *levels = (lock_level_t *) &lock_levels;
+	lock_caller_stats_t *stats = NULL;
+	uint64_t hold, now = _lock_time_usec();
+
+	slurm_mutex_lock(&lock_stats_mutex);
+	for (int i = 0; i < LOCK_CALLER_SIZE; i++) {
+		if (!lock_caller_stats[i].caller)
+			lock_caller_stats[i].caller = thread_lock_caller;
+		else if (lock_caller_stats[i].caller != thread_lock_caller)
+			continue;
+		stats = &lock_caller_stats[i];
+		break;
+	}
+
+	for (int i = 0; i < ENTITY_COUNT; i++) {
+		if (levels[i] == NO_LOCK)
+			continue;
+		hold = now - thread_lock_acquired[i];
+		lock_hold_hist[i][_lock_hist_inx(hold)]++;
+		lock_wait_hist[i][_lock_hist_inx(thread_lock_wait[i])]++;
+
+		if (!stats)
+			continue;
+		stats->count[i]++;
+		stats->hold_time[i] += hold;
+		stats->hold_max[i] = MAX(stats->hold_max[i], hold);
+		stats->wait_time[i] += thread_lock_wait[i];
+		stats->wait_max[i] = MAX(stats->wait_max[i],
+					 thread_lock_wait[i]);
+	}
+	slurm_mutex_unlock(&lock_stats_mutex);
+}
+
 /* lock_slurmctld - Issue the required lock requests in a well defined order */
-extern void lock_slurmctld(slurmctld_lock_t lock_levels)
+extern void lock_slurmctld_caller(slurmctld_lock_t lock_levels,
+				  const char *caller)
 {
 	static bool init_run = false;
 	xassert(_store_locks(lock_levels));
@@ -114,30 +220,12 @@ extern void lock_slurmctld(slurmctld_lock_t lock_levels)
 			slurm_rwlock_init(&slurmctld_locks[i]);
 	}
 
-	if (lock_levels.conf == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[CONF_LOCK]);
-	else if (lock_levels.conf == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[CONF_LOCK]);
-
-	if (lock_levels.job == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[JOB_LOCK]);
-	else if (lock_levels.job == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[JOB_LOCK]);
-
-	if (lock_levels.node == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[NODE_LOCK]);
-	else if (lock_levels.node == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[NODE_LOCK]);
-
-	if (lock_levels.part == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[PART_LOCK]);
-	else if (lock_levels.part == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[PART_LOCK]);
-
-	if (lock_levels.fed == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[FED_LOCK]);
-	else if (lock_levels.fed == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[FED_LOCK]);
+	thread_lock_caller = caller;
+	_lock_entity(CONF_LOCK, lock_levels.conf);
+	_lock_entity(JOB_LOCK, lock_levels.job);
+	_lock_entity(NODE_LOCK, lock_levels.node);
+	_lock_entity(PART_LOCK, lock_levels.part);
+	_lock_entity(FED_LOCK, lock_levels.fed);
 }
 
 /* unlock_slurmctld - Issue the required unlock requests in a well
@@ -146,6 +234,8 @@ extern void unlock_slurmctld(slurmctld_lock_t lock_levels)
 {
 	xassert(_clear_locks(lock_levels));
 
+	_record_lock_stats(lock_levels);
+
 	if (lock_levels.fed)
 		slurm_rwlock_unlock(&slurmctld_locks[FED_LOCK]);
 
@@ -206,6 +296,83 @@ int report_locks_set(void)
 }
 
 
+extern void pack_lock_stats(buf_t *buffer, uint16_t protocol_version)
+{
+	uint32_t caller_cnt, entity_cnt = ENTITY_COUNT;
+	char **callers;
+	uint32_t *count;
+	uint64_t *hold_max, *hold_time, *wait_max, *wait_time;
+
+	slurm_mutex_lock(&lock_stats_mutex);
+	for (caller_cnt = 0; caller_cnt < LOCK_CALLER_SIZE; caller_cnt++) {
+		if (!lock_caller_stats[caller_cnt].caller)
+			break;
+	}
+
+	callers = xcalloc(caller_cnt + 1, sizeof(char *));
+	count = xcalloc(caller_cnt * entity_cnt + 1, sizeof(uint32_t));
+	hold_max = xcalloc(caller_cnt * entity_cnt + 1, sizeof(uint64_t));
+	hold_time = xcalloc(caller_cnt * entity_cnt + 1, sizeof(uint64_t));
+	wait_max = xcalloc(caller_cnt * entity_cnt + 1, sizeof(uint64_t));
+	wait_time = xcalloc(caller_cnt * entity_cnt + 1, sizeof(uint64_t));
+	for (int i = 0; i < caller_cnt; i++) {
+		lock_caller_stats_t *stats = &lock_caller_stats[i];
+		int offset = i * entity_cnt;
+
+		callers[i] = (char *) stats->caller;
+		memcpy(&count[offset], stats->count, sizeof(stats->count));
+		memcpy(&hold_max[offset], stats->hold_max,
+		       sizeof(stats->hold_max));
+		memcpy(&hold_time[offset], stats->hold_time,
+		       sizeof(stats->hold_time));
+		memcpy(&wait_max[offset], stats->wait_max,
+		       sizeof(stats->wait_max));
+		memcpy(&wait_time[offset], stats->wait_time,
+		       sizeof(stats->wait_time));
+	}
+
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		pack32(entity_cnt, buffer);
+		pack32(LOCK_HIST_SIZE, buffer);
+		pack32_array((uint32_t *) lock_wait_hist,
+			     entity_cnt * LOCK_HIST_SIZE, buffer);
+		pack32_array((uint32_t *) lock_hold_hist,
+			     entity_cnt * LOCK_HIST_SIZE, buffer);
+
+		packstr_array(callers, caller_cnt, buffer);
+		pack32_array(count, caller_cnt * entity_cnt, buffer);
+		pack64_array(wait_time, caller_cnt * entity_cnt, buffer);
+		pack64_array(wait_max, caller_cnt * entity_cnt, buffer);
+		pack64_array(hold_time, caller_cnt * entity_cnt, buffer);
+		pack64_array(hold_max, caller_cnt * entity_cnt, buffer);
+	}
+	slurm_mutex_unlock(&lock_stats_mutex);
+
+	xfree(callers);
+	xfree(count);
+	xfree(hold_max);
+	xfree(hold_time);
+	xfree(wait_max);
+	xfree(wait_time);
+}
+
+extern uint64_t get_thread_lock_wait(void)
+{
+	uint64_t wait = thread_lock_wait_total;
+
+	thread_lock_wait_total = 0;
+	return wait;
+}
+
+extern void reset_lock_stats(void)
+{
+	slurm_mutex_lock(&lock_stats_mutex);
+	memset(lock_caller_stats, 0, sizeof(lock_caller_stats));
+	memset(lock_hold_hist, 0, sizeof(lock_hold_hist));
+	memset(lock_wait_hist, 0, sizeof(lock_wait_hist));
+	slurm_mutex_unlock(&lock_stats_mutex);
+}
+
 /* un/lock semaphore used for saving state of slurmctld */
 extern void lock_state_files(void)
 {
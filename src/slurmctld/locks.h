@@ -93,6 +93,8 @@
 
 #include <stdbool.h>
 
+#include "src/common/pack.h"
+
 /* levels of locking required for each data structure */
 typedef enum {
 	NO_LOCK,
@@ -127,7 +129,16 @@ extern bool verify_lock(lock_datatype_t datatype, lock_level_t level);
 extern void init_locks ( void );
 
 /* lock_slurmctld - Issue the required lock requests in a well defined order */
-extern void lock_slurmctld (slurmctld_lock_t lock_levels);
+#define lock_slurmctld(lock_levels) \
+	lock_slurmctld_caller(lock_levels, __func__)
+
+/*
+ * lock_slurmctld_caller - Issue the required lock requests in a well defined
+ *	order, recording lock wait and hold times against caller
+ * IN caller - name of the calling function, must be a static string
+ */
+extern void lock_slurmctld_caller(slurmctld_lock_t lock_levels,
+				  const char *caller);
 
 /* unlock_slurmctld - Issue the required unlock requests in a well
  *	defined order */
@@ -135,6 +146,18 @@ extern void unlock_slurmctld (slurmctld_lock_t lock_levels);
 
 extern int report_locks_set(void);
 
+/* pack_lock_stats - pack lock wait and hold time statistics for sdiag */
+extern void pack_lock_stats(buf_t *buffer, uint16_t protocol_version);
+
+/*
+ * get_thread_lock_wait - return the usec this thread has spent waiting for
+ *	slurmctld locks since the previous call, and restart the count
+ */
+extern uint64_t get_thread_lock_wait(void);
+
+/* reset_lock_stats - clear lock wait and hold time statistics */
+extern void reset_lock_stats(void);
+
 /* un/lock semaphore used for saving state of slurmctld */
 extern void lock_state_files ( void );
 extern void unlock_state_files ( void );
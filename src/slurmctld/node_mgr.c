@@ -71,9 +71,11 @@
 #include "src/common/slurm_resource_info.h"
 #include "src/common/slurm_mcs.h"
 #include "src/common/xassert.h"
+#include "src/common/xhash.h"
 #include "src/common/xstring.h"
 
 #include "src/slurmctld/agent.h"
+#include "src/slurmctld/event_bus.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/ping_nodes.h"
@@ -83,6 +85,7 @@
 #include "src/slurmctld/reservation.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/slurmctld_plugstack.h"
+#include "src/slurmctld/state_replica.h"
 #include "src/slurmctld/state_save.h"
 #include "src/common/timers.h"
 #include "src/slurmctld/trigger_mgr.h"
@@ -109,6 +112,21 @@ bitstr_t *share_node_bitmap = NULL;  	/* bitmap of sharable nodes */
 bitstr_t *up_node_bitmap    = NULL;  	/* bitmap of non-down nodes */
 bitstr_t *rs_node_bitmap    = NULL; 	/* bitmap of resuming nodes */
 
+/* Nodes by owner and MCS label, see node_set_owner() and node_set_mcs() */
+typedef struct {
+	char *key;
+	uint32_t key_len;
+	bitstr_t *node_bitmap;
+	int node_cnt;
+} node_key_map_t;
+
+static bitstr_t *owner_node_bitmap = NULL;	/* nodes with an owner */
+static bitstr_t *mcs_node_bitmap = NULL;	/* nodes with a mcs_label */
+static xhash_t *owner_node_hash = NULL;		/* node_key_map_t by owner */
+static xhash_t *mcs_node_hash = NULL;		/* node_key_map_t by label */
+static node_record_t *owner_node_table = NULL;	/* table they index */
+static int owner_node_cnt = 0;
+
 static void 	_dump_node_state(node_record_t *dump_node_ptr, buf_t *buffer);
 static front_end_record_t * _front_end_reg(
 				slurm_node_registration_status_msg_t *reg_msg);
@@ -118,7 +136,8 @@ static void 	_make_node_down(node_record_t *node_ptr,
 static bool	_node_is_hidden(node_record_t *node_ptr, uid_t uid);
 static buf_t *_open_node_state_file(char **state_file);
 static void 	_pack_node(node_record_t *dump_node_ptr, buf_t *buffer,
-			   uint16_t protocol_version, uint16_t show_flags);
+			   uint16_t protocol_version, uint16_t show_flags,
+			   pack_str_dict_t *dict);
 static void	_sync_bitmaps(node_record_t *node_ptr, int job_count);
 static void	_update_config_ptr(bitstr_t *bitmap,
 				   config_record_t *config_ptr);
@@ -210,6 +229,8 @@ int dump_all_node_state ( void )
 	xfree (new_file);
 	unlock_state_files ();
 
+	if (!error_code)
+		state_replica_send("node_state", buffer);
 	free_buf (buffer);
 	END_TIMER2("dump_all_node_state");
 	return error_code;
@@ -265,6 +286,9 @@ static buf_t *_open_node_state_file(char **state_file)
 	*state_file = xstrdup(slurm_conf.state_save_location);
 	xstrcat(*state_file, "/node_state");
 
+	if ((buf = state_replica_open(*state_file)))
+		return buf;
+
 	if (!(buf = create_mmap_buf(*state_file)))
 		error("Could not open node state file %s: %m", *state_file);
 	else
@@ -605,9 +629,7 @@ extern int load_all_node_state ( bool state_only )
 			node_ptr->threads       = threads;
 			node_ptr->real_memory   = real_memory;
 			node_ptr->tmp_disk      = tmp_disk;
-			xfree(node_ptr->mcs_label);
-			node_ptr->mcs_label	= mcs_label;
-			mcs_label		= NULL; /* Nothing to free */
+			node_set_mcs(node_ptr, mcs_label);
 		}
 
 		if (node_ptr) {
@@ -656,6 +678,7 @@ extern int load_all_node_state ( bool state_only )
 		xfree(comment);
 		xfree(reason);
 		xfree(cpu_spec_list);
+		xfree(mcs_label);
 	}
 
 fini:	info("Recovered state of %d nodes", node_cnt);
@@ -690,6 +713,7 @@ unpack_error:
 	xfree(node_name);
 	xfree(comment);
 	xfree(reason);
+	xfree(mcs_label);
 	goto fini;
 }
 
@@ -741,6 +765,48 @@ static bool _node_is_hidden(node_record_t *node_ptr, uid_t uid)
 	return true;
 }
 
+/*
+ * Build a bitmap of the nodes matching a node info_filter_t. Invalid node
+ * names are ignored, unknown partitions contain no nodes.
+ * RET bitmap of nodes to pack or NULL to pack every node, free with
+ *	FREE_NULL_BITMAP()
+ */
+static bitstr_t *_build_node_filter(info_filter_t *info_filter)
+{
+	bitstr_t *filter_bitmap = NULL, *part_bitmap;
+	part_record_t *part_ptr;
+	char *tmp, *tok, *save_ptr = NULL;
+
+	if (!info_filter || (!info_filter->nodes && !info_filter->partitions))
+		return NULL;
+
+	if (info_filter->nodes) {
+		(void) node_name2bitmap(info_filter->nodes, true,
+					&filter_bitmap);
+	}
+
+	if (info_filter->partitions) {
+		part_bitmap = bit_alloc(node_record_count);
+		tmp = xstrdup(info_filter->partitions);
+		tok = strtok_r(tmp, ",", &save_ptr);
+		while (tok) {
+			if ((part_ptr = find_part_record(tok)) &&
+			    part_ptr->node_bitmap)
+				bit_or(part_bitmap, part_ptr->node_bitmap);
+			tok = strtok_r(NULL, ",", &save_ptr);
+		}
+		xfree(tmp);
+
+		if (filter_bitmap) {
+			bit_and(filter_bitmap, part_bitmap);
+			FREE_NULL_BITMAP(part_bitmap);
+		} else
+			filter_bitmap = part_bitmap;
+	}
+
+	return filter_bitmap;
+}
+
 /*
  * pack_all_node - dump all configuration and node information for all nodes
  *	in machine independent form (for network transmission)
@@ -748,6 +814,7 @@ static bool _node_is_hidden(node_record_t *node_ptr, uid_t uid)
  * OUT buffer_size - set to size of the buffer in bytes
  * IN show_flags - node filtering options
  * IN uid - uid of user making request (for partition filtering)
+ * IN info_filter - pack nodes not matching this filter as hidden, or NULL
  * IN protocol_version - slurm protocol version of client
  * global: node_record_table_ptr - pointer to global node table
  * NOTE: the caller must xfree the buffer at *buffer_ptr
@@ -755,6 +822,7 @@ static bool _node_is_hidden(node_record_t *node_ptr, uid_t uid)
  */
 extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 			   uint16_t show_flags, uid_t uid,
+			   info_filter_t *info_filter,
 			   uint16_t protocol_version)
 {
 	int inx;
@@ -762,6 +830,8 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 	buf_t *buffer;
 	time_t now = time(NULL);
 	node_record_t *node_ptr = node_record_table_ptr;
+	bitstr_t *filter_bitmap;
+	pack_str_dict_t *dict = NULL;
 	bool hidden;
 
 	xassert(verify_lock(CONF_LOCK, READ_LOCK));
@@ -770,8 +840,12 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 	buffer_ptr[0] = NULL;
 	*buffer_size = 0;
 
+	filter_bitmap = _build_node_filter(info_filter);
+
 	buffer = init_buf (BUF_SIZE*16);
 	nodes_packed = 0;
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION)
+		dict = pack_str_dict_create();
 
 	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		/* write header: count and time */
@@ -800,16 +874,18 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 			else if ((node_ptr->name == NULL) ||
 				 (node_ptr->name[0] == '\0'))
 				hidden = true;
+			else if (filter_bitmap && !bit_test(filter_bitmap, inx))
+				hidden = true;
 
 			if (hidden) {
 				char *orig_name = node_ptr->name;
 				node_ptr->name = NULL;
 				_pack_node(node_ptr, buffer, protocol_version,
-				           show_flags);
+				           show_flags, dict);
 				node_ptr->name = orig_name;
 			} else {
 				_pack_node(node_ptr, buffer, protocol_version,
-					   show_flags);
+					   show_flags, dict);
 			}
 			nodes_packed++;
 		}
@@ -825,6 +901,9 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 
 	*buffer_size = get_buf_offset (buffer);
 	buffer_ptr[0] = xfer_buf_data (buffer);
+
+	FREE_NULL_BITMAP(filter_bitmap);
+	pack_str_dict_destroy(dict);
 }
 
 /*
@@ -849,6 +928,7 @@ extern void pack_one_node (char **buffer_ptr, int *buffer_size,
 	buf_t *buffer;
 	time_t now = time(NULL);
 	node_record_t *node_ptr;
+	pack_str_dict_t *dict = NULL;
 	bool hidden;
 
 	xassert(verify_lock(CONF_LOCK, READ_LOCK));
@@ -859,6 +939,8 @@ extern void pack_one_node (char **buffer_ptr, int *buffer_size,
 
 	buffer = init_buf (BUF_SIZE);
 	nodes_packed = 0;
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION)
+		dict = pack_str_dict_create();
 
 	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		/* write header: count and time */
@@ -887,7 +969,7 @@ extern void pack_one_node (char **buffer_ptr, int *buffer_size,
 
 			if (!hidden) {
 				_pack_node(node_ptr, buffer, protocol_version,
-					   show_flags);
+					   show_flags, dict);
 				nodes_packed++;
 			}
 		}
@@ -903,6 +985,8 @@ extern void pack_one_node (char **buffer_ptr, int *buffer_size,
 
 	*buffer_size = get_buf_offset (buffer);
 	buffer_ptr[0] = xfer_buf_data (buffer);
+
+	pack_str_dict_destroy(dict);
 }
 
 /*
@@ -912,18 +996,95 @@ extern void pack_one_node (char **buffer_ptr, int *buffer_size,
  * IN/OUT buffer - buffer where data is placed, pointers automatically updated
  * IN protocol_version - slurm protocol version of client
  * IN show_flags -
+ * IN/OUT dict - string dictionary shared by all nodes of the message,
+ *	required for SLURM_21_08_PROTOCOL_VERSION and later
  * NOTE: if you make any changes here be sure to make the corresponding changes
  * 	to _unpack_node_info_members() in common/slurm_protocol_pack.c
  */
 static void _pack_node(node_record_t *dump_node_ptr, buf_t *buffer,
-		       uint16_t protocol_version, uint16_t show_flags)
+		       uint16_t protocol_version, uint16_t show_flags,
+		       pack_str_dict_t *dict)
 {
 	char *gres_drain = NULL, *gres_used = NULL;
 
 	xassert(verify_lock(CONF_LOCK, READ_LOCK));
 
 
-	if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		/*
+		 * Nodes of a rack mostly share the same strings, send each
+		 * distinct one once and refer back to it by index.
+		 */
+		packstr_dict(dump_node_ptr->name, dict, buffer);
+		packstr_dict(dump_node_ptr->node_hostname, dict, buffer);
+		packstr_dict(dump_node_ptr->comm_name, dict, buffer);
+		packstr_dict(dump_node_ptr->bcast_address, dict, buffer);
+		pack16(dump_node_ptr->port, buffer);
+		pack32(dump_node_ptr->next_state, buffer);
+		pack32(dump_node_ptr->node_state, buffer);
+		packstr_dict(dump_node_ptr->version, dict, buffer);
+
+		/* Only data from config_record used for scheduling */
+		pack16(dump_node_ptr->config_ptr->cpus, buffer);
+		pack16(dump_node_ptr->config_ptr->boards, buffer);
+		pack16(dump_node_ptr->config_ptr->tot_sockets, buffer);
+		pack16(dump_node_ptr->config_ptr->cores, buffer);
+		pack16(dump_node_ptr->config_ptr->threads, buffer);
+		pack64(dump_node_ptr->config_ptr->real_memory, buffer);
+		pack32(dump_node_ptr->config_ptr->tmp_disk, buffer);
+
+		packstr_dict(dump_node_ptr->mcs_label, dict, buffer);
+		pack32(dump_node_ptr->owner, buffer);
+		pack16(dump_node_ptr->core_spec_cnt, buffer);
+		pack32(dump_node_ptr->cpu_bind, buffer);
+		pack64(dump_node_ptr->mem_spec_limit, buffer);
+		packstr_dict(dump_node_ptr->cpu_spec_list, dict, buffer);
+
+		pack32(dump_node_ptr->cpu_load, buffer);
+		pack64(dump_node_ptr->free_mem, buffer);
+		pack32(dump_node_ptr->config_ptr->weight, buffer);
+		pack32(dump_node_ptr->reason_uid, buffer);
+
+		pack_time(dump_node_ptr->boot_time, buffer);
+		pack_time(dump_node_ptr->reason_time, buffer);
+		pack_time(dump_node_ptr->slurmd_start_time, buffer);
+
+		select_g_select_nodeinfo_pack(dump_node_ptr->select_nodeinfo,
+					      buffer, protocol_version);
+
+		packstr_dict(dump_node_ptr->arch, dict, buffer);
+		packstr_dict(dump_node_ptr->features, dict, buffer);
+		packstr_dict(dump_node_ptr->features_act, dict, buffer);
+		if (dump_node_ptr->gres)
+			packstr_dict(dump_node_ptr->gres, dict, buffer);
+		else
+			packstr_dict(dump_node_ptr->config_ptr->gres, dict,
+				     buffer);
+
+		/* Gathering GRES details is slow, so don't by default */
+		if (show_flags & SHOW_DETAIL) {
+			gres_drain =
+				gres_get_node_drain(dump_node_ptr->gres_list);
+			gres_used  =
+				gres_get_node_used(dump_node_ptr->gres_list);
+		}
+		packstr_dict(gres_drain, dict, buffer);
+		packstr_dict(gres_used, dict, buffer);
+		xfree(gres_drain);
+		xfree(gres_used);
+
+		packstr_dict(dump_node_ptr->os, dict, buffer);
+		packstr_dict(dump_node_ptr->comment, dict, buffer);
+		packstr_dict(dump_node_ptr->reason, dict, buffer);
+		acct_gather_energy_pack(dump_node_ptr->energy, buffer,
+					protocol_version);
+		ext_sensors_data_pack(dump_node_ptr->ext_sensors, buffer,
+				      protocol_version);
+		power_mgmt_data_pack(dump_node_ptr->power, buffer,
+				     protocol_version);
+
+		packstr_dict(dump_node_ptr->tres_fmt_str, dict, buffer);
+	} else if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
 		packstr(dump_node_ptr->name, buffer);
 		packstr(dump_node_ptr->node_hostname, buffer);
 		packstr(dump_node_ptr->comm_name, buffer);
@@ -1124,6 +1285,125 @@ static void _undo_reboot_asap(node_record_t *node_ptr)
 	xfree(node_ptr->reason);
 }
 
+/*
+ * Node state changes for accounting gathered while walking a list of nodes,
+ * so they go to the database as one message per range of nodes sharing the
+ * same state, reason and time instead of one per node.
+ */
+typedef struct {
+	time_t event_time;
+	hostlist_t hl;
+	uint32_t node_state;
+	char *reason;
+	uint32_t reason_uid;
+	char *tres_str;
+	bool up;
+} acct_node_event_t;
+
+static void _acct_node_event_free(void *x)
+{
+	acct_node_event_t *event = x;
+
+	FREE_NULL_HOSTLIST(event->hl);
+	xfree(event->reason);
+	xfree(event->tres_str);
+	xfree(event);
+}
+
+static int _find_acct_node_event(void *x, void *key)
+{
+	acct_node_event_t *event = x, *match = key;
+
+	if ((event->up != match->up) ||
+	    (event->event_time != match->event_time))
+		return 0;
+	if (event->up)
+		return 1;
+	if ((event->node_state != match->node_state) ||
+	    (event->reason_uid != match->reason_uid) ||
+	    xstrcmp(event->reason, match->reason) ||
+	    xstrcmp(event->tres_str, match->tres_str))
+		return 0;
+	return 1;
+}
+
+/*
+ * Queue a clusteracct_storage_g_node_up() (up == true) or
+ * clusteracct_storage_g_node_down() of node_ptr into events, sent by
+ * _acct_node_events_send(). NULL reason is the node's reason.
+ */
+static void _acct_node_event_add(List *events, node_record_t *node_ptr,
+				 bool up, time_t event_time, char *reason,
+				 uint32_t reason_uid)
+{
+	acct_node_event_t key = {
+		.event_time = event_time,
+		.node_state = node_ptr->node_state,
+		.reason = reason ? reason : node_ptr->reason,
+		.reason_uid = reason_uid,
+		.tres_str = node_ptr->tres_str,
+		.up = up,
+	};
+	acct_node_event_t *event;
+
+	if (!*events)
+		*events = list_create(_acct_node_event_free);
+
+	if (!(event = list_find_first(*events, _find_acct_node_event,
+				      &key))) {
+		event = xmalloc(sizeof(*event));
+		event->event_time = event_time;
+		event->hl = hostlist_create(NULL);
+		event->up = up;
+		if (!up) {
+			event->node_state = key.node_state;
+			event->reason = xstrdup(key.reason);
+			event->reason_uid = reason_uid;
+			event->tres_str = xstrdup(key.tres_str);
+		}
+		list_append(*events, event);
+	}
+	hostlist_push_host(event->hl, node_ptr->name);
+}
+
+static int _acct_node_event_send(void *x, void *arg)
+{
+	acct_node_event_t *event = x;
+	node_record_t node_rec;
+	int *rc = arg;
+
+	memset(&node_rec, 0, sizeof(node_rec));
+	node_rec.name = hostlist_ranged_string_xmalloc(event->hl);
+	node_rec.node_state = event->node_state;
+	node_rec.reason = event->reason;
+	node_rec.reason_uid = event->reason_uid;
+	node_rec.tres_str = event->tres_str;
+
+	if (event->up)
+		*rc = clusteracct_storage_g_node_up(acct_db_conn, &node_rec,
+						    event->event_time);
+	else
+		*rc = clusteracct_storage_g_node_down(acct_db_conn, &node_rec,
+						      event->event_time,
+						      event->reason,
+						      event->reason_uid);
+	xfree(node_rec.name);
+
+	return (*rc == SLURM_ERROR) ? -1 : 0;
+}
+
+/* Send and free the events queued by _acct_node_event_add() */
+static int _acct_node_events_send(List *events)
+{
+	int rc = SLURM_SUCCESS;
+
+	if (*events)
+		list_for_each(*events, _acct_node_event_send, &rc);
+	FREE_NULL_LIST(*events);
+
+	return rc;
+}
+
 /*
  * update_node - update the configuration data for one or more nodes
  * IN update_node_msg - update node request
@@ -1138,6 +1418,7 @@ int update_node ( update_node_msg_t * update_node_msg )
 	hostlist_t host_list, hostaddr_list = NULL, hostname_list = NULL;
 	uint32_t base_state = 0, node_flags, state_val;
 	time_t now = time(NULL);
+	List acct_events = NULL;
 
 	if (update_node_msg->node_names == NULL ) {
 		info("%s: invalid node name", __func__);
@@ -1353,10 +1634,9 @@ int update_node ( update_node_msg_t * update_node_msg )
 				if (IS_NODE_IDLE(node_ptr) &&
 				    (IS_NODE_DRAIN(node_ptr) ||
 				     IS_NODE_FAIL(node_ptr))) {
-					clusteracct_storage_g_node_up(
-						acct_db_conn,
-						node_ptr,
-						now);
+					_acct_node_event_add(&acct_events,
+							     node_ptr, true,
+							     now, NULL, 0);
 					acct_updated = true;
 				}
 				node_ptr->node_state &= (~NODE_STATE_DRAIN);
@@ -1419,10 +1699,9 @@ int update_node ( update_node_msg_t * update_node_msg )
 			} else if (state_val == NODE_STATE_UNDRAIN) {
 				if (IS_NODE_IDLE(node_ptr) &&
 				    IS_NODE_DRAIN(node_ptr)) {
-					clusteracct_storage_g_node_up(
-						acct_db_conn,
-						node_ptr,
-						now);
+					_acct_node_event_add(&acct_events,
+							     node_ptr, true,
+							     now, NULL, 0);
 					acct_updated = true;
 				}
 				node_ptr->node_state &= (~NODE_STATE_DRAIN);
@@ -1455,18 +1734,16 @@ int update_node ( update_node_msg_t * update_node_msg )
 				 * FAIL flags too */
 				if (IS_NODE_DOWN(node_ptr)) {
 					trigger_node_up(node_ptr);
-					clusteracct_storage_g_node_up(
-						acct_db_conn,
-						node_ptr,
-						now);
+					_acct_node_event_add(&acct_events,
+							     node_ptr, true,
+							     now, NULL, 0);
 					acct_updated = true;
 				} else if (IS_NODE_IDLE(node_ptr)   &&
 					   (IS_NODE_DRAIN(node_ptr) ||
 					    IS_NODE_FAIL(node_ptr))) {
-					clusteracct_storage_g_node_up(
-						acct_db_conn,
-						node_ptr,
-						now);
+					_acct_node_event_add(&acct_events,
+							     node_ptr, true,
+							     now, NULL, 0);
 					acct_updated = true;
 				}	/* else already fully available */
 				node_ptr->node_state &= (~NODE_STATE_DRAIN);
@@ -1506,9 +1783,9 @@ int update_node ( update_node_msg_t * update_node_msg )
 				if ((node_ptr->run_job_cnt  == 0) &&
 				    (node_ptr->comp_job_cnt == 0)) {
 					trigger_node_drained(node_ptr);
-					clusteracct_storage_g_node_down(
-						acct_db_conn,
-						node_ptr, now, NULL,
+					_acct_node_event_add(
+						&acct_events, node_ptr, false,
+						now, NULL,
 						node_ptr->reason_uid);
 				}
 				if ((new_state == NODE_STATE_FAIL) &&
@@ -1614,6 +1891,8 @@ int update_node ( update_node_msg_t * update_node_msg )
 				info ("update_node: node %s state set to %s",
 					this_node_name,
 					node_state_string(state_val));
+				event_bus_node(node_ptr,
+					       CTLD_EVENT_NODE_UPDATE);
 			}
 		}
 
@@ -1622,12 +1901,13 @@ int update_node ( update_node_msg_t * update_node_msg )
 			/* reason information is handled in
 			   clusteracct_storage_g_node_up()
 			*/
-			clusteracct_storage_g_node_up(
-				acct_db_conn, node_ptr, now);
+			_acct_node_event_add(&acct_events, node_ptr, true,
+					     now, NULL, 0);
 		}
 
 		free (this_node_name);
 	}
+	(void) _acct_node_events_send(&acct_events);
 
 	/* Write/clear log */
 	(void)_update_node_active_features(NULL, NULL, FEATURE_MODE_PEND);
@@ -2130,6 +2410,7 @@ extern int drain_nodes(char *nodes, char *reason, uint32_t reason_uid)
 	char  *this_node_name ;
 	hostlist_t host_list;
 	time_t now = time(NULL);
+	List acct_events = NULL;
 
 	if ((nodes == NULL) || (nodes[0] == '\0')) {
 		error ("drain_nodes: invalid node name  %s", nodes);
@@ -2159,6 +2440,7 @@ extern int drain_nodes(char *nodes, char *reason, uint32_t reason_uid)
 		}
 
 		node_ptr->node_state |= NODE_STATE_DRAIN;
+		event_bus_node(node_ptr, CTLD_EVENT_NODE_DRAIN);
 		bit_clear (avail_node_bitmap, node_inx);
 		info ("drain_nodes: node %s state set to DRAIN",
 			this_node_name);
@@ -2173,13 +2455,13 @@ extern int drain_nodes(char *nodes, char *reason, uint32_t reason_uid)
 		    (node_ptr->comp_job_cnt == 0)) {
 			/* no jobs, node is drained */
 			trigger_node_drained(node_ptr);
-			clusteracct_storage_g_node_down(acct_db_conn,
-							node_ptr, now, NULL,
-							reason_uid);
+			_acct_node_event_add(&acct_events, node_ptr, false,
+					     now, NULL, reason_uid);
 		}
 
 		free (this_node_name);
 	}
+	(void) _acct_node_events_send(&acct_events);
 	last_node_update = time (NULL);
 
 	hostlist_destroy (host_list);
@@ -2384,7 +2666,11 @@ extern int validate_node_specs(slurm_msg_t *slurm_msg, bool *newly_up)
 	if (waiting_for_node_boot(node_ptr) ||
 	    waiting_for_node_power_down(node_ptr))
 		return SLURM_SUCCESS;
-	bit_clear(booting_node_bitmap, node_inx);
+	if (bit_test(booting_node_bitmap, node_inx)) {
+		bit_clear(booting_node_bitmap, node_inx);
+		/* Launch batch jobs waiting on this node without delay */
+		agent_nodes_ready();
+	}
 
 	if (cr_flag == NO_VAL) {
 		cr_flag = 0;  /* call is no-op for select/linear and others */
@@ -2715,6 +3001,7 @@ extern int validate_node_specs(slurm_msg_t *slurm_msg, bool *newly_up)
 			info("node %s returned to service",
 			     reg_msg->node_name);
 			trigger_node_up(node_ptr);
+			event_bus_node(node_ptr, CTLD_EVENT_NODE_UP);
 			last_node_update = now;
 			if (!IS_NODE_DRAIN(node_ptr)
 			    && !IS_NODE_DOWN(node_ptr)
@@ -2776,8 +3063,8 @@ extern int validate_node_specs(slurm_msg_t *slurm_msg, bool *newly_up)
 			last_node_update = now;
 		}
 		if (IS_NODE_IDLE(node_ptr)) {
-			node_ptr->owner = NO_VAL;
-			xfree(node_ptr->mcs_label);
+			node_set_owner(node_ptr, NO_VAL);
+			node_set_mcs(node_ptr, NULL);
 		}
 
 		select_g_update_node_config(node_inx);
@@ -3140,8 +3427,8 @@ extern int validate_nodes_via_front_end(
 				      node_ptr->name, reg_msg->job_count);
 			}
 			if (IS_NODE_IDLE(node_ptr)) {
-				node_ptr->owner = NO_VAL;
-				xfree(node_ptr->mcs_label);
+				node_set_owner(node_ptr, NO_VAL);
+				node_set_mcs(node_ptr, NULL);
 			}
 
 			select_g_update_node_config(i);
@@ -3278,6 +3565,7 @@ static void _node_did_resp(node_record_t *node_ptr)
 		info("node_did_resp: node %s returned to service",
 		     node_ptr->name);
 		trigger_node_up(node_ptr);
+		event_bus_node(node_ptr, CTLD_EVENT_NODE_UP);
 		last_node_update = now;
 		if (!IS_NODE_DRAIN(node_ptr) && !IS_NODE_FAIL(node_ptr)) {
 			/* reason information is handled in
@@ -3677,6 +3965,183 @@ void push_reconfig_to_slurmd(void)
 }
 
 
+static void _node_key_map_id(void *item, const char **key, uint32_t *key_len)
+{
+	node_key_map_t *map = item;
+
+	*key = map->key;
+	*key_len = map->key_len;
+}
+
+static void _node_key_map_free(void *item)
+{
+	node_key_map_t *map = item;
+
+	xfree(map->key);
+	FREE_NULL_BITMAP(map->node_bitmap);
+	xfree(map);
+}
+
+static void _node_key_map_set(xhash_t *hash, const char *key,
+			      uint32_t key_len, int inx)
+{
+	node_key_map_t *map;
+
+	if (!(map = xhash_get(hash, key, key_len))) {
+		map = xmalloc(sizeof(*map));
+		map->key = xmalloc(key_len);
+		memcpy(map->key, key, key_len);
+		map->key_len = key_len;
+		map->node_bitmap = bit_alloc(node_record_count);
+		xhash_add(hash, map);
+	}
+	if (!bit_test(map->node_bitmap, inx)) {
+		bit_set(map->node_bitmap, inx);
+		map->node_cnt++;
+	}
+}
+
+static void _node_key_map_clear(xhash_t *hash, const char *key,
+				uint32_t key_len, int inx)
+{
+	node_key_map_t *map;
+
+	if (!(map = xhash_get(hash, key, key_len)) ||
+	    !bit_test(map->node_bitmap, inx))
+		return;
+	bit_clear(map->node_bitmap, inx);
+	if (--map->node_cnt == 0)
+		xhash_delete(hash, key, key_len);
+}
+
+/* Build the owner and MCS label node maps again if the table changed */
+static void _node_owner_sync(void)
+{
+	node_record_t *node_ptr;
+	int i;
+
+	if (owner_node_bitmap && (owner_node_table == node_record_table_ptr) &&
+	    (owner_node_cnt == node_record_count))
+		return;
+
+	node_owner_fini();
+	owner_node_table = node_record_table_ptr;
+	owner_node_cnt = node_record_count;
+	owner_node_bitmap = bit_alloc(node_record_count);
+	mcs_node_bitmap = bit_alloc(node_record_count);
+	owner_node_hash = xhash_init(_node_key_map_id, _node_key_map_free);
+	mcs_node_hash = xhash_init(_node_key_map_id, _node_key_map_free);
+
+	for (i = 0, node_ptr = node_record_table_ptr; i < node_record_count;
+	     i++, node_ptr++) {
+		if (node_ptr->owner != NO_VAL) {
+			bit_set(owner_node_bitmap, i);
+			_node_key_map_set(owner_node_hash,
+					  (char *) &node_ptr->owner,
+					  sizeof(uint32_t), i);
+		}
+		if (node_ptr->mcs_label) {
+			bit_set(mcs_node_bitmap, i);
+			_node_key_map_set(mcs_node_hash, node_ptr->mcs_label,
+					  strlen(node_ptr->mcs_label), i);
+		}
+	}
+}
+
+extern void node_set_owner(node_record_t *node_ptr, uint32_t owner)
+{
+	int inx = node_ptr - node_record_table_ptr;
+
+	if (node_ptr->owner == owner)
+		return;
+
+	_node_owner_sync();
+	if (node_ptr->owner != NO_VAL) {
+		bit_clear(owner_node_bitmap, inx);
+		_node_key_map_clear(owner_node_hash, (char *) &node_ptr->owner,
+				    sizeof(uint32_t), inx);
+	}
+	node_ptr->owner = owner;
+	if (owner != NO_VAL) {
+		bit_set(owner_node_bitmap, inx);
+		_node_key_map_set(owner_node_hash, (char *) &owner,
+				  sizeof(uint32_t), inx);
+	}
+}
+
+extern void node_set_mcs(node_record_t *node_ptr, char *mcs_label)
+{
+	int inx = node_ptr - node_record_table_ptr;
+
+	if (!xstrcmp(node_ptr->mcs_label, mcs_label))
+		return;
+
+	_node_owner_sync();
+	if (node_ptr->mcs_label) {
+		bit_clear(mcs_node_bitmap, inx);
+		_node_key_map_clear(mcs_node_hash, node_ptr->mcs_label,
+				    strlen(node_ptr->mcs_label), inx);
+		xfree(node_ptr->mcs_label);
+	}
+	if (mcs_label) {
+		node_ptr->mcs_label = xstrdup(mcs_label);
+		bit_set(mcs_node_bitmap, inx);
+		_node_key_map_set(mcs_node_hash, mcs_label, strlen(mcs_label),
+				  inx);
+	}
+}
+
+/* Remove from mask the nodes in set_bitmap other than those in key_bitmap */
+static void _node_key_filter(bitstr_t *set_bitmap, xhash_t *hash,
+			     const char *key, uint32_t key_len, bitstr_t *mask)
+{
+	node_key_map_t *map = NULL;
+	bitstr_t *other_bitmap;
+
+	if (bit_ffs(set_bitmap) == -1)
+		return;
+	if (key)
+		map = xhash_get(hash, key, key_len);
+	if (!map) {
+		bit_and_not(mask, set_bitmap);
+		return;
+	}
+	other_bitmap = bit_copy(set_bitmap);
+	bit_and_not(other_bitmap, map->node_bitmap);
+	bit_and_not(mask, other_bitmap);
+	FREE_NULL_BITMAP(other_bitmap);
+}
+
+extern void node_owner_filter(uint32_t uid, bitstr_t *mask)
+{
+	_node_owner_sync();
+	_node_key_filter(owner_node_bitmap, owner_node_hash, (char *) &uid,
+			 sizeof(uint32_t), mask);
+}
+
+extern void node_mcs_filter(char *mcs_label, bitstr_t *mask)
+{
+	_node_owner_sync();
+	_node_key_filter(mcs_node_bitmap, mcs_node_hash, mcs_label,
+			 mcs_label ? strlen(mcs_label) : 0, mask);
+}
+
+extern bitstr_t *node_mcs_bitmap(void)
+{
+	_node_owner_sync();
+	return mcs_node_bitmap;
+}
+
+extern void node_owner_fini(void)
+{
+	FREE_NULL_BITMAP(owner_node_bitmap);
+	FREE_NULL_BITMAP(mcs_node_bitmap);
+	xhash_free_ptr(&owner_node_hash);
+	xhash_free_ptr(&mcs_node_hash);
+	owner_node_table = NULL;
+	owner_node_cnt = 0;
+}
+
 /*
  * make_node_alloc - flag specified node as allocated to a job
  * IN node_ptr - pointer to node being allocated
@@ -3699,13 +4164,11 @@ extern void make_node_alloc(node_record_t *node_ptr, job_record_t *job_ptr)
 	    (job_ptr->part_ptr &&
 	     (job_ptr->part_ptr->flags & PART_FLAG_EXCLUSIVE_USER))) {
 		node_ptr->owner_job_cnt++;
-		node_ptr->owner = job_ptr->user_id;
+		node_set_owner(node_ptr, job_ptr->user_id);
 	}
 
-	if (slurm_mcs_get_select(job_ptr) == 1) {
-		xfree(node_ptr->mcs_label);
-		node_ptr->mcs_label = xstrdup(job_ptr->mcs_label);
-	}
+	if (slurm_mcs_get_select(job_ptr) == 1)
+		node_set_mcs(node_ptr, job_ptr->mcs_label);
 
 	node_flags = node_ptr->node_state & NODE_STATE_FLAGS;
 	node_ptr->node_state = NODE_STATE_ALLOCATED | node_flags;
@@ -3810,14 +4273,15 @@ static void _make_node_down(node_record_t *node_ptr, time_t event_time)
 	node_flags = node_ptr->node_state & NODE_STATE_FLAGS;
 	node_flags &= (~NODE_STATE_COMPLETING);
 	node_ptr->node_state = NODE_STATE_DOWN | node_flags;
-	node_ptr->owner = NO_VAL;
-	xfree(node_ptr->mcs_label);
+	node_set_owner(node_ptr, NO_VAL);
+	node_set_mcs(node_ptr, NULL);
 	bit_clear (avail_node_bitmap, inx);
 	bit_clear (cg_node_bitmap,    inx);
 	bit_set   (idle_node_bitmap,  inx);
 	bit_set   (share_node_bitmap, inx);
 	bit_clear (up_node_bitmap,    inx);
 	trigger_node_down(node_ptr);
+	event_bus_node(node_ptr, CTLD_EVENT_NODE_DOWN);
 	last_node_update = time (NULL);
 	clusteracct_storage_g_node_down(acct_db_conn,
 					node_ptr, event_time, NULL,
@@ -3911,8 +4375,8 @@ void make_node_idle(node_record_t *node_ptr, job_record_t *job_ptr)
 		node_ptr->node_state &= (~NODE_STATE_COMPLETING);
 		bit_clear(cg_node_bitmap, inx);
 		if (IS_NODE_IDLE(node_ptr)) {
-			node_ptr->owner = NO_VAL;
-			xfree(node_ptr->mcs_label);
+			node_set_owner(node_ptr, NO_VAL);
+			node_set_mcs(node_ptr, NULL);
 		}
 	}
 
@@ -3968,8 +4432,8 @@ fini:
 			error("%s: node_ptr->owner_job_cnt underflow",
 			      __func__);
 		} else if (--node_ptr->owner_job_cnt == 0) {
-			node_ptr->owner = NO_VAL;
-			xfree(node_ptr->mcs_label);
+			node_set_owner(node_ptr, NO_VAL);
+			node_set_mcs(node_ptr, NULL);
 		}
 	}
 	last_node_update = now;
@@ -3977,9 +4441,10 @@ fini:
 
 extern int send_nodes_to_accounting(time_t event_time)
 {
-	int rc = SLURM_SUCCESS, i = 0;
+	int rc, i = 0;
 	node_record_t *node_ptr = NULL;
 	char *reason = NULL;
+	List acct_events = NULL;
 	slurmctld_lock_t node_read_lock = {
 		READ_LOCK, NO_LOCK, READ_LOCK, WRITE_LOCK, NO_LOCK };
 
@@ -3996,14 +4461,11 @@ extern int send_nodes_to_accounting(time_t event_time)
 		if (IS_NODE_DRAIN(node_ptr) ||
 		    IS_NODE_FAIL(node_ptr) ||
 		    IS_NODE_DOWN(node_ptr))
-			rc = clusteracct_storage_g_node_down(
-				acct_db_conn,
-				node_ptr, event_time,
-				reason,
-				slurm_conf.slurm_user_id);
-		if (rc == SLURM_ERROR)
-			break;
+			_acct_node_event_add(&acct_events, node_ptr, false,
+					     event_time, reason,
+					     slurm_conf.slurm_user_id);
 	}
+	rc = _acct_node_events_send(&acct_events);
 	unlock_slurmctld(node_read_lock);
 	return rc;
 }
@@ -4023,6 +4485,7 @@ extern void node_fini (void)
 	FREE_NULL_BITMAP(share_node_bitmap);
 	FREE_NULL_BITMAP(up_node_bitmap);
 	FREE_NULL_BITMAP(rs_node_bitmap);
+	node_owner_fini();
 	node_fini2();
 }
 
@@ -4037,9 +4500,11 @@ extern void reset_node_load(char *node_name, uint32_t cpu_load)
 	node_ptr = find_node_record(node_name);
 	if (node_ptr) {
 		time_t now = time(NULL);
+		/* Don't invalidate node info on every ping with no change */
+		if (node_ptr->cpu_load != cpu_load)
+			last_node_update = now;
 		node_ptr->cpu_load = cpu_load;
 		node_ptr->cpu_load_time = now;
-		last_node_update = now;
 	} else
 		error("reset_node_load unable to find node %s", node_name);
 #endif
@@ -4056,9 +4521,10 @@ extern void reset_node_free_mem(char *node_name, uint64_t free_mem)
 	node_ptr = find_node_record(node_name);
 	if (node_ptr) {
 		time_t now = time(NULL);
+		if (node_ptr->free_mem != free_mem)
+			last_node_update = now;
 		node_ptr->free_mem = free_mem;
 		node_ptr->free_mem_time = now;
-		last_node_update = now;
 	} else
 		error("reset_node_free_mem unable to find node %s", node_name);
 #endif
@@ -64,6 +64,7 @@
 #include "src/common/slurm_mcs.h"
 #include "src/common/slurm_priority.h"
 #include "src/common/slurm_topology.h"
+#include "src/common/timers.h"
 #include "src/common/uid.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
@@ -72,6 +73,7 @@
 #include "src/slurmctld/acct_policy.h"
 #include "src/slurmctld/agent.h"
 #include "src/slurmctld/burst_buffer.h"
+#include "src/slurmctld/event_bus.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/gang.h"
 #include "src/slurmctld/gres_ctld.h"
@@ -83,6 +85,7 @@
 #include "src/slurmctld/reservation.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/slurmctld_plugstack.h"
+#include "src/slurmctld/time_event.h"
 
 #define _DEBUG	0
 #define MAX_FEATURES  64	/* max exclusive features "[fs1|fs2]"=2 */
@@ -401,6 +404,7 @@ extern void deallocate_nodes(job_record_t *job_ptr, bool timeout,
 		 * update gang scheduling table */
 		cleanup_completing(job_ptr);
 	}
+	time_event_purge_add(job_ptr);
 
 	if (agent_args->node_count == 0) {
 		if (job_ptr->details->expanding_jobid == 0) {
@@ -464,6 +468,13 @@ extern void find_feature_nodes(List feature_list, bool can_reboot)
 		return;
 	feat_iter = list_iterator_create(feature_list);
 	while ((job_feat_ptr = list_next(feat_iter))) {
+		/* Bitmaps still current from the last call */
+		if (job_feat_ptr->node_bitmap_active &&
+		    job_feat_ptr->node_bitmap_avail &&
+		    (job_feat_ptr->node_bitmap_gen == node_features_gen) &&
+		    (job_feat_ptr->node_bitmap_reboot == can_reboot))
+			continue;
+
 		FREE_NULL_BITMAP(job_feat_ptr->node_bitmap_active);
 		FREE_NULL_BITMAP(job_feat_ptr->node_bitmap_avail);
 		node_feat_ptr = list_find_first(active_feature_list,
@@ -491,6 +502,8 @@ extern void find_feature_nodes(List feature_list, bool can_reboot)
 			job_feat_ptr->node_bitmap_avail =
 				bit_copy(job_feat_ptr->node_bitmap_active);
 		}
+		job_feat_ptr->node_bitmap_gen = node_features_gen;
+		job_feat_ptr->node_bitmap_reboot = can_reboot;
 
 		_log_feature_nodes(job_feat_ptr);
 	}
@@ -769,8 +782,6 @@ extern void filter_by_node_owner(job_record_t *job_ptr,
 {
 	ListIterator job_iterator;
 	job_record_t *job_ptr2;
-	node_record_t *node_ptr;
-	int i;
 
 	if ((job_ptr->details->whole_node == WHOLE_NODE_USER) ||
 	    (job_ptr->part_ptr->flags & PART_FLAG_EXCLUSIVE_USER)) {
@@ -790,12 +801,7 @@ extern void filter_by_node_owner(job_record_t *job_ptr,
 	}
 
 	/* Need to filter out any nodes exclusively allocated to other users */
-	for (i = 0, node_ptr = node_record_table_ptr; i < node_record_count;
-	     i++, node_ptr++) {
-		if ((node_ptr->owner != NO_VAL) &&
-		    (node_ptr->owner != job_ptr->user_id))
-			bit_clear(usable_node_mask, i);
-	}
+	node_owner_filter(job_ptr->user_id, usable_node_mask);
 }
 
 /*
@@ -808,30 +814,33 @@ extern void filter_by_node_mcs(job_record_t *job_ptr, int mcs_select,
 			       bitstr_t *usable_node_mask)
 {
 	node_record_t *node_ptr;
-	int i;
+	bitstr_t *busy_bitmap;
+	int i, i_first, i_last;
 
 	/* Need to filter out any nodes allocated with other mcs */
 	if (job_ptr->mcs_label && (mcs_select == 1)) {
-		for (i = 0, node_ptr = node_record_table_ptr;
-		     i < node_record_count; i++, node_ptr++) {
-			/* if there is a mcs_label -> OK if it's the same */
-			if ((node_ptr->mcs_label != NULL) &&
-			     xstrcmp(node_ptr->mcs_label,job_ptr->mcs_label)) {
-				bit_clear(usable_node_mask, i);
-			}
-			/* if no mcs_label -> OK if no jobs running */
-			if ((node_ptr->mcs_label == NULL) &&
-			    (node_ptr->run_job_cnt != 0)) {
+		/* if there is a mcs_label -> OK if it's the same */
+		node_mcs_filter(job_ptr->mcs_label, usable_node_mask);
+
+		/*
+		 * if no mcs_label -> OK if no jobs running, only nodes which
+		 * are not idle can have any
+		 */
+		busy_bitmap = bit_copy(usable_node_mask);
+		bit_and_not(busy_bitmap, idle_node_bitmap);
+		bit_and_not(busy_bitmap, node_mcs_bitmap());
+		i_first = bit_ffs(busy_bitmap);
+		i_last = (i_first >= 0) ? bit_fls(busy_bitmap) : -2;
+		for (i = i_first; i <= i_last; i++) {
+			if (!bit_test(busy_bitmap, i))
+				continue;
+			node_ptr = node_record_table_ptr + i;
+			if (node_ptr->run_job_cnt != 0)
 				bit_clear(usable_node_mask, i);
-			}
 		}
+		FREE_NULL_BITMAP(busy_bitmap);
 	} else {
-		for (i = 0, node_ptr = node_record_table_ptr;
-		     i < node_record_count; i++, node_ptr++) {
-			 if (node_ptr->mcs_label != NULL) {
-				bit_clear(usable_node_mask, i);
-			}
-		}
+		bit_and_not(usable_node_mask, node_mcs_bitmap());
 	}
 }
 
@@ -2156,6 +2165,7 @@ static void _end_null_job(job_record_t *job_ptr)
 	/* Call job_set_alloc_tres() before acct_policy_job_begin() */
 	job_set_alloc_tres(job_ptr, false);
 	acct_policy_job_begin(job_ptr);
+	event_bus_job(job_ptr, CTLD_EVENT_JOB_START);
 	/*
 	 * If run with slurmdbd, this is handled out of band in the job if
 	 * happening right away.  If the job has already become eligible and
@@ -2564,6 +2574,8 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 	 * is for the job when we place it
 	 */
 	job_ptr->start_time = job_ptr->time_last_active = now;
+	memset(job_ptr->launch_time, 0, sizeof(job_ptr->launch_time));
+	job_ptr->launch_time[JOB_LAUNCH_ALLOC] = slurm_time_usec();
 	if ((job_ptr->limit_set.time != ADMIN_SET_LIMIT) &&
 	    ((job_ptr->time_limit == NO_VAL) ||
 	     ((job_ptr->time_limit > part_ptr->max_time) &&
@@ -2638,6 +2650,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 
 	job_ptr->job_state = JOB_RUNNING;
 	job_ptr->bit_flags |= JOB_WAS_RUNNING;
+	depend_notify_job(job_ptr);
 
 	if (select_g_select_nodeinfo_set(job_ptr) != SLURM_SUCCESS) {
 		error("select_g_select_nodeinfo_set(%pJ): %m", job_ptr);
@@ -2677,6 +2690,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 	/* job_set_alloc_tres has to be done before acct_policy_job_begin */
 	job_set_alloc_tres(job_ptr, false);
 	acct_policy_job_begin(job_ptr);
+	event_bus_job(job_ptr, CTLD_EVENT_JOB_START);
 
 	job_claim_resv(job_ptr);
 
@@ -2930,6 +2944,7 @@ extern void launch_prolog(job_record_t *job_ptr)
 		      __func__, job_ptr);
 		slurm_free_prolog_launch_msg(prolog_msg_ptr);
 		job_ptr->details->begin_time = time(NULL) + 120;
+		time_event_job_add(job_ptr);
 		job_complete(job_ptr->job_id, slurm_conf.slurm_user_id,
 		             true, false, 0);
 		return;
@@ -70,6 +70,7 @@
 #include "src/slurmctld/read_config.h"
 #include "src/slurmctld/reservation.h"
 #include "src/slurmctld/slurmctld.h"
+#include "src/slurmctld/state_replica.h"
 #include "src/slurmctld/state_save.h"
 
 /* No need to change we always pack SLURM_PROTOCOL_VERSION */
@@ -484,6 +485,8 @@ int dump_all_part_state(void)
 	xfree(new_file);
 	unlock_state_files();
 
+	if (!error_code)
+		state_replica_send("part_state", buffer);
 	free_buf(buffer);
 	END_TIMER2("dump_all_part_state");
 	return 0;
@@ -552,6 +555,8 @@ static buf_t *_open_part_state_file(char **state_file)
 
 	*state_file = xstrdup(slurm_conf.state_save_location);
 	xstrcat(*state_file, "/part_state");
+	if ((buf = state_replica_open(*state_file)))
+		return buf;
 	buf = create_mmap_buf(*state_file);
 	if (!buf) {
 		error("Could not open partition state file %s: %m",
@@ -1164,7 +1169,7 @@ void pack_part(part_record_t *part_ptr, buf_t *buffer, uint16_t protocol_version
 		packstr(part_ptr->deny_accounts, buffer);
 		packstr(part_ptr->deny_qos, buffer);
 		packstr(part_ptr->nodes, buffer);
-		pack_bit_str_hex(part_ptr->node_bitmap, buffer);
+		pack_bit_str(part_ptr->node_bitmap, buffer, protocol_version);
 		packstr(part_ptr->billing_weights_str, buffer);
 		packstr(part_ptr->tres_fmt_str, buffer);
 		(void)slurm_pack_list(part_ptr->job_defaults_list,
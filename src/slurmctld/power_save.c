@@ -97,6 +97,11 @@ uint16_t slurmd_timeout;
 static bool idle_on_node_suspend = false;
 static uint16_t power_save_interval = 10;
 static uint16_t power_save_min_interval = 0;
+static int power_save_prewarm = 0;
+
+/* Nodes requested per second by newly submitted jobs, moving average */
+static double arrival_rate = 0.0;
+static time_t last_arrival_scan = (time_t) 0;
 
 bool cloud_reg_addrs = false;
 
@@ -256,6 +261,106 @@ static int _pick_exc_nodes(void *x, void *arg)
 }
 
 /* Perform any power change work to nodes */
+/* Change state of a powered down node and add it to the nodes to resume */
+static void _wake_node(node_record_t *node_ptr, int inx, time_t now,
+		       bitstr_t **wake_node_bitmap)
+{
+	if (*wake_node_bitmap == NULL)
+		*wake_node_bitmap = bit_alloc(node_record_count);
+	resume_cnt++;
+	resume_cnt_f++;
+	node_ptr->node_state &= (~NODE_STATE_POWER_SAVE);
+	node_ptr->node_state |=   NODE_STATE_POWER_UP;
+	node_ptr->node_state |=   NODE_STATE_NO_RESPOND;
+	bit_clear(power_node_bitmap, inx);
+	node_ptr->boot_req_time = now;
+	bit_set(booting_node_bitmap, inx);
+	bit_set(resume_node_bitmap,  inx);
+	bit_set(*wake_node_bitmap,   inx);
+}
+
+/*
+ * Resume idle powered down nodes ahead of demand, so that jobs do not wait
+ * for them to boot. The demand forecast over the next ResumeTimeout is the
+ * nodes of pending jobs the backfill scheduler expects to start by then, plus
+ * the nodes new jobs are expected to request at the recent arrival rate. Idle
+ * nodes already powered up or booting count against it, and at most
+ * power_save_prewarm nodes are kept warm.
+ */
+static void _do_prewarm(time_t now, bitstr_t **wake_node_bitmap)
+{
+	ListIterator job_iterator;
+	job_record_t *job_ptr;
+	node_record_t *node_ptr;
+	bitstr_t *part_node_bitmap = NULL, *warm_node_bitmap;
+	uint32_t arrived = 0, soon = 0, node_cnt;
+	int forecast, warm_cnt, i;
+
+	job_iterator = list_iterator_create(job_list);
+	while ((job_ptr = list_next(job_iterator))) {
+		if (!IS_JOB_PENDING(job_ptr) || IS_JOB_REVOKED(job_ptr) ||
+		    !job_ptr->details || !job_ptr->part_ptr ||
+		    !job_ptr->part_ptr->node_bitmap)
+			continue;
+		node_cnt = MAX(job_ptr->details->min_nodes, 1);
+		if (last_arrival_scan &&
+		    (job_ptr->details->submit_time > last_arrival_scan))
+			arrived += node_cnt;
+		else if (!job_ptr->priority || !job_ptr->start_time ||
+			 (job_ptr->start_time > (now + resume_timeout)))
+			continue;
+		else
+			soon += node_cnt;
+
+		if (!part_node_bitmap)
+			part_node_bitmap =
+				bit_copy(job_ptr->part_ptr->node_bitmap);
+		else
+			bit_or(part_node_bitmap,
+			       job_ptr->part_ptr->node_bitmap);
+	}
+	list_iterator_destroy(job_iterator);
+
+	if (last_arrival_scan && (now > last_arrival_scan)) {
+		arrival_rate = (0.8 * arrival_rate) +
+			(0.2 * arrived / (now - last_arrival_scan));
+	}
+	last_arrival_scan = now;
+
+	if (!part_node_bitmap)
+		return;
+
+	forecast = soon + (int) ((arrival_rate * resume_timeout) + 0.5);
+	forecast = MIN(forecast, power_save_prewarm);
+
+	warm_node_bitmap = bit_copy(part_node_bitmap);
+	bit_and(warm_node_bitmap, idle_node_bitmap);
+	bit_and_not(warm_node_bitmap, power_node_bitmap);
+	warm_cnt = bit_set_count(warm_node_bitmap);
+	FREE_NULL_BITMAP(warm_node_bitmap);
+
+	if (power_save_debug && (forecast > warm_cnt)) {
+		info("power_save: prewarm forecast %d nodes (%u pending, %.2f nodes/sec arriving), %d warm",
+		     forecast, soon, arrival_rate, warm_cnt);
+	}
+
+	for (i = 0, node_ptr = node_record_table_ptr;
+	     (i < node_record_count) && (warm_cnt < forecast);
+	     i++, node_ptr++) {
+		if ((resume_rate != 0) && (resume_cnt >= resume_rate))
+			break;
+		if (!bit_test(part_node_bitmap, i) ||
+		    !IS_NODE_POWER_SAVE(node_ptr) ||
+		    IS_NODE_POWERING_DOWN(node_ptr) ||
+		    IS_NODE_ALLOCATED(node_ptr) ||
+		    IS_NODE_DOWN(node_ptr) || IS_NODE_DRAIN(node_ptr))
+			continue;
+		_wake_node(node_ptr, i, now, wake_node_bitmap);
+		warm_cnt++;
+	}
+	FREE_NULL_BITMAP(part_node_bitmap);
+}
+
 static void _do_power_work(time_t now)
 {
 	int i, wake_cnt = 0, susp_total = 0;
@@ -345,21 +450,8 @@ static void _do_power_work(time_t now)
 		    !IS_NODE_POWERING_DOWN(node_ptr) &&
 		    (IS_NODE_ALLOCATED(node_ptr) ||
 		     (node_ptr->last_idle > (now - idle_time)))) {
-			if (wake_node_bitmap == NULL) {
-				wake_node_bitmap =
-					bit_alloc(node_record_count);
-			}
 			wake_cnt++;
-			resume_cnt++;
-			resume_cnt_f++;
-			node_ptr->node_state &= (~NODE_STATE_POWER_SAVE);
-			node_ptr->node_state |=   NODE_STATE_POWER_UP;
-			node_ptr->node_state |=   NODE_STATE_NO_RESPOND;
-			bit_clear(power_node_bitmap, i);
-			node_ptr->boot_req_time = now;
-			bit_set(booting_node_bitmap, i);
-			bit_set(resume_node_bitmap,  i);
-			bit_set(wake_node_bitmap,    i);
+			_wake_node(node_ptr, i, now, &wake_node_bitmap);
 		}
 
 		/* Suspend nodes as appropriate */
@@ -462,6 +554,11 @@ static void _do_power_work(time_t now)
 		}
 	}
 	FREE_NULL_BITMAP(avoid_node_bitmap);
+
+	/* Resume nodes for jobs already allocated first */
+	if (power_save_prewarm)
+		_do_prewarm(now, &wake_node_bitmap);
+
 	if (power_save_debug && ((now - last_log) > 600) && (susp_total > 0)) {
 		info("Power save mode: %d nodes", susp_total);
 		last_log = now;
@@ -897,6 +994,15 @@ static int _init_power_config(void)
 			strtol(tmp_ptr + strlen("power_save_min_interval="),
 			       NULL, 10);
 	}
+	power_save_prewarm = 0;
+	if ((tmp_ptr = xstrcasestr(slurm_conf.slurmctld_params,
+				   "power_save_prewarm="))) {
+		power_save_prewarm =
+			strtol(tmp_ptr + strlen("power_save_prewarm="), NULL,
+			       10);
+	}
+	arrival_rate = 0.0;
+	last_arrival_scan = (time_t) 0;
 
 	if (idle_time < 0) {	/* not an error */
 		debug("power_save module disabled, SuspendTime < 0");
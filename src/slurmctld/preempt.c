@@ -162,16 +162,20 @@ static int _add_preemptable_job(void *x, void *arg)
 	if (candidate->het_job_id && !candidate->het_job_list)
 		return 0;
 
-	if (_is_job_preempt_exempt(candidate, preemptor))
-		return 0;
 	/*
 	 * We have to check the entire bitmap space here before we can check
-	 * each part of a hetjob in _is_job_preempt_exempt()
+	 * each part of a hetjob in _is_job_preempt_exempt(). This is also
+	 * the cheap test: most of job_list is pending or finished, and
+	 * _is_job_preempt_exempt() calls into the preempt plugin and takes
+	 * the assoc_mgr QOS lock for every job it looks at.
 	 */
 	if (!job_overlap_and_running(preemptor->part_ptr->node_bitmap,
 				     candidate))
 		return 0;
 
+	if (_is_job_preempt_exempt(candidate, preemptor))
+		return 0;
+
 	/* This job is a preemption candidate */
 	if (!candidates->preemptee_job_list)
 		candidates->preemptee_job_list = list_create(NULL);
@@ -80,6 +80,7 @@
 #include "src/common/slurm_protocol_interface.h"
 #include "src/common/slurm_topology.h"
 #include "src/common/switch.h"
+#include "src/common/trace.h"
 #include "src/common/uid.h"
 #include "src/common/xcgroup_read_config.h"
 #include "src/common/xstring.h"
@@ -87,6 +88,7 @@
 #include "src/slurmctld/acct_policy.h"
 #include "src/slurmctld/agent.h"
 #include "src/slurmctld/burst_buffer.h"
+#include "src/slurmctld/event_bus.h"
 #include "src/slurmctld/fed_mgr.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/gang.h"
@@ -95,8 +97,10 @@
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/power_save.h"
 #include "src/slurmctld/proc_req.h"
+#include "src/slurmctld/profiler.h"
 #include "src/slurmctld/read_config.h"
 #include "src/slurmctld/reservation.h"
+#include "src/slurmctld/rpc_queue.h"
 #include "src/slurmctld/sched_plugin.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/slurmctld_plugstack.h"
@@ -109,6 +113,12 @@ static pthread_mutex_t rpc_mutex = PTHREAD_MUTEX_INITIALIZER;
 static uint16_t rpc_type_id[RPC_TYPE_SIZE] = { 0 };
 static uint32_t rpc_type_cnt[RPC_TYPE_SIZE] = { 0 };
 static uint64_t rpc_type_time[RPC_TYPE_SIZE] = { 0 };
+static uint64_t rpc_type_auth_time[RPC_TYPE_SIZE] = { 0 };
+static uint64_t rpc_type_lock_time[RPC_TYPE_SIZE] = { 0 };
+static uint64_t rpc_type_max_time[RPC_TYPE_SIZE] = { 0 };
+/* Bucket N holds times < 2^(N+1) usec, the last one everything slower */
+#define RPC_HIST_SIZE 24
+static uint32_t rpc_type_hist[RPC_TYPE_SIZE][RPC_HIST_SIZE];
 #define RPC_USER_SIZE 200
 static uint32_t rpc_user_id[RPC_USER_SIZE] = { 0 };
 static uint32_t rpc_user_cnt[RPC_USER_SIZE] = { 0 };
@@ -122,6 +132,16 @@ static pthread_cond_t throttle_cond = PTHREAD_COND_INITIALIZER;
 static pthread_cond_t  reconfig_cond = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t reconfig_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/*
+ * Client sessions share the persistent connection thread pool with
+ * federation siblings, so cap them well below its size. Idle sessions are
+ * closed after CLIENT_SESSION_TIMEOUT seconds.
+ */
+#define CLIENT_SESSION_MAX 32
+#define CLIENT_SESSION_TIMEOUT 300
+static pthread_mutex_t client_session_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int client_session_cnt = 0;
+
 static void         _create_het_job_id_set(hostset_t jobid_hostset,
 					    uint32_t het_job_offset,
 					    char **het_job_id_set);
@@ -129,8 +149,7 @@ static void         _fill_ctld_conf(slurm_conf_t * build_ptr);
 static void         _kill_job_on_msg_fail(uint32_t job_id);
 static int          _is_prolog_finished(uint32_t job_id);
 static int          _make_step_cred(step_record_t *step_rec,
-				    slurm_cred_t **slurm_cred,
-				    uint16_t protocol_version);
+				    slurm_cred_t **slurm_cred);
 static int          _route_msg_to_origin(slurm_msg_t *msg, char *job_id_str,
 					 uint32_t job_id);
 static void         _throttle_fini(int *active_rpc_cnt);
@@ -153,8 +172,19 @@ extern diag_stats_t slurmctld_diag_stats;
 static __thread bool drop_priv = false;
 #endif
 
+static int _rpc_hist_inx(long usec)
+{
+	int inx = 0;
+
+	while ((usec >>= 1) && (inx < (RPC_HIST_SIZE - 1)))
+		inx++;
+	return inx;
+}
+
 extern void record_rpc_stats(slurm_msg_t *msg, long delta)
 {
+	uint64_t lock_wait = get_thread_lock_wait();
+
 	slurm_mutex_lock(&rpc_mutex);
 	for (int i = 0; i < RPC_TYPE_SIZE; i++) {
 		if (rpc_type_id[i] == 0)
@@ -163,6 +193,10 @@ extern void record_rpc_stats(slurm_msg_t *msg, long delta)
 			continue;
 		rpc_type_cnt[i]++;
 		rpc_type_time[i] += delta;
+		rpc_type_auth_time[i] += msg->auth_time;
+		rpc_type_lock_time[i] += lock_wait;
+		rpc_type_max_time[i] = MAX(rpc_type_max_time[i], delta);
+		rpc_type_hist[i][_rpc_hist_inx(delta)]++;
 		break;
 	}
 	for (int i = 0; i < RPC_USER_SIZE; i++) {
@@ -736,8 +770,7 @@ static void _kill_job_on_msg_fail(uint32_t job_id)
 }
 
 /* create a credential for a given job step, return error code */
-static int _make_step_cred(step_record_t *step_ptr, slurm_cred_t **slurm_cred,
-			   uint16_t protocol_version)
+static int _make_step_cred(step_record_t *step_ptr, slurm_cred_t **slurm_cred)
 {
 	slurm_cred_arg_t cred_arg;
 	job_record_t *job_ptr = step_ptr->job_ptr;
@@ -774,11 +807,14 @@ static int _make_step_cred(step_record_t *step_ptr, slurm_cred_t **slurm_cred,
 	cred_arg.sockets_per_node    = job_resrcs_ptr->sockets_per_node;
 	cred_arg.sock_core_rep_count = job_resrcs_ptr->sock_core_rep_count;
 
-	*slurm_cred = slurm_cred_create(slurmctld_config.cred_ctx, &cred_arg,
-					protocol_version);
+	/*
+	 * The credential is signed by the caller once the job write lock
+	 * is released, see _slurm_rpc_job_step_create().
+	 */
+	*slurm_cred = slurm_cred_create_unsigned(&cred_arg);
 
 	if (*slurm_cred == NULL) {
-		error("slurm_cred_create error");
+		error("slurm_cred_create_unsigned error");
 		return ESLURM_INVALID_JOB_CREDENTIAL;
 	}
 
@@ -1362,6 +1398,8 @@ static void _slurm_rpc_allocate_resources(slurm_msg_t * msg)
 			if (!job_ptr ||
 			    (error_code && job_ptr->job_state == JOB_FAILED))
 				reject_job = true;
+			else
+				trace_set_id(job_ptr->job_id);
 		}
 		END_TIMER2("_slurm_rpc_allocate_resources");
 	} else {
@@ -1505,6 +1543,7 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 			pack_all_jobs(&dump, &dump_size,
 				      job_info_request_msg->show_flags,
 				      msg->auth_uid, NO_VAL,
+				      &job_info_request_msg->filter,
 				      msg->protocol_version);
 		}
 		if (!(msg->flags & CTLD_QUEUE_PROCESSING))
@@ -1514,6 +1553,12 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 		info("_slurm_rpc_dump_jobs, size=%d %s", dump_size, TIME_STR);
 #endif
 
+		if (msg->flags & CTLD_QUEUE_PROCESSING) {
+			rpc_queue_defer_response(msg, RESPONSE_JOB_INFO, dump,
+						 dump_size);
+			return;
+		}
+
 		response_init(&response_msg, msg);
 		response_msg.msg_type = RESPONSE_JOB_INFO;
 		response_msg.data = dump;
@@ -1541,8 +1586,16 @@ static void _slurm_rpc_dump_jobs_user(slurm_msg_t * msg)
 	START_TIMER;
 	if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 		lock_slurmctld(job_read_lock);
+	if (job_info_request_msg->last_update &&
+	    ((job_info_request_msg->last_update - 1) >= last_job_update)) {
+		if (!(msg->flags & CTLD_QUEUE_PROCESSING))
+			unlock_slurmctld(job_read_lock);
+		debug3("_slurm_rpc_dump_jobs_user, no change");
+		slurm_send_rc_msg(msg, SLURM_NO_CHANGE_IN_DATA);
+		return;
+	}
 	pack_all_jobs(&dump, &dump_size, job_info_request_msg->show_flags,
-		      msg->auth_uid, job_info_request_msg->user_id,
+		      msg->auth_uid, job_info_request_msg->user_id, NULL,
 		      msg->protocol_version);
 	if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 		unlock_slurmctld(job_read_lock);
@@ -1551,6 +1604,12 @@ static void _slurm_rpc_dump_jobs_user(slurm_msg_t * msg)
 	info("_slurm_rpc_dump_user_jobs, size=%d %s", dump_size, TIME_STR);
 #endif
 
+	if (msg->flags & CTLD_QUEUE_PROCESSING) {
+		rpc_queue_defer_response(msg, RESPONSE_JOB_INFO, dump,
+					 dump_size);
+		return;
+	}
+
 	response_init(&response_msg, msg);
 	response_msg.msg_type = RESPONSE_JOB_INFO;
 	response_msg.data = dump;
@@ -1589,6 +1648,10 @@ static void _slurm_rpc_dump_job_single(slurm_msg_t * msg)
 	/* init response_msg structure */
 	if (rc != SLURM_SUCCESS) {
 		slurm_send_rc_msg(msg, rc);
+	} else if (msg->flags & CTLD_QUEUE_PROCESSING) {
+		rpc_queue_defer_response(msg, RESPONSE_JOB_INFO, dump,
+					 dump_size);
+		return;
 	} else {
 		response_init(&response_msg, msg);
 		response_msg.msg_type = RESPONSE_JOB_INFO;
@@ -1771,7 +1834,8 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 		slurm_send_rc_msg(msg, SLURM_NO_CHANGE_IN_DATA);
 	} else {
 		pack_all_node(&dump, &dump_size, node_req_msg->show_flags,
-			      msg->auth_uid, msg->protocol_version);
+			      msg->auth_uid, &node_req_msg->filter,
+			      msg->protocol_version);
 		if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 			unlock_slurmctld(node_write_lock);
 		END_TIMER2("_slurm_rpc_dump_nodes");
@@ -1890,6 +1954,9 @@ static void _slurm_rpc_dump_partitions(slurm_msg_t * msg)
 	}
 }
 
+/* Set by queued epilog completions, only used by the queue's thread */
+static bool epilog_run_scheduler = false;
+
 /* _slurm_rpc_epilog_complete - process RPC noting the completion of
  * the epilog denoting the completion of a job it its entirety */
 static void  _slurm_rpc_epilog_complete(slurm_msg_t *msg)
@@ -1946,6 +2013,9 @@ static void  _slurm_rpc_epilog_complete(slurm_msg_t *msg)
 	if (!(msg->flags & CTLD_QUEUE_PROCESSING)) {
 		unlock_slurmctld(job_write_lock);
 		_throttle_fini(&active_rpc_cnt);
+	} else if (run_scheduler) {
+		/* Scheduled once for the batch by _epilog_complete_post() */
+		epilog_run_scheduler = true;
 	}
 
 	END_TIMER2("_slurm_rpc_epilog_complete");
@@ -1969,6 +2039,20 @@ static void  _slurm_rpc_epilog_complete(slurm_msg_t *msg)
 	/* NOTE: RPC has no response */
 }
 
+/* Run once after each batch of queued epilog completions, without locks */
+static void _epilog_complete_post(void)
+{
+	if (!epilog_run_scheduler)
+		return;
+	epilog_run_scheduler = false;
+
+	/* See _slurm_rpc_epilog_complete() for defer mode */
+	if (!LOTS_OF_AGENTS && !xstrcasestr(slurm_conf.sched_params, "defer"))
+		(void) schedule(0);	/* Has own locking */
+	schedule_node_save();		/* Has own locking */
+	schedule_job_save();		/* Has own locking */
+}
+
 /* _slurm_rpc_job_step_kill - process RPC to cancel an entire job or
  * an individual job step */
 static void _slurm_rpc_job_step_kill(slurm_msg_t *msg)
@@ -2138,6 +2222,14 @@ static void _slurm_rpc_complete_batch_script(slurm_msg_t *msg)
 		return;
 	}
 
+	/* The node side launch stages are only reported on completion */
+	if (job_ptr && comp_msg->launch_time[JOB_LAUNCH_TASK] &&
+	    !job_ptr->launch_time[JOB_LAUNCH_TASK]) {
+		for (int i = JOB_LAUNCH_RECV; i < JOB_LAUNCH_STAGE_CNT; i++)
+			job_ptr->launch_time[i] = comp_msg->launch_time[i];
+		record_job_launch_stats(job_ptr);
+	}
+
 	/*
 	 * Send batch step info to accounting, only if the job is
 	 * still completing.
@@ -2383,8 +2475,7 @@ static void _slurm_rpc_job_step_create(slurm_msg_t * msg)
 				 msg->protocol_version);
 
 	if (error_code == SLURM_SUCCESS) {
-		error_code = _make_step_cred(step_rec, &slurm_cred,
-					     step_rec->start_protocol_ver);
+		error_code = _make_step_cred(step_rec, &slurm_cred);
 		ext_sensors_g_get_stepstartdata(step_rec);
 	}
 	END_TIMER2("_slurm_rpc_job_step_create");
@@ -2448,11 +2539,24 @@ static void _slurm_rpc_job_step_create(slurm_msg_t * msg)
 			unlock_slurmctld(job_write_lock);
 			_throttle_fini(&active_rpc_cnt);
 		}
-		response_init(&resp, msg);
-		resp.msg_type = RESPONSE_JOB_STEP_CREATE;
-		resp.data = &job_step_resp;
 
-		slurm_send_node_msg(msg->conn_fd, &resp);
+		/*
+		 * User lookup and signing can be slow and only touch the
+		 * credential copy, so keep them out of the job write lock.
+		 */
+		if (slurm_cred_sign(slurmctld_config.cred_ctx, slurm_cred,
+				    job_step_resp.use_protocol_ver)) {
+			error("%s: slurm_cred_sign error for JobId=%u StepId=%u",
+			      __func__, req_step_msg->step_id.job_id,
+			      job_step_resp.job_step_id);
+			slurm_send_rc_msg(msg, ESLURM_INVALID_JOB_CREDENTIAL);
+		} else {
+			response_init(&resp, msg);
+			resp.msg_type = RESPONSE_JOB_STEP_CREATE;
+			resp.data = &job_step_resp;
+
+			slurm_send_node_msg(msg->conn_fd, &resp);
+		}
 
 		slurm_cred_destroy(slurm_cred);
 		slurm_step_layout_destroy(step_layout);
@@ -2779,14 +2883,18 @@ static void _slurm_rpc_node_registration(slurm_msg_t *msg)
 		error("_slurm_rpc_node_registration node=%s: %s",
 		      node_reg_stat_msg->node_name,
 		      slurm_strerror(error_code));
-		slurm_send_rc_msg(msg, error_code);
+		if (msg->flags & CTLD_QUEUE_PROCESSING)
+			rpc_queue_defer_rc(msg, error_code);
+		else
+			slurm_send_rc_msg(msg, error_code);
 	} else {
 		debug2("_slurm_rpc_node_registration complete for %s %s",
 		       node_reg_stat_msg->node_name, TIME_STR);
 		/* If the slurmd is requesting a response send it */
 		if (node_reg_stat_msg->flags & SLURMD_REG_FLAG_RESP) {
 			slurm_node_reg_resp_msg_t *resp = NULL, tmp_resp;
-			if (msg->msg_index && msg->ret_list) {
+			if ((msg->msg_index && msg->ret_list) ||
+			    (msg->flags & CTLD_QUEUE_PROCESSING)) {
 				/*
 				 * If this is the case then the resp must be
 				 * xmalloced and will be freed when dealt with
@@ -2809,8 +2917,21 @@ static void _slurm_rpc_node_registration(slurm_msg_t *msg)
 			if (node_reg_stat_msg->dynamic)
 				resp->node_name = node_reg_stat_msg->node_name;
 
-			slurm_send_msg(msg, RESPONSE_NODE_REGISTRATION, resp);
-		} else
+			/*
+			 * Send queued responses once the queue releases its
+			 * locks rather than holding the node write lock
+			 * while waiting on each slurmd.
+			 */
+			if (msg->flags & CTLD_QUEUE_PROCESSING)
+				rpc_queue_defer_msg(msg,
+						    RESPONSE_NODE_REGISTRATION,
+						    resp);
+			else
+				slurm_send_msg(msg, RESPONSE_NODE_REGISTRATION,
+					       resp);
+		} else if (msg->flags & CTLD_QUEUE_PROCESSING)
+			rpc_queue_defer_rc(msg, SLURM_SUCCESS);
+		else
 			slurm_send_rc_msg(msg, SLURM_SUCCESS);
 	}
 }
@@ -3227,6 +3348,7 @@ static void _slurm_rpc_reconfigure_controller(slurm_msg_t * msg)
 		slurm_send_rc_msg(msg, SLURM_SUCCESS);
 		priority_g_reconfig(true);	/* notify priority plugin too */
 		save_all_state();		/* has its own locks */
+		trace_dump(slurm_conf.state_save_location, "slurmctld");
 		queue_job_scheduler();
 	}
 	slurm_mutex_unlock(&reconfig_mutex);
@@ -3614,6 +3736,7 @@ static void _slurm_rpc_submit_batch_job(slurm_msg_t *msg)
 		else {
 			job_id = job_ptr->job_id;
 			priority = job_ptr->priority;
+			trace_set_id(job_id);
 		}
 
 		if (job_desc_msg->immediate &&
@@ -3674,6 +3797,143 @@ send_msg:
 	xfree(job_submit_user_msg);
 }
 
+/*
+ * _slurm_rpc_submit_batch_jobs - process RPC to submit several independent
+ *	batch jobs, validating and creating all of them within one lock
+ *	acquisition
+ */
+static void _slurm_rpc_submit_batch_jobs(slurm_msg_t *msg)
+{
+	static int active_rpc_cnt = 0;
+	ListIterator iter;
+	DEF_TIMERS;
+	int inx;
+	bool submitted = false;
+	job_record_t *job_ptr;
+	slurm_msg_t response_msg;
+	submit_batch_jobs_response_msg_t submit_msg;
+	job_desc_msg_t *job_desc_msg;
+	/* Locks: Read config, read job, read node, read partition */
+	slurmctld_lock_t job_read_lock = {
+		READ_LOCK, READ_LOCK, READ_LOCK, READ_LOCK, READ_LOCK };
+	/* Locks: Read config, write job, write node, read partition, read
+	 * federation */
+	slurmctld_lock_t job_write_lock = {
+		READ_LOCK, WRITE_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK };
+	List job_req_list = (List) msg->data;
+	gid_t gid = auth_g_get_gid(msg->auth_cred);
+	char *err_msg = NULL;
+
+	START_TIMER;
+	if (!job_req_list || (list_count(job_req_list) == 0)) {
+		info("REQUEST_SUBMIT_BATCH_JOBS from uid=%u with empty job list",
+		     msg->auth_uid);
+		slurm_send_rc_msg(msg, SLURM_ERROR);
+		return;
+	}
+	if (slurmctld_config.submissions_disabled) {
+		info("Submissions disabled on system");
+		slurm_send_rc_msg(msg, ESLURM_SUBMISSIONS_DISABLED);
+		return;
+	}
+
+	memset(&submit_msg, 0, sizeof(submit_msg));
+	submit_msg.job_cnt = list_count(job_req_list);
+	submit_msg.error_code = xcalloc(submit_msg.job_cnt, sizeof(uint32_t));
+	submit_msg.job_id = xcalloc(submit_msg.job_cnt, sizeof(uint32_t));
+
+	/* Validate the individual requests */
+	lock_slurmctld(job_read_lock);     /* Locks for job_submit plugin use */
+	iter = list_iterator_create(job_req_list);
+	for (inx = 0; (job_desc_msg = list_next(iter)); inx++) {
+		if ((submit_msg.error_code[inx] =
+		     _valid_id("REQUEST_SUBMIT_BATCH_JOBS", job_desc_msg,
+			       msg->auth_uid, gid)))
+			continue;
+
+		_set_hostname(msg, &job_desc_msg->alloc_node);
+
+		if ((job_desc_msg->alloc_node == NULL) ||
+		    (job_desc_msg->alloc_node[0] == '\0')) {
+			error("REQUEST_SUBMIT_BATCH_JOBS lacks alloc_node from uid=%u",
+			      msg->auth_uid);
+			submit_msg.error_code[inx] = ESLURM_INVALID_NODE_NAME;
+			continue;
+		}
+
+		dump_job_desc(job_desc_msg);
+
+		job_desc_msg->het_job_offset = NO_VAL;
+		submit_msg.error_code[inx] =
+			validate_job_create_req(job_desc_msg, msg->auth_uid,
+						&err_msg);
+		xfree(err_msg);
+	}
+	list_iterator_destroy(iter);
+	unlock_slurmctld(job_read_lock);
+
+	/* Create the new jobs */
+	_throttle_start(&active_rpc_cnt);
+	lock_slurmctld(job_write_lock);
+	START_TIMER;	/* Restart after we have locks */
+	iter = list_iterator_create(job_req_list);
+	for (inx = 0; (job_desc_msg = list_next(iter)); inx++) {
+		int error_code = SLURM_SUCCESS;
+
+		if (submit_msg.error_code[inx])
+			continue;
+
+		if (fed_mgr_fed_rec) {
+			if (fed_mgr_job_allocate(msg, job_desc_msg, false,
+						 &submit_msg.job_id[inx],
+						 &error_code, &err_msg))
+				submit_msg.job_id[inx] = 0;
+		} else {
+			job_ptr = NULL;
+			job_desc_msg->het_job_offset = NO_VAL;
+			error_code = job_allocate(job_desc_msg,
+						  job_desc_msg->immediate,
+						  false, NULL, 0, msg->auth_uid,
+						  false, &job_ptr, &err_msg,
+						  msg->protocol_version);
+			if (job_ptr &&
+			    (!error_code || (job_ptr->job_state != JOB_FAILED)))
+				submit_msg.job_id[inx] = job_ptr->job_id;
+			if (job_desc_msg->immediate && error_code) {
+				error_code = ESLURM_CAN_NOT_START_IMMEDIATELY;
+				submit_msg.job_id[inx] = 0;
+			}
+		}
+		xfree(err_msg);
+
+		submit_msg.error_code[inx] = error_code;
+		if (submit_msg.job_id[inx])
+			submitted = true;
+		else if (!error_code)
+			submit_msg.error_code[inx] = SLURM_ERROR;
+	}
+	list_iterator_destroy(iter);
+	unlock_slurmctld(job_write_lock);
+	_throttle_fini(&active_rpc_cnt);
+
+	END_TIMER2("_slurm_rpc_submit_batch_jobs");
+	info("%s: %u jobs from uid=%u %s",
+	     __func__, submit_msg.job_cnt, msg->auth_uid, TIME_STR);
+
+	response_init(&response_msg, msg);
+	response_msg.msg_type = RESPONSE_SUBMIT_BATCH_JOBS;
+	response_msg.data = &submit_msg;
+	slurm_send_node_msg(msg->conn_fd, &response_msg);
+
+	if (submitted) {
+		schedule_job_save();	/* Has own locks */
+		schedule_node_save();	/* Has own locks */
+		queue_job_scheduler();
+	}
+	xfree(submit_msg.error_code);
+	xfree(submit_msg.job_id);
+}
+
 /* _slurm_rpc_submit_batch_het_job - process RPC to submit a batch hetjob */
 static void _slurm_rpc_submit_batch_het_job(slurm_msg_t *msg)
 {
@@ -4984,6 +5244,88 @@ static void _slurm_rpc_job_notify(slurm_msg_t *msg)
 	slurm_send_rc_msg(msg, error_code);
 }
 
+/*
+ * Register the sender to be pushed SRUN_JOB_COMPLETE when any of the jobs
+ * ends, so clients like "sbatch --wait" need not poll for the job state.
+ */
+static void _slurm_rpc_job_wait_notify(slurm_msg_t *msg)
+{
+	int error_code = SLURM_SUCCESS;
+	/* Locks: read job */
+	slurmctld_lock_t job_read_lock = {
+		NO_LOCK, READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK };
+	job_wait_notify_msg_t *wait_msg = msg->data;
+	job_record_t *job_ptr;
+	slurm_addr_t resp_addr;
+	int i;
+	DEF_TIMERS;
+
+	START_TIMER;
+	if (!wait_msg->job_cnt || !wait_msg->port) {
+		slurm_send_rc_msg(msg, EINVAL);
+		return;
+	}
+	if (slurm_get_peer_addr(msg->conn_fd, &resp_addr)) {
+		info("%s: from uid=%u, can't get peer addr",
+		     __func__, msg->auth_uid);
+		slurm_send_rc_msg(msg, SLURM_ERROR);
+		return;
+	}
+
+	lock_slurmctld(job_read_lock);
+	for (i = 0; i < wait_msg->job_cnt; i++) {
+		if (!(job_ptr = find_job_record(wait_msg->job_ids[i]))) {
+			error_code = ESLURM_INVALID_JOB_ID;
+			break;
+		}
+		if ((job_ptr->user_id != msg->auth_uid) &&
+		    !validate_operator(msg->auth_uid)) {
+			error_code = ESLURM_USER_ID_MISSING;
+			error("Security violation, REQUEST_JOB_WAIT_NOTIFY RPC from uid=%u for %pJ owner %u",
+			      msg->auth_uid, job_ptr, job_ptr->user_id);
+			break;
+		}
+	}
+	/* Already finished jobs are left for the client to find */
+	for (i = 0; !error_code && (i < wait_msg->job_cnt); i++) {
+		if (!test_job_array_finished(wait_msg->job_ids[i]))
+			srun_job_wait_register(wait_msg->job_ids[i], &resp_addr,
+					       wait_msg->port,
+					       msg->protocol_version);
+	}
+	unlock_slurmctld(job_read_lock);
+
+	END_TIMER2(__func__);
+	slurm_send_rc_msg(msg, error_code);
+}
+
+/*
+ * Return the events recorded after since_seq, waiting for one if there are
+ * none yet. Takes no slurmctld locks, so waiting does not hold up others.
+ */
+static void _slurm_rpc_ctld_events(slurm_msg_t *msg)
+{
+	ctld_event_req_msg_t *req = msg->data;
+	ctld_event_msg_t resp = { 0 };
+	slurm_msg_t response_msg;
+	uint32_t i;
+
+	/* Other users' job events are private like their jobs */
+	if ((slurm_conf.private_data & PRIVATE_DATA_JOBS) &&
+	    !validate_operator(msg->auth_uid))
+		req->filter.user_id = msg->auth_uid;
+
+	event_bus_get(req, &resp);
+
+	response_init(&response_msg, msg);
+	response_msg.msg_type = RESPONSE_CTLD_EVENTS;
+	response_msg.data = &resp;
+	slurm_send_node_msg(msg->conn_fd, &response_msg);
+	for (i = 0; i < resp.record_count; i++)
+		slurm_free_ctld_event_members(&resp.event_array[i]);
+	xfree(resp.event_array);
+}
+
 static void _slurm_rpc_set_debug_flags(slurm_msg_t *msg)
 {
 	slurmctld_lock_t config_write_lock =
@@ -5013,6 +5355,7 @@ static void _slurm_rpc_set_debug_flags(slurm_msg_t *msg)
 	(void) switch_g_reconfig();
 
 	unlock_slurmctld (config_write_lock);
+	profiler_reconfig();
 	flag_string = debug_flags2str(slurm_conf.debug_flags);
 	info("Set DebugFlags to %s", flag_string ? flag_string : "none");
 	xfree(flag_string);
@@ -5337,16 +5680,22 @@ static void _clear_rpc_stats(void)
 	memset(rpc_type_cnt, 0, sizeof(rpc_type_cnt));
 	memset(rpc_type_id, 0, sizeof(rpc_type_id));
 	memset(rpc_type_time, 0, sizeof(rpc_type_time));
+	memset(rpc_type_auth_time, 0, sizeof(rpc_type_auth_time));
+	memset(rpc_type_lock_time, 0, sizeof(rpc_type_lock_time));
+	memset(rpc_type_max_time, 0, sizeof(rpc_type_max_time));
+	memset(rpc_type_hist, 0, sizeof(rpc_type_hist));
 	memset(rpc_user_cnt, 0, sizeof(rpc_user_cnt));
 	memset(rpc_user_id, 0, sizeof(rpc_user_id));
 	memset(rpc_user_time, 0, sizeof(rpc_user_time));
 	slurm_mutex_unlock(&rpc_mutex);
+
+	reset_lock_stats();
 }
 
 static void _pack_rpc_stats(int resp, char **buffer_ptr, int *buffer_size,
 			    uint16_t protocol_version)
 {
-	uint32_t i;
+	uint32_t i, type_cnt;
 	buf_t *buffer;
 
 	slurm_mutex_lock(&rpc_mutex);
@@ -5358,6 +5707,7 @@ static void _pack_rpc_stats(int resp, char **buffer_ptr, int *buffer_size,
 			if (rpc_type_id[i] == 0)
 				break;
 		}
+		type_cnt = i;
 		pack32(i, buffer);
 		pack16_array(rpc_type_id,   i, buffer);
 		pack32_array(rpc_type_cnt,  i, buffer);
@@ -5374,6 +5724,16 @@ static void _pack_rpc_stats(int resp, char **buffer_ptr, int *buffer_size,
 
 		agent_pack_pending_rpc_stats(buffer);
 
+		pack_lock_stats(buffer, protocol_version);
+
+		if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+			pack64_array(rpc_type_auth_time, type_cnt, buffer);
+			pack64_array(rpc_type_lock_time, type_cnt, buffer);
+			pack64_array(rpc_type_max_time, type_cnt, buffer);
+			pack32(RPC_HIST_SIZE, buffer);
+			pack32_array(&rpc_type_hist[0][0],
+				     type_cnt * RPC_HIST_SIZE, buffer);
+		}
 	}
 
 	slurm_mutex_unlock(&rpc_mutex);
@@ -5401,6 +5761,38 @@ static void _slurm_rpc_burst_buffer_status(slurm_msg_t *msg)
 	xfree(status_resp_msg.status_resp);
 }
 
+/*
+ * _slurm_rpc_ctld_profile - return the stacks sampled with StackSample, and
+ * the allocations by call site if built with XMALLOC_PROFILE
+ */
+static void _slurm_rpc_ctld_profile(slurm_msg_t *msg)
+{
+	slurm_msg_t response_msg;
+	ctld_profile_msg_t profile_msg;
+	char *alloc;
+
+	if (!validate_operator(msg->auth_uid)) {
+		error("Security violation, REQUEST_CTLD_PROFILE RPC from uid=%u",
+		      msg->auth_uid);
+		slurm_send_rc_msg(msg, ESLURM_ACCESS_DENIED);
+		return;
+	}
+
+	response_init(&response_msg, msg);
+	response_msg.msg_type = RESPONSE_CTLD_PROFILE;
+	memset(&profile_msg, 0, sizeof(profile_msg));
+	response_msg.data = &profile_msg;
+	profile_msg.folded = profiler_dump();
+	if ((alloc = xmalloc_profile_dump())) {
+		xstrcat(profile_msg.folded, alloc);
+		xfree(alloc);
+	}
+	if (profile_msg.folded)
+		response_msg.data_size = strlen(profile_msg.folded) + 1;
+	slurm_send_node_msg(msg->conn_fd, &response_msg);
+	xfree(profile_msg.folded);
+}
+
 /* _slurm_rpc_dump_stats - process RPC for statistics information */
 static void _slurm_rpc_dump_stats(slurm_msg_t *msg)
 {
@@ -5489,6 +5881,7 @@ static void _slurm_rpc_kill_job(slurm_msg_t *msg)
 	slurmctld_lock_t lock = {READ_LOCK, WRITE_LOCK,
 				 WRITE_LOCK, NO_LOCK, READ_LOCK };
 	int cc;
+	uint32_t signaled_cnt = 0;
 
 	kill =	(job_step_kill_msg_t *)msg->data;
 
@@ -5500,6 +5893,12 @@ static void _slurm_rpc_kill_job(slurm_msg_t *msg)
 	 * the job and it will report the cancel back to the origin.
 	 */
 	lock_slurmctld(fed_job_read_lock);
+	if (fed_mgr_fed_rec && (kill->flags & KILL_JOB_LIST)) {
+		/* The jobs may have to be routed to different origins */
+		unlock_slurmctld(fed_job_read_lock);
+		slurm_send_rc_msg(msg, ESLURM_NOT_SUPPORTED);
+		return;
+	}
 	if (fed_mgr_fed_rec) {
 		uint32_t job_id, origin_id;
 		job_record_t *job_ptr;
@@ -5539,14 +5938,25 @@ static void _slurm_rpc_kill_job(slurm_msg_t *msg)
 	unlock_slurmctld(fed_job_read_lock);
 
 	START_TIMER;
-	info("%s: REQUEST_KILL_JOB JobId=%s uid %u",
-	     __func__, kill->sjob_id, msg->auth_uid);
+	if (kill->flags & KILL_JOB_LIST) {
+		info("%s: REQUEST_KILL_JOB list of jobs uid %u",
+		     __func__, msg->auth_uid);
+		debug2("%s: REQUEST_KILL_JOB JobIds=%s",
+		       __func__, kill->sjob_id);
+	} else
+		info("%s: REQUEST_KILL_JOB JobId=%s uid %u",
+		     __func__, kill->sjob_id, msg->auth_uid);
 
 	_throttle_start(&active_rpc_cnt);
 	lock_slurmctld(lock);
 	if (kill->sibling) {
 		uint32_t job_id = strtol(kill->sjob_id, NULL, 10);
 		cc = fed_mgr_remove_active_sibling(job_id, kill->sibling);
+	} else if (kill->flags & KILL_JOB_LIST) {
+		/* Signal all of the jobs under one lock */
+		cc = job_str_signal_list(kill->sjob_id, kill->signal,
+					 kill->flags & (~KILL_JOB_LIST),
+					 msg->auth_uid, &signaled_cnt);
 	} else {
 		cc = job_str_signal(kill->sjob_id, kill->signal, kill->flags,
 				    msg->auth_uid, 0);
@@ -5554,7 +5964,10 @@ static void _slurm_rpc_kill_job(slurm_msg_t *msg)
 	unlock_slurmctld(lock);
 	_throttle_fini(&active_rpc_cnt);
 
-	if (cc == ESLURM_ALREADY_DONE) {
+	if (kill->flags & KILL_JOB_LIST) {
+		/* job_str_signal_list() logged the errors of each job */
+		slurmctld_diag_stats.jobs_canceled += signaled_cnt;
+	} else if (cc == ESLURM_ALREADY_DONE) {
 		debug2("%s: job_str_signal() JobId=%s sig %d returned %s",
 		       __func__, kill->sjob_id,
 		       kill->signal, slurm_strerror(cc));
@@ -5625,12 +6038,57 @@ static int _process_persist_conn(void *arg,
 
 	msg.msg_type = persist_msg->msg_type;
 	msg.data = persist_msg->data;
+	msg.protocol_version = persist_conn->version;
+
+	if ((persist_conn->persist_type == PERSIST_TYPE_CLIENT) &&
+	    !slurm_ctld_session_rpc(msg.msg_type)) {
+		error("%s: %s is not allowed on a client session from uid=%u",
+		      __func__, rpc_num2string(msg.msg_type), *uid);
+		slurm_send_rc_msg(&msg, ESLURM_NOT_SUPPORTED);
+		return SLURM_SUCCESS;
+	}
 
 	slurmctld_req(&msg);
 
 	return SLURM_SUCCESS;
 }
 
+static void _client_session_fini(void *arg)
+{
+	slurm_persist_conn_t *persist_conn = arg;
+
+	log_flag(NET, "%s: client session from %s closed",
+		 __func__, persist_conn->rem_host);
+
+	slurm_mutex_lock(&client_session_mutex);
+	client_session_cnt--;
+	slurm_mutex_unlock(&client_session_mutex);
+}
+
+/* Start serving a REQUEST_PERSIST_INIT from a client command or library */
+static int _add_client_session(slurm_persist_conn_t *persist_conn,
+			       char **comment)
+{
+	slurm_mutex_lock(&client_session_mutex);
+	if (client_session_cnt >= CLIENT_SESSION_MAX) {
+		slurm_mutex_unlock(&client_session_mutex);
+		*comment = xstrdup_printf("too many client sessions (%d)",
+					  CLIENT_SESSION_MAX);
+		debug("%s: %s", __func__, *comment);
+		return SLURM_ERROR;
+	}
+	client_session_cnt++;
+	slurm_mutex_unlock(&client_session_mutex);
+
+	persist_conn->callback_fini = _client_session_fini;
+	persist_conn->flags |= PERSIST_FLAG_ALREADY_INITED;
+	persist_conn->timeout = CLIENT_SESSION_TIMEOUT * MSEC_IN_SEC;
+
+	slurm_persist_conn_recv_thread_init(persist_conn, -1, persist_conn);
+
+	return SLURM_SUCCESS;
+}
+
 static void _slurm_rpc_persist_init(slurm_msg_t *msg)
 {
 	DEF_TIMERS;
@@ -5649,7 +6107,8 @@ static void _slurm_rpc_persist_init(slurm_msg_t *msg)
 	if (persist_init->version > SLURM_PROTOCOL_VERSION)
 		persist_init->version = SLURM_PROTOCOL_VERSION;
 
-	if (!validate_slurm_user(msg->auth_uid)) {
+	if ((persist_init->persist_type != PERSIST_TYPE_CLIENT) &&
+	    !validate_slurm_user(msg->auth_uid)) {
 		memset(&p_tmp, 0, sizeof(p_tmp));
 		p_tmp.fd = msg->conn_fd;
 		p_tmp.cluster_name = persist_init->cluster_name;
@@ -5693,6 +6152,8 @@ static void _slurm_rpc_persist_init(slurm_msg_t *msg)
 
 	if (persist_init->persist_type == PERSIST_TYPE_FED)
 		rc = fed_mgr_add_sibling_conn(persist_conn, &comment);
+	else if (persist_init->persist_type == PERSIST_TYPE_CLIENT)
+		rc = _add_client_session(persist_conn, &comment);
 	else
 		rc = SLURM_ERROR;
 end_it:
@@ -5710,6 +6171,8 @@ end_it:
 		/* Free AFTER message has been sent back to remote */
 		persist_conn->fd = -1;
 		slurm_persist_conn_destroy(persist_conn);
+		/* Give the socket back so it is closed with the RPC */
+		msg->conn_fd = p_tmp.fd;
 	}
 	xfree(comment);
 	free_buf(ret_buf);
@@ -5719,12 +6182,18 @@ end_it:
 	//slurm_persist_conn_destroy(persist_conn);
 }
 
+/* Sibling RPCs are only trusted on a federation persistent connection */
+static bool _is_fed_conn(slurm_msg_t *msg)
+{
+	return (msg->conn && (msg->conn->persist_type == PERSIST_TYPE_FED));
+}
+
 static void _slurm_rpc_sib_job_lock(slurm_msg_t *msg)
 {
 	int rc;
 	sib_msg_t *sib_msg = msg->data;
 
-	if (!msg->conn) {
+	if (!_is_fed_conn(msg)) {
 		error("Security violation, SIB_JOB_LOCK RPC from uid=%u",
 		      msg->auth_uid);
 		slurm_send_rc_msg(msg, ESLURM_ACCESS_DENIED);
@@ -5741,7 +6210,7 @@ static void _slurm_rpc_sib_job_unlock(slurm_msg_t *msg)
 	int rc;
 	sib_msg_t *sib_msg = msg->data;
 
-	if (!msg->conn) {
+	if (!_is_fed_conn(msg)) {
 		error("Security violation, SIB_JOB_UNLOCK RPC from uid=%u",
 		      msg->auth_uid);
 		slurm_send_rc_msg(msg, ESLURM_ACCESS_DENIED);
@@ -5754,7 +6223,7 @@ static void _slurm_rpc_sib_job_unlock(slurm_msg_t *msg)
 }
 
 static void _slurm_rpc_sib_msg(uint32_t uid, slurm_msg_t *msg) {
-	if (!msg->conn) {
+	if (!_is_fed_conn(msg)) {
 		error("Security violation, SIB_SUBMISSION RPC from uid=%u",
 		      uid);
 		slurm_send_rc_msg(msg, ESLURM_ACCESS_DENIED);
@@ -5766,7 +6235,7 @@ static void _slurm_rpc_sib_msg(uint32_t uid, slurm_msg_t *msg) {
 
 static void _slurm_rpc_dependency_msg(uint32_t uid, slurm_msg_t *msg)
 {
-	if (!msg->conn || !validate_slurm_user(uid)) {
+	if (!_is_fed_conn(msg) || !validate_slurm_user(uid)) {
 		error("Security violation, REQUEST_SEND_DEP RPC from uid=%d",
 		      uid);
 		slurm_send_rc_msg(msg, ESLURM_ACCESS_DENIED);
@@ -5778,7 +6247,7 @@ static void _slurm_rpc_dependency_msg(uint32_t uid, slurm_msg_t *msg)
 
 static void _slurm_rpc_update_origin_dep_msg(uint32_t uid, slurm_msg_t *msg)
 {
-	if (!msg->conn || !validate_slurm_user(uid)) {
+	if (!_is_fed_conn(msg) || !validate_slurm_user(uid)) {
 		error("Security violation, REQUEST_UPDATE_ORIGIN_DEP RPC from uid=%d",
 		      uid);
 		slurm_send_rc_msg(msg, ESLURM_ACCESS_DENIED);
@@ -5823,7 +6292,7 @@ static void _proc_multi_msg(slurm_msg_t *msg)
 	ListIterator iter = NULL;
 	int rc;
 
-	if (!msg->conn) {
+	if (!_is_fed_conn(msg)) {
 		error("Security violation, REQUEST_CTLD_MULT_MSG RPC from uid=%u",
 		      msg->auth_uid);
 		slurm_send_rc_msg(msg, ESLURM_ACCESS_DENIED);
@@ -5908,7 +6377,7 @@ static int _route_msg_to_origin(slurm_msg_t *msg, char *src_job_id_str,
 	xassert(msg);
 
 	/* route msg to origin cluster if a federated job */
-	if (!msg->conn && fed_mgr_fed_rec) {
+	if (!_is_fed_conn(msg) && fed_mgr_fed_rec) {
 		/* Don't send reroute if coming from a federated cluster (aka
 		 * has a msg->conn). */
 		uint32_t job_id, origin_id;
@@ -6170,6 +6639,13 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = MESSAGE_EPILOG_COMPLETE,
 		.func = _slurm_rpc_epilog_complete,
+		.queue_enabled = true,
+		.locks = {
+			.conf = READ_LOCK,
+			.job = WRITE_LOCK,
+			.node = WRITE_LOCK,
+		},
+		.post_func = _epilog_complete_post,
 	},{
 		.msg_type = REQUEST_CANCEL_JOB_STEP,
 		.func = _slurm_rpc_job_step_kill,
@@ -6270,6 +6746,9 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_SUBMIT_BATCH_HET_JOB,
 		.func = _slurm_rpc_submit_batch_het_job,
+	},{
+		.msg_type = REQUEST_SUBMIT_BATCH_JOBS,
+		.func = _slurm_rpc_submit_batch_jobs,
 	},{
 		.msg_type = REQUEST_UPDATE_FRONT_END,
 		.func = _slurm_rpc_update_front_end,
@@ -6354,6 +6833,12 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_JOB_NOTIFY,
 		.func = _slurm_rpc_job_notify,
+	},{
+		.msg_type = REQUEST_JOB_WAIT_NOTIFY,
+		.func = _slurm_rpc_job_wait_notify,
+	},{
+		.msg_type = REQUEST_CTLD_EVENTS,
+		.func = _slurm_rpc_ctld_events,
 	},{
 		.msg_type = REQUEST_SET_DEBUG_FLAGS,
 		.func = _slurm_rpc_set_debug_flags,
@@ -6402,6 +6887,9 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_BURST_BUFFER_STATUS,
 		.func = _slurm_rpc_burst_buffer_status,
+	},{
+		.msg_type = REQUEST_CTLD_PROFILE,
+		.func = _slurm_rpc_ctld_profile,
 	},{
 		.msg_type = REQUEST_CRONTAB,
 		.func = _slurm_rpc_request_crontab,
@@ -6422,6 +6910,7 @@ void slurmctld_req(slurm_msg_t *msg)
 {
 	DEF_TIMERS;
 	slurmctld_rpc_t *this_rpc = NULL;
+	uint64_t span;
 
 	if (msg->conn_fd >= 0)
 		fd_set_nonblocking(msg->conn_fd);
@@ -6438,6 +6927,9 @@ void slurmctld_req(slurm_msg_t *msg)
 	/* Debug the protocol layer.
 	 */
 	START_TIMER;
+	(void) get_thread_lock_wait();
+	trace_set_id(msg->trace_id);
+	span = trace_span_start();
 	if (slurm_conf.debug_flags & DEBUG_FLAG_PROTOCOL) {
 		char *p = rpc_num2string(msg->msg_type);
 		if (msg->conn) {
@@ -6468,6 +6960,7 @@ void slurmctld_req(slurm_msg_t *msg)
 		(*(this_rpc->func))(msg);
 		END_TIMER;
 		record_rpc_stats(msg, DELTA_TIMER);
+		trace_span_end(rpc_num2string(msg->msg_type), span);
 	} else {
 		error("invalid RPC msg_type=%u", msg->msg_type);
 		slurm_send_rc_msg(msg, EINVAL);
@@ -49,6 +49,7 @@ typedef struct {
 	uint16_t msg_type;
 	void (*func)(slurm_msg_t *msg);
 	slurmctld_lock_t locks;
+	void (*post_func)(void); /* run without locks after each queue batch */
 
 	/* Queue structual elements */
 	char *msg_name; /* automatically derived from msg_type */
@@ -60,7 +61,13 @@ typedef struct {
 	pthread_cond_t cond;
 	pthread_mutex_t mutex;
 
-	List work;
+	mpsc_queue_t work;
+	mpsc_link_t *pending;	/* taken from work, not yet processed */
+
+	/* responses sent after releasing locks, only used by thread */
+	struct deferred_resp *deferred;
+	struct deferred_resp **deferred_tail;
+	int deferred_cnt;
 } slurmctld_rpc_t;
 
 extern slurmctld_rpc_t slurmctld_rpcs[];
@@ -0,0 +1,323 @@
+/*****************************************************************************\
+ *  profiler.c - sampling profiler for slurmctld threads
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "config.h"
+#define _GNU_SOURCE
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/time.h>
+
+#if defined(__GLIBC__)
+#  include <execinfo.h>
+#endif
+
+#if HAVE_SYS_PRCTL_H
+#  include <sys/prctl.h>
+#endif
+
+#include "slurm/slurm.h"
+
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/read_config.h"
+#include "src/common/xhash.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+#include "src/slurmctld/profiler.h"
+
+#define PROFILE_HZ	100	/* samples per second of CPU time */
+#define PROFILE_DEPTH	32	/* frames recorded per sample */
+#define PROFILE_RING	4096	/* samples buffered between drains */
+#define PROFILE_SKIP	2	/* frames of the signal handler itself */
+
+typedef struct {
+	char name[16];		/* thread name, see PR_GET_NAME */
+	void *frames[PROFILE_DEPTH];
+} prof_key_t;
+
+/* Written by the signal handler, seq is 0 while the slot is being filled */
+typedef struct {
+	volatile uint32_t seq;
+	int depth;
+	prof_key_t key;
+} prof_sample_t;
+
+typedef struct {
+	prof_key_t key;
+	uint32_t key_len;
+	uint32_t count;
+} prof_stack_t;
+
+static prof_sample_t ring[PROFILE_RING];
+static volatile uint32_t ring_head = 0;
+static uint32_t ring_tail = 0;
+
+static pthread_mutex_t prof_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t prof_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t prof_tid = 0;
+static bool prof_running = false;
+static xhash_t *prof_stacks = NULL;
+static uint32_t prof_dropped = 0;
+
+static void _stack_id(void *item, const char **key, uint32_t *key_len)
+{
+	prof_stack_t *stack = item;
+
+	*key = (const char *) &stack->key;
+	*key_len = stack->key_len;
+}
+
+static void _sig_prof(int sig)
+{
+#if defined(__GLIBC__)
+	int saved_errno = errno;
+	uint32_t inx = __sync_fetch_and_add(&ring_head, 1);
+	prof_sample_t *sample = &ring[inx % PROFILE_RING];
+
+	sample->seq = 0;
+	memset(sample->key.name, 0, sizeof(sample->key.name));
+#if HAVE_SYS_PRCTL_H
+	(void) prctl(PR_GET_NAME, sample->key.name, NULL, NULL, NULL);
+#endif
+	sample->depth = backtrace(sample->key.frames, PROFILE_DEPTH);
+	__sync_synchronize();
+	sample->seq = inx + 1;
+	errno = saved_errno;
+#endif
+}
+
+/* Move the buffered samples into prof_stacks, call with prof_mutex locked */
+static void _drain_ring(void)
+{
+	uint32_t head = ring_head;
+	prof_sample_t copy;
+	prof_stack_t *stack;
+	uint32_t key_len;
+
+	if ((head - ring_tail) > PROFILE_RING) {
+		prof_dropped += head - ring_tail - PROFILE_RING;
+		ring_tail = head - PROFILE_RING;
+	}
+
+	for (; ring_tail != head; ring_tail++) {
+		prof_sample_t *sample = &ring[ring_tail % PROFILE_RING];
+
+		if (sample->seq != ring_tail + 1) {
+			prof_dropped++;
+			continue;
+		}
+		memcpy(&copy, sample, sizeof(copy));
+		__sync_synchronize();
+		/* Overwritten by the handler while being copied */
+		if ((sample->seq != ring_tail + 1) || (copy.depth <= 0)) {
+			prof_dropped++;
+			continue;
+		}
+
+		copy.key.name[sizeof(copy.key.name) - 1] = '\0';
+		key_len = offsetof(prof_key_t, frames) +
+			  (copy.depth * sizeof(void *));
+		if ((stack = xhash_get(prof_stacks, (char *) &copy.key,
+				       key_len))) {
+			stack->count++;
+			continue;
+		}
+		stack = xmalloc(sizeof(*stack));
+		memcpy(&stack->key, &copy.key, key_len);
+		stack->key_len = key_len;
+		stack->count = 1;
+		xhash_add(prof_stacks, stack);
+	}
+}
+
+static void *_profiler_agent(void *arg)
+{
+	struct timespec ts;
+
+#if HAVE_SYS_PRCTL_H
+	if (prctl(PR_SET_NAME, "profiler", NULL, NULL, NULL) < 0) {
+		error("%s: cannot set my name to %s %m", __func__, "profiler");
+	}
+#endif
+
+	slurm_mutex_lock(&prof_mutex);
+	while (prof_running) {
+		ts.tv_sec = time(NULL) + 1;
+		ts.tv_nsec = 0;
+		slurm_cond_timedwait(&prof_cond, &prof_mutex, &ts);
+		_drain_ring();
+	}
+	slurm_mutex_unlock(&prof_mutex);
+
+	return NULL;
+}
+
+static void _set_timer(int hz)
+{
+	struct itimerval it;
+
+	memset(&it, 0, sizeof(it));
+	if (hz) {
+		it.it_interval.tv_usec = USEC_IN_SEC / hz;
+		it.it_value.tv_usec = USEC_IN_SEC / hz;
+	}
+	if (setitimer(ITIMER_PROF, &it, NULL))
+		error("%s: setitimer: %m", __func__);
+}
+
+static void _profiler_start(void)
+{
+#if defined(__GLIBC__)
+	static bool preloaded = false;
+	struct sigaction sa;
+
+	/* backtrace() loads libgcc on first use, which is not signal safe */
+	if (!preloaded) {
+		void *frame;
+
+		(void) backtrace(&frame, 1);
+		preloaded = true;
+	}
+
+	slurm_mutex_lock(&prof_mutex);
+	if (prof_running) {
+		slurm_mutex_unlock(&prof_mutex);
+		return;
+	}
+	if (prof_stacks)
+		xhash_clear(prof_stacks);
+	else
+		prof_stacks = xhash_init(_stack_id, xfree_ptr);
+	prof_dropped = 0;
+	ring_tail = ring_head;
+	prof_running = true;
+	slurm_mutex_unlock(&prof_mutex);
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = _sig_prof;
+	sa.sa_flags = SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	if (sigaction(SIGPROF, &sa, NULL))
+		error("%s: sigaction: %m", __func__);
+
+	slurm_thread_create(&prof_tid, _profiler_agent, NULL);
+	_set_timer(PROFILE_HZ);
+	info("Stack sampling started at %d Hz", PROFILE_HZ);
+#else
+	error("Stack sampling is not supported on this platform");
+#endif
+}
+
+static void _profiler_stop(void)
+{
+	pthread_t tid;
+
+	slurm_mutex_lock(&prof_mutex);
+	if (!prof_running) {
+		slurm_mutex_unlock(&prof_mutex);
+		return;
+	}
+	_set_timer(0);
+	prof_running = false;
+	slurm_cond_signal(&prof_cond);
+	tid = prof_tid;
+	prof_tid = 0;
+	slurm_mutex_unlock(&prof_mutex);
+
+	pthread_join(tid, NULL);
+	info("Stack sampling stopped");
+}
+
+extern void profiler_reconfig(void)
+{
+	if (slurm_conf.debug_flags & DEBUG_FLAG_STACK_SAMPLE)
+		_profiler_start();
+	else
+		_profiler_stop();
+}
+
+static void _dump_stack(void *item, void *arg)
+{
+	prof_stack_t *stack = item;
+	char **str = arg;
+	int depth = (stack->key_len - offsetof(prof_key_t, frames)) /
+		    sizeof(void *);
+	Dl_info dl;
+
+	xstrfmtcat(*str, "%s", stack->key.name[0] ? stack->key.name : "?");
+	/* Folded stacks are root first, backtrace() is leaf first */
+	for (int i = depth - 1; i >= PROFILE_SKIP; i--) {
+		void *addr = stack->key.frames[i];
+
+		if (!dladdr(addr, &dl) || !dl.dli_fname)
+			xstrfmtcat(*str, ";%p", addr);
+		else if (dl.dli_sname)
+			xstrfmtcat(*str, ";%s", dl.dli_sname);
+		else
+			xstrfmtcat(*str, ";%s+0x%lx",
+				   xbasename((char *) dl.dli_fname),
+				   (unsigned long) ((char *) addr -
+						    (char *) dl.dli_fbase));
+	}
+	xstrfmtcat(*str, " %u\n", stack->count);
+}
+
+extern char *profiler_dump(void)
+{
+	char *str = NULL;
+
+	slurm_mutex_lock(&prof_mutex);
+	if (prof_stacks) {
+		_drain_ring();
+		xhash_walk(prof_stacks, _dump_stack, &str);
+		if (prof_dropped)
+			debug("%s: %u samples dropped", __func__, prof_dropped);
+	}
+	slurm_mutex_unlock(&prof_mutex);
+
+	return str;
+}
+
+extern void profiler_fini(void)
+{
+	_profiler_stop();
+
+	slurm_mutex_lock(&prof_mutex);
+	xhash_free(prof_stacks);
+	slurm_mutex_unlock(&prof_mutex);
+}
@@ -0,0 +1,56 @@
+/*****************************************************************************\
+ *  profiler.h - sampling profiler for slurmctld threads
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _HAVE_PROFILER_H
+#define _HAVE_PROFILER_H
+
+/*
+ * Sample the stacks of all slurmctld threads from a SIGPROF timer while
+ * DebugFlags=StackSample is set. Samples are aggregated by thread name and
+ * call stack, and kept until sampling is enabled again.
+ */
+
+/* Start or stop sampling to match the current DebugFlags */
+extern void profiler_reconfig(void);
+
+/*
+ * Return the aggregated samples in folded stack format, one line per distinct
+ * stack: "<thread>;<root frame>;...;<leaf frame> <count>"
+ * RET xmalloc'd string or NULL if nothing was sampled, caller must xfree()
+ */
+extern char *profiler_dump(void);
+
+/* Stop sampling and free all samples */
+extern void profiler_fini(void);
+
+#endif
@@ -98,6 +98,7 @@
 List active_feature_list;	/* list of currently active features_records */
 List avail_feature_list;	/* list of available features_records */
 bool node_features_updated = true;
+uint32_t node_features_gen = 1;
 bool slurmctld_init_db = true;
 
 static void _acct_restore_active_jobs(void);
@@ -354,6 +355,7 @@ static void _init_bitmaps(void)
 	FREE_NULL_BITMAP(share_node_bitmap);
 	FREE_NULL_BITMAP(up_node_bitmap);
 	FREE_NULL_BITMAP(rs_node_bitmap);
+	node_owner_fini();
 	avail_node_bitmap = bit_alloc(node_record_count);
 	bf_ignore_node_bitmap = bit_alloc(node_record_count);
 	booting_node_bitmap = bit_alloc(node_record_count);
@@ -1616,6 +1618,7 @@ extern void build_feature_list_eq(void)
 	FREE_NULL_LIST(avail_feature_list);
 	active_feature_list = list_create(_list_delete_feature);
 	avail_feature_list = list_create(_list_delete_feature);
+	node_features_gen++;
 
 	config_iterator = list_iterator_create(config_list);
 	while ((config_ptr = list_next(config_iterator))) {
@@ -1685,6 +1688,7 @@ extern void build_feature_list_ne(void)
 	FREE_NULL_LIST(avail_feature_list);
 	active_feature_list = list_create(_list_delete_feature);
 	avail_feature_list = list_create(_list_delete_feature);
+	node_features_gen++;
 
 	for (i = 0, node_ptr = node_record_table_ptr; i < node_record_count;
 	     i++, node_ptr++) {
@@ -1749,6 +1753,7 @@ extern void update_feature_list(List feature_list, char *new_features,
 		xfree(tmp_str);
 	}
 	node_features_updated = true;
+	node_features_gen++;
 }
 
 static void _gres_reconfig(bool reconfig)
@@ -2600,13 +2605,11 @@ static int _sync_nodes_to_active_job(job_record_t *job_ptr)
 		    (job_ptr->part_ptr &&
 		     (job_ptr->part_ptr->flags & PART_FLAG_EXCLUSIVE_USER))) {
 			node_ptr->owner_job_cnt++;
-			node_ptr->owner = job_ptr->user_id;
+			node_set_owner(node_ptr, job_ptr->user_id);
 		}
 
-		if (slurm_mcs_get_select(job_ptr) == 1) {
-			xfree(node_ptr->mcs_label);
-			node_ptr->mcs_label = xstrdup(job_ptr->mcs_label);
-		}
+		if (slurm_mcs_get_select(job_ptr) == 1)
+			node_set_mcs(node_ptr, job_ptr->mcs_label);
 
 		node_flags = node_ptr->node_state & NODE_STATE_FLAGS;
 
@@ -79,6 +79,7 @@
 #include "src/slurmctld/node_scheduler.h"
 #include "src/slurmctld/reservation.h"
 #include "src/slurmctld/slurmctld.h"
+#include "src/slurmctld/state_replica.h"
 #include "src/slurmctld/state_save.h"
 
 #define RESV_MAGIC	0x3b82
@@ -1897,7 +1898,8 @@ static void _pack_resv(slurmctld_resv_t *resv_ptr, buf_t *buffer,
 			packstr(resv_ptr->tres_str,	buffer);
 			pack32(resv_ptr->ctld_flags,	buffer);
 		} else {
-			pack_bit_str_hex(resv_ptr->node_bitmap, buffer);
+			pack_bit_str(resv_ptr->node_bitmap, buffer,
+				     protocol_version);
 			if (!resv_ptr->core_bitmap ||
 			    !resv_ptr->core_resrcs ||
 			    !resv_ptr->core_resrcs->node_bitmap ||
@@ -1980,7 +1982,8 @@ static void _pack_resv(slurmctld_resv_t *resv_ptr, buf_t *buffer,
 				uint8_tmp = 0;
 			pack8(uint8_tmp,	buffer);
 		} else {
-			pack_bit_str_hex(resv_ptr->node_bitmap, buffer);
+			pack_bit_str(resv_ptr->node_bitmap, buffer,
+				     protocol_version);
 			if (!resv_ptr->core_bitmap ||
 			    !resv_ptr->core_resrcs ||
 			    !resv_ptr->core_resrcs->node_bitmap ||
@@ -3626,6 +3629,8 @@ extern int dump_all_resv_state(void)
 	xfree(new_file);
 	unlock_state_files();
 
+	if (!error_code)
+		state_replica_send("resv_state", buffer);
 	free_buf(buffer);
 	END_TIMER2("dump_all_resv_state");
 	return 0;
@@ -4150,6 +4155,8 @@ static buf_t *_open_resv_state_file(char **state_file)
 
 	*state_file = xstrdup(slurm_conf.state_save_location);
 	xstrcat(*state_file, "/resv_state");
+	if ((buf = state_replica_open(*state_file)))
+		return buf;
 	if (!(buf = create_mmap_buf(*state_file)))
 		error("Could not open reservation state file %s: %m",
 		      *state_file);
@@ -6224,10 +6231,15 @@ extern int job_test_resv(job_record_t *job_ptr, time_t *when,
 
 		/*
 		 * if there are any overlapping reservations, we need to
-		 * prevent the job from using those nodes (e.g. MAINT nodes)
+		 * prevent the job from using those nodes (e.g. MAINT nodes).
+		 * Nothing is removed from a MAINT reservation, so don't bother
+		 * walking the list for one.
 		 */
-		iter = list_iterator_create(resv_list);
-		while ((res2_ptr = list_next(iter))) {
+		if (resv_ptr->flags & RESERVE_FLAG_MAINT)
+			iter = NULL;
+		else
+			iter = list_iterator_create(resv_list);
+		while (iter && (res2_ptr = list_next(iter))) {
 			if (reboot)
 				job_end_time_use =
 					job_end_time + res2_ptr->boot_time;
@@ -6237,8 +6249,7 @@ extern int job_test_resv(job_record_t *job_ptr, time_t *when,
 			_get_rel_start_end(
 				res2_ptr, now, &start_relative, &end_relative);
 
-			if ((resv_ptr->flags & RESERVE_FLAG_MAINT) ||
-			    ((resv_ptr->flags & RESERVE_FLAG_OVERLAP) &&
+			if (((resv_ptr->flags & RESERVE_FLAG_OVERLAP) &&
 			     !(res2_ptr->flags & RESERVE_FLAG_MAINT)) ||
 			    (res2_ptr == resv_ptr) ||
 			    (res2_ptr->node_bitmap == NULL) ||
@@ -6257,7 +6268,8 @@ extern int job_test_resv(job_record_t *job_ptr, time_t *when,
 				bit_and_not(*node_bitmap,res2_ptr->node_bitmap);
 			}
 		}
-		list_iterator_destroy(iter);
+		if (iter)
+			list_iterator_destroy(iter);
 
 		if (slurm_conf.debug_flags & DEBUG_FLAG_RESERVATION) {
 			char *nodes = bitmap2node_name(*node_bitmap);
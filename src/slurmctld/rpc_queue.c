@@ -42,20 +42,77 @@
 #include <sys/prctl.h>
 #endif
 
-#include "src/common/list.h"
 #include "src/common/macros.h"
 #include "src/common/read_config.h"
 #include "src/common/slurm_protocol_defs.h"
+#include "src/common/trace.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
 #include "src/slurmctld/job_scheduler.h"
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/proc_req.h"
+#include "src/slurmctld/rpc_queue.h"
 #include "src/slurmctld/state_save.h"
 
+/*
+ * Maximum count of responses held before the locks are released to send
+ * them. Bounds both the latency of the first response and the memory held.
+ */
+#define MAX_DEFERRED_RESPONSES 32
+
+typedef struct deferred_resp {
+	char *data;
+	uint32_t data_size;
+	slurm_msg_t *msg;
+	uint16_t msg_type;
+	struct deferred_resp *next;
+	void *resp;		/* unpacked response, data is NULL */
+} deferred_resp_t;
+
 bool enabled = true;
 
+static void _send_deferred(slurmctld_rpc_t *q)
+{
+	deferred_resp_t *resp;
+	slurm_msg_t response_msg;
+
+	while ((resp = q->deferred)) {
+		q->deferred = resp->next;
+		q->deferred_cnt--;
+		if (resp->resp) {
+			slurm_send_msg(resp->msg, resp->msg_type, resp->resp);
+			xfree(resp->resp);
+		} else {
+			response_init(&response_msg, resp->msg);
+			response_msg.msg_type = resp->msg_type;
+			response_msg.data = resp->data;
+			response_msg.data_size = resp->data_size;
+			slurm_send_node_msg(resp->msg->conn_fd, &response_msg);
+		}
+
+		if ((resp->msg->conn_fd >= 0) && (close(resp->msg->conn_fd) < 0))
+			error("close(%d): %m", resp->msg->conn_fd);
+		slurm_free_msg(resp->msg);
+		xfree(resp->data);
+		xfree(resp);
+	}
+	q->deferred_tail = &q->deferred;
+}
+
+/* Return the oldest queued message, or NULL if none */
+static slurm_msg_t *_dequeue(slurmctld_rpc_t *q)
+{
+	slurm_msg_t *msg;
+
+	if (!q->pending && !(q->pending = mpsc_queue_take(&q->work)))
+		return NULL;
+
+	msg = mpsc_entry(q->pending, slurm_msg_t, queue_link);
+	q->pending = q->pending->next;
+	return msg;
+}
+
 static void *_rpc_queue_worker(void *arg)
 {
 	slurmctld_rpc_t *q = (slurmctld_rpc_t *) arg;
@@ -81,11 +138,19 @@ static void *_rpc_queue_worker(void *arg)
 	 * acquisition, then fall back to sleep until additional work is queued.
 	 */
 	while (true) {
-		msg = list_dequeue(q->work);
+		if (q->deferred_cnt < MAX_DEFERRED_RESPONSES)
+			msg = _dequeue(q);
+		else
+			msg = NULL;
 
 		if (!msg) {
 			unlock_slurmctld(q->locks);
 
+			_send_deferred(q);
+
+			if (processed && q->post_func)
+				q->post_func();
+
 			log_flag(PROTOCOL, "%s(%s): sleeping after processing %d",
 				 __func__, q->msg_name, processed);
 			processed = 0;
@@ -114,11 +179,11 @@ static void *_rpc_queue_worker(void *arg)
 			}
 
 			/*
-			 * Verify list is empty. Since list_dequeue() above is
+			 * Verify queue is empty. Since _dequeue() above is
 			 * called without the mutex held, there is a race with
 			 * rpc_enqueue() that this check will solve.
 			 */
-			if (!list_count(q->work))
+			if (!q->pending && mpsc_queue_is_empty(&q->work))
 				slurm_cond_wait(&q->cond, &q->mutex);
 
 			slurm_mutex_unlock(&q->mutex);
@@ -126,18 +191,28 @@ static void *_rpc_queue_worker(void *arg)
 				 __func__, q->msg_name);
 			lock_slurmctld(q->locks);
 		} else {
+			int deferred_cnt = q->deferred_cnt;
+			uint64_t span;
 			DEF_TIMERS;
 			START_TIMER;
+			trace_set_id(msg->trace_id);
+			span = trace_span_start();
 
 			msg->flags |= CTLD_QUEUE_PROCESSING;
 			q->func(msg);
-			if ((msg->conn_fd >= 0) && (close(msg->conn_fd) < 0))
-				error("close(%d): %m", msg->conn_fd);
 
 			END_TIMER;
 			record_rpc_stats(msg, DELTA_TIMER);
-			slurm_free_msg(msg);
+			trace_span_end(q->msg_name, span);
 			processed++;
+
+			/* Deferred responses are sent and freed later */
+			if (q->deferred_cnt != deferred_cnt)
+				continue;
+
+			if ((msg->conn_fd >= 0) && (close(msg->conn_fd) < 0))
+				error("close(%d): %m", msg->conn_fd);
+			slurm_free_msg(msg);
 		}
 	}
 
@@ -158,7 +233,11 @@ extern void rpc_queue_init(void)
 			continue;
 
 		q->msg_name = rpc_num2string(q->msg_type);
-		q->work = list_create(NULL);
+		q->work.head = NULL;
+		q->pending = NULL;
+		q->deferred = NULL;
+		q->deferred_tail = &q->deferred;
+		q->deferred_cnt = 0;
 		slurm_cond_init(&q->cond, NULL);
 		slurm_mutex_init(&q->mutex);
 		q->shutdown = false;
@@ -193,7 +272,6 @@ extern void rpc_queue_shutdown(void)
 			continue;
 
 		pthread_join(q->thread, NULL);
-		FREE_NULL_LIST(q->work);
 	}
 }
 
@@ -207,10 +285,15 @@ extern bool rpc_enqueue(slurm_msg_t *msg)
 			if (!q->queue_enabled)
 				break;
 
-			list_enqueue(q->work, msg);
-			slurm_mutex_lock(&q->mutex);
-			slurm_cond_signal(&q->cond);
-			slurm_mutex_unlock(&q->mutex);
+			/*
+			 * The worker checks the queue under the mutex before
+			 * waiting, so it only needs a wakeup if it was empty.
+			 */
+			if (mpsc_queue_push(&q->work, &msg->queue_link)) {
+				slurm_mutex_lock(&q->mutex);
+				slurm_cond_signal(&q->cond);
+				slurm_mutex_unlock(&q->mutex);
+			}
 			return true;
 		}
 	}
@@ -218,3 +301,54 @@ extern bool rpc_enqueue(slurm_msg_t *msg)
 	/* RPC does not have a dedicated queue */
 	return false;
 }
+
+static void _defer(slurm_msg_t *msg, deferred_resp_t *resp)
+{
+	xassert(msg->flags & CTLD_QUEUE_PROCESSING);
+
+	for (slurmctld_rpc_t *q = slurmctld_rpcs; q->msg_type; q++) {
+		if (q->msg_type != msg->msg_type)
+			continue;
+
+		/* Only used by this queue's worker thread */
+		resp->next = NULL;
+		*q->deferred_tail = resp;
+		q->deferred_tail = &resp->next;
+		q->deferred_cnt++;
+		return;
+	}
+
+	fatal_abort("%s: no queue for %s",
+		    __func__, rpc_num2string(msg->msg_type));
+}
+
+extern void rpc_queue_defer_msg(slurm_msg_t *msg, uint16_t msg_type,
+				void *resp)
+{
+	deferred_resp_t *deferred = xmalloc(sizeof(*deferred));
+
+	deferred->msg = msg;
+	deferred->msg_type = msg_type;
+	deferred->resp = resp;
+	_defer(msg, deferred);
+}
+
+extern void rpc_queue_defer_rc(slurm_msg_t *msg, int rc)
+{
+	return_code_msg_t *rc_msg = xmalloc(sizeof(*rc_msg));
+
+	rc_msg->return_code = rc;
+	rpc_queue_defer_msg(msg, RESPONSE_SLURM_RC, rc_msg);
+}
+
+extern void rpc_queue_defer_response(slurm_msg_t *msg, uint16_t msg_type,
+				     char *data, uint32_t data_size)
+{
+	deferred_resp_t *resp = xmalloc(sizeof(*resp));
+
+	resp->data = data;
+	resp->data_size = data_size;
+	resp->msg = msg;
+	resp->msg_type = msg_type;
+	_defer(msg, resp);
+}
@@ -43,4 +43,31 @@ extern void rpc_queue_shutdown(void);
 
 extern bool rpc_enqueue(slurm_msg_t *msg);
 
+/*
+ * Queue a packed response to a message being processed by an RPC queue
+ * (CTLD_QUEUE_PROCESSING set). The response is sent once the queue has
+ * released its slurmctld locks, so that readers holding the locks are not
+ * also waiting on the network.
+ * IN msg - message being processed, freed by the queue after the response
+ * IN msg_type - response message type
+ * IN data - packed response body, freed by the queue
+ * IN data_size - size of data
+ */
+extern void rpc_queue_defer_response(slurm_msg_t *msg, uint16_t msg_type,
+				     char *data, uint32_t data_size);
+
+/*
+ * As rpc_queue_defer_response(), but for a response which is packed when it
+ * is sent.
+ * IN msg - message being processed, freed by the queue after the response
+ * IN msg_type - response message type
+ * IN resp - response body, xfree'd by the queue after the response is sent.
+ *	Anything it points to must remain valid until msg is freed.
+ */
+extern void rpc_queue_defer_msg(slurm_msg_t *msg, uint16_t msg_type,
+				void *resp);
+
+/* As rpc_queue_defer_msg() for a RESPONSE_SLURM_RC with return code rc */
+extern void rpc_queue_defer_rc(slurm_msg_t *msg, int rc);
+
 #endif
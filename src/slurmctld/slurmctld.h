@@ -154,6 +154,9 @@ typedef struct slurmctld_config {
 	pthread_t thread_id_rpc;
 } slurmctld_config_t;
 
+/* Bucket N holds launch times < 2^(N+1) msec, the last one everything slower */
+#define JOB_LAUNCH_HIST_SIZE 20
+
 /* Job scheduling statistics */
 typedef struct diag_stats {
 	int proc_req_threads;
@@ -193,6 +196,22 @@ typedef struct diag_stats {
 	uint32_t bf_table_size;
 	uint32_t bf_table_size_sum;
 	time_t   bf_when_last_cycle;
+	/* usec spent in each backfill phase, last cycle and sum of cycles */
+	uint64_t bf_phase_queue_last;
+	uint64_t bf_phase_queue_sum;
+	uint64_t bf_phase_running_last;
+	uint64_t bf_phase_running_sum;
+	uint64_t bf_phase_resv_last;
+	uint64_t bf_phase_resv_sum;
+	uint64_t bf_phase_sched_last;
+	uint64_t bf_phase_sched_sum;
+	uint64_t bf_phase_yield_last;
+	uint64_t bf_phase_yield_sum;
+	/* msec batch job launch latency, see record_job_launch_stats() */
+	uint32_t job_launch_hist[JOB_LAUNCH_STAGE_CNT][JOB_LAUNCH_HIST_SIZE];
+	uint64_t job_launch_sum[JOB_LAUNCH_STAGE_CNT];
+	uint64_t job_launch_max[JOB_LAUNCH_STAGE_CNT];
+	char *job_launch_max_node[JOB_LAUNCH_STAGE_CNT];
 
 	uint32_t latency;
 } diag_stats_t;
@@ -231,6 +250,7 @@ extern uint32_t   cluster_cpus;
 extern bool disable_remote_singleton;
 extern int max_depend_depth;
 extern bool node_features_updated;
+extern uint32_t node_features_gen;	/* bumped when feature lists change */
 extern pthread_cond_t purge_thread_cond;
 extern pthread_mutex_t purge_thread_lock;
 extern pthread_mutex_t check_bf_running_lock;
@@ -503,6 +523,9 @@ typedef struct job_feature {
 	uint8_t op_code;		/* separator, see FEATURE_OP_ above */
 	bitstr_t *node_bitmap_active;	/* nodes with this feature active */
 	bitstr_t *node_bitmap_avail;	/* nodes with this feature available */
+	uint32_t node_bitmap_gen;	/* node_features_gen when the bitmaps
+					 * were set by find_feature_nodes() */
+	bool node_bitmap_reboot;	/* can_reboot when the bitmaps were set */
 	uint16_t paren;			/* count of enclosing parenthesis */
 } job_feature_t;
 
@@ -545,8 +568,11 @@ struct job_details {
 					 * scrontab) */
 	uint16_t orig_cpus_per_task;	/* requested value of cpus_per_task */
 	List depend_list;		/* list of job_ptr:state pairs */
+	bool depend_cached;		/* dependencies unchanged since last
+					 * test, see depend_notify_job() */
 	char *dependency;		/* wait for other jobs */
 	char *orig_dependency;		/* original value (for archiving) */
+	char *env_blob;			/* blob_store key of the environment */
 	uint16_t env_cnt;		/* size of env_sup (see below) */
 	char **env_sup;			/* supplemental environment variables */
 	bitstr_t *exc_node_bitmap;	/* bitmap of excluded nodes */
@@ -593,6 +619,7 @@ struct job_details {
 					 * this job */
 	char *req_nodes;		/* required nodes */
 	uint16_t requeue;		/* controls ability requeue job */
+	char *script_blob;		/* blob_store key of the batch script */
 	uint8_t share_res;		/* set if job can share resources with
 					 * other jobs */
 	char *std_err;			/* pathname of job's stderr file */
@@ -741,7 +768,10 @@ struct job_record {
 					 * components */
 	uint32_t job_id;		/* job ID */
 	job_record_t *job_next;		/* next entry with same hash index */
+	job_record_t *job_name_next;	/* next entry with same user/name hash
+					 * index */
 	job_record_t *job_array_next_j;	/* job array linked list by job_id */
+	job_record_t *job_array_prev_j;	/* previous entry in that list */
 	job_record_t *job_array_next_t;	/* job array linked list by task_id */
 	job_record_t *job_preempt_comp; /* het job preempt component */
 	job_resources_t *job_resrcs;	/* details of allocated cores */
@@ -749,6 +779,9 @@ struct job_record {
 	uint16_t kill_on_node_fail;	/* 1 if job should be killed on
 					 * node failure */
 	time_t last_sched_eval;		/* last time job was evaluated for scheduling */
+	uint64_t launch_time[JOB_LAUNCH_STAGE_CNT]; /* usec each batch launch
+					 * stage was reached, see
+					 * enum job_launch_stages */
 	char *licenses;			/* licenses required by the job */
 	List license_list;		/* structure with license info */
 	acct_policy_limit_set_t limit_set; /* flags if indicate an
@@ -1259,6 +1292,19 @@ extern job_record_t *find_het_job_record(uint32_t job_id, uint32_t het_job_id);
  */
 extern job_record_t *find_job_record(uint32_t job_id);
 
+/*
+ * find_user_name_job - return the first job of a user with the given name
+ *	for which the match function returns non-zero. Jobs without a name
+ *	are also offered to the match function.
+ * IN user_id - user of the jobs
+ * IN name - name of the jobs
+ * IN match - match function, see list_find_first()
+ * IN key - passed to match
+ * RET pointer to the job's record, NULL if none matched
+ */
+extern job_record_t *find_user_name_job(uint32_t user_id, const char *name,
+					ListFindF match, void *key);
+
 /*
  * find_first_node_record - find a record for first node in the bitmap
  * IN node_bitmap
@@ -1597,6 +1643,22 @@ extern int het_job_signal(job_record_t *het_job_leader, uint16_t signal,
 extern int job_str_signal(char *job_id_str, uint16_t signal, uint16_t flags,
 			  uid_t uid, bool preempt);
 
+/*
+ * job_str_signal_list - signal the jobs of a list
+ * IN job_id_list - space separated list of job ids, each of a format accepted
+ *	by job_str_signal()
+ * IN signal - signal to send, SIGKILL == cancel the job
+ * IN flags  - see KILL_JOB_* flags in slurm.h
+ * IN uid - uid of requesting user
+ * OUT signaled_cnt - count of job ids signaled without error
+ * RET 0 on success, otherwise the first ESLURM error code other than
+ *	ESLURM_ALREADY_DONE and ESLURM_INVALID_JOB_ID, or one of those if only
+ *	they occurred
+ */
+extern int job_str_signal_list(char *job_id_list, uint16_t signal,
+			       uint16_t flags, uid_t uid,
+			       uint32_t *signaled_cnt);
+
 /*
  * job_suspend/job_suspend2 - perform some suspend/resume operation
  * NB job_suspend  - Uses the job_id field and ignores job_id_str
@@ -1868,6 +1930,26 @@ extern int load_step_state(job_record_t *job_ptr, buf_t *buffer,
  */
 extern void log_feature_lists(void);
 
+/*
+ * Set the user owning a node through OverSubscribe=USER or ExclusiveUser
+ * jobs (NO_VAL for none), or the MCS label of the jobs on it (NULL for
+ * none), keeping the node bitmaps used by node_owner_filter() and
+ * node_mcs_filter() current. Always use these to change either.
+ */
+extern void node_set_owner(node_record_t *node_ptr, uint32_t owner);
+extern void node_set_mcs(node_record_t *node_ptr, char *mcs_label);
+
+/* Clear from mask the nodes owned by users other than uid */
+extern void node_owner_filter(uint32_t uid, bitstr_t *mask);
+
+/* Clear from mask the nodes with a MCS label other than mcs_label */
+extern void node_mcs_filter(char *mcs_label, bitstr_t *mask);
+
+/* Nodes with a MCS label, do not modify or free */
+extern bitstr_t *node_mcs_bitmap(void);
+
+extern void node_owner_fini(void);
+
 /* make_node_alloc - flag specified node as allocated to a job
  * IN node_ptr - pointer to node being allocated
  * IN job_ptr  - pointer to job that is starting
@@ -1934,6 +2016,7 @@ extern int num_pending_job_array_tasks(uint32_t array_job_id);
  * IN show_flags - job filtering options
  * IN uid - uid of user making request (for partition filtering)
  * IN filter_uid - pack only jobs belonging to this user if not NO_VAL
+ * IN info_filter - pack only jobs matching this filter if not NULL
  * IN protocol_version - slurm protocol version of client
  * global: job_list - global list of job records
  * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
@@ -1942,6 +2025,7 @@ extern int num_pending_job_array_tasks(uint32_t array_job_id);
  */
 extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid, uint32_t filter_uid,
+			  info_filter_t *info_filter,
 			  uint16_t protocol_version);
 
 /*
@@ -1969,6 +2053,7 @@ extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
  * OUT buffer_size - set to size of the buffer in bytes
  * IN show_flags - node filtering options
  * IN uid - uid of user making request (for partition filtering)
+ * IN info_filter - pack nodes not matching this filter as hidden, or NULL
  * IN protocol_version - slurm protocol version of client
  * global: node_record_table_ptr - pointer to global node table
  * NOTE: the caller must xfree the buffer at *buffer_ptr
@@ -1977,6 +2062,7 @@ extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
  */
 extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 			   uint16_t show_flags, uid_t uid,
+			   info_filter_t *info_filter,
 			   uint16_t protocol_version);
 
 /* Pack all scheduling statistics */
@@ -2202,6 +2288,13 @@ extern step_record_t *build_batch_step(job_record_t *job_ptr_in);
 /* update first assigned job id as needed on reconfigure */
 extern void reset_first_job_id(void);
 
+/*
+ * Add a batch job's launch latency to the statistics once its batch script
+ * has started. The JOB_LAUNCH_ALLOC entry records the time from allocation
+ * to batch script start, the others the time from the prior stage reached.
+ */
+extern void record_job_launch_stats(job_record_t *job_ptr);
+
 /*
  * reset_job_bitmaps - reestablish bitmaps for existing jobs.
  *	this should be called after rebuilding node information,
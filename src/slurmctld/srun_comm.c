@@ -43,6 +43,7 @@
 
 #include "src/common/node_select.h"
 #include "src/common/xassert.h"
+#include "src/common/xhash.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 #include "src/slurmctld/agent.h"
@@ -51,6 +52,21 @@
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/srun_comm.h"
 
+/* A client waiting on the end of a job, see srun_job_wait_register() */
+typedef struct {
+	char host[64];			/* for the agent's hostlist */
+	uint16_t port;
+	uint16_t protocol_version;
+} job_waiter_t;
+
+typedef struct {
+	uint32_t job_id;
+	List waiters;			/* job_waiter_t */
+} job_wait_t;
+
+static pthread_mutex_t job_wait_mutex = PTHREAD_MUTEX_INITIALIZER;
+static xhash_t *job_wait_hash = NULL;
+
 /* Launch the srun request. Note that retry is always zero since
  * we don't want to clog the system up with messages destined for
  * defunct srun processes
@@ -465,6 +481,120 @@ extern void srun_job_complete(job_record_t *job_ptr)
 	list_iterator_destroy(step_iterator);
 }
 
+static void _job_wait_id(void *item, const char **key, uint32_t *key_len)
+{
+	job_wait_t *wait = item;
+
+	*key = (const char *) &wait->job_id;
+	*key_len = sizeof(wait->job_id);
+}
+
+static void _job_wait_free(void *item)
+{
+	job_wait_t *wait = item;
+
+	FREE_NULL_LIST(wait->waiters);
+	xfree(wait);
+}
+
+static int _find_job_waiter(void *x, void *key)
+{
+	job_waiter_t *waiter = x, *match = key;
+
+	return ((waiter->port == match->port) &&
+		!xstrcmp(waiter->host, match->host));
+}
+
+/*
+ * srun_job_wait_register - register a client to be sent SRUN_JOB_COMPLETE
+ *	once a job ends
+ * IN job_id - job, array or hetjob leader to watch
+ * IN addr - address of the client, its port is replaced by port
+ * IN port - port the client listens on
+ * IN protocol_version - of the client
+ */
+extern void srun_job_wait_register(uint32_t job_id, slurm_addr_t *addr,
+				   uint16_t port, uint16_t protocol_version)
+{
+	job_waiter_t *waiter = xmalloc(sizeof(*waiter));
+	job_wait_t *wait;
+
+	slurm_get_ip_str(addr, waiter->host, sizeof(waiter->host));
+	waiter->port = port;
+	waiter->protocol_version = protocol_version;
+
+	slurm_mutex_lock(&job_wait_mutex);
+	if (!job_wait_hash)
+		job_wait_hash = xhash_init(_job_wait_id, _job_wait_free);
+	if (!(wait = xhash_get(job_wait_hash, (char *) &job_id,
+			       sizeof(job_id)))) {
+		wait = xmalloc(sizeof(*wait));
+		wait->job_id = job_id;
+		wait->waiters = list_create(xfree_ptr);
+		xhash_add(job_wait_hash, wait);
+	}
+	/* Clients register again after each wake up, keep one entry */
+	if (list_find_first(wait->waiters, _find_job_waiter, waiter))
+		xfree(waiter);
+	else
+		list_append(wait->waiters, waiter);
+	slurm_mutex_unlock(&job_wait_mutex);
+}
+
+static void _job_wait_notify(uint32_t job_id)
+{
+	job_wait_t *wait;
+	job_waiter_t *waiter;
+	srun_job_complete_msg_t *msg_arg;
+	slurm_addr_t *addr;
+
+	if (!(wait = xhash_pop(job_wait_hash, (char *) &job_id,
+			       sizeof(job_id))))
+		return;
+
+	while ((waiter = list_pop(wait->waiters))) {
+		addr = xmalloc(sizeof(slurm_addr_t));
+		slurm_set_addr(addr, waiter->port, waiter->host);
+		msg_arg = xmalloc(sizeof(srun_job_complete_msg_t));
+		msg_arg->job_id = job_id;
+		msg_arg->step_id = NO_VAL;
+		msg_arg->step_het_comp = NO_VAL;
+		_srun_agent_launch(addr, waiter->host, SRUN_JOB_COMPLETE,
+				   msg_arg, waiter->protocol_version);
+		xfree(waiter);
+	}
+	_job_wait_free(wait);
+}
+
+/*
+ * srun_job_wait_notify - notify clients registered by
+ *	srun_job_wait_register() of the end of a job, its array or its hetjob
+ * IN job_ptr - pointer to the slurmctld job record
+ */
+extern void srun_job_wait_notify(job_record_t *job_ptr)
+{
+	xassert(job_ptr);
+
+	slurm_mutex_lock(&job_wait_mutex);
+	if (job_wait_hash) {
+		_job_wait_notify(job_ptr->job_id);
+		if (job_ptr->array_job_id &&
+		    (job_ptr->array_job_id != job_ptr->job_id))
+			_job_wait_notify(job_ptr->array_job_id);
+		if (job_ptr->het_job_id &&
+		    (job_ptr->het_job_id != job_ptr->job_id))
+			_job_wait_notify(job_ptr->het_job_id);
+	}
+	slurm_mutex_unlock(&job_wait_mutex);
+}
+
+extern void srun_job_wait_fini(void)
+{
+	slurm_mutex_lock(&job_wait_mutex);
+	xhash_free(job_wait_hash);
+	slurm_mutex_unlock(&job_wait_mutex);
+}
+
 /*
  * srun_job_suspend - notify salloc of suspend/resume operation
  * IN job_ptr - pointer to the slurmctld job record
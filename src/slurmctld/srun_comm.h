@@ -71,6 +71,28 @@ extern void srun_exec(step_record_t *step_ptr, char **argv);
  */
 extern void srun_job_complete(job_record_t *job_ptr);
 
+/*
+ * srun_job_wait_register - register a client to be sent SRUN_JOB_COMPLETE
+ *	once a job ends. Each registration is notified once, clients check
+ *	the job state themselves and register again as needed.
+ * IN job_id - job, array or hetjob leader to watch
+ * IN addr - address of the client, its port is replaced by port
+ * IN port - port the client listens on
+ * IN protocol_version - of the client
+ */
+extern void srun_job_wait_register(uint32_t job_id, slurm_addr_t *addr,
+				   uint16_t port, uint16_t protocol_version);
+
+/*
+ * srun_job_wait_notify - notify clients registered by
+ *	srun_job_wait_register() of the end of a job, its array or its hetjob
+ * IN job_ptr - pointer to the slurmctld job record
+ */
+extern void srun_job_wait_notify(job_record_t *job_ptr);
+
+/* Free all srun_job_wait_register() registrations */
+extern void srun_job_wait_fini(void);
+
 
 /*
  * srun_job_suspend - notify salloc of suspend/resume operation
@@ -0,0 +1,172 @@
+/*****************************************************************************\
+ *  state_replica.c - replicate saved state to standby controllers
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <pthread.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "src/common/list.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/read_config.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "src/slurmctld/slurmctld.h"
+#include "src/slurmctld/state_replica.h"
+
+static pthread_mutex_t replica_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List replica_list = NULL;	/* state_replica_msg_t, one per file */
+
+static int _find_name(void *x, void *key)
+{
+	state_replica_msg_t *msg = x;
+
+	return !xstrcmp(msg->name, key);
+}
+
+extern void state_replica_send(const char *name, buf_t *buffer)
+{
+	state_replica_msg_t msg = { 0 };
+	slurm_msg_t req;
+	struct stat sbuf;
+	char *path;
+	int rc;
+
+	if ((slurm_conf.control_cnt < 2) ||
+	    !xstrcasestr(slurm_conf.slurmctld_params, "replicate_state"))
+		return;
+
+	/* The standby compares this with the file when taking over */
+	path = xstrdup_printf("%s/%s", slurm_conf.state_save_location, name);
+	if (stat(path, &sbuf)) {
+		error("%s: stat(%s): %m", __func__, path);
+		xfree(path);
+		return;
+	}
+	xfree(path);
+
+	msg.name = (char *) name;
+	msg.mtime = sbuf.st_mtime;
+	msg.data = get_buf_data(buffer);
+	msg.size = get_buf_offset(buffer);
+
+	for (int i = 1; i < slurm_conf.control_cnt; i++) {
+		if ((i == backup_inx) || !slurm_conf.control_addr[i] ||
+		    !slurm_conf.control_addr[i][0])
+			continue;
+
+		slurm_msg_t_init(&req);
+		slurm_set_addr(&req.address, slurm_conf.slurmctld_port,
+			       slurm_conf.control_addr[i]);
+		req.msg_type = REQUEST_STATE_REPLICA;
+		req.data = &msg;
+		if (slurm_send_recv_rc_msg_only_one(&req, &rc, 0) < 0) {
+			debug("%s: send %s to %s: %m", __func__, name,
+			      slurm_conf.control_machine[i]);
+		} else if (rc) {
+			debug("%s: %s rejected %s: %s", __func__,
+			      slurm_conf.control_machine[i], name,
+			      slurm_strerror(rc));
+		}
+	}
+}
+
+extern void state_replica_store(state_replica_msg_t *msg)
+{
+	state_replica_msg_t *old;
+
+	if (!msg || !msg->name)
+		goto fini;
+
+	slurm_mutex_lock(&replica_mutex);
+	if (!replica_list)
+		replica_list = list_create(
+			(ListDelF) slurm_free_state_replica_msg);
+	if ((old = list_find_first(replica_list, _find_name, msg->name)) &&
+	    (old->mtime > msg->mtime)) {
+		slurm_mutex_unlock(&replica_mutex);
+		goto fini;
+	}
+	if (old)
+		list_delete_ptr(replica_list, old);
+	debug3("%s: %s of %u bytes", __func__, msg->name, msg->size);
+	list_append(replica_list, msg);
+	slurm_mutex_unlock(&replica_mutex);
+	return;
+
+fini:
+	slurm_free_state_replica_msg(msg);
+}
+
+extern buf_t *state_replica_open(const char *state_file)
+{
+	state_replica_msg_t *msg;
+	struct stat sbuf;
+	const char *name;
+	buf_t *buf = NULL;
+
+	if (!(name = strrchr(state_file, '/')))
+		name = state_file;
+	else
+		name++;
+
+	slurm_mutex_lock(&replica_mutex);
+	if (!replica_list ||
+	    !(msg = list_find_first(replica_list, _find_name, (void *) name)))
+		goto fini;
+
+	/* The primary saved again but could not send it */
+	if (!stat(state_file, &sbuf) && (sbuf.st_mtime > msg->mtime)) {
+		info("%s: %s is newer than its replica, reading the file",
+		     __func__, state_file);
+		goto fini;
+	}
+
+	info("Recovering %s from replica", name);
+	buf = create_buf(xmalloc(msg->size), msg->size);
+	memcpy(get_buf_data(buf), msg->data, msg->size);
+
+fini:
+	slurm_mutex_unlock(&replica_mutex);
+	return buf;
+}
+
+extern void state_replica_fini(void)
+{
+	slurm_mutex_lock(&replica_mutex);
+	FREE_NULL_LIST(replica_list);
+	slurm_mutex_unlock(&replica_mutex);
+}
@@ -0,0 +1,66 @@
+/*****************************************************************************\
+ *  state_replica.h - replicate saved state to standby controllers
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _HAVE_STATE_REPLICA_H
+#define _HAVE_STATE_REPLICA_H
+
+#include "src/common/pack.h"
+#include "src/common/slurm_protocol_defs.h"
+
+/*
+ * With SlurmctldParameters=replicate_state, the primary sends each state
+ * file it saves to the standby controllers, which keep the latest copy in
+ * memory and recover from it on takeover instead of reading
+ * StateSaveLocation.
+ */
+
+/*
+ * Send a state file just saved to the standby controllers.
+ * IN name - state file name in StateSaveLocation, e.g. "job_state"
+ * IN buffer - contents of the file as written
+ * NOTE: Call without slurmctld locks, the send is synchronous.
+ */
+extern void state_replica_send(const char *name, buf_t *buffer);
+
+/* Keep a state file sent by the primary, takes ownership of msg */
+extern void state_replica_store(state_replica_msg_t *msg);
+
+/*
+ * Return a copy of the replicated state file state_file, or NULL if there is
+ * none or the file on disk is newer. Free with free_buf().
+ */
+extern buf_t *state_replica_open(const char *state_file);
+
+extern void state_replica_fini(void);
+
+#endif /* !_HAVE_STATE_REPLICA_H */
@@ -117,6 +117,17 @@ extern void schedule_trigger_save(void)
 	slurm_mutex_unlock(&state_save_lock);
 }
 
+/*
+ * Save job state from a separate thread. The job table is normally the
+ * largest, so writing and syncing its file overlaps with packing the
+ * node, partition and reservation tables in the main save thread.
+ */
+static void *_job_state_save(void *no_data)
+{
+	(void) dump_all_job_state();
+	return NULL;
+}
+
 /* shutdown the slurmctld_state_save thread */
 extern void shutdown_state_save(void)
 {
@@ -139,6 +150,8 @@ extern void *slurmctld_state_save(void *no_data)
 	double save_delay;
 	bool run_save;
 	int save_count;
+	pthread_t job_save_tid;
+	bool job_save_active;
 
 #if HAVE_SYS_PRCTL_H
 	if (prctl(PR_SET_NAME, "sstate", NULL, NULL, NULL) < 0) {
@@ -189,16 +202,17 @@ extern void *slurmctld_state_save(void *no_data)
 		if (run_save)
 			(void)dump_all_front_end_state();
 
-		/* save job info if necessary */
-		run_save = false;
+		/* save job info if necessary, joined below */
+		job_save_active = false;
 		slurm_mutex_lock(&state_save_lock);
 		if (save_jobs) {
-			run_save = true;
+			job_save_active = true;
 			save_jobs = 0;
 		}
 		slurm_mutex_unlock(&state_save_lock);
-		if (run_save)
-			(void)dump_all_job_state();
+		if (job_save_active)
+			slurm_thread_create(&job_save_tid, _job_state_save,
+					    NULL);
 
 		/* save node info if necessary */
 		run_save = false;
@@ -243,5 +257,8 @@ extern void *slurmctld_state_save(void *no_data)
 		slurm_mutex_unlock(&state_save_lock);
 		if (run_save)
 			(void)trigger_state_save();
+
+		if (job_save_active)
+			pthread_join(job_save_tid, NULL);
 	}
 }
@@ -47,6 +47,9 @@
 
 extern int retry_list_size(void);
 
+/* Protects the job_launch_* statistics, which are updated without locks */
+static pthread_mutex_t launch_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /* Pack all scheduling statistics */
 extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			  uint16_t protocol_version)
@@ -140,6 +143,45 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			pack32(slurmctld_diag_stats.bf_active, buffer);
 			pack32(slurmctld_diag_stats.backfilled_het_jobs,
 			       buffer);
+
+			if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+				pack64(slurmctld_diag_stats.bf_phase_queue_last,
+				       buffer);
+				pack64(slurmctld_diag_stats.bf_phase_queue_sum,
+				       buffer);
+				pack64(slurmctld_diag_stats.bf_phase_running_last,
+				       buffer);
+				pack64(slurmctld_diag_stats.bf_phase_running_sum,
+				       buffer);
+				pack64(slurmctld_diag_stats.bf_phase_resv_last,
+				       buffer);
+				pack64(slurmctld_diag_stats.bf_phase_resv_sum,
+				       buffer);
+				pack64(slurmctld_diag_stats.bf_phase_sched_last,
+				       buffer);
+				pack64(slurmctld_diag_stats.bf_phase_sched_sum,
+				       buffer);
+				pack64(slurmctld_diag_stats.bf_phase_yield_last,
+				       buffer);
+				pack64(slurmctld_diag_stats.bf_phase_yield_sum,
+				       buffer);
+
+				slurm_mutex_lock(&launch_stats_mutex);
+				pack32(JOB_LAUNCH_STAGE_CNT, buffer);
+				pack32(JOB_LAUNCH_HIST_SIZE, buffer);
+				pack32_array(
+					&slurmctld_diag_stats.job_launch_hist[0][0],
+					JOB_LAUNCH_STAGE_CNT *
+					JOB_LAUNCH_HIST_SIZE, buffer);
+				pack64_array(slurmctld_diag_stats.job_launch_sum,
+					     JOB_LAUNCH_STAGE_CNT, buffer);
+				pack64_array(slurmctld_diag_stats.job_launch_max,
+					     JOB_LAUNCH_STAGE_CNT, buffer);
+				packstr_array(
+					slurmctld_diag_stats.job_launch_max_node,
+					JOB_LAUNCH_STAGE_CNT, buffer);
+				slurm_mutex_unlock(&launch_stats_mutex);
+			}
 		}
 	}
 
@@ -180,6 +222,71 @@ extern void reset_stats(int level)
 	slurmctld_diag_stats.bf_cycle_max = 0;
 	slurmctld_diag_stats.bf_last_depth = 0;
 	slurmctld_diag_stats.bf_last_depth_try = 0;
+	slurmctld_diag_stats.bf_phase_queue_last = 0;
+	slurmctld_diag_stats.bf_phase_queue_sum = 0;
+	slurmctld_diag_stats.bf_phase_running_last = 0;
+	slurmctld_diag_stats.bf_phase_running_sum = 0;
+	slurmctld_diag_stats.bf_phase_resv_last = 0;
+	slurmctld_diag_stats.bf_phase_resv_sum = 0;
+	slurmctld_diag_stats.bf_phase_sched_last = 0;
+	slurmctld_diag_stats.bf_phase_sched_sum = 0;
+	slurmctld_diag_stats.bf_phase_yield_last = 0;
+	slurmctld_diag_stats.bf_phase_yield_sum = 0;
+
+	slurm_mutex_lock(&launch_stats_mutex);
+	memset(slurmctld_diag_stats.job_launch_hist, 0,
+	       sizeof(slurmctld_diag_stats.job_launch_hist));
+	memset(slurmctld_diag_stats.job_launch_sum, 0,
+	       sizeof(slurmctld_diag_stats.job_launch_sum));
+	memset(slurmctld_diag_stats.job_launch_max, 0,
+	       sizeof(slurmctld_diag_stats.job_launch_max));
+	for (int i = 0; i < JOB_LAUNCH_STAGE_CNT; i++)
+		xfree(slurmctld_diag_stats.job_launch_max_node[i]);
+	slurm_mutex_unlock(&launch_stats_mutex);
 
 	last_proc_req_start = time(NULL);
 }
+
+static int _launch_hist_inx(uint64_t msec)
+{
+	int inx = 0;
+
+	while ((msec >>= 1) && (inx < (JOB_LAUNCH_HIST_SIZE - 1)))
+		inx++;
+	return inx;
+}
+
+extern void record_job_launch_stats(job_record_t *job_ptr)
+{
+	uint64_t *launch_time = job_ptr->launch_time;
+	uint64_t prev = launch_time[JOB_LAUNCH_ALLOC];
+
+	if (!launch_time[JOB_LAUNCH_ALLOC] || !launch_time[JOB_LAUNCH_TASK])
+		return;
+
+	slurm_mutex_lock(&launch_stats_mutex);
+	for (int i = 0; i < JOB_LAUNCH_STAGE_CNT; i++) {
+		uint64_t start = prev, end = launch_time[i], msec;
+
+		if (!end)	/* stage skipped, e.g. no prolog */
+			continue;
+		if (i == JOB_LAUNCH_ALLOC)
+			end = launch_time[JOB_LAUNCH_TASK];
+		else
+			prev = end;
+		/* Node and slurmctld clocks may differ slightly */
+		msec = (end > start) ? ((end - start) / 1000) : 0;
+
+		slurmctld_diag_stats.job_launch_hist[i]
+			[_launch_hist_inx(msec)]++;
+		slurmctld_diag_stats.job_launch_sum[i] += msec;
+		if ((msec > slurmctld_diag_stats.job_launch_max[i]) ||
+		    !slurmctld_diag_stats.job_launch_max_node[i]) {
+			slurmctld_diag_stats.job_launch_max[i] = msec;
+			xfree(slurmctld_diag_stats.job_launch_max_node[i]);
+			slurmctld_diag_stats.job_launch_max_node[i] =
+				xstrdup(job_ptr->batch_host);
+		}
+	}
+	slurm_mutex_unlock(&launch_stats_mutex);
+}
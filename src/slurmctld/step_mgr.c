@@ -1665,15 +1665,27 @@ cleanup:
 static int _count_cpus(job_record_t *job_ptr, bitstr_t *bitmap,
 		       uint32_t *usable_cpu_cnt)
 {
-	int i, sum = 0;
+	int i, i_first, i_last, sum = 0;
 	node_record_t *node_ptr;
 
 	if (job_ptr->job_resrcs && job_ptr->job_resrcs->cpus &&
 	    job_ptr->job_resrcs->node_bitmap) {
+		bitstr_t *job_node_bitmap = job_ptr->job_resrcs->node_bitmap;
 		int node_inx = -1;
-		for (i = 0, node_ptr = node_record_table_ptr;
-		     i < node_record_count; i++, node_ptr++) {
-			if (!bit_test(job_ptr->job_resrcs->node_bitmap, i))
+
+		/*
+		 * Only scan the range of nodes in the step bitmap, which is
+		 * often a single node. The job's node index of the first node
+		 * is found by counting the job's nodes before it.
+		 */
+		if ((i_first = bit_ffs(bitmap)) == -1)
+			return sum;
+		i_last = bit_fls(bitmap);
+		if (i_first > 0)
+			node_inx += bit_set_count_range(job_node_bitmap, 0,
+							i_first);
+		for (i = i_first; i <= i_last; i++) {
+			if (!bit_test(job_node_bitmap, i))
 				continue;
 			node_inx++;
 			if (!bit_test(job_ptr->node_bitmap, i) ||
@@ -3134,7 +3146,7 @@ static void _pack_ctld_job_step_info(step_record_t *step_ptr, buf_t *buffer,
 		packstr(node_list, buffer);
 		packstr(step_ptr->name, buffer);
 		packstr(step_ptr->network, buffer);
-		pack_bit_str_hex(pack_bitstr, buffer);
+		pack_bit_str(pack_bitstr, buffer, protocol_version);
 		select_g_select_jobinfo_pack(step_ptr->select_jobinfo, buffer,
 					     protocol_version);
 		packstr(step_ptr->tres_fmt_alloc_str, buffer);
@@ -3187,7 +3199,7 @@ static void _pack_ctld_job_step_info(step_record_t *step_ptr, buf_t *buffer,
 		packstr(node_list, buffer);
 		packstr(step_ptr->name, buffer);
 		packstr(step_ptr->network, buffer);
-		pack_bit_str_hex(pack_bitstr, buffer);
+		pack_bit_str(pack_bitstr, buffer, protocol_version);
 		select_g_select_jobinfo_pack(step_ptr->select_jobinfo, buffer,
 					     protocol_version);
 		packstr(step_ptr->tres_fmt_alloc_str, buffer);
@@ -3522,7 +3534,7 @@ extern void step_set_alloc_tres(step_record_t *step_ptr, uint32_t node_count,
 				bool assoc_mgr_locked, bool make_formatted)
 {
 	uint64_t cpu_count = 1, mem_count = 1;
-	char *tmp_tres_str = NULL;
+	uint64_t *tres_cnt;
 	assoc_mgr_lock_t locks = { .tres = READ_LOCK };
 
 	xassert(step_ptr);
@@ -3545,6 +3557,9 @@ extern void step_set_alloc_tres(step_record_t *step_ptr, uint32_t node_count,
 	if (!assoc_mgr_locked)
 		assoc_mgr_lock(&locks);
 
+	/* Build the counts, the strings are only made from them once */
+	tres_cnt = xcalloc(g_tres_count, sizeof(uint64_t));
+
 	if (((step_ptr->step_id.step_id == SLURM_BATCH_SCRIPT) ||
 	     (step_ptr->step_id.step_id == SLURM_INTERACTIVE_STEP)) &&
 	    step_ptr->job_ptr->job_resrcs) {
@@ -3568,8 +3583,8 @@ extern void step_set_alloc_tres(step_record_t *step_ptr, uint32_t node_count,
 			mem_count = step_ptr->job_ptr->job_resrcs->
 				memory_allocated[0];
 
-		tmp_tres_str = gres_ctld_gres_on_node_as_tres(
-			step_ptr->job_ptr->gres_list, 0, true);
+		gres_ctld_gres_on_node_as_tres_cnt(
+			step_ptr->job_ptr->gres_list, 0, tres_cnt, true);
 	} else {
 		if (!step_ptr->step_layout || !step_ptr->step_layout->task_cnt)
 			cpu_count = (uint64_t)step_ptr->job_ptr->total_cpus;
@@ -3581,29 +3596,21 @@ extern void step_set_alloc_tres(step_record_t *step_ptr, uint32_t node_count,
 			mem_count *= cpu_count;
 		} else
 			mem_count *= node_count;
-		tmp_tres_str = gres_ctld_gres_2_tres_str(
-			step_ptr->gres_list, true);
+		gres_ctld_gres_2_tres_cnt(step_ptr->gres_list, tres_cnt, true);
 	}
 
-	xstrfmtcat(step_ptr->tres_alloc_str,
-		   "%s%u=%"PRIu64",%u=%"PRIu64",%u=%u",
-		   step_ptr->tres_alloc_str ? "," : "",
-		   TRES_CPU, cpu_count,
-		   TRES_MEM, mem_count,
-		   TRES_NODE, node_count);
-
-	if (tmp_tres_str) {
-		xstrfmtcat(step_ptr->tres_alloc_str, "%s%s",
-			   step_ptr->tres_alloc_str ? "," : "",
-			   tmp_tres_str);
-		xfree(tmp_tres_str);
-	}
+	tres_cnt[TRES_ARRAY_CPU] = cpu_count;
+	tres_cnt[TRES_ARRAY_MEM] = mem_count;
+	tres_cnt[TRES_ARRAY_NODE] = node_count;
+
+	step_ptr->tres_alloc_str = assoc_mgr_make_tres_str_from_array(
+		tres_cnt, TRES_STR_FLAG_SIMPLE, true);
 
 	if (make_formatted)
 		step_ptr->tres_fmt_alloc_str =
-			slurmdb_make_tres_string_from_simple(
-				step_ptr->tres_alloc_str, assoc_mgr_tres_list,
-				NO_VAL, CONVERT_NUM_UNIT_EXACT, 0, NULL);
+			assoc_mgr_make_tres_str_from_array(
+				tres_cnt, TRES_STR_CONVERT_UNITS, true);
+	xfree(tres_cnt);
 
 	if (!assoc_mgr_locked)
 		assoc_mgr_unlock(&locks);
@@ -3617,15 +3624,21 @@ static hostlist_t _step_range_to_hostlist(step_record_t *step_ptr,
 					  uint32_t range_first,
 					  uint32_t range_last)
 {
-	int i, node_inx = -1;
+	int i, i_first, i_last, node_inx = -1;
 	hostlist_t hl = hostlist_create(NULL);
 
-	for (i = 0; i < node_record_count; i++) {
+	i_first = bit_ffs(step_ptr->step_node_bitmap);
+	if (i_first >= 0)
+		i_last = bit_fls(step_ptr->step_node_bitmap);
+	else
+		i_last = -2;
+	for (i = i_first; i <= i_last; i++) {
 		if (bit_test(step_ptr->step_node_bitmap, i) == 0)
 			continue;
 		node_inx++;
-		if ((node_inx >= range_first)
-		&&  (node_inx <= range_last)) {
+		if (node_inx > range_last)
+			break;
+		if (node_inx >= range_first) {
 			hostlist_push_host(hl,
 				node_record_table_ptr[i].name);
 		}
@@ -3788,9 +3801,10 @@ extern int dump_job_step_state(void *x, void *arg)
 	pack64(step_ptr->pn_min_memory, buffer);
 	pack32(step_ptr->exit_code, buffer);
 	if (step_ptr->exit_code != NO_VAL) {
-		pack_bit_str_hex(step_ptr->exit_node_bitmap, buffer);
+		pack_bit_str(step_ptr->exit_node_bitmap, buffer,
+			     SLURM_PROTOCOL_VERSION);
 	}
-	pack_bit_str_hex(step_ptr->core_bitmap_job, buffer);
+	pack_bit_str(step_ptr->core_bitmap_job, buffer, SLURM_PROTOCOL_VERSION);
 	pack32(step_ptr->time_limit, buffer);
 	pack32(step_ptr->cpu_freq_min, buffer);
 	pack32(step_ptr->cpu_freq_max, buffer);
@@ -3890,9 +3904,10 @@ extern int load_step_state(job_record_t *job_ptr, buf_t *buffer,
 		safe_unpack64(&pn_min_memory, buffer);
 		safe_unpack32(&exit_code, buffer);
 		if (exit_code != NO_VAL) {
-			unpack_bit_str_hex(&exit_node_bitmap, buffer);
+			unpack_bit_str(&exit_node_bitmap, buffer,
+				       protocol_version);
 		}
-		unpack_bit_str_hex(&core_bitmap_job, buffer);
+		unpack_bit_str(&core_bitmap_job, buffer, protocol_version);
 
 		safe_unpack32(&time_limit, buffer);
 		safe_unpack32(&cpu_freq_min, buffer);
@@ -3961,9 +3976,10 @@ extern int load_step_state(job_record_t *job_ptr, buf_t *buffer,
 		safe_unpack64(&pn_min_memory, buffer);
 		safe_unpack32(&exit_code, buffer);
 		if (exit_code != NO_VAL) {
-			unpack_bit_str_hex(&exit_node_bitmap, buffer);
+			unpack_bit_str(&exit_node_bitmap, buffer,
+				       protocol_version);
 		}
-		unpack_bit_str_hex(&core_bitmap_job, buffer);
+		unpack_bit_str(&core_bitmap_job, buffer, protocol_version);
 
 		safe_unpack32(&time_limit, buffer);
 		safe_unpack32(&cpu_freq_min, buffer);
@@ -0,0 +1,273 @@
+/*****************************************************************************\
+ *  time_event.c - queue of time triggered job events
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <pthread.h>
+
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/xmalloc.h"
+
+#include "src/slurmctld/job_scheduler.h"
+#include "src/slurmctld/locks.h"
+#include "src/slurmctld/slurmctld.h"
+#include "src/slurmctld/time_event.h"
+
+typedef enum {
+	TIME_EVENT_BEGIN,	/* begin_time reached, job may be eligible */
+	TIME_EVENT_DEADLINE,	/* deadline can no longer be met */
+	TIME_EVENT_PURGE,	/* finished job may be purged or re-killed */
+} time_event_type_t;
+
+typedef struct {
+	time_t when;
+	uint32_t job_id;
+	time_event_type_t type;
+} time_event_t;
+
+/*
+ * Binary min-heap on the event time, so the background thread can tell in
+ * O(1) whether anything is due and only touch the jobs which are instead of
+ * scanning the job list for them.
+ */
+typedef struct {
+	time_event_t *ev;
+	int cnt;
+	int size;
+} heap_t;
+
+static pthread_mutex_t event_mutex = PTHREAD_MUTEX_INITIALIZER;
+static heap_t event_heap = { 0 };	/* pending job events */
+static heap_t purge_heap = { 0 };	/* finished jobs, for purge_old_job() */
+
+static void _swap(heap_t *heap, int i, int j)
+{
+	time_event_t tmp = heap->ev[i];
+
+	heap->ev[i] = heap->ev[j];
+	heap->ev[j] = tmp;
+}
+
+static void _push(heap_t *heap, time_t when, uint32_t job_id,
+		  time_event_type_t type)
+{
+	time_event_t *ev;
+	int i;
+
+	slurm_mutex_lock(&event_mutex);
+	if (heap->cnt >= heap->size) {
+		heap->size = MAX(1024, heap->size * 2);
+		xrecalloc(heap->ev, heap->size, sizeof(time_event_t));
+	}
+	ev = heap->ev;
+	i = heap->cnt++;
+	ev[i].when = when;
+	ev[i].job_id = job_id;
+	ev[i].type = type;
+	while (i && (ev[(i - 1) / 2].when > ev[i].when)) {
+		_swap(heap, i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+	slurm_mutex_unlock(&event_mutex);
+}
+
+/* Remove the earliest event into event if it is due by now */
+static bool _pop_due(heap_t *heap, time_t now, time_event_t *event)
+{
+	time_event_t *ev;
+	int i = 0;
+
+	slurm_mutex_lock(&event_mutex);
+	ev = heap->ev;
+	if (!heap->cnt || (ev[0].when > now)) {
+		slurm_mutex_unlock(&event_mutex);
+		return false;
+	}
+	*event = ev[0];
+	ev[0] = ev[--heap->cnt];
+	while (true) {
+		int min = i, l = (2 * i) + 1, r = l + 1;
+
+		if ((l < heap->cnt) && (ev[l].when < ev[min].when))
+			min = l;
+		if ((r < heap->cnt) && (ev[r].when < ev[min].when))
+			min = r;
+		if (min == i)
+			break;
+		_swap(heap, i, min);
+		i = min;
+	}
+	slurm_mutex_unlock(&event_mutex);
+
+	return true;
+}
+
+/*
+ * Time from which deadline_ok() would cancel the pending job, i.e. when
+ * the deadline falls within its minimum run time. 0 if never.
+ */
+static time_t _deadline_time(job_record_t *job_ptr)
+{
+	uint32_t limit;
+
+	if (!job_ptr->deadline || (job_ptr->deadline == NO_VAL))
+		return 0;
+	if (job_ptr->time_min && (job_ptr->time_min != NO_VAL))
+		limit = job_ptr->time_min;
+	else if ((job_ptr->time_limit != NO_VAL) &&
+		 (job_ptr->time_limit != INFINITE))
+		limit = job_ptr->time_limit;
+	else
+		return 0;
+
+	return job_ptr->deadline - (limit * 60) + 1;
+}
+
+/*
+ * Time from which a finished job passes MinJobAge, or a completing one is
+ * due for another kill request, matching _list_find_job_old(). 0 if never.
+ */
+static time_t _purge_time(job_record_t *job_ptr)
+{
+	if (job_ptr->het_job_id)
+		return 0;	/* purged with their leader */
+	if (IS_JOB_COMPLETING(job_ptr))
+		return job_ptr->time_last_active + slurm_conf.kill_wait +
+		       (2 * slurm_conf.msg_timeout) + 1;
+	if (!IS_JOB_FINISHED(job_ptr) || !slurm_conf.min_job_age)
+		return 0;
+	return job_ptr->end_time + slurm_conf.min_job_age;
+}
+
+extern void time_event_job_add(job_record_t *job_ptr)
+{
+	time_t now = time(NULL), when;
+
+	if (!job_ptr->details)
+		return;
+
+	/* Also set on jobs about to be requeued, checked when it fires */
+	if (job_ptr->details->begin_time > now)
+		_push(&event_heap, job_ptr->details->begin_time,
+		      job_ptr->job_id, TIME_EVENT_BEGIN);
+
+	if (IS_JOB_PENDING(job_ptr) && (when = _deadline_time(job_ptr)))
+		_push(&event_heap, MAX(when, now), job_ptr->job_id,
+		      TIME_EVENT_DEADLINE);
+}
+
+extern void time_event_purge_add(job_record_t *job_ptr)
+{
+	time_t when;
+
+	if ((when = _purge_time(job_ptr)))
+		_push(&purge_heap, when, job_ptr->job_id, TIME_EVENT_PURGE);
+}
+
+extern uint32_t time_event_purge_pop(time_t now)
+{
+	time_event_t event;
+
+	if (!_pop_due(&purge_heap, now, &event))
+		return 0;
+	return event.job_id;
+}
+
+extern time_t time_event_next(void)
+{
+	time_t when = 0;
+
+	slurm_mutex_lock(&event_mutex);
+	if (event_heap.cnt)
+		when = event_heap.ev[0].when;
+	slurm_mutex_unlock(&event_mutex);
+
+	return when;
+}
+
+extern void time_event_run(void)
+{
+	time_event_t event;
+	job_record_t *job_ptr;
+	time_t now = time(NULL), when;
+	bool sched = false;
+	int event_cnt = 0;
+
+	xassert(verify_lock(JOB_LOCK, WRITE_LOCK));
+
+	while (_pop_due(&event_heap, now, &event)) {
+		event_cnt++;
+		if (!(job_ptr = find_job_record(event.job_id)) ||
+		    !IS_JOB_PENDING(job_ptr) || !job_ptr->details)
+			continue;
+
+		switch (event.type) {
+		case TIME_EVENT_BEGIN:
+			/* begin_time was moved later since queued */
+			if (job_ptr->details->begin_time > now)
+				_push(&event_heap,
+				      job_ptr->details->begin_time,
+				      event.job_id, TIME_EVENT_BEGIN);
+			else
+				sched = true;
+			break;
+		case TIME_EVENT_DEADLINE:
+			if (!(when = _deadline_time(job_ptr)))
+				break;
+			if (when > now)
+				_push(&event_heap, when, event.job_id,
+				      TIME_EVENT_DEADLINE);
+			else
+				(void) deadline_ok(job_ptr, "time_event");
+			break;
+		default:
+			break;
+		}
+	}
+
+	if (event_cnt)
+		debug2("%s: processed %d events", __func__, event_cnt);
+
+	/* Start jobs as their begin time passes, not at the next full pass */
+	if (sched)
+		queue_job_scheduler();
+}
+
+extern void time_event_fini(void)
+{
+	slurm_mutex_lock(&event_mutex);
+	xfree(event_heap.ev);
+	event_heap.cnt = event_heap.size = 0;
+	xfree(purge_heap.ev);
+	purge_heap.cnt = purge_heap.size = 0;
+	slurm_mutex_unlock(&event_mutex);
+}
@@ -0,0 +1,76 @@
+/*****************************************************************************\
+ *  time_event.h - queue of time triggered job events
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _HAVE_TIME_EVENT_H
+#define _HAVE_TIME_EVENT_H
+
+#include <time.h>
+
+#include "src/slurmctld/slurmctld.h"
+
+/*
+ * Queue the time triggered events of a job: its begin time (including the
+ * next run of a scrontab entry) and the time a pending job can no longer
+ * meet its deadline. Call whenever either may have changed.
+ * Entries are validated against the job when they fire, so stale or
+ * duplicate entries are harmless.
+ * NOTE: Call with the job write lock held.
+ */
+extern void time_event_job_add(job_record_t *job_ptr);
+
+/*
+ * Queue a finished or completing job for purge_old_job(), at the time it
+ * passes MinJobAge or is due for another kill request. Call when the job
+ * finishes and when its completion is done.
+ * NOTE: Call with the job write lock held.
+ */
+extern void time_event_purge_add(job_record_t *job_ptr);
+
+/*
+ * Return the id of a job queued by time_event_purge_add() which is due by
+ * now, or 0 if there are none. The job must be checked again by the caller.
+ */
+extern uint32_t time_event_purge_pop(time_t now);
+
+/* Time of the earliest queued event, or 0 if none */
+extern time_t time_event_next(void);
+
+/*
+ * Process the events which are due.
+ * NOTE: Call with the same locks as job_time_limit().
+ */
+extern void time_event_run(void);
+
+extern void time_event_fini(void);
+
+#endif /* !_HAVE_TIME_EVENT_H */
@@ -61,6 +61,7 @@
 
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/slurmctld.h"
+#include "src/slurmctld/state_replica.h"
 #include "src/slurmctld/state_save.h"
 #include "src/slurmctld/trigger_mgr.h"
 
@@ -92,6 +93,10 @@ static bool trigger_pri_dbd_res_op = false;
 static bool trigger_pri_db_fail = false;
 static bool trigger_pri_db_res_op = false;
 
+/* Nodes idle since idle_min_time, shared by IDLE triggers with one offset */
+static bitstr_t *trigger_idle_nodes_bitmap = NULL;
+static time_t trigger_idle_min_time = 0;
+
 /* Current trigger pull states (saved and restored) */
 uint8_t ctld_failure = 0;
 uint8_t bu_ctld_failure = 0;
@@ -890,6 +895,8 @@ extern int trigger_state_save(void)
 	xfree(reg_file);
 	xfree(new_file);
 	unlock_state_files();
+	if (!error_code)
+		state_replica_send("trigger_state", buffer);
 	free_buf(buffer);
 	return error_code;
 }
@@ -904,6 +911,8 @@ static buf_t *_open_trigger_state_file(char **state_file)
 
 	*state_file = xstrdup(slurm_conf.state_save_location);
 	xstrcat(*state_file, "/trigger_state");
+	if ((buf = state_replica_open(*state_file)))
+		return buf;
 	if (!(buf = create_mmap_buf(*state_file)))
 		error("Could not open trigger state file %s: %m",
 		      *state_file);
@@ -994,8 +1003,12 @@ static bool _front_end_job_test(bitstr_t *front_end_bitmap,
 	return false;
 }
 
-/* Test if the event has been triggered, change trigger state as needed */
-static void _trigger_job_event(trig_mgr_info_t *trig_in, time_t now)
+/*
+ * Test if the event has been triggered, change trigger state as needed
+ * IN events - TRIGGER_TYPE_* node and front end events of this pass
+ */
+static void _trigger_job_event(trig_mgr_info_t *trig_in, time_t now,
+			       uint32_t events)
 {
 	job_record_t *job_ptr;
 	xassert(verify_lock(JOB_LOCK, READ_LOCK));
@@ -1031,7 +1044,7 @@ static void _trigger_job_event(trig_mgr_info_t *trig_in, time_t now)
 		}
 	}
 
-	if (trig_in->trig_type & TRIGGER_TYPE_DOWN) {
+	if (trig_in->trig_type & events & TRIGGER_TYPE_DOWN) {
 		if (_front_end_job_test(trigger_down_front_end_bitmap,
 					job_ptr)) {
 			log_flag(TRIGGERS, "trigger[%u] for job %u down",
@@ -1043,7 +1056,7 @@ static void _trigger_job_event(trig_mgr_info_t *trig_in, time_t now)
 		}
 	}
 
-	if (trig_in->trig_type & TRIGGER_TYPE_DOWN) {
+	if (trig_in->trig_type & events & TRIGGER_TYPE_DOWN) {
 		if (trigger_down_nodes_bitmap &&
 		    bit_overlap_any(job_ptr->node_bitmap,
 				    trigger_down_nodes_bitmap)) {
@@ -1056,7 +1069,7 @@ static void _trigger_job_event(trig_mgr_info_t *trig_in, time_t now)
 		}
 	}
 
-	if (trig_in->trig_type & TRIGGER_TYPE_FAIL) {
+	if (trig_in->trig_type & events & TRIGGER_TYPE_FAIL) {
 		if (trigger_fail_nodes_bitmap &&
 		    bit_overlap_any(job_ptr->node_bitmap,
 				    trigger_fail_nodes_bitmap)) {
@@ -1069,7 +1082,7 @@ static void _trigger_job_event(trig_mgr_info_t *trig_in, time_t now)
 		}
 	}
 
-	if (trig_in->trig_type & TRIGGER_TYPE_UP) {
+	if (trig_in->trig_type & events & TRIGGER_TYPE_UP) {
 		if (trigger_up_nodes_bitmap &&
 		    bit_overlap_any(job_ptr->node_bitmap,
 				    trigger_up_nodes_bitmap)) {
@@ -1227,30 +1240,37 @@ static void _trigger_node_event(trig_mgr_info_t *trig_in, time_t now)
 		time_t min_idle = now - (trig_in->trig_time - 0x8000);
 		int i;
 		node_record_t *node_ptr = node_record_table_ptr;
-		bitstr_t *trigger_idle_node_bitmap;
 
-		trigger_idle_node_bitmap = bit_alloc(node_record_count);
-		for (i = 0; i < node_record_count; i++, node_ptr++) {
-			if (!IS_NODE_IDLE(node_ptr) ||
-			    (node_ptr->last_idle > min_idle))
-				continue;
-			bit_set(trigger_idle_node_bitmap, i);
+		/* Triggers usually share an offset, so reuse the last scan */
+		if (!trigger_idle_nodes_bitmap ||
+		    (trigger_idle_min_time != min_idle)) {
+			if (!trigger_idle_nodes_bitmap)
+				trigger_idle_nodes_bitmap =
+					bit_alloc(node_record_count);
+			else
+				bit_clear_all(trigger_idle_nodes_bitmap);
+			for (i = 0; i < node_record_count; i++, node_ptr++) {
+				if (!IS_NODE_IDLE(node_ptr) ||
+				    (node_ptr->last_idle > min_idle))
+					continue;
+				bit_set(trigger_idle_nodes_bitmap, i);
+			}
+			trigger_idle_min_time = min_idle;
 		}
 		if (trig_in->nodes_bitmap == NULL) {    /* all nodes */
 			xfree(trig_in->res_id);
 			trig_in->res_id = bitmap2node_name(
-					  trigger_idle_node_bitmap);
+					  trigger_idle_nodes_bitmap);
 			trig_in->state = 1;
 		} else if (bit_overlap_any(trig_in->nodes_bitmap,
-					   trigger_idle_node_bitmap)) {
+					   trigger_idle_nodes_bitmap)) {
 			bit_and(trig_in->nodes_bitmap,
-				trigger_idle_node_bitmap);
+				trigger_idle_nodes_bitmap);
 			xfree(trig_in->res_id);
 			trig_in->res_id = bitmap2node_name(
 					  trig_in->nodes_bitmap);
 			trig_in->state = 1;
 		}
-		FREE_NULL_BITMAP(trigger_idle_node_bitmap);
 		if (trig_in->state == 1) {
 			trig_in->trig_time = now;
 			log_flag(TRIGGERS, "trigger[%u] for node %s idle",
@@ -1498,6 +1518,78 @@ static void _trigger_run_program(trig_mgr_info_t *trig_in)
 		xfree(args[i]);
 }
 
+static bool _bitmap_any(bitstr_t *bitmap)
+{
+	return (bitmap && (bit_ffs(bitmap) != -1));
+}
+
+/*
+ * Return the TRIGGER_TYPE_* events which occurred since the last pass, so
+ * that pending triggers which can not fire are skipped without testing their
+ * nodes or jobs. IDLE is time based and can fire at any pass.
+ */
+static uint32_t _node_events(void)
+{
+	uint32_t events = TRIGGER_TYPE_IDLE;
+
+	if (_bitmap_any(trigger_down_nodes_bitmap))
+		events |= TRIGGER_TYPE_DOWN;
+	if (_bitmap_any(trigger_drained_nodes_bitmap))
+		events |= TRIGGER_TYPE_DRAINED;
+	if (_bitmap_any(trigger_fail_nodes_bitmap))
+		events |= TRIGGER_TYPE_FAIL;
+	if (_bitmap_any(trigger_up_nodes_bitmap))
+		events |= TRIGGER_TYPE_UP;
+	if (trigger_node_reconfig)
+		events |= TRIGGER_TYPE_RECONFIG;
+
+	return events;
+}
+
+static uint32_t _front_end_events(void)
+{
+	uint32_t events = 0;
+
+	if (_bitmap_any(trigger_down_front_end_bitmap))
+		events |= TRIGGER_TYPE_DOWN;
+	if (_bitmap_any(trigger_up_front_end_bitmap))
+		events |= TRIGGER_TYPE_UP;
+
+	return events;
+}
+
+static uint32_t _other_events(void)
+{
+	uint32_t events = 0;
+
+	if (trigger_bb_error)
+		events |= TRIGGER_TYPE_BURST_BUFFER;
+	if (trigger_pri_ctld_fail)
+		events |= TRIGGER_TYPE_PRI_CTLD_FAIL;
+	if (trigger_pri_ctld_res_op)
+		events |= TRIGGER_TYPE_PRI_CTLD_RES_OP;
+	if (trigger_pri_ctld_res_ctrl)
+		events |= TRIGGER_TYPE_PRI_CTLD_RES_CTRL;
+	if (trigger_pri_ctld_acct_buffer_full)
+		events |= TRIGGER_TYPE_PRI_CTLD_ACCT_FULL;
+	if (trigger_bu_ctld_fail)
+		events |= TRIGGER_TYPE_BU_CTLD_FAIL;
+	if (trigger_bu_ctld_res_op)
+		events |= TRIGGER_TYPE_BU_CTLD_RES_OP;
+	if (trigger_bu_ctld_as_ctrl)
+		events |= TRIGGER_TYPE_BU_CTLD_AS_CTRL;
+	if (trigger_pri_dbd_fail)
+		events |= TRIGGER_TYPE_PRI_DBD_FAIL;
+	if (trigger_pri_dbd_res_op)
+		events |= TRIGGER_TYPE_PRI_DBD_RES_OP;
+	if (trigger_pri_db_fail)
+		events |= TRIGGER_TYPE_PRI_DB_FAIL;
+	if (trigger_pri_db_res_op)
+		events |= TRIGGER_TYPE_PRI_DB_RES_OP;
+
+	return events;
+}
+
 static void _clear_event_triggers(void)
 {
 	if (trigger_down_front_end_bitmap) {
@@ -1520,6 +1612,7 @@ static void _clear_event_triggers(void)
 		bit_nclear(trigger_up_nodes_bitmap,
 			   0, (bit_size(trigger_up_nodes_bitmap) - 1));
 	}
+	FREE_NULL_BITMAP(trigger_idle_nodes_bitmap);
 	trigger_node_reconfig = false;
 	trigger_bb_error = false;
 	trigger_pri_ctld_fail = false;
@@ -1570,18 +1663,37 @@ extern void trigger_process(void)
 	bool state_change = false;
 	pid_t rc;
 	int prog_stat;
+	uint32_t events[TRIGGER_RES_TYPE_OTHER + 1] = { 0 };
 
 	slurm_mutex_lock(&trigger_mutex);
 	if (trigger_list == NULL)
 		trigger_list = list_create(_trig_del);
 
+	events[TRIGGER_RES_TYPE_NODE] = _node_events();
+	events[TRIGGER_RES_TYPE_FRONT_END] = _front_end_events();
+	events[TRIGGER_RES_TYPE_JOB] = events[TRIGGER_RES_TYPE_NODE] |
+				       events[TRIGGER_RES_TYPE_FRONT_END];
+	events[TRIGGER_RES_TYPE_SLURMCTLD] = _other_events();
+	events[TRIGGER_RES_TYPE_SLURMDBD] = events[TRIGGER_RES_TYPE_SLURMCTLD];
+	events[TRIGGER_RES_TYPE_DATABASE] = events[TRIGGER_RES_TYPE_SLURMCTLD];
+	events[TRIGGER_RES_TYPE_OTHER] = events[TRIGGER_RES_TYPE_SLURMCTLD];
+
 	trig_iter = list_iterator_create(trigger_list);
 	while ((trig_in = list_next(trig_iter))) {
-		if (trig_in->state == 0) {
+		/*
+		 * Skip pending triggers none of whose events occurred. Job
+		 * triggers are always tested as the job may end at any time.
+		 */
+		if ((trig_in->state == 0) &&
+		    (trig_in->res_type <= TRIGGER_RES_TYPE_OTHER) &&
+		    ((trig_in->res_type == TRIGGER_RES_TYPE_JOB) ||
+		     (trig_in->trig_type & events[trig_in->res_type]))) {
 			if (trig_in->res_type == TRIGGER_RES_TYPE_OTHER)
 				_trigger_other_event(trig_in, now);
 			else if (trig_in->res_type == TRIGGER_RES_TYPE_JOB)
-				_trigger_job_event(trig_in, now);
+				_trigger_job_event(
+					trig_in, now,
+					events[TRIGGER_RES_TYPE_JOB]);
 			else if (trig_in->res_type == TRIGGER_RES_TYPE_NODE)
 				_trigger_node_event(trig_in, now);
 			else if (trig_in->res_type ==
@@ -1597,6 +1709,7 @@ extern void trigger_process(void)
 				 TRIGGER_RES_TYPE_FRONT_END)
 			 	_trigger_front_end_event(trig_in, now);
 		}
+
 		if ((trig_in->state == 1) &&
 		    (trig_in->trig_time <= now)) {
 			log_flag(TRIGGERS, "launching program for trigger[%u]: uid=%u gid=%u program=%s arg=%s",
@@ -1671,4 +1784,5 @@ extern void trigger_fini(void)
 	FREE_NULL_BITMAP(trigger_drained_nodes_bitmap);
 	FREE_NULL_BITMAP(trigger_fail_nodes_bitmap);
 	FREE_NULL_BITMAP(trigger_up_nodes_bitmap);
+	FREE_NULL_BITMAP(trigger_idle_nodes_bitmap);
 }
@@ -0,0 +1,166 @@
+/*****************************************************************************\
+ *  node_counters.c - node wide counters shared by the slurmstepds of a node
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "slurm/slurm_errno.h"
+
+#include "src/common/log.h"
+#include "src/common/xassert.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "src/slurmd/common/node_counters.h"
+
+#define NODE_COUNTERS_VERSION 1
+
+/* Layout of the mapped file */
+typedef struct {
+	uint32_t version;
+	uint32_t cnt;
+	time_t sample_time;	/* 0 if never sampled */
+	uint64_t counters[];
+} node_counters_shm_t;
+
+struct node_counters {
+	int fd;
+	int cnt;
+	char *path;
+	size_t size;
+	node_counters_shm_t *shm;
+};
+
+extern node_counters_t *node_counters_open(const char *dir, const char *name,
+					   int cnt)
+{
+	node_counters_t *nc;
+	struct stat st;
+
+	if (!dir || !name || (cnt <= 0))
+		return NULL;
+
+	nc = xmalloc(sizeof(*nc));
+	nc->cnt = cnt;
+	nc->size = sizeof(node_counters_shm_t) + (cnt * sizeof(uint64_t));
+	nc->path = xstrdup_printf("%s/node_counters_%s", dir, name);
+
+	if ((nc->fd = open(nc->path, O_RDWR | O_CREAT | O_CLOEXEC,
+			   S_IRUSR | S_IWUSR)) < 0) {
+		debug("%s: open(%s): %m", __func__, nc->path);
+		goto fail;
+	}
+
+	if (flock(nc->fd, LOCK_EX) < 0) {
+		debug("%s: flock(%s): %m", __func__, nc->path);
+		goto fail;
+	}
+	if ((fstat(nc->fd, &st) < 0) ||
+	    ((st.st_size != nc->size) && (ftruncate(nc->fd, nc->size) < 0))) {
+		debug("%s: can't size %s: %m", __func__, nc->path);
+		goto fail;
+	}
+	nc->shm = mmap(NULL, nc->size, PROT_READ | PROT_WRITE, MAP_SHARED,
+		       nc->fd, 0);
+	if (nc->shm == MAP_FAILED) {
+		nc->shm = NULL;
+		debug("%s: mmap(%s): %m", __func__, nc->path);
+		goto fail;
+	}
+	/* New file or left by another version, start over */
+	if ((nc->shm->version != NODE_COUNTERS_VERSION) ||
+	    (nc->shm->cnt != cnt)) {
+		memset(nc->shm, 0, nc->size);
+		nc->shm->version = NODE_COUNTERS_VERSION;
+		nc->shm->cnt = cnt;
+	}
+	(void) flock(nc->fd, LOCK_UN);
+
+	return nc;
+
+fail:
+	node_counters_close(nc);
+	return NULL;
+}
+
+extern int node_counters_get(node_counters_t *nc, int max_age,
+			     node_counters_read_f read_f, uint64_t *counters,
+			     time_t *sample_time)
+{
+	time_t now = time(NULL);
+	int rc = SLURM_SUCCESS;
+
+	xassert(nc && nc->shm);
+
+	/* Held while sampling, so the other steps wait and reuse it */
+	if (flock(nc->fd, LOCK_EX) < 0) {
+		debug("%s: flock(%s): %m", __func__, nc->path);
+		return read_f(counters, nc->cnt);
+	}
+
+	if (!nc->shm->sample_time || (now < nc->shm->sample_time) ||
+	    ((now - nc->shm->sample_time) >= max_age)) {
+		if ((rc = read_f(nc->shm->counters, nc->cnt)) ==
+		    SLURM_SUCCESS)
+			nc->shm->sample_time = now;
+		else
+			nc->shm->sample_time = 0;
+	}
+	if (rc == SLURM_SUCCESS) {
+		memcpy(counters, nc->shm->counters,
+		       nc->cnt * sizeof(uint64_t));
+		if (sample_time)
+			*sample_time = nc->shm->sample_time;
+	}
+
+	(void) flock(nc->fd, LOCK_UN);
+
+	return rc;
+}
+
+extern void node_counters_close(node_counters_t *nc)
+{
+	if (!nc)
+		return;
+
+	if (nc->shm)
+		munmap(nc->shm, nc->size);
+	if (nc->fd >= 0)
+		close(nc->fd);
+	xfree(nc->path);
+	xfree(nc);
+}
@@ -0,0 +1,73 @@
+/*****************************************************************************\
+ *  node_counters.h - node wide counters shared by the slurmstepds of a node
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _NODE_COUNTERS_H
+#define _NODE_COUNTERS_H
+
+#include <inttypes.h>
+#include <time.h>
+
+/*
+ * Cache of cumulative node wide counters (e.g. interconnect port or
+ * filesystem client statistics) in a file mapped by every slurmstepd of
+ * the node. The first step wanting a sample newer than max_age reads the
+ * counters, the others reuse its sample, so the reads per node do not grow
+ * with the number of steps. Each step keeps its own previous values to
+ * work out what changed since its last sample.
+ */
+typedef struct node_counters node_counters_t;
+
+/* Read cnt cumulative counters into counters, RET SLURM_SUCCESS or error */
+typedef int (*node_counters_read_f)(uint64_t *counters, int cnt);
+
+/*
+ * Open or create the cache of cnt counters named name in directory dir
+ * (SlurmdSpoolDir). RET cache or NULL if it can't be used, in which case
+ * the counters should be read directly.
+ */
+extern node_counters_t *node_counters_open(const char *dir, const char *name,
+					   int cnt);
+
+/*
+ * Fill in counters with the cached sample if it is less than max_age
+ * seconds old, else with a new one taken by read_f and stored in the cache.
+ * OUT sample_time - time of the sample, may be NULL
+ * RET SLURM_SUCCESS or error of read_f
+ */
+extern int node_counters_get(node_counters_t *nc, int max_age,
+			     node_counters_read_f read_f, uint64_t *counters,
+			     time_t *sample_time);
+
+extern void node_counters_close(node_counters_t *nc);
+
+#endif /* !_NODE_COUNTERS_H */
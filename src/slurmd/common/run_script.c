@@ -43,9 +43,11 @@
 #include <string.h>
 #include <sys/errno.h>
 #include <sys/wait.h>
+#include <time.h>
 
 #include "slurm/slurm_errno.h"
 #include "src/common/list.h"
+#include "src/common/timers.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
@@ -93,27 +95,19 @@ int waitpid_timeout (const char *name, pid_t pid, int *pstatus, int timeout)
 }
 
 /*
- * Run a prolog or epilog script (does NOT drop privileges)
+ * Start a prolog or epilog script in its own process group
+ * (does NOT drop privileges)
  * name IN: class of program (prolog, epilog, etc.),
  * path IN: pathname of program to run
  * job_id IN: info on associated job
- * max_wait IN: maximum time to wait in seconds, -1 for no limit
- * env IN: environment variables to use on exec, sets minimal environment
- *	if NULL
- * uid IN: user ID of job owner
- * RET 0 on success, -1 on failure.
+ * env IN: environment variables to use on exec
+ * RET pid of the child on success, -1 on failure.
  */
-static int
-_run_one_script(const char *name, const char *path, uint32_t job_id,
-		int max_wait, char **env, uid_t uid)
+static pid_t _fork_one_script(const char *name, const char *path,
+			      uint32_t job_id, char **env)
 {
-	int status;
 	pid_t cpid;
 
-	xassert(env);
-	if (path == NULL || path[0] == '\0')
-		return 0;
-
 	if (job_id) {
 		debug("[job %u] attempting to run %s [%s]",
 			job_id, name, path);
@@ -151,11 +145,94 @@ _run_one_script(const char *name, const char *path, uint32_t job_id,
 		_exit(127);
 	}
 
+	return cpid;
+}
+
+/*
+ * Run a prolog or epilog script (does NOT drop privileges)
+ * name IN: class of program (prolog, epilog, etc.),
+ * path IN: pathname of program to run
+ * job_id IN: info on associated job
+ * max_wait IN: maximum time to wait in seconds, -1 for no limit
+ * env IN: environment variables to use on exec, sets minimal environment
+ *	if NULL
+ * uid IN: user ID of job owner
+ * RET 0 on success, -1 on failure.
+ */
+static int
+_run_one_script(const char *name, const char *path, uint32_t job_id,
+		int max_wait, char **env, uid_t uid)
+{
+	int status;
+	pid_t cpid;
+
+	xassert(env);
+	if (path == NULL || path[0] == '\0')
+		return 0;
+
+	if ((cpid = _fork_one_script(name, path, job_id, env)) < 0)
+		return -1;
+
 	if (waitpid_timeout(name, cpid, &status, max_wait) < 0)
 		return (-1);
 	return status;
 }
 
+/*
+ * Start every script in list l at once, then reap them all. max_wait
+ * bounds the whole set rather than each script, so a slow script does
+ * not extend the time left for the ones reaped after it.
+ * RET 0 if every script succeeded, otherwise the status of the first
+ *	failed script found.
+ */
+static int _run_scripts_parallel(const char *name, List l, uint32_t job_id,
+				 int max_wait, char **env)
+{
+	int cnt = list_count(l), i = 0, rc = 0, status, wait_time;
+	pid_t *cpids = xcalloc(cnt, sizeof(pid_t));
+	char **paths = xcalloc(cnt, sizeof(char *));
+	time_t start = time(NULL);
+	ListIterator itr;
+	char *s;
+	DEF_TIMERS;
+
+	xassert(env);
+	START_TIMER;
+	itr = list_iterator_create(l);
+	while ((s = list_next(itr))) {
+		paths[i] = s;
+		cpids[i++] = _fork_one_script(name, s, job_id, env);
+	}
+	list_iterator_destroy(itr);
+
+	for (i = 0; i < cnt; i++) {
+		if (cpids[i] < 0) {
+			status = -1;
+		} else {
+			wait_time = max_wait;
+			if (max_wait > 0)
+				wait_time = MAX(1, max_wait -
+						   (time(NULL) - start));
+			if (waitpid_timeout(name, cpids[i], &status,
+					    wait_time) < 0)
+				status = -1;
+			END_TIMER;
+			debug("%s: %s finished within %s",
+			      name, paths[i], TIME_STR);
+		}
+		if (status) {
+			error("%s: exited with status 0x%04x",
+			      paths[i], status);
+			if (!rc)
+				rc = status;
+		}
+	}
+
+	xfree(cpids);
+	xfree(paths);
+	return rc;
+}
+
 static int _ef (const char *p, int errnum)
 {
 	return error ("run_script: glob: %s: %s", p, strerror (errno));
@@ -196,12 +273,13 @@ static List _script_list_create (const char *pattern)
 }
 
 int run_script(const char *name, const char *pattern, uint32_t job_id,
-	       int max_wait, char **env, uid_t uid)
+	       int max_wait, char **env, uid_t uid, bool parallel)
 {
 	int rc = 0;
 	List l;
 	ListIterator i;
 	char *s;
+	DEF_TIMERS;
 
 	if (pattern == NULL || pattern[0] == '\0')
 		return 0;
@@ -210,9 +288,18 @@ int run_script(const char *name, const char *pattern, uint32_t job_id,
 	if (l == NULL)
 		return error ("Unable to run %s [%s]", name, pattern);
 
+	if (parallel && (list_count(l) > 1)) {
+		rc = _run_scripts_parallel(name, l, job_id, max_wait, env);
+		FREE_NULL_LIST(l);
+		return rc;
+	}
+
 	i = list_iterator_create (l);
 	while ((s = list_next (i))) {
+		START_TIMER;
 		rc = _run_one_script (name, s, job_id, max_wait, env, uid);
+		END_TIMER;
+		debug("%s: %s finished in %s", name, s, TIME_STR);
 		if (rc) {
 			error ("%s: exited with status 0x%04x", s, rc);
 			break;
@@ -39,6 +39,7 @@
 #ifndef _RUN_SCRIPT_H
 #define _RUN_SCRIPT_H
 
+#include <stdbool.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <inttypes.h>
@@ -63,9 +64,11 @@ int waitpid_timeout (const char *name, pid_t pid, int *pstatus, int timeout);
  * env IN: environment variables to use on exec, sets minimal environment 
  *	if NULL
  * uid IN: user ID of job owner
+ * parallel IN: if path matches several programs, start them all at once
+ *	rather than one after another
  * RET 0 on success, -1 on failure.
  */
 int run_script(const char *name, const char *path, uint32_t jobid, 
-	       int max_wait, char **env, uid_t uid);
+	       int max_wait, char **env, uid_t uid, bool parallel);
 
 #endif /* _RUN_SCRIPT_H */
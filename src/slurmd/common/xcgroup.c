@@ -57,7 +57,7 @@
 #include "xcgroup.h"
 
 /* internal functions */
-size_t _file_getsize(int fd);
+ssize_t _file_read_all(int fd, char **pbuf);
 int _file_read_uint32s(char* file_path, uint32_t** pvalues, int* pnb);
 int _file_write_uint32s(char* file_path, uint32_t* values, int nb);
 int _file_read_uint64s(char* file_path, uint64_t** pvalues, int* pnb);
@@ -1095,36 +1095,42 @@ endit:
  * -----------------------------------------------------------------------------
  */
 
-size_t _file_getsize(int fd)
+/*
+ * Read everything left in fd into a NUL terminated xmalloc'd buffer.
+ *
+ * The buffer starts at one page and is doubled as needed, so the usual cgroup
+ * file is read with a single read() instead of first being walked one byte
+ * per syscall to size it and then read a second time. This also can't be
+ * fooled by the content changing between the sizing and the real read.
+ *
+ * RET number of bytes read (*pbuf set) or -1 on error (*pbuf untouched)
+ */
+ssize_t _file_read_all(int fd, char **pbuf)
 {
-	int rc;
-	size_t fsize;
-	off_t offset;
-	char c;
-
-	/* store current position and rewind */
-	offset = lseek(fd, 0, SEEK_CUR);
-	if (offset < 0)
-		return -1;
-	if (lseek(fd, 0, SEEK_SET) < 0)
-		error("%s: lseek(0): %m", __func__);
-
-	/* get file size */
-	fsize = 0;
-	do {
-		rc = read(fd, (void*)&c, 1);
-		if (rc > 0)
-			fsize++;
-	} while ((rc < 0 && errno == EINTR) || rc > 0);
+	size_t bufsize = 4096, len = 0;
+	char *buf = xmalloc(bufsize);
+	ssize_t rc;
 
-	/* restore position */
-	if (lseek(fd, offset, SEEK_SET) < 0)
-		error("%s: lseek(): %m", __func__);
+	while (1) {
+		rc = read(fd, buf + len, bufsize - len - 1);
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			xfree(buf);
+			return -1;
+		}
+		if (!rc)
+			break;
+		len += rc;
+		if (len == (bufsize - 1)) {
+			bufsize *= 2;
+			xrealloc(buf, bufsize);
+		}
+	}
+	buf[len] = '\0';
 
-	if (rc < 0)
-		return -1;
-	else
-		return fsize;
+	*pbuf = buf;
+	return len;
 }
 
 int _file_write_uint64s(char* file_path, uint64_t* values, int nb)
@@ -1182,7 +1188,6 @@ int _file_read_uint64s(char* file_path, uint64_t** pvalues, int* pnb)
 	int rc;
 	int fd;
 
-	size_t fsize;
 	char* buf;
 	char* p;
 
@@ -1201,20 +1206,11 @@ int _file_read_uint64s(char* file_path, uint64_t** pvalues, int* pnb)
 		return XCGROUP_ERROR;
 	}
 
-	/* get file size */
-	fsize=_file_getsize(fd);
-	if (fsize == -1) {
-		close(fd);
-		return XCGROUP_ERROR;
-	}
-
 	/* read file contents */
-	buf = xmalloc(fsize + 1);
-	do {
-		rc = read(fd, buf, fsize);
-	} while (rc < 0 && errno == EINTR);
+	rc = _file_read_all(fd, &buf);
 	close(fd);
-	buf[fsize]='\0';
+	if (rc < 0)
+		return XCGROUP_ERROR;
 
 	/* count values (splitted by \n) */
 	i=0;
@@ -1291,7 +1287,6 @@ int _file_read_uint32s(char* file_path, uint32_t** pvalues, int* pnb)
 	int rc;
 	int fd;
 
-	size_t fsize;
 	char* buf;
 	char* p;
 
@@ -1310,20 +1305,11 @@ int _file_read_uint32s(char* file_path, uint32_t** pvalues, int* pnb)
 		return XCGROUP_ERROR;
 	}
 
-	/* get file size */
-	fsize =_file_getsize(fd);
-	if (fsize == -1) {
-		close(fd);
-		return XCGROUP_ERROR;
-	}
-
 	/* read file contents */
-	buf = xmalloc(fsize + 1);
-	do {
-		rc = read(fd, buf, fsize);
-	} while (rc < 0 && errno == EINTR);
+	rc = _file_read_all(fd, &buf);
 	close(fd);
-	buf[fsize]='\0';
+	if (rc < 0)
+		return XCGROUP_ERROR;
 
 	/* count values (splitted by \n) */
 	i=0;
@@ -1386,7 +1372,6 @@ int _file_read_content(char* file_path, char** content, size_t *csize)
 	int fstatus;
 	int rc;
 	int fd;
-	size_t fsize;
 	char* buf;
 
 	fstatus = XCGROUP_ERROR;
@@ -1403,27 +1388,14 @@ int _file_read_content(char* file_path, char** content, size_t *csize)
 		return fstatus;
 	}
 
-	/* get file size */
-	fsize=_file_getsize(fd);
-	if (fsize == -1) {
-		close(fd);
-		return fstatus;
-	}
-
 	/* read file contents */
-	buf = xmalloc(fsize + 1);
-	buf[fsize]='\0';
-	do {
-		rc = read(fd, buf, fsize);
-	} while (rc < 0 && errno == EINTR);
+	rc = _file_read_all(fd, &buf);
 
 	/* set output values */
 	if (rc >= 0) {
 		*content = buf;
 		*csize = rc;
 		fstatus = XCGROUP_SUCCESS;
-	} else {
-		xfree(buf);
 	}
 
 	/* close file */
@@ -46,10 +46,12 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/utsname.h>
 
 #include "slurm/slurm.h"
 #include "slurm/slurm_errno.h"
 #include "src/common/log.h"
+#include "src/common/macros.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
@@ -166,6 +168,184 @@ static inline int _internal_hwloc_topology_export_xml(
 #endif
 }
 
+/* First line of a file, without the newline, or NULL. Must xfree() */
+static char *_read_line(const char *path)
+{
+	char buf[1024], *nl;
+	FILE *fp;
+
+	if (!(fp = fopen(path, "r")))
+		return NULL;
+	if (!fgets(buf, sizeof(buf), fp)) {
+		fclose(fp);
+		return NULL;
+	}
+	fclose(fp);
+	if ((nl = strchr(buf, '\n')))
+		*nl = '\0';
+
+	return xstrdup(buf);
+}
+
+/*
+ * Identify the hardware a whole system topology was exported from: kernel,
+ * hwloc version, online CPUs and NUMA nodes and the board. slurmd reuses
+ * the exported file at startup while this is unchanged. Must xfree()
+ */
+static char *_topo_id(void)
+{
+	struct utsname uts;
+	char *cpus, *nodes, *board, *id = NULL;
+
+	if (uname(&uts) < 0)
+		return NULL;
+
+	cpus = _read_line("/sys/devices/system/cpu/online");
+	nodes = _read_line("/sys/devices/system/node/online");
+	board = _read_line("/sys/class/dmi/id/product_uuid");
+
+	if (cpus)
+		id = xstrdup_printf("release=%s hwloc=0x%x cpus=%s nodes=%s board=%s",
+				    uts.release, HWLOC_API_VERSION, cpus,
+				    nodes ? nodes : "", board ? board : "");
+	xfree(cpus);
+	xfree(nodes);
+	xfree(board);
+
+	return id;
+}
+
+static char *_topo_objs(hwloc_topology_t topology)
+{
+	return xstrdup_printf("sockets=%d cores=%d pus=%d",
+			      hwloc_get_nbobjs_by_type(topology,
+						       HWLOC_OBJ_SOCKET),
+			      hwloc_get_nbobjs_by_type(topology,
+						       HWLOC_OBJ_CORE),
+			      hwloc_get_nbobjs_by_type(topology,
+						       HWLOC_OBJ_PU));
+}
+
+/*
+ * Record the id of the hardware next to topo_file, followed by its object
+ * counts to check against when it is discovered again.
+ */
+static void _topo_id_save(char *topo_file, hwloc_topology_t topology)
+{
+	char *id_file = xstrdup_printf("%s.id", topo_file);
+	char *id = _topo_id(), *objs = _topo_objs(topology);
+	FILE *fp;
+
+	if (!id) {
+		(void) unlink(id_file);
+	} else if (!(fp = fopen(id_file, "w"))) {
+		error("%s: unable to write %s: %m", __func__, id_file);
+	} else {
+		fprintf(fp, "%s\n%s\n", id, objs);
+		fclose(fp);
+	}
+
+	xfree(id);
+	xfree(objs);
+	xfree(id_file);
+}
+
+/* Return true if topo_file was exported from this hardware */
+static bool _topo_id_valid(char *topo_file)
+{
+	char *id_file = xstrdup_printf("%s.id", topo_file);
+	char *id = _topo_id(), *saved = _read_line(id_file);
+	bool valid = (id && !xstrcmp(id, saved));
+
+	xfree(id);
+	xfree(saved);
+	xfree(id_file);
+
+	return valid;
+}
+
+static void _topo_set_full(hwloc_topology_t *topology)
+{
+	/* parse all system */
+	hwloc_topology_set_flags(*topology, HWLOC_TOPOLOGY_FLAG_WHOLE_SYSTEM);
+
+	/* ignores cache, misc */
+#if HWLOC_API_VERSION < 0x00020000
+	hwloc_topology_ignore_type (*topology, HWLOC_OBJ_CACHE);
+	hwloc_topology_ignore_type (*topology, HWLOC_OBJ_MISC);
+#else
+	hwloc_topology_set_type_filter(*topology, HWLOC_OBJ_L1CACHE,
+				       HWLOC_TYPE_FILTER_KEEP_NONE);
+	hwloc_topology_set_type_filter(*topology, HWLOC_OBJ_L2CACHE,
+				       HWLOC_TYPE_FILTER_KEEP_NONE);
+	hwloc_topology_set_type_filter(*topology, HWLOC_OBJ_L3CACHE,
+				       HWLOC_TYPE_FILTER_KEEP_NONE);
+	hwloc_topology_set_type_filter(*topology, HWLOC_OBJ_L4CACHE,
+				       HWLOC_TYPE_FILTER_KEEP_NONE);
+	hwloc_topology_set_type_filter(*topology, HWLOC_OBJ_L5CACHE,
+				       HWLOC_TYPE_FILTER_KEEP_NONE);
+	hwloc_topology_set_type_filter(*topology, HWLOC_OBJ_MISC,
+				       HWLOC_TYPE_FILTER_KEEP_NONE);
+#endif
+}
+
+/*
+ * Discover the topology again after slurmd started from the exported one,
+ * replacing the file and warning if the hardware no longer matches it.
+ */
+static void *_topo_refresh(void *arg)
+{
+	char *topo_file = arg, *id_file, *new_file, *saved = NULL, *objs;
+	hwloc_topology_t topology;
+	FILE *fp;
+
+	if (hwloc_topology_init(&topology)) {
+		xfree(topo_file);
+		return NULL;
+	}
+	_topo_set_full(&topology);
+	if (hwloc_topology_load(topology)) {
+		debug("%s: hwloc_topology_load() failed", __func__);
+		goto fini;
+	}
+
+	id_file = xstrdup_printf("%s.id", topo_file);
+	if ((fp = fopen(id_file, "r"))) {
+		char buf[1024];
+
+		/* Object counts are on the second line */
+		if (fgets(buf, sizeof(buf), fp) && fgets(buf, sizeof(buf), fp)) {
+			buf[strcspn(buf, "\n")] = '\0';
+			saved = xstrdup(buf);
+		}
+		fclose(fp);
+	}
+	xfree(id_file);
+
+	objs = _topo_objs(topology);
+	if (xstrcmp(saved, objs))
+		error("%s: hardware topology changed from %s to %s since %s was exported, restart slurmd to register it",
+		      __func__, saved, objs, topo_file);
+	else
+		debug2("%s: %s is current", __func__, topo_file);
+	xfree(objs);
+	xfree(saved);
+
+	new_file = xstrdup_printf("%s.new", topo_file);
+	if (_internal_hwloc_topology_export_xml(topology, new_file))
+		error("%s: unable to export %s", __func__, new_file);
+	else if (rename(new_file, topo_file) < 0)
+		error("%s: unable to rename %s: %m", __func__, new_file);
+	else
+		_topo_id_save(topo_file, topology);
+	xfree(new_file);
+
+fini:
+	hwloc_topology_destroy(topology);
+	xfree(topo_file);
+	return NULL;
+}
+
 /* read or load topology and write if needed
  * init and destroy topology must be outside this function */
 extern int xcpuinfo_hwloc_topo_load(
@@ -176,7 +356,7 @@ extern int xcpuinfo_hwloc_topo_load(
 	hwloc_topology_t *topology = topology_in;
 	hwloc_topology_t tmp_topo;
 	static bool first_full = true;
-	bool check_file = true;
+	bool check_file = true, refresh = false, save_id = false;
 
 	xassert(topo_file);
 
@@ -186,9 +366,14 @@ extern int xcpuinfo_hwloc_topo_load(
 	}
 
 	if (full && first_full) {
-		/* Always regenerate file on slurmd startup */
-		if (running_in_slurmd())
-			check_file = false;
+		/*
+		 * On slurmd startup use the file only if it was exported from
+		 * this hardware, and discover it again in the background.
+		 */
+		if (running_in_slurmd()) {
+			check_file = refresh = _topo_id_valid(topo_file);
+			save_id = true;
+		}
 		first_full = false;
 	}
 
@@ -200,8 +385,16 @@ extern int xcpuinfo_hwloc_topo_load(
 		else if (hwloc_topology_load(*topology))
 			error("%s: hwloc_topology_load() failed (%s)",
 			      __func__, topo_file);
-		else
+		else {
+			if (refresh) {
+				debug("%s: using topology exported at last startup (%s)",
+				      __func__, topo_file);
+				slurm_thread_create_detached(NULL,
+							     _topo_refresh,
+							     xstrdup(topo_file));
+			}
 			return ret;
+		}
 	}
 
 	hwloc_topology_destroy(*topology);
@@ -210,30 +403,8 @@ handle_write:
 
 	hwloc_topology_init(topology);
 
-	if (full) {
-		/* parse all system */
-		hwloc_topology_set_flags(*topology,
-					 HWLOC_TOPOLOGY_FLAG_WHOLE_SYSTEM);
-
-		/* ignores cache, misc */
-#if HWLOC_API_VERSION < 0x00020000
-		hwloc_topology_ignore_type (*topology, HWLOC_OBJ_CACHE);
-		hwloc_topology_ignore_type (*topology, HWLOC_OBJ_MISC);
-#else
-		hwloc_topology_set_type_filter(*topology, HWLOC_OBJ_L1CACHE,
-					       HWLOC_TYPE_FILTER_KEEP_NONE);
-		hwloc_topology_set_type_filter(*topology, HWLOC_OBJ_L2CACHE,
-					       HWLOC_TYPE_FILTER_KEEP_NONE);
-		hwloc_topology_set_type_filter(*topology, HWLOC_OBJ_L3CACHE,
-					       HWLOC_TYPE_FILTER_KEEP_NONE);
-		hwloc_topology_set_type_filter(*topology, HWLOC_OBJ_L4CACHE,
-					       HWLOC_TYPE_FILTER_KEEP_NONE);
-		hwloc_topology_set_type_filter(*topology, HWLOC_OBJ_L5CACHE,
-					       HWLOC_TYPE_FILTER_KEEP_NONE);
-		hwloc_topology_set_type_filter(*topology, HWLOC_OBJ_MISC,
-					       HWLOC_TYPE_FILTER_KEEP_NONE);
-#endif
-	}
+	if (full)
+		_topo_set_full(topology);
 
 	/* load topology */
 	debug2("hwloc_topology_load");
@@ -246,7 +417,8 @@ handle_write:
 		if (_internal_hwloc_topology_export_xml(*topology, topo_file)) {
 			/* error in export hardware topology */
 			error("%s: failed (load will be required after read failures).", __func__);
-		}
+		} else if (save_id)
+			_topo_id_save(topo_file, *topology);
 	}
 
 	if (!topology_in)
@@ -42,6 +42,7 @@
 #include "config.h"
 
 #include <ctype.h>
+#include <dirent.h>
 #include <fcntl.h>
 #include <grp.h>
 #ifdef HAVE_NUMA
@@ -89,6 +90,8 @@
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_protocol_interface.h"
 #include "src/common/stepd_api.h"
+#include "src/common/timers.h"
+#include "src/common/trace.h"
 #include "src/common/uid.h"
 #include "src/common/util-net.h"
 #include "src/common/xcgroup_read_config.h"
@@ -158,6 +161,7 @@ static void _rpc_timelimit(slurm_msg_t *);
 static void _rpc_reattach_tasks(slurm_msg_t *);
 static void _rpc_suspend_job(slurm_msg_t *msg);
 static void _rpc_terminate_job(slurm_msg_t *);
+static void _rpc_kill_job_list(slurm_msg_t *msg);
 static void _rpc_shutdown(slurm_msg_t *msg);
 static void _rpc_reconfig(slurm_msg_t *msg);
 static void _rpc_reconfig_with_config(slurm_msg_t *msg);
@@ -253,6 +257,8 @@ static pthread_mutex_t waiter_mutex = PTHREAD_MUTEX_INITIALIZER;
 void
 slurmd_req(slurm_msg_t *msg)
 {
+	uint64_t span;
+
 	if (msg == NULL) {
 		if (startup == 0)
 			startup = time(NULL);
@@ -273,6 +279,8 @@ slurmd_req(slurm_msg_t *msg)
 		      __func__);
 
 	debug2("Processing RPC: %s", rpc_num2string(msg->msg_type));
+	trace_set_id(msg->trace_id);
+	span = trace_span_start();
 	switch (msg->msg_type) {
 	case REQUEST_LAUNCH_PROLOG:
 		_rpc_prolog(msg);
@@ -314,6 +322,10 @@ slurmd_req(slurm_msg_t *msg)
 		last_slurmctld_msg = time(NULL);
 		_rpc_terminate_job(msg);
 		break;
+	case REQUEST_KILL_JOB_LIST:
+		last_slurmctld_msg = time(NULL);
+		_rpc_kill_job_list(msg);
+		break;
 	case REQUEST_SHUTDOWN:
 		_rpc_shutdown(msg);
 		break;
@@ -381,6 +393,7 @@ slurmd_req(slurm_msg_t *msg)
 		slurm_send_rc_msg(msg, EINVAL);
 		break;
 	}
+	trace_span_end(rpc_num2string(msg->msg_type), span);
 	return;
 }
 
@@ -429,6 +442,22 @@ rwfail:
 	return (-1);
 }
 
+/*
+ * Append a packed address to buffer, preceded by its packed length as a raw
+ * int, the way _init_from_slurmd() in slurmstepd reads it.
+ */
+static void _pack_addr_raw(slurm_addr_t *addr, buf_t *buffer)
+{
+	buf_t *addr_buf = init_buf(0);
+	int len;
+
+	slurm_pack_addr(addr, addr_buf);
+	len = get_buf_offset(addr_buf);
+	packmem_array((char *) &len, sizeof(int), buffer);
+	packmem_array(get_buf_data(addr_buf), len, buffer);
+	free_buf(addr_buf);
+}
+
 static int
 _send_slurmstepd_init(int fd, int type, void *req,
 		      slurm_addr_t *cli, slurm_addr_t *self,
@@ -457,8 +486,18 @@ _send_slurmstepd_init(int fd, int type, void *req,
 	if (acct_gather_write_conf(fd) < 0)
 		goto rwfail;
 
+	/* send resolved plugstack.conf over to slurmstepd */
+	if (spank_stack_write_conf(fd) < 0)
+		goto rwfail;
+
+	/*
+	 * The launch type, reverse-tree info and addresses are small fixed
+	 * pieces; collect them and send them to slurmstepd in one write.
+	 */
+	buffer = init_buf(256);
+
 	/* send type over to slurmstepd */
-	safe_write(fd, &type, sizeof(int));
+	packmem_array((char *) &type, sizeof(int), buffer);
 
 	/* step_hset can be NULL for batch scripts OR if the job was submitted
 	 * by SlurmUser or root using the --no-allocate/-Z option and the job
@@ -547,37 +586,28 @@ _send_slurmstepd_init(int fd, int type, void *req,
 		free(parent_alias);
 
 	/* send reverse-tree info to the slurmstepd */
-	safe_write(fd, &rank, sizeof(int));
-	safe_write(fd, &parent_rank, sizeof(int));
-	safe_write(fd, &children, sizeof(int));
-	safe_write(fd, &depth, sizeof(int));
-	safe_write(fd, &max_depth, sizeof(int));
-	safe_write(fd, &parent_addr, sizeof(slurm_addr_t));
+	packmem_array((char *) &rank, sizeof(int), buffer);
+	packmem_array((char *) &parent_rank, sizeof(int), buffer);
+	packmem_array((char *) &children, sizeof(int), buffer);
+	packmem_array((char *) &depth, sizeof(int), buffer);
+	packmem_array((char *) &max_depth, sizeof(int), buffer);
+	packmem_array((char *) &parent_addr, sizeof(slurm_addr_t), buffer);
 
 	/* send cli address over to slurmstepd */
-	buffer = init_buf(0);
-	slurm_pack_addr(cli, buffer);
-	len = get_buf_offset(buffer);
-	safe_write(fd, &len, sizeof(int));
-	safe_write(fd, get_buf_data(buffer), len);
-	free_buf(buffer);
-	buffer = NULL;
+	_pack_addr_raw(cli, buffer);
 
 	/* send self address over to slurmstepd */
 	if (self) {
-		buffer = init_buf(0);
-		slurm_pack_addr(self, buffer);
-		len = get_buf_offset(buffer);
-		safe_write(fd, &len, sizeof(int));
-		safe_write(fd, get_buf_data(buffer), len);
-		free_buf(buffer);
-		buffer = NULL;
-
+		_pack_addr_raw(self, buffer);
 	} else {
 		len = 0;
-		safe_write(fd, &len, sizeof(int));
+		packmem_array((char *) &len, sizeof(int), buffer);
 	}
 
+	safe_write(fd, get_buf_data(buffer), get_buf_offset(buffer));
+	free_buf(buffer);
+	buffer = NULL;
+
 	/* send cpu_frequency info to slurmstepd */
 	cpu_freq_send_info(fd);
 
@@ -1382,7 +1412,9 @@ _rpc_launch_tasks(slurm_msg_t *msg)
 	job_mem_limits_t *job_limits_ptr;
 	int node_id = 0;
 	bitstr_t *numa_bitmap = NULL;
+	uint64_t span;
 
+	trace_set_id(req->step_id.job_id);
 	slurm_mutex_lock(&launch_mutex);
 
 #ifndef HAVE_FRONT_END
@@ -1566,8 +1598,10 @@ _rpc_launch_tasks(slurm_msg_t *msg)
 	}
 
 	debug3("%s: call to _forkexec_slurmstepd", __func__);
+	span = trace_span_start();
 	errnum = _forkexec_slurmstepd(LAUNCH_TASKS, (void *)req, cli, &self,
 				      step_hset, msg->protocol_version);
+	trace_span_end("launch", span);
 	debug3("%s: return from _forkexec_slurmstepd", __func__);
 	_launch_complete_add(req->step_id.job_id);
 
@@ -2190,6 +2224,7 @@ static void _rpc_prolog(slurm_msg_t *msg)
 	if (req == NULL)
 		return;
 
+	trace_set_id(req->job_id);
 	if (!_slurm_authorized_user(msg->auth_uid)) {
 		error("REQUEST_LAUNCH_PROLOG request from uid %u",
 		      msg->auth_uid);
@@ -2319,7 +2354,10 @@ static void _rpc_batch_job(slurm_msg_t *msg)
 	int      rc = SLURM_SUCCESS, node_id = 0;
 	bool	 replied = false, revoked;
 	slurm_addr_t *cli = &msg->orig_addr;
+	uint64_t span;
 
+	req->launch_time[JOB_LAUNCH_RECV] = slurm_time_usec();
+	trace_set_id(req->job_id);
 	if (!_slurm_authorized_user(msg->auth_uid)) {
 		error("Security violation, batch launch RPC from uid %u",
 		      msg->auth_uid);
@@ -2465,8 +2503,13 @@ static void _rpc_batch_job(slurm_msg_t *msg)
 
 		if ((rc = container_g_create(jobid)))
 			error("container_g_create(%u): %m", req->job_id);
-		else
+		else {
+			req->launch_time[JOB_LAUNCH_PROLOG_START] =
+				slurm_time_usec();
 			rc = _run_prolog(&job_env, req->cred, true);
+			req->launch_time[JOB_LAUNCH_PROLOG_END] =
+				slurm_time_usec();
+		}
 		_free_job_env(&job_env);
 		if (rc) {
 			int term_sig = 0, exit_status = 0;
@@ -2510,8 +2553,10 @@ static void _rpc_batch_job(slurm_msg_t *msg)
 	info("Launching batch job %u for UID %u", req->job_id, req->uid);
 
 	debug3("_rpc_batch_job: call to _forkexec_slurmstepd");
+	span = trace_span_start();
 	rc = _forkexec_slurmstepd(LAUNCH_BATCH_JOB, (void *)req, cli, NULL,
 				  (hostset_t)NULL, SLURM_PROTOCOL_VERSION);
+	trace_span_end("launch", span);
 	debug3("_rpc_batch_job: return from _forkexec_slurmstepd: %d", rc);
 
 	slurm_mutex_unlock(&launch_mutex);
@@ -3532,6 +3577,44 @@ static void _rpc_daemon_status(slurm_msg_t *msg)
 	slurm_free_slurmd_status(resp);
 }
 
+/*
+ * Merge the accounting of the nodes we forwarded a REQUEST_JOB_STEP_STAT to
+ * into our own response, so only one jobacct per subtree goes back up the
+ * tree. The records of those nodes are kept for their names, task counts and
+ * pids.
+ */
+static void _aggregate_stat_jobacct(slurm_msg_t *msg, job_step_stat_t *resp)
+{
+	ListIterator itr;
+	ret_data_info_t *ret_data_info;
+	job_step_stat_t *stat;
+
+	forward_wait(msg);
+	if (!msg->ret_list)
+		return;
+
+	itr = list_iterator_create(msg->ret_list);
+	while ((ret_data_info = list_next(itr))) {
+		if ((ret_data_info->type != RESPONSE_JOB_STEP_STAT) ||
+		    !(stat = ret_data_info->data) || !stat->jobacct)
+			continue;
+		if (!resp->jobacct) {
+			resp->jobacct = stat->jobacct;
+			stat->jobacct = NULL;
+			continue;
+		}
+		/* All nodes should have the same TRES, but be sure */
+		if ((resp->jobacct->tres_count != stat->jobacct->tres_count) ||
+		    memcmp(resp->jobacct->tres_ids, stat->jobacct->tres_ids,
+			   sizeof(uint32_t) * resp->jobacct->tres_count))
+			continue;
+		jobacctinfo_aggregate(resp->jobacct, stat->jobacct);
+		jobacctinfo_destroy(stat->jobacct);
+		stat->jobacct = NULL;
+	}
+	list_iterator_destroy(itr);
+}
+
 static void _rpc_stat_jobacct(slurm_msg_t *msg)
 {
 	slurm_step_id_t *req = (slurm_step_id_t *)msg->data;
@@ -3580,7 +3663,6 @@ static void _rpc_stat_jobacct(slurm_msg_t *msg)
 	resp = xmalloc(sizeof(job_step_stat_t));
 	resp->step_pids = xmalloc(sizeof(job_step_pids_t));
 	resp->step_pids->node_name = xstrdup(conf->node_name);
-	slurm_msg_t_copy(&resp_msg, msg);
 	resp->return_code = SLURM_SUCCESS;
 
 	if (stepd_stat_jobacct(fd, protocol_version, req, resp)
@@ -3598,6 +3680,11 @@ static void _rpc_stat_jobacct(slurm_msg_t *msg)
 
 	close(fd);
 
+	/* Must happen before the copy, forward_wait() frees forward_struct */
+	if (msg->flags & SLURM_MSG_AGGREGATE)
+		_aggregate_stat_jobacct(msg, resp);
+
+	slurm_msg_t_copy(&resp_msg, msg);
 	resp_msg.msg_type     = RESPONSE_JOB_STEP_STAT;
 	resp_msg.data         = resp;
 
@@ -3758,6 +3845,74 @@ static void _rpc_list_pids(slurm_msg_t *msg)
 	slurm_free_job_step_pids(resp);
 }
 
+static void *_kill_job_list_thread(void *arg)
+{
+	slurm_msg_t *msg = arg;
+
+	if (msg->msg_type == REQUEST_TERMINATE_JOB)
+		_rpc_terminate_job(msg);
+	else
+		_rpc_timelimit(msg);
+
+	return NULL;
+}
+
+/*
+ *  Several kill requests of the same type from slurmctld: reply once, then
+ *   handle each request in its own thread as if its connection had already
+ *   been closed, so completion is reported with MESSAGE_EPILOG_COMPLETE.
+ */
+static void _rpc_kill_job_list(slurm_msg_t *msg)
+{
+	kill_job_list_msg_t *req = msg->data;
+	slurm_msg_t *kill_msgs;
+	pthread_t *threads;
+	int i;
+
+	if (!_slurm_authorized_user(msg->auth_uid)) {
+		error("Security violation: kill_job_list req from uid %u",
+		      msg->auth_uid);
+		slurm_send_rc_msg(msg, ESLURM_USER_ID_MISSING);
+		return;
+	}
+
+	if ((req->kill_msg_type != REQUEST_TERMINATE_JOB) &&
+	    (req->kill_msg_type != REQUEST_KILL_TIMELIMIT) &&
+	    (req->kill_msg_type != REQUEST_KILL_PREEMPTED)) {
+		error("%s: invalid kill message type %s", __func__,
+		      rpc_num2string(req->kill_msg_type));
+		slurm_send_rc_msg(msg, SLURM_ERROR);
+		return;
+	}
+
+	slurm_send_rc_msg(msg, SLURM_SUCCESS);
+	close(msg->conn_fd);
+	msg->conn_fd = -1;
+
+	debug("%s: %u %s requests", __func__, req->count,
+	      rpc_num2string(req->kill_msg_type));
+
+	kill_msgs = xcalloc(req->count, sizeof(slurm_msg_t));
+	threads = xcalloc(req->count, sizeof(pthread_t));
+	for (i = 0; i < req->count; i++) {
+		slurm_msg_t_init(&kill_msgs[i]);
+		kill_msgs[i].msg_type = req->kill_msg_type;
+		kill_msgs[i].data = req->kill_msgs[i];
+		kill_msgs[i].auth_uid = msg->auth_uid;
+		kill_msgs[i].auth_uid_set = true;
+		kill_msgs[i].protocol_version = msg->protocol_version;
+		slurm_thread_create(&threads[i], _kill_job_list_thread,
+				    &kill_msgs[i]);
+	}
+
+	/* Keep this RPC thread counted until every request is done */
+	for (i = 0; i < req->count; i++)
+		pthread_join(threads[i], NULL);
+
+	xfree(threads);
+	xfree(kill_msgs);
+}
+
 /*
  *  For the specified job_id: reply to slurmctld,
  *   sleep(configured kill_wait), then send SIGKILL
@@ -3778,9 +3933,11 @@ _rpc_timelimit(slurm_msg_t *msg)
 	/*
 	 *  Indicate to slurmctld that we've received the message
 	 */
-	slurm_send_rc_msg(msg, SLURM_SUCCESS);
-	close(msg->conn_fd);
-	msg->conn_fd = -1;
+	if (msg->conn_fd >= 0) {
+		slurm_send_rc_msg(msg, SLURM_SUCCESS);
+		close(msg->conn_fd);
+		msg->conn_fd = -1;
+	}
 
 	if (req->step_id.step_id != NO_VAL) {
 		slurm_conf_t *cf;
@@ -4009,6 +4166,325 @@ static void _file_bcast_close_file(file_bcast_info_t *key)
 	_fb_wrunlock();
 }
 
+/*
+ * sbcast cache: a node local copy of recently broadcast files, keyed by
+ * the owner's uid and the content hash sent by sbcast. Entries are kept
+ * per uid so a hash collision can only ever hand a user one of their own
+ * files back. The cache is enabled with SlurmdParameters=sbcast_cache=<MB>.
+ */
+typedef struct {
+	uint64_t file_hash;	/* content hash of the file */
+	uint64_t file_size;	/* file size */
+	time_t last_use;	/* last time the entry was copied out */
+	char *path;		/* cached copy of the file */
+	uid_t uid;		/* owner of the broadcast file */
+} bcast_cache_ent_t;
+
+static pthread_mutex_t bcast_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List bcast_cache_list = NULL;
+static uint64_t bcast_cache_size = 0;
+
+static void _free_bcast_cache_ent(void *arg)
+{
+	bcast_cache_ent_t *ent = arg;
+
+	if (!ent)
+		return;
+
+	xfree(ent->path);
+	xfree(ent);
+}
+
+static int _find_bcast_cache_ent(void *x, void *key)
+{
+	bcast_cache_ent_t *ent = x, *match = key;
+
+	return ((ent->uid == match->uid) &&
+		(ent->file_hash == match->file_hash) &&
+		(ent->file_size == match->file_size));
+}
+
+static int _sort_bcast_cache_ent(void *x, void *y)
+{
+	bcast_cache_ent_t *ent1 = *(bcast_cache_ent_t **) x;
+	bcast_cache_ent_t *ent2 = *(bcast_cache_ent_t **) y;
+
+	return (ent1->last_use > ent2->last_use) -
+	       (ent1->last_use < ent2->last_use);
+}
+
+/* Size limit of the sbcast cache in bytes, zero if disabled */
+static uint64_t _bcast_cache_limit(void)
+{
+	static time_t config_update = 0;
+	static uint64_t limit = 0;
+	char *tmp;
+
+	if (config_update != slurm_conf.last_update) {
+		limit = 0;
+		if ((tmp = xstrcasestr(slurm_conf.slurmd_params,
+				       "sbcast_cache=")))
+			limit = strtoull(tmp + 13, NULL, 10) * 1024 * 1024;
+		config_update = slurm_conf.last_update;
+	}
+
+	return limit;
+}
+
+/* Remove least recently used entries until the cache fits in limit */
+static void _bcast_cache_evict(uint64_t limit)
+{
+	bcast_cache_ent_t *ent;
+
+	if (bcast_cache_size <= limit)
+		return;
+
+	list_sort(bcast_cache_list, _sort_bcast_cache_ent);
+	while ((bcast_cache_size > limit) &&
+	       (ent = list_pop(bcast_cache_list))) {
+		debug("sbcast cache: removing `%s`", ent->path);
+		if (unlink(ent->path) && (errno != ENOENT))
+			error("sbcast cache: unable to remove `%s`: %m",
+			      ent->path);
+		bcast_cache_size -= ent->file_size;
+		_free_bcast_cache_ent(ent);
+	}
+}
+
+/* Rebuild the cache index from the entries left by a previous slurmd */
+static void _bcast_cache_load(void)
+{
+	char *dir = xstrdup_printf("%s/sbcast_cache", conf->spooldir);
+	char *path = NULL;
+	struct dirent *de;
+	struct stat st;
+	DIR *dp;
+
+	bcast_cache_list = list_create(_free_bcast_cache_ent);
+
+	if (!(dp = opendir(dir))) {
+		xfree(dir);
+		return;
+	}
+	while ((de = readdir(dp))) {
+		bcast_cache_ent_t *ent;
+		uint64_t hash;
+		uint32_t uid;
+		int len = 0;
+
+		if (de->d_name[0] == '.')
+			continue;
+		xstrfmtcat(path, "%s/%s", dir, de->d_name);
+		if ((sscanf(de->d_name, "%u.%"SCNx64"%n",
+			    &uid, &hash, &len) != 2) ||
+		    de->d_name[len] || stat(path, &st) ||
+		    !S_ISREG(st.st_mode)) {
+			/* partial transfers and anything unexpected */
+			(void) unlink(path);
+			xfree(path);
+			continue;
+		}
+		ent = xmalloc(sizeof(*ent));
+		ent->file_hash = hash;
+		ent->file_size = st.st_size;
+		ent->last_use = st.st_mtime;
+		ent->path = path;
+		ent->uid = uid;
+		path = NULL;
+		bcast_cache_size += ent->file_size;
+		list_append(bcast_cache_list, ent);
+	}
+	closedir(dp);
+	xfree(dir);
+
+	_bcast_cache_evict(_bcast_cache_limit());
+}
+
+static int _bcast_cache_copy(int in_fd, int out_fd, uint64_t size)
+{
+	int buf_size = 1024 * 1024;
+	char *buf = xmalloc(buf_size);
+	ssize_t in_len, out_len, offset;
+	uint64_t copied = 0;
+
+	while ((in_len = read(in_fd, buf, buf_size))) {
+		if (in_len < 0) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		for (offset = 0; offset < in_len; offset += out_len) {
+			out_len = write(out_fd, buf + offset, in_len - offset);
+			if (out_len < 0) {
+				if (errno == EINTR) {
+					out_len = 0;
+					continue;
+				}
+				xfree(buf);
+				return SLURM_ERROR;
+			}
+		}
+		copied += in_len;
+	}
+	xfree(buf);
+
+	return (copied == size) ? SLURM_SUCCESS : SLURM_ERROR;
+}
+
+/*
+ * Fill the destination file from the sbcast cache
+ * RET true if the file was found in the cache and copied
+ */
+static bool _bcast_cache_get(file_bcast_info_t *file_info)
+{
+	bcast_cache_ent_t key, *ent;
+	int fd = -1;
+
+	key.file_hash = file_info->file_hash;
+	key.file_size = file_info->file_size;
+	key.uid = file_info->uid;
+
+	slurm_mutex_lock(&bcast_cache_mutex);
+	if (_bcast_cache_limit() &&
+	    (ent = list_find_first(bcast_cache_list, _find_bcast_cache_ent,
+				   &key))) {
+		if ((fd = open(ent->path, O_RDONLY | O_CLOEXEC)) < 0) {
+			error("sbcast cache: unable to open `%s`: %m",
+			      ent->path);
+			bcast_cache_size -= ent->file_size;
+			list_delete_ptr(bcast_cache_list, ent);
+		} else
+			ent->last_use = time(NULL);
+	}
+	slurm_mutex_unlock(&bcast_cache_mutex);
+
+	if (fd < 0)
+		return false;
+
+	/* an entry evicted meanwhile stays readable until closed */
+	if (_bcast_cache_copy(fd, file_info->fd, file_info->file_size)) {
+		error("sbcast cache: unable to copy to `%s`: %m",
+		      file_info->fname);
+		close(fd);
+		return false;
+	}
+	close(fd);
+
+	debug("sbcast cache: copied uid:%u `%s` from cache",
+	      file_info->uid, file_info->fname);
+	return true;
+}
+
+/* Start a new cache entry to be written along with the destination file */
+static void _bcast_cache_start(file_bcast_info_t *file_info)
+{
+	uint64_t limit;
+	char *dir;
+	int fd;
+
+	slurm_mutex_lock(&bcast_cache_mutex);
+	limit = _bcast_cache_limit();
+	slurm_mutex_unlock(&bcast_cache_mutex);
+
+	if (!limit || (file_info->file_size > limit))
+		return;
+
+	dir = xstrdup_printf("%s/sbcast_cache", conf->spooldir);
+	if ((mkdir(dir, 0700) < 0) && (errno != EEXIST)) {
+		error("sbcast cache: mkdir(%s): %m", dir);
+		xfree(dir);
+		return;
+	}
+	file_info->cache_tmp = xstrdup_printf("%s/%u.%016"PRIx64".%u.tmp",
+					      dir, file_info->uid,
+					      file_info->file_hash,
+					      file_info->job_id);
+	xfree(dir);
+
+	fd = open(file_info->cache_tmp,
+		  O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	if (fd < 0) {
+		error("sbcast cache: unable to create `%s`: %m",
+		      file_info->cache_tmp);
+		xfree(file_info->cache_tmp);
+		return;
+	}
+	file_info->cache_fd = fd;
+}
+
+/* Write a block to the cache entry being built, if any */
+static void _bcast_cache_write(file_bcast_info_t *file_info,
+			       file_bcast_msg_t *req)
+{
+	int64_t offset = 0, inx;
+
+	if (!file_info->cache_fd || file_info->cache_error)
+		return;
+
+	while (req->block_len - offset) {
+		inx = pwrite(file_info->cache_fd, &req->block[offset],
+			     (req->block_len - offset),
+			     req->block_offset + offset);
+		if (inx == -1) {
+			if ((errno == EINTR) || (errno == EAGAIN))
+				continue;
+			error("sbcast cache: can't write `%s`: %m",
+			      file_info->cache_tmp);
+			file_info->cache_error = true;
+			return;
+		}
+		offset += inx;
+	}
+}
+
+/* Add a completely received file to the cache */
+static void _bcast_cache_commit(file_bcast_info_t *file_info)
+{
+	bcast_cache_ent_t *ent, *old;
+	char *path;
+
+	close(file_info->cache_fd);
+	file_info->cache_fd = 0;
+
+	if (file_info->cache_error) {
+		(void) unlink(file_info->cache_tmp);
+		xfree(file_info->cache_tmp);
+		return;
+	}
+
+	path = xstrdup_printf("%s/sbcast_cache/%u.%016"PRIx64,
+			      conf->spooldir, file_info->uid,
+			      file_info->file_hash);
+	if (rename(file_info->cache_tmp, path)) {
+		error("sbcast cache: unable to rename `%s`: %m",
+		      file_info->cache_tmp);
+		(void) unlink(file_info->cache_tmp);
+		xfree(file_info->cache_tmp);
+		xfree(path);
+		return;
+	}
+	xfree(file_info->cache_tmp);
+
+	ent = xmalloc(sizeof(*ent));
+	ent->file_hash = file_info->file_hash;
+	ent->file_size = file_info->file_size;
+	ent->last_use = time(NULL);
+	ent->path = path;
+	ent->uid = file_info->uid;
+
+	slurm_mutex_lock(&bcast_cache_mutex);
+	/* a concurrent transfer of the same file may have won the race */
+	if ((old = list_find_first(bcast_cache_list, _find_bcast_cache_ent,
+				   ent))) {
+		bcast_cache_size -= old->file_size;
+		list_delete_ptr(bcast_cache_list, old);
+	}
+	list_append(bcast_cache_list, ent);
+	bcast_cache_size += ent->file_size;
+	_bcast_cache_evict(_bcast_cache_limit());
+	slurm_mutex_unlock(&bcast_cache_mutex);
+}
+
 static void _free_file_bcast_info_t(void *arg)
 {
 	file_bcast_info_t *f = (file_bcast_info_t *)arg;
@@ -4019,6 +4495,13 @@ static void _free_file_bcast_info_t(void *arg)
 	xfree(f->fname);
 	if (f->fd)
 		close(f->fd);
+	if (f->cache_fd)
+		close(f->cache_fd);
+	if (f->cache_tmp) {
+		/* transfer never completed, discard the cache entry */
+		(void) unlink(f->cache_tmp);
+		xfree(f->cache_tmp);
+	}
 	xfree(f);
 }
 
@@ -4050,12 +4533,14 @@ void file_bcast_init(void)
 {
 	/* skip locks during slurmd init */
 	file_bcast_list = list_create(_free_file_bcast_info_t);
+	_bcast_cache_load();
 }
 
 void file_bcast_purge(void)
 {
 	_fb_wrlock();
 	list_destroy(file_bcast_list);
+	FREE_NULL_LIST(bcast_cache_list);
 	/* destroying list before exit, no need to unlock */
 }
 
@@ -4067,6 +4552,7 @@ static void _rpc_file_bcast(slurm_msg_t *msg)
 	file_bcast_info_t *file_info;
 	file_bcast_msg_t *req = msg->data;
 	file_bcast_info_t key;
+	bool cached;
 
 	key.uid = msg->auth_uid;
 	key.gid = auth_g_get_gid(msg->auth_cred);
@@ -4138,6 +4624,10 @@ static void _rpc_file_bcast(slurm_msg_t *msg)
 		goto done;
 	}
 
+	/* the file already came from the sbcast cache, ignore the data */
+	if ((cached = file_info->cached))
+		goto written;
+
 	/* now decompress file */
 	if (bcast_decompress_data(req) < 0) {
 		error("sbcast: data decompression error for UID %u, file %s",
@@ -4147,10 +4637,15 @@ static void _rpc_file_bcast(slurm_msg_t *msg)
 		goto done;
 	}
 
+	/*
+	 * Write at the block's offset, sbcast forwards several blocks at
+	 * once so they are not guaranteed to arrive in order.
+	 */
 	offset = 0;
 	while (req->block_len - offset) {
-		inx = write(file_info->fd, &req->block[offset],
-			    (req->block_len - offset));
+		inx = pwrite(file_info->fd, &req->block[offset],
+			     (req->block_len - offset),
+			     req->block_offset + offset);
 		if (inx == -1) {
 			if ((errno == EINTR) || (errno == EAGAIN))
 				continue;
@@ -4162,7 +4657,9 @@ static void _rpc_file_bcast(slurm_msg_t *msg)
 		}
 		offset += inx;
 	}
+	_bcast_cache_write(file_info, req);
 
+written:
 	file_info->last_update = time(NULL);
 
 	if (req->last_block && fchmod(file_info->fd, (req->modes & 0777))) {
@@ -4183,12 +4680,20 @@ static void _rpc_file_bcast(slurm_msg_t *msg)
 		}
 	}
 
+	/* all other blocks are done before sbcast sends the last one */
+	if (req->last_block && file_info->cache_fd)
+		_bcast_cache_commit(file_info);
+
 	_fb_rdunlock();
 
 	if (req->last_block) {
 		_file_bcast_close_file(&key);
 	}
 
+	/* tell sbcast it need not send the rest of the file */
+	if (cached && (req->block_no == 1))
+		rc = ESLURMD_BCAST_CACHED;
+
 done:
 	slurm_send_rc_msg(msg, rc);
 }
@@ -4227,6 +4732,15 @@ static int _file_bcast_register_file(slurm_msg_t *msg,
 	file_info->gid = key->gid;
 	file_info->job_id = key->job_id;
 	file_info->last_update = file_info->start_time = time(NULL);
+	file_info->file_hash = req->file_hash;
+	file_info->file_size = req->file_size;
+
+	if (file_info->file_hash) {
+		if (_bcast_cache_get(file_info))
+			file_info->cached = true;
+		else
+			_bcast_cache_start(file_info);
+	}
 
 	//TODO: mmap the file here
 	_fb_wrlock();
@@ -5567,6 +6081,7 @@ _run_prolog(job_env_t *job_env, slurm_cred_t *cred, bool remove_running)
 	timer_struct_t  timer_struct;
 	bool prolog_fini = false;
 	bool script_lock = false;
+	uint64_t span;
 
 	if (slurm_conf.prolog_flags & PROLOG_FLAG_SERIAL) {
 		slurm_mutex_lock(&prolog_serial_mutex);
@@ -5580,7 +6095,9 @@ _run_prolog(job_env_t *job_env, slurm_cred_t *cred, bool remove_running)
 	timer_struct.timer_mutex = &timer_mutex;
 	slurm_thread_create(&timer_id, _prolog_timer, &timer_struct);
 
+	span = trace_span_start();
 	rc = prep_g_prolog(job_env, cred);
+	trace_span_end("prolog", span);
 
 	slurm_mutex_lock(&timer_mutex);
 	prolog_fini = true;
@@ -5610,6 +6127,7 @@ _run_epilog(job_env_t *job_env)
 	time_t start_time = time(NULL);
 	int error_code, diff_time;
 	bool script_lock = false;
+	uint64_t span;
 
 	_wait_for_job_running_prolog(job_env->jobid);
 
@@ -5618,7 +6136,10 @@ _run_epilog(job_env_t *job_env)
 		script_lock = true;
 	}
 
+	trace_set_id(job_env->jobid);
+	span = trace_span_start();
 	error_code = prep_g_epilog(job_env, NULL);
+	trace_span_end("epilog", span);
 
 	diff_time = difftime(time(NULL), start_time);
 	if (diff_time >= (slurm_conf.msg_timeout / 2)) {
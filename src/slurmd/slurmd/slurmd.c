@@ -99,6 +99,7 @@
 #include "src/common/slurm_topology.h"
 #include "src/common/stepd_api.h"
 #include "src/common/switch.h"
+#include "src/common/trace.h"
 #include "src/common/uid.h"
 #include "src/common/xcgroup_read_config.h"
 #include "src/common/xmalloc.h"
@@ -370,6 +371,9 @@ main (int argc, char **argv)
 		fatal("Unable to clear interconnect state.");
 	switch_g_slurmd_init();
 	file_bcast_init();
+	acct_gather_energy_set_spooldir(conf->spooldir);
+	if (acct_gather_energy_start_publish() != SLURM_SUCCESS)
+		error("Unable to publish node energy readings to steps");
 
 	_create_msg_socket();
 
@@ -1100,6 +1104,7 @@ _reconfigure(void)
 	List gres_list = NULL;
 
 	_reconfig = 0;
+	trace_dump(conf->spooldir, "slurmd");
 	slurm_conf_reinit(conf->conffile);
 	xcgroup_reconfig_slurm_cgroup_conf();
 	_read_config();
@@ -1162,6 +1167,7 @@ _reconfigure(void)
 	send_registration_msg(SLURM_SUCCESS, false);
 
 	acct_gather_reconfig();
+	spank_slurmd_reconfig();
 
 	/* reconfigure energy */
 	acct_gather_energy_g_set_data(ENERGY_DATA_RECONFIG, NULL);
@@ -1904,6 +1910,7 @@ cleanup:
 static int
 _slurmd_fini(void)
 {
+	trace_dump(conf->spooldir, "slurmd");
 	assoc_mgr_fini(false);
 	node_features_g_fini();
 	core_spec_g_fini();
@@ -2611,7 +2618,7 @@ extern int run_script_health_check(void)
 		setenvf(&env, "SLURMD_NODENAME", "%s", conf->node_name);
 
 		rc = run_script("health_check", slurm_conf.health_check_program,
-				0, 60, env, 0);
+				0, 60, env, 0, false);
 
 		env_array_free(env);
 	}
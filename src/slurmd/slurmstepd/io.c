@@ -56,6 +56,7 @@
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <termios.h>
 #include <unistd.h>
 
@@ -94,6 +95,7 @@ struct io_operations client_ops = {
 };
 
 #define CLIENT_IO_MAGIC 0x10102
+#define CLIENT_WRITEV_MAX 16
 struct client_io_info {
 	int                   magic;
 	stepd_step_rec_t    *job;		 /* pointer back to job data   */
@@ -423,13 +425,19 @@ _client_read(eio_obj_t *obj, List objs)
 
 /*
  * Write outgoing packed messages to the client socket.
+ *
+ * Messages already waiting in the queue are gathered into the same writev()
+ * (up to CLIENT_WRITEV_MAX of them), so a task producing a lot of output does
+ * not cost one poll() wakeup and one syscall per MAX_MSG_LEN sized message.
  */
 static int
 _client_write(eio_obj_t *obj, List objs)
 {
 	struct client_io_info *client = (struct client_io_info *) obj->arg;
-	void *buf;
-	int n;
+	struct io_buf *msgs[CLIENT_WRITEV_MAX];
+	struct iovec iov[CLIENT_WRITEV_MAX];
+	int cnt, i, j;
+	ssize_t n;
 
 	xassert(client->magic == CLIENT_IO_MAGIC);
 
@@ -452,35 +460,56 @@ _client_write(eio_obj_t *obj, List objs)
 
 	debug5("  client->out_remaining = %d", client->out_remaining);
 
+	msgs[0] = client->out_msg;
+	iov[0].iov_base = client->out_msg->data +
+		(client->out_msg->length - client->out_remaining);
+	iov[0].iov_len = client->out_remaining;
+	for (cnt = 1; cnt < CLIENT_WRITEV_MAX; cnt++) {
+		if (!(msgs[cnt] = list_dequeue(client->msg_queue)))
+			break;
+		iov[cnt].iov_base = msgs[cnt]->data;
+		iov[cnt].iov_len = msgs[cnt]->length;
+	}
+
 	/*
-	 * Write message to socket.
+	 * Write messages to socket.
 	 */
-	buf = client->out_msg->data +
-		(client->out_msg->length - client->out_remaining);
 again:
-	if ((n = write(obj->fd, buf, client->out_remaining)) < 0) {
+	if ((n = writev(obj->fd, iov, cnt)) < 0) {
 		if (errno == EINTR) {
 			goto again;
 		} else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
 			debug5("_client_write returned EAGAIN");
-			return SLURM_SUCCESS;
+			n = 0;
 		} else {
 			client->out_eof = true;
+			for (j = cnt - 1; j > 0; j--)
+				list_push(client->msg_queue, msgs[j]);
 			_free_all_outgoing_msgs(client->msg_queue, client->job);
 			return SLURM_SUCCESS;
 		}
+	} else
+		debug5("Wrote %zd bytes to socket", n);
+
+	/* Find the first message that was not completely written */
+	for (i = 0; i < cnt; i++) {
+		if ((size_t) n < iov[i].iov_len)
+			break;
+		n -= iov[i].iov_len;
 	}
-	if (n < client->out_remaining) {
-		error("Only wrote %d of %d bytes to socket",
-		      n, client->out_remaining);
+
+	/* Put back what writev() didn't get to, keeping the queue order */
+	for (j = cnt - 1; j > i; j--)
+		list_push(client->msg_queue, msgs[j]);
+
+	if (i < cnt) {
+		client->out_msg = msgs[i];
+		client->out_remaining = iov[i].iov_len - n;
 	} else
-		debug5("Wrote %d bytes to socket", n);
-	client->out_remaining -= n;
-	if (client->out_remaining > 0)
-		return SLURM_SUCCESS;
+		client->out_msg = NULL;
 
-	_free_outgoing_msg(client->out_msg, client->job);
-	client->out_msg = NULL;
+	for (j = 0; j < i; j++)
+		_free_outgoing_msg(msgs[j], client->job);
 
 	return SLURM_SUCCESS;
 }
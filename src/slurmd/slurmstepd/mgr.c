@@ -89,6 +89,8 @@
 #include "src/common/slurm_mpi.h"
 #include "src/common/strlcpy.h"
 #include "src/common/switch.h"
+#include "src/common/timers.h"
+#include "src/common/trace.h"
 #include "src/common/tres_frequency.h"
 #include "src/common/util-net.h"
 #include "src/common/xmalloc.h"
@@ -351,6 +353,8 @@ static uint32_t _get_exit_code(stepd_step_rec_t *job)
 extern void
 batch_finish(stepd_step_rec_t *job, int rc)
 {
+	uint64_t span;
+
 	step_complete.step_rc = _get_exit_code(job);
 
 	if (job->argv[0] && (unlink(job->argv[0]) < 0))
@@ -364,12 +368,16 @@ batch_finish(stepd_step_rec_t *job, int rc)
 	} else if (job->step_id.step_id == SLURM_BATCH_SCRIPT) {
 		verbose("job %u completed with slurm_rc = %d, job_rc = %d",
 			job->step_id.job_id, rc, step_complete.step_rc);
+		span = trace_span_start();
 		_send_complete_batch_script_msg(job, rc, step_complete.step_rc);
+		trace_span_end("completion", span);
 	} else {
 		stepd_wait_for_children_slurmstepd(job);
 		verbose("%ps completed with slurm_rc = %d, job_rc = %d",
 			&job->step_id, rc, step_complete.step_rc);
+		span = trace_span_start();
 		stepd_send_step_complete_msgs(job);
+		trace_span_end("completion", span);
 	}
 
 	/* Do not purge directory until slurmctld is notified of batch job
@@ -1131,9 +1139,13 @@ job_manager(stepd_step_rec_t *job)
 {
 	int  rc = SLURM_SUCCESS;
 	bool io_initialized = false;
+	uint64_t span;
 
 	debug3("Entered job_manager for %ps pid=%d",
 	       &job->step_id, job->jmgr_pid);
+	trace_set_id(job->step_id.job_id);
+	if (job->batch)
+		job->launch_time[JOB_LAUNCH_STEPD] = slurm_time_usec();
 
 #ifdef PR_SET_DUMPABLE
 	if (prctl(PR_SET_DUMPABLE, 1) < 0)
@@ -1232,11 +1244,16 @@ job_manager(stepd_step_rec_t *job)
 	 * successful.  Only check for < 0 here since other slurm
 	 * error codes could come that are more descriptive.
 	 */
-	if ((rc = _fork_all_tasks(job, &io_initialized)) < 0) {
+	span = trace_span_start();
+	rc = _fork_all_tasks(job, &io_initialized);
+	trace_span_end("task_start", span);
+	if (rc < 0) {
 		debug("_fork_all_tasks failed");
 		rc = ESLURMD_EXECVE_FAILED;
 		goto fail3;
 	}
+	if (job->batch)
+		job->launch_time[JOB_LAUNCH_TASK] = slurm_time_usec();
 
 	/*
 	 * If IO initialization failed, return SLURM_SUCCESS (on a
@@ -1384,7 +1401,9 @@ fail1:
 			info("job_manager exiting with aborted job");
 		else
 			stepd_wait_for_children_slurmstepd(job);
+		span = trace_span_start();
 		stepd_send_step_complete_msgs(job);
+		trace_span_end("completion", span);
 	}
 
 	if (!job->batch && (job->step_id.step_id != SLURM_INTERACTIVE_STEP)
@@ -1621,6 +1640,15 @@ static void _unblock_signals (void)
 	xsignal_set_mask (&set);
 }
 
+/* Return usec elapsed since *tv and restart *tv at now, for phase timing */
+static long _phase_usec(struct timeval *tv)
+{
+	long usec = slurm_delta_tv(tv);
+
+	gettimeofday(tv, NULL);
+	return usec;
+}
+
 /*
  * fork and exec N tasks
  */
@@ -1635,6 +1663,8 @@ _fork_all_tasks(stepd_step_rec_t *job, bool *io_initialized)
 	List exec_wait_list = NULL;
 	uint32_t jobid;
 	uint32_t node_offset = 0, task_offset = 0;
+	struct timeval phase_tv;
+	long setup_usec, fork_usec, attach_usec;
 
 	if (job->het_job_node_offset != NO_VAL)
 		node_offset = job->het_job_node_offset;
@@ -1643,6 +1673,7 @@ _fork_all_tasks(stepd_step_rec_t *job, bool *io_initialized)
 
 	DEF_TIMERS;
 	START_TIMER;
+	gettimeofday(&phase_tv, NULL);
 
 	xassert(job != NULL);
 
@@ -1745,6 +1776,8 @@ _fork_all_tasks(stepd_step_rec_t *job, bool *io_initialized)
 
 	exec_wait_list = list_create ((ListDelF) _exec_wait_info_destroy);
 
+	setup_usec = _phase_usec(&phase_tv);
+
 	/*
 	 * Fork all of the task processes.
 	 */
@@ -1826,10 +1859,13 @@ _fork_all_tasks(stepd_step_rec_t *job, bool *io_initialized)
 
 		list_append (exec_wait_list, ei);
 
-		log_timestamp(time_stamp, sizeof(time_stamp));
-		verbose("task %lu (%lu) started %s",
-			(unsigned long) job->task[i]->gtid + task_offset,
-			(unsigned long) pid, time_stamp);
+		if (get_log_level() >= LOG_LEVEL_VERBOSE) {
+			log_timestamp(time_stamp, sizeof(time_stamp));
+			verbose("task %lu (%lu) started %s",
+				(unsigned long) job->task[i]->gtid +
+				task_offset,
+				(unsigned long) pid, time_stamp);
+		}
 
 		job->task[i]->pid = pid;
 		if (i == 0)
@@ -1840,6 +1876,7 @@ _fork_all_tasks(stepd_step_rec_t *job, bool *io_initialized)
 	 * All tasks are now forked and running as the user, but
 	 * will wait for our signal before calling exec.
 	 */
+	fork_usec = _phase_usec(&phase_tv);
 
 	/*
 	 * Reclaim privileges
@@ -1912,6 +1949,8 @@ _fork_all_tasks(stepd_step_rec_t *job, bool *io_initialized)
 #else
 	jobid = job->step_id.job_id;
 #endif
+	attach_usec = _phase_usec(&phase_tv);
+
 	if (container_g_add_cont(jobid, job->cont_id) != SLURM_SUCCESS)
 		error("container_g_add_cont(%u): %m", job->step_id.job_id);
 	if (!job->batch && (job->step_id.step_id != SLURM_INTERACTIVE_STEP) &&
@@ -1937,6 +1976,10 @@ _fork_all_tasks(stepd_step_rec_t *job, bool *io_initialized)
 		}
 	}
 	END_TIMER2(__func__);
+	log_flag(STEPS, "%s: %ps started %u tasks (%s): setup=%ldus fork=%ldus attach=%ldus release=%ldus",
+		 __func__, &job->step_id, job->node_tasks, TIME_STR,
+		 setup_usec, fork_usec, attach_usec,
+		 _phase_usec(&phase_tv));
 	return rc;
 
 fail4:
@@ -2465,6 +2508,7 @@ _send_complete_batch_script_msg(stepd_step_rec_t *job, int err, int status)
 	req.node_name	= job->node_name;
 	req.slurm_rc	= err;
 	req.user_id	= (uint32_t) job->uid;
+	memcpy(req.launch_time, job->launch_time, sizeof(req.launch_time));
 	slurm_msg_t_init(&req_msg);
 	req_msg.msg_type= REQUEST_COMPLETE_BATCH_SCRIPT;
 	req_msg.data	= &req;
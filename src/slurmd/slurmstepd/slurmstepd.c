@@ -58,6 +58,7 @@
 #include "src/common/slurm_rlimits_info.h"
 #include "src/common/stepd_api.h"
 #include "src/common/switch.h"
+#include "src/common/trace.h"
 #include "src/common/xcgroup_read_config.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xsignal.h"
@@ -202,6 +203,8 @@ extern int stepd_cleanup(slurm_msg_t *msg, stepd_step_rec_t *job,
 	if (conf->hwloc_xml)
 		(void)remove(conf->hwloc_xml);
 
+	trace_dump(conf->spooldir, "slurmstepd");
+
 #ifdef MEMORY_LEAK_DEBUG
 	acct_gather_conf_destroy();
 	(void) core_spec_g_fini();
@@ -529,6 +532,10 @@ _init_from_slurmd(int sock, char **argv,
 	if (acct_gather_read_conf(sock) != SLURM_SUCCESS)
 		fatal("Failed to read acct_gather conf from slurmd");
 
+	/* receive resolved plugstack.conf from slurmd */
+	if (spank_stack_read_conf(sock) != SLURM_SUCCESS)
+		fatal("Failed to read plugstack conf from slurmd");
+
 	/* receive job type from slurmd */
 	safe_read(sock, &step_type, sizeof(int));
 	debug3("step_type = %d", step_type);
@@ -640,6 +647,7 @@ _init_from_slurmd(int sock, char **argv,
 	safe_read(sock, conf->node_name, len);
 
 	_set_job_log_prefix(&step_id);
+	acct_gather_energy_set_spooldir(conf->spooldir);
 
 	if (!conf->hwloc_xml) {
 		conf->hwloc_xml = xstrdup_printf("%s/hwloc_topo_%u.%u",
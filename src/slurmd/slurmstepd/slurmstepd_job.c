@@ -540,6 +540,7 @@ batch_stepd_step_rec_create(batch_job_launch_msg_t *msg)
 
 	job->batch   = true;
 	job->node_name  = xstrdup(conf->node_name);
+	memcpy(job->launch_time, msg->launch_time, sizeof(job->launch_time));
 
 	job->uid	= (uid_t) msg->uid;
 	job->gid	= (gid_t) msg->gid;
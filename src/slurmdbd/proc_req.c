@@ -964,8 +964,17 @@ static int _get_jobs_cond(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 			list_msg.my_list = list_create(NULL);
 		*out_buffer = init_buf(1024);
 		pack16((uint16_t) DBD_GOT_JOBS, *out_buffer);
-		slurmdbd_pack_list_msg(&list_msg, slurmdbd_conn->conn->version,
-				       DBD_GOT_JOBS, *out_buffer);
+		/*
+		 * Same layout as slurmdbd_pack_list_msg(), but free each job
+		 * as it is packed. A wide sacct query can return millions of
+		 * records and we don't want to hold them and their packed
+		 * copy at the same time.
+		 */
+		list_msg.return_code = slurm_pack_list_consume(
+			list_msg.my_list, slurmdb_pack_job_rec,
+			slurmdb_destroy_job_rec, *out_buffer,
+			slurmdbd_conn->conn->version);
+		pack32(list_msg.return_code, *out_buffer);
 	} else {
 		*out_buffer = slurm_persist_make_rc_msg(slurmdbd_conn->conn,
 							errno,
@@ -2865,6 +2874,12 @@ static int _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 
 	list_msg.my_list = list_create(slurmdbd_free_buffer);
 	/* START_TIMER; */
+	/*
+	 * Let proc_req() commit the whole batch once when we return instead
+	 * of after every sub message. Each commit is a log flush in InnoDB,
+	 * which limits how fast a backlog from the slurmctld can drain.
+	 */
+	slurmdbd_conn->in_mult_msg = true;
 	itr = list_iterator_create(get_msg->my_list);
 	while ((req_buf = list_next(itr))) {
 		persist_msg_t sub_msg;
@@ -2887,6 +2902,7 @@ static int _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 			break;
 	}
 	list_iterator_destroy(itr);
+	slurmdbd_conn->in_mult_msg = false;
 	/* END_TIMER; */
 	/* info("%d multi took %s", list_count(get_msg->my_list), TIME_STR); */
 
@@ -3366,7 +3382,8 @@ extern int proc_req(void *conn, persist_msg_t *msg, buf_t **out_buffer,
 		      slurmdbd_conn->conn->fd,
 		      slurmdbd_msg_type_2_str(msg->msg_type, 1));
 	else if (slurmdbd_conn->conn->rem_port
-		 && !slurmdbd_conf->commit_delay) {
+		 && !slurmdbd_conf->commit_delay
+		 && !slurmdbd_conn->in_mult_msg) {
 		/* If we are dealing with the slurmctld do the
 		   commit (SUCCESS or NOT) afterwards since we
 		   do transactions for performance reasons.
@@ -184,6 +184,7 @@ extern int read_slurmdbd_conf(void)
 	s_p_hashtbl_t *tbl = NULL;
 	char *conf_path = NULL;
 	char *temp_str = NULL;
+	char *tmp_ptr = NULL;
 	struct stat buf;
 
 	/* Set initial values */
@@ -330,12 +331,23 @@ extern int read_slurmdbd_conf(void)
 		else if (slurm_conf.msg_timeout > 100)
 			info("WARNING: MessageTimeout is too high for effective fault-tolerance");
 
+		slurmdbd_conf->rollup_threads = 1;
 		s_p_get_string(&slurmdbd_conf->parameters, "Parameters", tbl);
 		if (slurmdbd_conf->parameters) {
 			if (xstrcasestr(slurmdbd_conf->parameters,
 					"PreserveCaseUser"))
 				slurmdbd_conf->persist_conn_rc_flags |=
 					PERSIST_FLAG_P_USER_CASE;
+			if ((tmp_ptr = xstrcasestr(slurmdbd_conf->parameters,
+						   "rollup_threads="))) {
+				int threads = atoi(tmp_ptr + 15);
+				if ((threads < 1) || (threads > 64)) {
+					error("Invalid rollup_threads value %d, using 1",
+					      threads);
+					threads = 1;
+				}
+				slurmdbd_conf->rollup_threads = threads;
+			}
 		}
 
 		s_p_get_string(&slurmdbd_conf->pid_file, "PidFile", tbl);
@@ -70,6 +70,8 @@
 #define MAGIC_WRAP_WORK 0xD231444A
 /* Default buffer to 1 page */
 #define BUFFER_START_SIZE 4096
+/* largest idle buffer to keep for reuse */
+#define BUFFER_POOL_MAX_SIZE (BUFFER_START_SIZE * 16)
 #define MAX_OPEN_CONNECTIONS 124
 
 /*
@@ -160,6 +162,42 @@ static inline void _check_magic_fd(con_mgr_fd_t *con)
 	}
 }
 
+static void _free_buffer(void *x)
+{
+	buf_t *buf = x;
+
+	FREE_NULL_BUFFER(buf);
+}
+
+/* Get buffer for new connection from pool or create a new one */
+static buf_t *_get_buffer(con_mgr_t *mgr)
+{
+	buf_t *buf = list_pop(mgr->buffers);
+
+	if (buf) {
+		set_buf_offset(buf, 0);
+		return buf;
+	}
+
+	return create_buf(xmalloc(BUFFER_START_SIZE), BUFFER_START_SIZE);
+}
+
+/* Return buffer of closed connection to pool */
+static void _put_buffer(con_mgr_t *mgr, buf_t *buf)
+{
+	if (!buf)
+		return;
+
+	/* avoid holding on to buffers grown for large requests/responses */
+	if ((size_buf(buf) > BUFFER_POOL_MAX_SIZE) ||
+	    (list_count(mgr->buffers) >= (MAX_OPEN_CONNECTIONS * 2))) {
+		free_buf(buf);
+		return;
+	}
+
+	list_push(mgr->buffers, buf);
+}
+
 static void _connection_fd_delete(void *x)
 {
 	con_mgr_fd_t *con = x;
@@ -181,8 +219,10 @@ static void _connection_fd_delete(void *x)
 	else
 		xassert(!list_remove_first(mgr->connections, _find_by_ptr,
 					   con));
-	FREE_NULL_BUFFER(con->in);
-	FREE_NULL_BUFFER(con->out);
+	_put_buffer(mgr, con->in);
+	con->in = NULL;
+	_put_buffer(mgr, con->out);
+	con->out = NULL;
 	FREE_NULL_LIST(con->work);
 	xfree(con->name);
 	xfree(con->unix_socket);
@@ -218,6 +258,7 @@ extern con_mgr_t *init_con_mgr(int thread_count)
 	mgr->magic = MAGIC_CON_MGR;
 	mgr->connections = list_create(NULL);
 	mgr->listen = list_create(NULL);
+	mgr->buffers = list_create(_free_buffer);
 
 	slurm_mutex_init(&mgr->mutex);
 	slurm_cond_init(&mgr->cond, NULL);
@@ -341,6 +382,7 @@ extern void free_con_mgr(con_mgr_t *mgr)
 	xassert(list_is_empty(mgr->listen));
 	FREE_NULL_LIST(mgr->connections);
 	FREE_NULL_LIST(mgr->listen);
+	FREE_NULL_LIST(mgr->buffers);
 
 	slurm_mutex_destroy(&mgr->mutex);
 	slurm_cond_destroy(&mgr->cond);
@@ -455,10 +497,8 @@ static con_mgr_fd_t *_add_connection(con_mgr_t *mgr, con_mgr_fd_t *source,
 	};
 
 	if (!is_listen) {
-		con->in = create_buf(xmalloc(BUFFER_START_SIZE),
-				     BUFFER_START_SIZE);
-		con->out = create_buf(xmalloc(BUFFER_START_SIZE),
-				      BUFFER_START_SIZE);
+		con->in = _get_buffer(mgr);
+		con->out = _get_buffer(mgr);
 	}
 
 	/* listen on unix socket */
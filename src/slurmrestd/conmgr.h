@@ -195,6 +195,11 @@ struct con_mgr_s {
 	bool exit_on_error;
 	/* First observed error */
 	int error;
+	/*
+	 * idle buffers to reuse for new connections
+	 * type: buf_t
+	 */
+	List buffers;
 
 	pthread_mutex_t mutex;
 	/* called after events or changes to wake up _watch */
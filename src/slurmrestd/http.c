@@ -128,6 +128,33 @@ static void _free_request_t(request_t *request)
 	xfree(request);
 }
 
+/*
+ * Reset request to allow persistent connections to continue but without
+ * inheriting previous requests while reusing the allocated request.
+ */
+static void _reset_request_t(request_t *request)
+{
+	List headers = request->headers;
+	http_context_t *context = request->context;
+
+	xassert(request->magic == MAGIC_REQUEST_T);
+
+	list_flush(headers);
+	xfree(request->path);
+	xfree(request->query);
+	xfree(request->last_header);
+	xfree(request->content_type);
+	xfree(request->accept);
+	xfree(request->body);
+	xfree(request->body_encoding);
+
+	*request = (request_t) {
+		.magic = MAGIC_REQUEST_T,
+		.headers = headers,
+		.context = context,
+	};
+}
+
 static void _http_parser_url_init(struct http_parser_url *url)
 {
 #if (HTTP_PARSER_VERSION_MAJOR == 2 && HTTP_PARSER_VERSION_MINOR >= 6) || \
@@ -472,12 +499,66 @@ static int _write_fmt_num_header(con_mgr_fd_t *con, const char *name,
 	return rc;
 }
 
+extern int send_http_chunk(con_mgr_fd_t *con, const char *buf, size_t len)
+{
+	char *buffer = NULL;
+	int rc;
+
+	/* zero length chunk would terminate the body */
+	if (!len)
+		return SLURM_SUCCESS;
+
+	/* RFC7230-4.1 chunk size in hex */
+	xstrfmtcat(buffer, "%zx"CRLF, len);
+	rc = con_mgr_queue_write_fd(con, buffer, strlen(buffer));
+	xfree(buffer);
+
+	if (!rc)
+		rc = con_mgr_queue_write_fd(con, buf, len);
+	if (!rc)
+		rc = con_mgr_queue_write_fd(con, CRLF, strlen(CRLF));
+
+	return rc;
+}
+
+static int _send_chunked_body(const send_http_response_args_t *args)
+{
+	static const char last_chunk[] = "0"CRLF CRLF;
+	int rc;
+
+	if ((rc = _write_fmt_header(args->con, "Transfer-Encoding",
+				    "chunked")))
+		return rc;
+
+	if (args->body_encoding &&
+	    (rc = _write_fmt_header(args->con, "Content-Type",
+				    args->body_encoding)))
+		return rc;
+
+	if ((rc = con_mgr_queue_write_fd(args->con, CRLF, strlen(CRLF))))
+		return rc;
+
+	debug5("%s: [%s] rc=%s(%u) streaming chunked body",
+	       __func__, args->con->name,
+	       get_http_status_code_string(args->status_code),
+	       args->status_code);
+
+	if ((rc = args->body_writer(args->con, args->body_writer_arg)))
+		return rc;
+
+	return con_mgr_queue_write_fd(args->con, last_chunk,
+				      strlen(last_chunk));
+}
+
 extern int send_http_response(const send_http_response_args_t *args)
 {
 	char *buffer = NULL;
 	int rc = SLURM_SUCCESS;
 	xassert(args->status_code != HTTP_STATUS_NONE);
 	xassert(args->body_length == 0 || (args->body_length && args->body));
+	xassert(!args->body_writer || !args->body);
+	xassert(!args->body_writer || (args->http_major > 1) ||
+		((args->http_major == 1) && (args->http_minor >= 1)));
 
 	log_flag(NET, "%s: [%s] sending response %u: %s",
 	       __func__, args->con->name,
@@ -489,28 +570,25 @@ extern int send_http_response(const send_http_response_args_t *args)
 		   args->http_major, args->http_minor, args->status_code,
 		   get_http_status_code_string(args->status_code));
 
-	rc = con_mgr_queue_write_fd(args->con, buffer, strlen(buffer));
-	xfree(buffer);
-
-	if (rc)
-		return rc;
-
-	/* send along any requested headers */
+	/* send along any requested headers in the same write */
 	if (args->headers) {
 		ListIterator itr = list_iterator_create(args->headers);
 		http_header_entry_t *header = NULL;
-		while ((header = list_next(itr))) {
-			if ((rc = _write_fmt_header(args->con, header->name,
-						    header->value)))
-				break;
-		}
+		while ((header = list_next(itr)))
+			xstrfmtcat(buffer, "%s: %s"CRLF, header->name,
+				   header->value);
 		list_iterator_destroy(itr);
-
-		if (rc)
-			return rc;
 	}
 
-	if (args->body && args->body_length) {
+	rc = con_mgr_queue_write_fd(args->con, buffer, strlen(buffer));
+	xfree(buffer);
+
+	if (rc)
+		return rc;
+
+	if (args->body_writer) {
+		return _send_chunked_body(args);
+	} else if (args->body && args->body_length) {
 		/* RFC7230-3.3.2 limits response of Content-Length */
 		if ((args->status_code < 100) ||
 		    ((args->status_code >= 200) &&
@@ -738,27 +816,23 @@ static int _on_message_complete(http_parser *parser)
 	}
 
 	if (!request->connection_close) {
-		/*
-		 * Create a new HTTP request to allow persistent connections to
-		 * continue but without inheirting previous requests.
-		 */
-		request_t *nrequest = xmalloc(sizeof(*request));
-		nrequest->magic = MAGIC_REQUEST_T;
-		nrequest->headers = list_create(_free_http_header);
-		nrequest->context = request->context;
-		request->context->request = nrequest;
-		parser->data = nrequest;
-		_free_request_t(request);
+		/* any pipelined requests are parsed into the same request */
+		_reset_request_t(request);
 	} else {
 		/* Notify client that this connection will be closed now */
-		if (request->connection_close)
-			send_http_connection_close(request->context);
+		send_http_connection_close(request->context);
 
 		con_mgr_queue_close_fd(request->context->con);
 
 		request->context->request = NULL;
 		_free_request_t(request);
 		parser->data = NULL;
+
+		/*
+		 * Stop parser from handing any further pipelined requests
+		 * to the released request.
+		 */
+		return HTTP_PARSER_RETURN_ERROR;
 	}
 
 	return 0;
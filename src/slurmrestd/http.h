@@ -200,6 +200,15 @@ typedef http_context_t *(*on_http_connection_t)(int fd);
  */
 extern int parse_http(con_mgr_fd_t *con, void *context);
 
+/*
+ * Call back to stream body of a response
+ * Must only write the body using send_http_chunk().
+ * IN con conmgr connection of client
+ * IN arg arbitrary pointer from send_http_response_args_t
+ * RET SLURM_SUCCESS or error to kill connection
+ */
+typedef int (*http_body_writer_t)(con_mgr_fd_t *con, void *arg);
+
 typedef struct {
 	con_mgr_fd_t *con; /* assigned connection */
 	uint16_t http_major; /* HTTP major version */
@@ -209,6 +218,12 @@ typedef struct {
 	const char *body; /* body to send or NULL */
 	size_t body_length; /* bytes in body to send or 0 */
 	const char *body_encoding; /* body encoding type or NULL */
+	/*
+	 * Stream body with chunked transfer encoding instead of sending body.
+	 * Only valid for HTTP/1.1 or later.
+	 */
+	http_body_writer_t body_writer;
+	void *body_writer_arg; /* arg to hand to body_writer */
 } send_http_response_args_t;
 
 /*
@@ -226,6 +241,16 @@ extern int send_http_connection_close(http_context_t *ctxt);
  */
 extern int send_http_response(const send_http_response_args_t *args);
 
+/*
+ * Send chunk of HTTP response body using chunked transfer encoding
+ * Only valid from inside of http_body_writer_t.
+ * IN con conmgr connection of client
+ * IN buf body bytes to send
+ * IN len number of bytes in buf (0 is ignored)
+ * RET SLURM_SUCESS or error
+ */
+extern int send_http_chunk(con_mgr_fd_t *con, const char *buf, size_t len);
+
 typedef struct {
 	const char *host;
 	const char *port; /* port as string for later parsing */
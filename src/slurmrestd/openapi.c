@@ -46,6 +46,7 @@
 #include "src/common/plugin.h"
 #include "src/common/ref.h"
 #include "src/common/xassert.h"
+#include "src/common/xhash.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
@@ -58,9 +59,11 @@
 decl_static_data(openapi_json);
 
 #define MAGIC_PATH 0x1111beef
+#define MAGIC_PATH_NODE 0x1112beef
 
 static pthread_rwlock_t paths_lock = PTHREAD_RWLOCK_INITIALIZER;
 static List paths = NULL;
+static struct path_node_s *path_root = NULL;
 static int path_tag_counter = 0;
 static data_t **spec = NULL;
 
@@ -177,15 +180,25 @@ typedef struct {
 } entry_t;
 
 typedef struct {
-	entry_t *entries;
-	http_request_method_t method;
-} entry_method_t;
-
-typedef struct {
-	entry_method_t *methods;
+	int magic;
 	int tag;
+	List nodes; /* list of path_node_t where path ends */
 } path_t;
 
+/*
+ * Registered paths are compiled into a trie of path entries to avoid
+ * walking every path for every request.
+ */
+typedef struct path_node_s {
+	int magic;
+	char *entry; /* path entry as given in OAS */
+	char *name; /* parameter name or NULL for string match */
+	parameter_type_t parameter;
+	xhash_t *strings; /* string match children keyed by entry */
+	List params; /* parameter match children */
+	List paths; /* path_t ending at this node (first is used) */
+} path_node_t;
+
 static entry_t *_parse_openapi_path(const char *str_path)
 {
 	char *save_ptr = NULL;
@@ -416,8 +429,122 @@ static const data_t *_find_spec_path(const char *str_path)
 	return args.found;
 }
 
+static void _check_path_node_magic(const path_node_t *node)
+{
+	xassert(node->magic == MAGIC_PATH_NODE);
+	xassert(node->paths);
+}
+
+static void _path_node_id(void *item, const char **key, uint32_t *key_len)
+{
+	path_node_t *node = item;
+
+	_check_path_node_magic(node);
+
+	*key = node->entry;
+	*key_len = strlen(node->entry);
+}
+
+static void _free_path_node(void *x)
+{
+	path_node_t *node = x;
+
+	if (!node)
+		return;
+
+	_check_path_node_magic(node);
+
+	xhash_free(node->strings);
+	FREE_NULL_LIST(node->params);
+	FREE_NULL_LIST(node->paths);
+	xfree(node->entry);
+	xfree(node->name);
+	node->magic = ~MAGIC_PATH_NODE;
+	xfree(node);
+}
+
+static path_node_t *_new_path_node(const entry_t *entry)
+{
+	path_node_t *node = xmalloc(sizeof(*node));
+
+	node->magic = MAGIC_PATH_NODE;
+	node->paths = list_create(NULL);
+
+	if (entry) {
+		node->entry = xstrdup(entry->entry);
+		node->name = xstrdup(entry->name);
+		node->parameter = entry->parameter;
+	}
+
+	return node;
+}
+
+static int _match_param_node(void *x, void *key)
+{
+	path_node_t *node = x;
+	entry_t *entry = key;
+
+	return (!xstrcmp(node->name, entry->name) &&
+		(node->parameter == entry->parameter));
+}
+
+/* find or add child node of parent matching entry */
+static path_node_t *_add_path_node(path_node_t *parent, const entry_t *entry)
+{
+	path_node_t *node;
+
+	_check_path_node_magic(parent);
+
+	if (entry->type == OPENAPI_PATH_ENTRY_MATCH_STRING) {
+		if (!parent->strings)
+			parent->strings = xhash_init(_path_node_id,
+						     _free_path_node);
+		else if ((node = xhash_get_str(parent->strings, entry->entry)))
+			return node;
+
+		node = _new_path_node(entry);
+		xhash_add(parent->strings, node);
+	} else {
+		xassert(entry->type == OPENAPI_PATH_ENTRY_MATCH_PARAMETER);
+
+		if (!parent->params)
+			parent->params = list_create(_free_path_node);
+		else if ((node = list_find_first(parent->params,
+						 _match_param_node,
+						 (void *) entry)))
+			return node;
+
+		node = _new_path_node(entry);
+		list_append(parent->params, node);
+	}
+
+	debug5("%s: added %s path node entry:%s name:%s parameter:%s",
+	       __func__, _get_entry_type_string(entry->type), node->entry,
+	       node->name, _get_parameter_type_string(node->parameter));
+
+	return node;
+}
+
+static int _match_ptr(void *x, void *key)
+{
+	return (x == key);
+}
+
+static void _compile_path(path_t *path, const entry_t *entries)
+{
+	path_node_t *node = path_root;
+
+	for (const entry_t *entry = entries; entry->type; entry++)
+		node = _add_path_node(node, entry);
+
+	if (list_find_first(path->nodes, _match_ptr, node))
+		return;
+
+	list_append(path->nodes, node);
+	list_append(node->paths, path);
+}
+
 typedef struct {
-	entry_method_t *method;
 	entry_t *entries;
 	path_t *path;
 } populate_methods_t;
@@ -460,13 +587,11 @@ static data_for_each_cmd_t _populate_methods(const char *key,
 					     void *arg)
 {
 	populate_methods_t *args = arg;
-	populate_methods_t nargs = *args;
-	entry_method_t *method = args->method;
+	http_request_method_t method;
 	const data_t *para;
-	int count = 0;
 	entry_t *entry;
 
-	if ((method->method = get_http_method(key)) == HTTP_REQUEST_INVALID)
+	if ((method = get_http_method(key)) == HTTP_REQUEST_INVALID)
 		/* Ignore none HTTP method dictionary keys */
 		return DATA_FOR_EACH_CONT;
 
@@ -474,46 +599,28 @@ static data_for_each_cmd_t _populate_methods(const char *key,
 		fatal("%s: unexpected data type %s instead of dictionary",
 		      __func__, data_type_to_string(data_get_type(data)));
 
+	/* parameter types are per method */
 	for (entry = args->entries; entry->type; entry++)
-		count++;
-
-	if (!method->entries) {
-		/* only add entries on first method parse */
-		method->entries = xcalloc((count + 1), sizeof(entry_t));
-		/* count is already bounded */
-		memcpy(method->entries, args->entries,
-		       (count * sizeof(entry_t)));
-	}
-
-	/* unlink strings from source */
-	for (entry = args->entries; entry->type; entry++) {
-		entry->entry = NULL;
-		entry->name = NULL;
-	}
-
-	/* point to new entries clone */
-	nargs.entries = method->entries;
+		entry->parameter = OPENAPI_TYPE_UNKNOWN;
 
 	para = data_key_get_const(data, "parameters");
-	if (!para)
-		return DATA_FOR_EACH_CONT;
-	if (data_get_type(para) != DATA_TYPE_LIST)
+	if (para && (data_get_type(para) != DATA_TYPE_LIST))
 		return DATA_FOR_EACH_FAIL;
-	if (data_list_for_each_const(para, _populate_parameters, &nargs) < 0)
+	if (para &&
+	    (data_list_for_each_const(para, _populate_parameters, args) < 0))
 		return DATA_FOR_EACH_FAIL;
 
-	/* increment to next method entry */
-	args->method++;
-
 	if (get_log_level() >= LOG_LEVEL_DEBUG5)
-		for (entry = method->entries; entry->type; entry++) {
+		for (entry = args->entries; entry->type; entry++) {
 			debug5("%s: add method:%s for path tag:%d entry:%s name:%s parameter:%s entry_type:%s",
-			       __func__, key, args->path->tag, entry->entry,
-			       entry->name,
+			       __func__, get_http_method_string(method),
+			       args->path->tag, entry->entry, entry->name,
 			       _get_parameter_type_string(entry->parameter),
 			       _get_entry_type_string(entry->type));
 		}
 
+	_compile_path(args->path, args->entries);
+
 	return DATA_FOR_EACH_CONT;
 }
 
@@ -523,36 +630,40 @@ extern int register_path_tag(const char *str_path)
 	const data_t *spec_entry;
 	populate_methods_t args = {0};
 	entry_t *entries = _parse_openapi_path(str_path);
+	int tag = -1;
 
 	if (!entries)
 		return -1;
 
-	spec_entry = _find_spec_path(str_path);
-	if (!spec_entry)
-		return -1;
+	slurm_rwlock_wrlock(&paths_lock);
 
-	if (data_get_type(spec_entry) != DATA_TYPE_DICT)
-		return -1;
+	spec_entry = _find_spec_path(str_path);
+	if (!spec_entry || (data_get_type(spec_entry) != DATA_TYPE_DICT))
+		goto cleanup;
 
 	path = xmalloc(sizeof(*path));
+	path->magic = MAGIC_PATH;
 	path->tag = path_tag_counter++;
-	path->methods = xcalloc((data_get_dict_length(spec_entry) + 1),
-				sizeof(*path->methods));
+	path->nodes = list_create(NULL);
 
-	args.method = path->methods;
 	args.entries = entries;
 	args.path = path;
 	if (data_dict_for_each_const(spec_entry, _populate_methods, &args) < 0)
 		fatal_abort("%s: failed", __func__);
 
+	list_append(paths, path);
+	tag = path->tag;
+
+cleanup:
+	slurm_rwlock_unlock(&paths_lock);
+
 	for (entry_t *entry = entries; entry->type; entry++) {
 		xfree(entry->entry);
 		xfree(entry->name);
 	}
 	xfree(entries);
-	list_append(paths, path);
 
-	return path->tag;
+	return tag;
 }
 
 static int _rm_path_by_tag(void *x, void *tptr)
@@ -578,34 +689,24 @@ extern void unregister_path_tag(int tag)
 	slurm_rwlock_unlock(&paths_lock);
 }
 
-typedef struct {
-	bool matched;
-	const data_t *dpath;
-	path_t *path;
-	data_t *params;
-	http_request_method_t method;
-	entry_t *entry;
-} match_path_from_data_t;
-
 /*
  * Check if the entry matches based on the OAS type
  * and if it does, then add that matched parameter
  */
-static bool _match_param(const data_t *data, match_path_from_data_t *args)
+static bool _match_param(const data_t *data, const path_node_t *node,
+			 data_t *params)
 {
 	bool matched = false;
-	entry_t *entry = args->entry;
-	data_t *params = args->params;
 	data_t *match = data_new();
 
 	data_copy(match, data);
 
-	switch (entry->parameter) {
+	switch (node->parameter) {
 	case OPENAPI_TYPE_NUMBER:
 	{
 		if (data_convert_type(match, DATA_TYPE_FLOAT) ==
 		    DATA_TYPE_FLOAT) {
-			data_set_float(data_key_set(params, entry->name),
+			data_set_float(data_key_set(params, node->name),
 				       data_get_float(match));
 			matched = true;
 		}
@@ -615,7 +716,7 @@ static bool _match_param(const data_t *data, match_path_from_data_t *args)
 	{
 		if (data_convert_type(match, DATA_TYPE_INT_64) ==
 		    DATA_TYPE_INT_64) {
-			data_set_int(data_key_set(params, entry->name),
+			data_set_int(data_key_set(params, node->name),
 				     data_get_int(match));
 			matched = true;
 		}
@@ -623,13 +724,13 @@ static bool _match_param(const data_t *data, match_path_from_data_t *args)
 	}
 	default: /* assume string */
 		debug("%s: unknown parameter type %s",
-		      __func__, _get_parameter_type_string(entry->parameter));
+		      __func__, _get_parameter_type_string(node->parameter));
 		/* fall through */
 	case OPENAPI_TYPE_STRING:
 	{
 		if (data_convert_type(match, DATA_TYPE_STRING) ==
 		    DATA_TYPE_STRING) {
-			data_set_string(data_key_set(params, entry->name),
+			data_set_string(data_key_set(params, node->name),
 					data_get_string(match));
 			matched = true;
 		}
@@ -642,8 +743,8 @@ static bool _match_param(const data_t *data, match_path_from_data_t *args)
 		data_get_string_converted(data, &str);
 
 		debug5("%s: parameter %s[%s]->%s[%s] result=%s",
-		       __func__, entry->name,
-		       _get_parameter_type_string(entry->parameter),
+		       __func__, node->name,
+		       _get_parameter_type_string(node->parameter),
 		       str, data_type_to_string(data_get_type(data)),
 		       (matched ? "matched" : "failed"));
 
@@ -654,92 +755,106 @@ static bool _match_param(const data_t *data, match_path_from_data_t *args)
 	return matched;
 }
 
-static data_for_each_cmd_t _match_path(const data_t *data, void *y)
+typedef struct {
+	const data_t **entries; /* split up path requested */
+	int count; /* number of entries */
+	data_t *params;
+} match_path_from_data_t;
+
+static data_for_each_cmd_t _split_path(const data_t *data, void *arg)
 {
-	match_path_from_data_t *args = y;
-	entry_t *entry = args->entry;
-	args->matched = false;
+	match_path_from_data_t *args = arg;
 
-	if (!entry->type)
-		return DATA_FOR_EACH_FAIL;
+	args->entries[args->count++] = data;
 
-	if (entry->type == OPENAPI_PATH_ENTRY_MATCH_STRING) {
-		bool match;
+	return DATA_FOR_EACH_CONT;
+}
 
-		if (data_get_type(data) != DATA_TYPE_STRING)
-			return DATA_FOR_EACH_FAIL;
+/*
+ * Walk trie to find path ending at entry count
+ * String matches are always preferred over parameter matches.
+ * RET path or NULL if not found
+ */
+static path_t *_match_path_node(const path_node_t *node,
+				match_path_from_data_t *args, int depth)
+{
+	const data_t *data;
+	path_node_t *child;
+	path_t *path = NULL;
 
-		match = !xstrcmp(data_get_string_const(data), entry->entry);
+	_check_path_node_magic(node);
 
-		debug5("%s: string attempt match %s to %s: %s",
-		       __func__, entry->entry, data_get_string_const(data),
-		       (match ? "SUCCESS" : "FAILURE"));
+	if (depth == args->count)
+		return list_peek(node->paths);
 
-		if (!match)
-			return DATA_FOR_EACH_FAIL;
-	} else if (entry->type == OPENAPI_PATH_ENTRY_MATCH_PARAMETER) {
-		if (!_match_param(data, args))
-			return DATA_FOR_EACH_FAIL;
-	} else
-		fatal_abort("%s: unknown OAS path entry match type",
-			    __func__);
+	data = args->entries[depth];
 
-	args->entry++;
-	args->matched = true;
-	return DATA_FOR_EACH_CONT;
-}
+	if (node->strings && (data_get_type(data) == DATA_TYPE_STRING) &&
+	    (child = xhash_get_str(node->strings,
+				   data_get_string_const(data)))) {
+		debug5("%s: string match %s at depth %d",
+		       __func__, child->entry, depth);
 
-static int _match_path_from_data(void *x, void *key)
-{
-	match_path_from_data_t *args = key;
-	path_t *path = x;
-	entry_method_t *method;
+		if ((path = _match_path_node(child, args, (depth + 1))))
+			return path;
+	}
 
-	args->path = path;
-	for (method = path->methods; method->entries; method++) {
-		args->entry = method->entries;
-		data_list_for_each_const(args->dpath, _match_path, args);
+	if (node->params) {
+		ListIterator itr = list_iterator_create(node->params);
 
-		if (args->matched)
-			break;
-	}
+		while (!path && (child = list_next(itr))) {
+			if (!_match_param(data, child, args->params))
+				continue;
 
-	if (get_log_level() >= LOG_LEVEL_DEBUG5) {
-		char *str_path = dump_json(args->dpath,
-					   DUMP_JSON_FLAGS_COMPACT);
-		if (args->matched)
-			debug5("%s: match successful for tag %d to %s(0x%"PRIXPTR")",
-			       __func__, args->path->tag, str_path,
-			       (uintptr_t) args->dpath);
-		else
-			debug5("%s: match failed for tag %d to %s(0x%"PRIXPTR")",
-			       __func__, args->path->tag, str_path,
-			       (uintptr_t) args->dpath);
-		xfree(str_path);
+			if (!(path = _match_path_node(child, args,
+						      (depth + 1))))
+				data_key_unset(args->params, child->name);
+		}
+
+		list_iterator_destroy(itr);
 	}
 
-	return (args->matched ? 1 : 0);
+	return path;
 }
 
 extern int find_path_tag(const data_t *dpath, data_t *params,
 			 http_request_method_t method)
 {
-	path_t *path;
+	path_t *path = NULL;
 	int tag = -1;
 	match_path_from_data_t args = {
 		.params = params,
-		.dpath = dpath,
 	};
 
 	xassert(data_get_type(params) == DATA_TYPE_DICT);
+
+	if (data_get_type(dpath) != DATA_TYPE_LIST)
+		return -1;
+
+	args.entries = xcalloc((data_get_list_length(dpath) + 1),
+			       sizeof(*args.entries));
+	(void) data_list_for_each_const(dpath, _split_path, &args);
+
 	slurm_rwlock_rdlock(&paths_lock);
 
-	path = list_find_first(paths, _match_path_from_data, &args);
+	/* empty path never matched any registered path */
+	if (args.count && path_root)
+		path = _match_path_node(path_root, &args, 0);
 	if (path)
 		tag = path->tag;
 
 	slurm_rwlock_unlock(&paths_lock);
 
+	if (get_log_level() >= LOG_LEVEL_DEBUG5) {
+		char *str_path = dump_json(dpath, DUMP_JSON_FLAGS_COMPACT);
+		debug5("%s: match %s for tag %d to %s(0x%"PRIXPTR")",
+		       __func__, (path ? "successful" : "failed"), tag,
+		       str_path, (uintptr_t) dpath);
+		xfree(str_path);
+	}
+
+	xfree(args.entries);
+
 	return tag;
 }
 
@@ -1037,40 +1152,33 @@ static int _get_openapi_specification(data_t *resp)
 	return SLURM_SUCCESS;
 }
 
-static void _list_delete_path_t(void *x)
+static int _rm_path_from_node(void *x, void *arg)
 {
-	entry_method_t *method;
+	path_node_t *node = x;
 
-	if (!x)
-		return;
+	_check_path_node_magic(node);
+	list_delete_ptr(node->paths, arg);
 
-	path_t *path = x;
-	xassert(path->tag != -1);
-	method = path->methods;
+	return 0;
+}
 
-	while (method->method) {
-		entry_t *entry = method->entries;
+static void _list_delete_path_t(void *x)
+{
+	path_t *path = x;
 
-		debug5("%s: remove path tag:%d method:%s",
-		       __func__, path->tag,
-		       get_http_method_string(method->method));
+	if (!path)
+		return;
 
-		while (entry->type) {
-			debug5("%s: remove path tag:%d method:%s entry:%s name:%s",
-			       __func__, path->tag,
-			       get_http_method_string(method->method),
-			       entry->entry, entry->name);
+	xassert(path->magic == MAGIC_PATH);
+	xassert(path->tag != -1);
 
-			xfree(entry->entry);
-			xfree(entry->name);
-			entry++;
-		}
+	debug5("%s: remove path tag:%d", __func__, path->tag);
 
-		xfree(method->entries);
-		method++;
-	}
+	/* path nodes are kept but no longer resolve to this path */
+	list_for_each(path->nodes, _rm_path_from_node, path);
+	FREE_NULL_LIST(path->nodes);
 
-	xfree(path->methods);
+	path->magic = ~MAGIC_PATH;
 	xfree(path);
 }
 
@@ -1097,6 +1205,7 @@ extern int init_openapi(const plugin_handle_t *plugin_handles,
 		fatal_abort("%s called twice", __func__);
 
 	paths = list_create(_list_delete_path_t);
+	path_root = _new_path_node(NULL);
 
 	/* Load OpenAPI plugins */
 	xassert(g_context_cnt == -1);
@@ -1160,6 +1269,8 @@ extern void destroy_openapi(void)
 	g_context_cnt = -1;
 
 	FREE_NULL_LIST(paths);
+	_free_path_node(path_root);
+	path_root = NULL;
 
 	for (size_t i = 0; spec[i]; i++)
 		FREE_NULL_DATA(spec[i]);
@@ -360,6 +360,17 @@ static int _resolve_mime(on_http_request_args_t *args, mime_types_t *read_mime,
 	return SLURM_SUCCESS;
 }
 
+static int _write_json_chunk(const char *buf, size_t len, void *arg)
+{
+	return send_http_chunk(arg, buf, len);
+}
+
+static int _stream_json_body(con_mgr_fd_t *con, void *arg)
+{
+	return dump_json_stream(arg, DUMP_JSON_FLAGS_PRETTY, _write_json_chunk,
+				con);
+}
+
 static int _call_handler(on_http_request_args_t *args, data_t *params,
 			 data_t *query, operation_handler_t callback,
 			 int callback_tag, mime_types_t write_mime)
@@ -367,12 +378,18 @@ static int _call_handler(on_http_request_args_t *args, data_t *params,
 	int rc;
 	data_t *resp = data_new();
 	const char *body = NULL;
+	bool stream = false;
 
 	rc = callback(args->context->con->name, args->method, params, query,
 		      callback_tag, resp, args->context->auth);
 
 	if (data_get_type(resp) == DATA_TYPE_NULL)
 		/* no op */;
+	else if (!rc && (write_mime == MIME_JSON) &&
+		 ((args->http_major > 1) ||
+		  ((args->http_major == 1) && (args->http_minor >= 1))))
+		/* avoid building entire response in memory */
+		stream = true;
 	else if (write_mime == MIME_YAML)
 		body = dump_yaml(resp);
 	else if (write_mime == MIME_JSON)
@@ -417,7 +434,11 @@ static int _call_handler(on_http_request_args_t *args, data_t *params,
 			.body_length = 0,
 		};
 
-		if (body) {
+		if (stream) {
+			send_args.body_writer = _stream_json_body;
+			send_args.body_writer_arg = resp;
+			send_args.body_encoding = get_mime_type_str(write_mime);
+		} else if (body) {
 			send_args.body = body;
 			send_args.body_length = strlen(body);
 			send_args.body_encoding = get_mime_type_str(write_mime);
@@ -36,12 +36,14 @@
 
 #include "config.h"
 
+#include <pthread.h>
 #include <stdarg.h>
 #include <unistd.h>
 
 #include "slurm/slurm.h"
 
 #include "src/common/data.h"
+#include "src/common/list.h"
 #include "src/common/log.h"
 #include "src/common/ref.h"
 #include "src/common/xassert.h"
@@ -86,6 +88,32 @@ const uint32_t plugin_version = SLURM_VERSION_NUMBER;
 
 decl_static_data(openapi_json);
 
+/* seconds a cached controller response is served without refresh */
+#define CTLD_CACHE_MAX_AGE 1
+/* seconds an unused cache entry is kept */
+#define CTLD_CACHE_EXPIRE 300
+
+struct cached_msg_s {
+	ctld_cache_type_t type;
+	void *msg; /* job_info_msg_t or node_info_msg_t */
+	time_t last_update; /* last_update from slurmctld */
+	int refs; /* protected by cache_lock */
+};
+
+typedef struct {
+	ctld_cache_type_t type;
+	char *user_name;
+	uint16_t show_flags;
+	cached_msg_t *cached; /* current response or NULL */
+	time_t fetched; /* when cached was last checked against slurmctld */
+	time_t used; /* when entry was last requested */
+	bool loading; /* a request is fetching from slurmctld */
+} cache_entry_t;
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cache_cond = PTHREAD_COND_INITIALIZER;
+static List cache = NULL;
+
 extern int get_date_param(data_t *query, const char *param, time_t *time) {
 	data_t *data_update_time;
 	if ((data_update_time = data_key_get(query, param))) {
@@ -98,6 +126,22 @@ extern int get_date_param(data_t *query, const char *param, time_t *time) {
 	return SLURM_SUCCESS;
 }
 
+extern int get_string_param(data_t *query, const char *param, char **str)
+{
+	data_t *dparam;
+
+	if (!(dparam = data_key_get(query, param)))
+		return SLURM_SUCCESS;
+
+	xfree(*str);
+	if (data_get_string_converted(dparam, str) || !*str || !(*str)[0]) {
+		xfree(*str);
+		return ESLURM_REST_INVALID_QUERY;
+	}
+
+	return SLURM_SUCCESS;
+}
+
 extern data_t *populate_response_format(data_t *resp)
 {
 	data_t *plugin, *slurm, *slurmv, *meta;
@@ -161,6 +205,180 @@ extern int resp_error(data_t *errors, int error_code, const char *source,
 	return error_code;
 }
 
+/* Caller must hold cache_lock */
+static void _release_cached(cached_msg_t *cached)
+{
+	if (!cached || --cached->refs)
+		return;
+
+	if (cached->type == CTLD_CACHE_JOBS)
+		slurm_free_job_info_msg(cached->msg);
+	else if (cached->type == CTLD_CACHE_NODES)
+		slurm_free_node_info_msg(cached->msg);
+
+	xfree(cached);
+}
+
+static void _free_cache_entry(void *x)
+{
+	cache_entry_t *entry = x;
+
+	_release_cached(entry->cached);
+	xfree(entry->user_name);
+	xfree(entry);
+}
+
+typedef struct {
+	ctld_cache_type_t type;
+	const char *user_name;
+	uint16_t show_flags;
+} cache_key_t;
+
+static int _find_cache_entry(void *x, void *arg)
+{
+	cache_entry_t *entry = x;
+	cache_key_t *key = arg;
+
+	return ((entry->type == key->type) &&
+		(entry->show_flags == key->show_flags) &&
+		!xstrcmp(entry->user_name, key->user_name));
+}
+
+static int _expire_cache_entry(void *x, void *arg)
+{
+	cache_entry_t *entry = x;
+	time_t *now = arg;
+
+	return (!entry->loading &&
+		((*now - entry->used) > CTLD_CACHE_EXPIRE));
+}
+
+/*
+ * Fetch response from slurmctld
+ * RET SLURM_SUCCESS, SLURM_NO_CHANGE_IN_DATA or error
+ */
+static int _load_ctld(ctld_cache_type_t type, uint16_t show_flags,
+		      time_t update_time, cached_msg_t **cached_ptr)
+{
+	cached_msg_t *cached;
+	int rc;
+
+	cached = xmalloc(sizeof(*cached));
+	cached->type = type;
+	cached->refs = 1;
+
+	if (type == CTLD_CACHE_JOBS) {
+		job_info_msg_t *msg = NULL;
+
+		rc = slurm_load_jobs(update_time, &msg, show_flags);
+		if (!rc) {
+			cached->msg = msg;
+			cached->last_update = msg->last_update;
+		}
+	} else if (type == CTLD_CACHE_NODES) {
+		node_info_msg_t *msg = NULL;
+
+		rc = slurm_load_node(update_time, &msg, show_flags);
+		if (!rc) {
+			cached->msg = msg;
+			cached->last_update = msg->last_update;
+		}
+	} else
+		fatal_abort("%s: invalid cache type", __func__);
+
+	if (rc) {
+		/* slurm_load_*() return SLURM_ERROR and set errno */
+		rc = errno;
+		xfree(cached);
+	} else
+		*cached_ptr = cached;
+
+	return rc;
+}
+
+extern int ctld_cache_load(ctld_cache_type_t type, rest_auth_context_t *auth,
+			   uint16_t show_flags, time_t update_time,
+			   void **msg_ptr, cached_msg_t **ref_ptr)
+{
+	cache_key_t key = {
+		.type = type,
+		.user_name = auth->user_name,
+		.show_flags = show_flags,
+	};
+	cache_entry_t *entry;
+	time_t now = time(NULL);
+	int rc = SLURM_SUCCESS;
+
+	xassert(type < CTLD_CACHE_MAX);
+
+	slurm_mutex_lock(&cache_lock);
+
+	(void) list_delete_all(cache, _expire_cache_entry, &now);
+
+	if (!(entry = list_find_first(cache, _find_cache_entry, &key))) {
+		entry = xmalloc(sizeof(*entry));
+		entry->type = type;
+		entry->user_name = xstrdup(auth->user_name);
+		entry->show_flags = show_flags;
+		list_append(cache, entry);
+	}
+	entry->used = now;
+
+	/* coalesce with request already fetching the same response */
+	while (entry->loading)
+		slurm_cond_wait(&cache_cond, &cache_lock);
+
+	if (!entry->cached || ((now - entry->fetched) >= CTLD_CACHE_MAX_AGE)) {
+		cached_msg_t *cached = NULL;
+		time_t last_update =
+			(entry->cached ? entry->cached->last_update : 0);
+
+		entry->loading = true;
+		slurm_mutex_unlock(&cache_lock);
+
+		/* only transfer the response again if it has changed */
+		rc = _load_ctld(type, show_flags, last_update, &cached);
+
+		slurm_mutex_lock(&cache_lock);
+		entry->loading = false;
+		slurm_cond_broadcast(&cache_cond);
+
+		if (!rc) {
+			_release_cached(entry->cached);
+			entry->cached = cached;
+			entry->fetched = now;
+		} else if ((rc == SLURM_NO_CHANGE_IN_DATA) && entry->cached) {
+			entry->fetched = now;
+			rc = SLURM_SUCCESS;
+		}
+
+		debug4("%s: %s cache refresh for user %s: %s",
+		       __func__, (type == CTLD_CACHE_JOBS ? "jobs" : "nodes"),
+		       entry->user_name, slurm_strerror(rc));
+	}
+
+	if (rc) {
+		/* errors are never cached */
+	} else if (update_time && (entry->cached->last_update <= update_time)) {
+		rc = SLURM_NO_CHANGE_IN_DATA;
+	} else {
+		entry->cached->refs++;
+		*ref_ptr = entry->cached;
+		*msg_ptr = entry->cached->msg;
+	}
+
+	slurm_mutex_unlock(&cache_lock);
+
+	return rc;
+}
+
+extern void ctld_cache_release(cached_msg_t *ref)
+{
+	slurm_mutex_lock(&cache_lock);
+	_release_cached(ref);
+	slurm_mutex_unlock(&cache_lock);
+}
+
 extern data_t *slurm_openapi_p_get_specification(void)
 {
 	data_t *spec = NULL;
@@ -172,7 +390,12 @@ extern data_t *slurm_openapi_p_get_specification(void)
 
 extern void slurm_openapi_p_init(void)
 {
+	slurm_mutex_lock(&cache_lock);
+	cache = list_create(_free_cache_entry);
+	slurm_mutex_unlock(&cache_lock);
+
 	init_op_diag();
+	init_op_events();
 	init_op_jobs();
 	init_op_nodes();
 	init_op_partitions();
@@ -182,8 +405,13 @@ extern void slurm_openapi_p_init(void)
 extern void slurm_openapi_p_fini(void)
 {
 	destroy_op_diag();
+	destroy_op_events();
 	destroy_op_jobs();
 	destroy_op_nodes();
 	destroy_op_partitions();
 	destroy_op_reservations();
+
+	slurm_mutex_lock(&cache_lock);
+	FREE_NULL_LIST(cache);
+	slurm_mutex_unlock(&cache_lock);
 }
@@ -42,9 +42,19 @@
 #include "slurm/slurm.h"
 
 #include "src/common/data.h"
+#include "src/slurmrestd/rest_auth.h"
 
 extern int get_date_param(data_t *query, const char *param, time_t *time);
 
+/*
+ * Copy string query parameter into *str if present
+ * IN query - query parameters
+ * IN param - parameter name
+ * IN/OUT str - set to xmalloc()ed value, left unchanged if not present
+ * RET SLURM_SUCCESS or ESLURM_REST_INVALID_QUERY if empty or not a string
+ */
+extern int get_string_param(data_t *query, const char *param, char **str);
+
 /*
  * Fill out boilerplate for every data response
  * RET ptr to errors dict
@@ -63,12 +73,46 @@ extern int resp_error(data_t *errors, int error_code, const char *source,
 		      const char *why, ...)
 	__attribute__((format(printf, 4, 5)));
 
+typedef enum {
+	CTLD_CACHE_JOBS = 0,
+	CTLD_CACHE_NODES,
+	CTLD_CACHE_MAX /* keep at end */
+} ctld_cache_type_t;
+
+typedef struct cached_msg_s cached_msg_t;
+
+/*
+ * Load response from slurmctld through cache shared by all requests.
+ * Responses are cached per user as slurmctld filters them per user.
+ * Concurrent requests for the same response are served by one RPC.
+ *
+ * IN type - type of response to load
+ * IN auth - auth context of the requesting user
+ * IN show_flags - SHOW_* flags to hand to slurmctld
+ * IN update_time - only return response if changed after this time
+ * OUT msg_ptr - populated with ptr to job_info_msg_t or node_info_msg_t
+ *	on SLURM_SUCCESS (do not modify or free)
+ * RET SLURM_SUCCESS, SLURM_NO_CHANGE_IN_DATA or error.
+ * 	Must call ctld_cache_release() on SLURM_SUCCESS.
+ */
+extern int ctld_cache_load(ctld_cache_type_t type, rest_auth_context_t *auth,
+			   uint16_t show_flags, time_t update_time,
+			   void **msg_ptr, cached_msg_t **ref_ptr);
+
+/*
+ * Release cached response from ctld_cache_load()
+ * IN ref - reference from ctld_cache_load()
+ */
+extern void ctld_cache_release(cached_msg_t *ref);
+
 extern void init_op_diag(void);
+extern void init_op_events(void);
 extern void init_op_jobs(void);
 extern void init_op_nodes(void);
 extern void init_op_partitions(void);
 extern void init_op_reservations(void);
 extern void destroy_op_diag(void);
+extern void destroy_op_events(void);
 extern void destroy_op_jobs(void);
 extern void destroy_op_nodes(void);
 extern void destroy_op_partitions(void);
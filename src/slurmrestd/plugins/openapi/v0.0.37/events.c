@@ -0,0 +1,194 @@
+/*****************************************************************************\
+ *  events.c - Slurm REST API event http operations handlers
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#include "config.h"
+
+#define _GNU_SOURCE
+
+#include <stdint.h>
+
+#include "slurm/slurm.h"
+
+#include "src/common/data.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/uid.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "src/slurmrestd/operations.h"
+
+#include "src/slurmrestd/plugins/openapi/v0.0.37/api.h"
+
+typedef struct {
+	uint32_t type;
+	const char *str;
+} event_type_t;
+
+static const event_type_t event_types[] = {
+	{ CTLD_EVENT_JOB_SUBMIT, "job_submit" },
+	{ CTLD_EVENT_JOB_START, "job_start" },
+	{ CTLD_EVENT_JOB_END, "job_end" },
+	{ CTLD_EVENT_NODE_DOWN, "node_down" },
+	{ CTLD_EVENT_NODE_DRAIN, "node_drain" },
+	{ CTLD_EVENT_NODE_UP, "node_up" },
+	{ CTLD_EVENT_NODE_UPDATE, "node_update" },
+};
+
+static const char *_event_type_str(uint32_t type)
+{
+	for (int i = 0; i < ARRAY_SIZE(event_types); i++)
+		if (event_types[i].type == type)
+			return event_types[i].str;
+
+	return "invalid";
+}
+
+/* Parse comma separated event type names into a CTLD_EVENT_* mask */
+static int _parse_types(char *types, uint32_t *mask)
+{
+	char *tmp = xstrdup(types), *tok, *save_ptr = NULL;
+	int rc = SLURM_SUCCESS;
+
+	for (tok = strtok_r(tmp, ",", &save_ptr); !rc && tok;
+	     tok = strtok_r(NULL, ",", &save_ptr)) {
+		int i;
+
+		for (i = 0; i < ARRAY_SIZE(event_types); i++)
+			if (!xstrcasecmp(tok, event_types[i].str))
+				break;
+		if (i < ARRAY_SIZE(event_types))
+			*mask |= event_types[i].type;
+		else
+			rc = ESLURM_REST_INVALID_QUERY;
+	}
+	xfree(tmp);
+
+	return rc;
+}
+
+static int _get_int_param(data_t *query, const char *param, int64_t *val)
+{
+	data_t *dparam;
+
+	if (!(dparam = data_key_get(query, param)))
+		return SLURM_SUCCESS;
+	if (data_get_int_converted(dparam, val) || (*val < 0))
+		return ESLURM_REST_INVALID_QUERY;
+
+	return SLURM_SUCCESS;
+}
+
+static void _dump_event(data_t *p, ctld_event_t *event)
+{
+	data_t *d = data_set_dict(data_list_append(p));
+
+	data_set_int(data_key_set(d, "sequence"), event->seq);
+	data_set_string(data_key_set(d, "type"), _event_type_str(event->type));
+	data_set_int(data_key_set(d, "time"), event->time);
+	if (event->node_name) {
+		data_set_string(data_key_set(d, "node_name"),
+				event->node_name);
+		data_set_string(data_key_set(d, "state"),
+				node_state_string(event->state));
+	} else {
+		data_set_int(data_key_set(d, "job_id"), event->job_id);
+		data_set_string(data_key_set(d, "partition"),
+				event->partition);
+		data_set_int(data_key_set(d, "user_id"), event->user_id);
+		data_set_string(data_key_set(d, "state"),
+				job_state_string(event->state));
+	}
+}
+
+/*
+ * Long poll for events: returns as soon as there are events after "since",
+ * or once "wait" seconds pass without any. Clients pass the returned
+ * last_sequence as "since" to read on without missing events.
+ */
+static int _op_handler_events(const char *context_id,
+			      http_request_method_t method, data_t *parameters,
+			      data_t *query, int tag, data_t *d,
+			      rest_auth_context_t *auth)
+{
+	int rc;
+	data_t *errors = populate_response_format(d);
+	data_t *events = data_set_list(data_key_set(d, "events"));
+	ctld_event_filter_t filter = { .user_id = NO_VAL };
+	ctld_event_msg_t *resp = NULL;
+	int64_t since = 0, wait = 0, user_id = NO_VAL;
+	char *types = NULL;
+
+	if ((rc = _get_int_param(query, "since", &since)) ||
+	    (rc = _get_int_param(query, "wait", &wait)) ||
+	    (rc = _get_int_param(query, "user_id", &user_id)) ||
+	    (rc = get_string_param(query, "partition", &filter.partition)) ||
+	    (rc = get_string_param(query, "types", &types)) ||
+	    (types && (rc = _parse_types(types, &filter.type_mask)))) {
+		resp_error(errors, rc, "events", "invalid query parameter");
+		goto done;
+	}
+	filter.user_id = user_id;
+
+	if ((rc = slurm_load_ctld_events(since, &filter, MIN(wait, UINT16_MAX),
+					 &resp))) {
+		resp_error(errors, errno, "slurm_load_ctld_events", NULL);
+		goto done;
+	}
+
+	if (resp) {
+		for (int i = 0; i < resp->record_count; i++)
+			_dump_event(events, &resp->event_array[i]);
+		data_set_int(data_key_set(d, "first_sequence"),
+			     resp->first_seq);
+		data_set_int(data_key_set(d, "last_sequence"),
+			     resp->next_seq - 1);
+	}
+
+done:
+	slurm_free_ctld_event_msg(resp);
+	xfree(filter.partition);
+	xfree(types);
+	return rc;
+}
+
+extern void init_op_events(void)
+{
+	bind_operation_handler("/slurm/v0.0.37/events/", _op_handler_events,
+			       0);
+}
+
+extern void destroy_op_events(void)
+{
+	unbind_operation_handler(_op_handler_events);
+}
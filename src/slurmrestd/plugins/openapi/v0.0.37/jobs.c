@@ -1159,6 +1159,77 @@ static data_t *dump_job_info(slurm_job_info_t *job, data_t *jd)
 	return jd;
 }
 
+/*
+ * Parse "fields" query of comma delimited job fields
+ * IN query - query sent by client
+ * OUT fields_ptr - dictionary of requested fields or NULL for all fields
+ * RET SLURM_SUCCESS or ESLURM_REST_INVALID_QUERY
+ */
+static int _parse_fields(data_t *query, data_t **fields_ptr)
+{
+	data_t *dfields;
+	data_t *fields;
+	char *str = NULL, *tok, *save_ptr = NULL;
+
+	*fields_ptr = NULL;
+
+	if (!(dfields = data_key_get(query, "fields")))
+		return SLURM_SUCCESS;
+
+	if (data_get_string_converted(dfields, &str))
+		return ESLURM_REST_INVALID_QUERY;
+
+	fields = data_set_dict(data_new());
+	for (tok = strtok_r(str, ",", &save_ptr); tok;
+	     tok = strtok_r(NULL, ",", &save_ptr))
+		data_set_bool(data_key_set(fields, tok), true);
+	xfree(str);
+
+	if (!data_get_dict_length(fields)) {
+		FREE_NULL_DATA(fields);
+		return ESLURM_REST_INVALID_QUERY;
+	}
+
+	*fields_ptr = fields;
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Parse the job filter query parameters which slurmctld applies before
+ * packing the jobs.
+ * RET SLURM_SUCCESS or error, filter members must be freed by the caller
+ */
+static int _parse_filter(data_t *query, info_filter_t *filter)
+{
+	int rc;
+
+	if ((rc = get_string_param(query, "account", &filter->accounts)) ||
+	    (rc = get_string_param(query, "node", &filter->nodes)) ||
+	    (rc = get_string_param(query, "partition", &filter->partitions)) ||
+	    (rc = get_string_param(query, "state", &filter->states)) ||
+	    (rc = get_string_param(query, "user", &filter->users)))
+		return rc;
+
+	return SLURM_SUCCESS;
+}
+
+typedef struct {
+	const data_t *src;
+	data_t *dst;
+} copy_fields_t;
+
+static data_for_each_cmd_t _copy_field(const char *key, const data_t *data,
+				       void *arg)
+{
+	copy_fields_t *args = arg;
+	const data_t *src = data_key_get_const(args->src, key);
+
+	if (src)
+		data_copy(data_key_set(args->dst, key), src);
+
+	return DATA_FOR_EACH_CONT;
+}
+
 static int _op_handler_jobs(const char *context_id,
 			    http_request_method_t method,
 			    data_t *parameters, data_t *query, int tag,
@@ -1166,30 +1237,79 @@ static int _op_handler_jobs(const char *context_id,
 {
 	int rc = SLURM_SUCCESS;
 	job_info_msg_t *job_info_ptr = NULL;
-	(void) populate_response_format(resp);
+	cached_msg_t *cached = NULL;
+	data_t *errors = populate_response_format(resp);
 	data_t *jobs = data_set_list(data_key_set(resp, "jobs"));
+	data_t *fields = NULL;
+	info_filter_t filter = { 0 };
 	time_t update_time = 0; /* default to unix epoch */
+	uint16_t show_flags = SHOW_ALL | SHOW_DETAIL;
 
 	debug4("%s: jobs handler called by %s", __func__, context_id);
 
 	if ((rc = get_date_param(query, "update_time", &update_time)))
 	    goto done;
 
-	rc = slurm_load_jobs(update_time, &job_info_ptr,
-			     SHOW_ALL | SHOW_DETAIL);
+	if ((rc = _parse_fields(query, &fields))) {
+		resp_error(errors, rc, "fields", "invalid fields query");
+		goto done;
+	}
+
+	if ((rc = _parse_filter(query, &filter))) {
+		resp_error(errors, rc, "filter", "invalid job filter query");
+		goto done;
+	}
+
+	/* job resources and GRES details are only packed with SHOW_DETAIL */
+	if (fields && !data_key_get(fields, "job_resources") &&
+	    !data_key_get(fields, "gres_detail"))
+		show_flags &= ~SHOW_DETAIL;
+
+	/* Filtered replies are specific to this request, bypass the cache */
+	if (filter.accounts || filter.nodes || filter.partitions ||
+	    filter.states || filter.users) {
+		errno = 0;
+		if ((rc = slurm_load_jobs_filter(update_time, &job_info_ptr,
+						 show_flags, &filter)))
+			rc = errno;
+	} else {
+		rc = ctld_cache_load(CTLD_CACHE_JOBS, auth, show_flags,
+				     update_time, (void **) &job_info_ptr,
+				     &cached);
+	}
 
 	if (rc == SLURM_NO_CHANGE_IN_DATA) {
 		/* no-op: nothing to do here */
 	} else if ((rc == SLURM_SUCCESS) && job_info_ptr &&
 		   job_info_ptr->record_count) {
 		for (size_t i = 0; i < job_info_ptr->record_count; ++i) {
-			dump_job_info(job_info_ptr->job_array + i,
-				      data_list_append(jobs));
+			data_t *jd;
+			copy_fields_t args;
+
+			if (!fields) {
+				dump_job_info(job_info_ptr->job_array + i,
+					      data_list_append(jobs));
+				continue;
+			}
+
+			/* only send requested fields */
+			jd = dump_job_info(job_info_ptr->job_array + i,
+					   data_new());
+			args.src = jd;
+			args.dst = data_set_dict(data_list_append(jobs));
+			(void) data_dict_for_each_const(fields, _copy_field,
+							&args);
+			FREE_NULL_DATA(jd);
 		}
 	}
 
 done:
-	slurm_free_job_info_msg(job_info_ptr);
+	if (cached)
+		ctld_cache_release(cached);
+	else
+		slurm_free_job_info_msg(job_info_ptr);
+	slurm_free_info_filter_members(&filter);
+	FREE_NULL_DATA(fields);
 
 	return rc;
 }
@@ -46,6 +46,7 @@
 
 #include "src/common/data.h"
 #include "src/common/ref.h"
+#include "src/common/slurm_protocol_defs.h"
 #include "src/common/uid.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
@@ -210,13 +211,34 @@ static int _op_handler_nodes(const char *context_id,
 	data_t *errors = populate_response_format(d);
 	data_t *nodes = data_set_list(data_key_set(d, "nodes"));
 	node_info_msg_t *node_info_ptr = NULL;
+	cached_msg_t *cached = NULL;
+	info_filter_t filter = { 0 };
 	time_t update_time = 0;
 
+	errno = 0;
+
 	if (tag == URL_TAG_NODES) {
-		if ((rc = get_date_param(query, "update_time", &update_time)))
+		if ((rc = get_date_param(query, "update_time", &update_time)) ||
+		    (rc = get_string_param(query, "node", &filter.nodes)) ||
+		    (rc = get_string_param(query, "partition",
+					   &filter.partitions)))
 			goto done;
-		rc = slurm_load_node(update_time, &node_info_ptr,
-				     SHOW_ALL|SHOW_DETAIL);
+
+		/* Filtered replies are specific to this request */
+		if (filter.nodes || filter.partitions) {
+			rc = slurm_load_node_filter(update_time,
+						    &node_info_ptr,
+						    (SHOW_ALL | SHOW_DETAIL),
+						    &filter);
+		} else {
+			rc = ctld_cache_load(CTLD_CACHE_NODES, auth,
+					     (SHOW_ALL | SHOW_DETAIL),
+					     update_time,
+					     (void **) &node_info_ptr,
+					     &cached);
+			if (rc == SLURM_NO_CHANGE_IN_DATA)
+				errno = rc;
+		}
 	} else if (tag == URL_TAG_NODE) {
 		const data_t *node_name = data_key_get_const(parameters,
 							     "node_name");
@@ -252,7 +274,11 @@ static int _op_handler_nodes(const char *context_id,
 	}
 
 done:
-	slurm_free_node_info_msg(node_info_ptr);
+	if (cached)
+		ctld_cache_release(cached);
+	else
+		slurm_free_node_info_msg(node_info_ptr);
+	slurm_free_info_filter_members(&filter);
 	return rc;
 }
 
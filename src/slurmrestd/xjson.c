@@ -36,10 +36,17 @@
 
 #include "config.h"
 
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
 #include "slurm/slurm.h"
 
 #include "src/common/log.h"
 #include "src/common/xassert.h"
+#include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
 #include "src/slurmrestd/xjson.h"
@@ -54,96 +61,6 @@
 
 static json_object *_data_to_json(const data_t *d);
 
-static json_object *_try_parse(const char *buffer, size_t stringlen,
-			       struct json_tokener *tok)
-{
-	json_object *jobj = json_tokener_parse_ex(tok, buffer, stringlen);
-
-	if (jobj == NULL) {
-		enum json_tokener_error jerr = json_tokener_get_error(tok);
-		error("%s: JSON parsing error %zu bytes: %s",
-		      __func__, stringlen, json_tokener_error_desc(jerr));
-		return NULL;
-	}
-	if (tok->char_offset < stringlen)
-		info("%s: WARNING: Extra %zu characters after JSON string detected",
-		     __func__, (stringlen - tok->char_offset));
-
-	return jobj;
-}
-
-static data_t *_json_to_data(json_object *jobj, data_t *d)
-{
-	size_t arraylen = 0;
-
-	if (!d)
-		d = data_new();
-
-	switch (json_object_get_type(jobj)) {
-	case json_type_null:
-		data_set_null(d);
-		break;
-	case json_type_boolean:
-		data_set_bool(d, json_object_get_boolean(jobj));
-		break;
-	case json_type_double:
-		data_set_float(d, json_object_get_double(jobj));
-		break;
-	case json_type_int:
-		data_set_int(d, json_object_get_int64(jobj));
-		break;
-	case json_type_object:
-		data_set_dict(d);
-		json_object_object_foreach(jobj, key, val)
-			_json_to_data(val, data_key_set(d, key));
-		break;
-	case json_type_array:
-		arraylen = json_object_array_length(jobj);
-		data_set_list(d);
-		for (size_t i = 0; i < arraylen; i++)
-			_json_to_data(json_object_array_get_idx(jobj, i),
-				      data_list_append(d));
-		break;
-	case json_type_string:
-		data_set_string(d, json_object_get_string(jobj));
-		break;
-	default:
-		fatal_abort("%s: unknown JSON type", __func__);
-	};
-
-	return d;
-}
-
-extern data_t *parse_json(const char *buffer, size_t len)
-{
-	json_object *jobj = NULL;
-	data_t *data = NULL;
-	struct json_tokener *tok = json_tokener_new();
-
-	if (!buffer)
-		return NULL;
-
-	/* json-c has hard limit of 32 bits */
-	if (len >= INT32_MAX) {
-		error("%s: unable to parse JSON: too large",
-		      __func__);
-		return NULL;
-	}
-
-	if (!tok)
-		return NULL;
-
-	jobj = _try_parse(buffer, len, tok);
-	if (jobj) {
-		data = _json_to_data(jobj, NULL);
-		json_object_put(jobj);
-	}
-
-	json_tokener_free(tok);
-
-	return data;
-}
-
 static data_for_each_cmd_t _convert_dict_json(const char *key,
 					      const data_t *data,
 					      void *arg)
@@ -242,16 +159,724 @@ extern char *dump_json(const data_t *data, dump_json_flags_t flags)
 
 #else /* HAVE_JSON */
 
-extern data_t *parse_json(const char *buf, size_t len)
+extern char *dump_json(const data_t *data, dump_json_flags_t flags)
 {
 	error("%s: JSON support not compiled", __func__);
 	return NULL;
 }
 
-extern char *dump_json(const data_t *data, dump_json_flags_t flags)
+#endif /* HAVE_JSON */
+
+/*
+ * Streaming JSON writer. This does not depend on json-c as it walks the
+ * data_t tree directly and only ever holds one staging buffer of output.
+ */
+#define JSON_STREAM_BUFFER_SIZE (16 * 1024)
+
+typedef struct {
+	dump_json_write_t write_cb;
+	void *arg;
+	bool pretty;
+	int depth;
+	bool first; /* next entry is first in current dict/list */
+	int rc;
+	size_t len;
+	char buf[JSON_STREAM_BUFFER_SIZE];
+} json_stream_t;
+
+static void _stream_flush(json_stream_t *s)
 {
-	error("%s: JSON support not compiled", __func__);
-	return NULL;
+	if (!s->rc && s->len)
+		s->rc = s->write_cb(s->buf, s->len, s->arg);
+	s->len = 0;
 }
 
-#endif /* HAVE_JSON */
+static void _stream_write(json_stream_t *s, const char *str, size_t len)
+{
+	while (!s->rc && len) {
+		size_t n = sizeof(s->buf) - s->len;
+
+		if (n > len)
+			n = len;
+
+		memcpy(s->buf + s->len, str, n);
+		s->len += n;
+		str += n;
+		len -= n;
+
+		if (s->len == sizeof(s->buf))
+			_stream_flush(s);
+	}
+}
+
+static void _stream_write_str(json_stream_t *s, const char *str)
+{
+	_stream_write(s, str, strlen(str));
+}
+
+static void _stream_write_quoted(json_stream_t *s, const char *str)
+{
+	const char *start = str;
+
+	_stream_write(s, "\"", 1);
+
+	for (; str && *str; str++) {
+		const char *esc = NULL;
+		char hex[7];
+
+		switch (*str) {
+		case '"':
+			esc = "\\\"";
+			break;
+		case '\\':
+			esc = "\\\\";
+			break;
+		case '/':
+			esc = "\\/";
+			break;
+		case '\b':
+			esc = "\\b";
+			break;
+		case '\f':
+			esc = "\\f";
+			break;
+		case '\n':
+			esc = "\\n";
+			break;
+		case '\r':
+			esc = "\\r";
+			break;
+		case '\t':
+			esc = "\\t";
+			break;
+		default:
+			if ((unsigned char) *str < 0x20) {
+				snprintf(hex, sizeof(hex), "\\u%04x",
+					 (unsigned char) *str);
+				esc = hex;
+			}
+		}
+
+		if (esc) {
+			_stream_write(s, start, (str - start));
+			_stream_write_str(s, esc);
+			start = str + 1;
+		}
+	}
+
+	if (str)
+		_stream_write(s, start, (str - start));
+
+	_stream_write(s, "\"", 1);
+}
+
+static void _stream_newline(json_stream_t *s)
+{
+	if (!s->pretty)
+		return;
+
+	_stream_write(s, "\n", 1);
+	for (int i = 0; i < s->depth; i++)
+		_stream_write(s, "  ", 2);
+}
+
+/* start next entry of the current dict or list */
+static void _stream_next(json_stream_t *s)
+{
+	if (!s->first)
+		_stream_write(s, ",", 1);
+	s->first = false;
+	_stream_newline(s);
+}
+
+static void _stream_data(json_stream_t *s, const data_t *d);
+
+static data_for_each_cmd_t _stream_dict(const char *key, const data_t *data,
+					void *arg)
+{
+	json_stream_t *s = arg;
+
+	_stream_next(s);
+	_stream_write_quoted(s, key);
+	_stream_write_str(s, (s->pretty ? ": " : ":"));
+	_stream_data(s, data);
+
+	return (s->rc ? DATA_FOR_EACH_FAIL : DATA_FOR_EACH_CONT);
+}
+
+static data_for_each_cmd_t _stream_list(const data_t *data, void *arg)
+{
+	json_stream_t *s = arg;
+
+	_stream_next(s);
+	_stream_data(s, data);
+
+	return (s->rc ? DATA_FOR_EACH_FAIL : DATA_FOR_EACH_CONT);
+}
+
+static void _stream_float(json_stream_t *s, double value)
+{
+	char num[64];
+
+	/* match json-c output for non-finite values */
+	if (isnan(value)) {
+		_stream_write_str(s, "NaN");
+		return;
+	} else if (isinf(value)) {
+		_stream_write_str(s, ((value < 0) ? "-Infinity" : "Infinity"));
+		return;
+	}
+
+	snprintf(num, sizeof(num), "%.17g", value);
+
+	/* always mark value as floating point */
+	if (!strpbrk(num, ".eE"))
+		strcat(num, ".0");
+
+	_stream_write_str(s, num);
+}
+
+static void _stream_data(json_stream_t *s, const data_t *d)
+{
+	char num[32];
+
+	if (!d) {
+		_stream_write_str(s, "null");
+		return;
+	}
+
+	switch (data_get_type(d)) {
+	case DATA_TYPE_NULL:
+		_stream_write_str(s, "null");
+		break;
+	case DATA_TYPE_BOOL:
+		_stream_write_str(s, (data_get_bool(d) ? "true" : "false"));
+		break;
+	case DATA_TYPE_FLOAT:
+		_stream_float(s, data_get_float(d));
+		break;
+	case DATA_TYPE_INT_64:
+		snprintf(num, sizeof(num), "%"PRId64, data_get_int(d));
+		_stream_write_str(s, num);
+		break;
+	case DATA_TYPE_DICT:
+	case DATA_TYPE_LIST:
+	{
+		bool dict = (data_get_type(d) == DATA_TYPE_DICT);
+		int rc;
+
+		_stream_write(s, (dict ? "{" : "["), 1);
+		s->depth++;
+		s->first = true;
+
+		if (dict)
+			rc = data_dict_for_each_const(d, _stream_dict, s);
+		else
+			rc = data_list_for_each_const(d, _stream_list, s);
+
+		if ((rc < 0) && !s->rc) {
+			error("%s: unexpected error walking %s",
+			      __func__, (dict ? "dictionary" : "list"));
+			s->rc = SLURM_ERROR;
+		}
+
+		s->depth--;
+		if (!s->first)
+			_stream_newline(s);
+		s->first = false;
+		_stream_write(s, (dict ? "}" : "]"), 1);
+		break;
+	}
+	case DATA_TYPE_STRING:
+		_stream_write_quoted(s, data_get_string_const(d));
+		break;
+	default:
+		fatal_abort("%s: unknown type", __func__);
+	}
+}
+
+extern int dump_json_stream(const data_t *data, dump_json_flags_t flags,
+			    dump_json_write_t write_cb, void *arg)
+{
+	json_stream_t *s;
+	int rc;
+
+	/* can't be pretty and compact at the same time! */
+	xassert((flags & (DUMP_JSON_FLAGS_PRETTY | DUMP_JSON_FLAGS_COMPACT)) !=
+		(DUMP_JSON_FLAGS_PRETTY | DUMP_JSON_FLAGS_COMPACT));
+	xassert(write_cb);
+
+	s = xmalloc(sizeof(*s));
+	s->write_cb = write_cb;
+	s->arg = arg;
+	s->pretty = (flags & DUMP_JSON_FLAGS_PRETTY);
+	s->first = true;
+
+	_stream_data(s, data);
+	_stream_flush(s);
+
+	rc = s->rc;
+	xfree(s);
+
+	return rc;
+}
+
+/*
+ * Single pass JSON parser. This builds the data_t tree directly from the
+ * buffer instead of building a json-c object tree first and copying it.
+ */
+#define JSON_PARSE_MAX_DEPTH 64
+
+typedef struct {
+	const char *buf;
+	const char *pos;
+	const char *end;
+	int depth;
+} json_parser_t;
+
+static int _parse_value(json_parser_t *p, data_t *d);
+
+static int _parse_fail(json_parser_t *p, const char *reason)
+{
+	error("%s: JSON parsing error at byte %zu of %zu bytes: %s",
+	      __func__, (size_t) (p->pos - p->buf),
+	      (size_t) (p->end - p->buf), reason);
+	return SLURM_ERROR;
+}
+
+static void _skip_whitespace(json_parser_t *p)
+{
+	while ((p->pos < p->end) &&
+	       ((*p->pos == ' ') || (*p->pos == '\t') ||
+		(*p->pos == '\n') || (*p->pos == '\r')))
+		p->pos++;
+}
+
+static bool _match_literal(json_parser_t *p, const char *literal)
+{
+	size_t len = strlen(literal);
+
+	if (((size_t) (p->end - p->pos) < len) || memcmp(p->pos, literal, len))
+		return false;
+
+	p->pos += len;
+	return true;
+}
+
+static int _hex_value(char c)
+{
+	if ((c >= '0') && (c <= '9'))
+		return c - '0';
+	if ((c >= 'a') && (c <= 'f'))
+		return c - 'a' + 10;
+	if ((c >= 'A') && (c <= 'F'))
+		return c - 'A' + 10;
+	return -1;
+}
+
+static int _parse_hex4(json_parser_t *p, uint32_t *cp)
+{
+	*cp = 0;
+
+	if ((p->end - p->pos) < 4)
+		return _parse_fail(p, "truncated unicode escape");
+
+	for (int i = 0; i < 4; i++) {
+		int v = _hex_value(*p->pos++);
+
+		if (v < 0)
+			return _parse_fail(p, "invalid unicode escape");
+
+		*cp = (*cp << 4) | v;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+/* write code point as UTF-8 into dst which must have 4 bytes available */
+static size_t _utf8_encode(uint32_t cp, char *dst)
+{
+	if (cp < 0x80) {
+		dst[0] = cp;
+		return 1;
+	} else if (cp < 0x800) {
+		dst[0] = 0xc0 | (cp >> 6);
+		dst[1] = 0x80 | (cp & 0x3f);
+		return 2;
+	} else if (cp < 0x10000) {
+		dst[0] = 0xe0 | (cp >> 12);
+		dst[1] = 0x80 | ((cp >> 6) & 0x3f);
+		dst[2] = 0x80 | (cp & 0x3f);
+		return 3;
+	}
+
+	dst[0] = 0xf0 | (cp >> 18);
+	dst[1] = 0x80 | ((cp >> 12) & 0x3f);
+	dst[2] = 0x80 | ((cp >> 6) & 0x3f);
+	dst[3] = 0x80 | (cp & 0x3f);
+	return 4;
+}
+
+/*
+ * Parse string at current position (after opening quote)
+ * OUT str_ptr ptr to NULL terminated string (must xfree())
+ * RET SLURM_SUCCESS or error
+ */
+static int _parse_string(json_parser_t *p, char **str_ptr)
+{
+	const char *quote = p->pos;
+	char *str, *dst;
+
+	/*
+	 * Let the (vectorized) libc memchr() find the closing quote, skipping
+	 * any quote preceded by an odd number of backslashes.
+	 */
+	while (true) {
+		const char *bs;
+
+		if (!(quote = memchr(quote, '"', (p->end - quote))))
+			return _parse_fail(p, "unterminated string");
+
+		for (bs = quote; (bs > p->pos) && (bs[-1] == '\\'); bs--)
+			;
+
+		if (!((quote - bs) % 2))
+			break;
+
+		quote++;
+	}
+
+	/* Fast path: most strings contain no escapes */
+	if (!memchr(p->pos, '\\', (quote - p->pos))) {
+		*str_ptr = xstrndup(p->pos, (quote - p->pos));
+		p->pos = quote + 1;
+		return SLURM_SUCCESS;
+	}
+
+	/* unescaped string is never longer than escaped string */
+	dst = str = xmalloc((quote - p->pos) + 1);
+
+	while (true) {
+		const char *start = p->pos;
+		uint32_t cp;
+
+		while ((p->pos < p->end) && (*p->pos != '"') &&
+		       (*p->pos != '\\'))
+			p->pos++;
+
+		memcpy(dst, start, (p->pos - start));
+		dst += (p->pos - start);
+
+		if (p->pos >= p->end) {
+			xfree(str);
+			return _parse_fail(p, "unterminated string");
+		}
+
+		if (*p->pos++ == '"')
+			break;
+
+		if (p->pos >= p->end) {
+			xfree(str);
+			return _parse_fail(p, "unterminated escape");
+		}
+
+		switch (*p->pos++) {
+		case '"':
+			*dst++ = '"';
+			break;
+		case '\\':
+			*dst++ = '\\';
+			break;
+		case '/':
+			*dst++ = '/';
+			break;
+		case 'b':
+			*dst++ = '\b';
+			break;
+		case 'f':
+			*dst++ = '\f';
+			break;
+		case 'n':
+			*dst++ = '\n';
+			break;
+		case 'r':
+			*dst++ = '\r';
+			break;
+		case 't':
+			*dst++ = '\t';
+			break;
+		case 'u':
+			if (_parse_hex4(p, &cp)) {
+				xfree(str);
+				return SLURM_ERROR;
+			}
+
+			/* combine UTF-16 surrogate pair */
+			if ((cp >= 0xd800) && (cp <= 0xdbff) &&
+			    ((p->end - p->pos) >= 6) &&
+			    (p->pos[0] == '\\') && (p->pos[1] == 'u')) {
+				uint32_t low;
+
+				p->pos += 2;
+				if (_parse_hex4(p, &low)) {
+					xfree(str);
+					return SLURM_ERROR;
+				}
+
+				if ((low >= 0xdc00) && (low <= 0xdfff)) {
+					cp = 0x10000 + ((cp - 0xd800) << 10) +
+					     (low - 0xdc00);
+				} else {
+					dst += _utf8_encode(cp, dst);
+					cp = low;
+				}
+			}
+
+			dst += _utf8_encode(cp, dst);
+			break;
+		default:
+			p->pos--;
+			xfree(str);
+			return _parse_fail(p, "invalid escape");
+		}
+	}
+
+	*dst = '\0';
+	*str_ptr = str;
+	return SLURM_SUCCESS;
+}
+
+static int _parse_number(json_parser_t *p, data_t *d)
+{
+	const char *start = p->pos;
+	bool is_float = false;
+	char num[128], *end = NULL;
+	size_t len;
+
+	if ((p->pos < p->end) && (*p->pos == '-'))
+		p->pos++;
+
+	while (p->pos < p->end) {
+		char c = *p->pos;
+
+		if ((c >= '0') && (c <= '9'))
+			/* digit */;
+		else if ((c == '.') || (c == 'e') || (c == 'E') ||
+			 (((c == '+') || (c == '-')) &&
+			  ((p->pos[-1] == 'e') || (p->pos[-1] == 'E'))))
+			is_float = true;
+		else
+			break;
+
+		p->pos++;
+	}
+
+	len = p->pos - start;
+	if (!len || (len >= sizeof(num)))
+		return _parse_fail(p, "invalid number");
+
+	/* strtod() and strtoll() require NULL termination */
+	memcpy(num, start, len);
+	num[len] = '\0';
+
+	errno = 0;
+	if (!is_float) {
+		long long value = strtoll(num, &end, 10);
+
+		if ((end == (num + len)) && !errno) {
+			data_set_int(d, value);
+			return SLURM_SUCCESS;
+		}
+
+		/* too large for int64_t: fall back to float */
+		errno = 0;
+	}
+
+	data_set_float(d, strtod(num, &end));
+	if (end != (num + len))
+		return _parse_fail(p, "invalid number");
+
+	return SLURM_SUCCESS;
+}
+
+static int _parse_dict(json_parser_t *p, data_t *d)
+{
+	data_set_dict(d);
+
+	_skip_whitespace(p);
+	if ((p->pos < p->end) && (*p->pos == '}')) {
+		p->pos++;
+		return SLURM_SUCCESS;
+	}
+
+	while (true) {
+		char *key = NULL;
+		int rc;
+
+		_skip_whitespace(p);
+		if ((p->pos >= p->end) || (*p->pos != '"'))
+			return _parse_fail(p, "expected dictionary key");
+		p->pos++;
+
+		if (_parse_string(p, &key))
+			return SLURM_ERROR;
+
+		_skip_whitespace(p);
+		if ((p->pos >= p->end) || (*p->pos != ':')) {
+			xfree(key);
+			return _parse_fail(p, "expected ':'");
+		}
+		p->pos++;
+
+		rc = _parse_value(p, data_key_set(d, key));
+		xfree(key);
+		if (rc)
+			return rc;
+
+		_skip_whitespace(p);
+		if (p->pos >= p->end)
+			return _parse_fail(p, "unterminated dictionary");
+		if (*p->pos == '}') {
+			p->pos++;
+			return SLURM_SUCCESS;
+		}
+		if (*p->pos != ',')
+			return _parse_fail(p, "expected ',' or '}'");
+		p->pos++;
+	}
+}
+
+static int _parse_list(json_parser_t *p, data_t *d)
+{
+	data_set_list(d);
+
+	_skip_whitespace(p);
+	if ((p->pos < p->end) && (*p->pos == ']')) {
+		p->pos++;
+		return SLURM_SUCCESS;
+	}
+
+	while (true) {
+		int rc;
+
+		if ((rc = _parse_value(p, data_list_append(d))))
+			return rc;
+
+		_skip_whitespace(p);
+		if (p->pos >= p->end)
+			return _parse_fail(p, "unterminated list");
+		if (*p->pos == ']') {
+			p->pos++;
+			return SLURM_SUCCESS;
+		}
+		if (*p->pos != ',')
+			return _parse_fail(p, "expected ',' or ']'");
+		p->pos++;
+	}
+}
+
+static int _parse_value(json_parser_t *p, data_t *d)
+{
+	int rc;
+
+	_skip_whitespace(p);
+	if (p->pos >= p->end)
+		return _parse_fail(p, "unexpected end of input");
+
+	switch (*p->pos) {
+	case '{':
+	case '[':
+	{
+		bool dict = (*p->pos == '{');
+
+		if (++p->depth > JSON_PARSE_MAX_DEPTH)
+			return _parse_fail(p, "nesting too deep");
+		p->pos++;
+
+		rc = (dict ? _parse_dict(p, d) : _parse_list(p, d));
+		p->depth--;
+		return rc;
+	}
+	case '"':
+	{
+		char *str = NULL;
+
+		p->pos++;
+		if ((rc = _parse_string(p, &str)))
+			return rc;
+
+		data_set_string_own(d, str);
+		return SLURM_SUCCESS;
+	}
+	case 't':
+		if (_match_literal(p, "true")) {
+			data_set_bool(d, true);
+			return SLURM_SUCCESS;
+		}
+		break;
+	case 'f':
+		if (_match_literal(p, "false")) {
+			data_set_bool(d, false);
+			return SLURM_SUCCESS;
+		}
+		break;
+	case 'n':
+		if (_match_literal(p, "null")) {
+			data_set_null(d);
+			return SLURM_SUCCESS;
+		}
+		break;
+	/* non-finite values as written by dump_json() */
+	case 'N':
+		if (_match_literal(p, "NaN")) {
+			data_set_float(d, NAN);
+			return SLURM_SUCCESS;
+		}
+		break;
+	case 'I':
+		if (_match_literal(p, "Infinity")) {
+			data_set_float(d, INFINITY);
+			return SLURM_SUCCESS;
+		}
+		break;
+	case '-':
+		if (_match_literal(p, "-Infinity")) {
+			data_set_float(d, -INFINITY);
+			return SLURM_SUCCESS;
+		}
+		/* fall through */
+	default:
+		if ((*p->pos == '-') || ((*p->pos >= '0') && (*p->pos <= '9')))
+			return _parse_number(p, d);
+	}
+
+	return _parse_fail(p, "unexpected character");
+}
+
+extern data_t *parse_json(const char *buffer, size_t len)
+{
+	json_parser_t p = {
+		.buf = buffer,
+		.pos = buffer,
+		.end = buffer + len,
+	};
+	data_t *data;
+
+	if (!buffer)
+		return NULL;
+
+	data = data_new();
+
+	if (_parse_value(&p, data)) {
+		FREE_NULL_DATA(data);
+		return NULL;
+	}
+
+	/* trailing NULL terminator is not an extra character */
+	_skip_whitespace(&p);
+	if ((p.pos < p.end) && *p.pos)
+		info("%s: WARNING: Extra %zu characters after JSON string detected",
+		     __func__, (size_t) (p.end - p.pos));
+
+	return data;
+}
@@ -66,4 +66,26 @@ typedef enum {
  */
 extern char *dump_json(const data_t *data, dump_json_flags_t flags);
 
+/*
+ * Callback to receive serialized JSON from dump_json_stream()
+ * IN buf bytes of JSON output (not NULL terminated)
+ * IN len number of bytes in buf
+ * IN arg arbitrary pointer handed to dump_json_stream()
+ * RET SLURM_SUCCESS or error to stop serializing
+ */
+typedef int (*dump_json_write_t)(const char *buf, size_t len, void *arg);
+
+/*
+ * Serialize data directly as JSON without building an intermediate JSON
+ * object tree or output string. Output is handed to write_cb in bounded
+ * chunks as it is generated.
+ * IN data data to serialize
+ * IN flags flags to format the output
+ * IN write_cb callback to receive the output
+ * IN arg arbitrary pointer to hand to write_cb
+ * RET SLURM_SUCCESS or error
+ */
+extern int dump_json_stream(const data_t *data, dump_json_flags_t flags,
+			    dump_json_write_t write_cb, void *arg);
+
 #endif /* _XJSON_H */
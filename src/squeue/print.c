@@ -130,7 +130,6 @@ int print_jobs_array(job_info_t * jobs, int size, List format)
 
 	_combine_pending_array_tasks(l);
 	_part_state_free();
-	sort_jobs_by_start_time (l);
 	sort_job_list (l);
 
 	/* Print the jobs of interest */
@@ -267,6 +266,8 @@ static void _job_list_del(void *x)
 {
 	squeue_job_rec_t *job_rec_ptr = (squeue_job_rec_t *) x;
 	xfree(job_rec_ptr->part_name);
+	xfree(job_rec_ptr->group_name);
+	FREE_NULL_HOSTLIST(job_rec_ptr->nodes_hl);
 	xfree(job_rec_ptr);
 }
 
@@ -333,10 +334,10 @@ static int _print_str(char *str, int width, bool right, bool cut_output)
 			return printed;
 	}
 
-	while (printed++ < width)
-		printf(" ");
+	if (printed < width)
+		printf("%*s", width - printed, "");
 
-	return printed;
+	return MAX(printed, width) + 1;
 }
 
 int _print_nodes(char *nodes, int width, bool right, bool cut)
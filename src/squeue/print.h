@@ -67,6 +67,10 @@ typedef struct squeue_job_rec {
 	job_info_t *	job_ptr;
 	char *		part_name;
 	uint32_t	part_prio;
+	/* Sort keys, set by sort_job_list() when first needed */
+	char *		group_name;
+	char *		user_name;	/* from uid_to_string_cached() */
+	hostlist_t	nodes_hl;
 } squeue_job_rec_t;
 
 long job_time_used(job_info_t * job_ptr);
@@ -50,7 +50,18 @@
 #define PURE_ALPHA_SORT 0
 #define CLUSTER_NAME_LEN 7
 
+/*
+ * All of the sort keys are applied in a single list_sort(), the first key
+ * given in params.sort being the most significant
+ */
+typedef struct {
+	ListCmpF func;
+	bool reverse;
+} sort_key_t;
+
 static bool reverse_order;
+static sort_key_t *sort_keys = NULL;	/* least significant key first */
+static int sort_key_cnt = 0, sort_key_size = 0;
 
 static void _get_job_info_from_void(job_info_t **j1, job_info_t **j2, void *v1, void *v2);
 static void _get_step_info_from_void(job_step_info_t **j1, job_step_info_t **j2, void *v1, void *v2);
@@ -92,11 +103,34 @@ static int _sort_step_by_time_limit(void *void1, void *void2);
 static int _sort_step_by_time_used(void *void1, void *void2);
 static int _sort_step_by_user_id(void *void1, void *void2);
 static int _sort_step_by_user_name(void *void1, void *void2);
-static int _sort_by_node_list(char *nodes1, char *nodes2);
+static int _sort_by_node_list(hostlist_t hostlist1, hostlist_t hostlist2);
 
 
 static time_t now;
 
+/* Add a key of higher significance than those added so far */
+static void _add_sort_key(ListCmpF func)
+{
+	if (sort_key_cnt >= sort_key_size) {
+		sort_key_size += 8;
+		xrecalloc(sort_keys, sort_key_size, sizeof(sort_key_t));
+	}
+	sort_keys[sort_key_cnt].func = func;
+	sort_keys[sort_key_cnt].reverse = reverse_order;
+	sort_key_cnt++;
+}
+
+static int _sort_by_keys(void *void1, void *void2)
+{
+	int diff = 0, i;
+
+	for (i = sort_key_cnt - 1; (i >= 0) && !diff; i--) {
+		reverse_order = sort_keys[i].reverse;
+		diff = (sort_keys[i].func)(void1, void2);
+	}
+	return diff;
+}
+
 /*****************************************************************************
  * Global Print Functions
  *****************************************************************************/
@@ -109,6 +143,11 @@ void sort_job_list(List job_list)
 	if (params.sort == NULL)
 		params.sort = xstrdup("P,t,-p"); /* Partition,state,priority */
 
+	/* Jobs otherwise equal are listed by descending start time */
+	sort_key_cnt = 0;
+	reverse_order = true;
+	_add_sort_key(_sort_job_by_time_start);
+
 	for (i=(strlen(params.sort)-1); i >= 0; i--) {
 		reverse_order = false;
 		if ((params.sort[i] == ',') ||
@@ -125,82 +164,84 @@ void sort_job_list(List job_list)
 			    (params.sort[i - CLUSTER_NAME_LEN] == '-'))
 				reverse_order = true;
 
-			list_sort(job_list, _sort_job_by_cluster_name);
+			_add_sort_key(_sort_job_by_cluster_name);
 			i -= CLUSTER_NAME_LEN - 1;
 		} else if (params.sort[i] == 'B')
-			list_sort(job_list, _sort_job_by_batch_host);
+			_add_sort_key(_sort_job_by_batch_host);
 		else if (params.sort[i] == 'b')	/* Vestigial gres sort */
 			info("Invalid sort specification: b");
 		else if (params.sort[i] == 'c')
 			;	/* sort_job_by_min_cpus_per_node */
 		else if (params.sort[i] == 'C')
-			list_sort(job_list, _sort_job_by_num_cpus);
+			_add_sort_key(_sort_job_by_num_cpus);
 		else if (params.sort[i] == 'd')
-			list_sort(job_list, _sort_job_by_min_tmp_disk);
+			_add_sort_key(_sort_job_by_min_tmp_disk);
 		else if (params.sort[i] == 'D')
-			list_sort(job_list, _sort_job_by_num_nodes);
+			_add_sort_key(_sort_job_by_num_nodes);
 		else if (params.sort[i] == 'e')
-			list_sort(job_list, _sort_job_by_time_end);
+			_add_sort_key(_sort_job_by_time_end);
 		else if (params.sort[i] == 'f')
 			;	/* sort_job_by_featuers */
 		else if (params.sort[i] == 'g')
-			list_sort(job_list, _sort_job_by_group_name);
+			_add_sort_key(_sort_job_by_group_name);
 		else if (params.sort[i] == 'G')
-			list_sort(job_list, _sort_job_by_group_id);
+			_add_sort_key(_sort_job_by_group_id);
 		else if (params.sort[i] == 'h')
 			;	/* sort_job_by_over_subscribe, not supported */
 		else if (params.sort[i] == 'H')
-			list_sort(job_list, _sort_job_by_sockets);
+			_add_sort_key(_sort_job_by_sockets);
 		else if (params.sort[i] == 'i')
-			list_sort(job_list, _sort_job_by_id);
+			_add_sort_key(_sort_job_by_id);
 		else if (params.sort[i] == 'I')
-			list_sort(job_list, _sort_job_by_cores);
+			_add_sort_key(_sort_job_by_cores);
 		else if (params.sort[i] == 'j')
-			list_sort(job_list, _sort_job_by_name);
+			_add_sort_key(_sort_job_by_name);
 		else if (params.sort[i] == 'J')
-			list_sort(job_list, _sort_job_by_threads);
+			_add_sort_key(_sort_job_by_threads);
 		else if (params.sort[i] == 'l')
-			list_sort(job_list, _sort_job_by_time_limit);
+			_add_sort_key(_sort_job_by_time_limit);
 		else if (params.sort[i] == 'L')
-			list_sort(job_list, _sort_job_by_time_left);
+			_add_sort_key(_sort_job_by_time_left);
 		else if (params.sort[i] == 'm')
-			list_sort(job_list, _sort_job_by_min_memory);
+			_add_sort_key(_sort_job_by_min_memory);
 		else if (params.sort[i] == 'M')
-			list_sort(job_list, _sort_job_by_time_used);
+			_add_sort_key(_sort_job_by_time_used);
 		else if (params.sort[i] == 'n')
 			;	/* sort_job_by_nodes_requested */
 		else if (params.sort[i] == 'N')
-			list_sort(job_list, _sort_job_by_node_list);
+			_add_sort_key(_sort_job_by_node_list);
 		else if (params.sort[i] == 'O')
 			;	/* sort_job_by_contiguous */
 		else if (params.sort[i] == 'p')
-			list_sort(job_list, _sort_job_by_priority);
+			_add_sort_key(_sort_job_by_priority);
 		else if (params.sort[i] == 'P')
-			list_sort(job_list, _sort_job_by_partition);
+			_add_sort_key(_sort_job_by_partition);
 		else if (params.sort[i] == 'Q')
-			list_sort(job_list, _sort_job_by_priority);
+			_add_sort_key(_sort_job_by_priority);
 		else if (params.sort[i] == 'S')
-			list_sort(job_list, _sort_job_by_time_start);
+			_add_sort_key(_sort_job_by_time_start);
 		else if (params.sort[i] == 't')
-			list_sort(job_list, _sort_job_by_state_compact);
+			_add_sort_key(_sort_job_by_state_compact);
 		else if (params.sort[i] == 'T')
-			list_sort(job_list, _sort_job_by_state);
+			_add_sort_key(_sort_job_by_state);
 		else if (params.sort[i] == 'u')
-			list_sort(job_list, _sort_job_by_user_name);
+			_add_sort_key(_sort_job_by_user_name);
 		else if (params.sort[i] == 'U')
-			list_sort(job_list, _sort_job_by_user_id);
+			_add_sort_key(_sort_job_by_user_id);
 		else if (params.sort[i] == 'v')
-			list_sort(job_list, _sort_job_by_reservation);
+			_add_sort_key(_sort_job_by_reservation);
 		else if (params.sort[i] == 'V')
-			list_sort(job_list, _sort_job_by_time_submit);
+			_add_sort_key(_sort_job_by_time_submit);
 		else if (params.sort[i] == 'z')
-			list_sort(job_list, _sort_job_by_num_sct);
+			_add_sort_key(_sort_job_by_num_sct);
 		else {
 			error("Invalid sort specification: %c",
 			      params.sort[i]);
 			exit(1);
 		}
 	}
+
+	list_sort(job_list, _sort_by_keys);
 }
 
 void sort_jobs_by_start_time (List jobs)
@@ -217,6 +258,8 @@ void sort_step_list(List step_list)
 
 	if (params.sort == NULL)
 		params.sort = xstrdup("P,i");	/* Partition, step id */
+
+	sort_key_cnt = 0;
 	for (i=(strlen(params.sort)-1); i >= 0; i--) {
 		reverse_order = false;
 		if ((params.sort[i] == ',') ||
@@ -232,28 +275,30 @@ void sort_step_list(List step_list)
 			    (params.sort[i - CLUSTER_NAME_LEN] == '-'))
 				reverse_order = true;
 
-			list_sort(step_list, _sort_step_by_cluster_name);
+			_add_sort_key(_sort_step_by_cluster_name);
 			i -= CLUSTER_NAME_LEN - 1;
 		}
 		else if (params.sort[i] == 'b')	/* Vestigial gres sort */
 			info("Invalid sort specification: b");
 		else if (params.sort[i] == 'i')
-			list_sort(step_list, _sort_step_by_id);
+			_add_sort_key(_sort_step_by_id);
 		else if (params.sort[i] == 'N')
-			list_sort(step_list, _sort_step_by_node_list);
+			_add_sort_key(_sort_step_by_node_list);
 		else if (params.sort[i] == 'P')
-			list_sort(step_list, _sort_step_by_partition);
+			_add_sort_key(_sort_step_by_partition);
 		else if (params.sort[i] == 'l')
-			list_sort(step_list, _sort_step_by_time_limit);
+			_add_sort_key(_sort_step_by_time_limit);
 		else if (params.sort[i] == 'S')
-			list_sort(step_list, _sort_step_by_time_start);
+			_add_sort_key(_sort_step_by_time_start);
 		else if (params.sort[i] == 'M')
-			list_sort(step_list, _sort_step_by_time_used);
+			_add_sort_key(_sort_step_by_time_used);
 		else if (params.sort[i] == 'u')
-			list_sort(step_list, _sort_step_by_user_name);
+			_add_sort_key(_sort_step_by_user_name);
 		else if (params.sort[i] == 'U')
-			list_sort(step_list, _sort_step_by_user_id);
+			_add_sort_key(_sort_step_by_user_id);
 	}
+
+	list_sort(step_list, _sort_by_keys);
 }
 
 /*****************************************************************************
@@ -297,6 +342,44 @@ static void _get_job_info_from_void(job_info_t **j1, job_info_t **j2,
 	*j1 = (*(squeue_job_rec_t **)void1)->job_ptr;
 	*j2 = (*(squeue_job_rec_t **)void2)->job_ptr;
 }
+static void _get_job_rec_from_void(squeue_job_rec_t **r1,
+				   squeue_job_rec_t **r2,
+				   void *void1, void *void2)
+{
+	*r1 = *(squeue_job_rec_t **)void1;
+	*r2 = *(squeue_job_rec_t **)void2;
+}
+/*
+ * Names and node lists used as sort keys are resolved on first use and kept
+ * in the job's record, rather than once per comparison
+ */
+static char *_job_rec_group_name(squeue_job_rec_t *job_rec)
+{
+	struct group *group_info;
+
+	if (!job_rec->group_name) {
+		if ((group_info = getgrgid((gid_t) job_rec->job_ptr->group_id)))
+			job_rec->group_name = xstrdup(group_info->gr_name);
+		else
+			job_rec->group_name = xstrdup("");
+	}
+	return job_rec->group_name;
+}
+static char *_job_rec_user_name(squeue_job_rec_t *job_rec)
+{
+	if (!job_rec->user_name)
+		job_rec->user_name = uid_to_string_cached(
+			(uid_t) job_rec->job_ptr->user_id);
+	return job_rec->user_name;
+}
+static hostlist_t _job_rec_hostlist(squeue_job_rec_t *job_rec)
+{
+	if (!job_rec->nodes_hl) {
+		job_rec->nodes_hl = hostlist_create(job_rec->job_ptr->nodes);
+		hostlist_sort(job_rec->nodes_hl);
+	}
+	return job_rec->nodes_hl;
+}
 static void _get_part_prio_info_from_void(uint32_t *prio1, uint32_t *prio2,
 					  void *void1, void *void2)
 {
@@ -368,18 +451,13 @@ static int _sort_job_by_group_id(void *void1, void *void2)
 static int _sort_job_by_group_name(void *void1, void *void2)
 {
 	int diff;
-	job_info_t *job1;
-	job_info_t *job2;
-	struct group *group_info = NULL;
-	char *name1 = "", *name2 = "";
+	squeue_job_rec_t *job_rec1;
+	squeue_job_rec_t *job_rec2;
 
-	_get_job_info_from_void(&job1, &job2, void1, void2);
+	_get_job_rec_from_void(&job_rec1, &job_rec2, void1, void2);
 
-	if ((group_info = getgrgid((gid_t) job1->group_id)))
-		name1 = group_info->gr_name;
-	if ((group_info = getgrgid((gid_t) job2->group_id)))
-		name2 = group_info->gr_name;
-	diff = xstrcmp(name1, name2);
+	diff = xstrcmp(_job_rec_group_name(job_rec1),
+		       _job_rec_group_name(job_rec2));
 
 	if (reverse_order)
 		diff = -diff;
@@ -449,39 +527,45 @@ static int _sort_job_by_name(void *void1, void *void2)
 
 static int _sort_job_by_node_list(void *void1, void *void2)
 {
-	job_info_t *job1, *job2;
-	_get_job_info_from_void(&job1, &job2, void1, void2);
-	return _sort_by_node_list(job1->nodes, job2->nodes);
+	squeue_job_rec_t *job_rec1, *job_rec2;
+	_get_job_rec_from_void(&job_rec1, &job_rec2, void1, void2);
+	return _sort_by_node_list(_job_rec_hostlist(job_rec1),
+				  _job_rec_hostlist(job_rec2));
 }
 
 static int _sort_step_by_node_list(void *void1, void *void2)
 {
 	job_step_info_t *step1, *step2;
+	hostlist_t hostlist1, hostlist2;
+	int diff;
+
 	_get_step_info_from_void(&step1, &step2, void1, void2);
-	return _sort_by_node_list(step1->nodes, step2->nodes);
+	hostlist1 = hostlist_create(step1->nodes);
+	hostlist_sort(hostlist1);
+	hostlist2 = hostlist_create(step2->nodes);
+	hostlist_sort(hostlist2);
+	diff = _sort_by_node_list(hostlist1, hostlist2);
+	hostlist_destroy(hostlist1);
+	hostlist_destroy(hostlist2);
+
+	return diff;
 }
 
-static int _sort_by_node_list(char *nodes1, char *nodes2)
+/* Compare the first host of two sorted hostlists */
+static int _sort_by_node_list(hostlist_t hostlist1, hostlist_t hostlist2)
 {
 	int diff = 0;
-	hostlist_t hostlist1, hostlist2;
 #if	PURE_ALPHA_SORT
 	char *val1, *val2;
 	char *ptr1, *ptr2;
-#endif
-	hostlist1 = hostlist_create(nodes1);
-	hostlist_sort(hostlist1);
-	hostlist2 = hostlist_create(nodes2);
-	hostlist_sort(hostlist2);
 
-#if	PURE_ALPHA_SORT
-	val1 = hostlist_shift(hostlist1);
+	val1 = hostlist_nth(hostlist1, 0);
 	if (val1)
 		ptr1 = val1;
 	else
 		ptr1 = "";
 
-	val2 = hostlist_shift(hostlist2);
+	val2 = hostlist_nth(hostlist2, 0);
 	if (val2)
 		ptr2 = val2;
 	else
@@ -499,8 +583,6 @@ static int _sort_by_node_list(char *nodes1, char *nodes2)
 	 */
 	diff = hostlist_cmp_first(hostlist1, hostlist2);
 #endif
-	hostlist_destroy(hostlist1);
-	hostlist_destroy(hostlist2);
 
 	if (reverse_order)
 		diff = -diff;
@@ -841,15 +923,13 @@ static int _sort_job_by_user_id(void *void1, void *void2)
 static int _sort_job_by_user_name(void *void1, void *void2)
 {
 	int diff;
-	job_info_t *job1;
-	job_info_t *job2;
-	char *name1, *name2;
+	squeue_job_rec_t *job_rec1;
+	squeue_job_rec_t *job_rec2;
 
-	_get_job_info_from_void(&job1, &job2, void1, void2);
+	_get_job_rec_from_void(&job_rec1, &job_rec2, void1, void2);
 
-	name1 = uid_to_string_cached((uid_t) job1->user_id);
-	name2 = uid_to_string_cached((uid_t) job2->user_id);
-	diff = xstrcmp(name1, name2);
+	diff = xstrcmp(_job_rec_user_name(job_rec1),
+		       _job_rec_user_name(job_rec2));
 
 	if (reverse_order)
 		diff = -diff;
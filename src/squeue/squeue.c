@@ -52,6 +52,8 @@
 #include "src/common/xstring.h"
 #include "src/squeue/squeue.h"
 
+#define STDOUT_BUF_SIZE (1024 * 1024)
+
 /********************
  * Global Variables *
  ********************/
@@ -64,6 +66,7 @@ int max_line_size;
 static int  _get_info(bool clear_old, bool log_cluster_name);
 static int  _get_window_width( void );
 static int  _multi_cluster(List clusters);
+static void _build_info_filter(info_filter_t *filter);
 static int  _print_job(bool clear_old, bool log_cluster_name);
 static int  _print_job_steps( bool clear_old );
 
@@ -81,9 +84,13 @@ main (int argc, char **argv)
 		log_alter(opts, SYSLOG_FACILITY_USER, NULL);
 	}
 	max_line_size = _get_window_width( );
+	/* Write rows out in large chunks rather than a line at a time */
+	setvbuf(stdout, NULL, _IOFBF, STDOUT_BUF_SIZE);
 
 	if (params.clusters)
 		working_cluster_rec = list_peek(params.clusters);
+	else if (params.iterate)
+		(void) slurm_open_controller_session();
 
 	while (1) {
 		if ((!params.no_header) &&
@@ -98,6 +105,7 @@ main (int argc, char **argv)
 
 		if ( params.iterate ) {
 			printf( "\n");
+			fflush(stdout);
 			sleep( params.iterate );
 		} else
 			break;
@@ -167,11 +175,34 @@ _get_window_width( void )
 }
 
 
+/*
+ * Have slurmctld skip jobs which _filter_job() would discard anyway. The
+ * controller only narrows the response, every filter is still applied to
+ * the jobs received.
+ * NOTE: xfree() filter->nodes when done
+ */
+static void _build_info_filter(info_filter_t *filter)
+{
+	char hostlist[8192];
+
+	memset(filter, 0, sizeof(*filter));
+	filter->accounts = params.accounts;
+	filter->partitions = params.partitions;
+	filter->users = params.users;
+	if (params.states && xstrcasecmp(params.states, "all"))
+		filter->states = params.states;
+	if (params.nodes &&
+	    (hostset_ranged_string(params.nodes, sizeof(hostlist),
+				   hostlist) >= 0))
+		filter->nodes = xstrdup(hostlist);
+}
+
 /* _print_job - print the specified job's information */
 static int _print_job(bool clear_old, bool log_cluster_name)
 {
 	static job_info_msg_t *old_job_ptr;
 	job_info_msg_t *new_job_ptr = NULL;
+	info_filter_t filter;
 	int error_code;
 	uint16_t show_flags = 0;
 
@@ -188,6 +219,8 @@ static int _print_job(bool clear_old, bool log_cluster_name)
 	if (params.format && strstr(params.format, "C"))
 		show_flags |= SHOW_DETAIL;
 
+	_build_info_filter(&filter);
+
 	if (old_job_ptr) {
 		if (clear_old)
 			old_job_ptr->last_update = 0;
@@ -196,15 +229,15 @@ static int _print_job(bool clear_old, bool log_cluster_name)
 				&new_job_ptr, params.job_id,
 				show_flags);
 		} else if (params.user_id) {
-			error_code = slurm_load_job_user(&new_job_ptr,
-							 params.user_id,
-							 show_flags);
+			error_code = slurm_load_job_user_update(
+				old_job_ptr->last_update, &new_job_ptr,
+				params.user_id, show_flags);
 		} else {
 			if (params.clusters)
 				show_flags |= SHOW_LOCAL;
-			error_code = slurm_load_jobs(
+			error_code = slurm_load_jobs_filter(
 				old_job_ptr->last_update,
-				&new_job_ptr, show_flags);
+				&new_job_ptr, show_flags, &filter);
 		}
 		if (error_code ==  SLURM_SUCCESS)
 			slurm_free_job_info_msg( old_job_ptr );
@@ -219,16 +252,18 @@ static int _print_job(bool clear_old, bool log_cluster_name)
 		error_code = slurm_load_job_user(&new_job_ptr, params.user_id,
 						 show_flags);
 	} else {
-		error_code = slurm_load_jobs((time_t) NULL, &new_job_ptr,
-					     show_flags);
+		error_code = slurm_load_jobs_filter((time_t) NULL,
+						    &new_job_ptr, show_flags,
+						    &filter);
 	}
+	xfree(filter.nodes);
 
 	if (error_code) {
 		slurm_perror ("slurm_load_jobs error");
 		return SLURM_ERROR;
 	}
 	old_job_ptr = new_job_ptr;
-	if (params.job_id || params.user_id)
+	if (params.job_id)
 		old_job_ptr->last_update = (time_t) 0;
 
 	if (params.verbose) {
@@ -38,6 +38,7 @@
 #include "src/sview/sview.h"
 #include "src/common/parse_time.h"
 #include "src/common/proc_args.h"
+#include "src/common/xhash.h"
 #include "src/common/xstring.h"
 
 #define _DEBUG 0
@@ -3012,26 +3013,29 @@ static int _sview_job_sort_aval_dec(void *s1, void *s2)
 	return 0;
 }
 
-static int _task_array_match(void *x, void *key)
+static void _job_id_key(void *item, const char **key, uint32_t *key_len)
 {
-	sview_job_info_t *sview_job_info_ptr = (sview_job_info_t *) x;
-	job_info_t *job_ptr = (job_info_t *) key;
+	sview_job_info_t *sview_job_info_ptr = item;
 
-	if (sview_job_info_ptr->job_ptr->array_job_id  == job_ptr->array_job_id)
-		return 1;
-
-	return 0;
+	*key = (const char *) &sview_job_info_ptr->job_id;
+	*key_len = sizeof(uint32_t);
 }
 
-static int _het_job_id_match(void *x, void *key)
+static void _array_job_id_key(void *item, const char **key,
+			      uint32_t *key_len)
 {
-	sview_job_info_t *sview_job_info_ptr = (sview_job_info_t *) x;
-	job_info_t *job_ptr = (job_info_t *) key;
+	sview_job_info_t *sview_job_info_ptr = item;
 
-	if (sview_job_info_ptr->job_ptr->het_job_id  == job_ptr->het_job_id)
-		return 1;
+	*key = (const char *) &sview_job_info_ptr->job_ptr->array_job_id;
+	*key_len = sizeof(uint32_t);
+}
 
-	return 0;
+static void _het_job_id_key(void *item, const char **key, uint32_t *key_len)
+{
+	sview_job_info_t *sview_job_info_ptr = item;
+
+	*key = (const char *) &sview_job_info_ptr->job_ptr->het_job_id;
+	*key_len = sizeof(uint32_t);
 }
 
 static List _create_job_info_list(job_info_msg_t *job_info_ptr,
@@ -3048,6 +3052,13 @@ static List _create_job_info_list(job_info_msg_t *job_info_ptr,
 	sview_job_info_t *sview_job_info_ptr = NULL;
 	job_info_t *job_ptr = NULL;
 	job_step_info_t *step_ptr = NULL;
+	/*
+	 * last_hash holds the records of the previous refresh not yet reused,
+	 * job_hash the records of this one. array_hash and het_hash hold the
+	 * first record in info_list of each job array and hetjob.
+	 */
+	xhash_t *last_hash = NULL, *job_hash = NULL;
+	xhash_t *array_hash = NULL, *het_hash = NULL;
 
 	if (info_list && (job_info_ptr == last_job_info_ptr)
 	    && (step_info_ptr == last_step_info_ptr))
@@ -3064,8 +3075,15 @@ static List _create_job_info_list(job_info_msg_t *job_info_ptr,
 		info_list = list_create(NULL);
 		odd_info_list = list_create(_job_info_list_del);
 	}
-	if (last_list)
+	if (last_list) {
+		last_hash = xhash_init(_job_id_key, NULL);
 		last_list_itr = list_iterator_create(last_list);
+		while ((sview_job_info_ptr = list_next(last_list_itr)))
+			xhash_add(last_hash, sview_job_info_ptr);
+	}
+	job_hash = xhash_init(_job_id_key, NULL);
+	array_hash = xhash_init(_array_job_id_key, NULL);
+	het_hash = xhash_init(_het_job_id_key, NULL);
 	for (i=0; i<job_info_ptr->record_count; i++) {
 		bool added_task = false;
 
@@ -3073,22 +3091,13 @@ static List _create_job_info_list(job_info_msg_t *job_info_ptr,
 		if (job_ptr->job_id == 0)
 			continue;
 
-		sview_job_info_ptr = NULL;
-
-		if (last_list_itr) {
-			while ((sview_job_info_ptr =
-				list_next(last_list_itr))) {
-				if (sview_job_info_ptr->job_id ==
-				    job_ptr->job_id) {
-					list_remove(last_list_itr);
-					_job_info_free(sview_job_info_ptr);
-					break;
-				}
-			}
-			list_iterator_reset(last_list_itr);
-		}
-
-		if (!sview_job_info_ptr)
+		/* Reuse the record of the last refresh to keep its row */
+		if (last_hash &&
+		    (sview_job_info_ptr = xhash_pop(last_hash,
+						    (char *) &job_ptr->job_id,
+						    sizeof(uint32_t))))
+			_job_info_free(sview_job_info_ptr);
+		else
 			sview_job_info_ptr = xmalloc(sizeof(sview_job_info_t));
 
 		sview_job_info_ptr->job_ptr = job_ptr;
@@ -3098,8 +3107,9 @@ static List _create_job_info_list(job_info_msg_t *job_info_ptr,
 		    (job_ptr->array_task_id != NO_VAL)) {
 			char task_str[64];
 			sview_job_info_t *first_job_info_ptr =
-				list_find_first(info_list,
-						_task_array_match, job_ptr);
+				xhash_get(array_hash,
+					  (char *) &job_ptr->array_job_id,
+					  sizeof(uint32_t));
 			if (job_ptr->array_task_str) {
 				snprintf(task_str, sizeof(task_str), "[%s]",
 					 job_ptr->array_task_str);
@@ -3154,8 +3164,9 @@ static List _create_job_info_list(job_info_msg_t *job_info_ptr,
 			snprintf(comp_str, sizeof(comp_str), "%u",
 				 job_ptr->het_job_offset);
 			sview_job_info_t *first_job_info_ptr =
-				list_find_first(info_list,
-						_het_job_id_match, job_ptr);
+				xhash_get(het_hash,
+					  (char *) &job_ptr->het_job_id,
+					  sizeof(uint32_t));
 			if (!first_job_info_ptr) {
 				sview_job_info_ptr->task_list =
 					list_create(NULL);
@@ -3186,15 +3197,8 @@ static List _create_job_info_list(job_info_msg_t *job_info_ptr,
 			job_ptr->job_id % sview_colors_cnt;
 		sview_job_info_ptr->nodes = xstrdup(job_ptr->nodes);
 		sview_job_info_ptr->node_cnt = job_ptr->num_nodes;
+		xhash_add(job_hash, sview_job_info_ptr);
 
-		for (j = 0; j < step_info_ptr->job_step_count; j++) {
-			step_ptr = &(step_info_ptr->job_steps[j]);
-			if ((step_ptr->step_id.job_id == job_ptr->job_id) &&
-			    (step_ptr->state == JOB_RUNNING)) {
-				list_append(sview_job_info_ptr->step_list,
-					    step_ptr);
-			}
-		}
 		if (!added_task)
 			list_append(odd_info_list, sview_job_info_ptr);
 
@@ -3205,17 +3209,49 @@ static List _create_job_info_list(job_info_msg_t *job_info_ptr,
 			continue;
 		}
 
-		if (!added_task)
-			list_append(info_list, sview_job_info_ptr);
+		if (added_task)
+			continue;
+
+		list_append(info_list, sview_job_info_ptr);
+		if ((job_ptr->array_task_str ||
+		     (job_ptr->array_task_id != NO_VAL)) &&
+		    !xhash_get(array_hash, (char *) &job_ptr->array_job_id,
+			       sizeof(uint32_t)))
+			xhash_add(array_hash, sview_job_info_ptr);
+		else if (job_ptr->het_job_id &&
+			 !xhash_get(het_hash, (char *) &job_ptr->het_job_id,
+				    sizeof(uint32_t)))
+			xhash_add(het_hash, sview_job_info_ptr);
 	}
 
+	for (j = 0; j < step_info_ptr->job_step_count; j++) {
+		step_ptr = &(step_info_ptr->job_steps[j]);
+		if ((step_ptr->state == JOB_RUNNING) &&
+		    (sview_job_info_ptr = xhash_get(
+			    job_hash, (char *) &step_ptr->step_id.job_id,
+			    sizeof(uint32_t))))
+			list_append(sview_job_info_ptr->step_list, step_ptr);
+	}
+	xhash_free(job_hash);
+	xhash_free(array_hash);
+	xhash_free(het_hash);
+
 	list_sort(info_list, (ListCmpF)_sview_job_sort_aval_dec);
 
 	list_sort(odd_info_list, (ListCmpF)_sview_job_sort_aval_dec);
 
 	if (last_list) {
+		/* Unlink the reused records, the others are gone jobs */
+		list_iterator_reset(last_list_itr);
+		while ((sview_job_info_ptr = list_next(last_list_itr))) {
+			if (xhash_get(last_hash,
+				      (char *) &sview_job_info_ptr->job_id,
+				      sizeof(uint32_t)) != sview_job_info_ptr)
+				list_remove(last_list_itr);
+		}
 		list_iterator_destroy(last_list_itr);
 		FREE_NULL_LIST(last_list);
+		xhash_free(last_hash);
 	}
 
 update_color:
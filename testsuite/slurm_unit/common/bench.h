@@ -0,0 +1,159 @@
+/*****************************************************************************\
+ *  bench.h - minimal harness for the common/ microbenchmarks
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _BENCH_H
+#define _BENCH_H
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "src/common/log.h"
+
+/*
+ * Minimal harness for the microbenchmarks run by "make bench".
+ *
+ * Each benchmark is run BENCH_RUNS times after one warm up run, and reports
+ * one JSON object per line:
+ *	{"suite":"bitstring","bench":"bit_set_count","iters":100000,
+ *	 "runs":5,"min_ns":12.3,"median_ns":12.5}
+ * where min_ns and median_ns are nanoseconds per iteration.
+ *
+ * Options:
+ *	-r <runs>	number of timed runs per benchmark (default BENCH_RUNS)
+ *	-s <scale>	multiply the iteration count of every benchmark
+ *	-f <filter>	only run benchmarks whose name contains <filter>
+ *
+ * Input data is generated from BENCH_SEED, so results are comparable
+ * between builds of the same machine.
+ */
+
+#define BENCH_RUNS 5
+#define BENCH_MAX_RUNS 101
+#define BENCH_SEED 20210401
+
+typedef void (*bench_func_t)(uint64_t iters, void *arg);
+
+static const char *bench_suite = NULL;
+static const char *bench_filter = NULL;
+static int bench_runs = BENCH_RUNS;
+static uint64_t bench_scale = 1;
+
+/* Written by benchmarks so the compiler can not discard their results */
+static volatile uint64_t bench_sink = 0;
+
+static void bench_init(const char *suite, int argc, char **argv)
+{
+	log_options_t log_opts = LOG_OPTS_INITIALIZER;
+	int c;
+
+	bench_suite = suite;
+	while ((c = getopt(argc, argv, "f:r:s:")) != -1) {
+		switch (c) {
+		case 'f':
+			bench_filter = optarg;
+			break;
+		case 'r':
+			bench_runs = atoi(optarg);
+			break;
+		case 's':
+			bench_scale = strtoull(optarg, NULL, 10);
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-f filter] [-r runs] [-s scale]\n",
+				argv[0]);
+			exit(1);
+		}
+	}
+	if ((bench_runs < 1) || (bench_runs > BENCH_MAX_RUNS))
+		bench_runs = BENCH_RUNS;
+	if (!bench_scale)
+		bench_scale = 1;
+
+	log_opts.stderr_level = LOG_LEVEL_ERROR;
+	log_init((char *) suite, log_opts, 0, NULL);
+	srandom(BENCH_SEED);
+}
+
+static uint64_t _bench_now_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t) ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+static int _bench_cmp(const void *a, const void *b)
+{
+	double x = *(const double *) a, y = *(const double *) b;
+
+	return (x > y) - (x < y);
+}
+
+/*
+ * Time func(iters, arg). Setup work that should not be measured belongs
+ * outside of func, in the caller.
+ */
+static void bench_run(const char *name, uint64_t iters, bench_func_t func,
+		      void *arg)
+{
+	double ns[BENCH_MAX_RUNS];
+	int i;
+
+	if (bench_filter && !strstr(name, bench_filter))
+		return;
+
+	iters *= bench_scale;
+	func(iters, arg);	/* warm up caches and allocator */
+	for (i = 0; i < bench_runs; i++) {
+		uint64_t start = _bench_now_nsec();
+		func(iters, arg);
+		ns[i] = (double) (_bench_now_nsec() - start) / iters;
+	}
+	qsort(ns, bench_runs, sizeof(double), _bench_cmp);
+
+	printf("{\"suite\":\"%s\",\"bench\":\"%s\",\"iters\":%"PRIu64",\"runs\":%d,\"min_ns\":%.1f,\"median_ns\":%.1f}\n",
+	       bench_suite, name, iters, bench_runs, ns[0],
+	       ns[bench_runs / 2]);
+	fflush(stdout);
+}
+
+static void bench_fini(void)
+{
+	log_fini();
+}
+
+#endif
@@ -0,0 +1,139 @@
+/*****************************************************************************\
+ *  bitstring-bench.c - microbenchmarks for bitstring.c
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "src/common/bitstring.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "bench.h"
+
+#define NBITS 65536
+
+static bitstr_t *b1 = NULL, *b2 = NULL;
+
+static void _set_test(uint64_t iters, void *arg)
+{
+	bitstr_t *b = bit_alloc(NBITS);
+
+	for (uint64_t i = 0; i < iters; i++)
+		bit_set(b, (i * 7919) % NBITS);
+	bench_sink += bit_test(b, 0);
+	FREE_NULL_BITMAP(b);
+}
+
+static void _set_count(uint64_t iters, void *arg)
+{
+	for (uint64_t i = 0; i < iters; i++)
+		bench_sink += bit_set_count(b1);
+}
+
+static void _ffs(uint64_t iters, void *arg)
+{
+	bitstr_t *b = bit_alloc(NBITS);
+
+	bit_set(b, NBITS - 1);
+	for (uint64_t i = 0; i < iters; i++)
+		bench_sink += bit_ffs(b);
+	FREE_NULL_BITMAP(b);
+}
+
+static void _and(uint64_t iters, void *arg)
+{
+	bitstr_t *b = bit_copy(b1);
+
+	for (uint64_t i = 0; i < iters; i++)
+		bit_and(b, b2);
+	bench_sink += bit_ffs(b);
+	FREE_NULL_BITMAP(b);
+}
+
+static void _overlap(uint64_t iters, void *arg)
+{
+	for (uint64_t i = 0; i < iters; i++)
+		bench_sink += bit_overlap(b1, b2);
+}
+
+static void _fmt(uint64_t iters, void *arg)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		char *str = bit_fmt_full(b1);
+		bench_sink += str[0];
+		xfree(str);
+	}
+}
+
+static void _unfmt(uint64_t iters, void *arg)
+{
+	char *str = arg;
+	bitstr_t *b = bit_alloc(NBITS);
+
+	for (uint64_t i = 0; i < iters; i++) {
+		bit_clear_all(b);
+		bench_sink += bit_unfmt(b, str);
+	}
+	FREE_NULL_BITMAP(b);
+}
+
+int main(int argc, char **argv)
+{
+	char *str;
+
+	bench_init("bitstring", argc, argv);
+
+	/* Random bitmaps about half full, as typical of node bitmaps */
+	b1 = bit_alloc(NBITS);
+	b2 = bit_alloc(NBITS);
+	for (int i = 0; i < NBITS; i++) {
+		if (random() & 1)
+			bit_set(b1, i);
+		if (random() & 1)
+			bit_set(b2, i);
+	}
+	/* Ranges rather than single bits, as typical of allocations */
+	str = xstrdup("0-1023,2048-4095,8192,8194,8196-16383,32768-65535");
+
+	bench_run("bit_set", 1000000, _set_test, NULL);
+	bench_run("bit_set_count", 10000, _set_count, NULL);
+	bench_run("bit_ffs_last", 10000, _ffs, NULL);
+	bench_run("bit_and", 10000, _and, NULL);
+	bench_run("bit_overlap", 10000, _overlap, NULL);
+	bench_run("bit_fmt_full", 100, _fmt, NULL);
+	bench_run("bit_unfmt", 10000, _unfmt, str);
+
+	xfree(str);
+	FREE_NULL_BITMAP(b1);
+	FREE_NULL_BITMAP(b2);
+	bench_fini();
+
+	return 0;
+}
@@ -152,6 +152,26 @@ main(int argc, char *argv[])
 		TEST(bit_ffs(bs) == 1048575, "bitstring");
 		bit_free(bs);
 	}
+	note("Testing bit_set_count/bit_overlap with partial words");
+	{
+		bitstr_t *bs = bit_alloc(130), *bs2 = bit_alloc(130);
+
+		bit_not(bs);	/* also sets unused bits of the last word */
+		TEST(bit_set_count(bs) == 130, "bitstring");
+		bit_set(bs2, 0);
+		bit_set(bs2, 64);
+		bit_set(bs2, 129);
+		TEST(bit_overlap(bs, bs2) == 3, "bitstring");
+		TEST(bit_overlap_any(bs, bs2) == 1, "bitstring");
+		bit_clear(bs, 0);
+		bit_clear(bs, 64);
+		bit_clear(bs, 129);
+		TEST(bit_set_count(bs) == 127, "bitstring");
+		TEST(bit_overlap(bs, bs2) == 0, "bitstring");
+		TEST(bit_overlap_any(bs, bs2) == 0, "bitstring");
+		bit_free(bs);
+		bit_free(bs2);
+	}
 	note("Testing bit_fmt");
 	{
 		char tmpstr[1024];
@@ -0,0 +1,170 @@
+/*****************************************************************************\
+ *  data-bench.c - microbenchmarks for data.c
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "src/common/data.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "bench.h"
+
+#define NJOBS 1000
+
+/* Build a tree shaped like the slurmrestd job listings */
+static data_t *_build_jobs(void)
+{
+	data_t *d = data_set_dict(data_new());
+	data_t *jobs = data_set_list(data_key_set(d, "jobs"));
+
+	for (int i = 0; i < NJOBS; i++) {
+		data_t *job = data_set_dict(data_list_append(jobs));
+		data_t *tres = data_set_dict(data_key_set(job, "tres"));
+		data_t *nodes = data_set_list(data_key_set(job, "nodes"));
+
+		data_set_int(data_key_set(job, "job_id"), 1000 + i);
+		data_set_string(data_key_set(job, "name"), "batch");
+		data_set_string(data_key_set(job, "partition"), "debug");
+		data_set_string(data_key_set(job, "account"), "physics");
+		data_set_string(data_key_set(job, "job_state"), "RUNNING");
+		data_set_int(data_key_set(job, "priority"), random());
+		data_set_bool(data_key_set(job, "requeue"), false);
+		data_set_float(data_key_set(job, "billing"), 1.5);
+		data_set_int(data_key_set(tres, "cpu"), 64);
+		data_set_string(data_key_set(tres, "mem"), "250G");
+		for (int j = 0; j < 4; j++) {
+			char name[32];
+			snprintf(name, sizeof(name), "node%05d", i + j);
+			data_set_string(data_list_append(nodes), name);
+		}
+	}
+
+	return d;
+}
+
+static data_for_each_cmd_t _count_job(const data_t *data, void *arg)
+{
+	int64_t job_id = 0;
+
+	if (!data_retrieve_dict_path_int(data, "job_id", &job_id))
+		*(uint64_t *) arg += job_id;
+	return DATA_FOR_EACH_CONT;
+}
+
+static void _build_free(uint64_t iters, void *arg)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		data_t *d = _build_jobs();
+		bench_sink += data_get_list_length(data_key_get(d, "jobs"));
+		FREE_NULL_DATA(d);
+	}
+}
+
+static void _copy(uint64_t iters, void *arg)
+{
+	data_t *src = arg;
+
+	for (uint64_t i = 0; i < iters; i++) {
+		data_t *d = data_copy(NULL, src);
+		bench_sink += data_get_type(d);
+		FREE_NULL_DATA(d);
+	}
+}
+
+static void _check_match(uint64_t iters, void *arg)
+{
+	data_t *src = arg;
+	data_t *d = data_copy(NULL, src);
+
+	for (uint64_t i = 0; i < iters; i++)
+		bench_sink += data_check_match(src, d, false);
+	FREE_NULL_DATA(d);
+}
+
+static void _list_walk(uint64_t iters, void *arg)
+{
+	const data_t *jobs = data_key_get_const(arg, "jobs");
+	uint64_t sum = 0;
+
+	for (uint64_t i = 0; i < iters; i++)
+		data_list_for_each_const(jobs, _count_job, &sum);
+	bench_sink += sum;
+}
+
+static void _resolve_path(uint64_t iters, void *arg)
+{
+	data_t *job = data_set_dict(data_new());
+
+	data_set_int(data_define_dict_path(job, "job/resources/tres/cpu"),
+		     64);
+	for (uint64_t i = 0; i < iters; i++) {
+		int64_t cpus = 0;
+		data_retrieve_dict_path_int(job, "job/resources/tres/cpu",
+					    &cpus);
+		bench_sink += cpus;
+	}
+	FREE_NULL_DATA(job);
+}
+
+static void _convert(uint64_t iters, void *arg)
+{
+	data_t *d = data_new();
+
+	for (uint64_t i = 0; i < iters; i++) {
+		data_set_string(d, "12345");
+		data_convert_type(d, DATA_TYPE_INT_64);
+		bench_sink += data_get_int(d);
+	}
+	FREE_NULL_DATA(d);
+}
+
+int main(int argc, char **argv)
+{
+	data_t *jobs;
+
+	bench_init("data", argc, argv);
+	if (data_init_static())
+		fatal("data_init_static() failed");
+	jobs = _build_jobs();
+
+	bench_run("data_build_free", 10, _build_free, NULL);
+	bench_run("data_copy", 10, _copy, jobs);
+	bench_run("data_check_match", 10, _check_match, jobs);
+	bench_run("data_list_for_each", 100, _list_walk, jobs);
+	bench_run("data_resolve_dict_path", 100000, _resolve_path, NULL);
+	bench_run("data_convert_type", 100000, _convert, NULL);
+
+	FREE_NULL_DATA(jobs);
+	data_destroy_static();
+	bench_fini();
+
+	return 0;
+}
@@ -0,0 +1,144 @@
+/*****************************************************************************\
+ *  hostlist-bench.c - microbenchmarks for hostlist.c
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "src/common/hostlist.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "bench.h"
+
+#define NHOSTS 16384
+
+/* Ranged expression of NHOSTS hosts, as found in slurm.conf and jobs */
+static char *ranged = NULL;
+/* The same hosts one by one and shuffled, as built up by the daemons */
+static char **names = NULL;
+
+static void _create(uint64_t iters, void *arg)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		hostlist_t hl = hostlist_create(ranged);
+		bench_sink += hostlist_count(hl);
+		hostlist_destroy(hl);
+	}
+}
+
+static void _ranged_string(uint64_t iters, void *arg)
+{
+	hostlist_t hl = hostlist_create(ranged);
+
+	for (uint64_t i = 0; i < iters; i++) {
+		char *str = hostlist_ranged_string_xmalloc(hl);
+		bench_sink += str[0];
+		xfree(str);
+	}
+	hostlist_destroy(hl);
+}
+
+static void _push_uniq(uint64_t iters, void *arg)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		hostlist_t hl = hostlist_create(NULL);
+		for (int j = 0; j < NHOSTS; j++)
+			hostlist_push_host(hl, names[j]);
+		hostlist_uniq(hl);
+		bench_sink += hostlist_count(hl);
+		hostlist_destroy(hl);
+	}
+}
+
+static void _find(uint64_t iters, void *arg)
+{
+	hostlist_t hl = hostlist_create(ranged);
+
+	for (uint64_t i = 0; i < iters; i++)
+		bench_sink += hostlist_find(hl, names[i % NHOSTS]);
+	hostlist_destroy(hl);
+}
+
+static void _nth(uint64_t iters, void *arg)
+{
+	hostlist_t hl = hostlist_create(ranged);
+
+	for (uint64_t i = 0; i < iters; i++) {
+		char *name = hostlist_nth(hl, (i * 7919) % NHOSTS);
+		bench_sink += name[0];
+		free(name);
+	}
+	hostlist_destroy(hl);
+}
+
+static void _hostset_within(uint64_t iters, void *arg)
+{
+	hostset_t hs = hostset_create(ranged);
+
+	for (uint64_t i = 0; i < iters; i++)
+		bench_sink += hostset_within(hs, names[i % NHOSTS]);
+	hostset_destroy(hs);
+}
+
+int main(int argc, char **argv)
+{
+	bench_init("hostlist", argc, argv);
+
+	/* Racks of 64 nodes with a few holes, so the ranges do not collapse */
+	for (int i = 0; i < NHOSTS; i += 64) {
+		xstrfmtcat(ranged, "%srack%d-[0-%d]", ranged ? "," : "",
+			   i / 64, 62 - (i / 64) % 8);
+	}
+	names = xcalloc(NHOSTS, sizeof(char *));
+	for (int i = 0; i < NHOSTS; i++)
+		names[i] = xstrdup_printf("rack%d-%d", i / 64,
+					  (int) (random() % 55));
+	for (int i = NHOSTS - 1; i > 0; i--) {
+		int j = random() % (i + 1);
+		char *tmp = names[i];
+		names[i] = names[j];
+		names[j] = tmp;
+	}
+
+	bench_run("hostlist_create", 100, _create, NULL);
+	bench_run("hostlist_ranged_string", 100, _ranged_string, NULL);
+	bench_run("hostlist_push_uniq", 1, _push_uniq, NULL);
+	bench_run("hostlist_find", 10000, _find, NULL);
+	bench_run("hostlist_nth", 10000, _nth, NULL);
+	bench_run("hostset_within", 10000, _hostset_within, NULL);
+
+	for (int i = 0; i < NHOSTS; i++)
+		xfree(names[i]);
+	xfree(names);
+	xfree(ranged);
+	bench_fini();
+
+	return 0;
+}
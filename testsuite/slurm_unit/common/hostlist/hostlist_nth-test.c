@@ -47,6 +47,7 @@ char *slurm_hostset_nth(hostset_t, int);
 hostset_t slurm_hostset_create(const char*);
 void slurm_hostset_destroy(hostset_t);
 int slurm_hostset_count(hostset_t);
+int slurm_hostlist_for_each_host(hostlist_t, int (*)(char *, void *), void *);
 
 #ifndef NDEBUG
 /* note: only works in CK_FORK mode */
@@ -144,6 +145,71 @@ START_TEST(hostset_nth_check)
 }
 END_TEST
 
+START_TEST(hostlist_push_host_check)
+{
+	hostlist_t hl = slurm_hostlist_create(NULL);
+	char *p;
+
+	slurm_hostlist_push_host(hl, "n007");
+	slurm_hostlist_push_host(hl, "n008");
+	slurm_hostlist_push_host(hl, "n9");
+	slurm_hostlist_push_host(hl, "n10");
+	slurm_hostlist_push_host(hl, "login");
+	slurm_hostlist_push_host(hl, "123");
+	slurm_hostlist_push_host(hl, "x12345678901234");
+	ck_assert_int_eq(slurm_hostlist_count(hl), 7);
+
+	p = slurm_hostlist_ranged_string_malloc(hl);
+	ck_assert_str_eq(p, "n[007-008,9-10],login,123,x12345678901234");
+	free(p);
+
+	slurm_hostlist_destroy(hl);
+}
+END_TEST
+
+typedef struct {
+	hostlist_t expect;
+	int count;
+	int stop;
+} for_each_args_t;
+
+static int _for_each_host(char *host, void *arg)
+{
+	for_each_args_t *args = arg;
+	char *p = slurm_hostlist_shift(args->expect);
+
+	ck_assert_str_eq(host, p);
+	free(p);
+
+	if (++args->count == args->stop)
+		return -1;
+	return 0;
+}
+
+START_TEST(hostlist_for_each_host_check)
+{
+	hostlist_t hl = slurm_hostlist_create("tux[1-3,009],login,x[2-3]");
+	for_each_args_t args = { 0 };
+
+	args.expect = slurm_hostlist_create("tux[1-3,009],login,x[2-3]");
+	ck_assert_int_eq(slurm_hostlist_for_each_host(hl, _for_each_host,
+						      &args), 7);
+	ck_assert_int_eq(args.count, 7);
+	ck_assert_int_eq(slurm_hostlist_count(hl), 7);
+	slurm_hostlist_destroy(args.expect);
+
+	/* negative return from the callback stops the walk */
+	args.expect = slurm_hostlist_create("tux[1-3,009],login,x[2-3]");
+	args.count = 0;
+	args.stop = 4;
+	ck_assert_int_eq(slurm_hostlist_for_each_host(hl, _for_each_host,
+						      &args), 4);
+	slurm_hostlist_destroy(args.expect);
+
+	slurm_hostlist_destroy(hl);
+}
+END_TEST
+
 /*****************************************************************************
  * TEST SUITE                                                                *
  ****************************************************************************/
@@ -154,6 +220,8 @@ Suite *make_nonassert_suite(void)
 	TCase *tc_core = tcase_create("host_nth_check_nonassert");
 	tcase_add_test(tc_core, hostlist_nth_check);
 	tcase_add_test(tc_core, hostset_nth_check);
+	tcase_add_test(tc_core, hostlist_push_host_check);
+	tcase_add_test(tc_core, hostlist_for_each_host_check);
 	suite_add_tcase(s, tc_core);
 	return s;
 }
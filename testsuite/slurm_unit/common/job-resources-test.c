@@ -8,6 +8,7 @@
 #include <stdlib.h>
 #include <src/common/bitstring.h>
 #include <src/common/job_resources.h>
+#include <src/common/pack.h>
 #include <sys/time.h>
 #include <testsuite/dejagnu.h>
 
@@ -157,6 +158,48 @@ main(int argc, char *argv[])
 	_free_job_res(job1);
 	_free_job_res(job2);
 
+	note("Testing un/pack_job_resources");
+	job1 = xmalloc(sizeof(job_resources_t));
+	job1->nhosts = NODE_CNT;
+	job1->cpus = xcalloc(NODE_CNT, sizeof(uint16_t));
+	job1->cpus_used = xcalloc(NODE_CNT, sizeof(uint16_t));
+	job1->memory_allocated = xcalloc(NODE_CNT, sizeof(uint64_t));
+	for (int i = 0; i < NODE_CNT; i++) {
+		job1->cpus[i] = (i < 6) ? 10 : 4;
+		job1->cpus_used[i] = i;
+		job1->memory_allocated[i] = 1024;
+	}
+	job1->cores_per_socket = xcalloc(1, sizeof(uint16_t));
+	job1->sockets_per_node = xcalloc(1, sizeof(uint16_t));
+	job1->sock_core_rep_count = xcalloc(1, sizeof(uint32_t));
+	job1->cores_per_socket[0] = 5;
+	job1->sockets_per_node[0] = 2;
+	job1->sock_core_rep_count[0] = NODE_CNT;
+	job1->core_bitmap = bit_alloc(CORE_CNT);
+	job1->core_bitmap_used = bit_alloc(CORE_CNT);
+	bit_nset(job1->core_bitmap, 0, 59);
+
+	buf_t *buffer = init_buf(0);
+	pack_job_resources(job1, buffer, SLURM_PROTOCOL_VERSION);
+	set_buf_offset(buffer, 0);
+	job2 = NULL;
+	TEST(!unpack_job_resources(&job2, buffer, SLURM_PROTOCOL_VERSION),
+	     "unpack_job_resources");
+	if (job2) {
+		TEST(!memcmp(job1->cpus, job2->cpus,
+			     NODE_CNT * sizeof(uint16_t)), "cpus");
+		TEST(!memcmp(job1->cpus_used, job2->cpus_used,
+			     NODE_CNT * sizeof(uint16_t)), "cpus_used");
+		TEST(!memcmp(job1->memory_allocated, job2->memory_allocated,
+			     NODE_CNT * sizeof(uint64_t)), "memory_allocated");
+		TEST(!job2->memory_used, "memory_used");
+		TEST(bit_equal(job1->core_bitmap, job2->core_bitmap),
+		     "core_bitmap");
+	}
+	free_buf(buffer);
+	free_job_resources(&job1);
+	free_job_resources(&job2);
+
 	totals();
 	return failed;
 }
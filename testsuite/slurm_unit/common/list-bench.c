@@ -0,0 +1,156 @@
+/*****************************************************************************\
+ *  list-bench.c - microbenchmarks for list.c
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "src/common/list.h"
+#include "src/common/xmalloc.h"
+
+#include "bench.h"
+
+#define NITEMS 10000
+
+static uint32_t *values = NULL;
+
+static int _find_value(void *x, void *key)
+{
+	return (*(uint32_t *) x == *(uint32_t *) key);
+}
+
+static int _sum_value(void *x, void *arg)
+{
+	*(uint64_t *) arg += *(uint32_t *) x;
+	return 0;
+}
+
+static int _cmp_value(void *x, void *y)
+{
+	uint32_t a = **(uint32_t **) x, b = **(uint32_t **) y;
+
+	return (a > b) - (a < b);
+}
+
+static List _fill_list(void)
+{
+	List l = list_create(NULL);
+
+	for (int i = 0; i < NITEMS; i++)
+		list_append(l, &values[i]);
+	return l;
+}
+
+static void _append_destroy(uint64_t iters, void *arg)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		List l = _fill_list();
+		bench_sink += list_count(l);
+		FREE_NULL_LIST(l);
+	}
+}
+
+static void _enqueue_dequeue(uint64_t iters, void *arg)
+{
+	List l = list_create(NULL);
+
+	for (uint64_t i = 0; i < iters; i++) {
+		list_enqueue(l, &values[i % NITEMS]);
+		bench_sink += *(uint32_t *) list_dequeue(l);
+	}
+	FREE_NULL_LIST(l);
+}
+
+static void _find_first(uint64_t iters, void *arg)
+{
+	List l = _fill_list();
+
+	for (uint64_t i = 0; i < iters; i++)
+		bench_sink += !!list_find_first(l, _find_value,
+						&values[i % NITEMS]);
+	FREE_NULL_LIST(l);
+}
+
+static void _for_each(uint64_t iters, void *arg)
+{
+	List l = _fill_list();
+	uint64_t sum = 0;
+
+	for (uint64_t i = 0; i < iters; i++)
+		list_for_each(l, _sum_value, &sum);
+	bench_sink += sum;
+	FREE_NULL_LIST(l);
+}
+
+static void _iterate(uint64_t iters, void *arg)
+{
+	List l = _fill_list();
+	uint64_t sum = 0;
+
+	for (uint64_t i = 0; i < iters; i++) {
+		ListIterator itr = list_iterator_create(l);
+		uint32_t *x;
+		while ((x = list_next(itr)))
+			sum += *x;
+		list_iterator_destroy(itr);
+	}
+	bench_sink += sum;
+	FREE_NULL_LIST(l);
+}
+
+static void _sort(uint64_t iters, void *arg)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		List l = _fill_list();
+		list_sort(l, _cmp_value);
+		bench_sink += *(uint32_t *) list_peek(l);
+		FREE_NULL_LIST(l);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	bench_init("list", argc, argv);
+
+	values = xcalloc(NITEMS, sizeof(uint32_t));
+	for (int i = 0; i < NITEMS; i++)
+		values[i] = random();
+
+	bench_run("list_append_destroy", 100, _append_destroy, NULL);
+	bench_run("list_enqueue_dequeue", 1000000, _enqueue_dequeue, NULL);
+	bench_run("list_find_first", 1000, _find_first, NULL);
+	bench_run("list_for_each", 1000, _for_each, NULL);
+	bench_run("list_iterator", 1000, _iterate, NULL);
+	bench_run("list_sort", 10, _sort, NULL);
+
+	xfree(values);
+	bench_fini();
+
+	return 0;
+}
@@ -0,0 +1,472 @@
+/*****************************************************************************\
+ *  pack-bench.c - microbenchmarks for pack.c
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "slurm/slurm.h"
+
+#include "src/common/macros.h"
+#include "src/common/pack.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "bench.h"
+
+#define NRECORDS 10000
+
+/*
+ * The node_info_msg_t and job_info_msg_t records are packed by slurmctld
+ * and need the select and accounting plugins to unpack, so the records here
+ * are packed and unpacked with the same field types and string dictionary
+ * as the 21.08 protocol, leaving out the plugin data. The slurm_free_*()
+ * functions would load the select plugin too, so only the strings are freed.
+ */
+
+static node_info_t *nodes = NULL;
+static job_info_t *jobs = NULL;
+
+static void _pack_node(node_info_t *node, pack_str_dict_t *dict, buf_t *buf)
+{
+	packstr_dict(node->name, dict, buf);
+	packstr_dict(node->node_hostname, dict, buf);
+	packstr_dict(node->node_addr, dict, buf);
+	packstr_dict(node->bcast_address, dict, buf);
+	pack16(node->port, buf);
+	pack32(node->next_state, buf);
+	pack32(node->node_state, buf);
+	packstr_dict(node->version, dict, buf);
+
+	pack16(node->cpus, buf);
+	pack16(node->boards, buf);
+	pack16(node->sockets, buf);
+	pack16(node->cores, buf);
+	pack16(node->threads, buf);
+
+	pack64(node->real_memory, buf);
+	pack32(node->tmp_disk, buf);
+
+	packstr_dict(node->mcs_label, dict, buf);
+	pack32(node->owner, buf);
+	pack16(node->core_spec_cnt, buf);
+	pack32(node->cpu_bind, buf);
+	pack64(node->mem_spec_limit, buf);
+	packstr_dict(node->cpu_spec_list, dict, buf);
+
+	pack32(node->cpu_load, buf);
+	pack64(node->free_mem, buf);
+	pack32(node->weight, buf);
+	pack32(node->reason_uid, buf);
+
+	pack_time(node->boot_time, buf);
+	pack_time(node->reason_time, buf);
+	pack_time(node->slurmd_start_time, buf);
+
+	packstr_dict(node->arch, dict, buf);
+	packstr_dict(node->features, dict, buf);
+	packstr_dict(node->features_act, dict, buf);
+	packstr_dict(node->gres, dict, buf);
+	packstr_dict(node->gres_drain, dict, buf);
+	packstr_dict(node->gres_used, dict, buf);
+	packstr_dict(node->os, dict, buf);
+	packstr_dict(node->comment, dict, buf);
+	packstr_dict(node->reason, dict, buf);
+	packstr_dict(node->tres_fmt_str, dict, buf);
+}
+
+static int _unpack_node(node_info_t *node, pack_str_dict_t *dict, buf_t *buf)
+{
+	slurm_init_node_info_t(node, true);
+
+	safe_unpackstr_dict(&node->name, dict, buf);
+	safe_unpackstr_dict(&node->node_hostname, dict, buf);
+	safe_unpackstr_dict(&node->node_addr, dict, buf);
+	safe_unpackstr_dict(&node->bcast_address, dict, buf);
+	safe_unpack16(&node->port, buf);
+	safe_unpack32(&node->next_state, buf);
+	safe_unpack32(&node->node_state, buf);
+	safe_unpackstr_dict(&node->version, dict, buf);
+
+	safe_unpack16(&node->cpus, buf);
+	safe_unpack16(&node->boards, buf);
+	safe_unpack16(&node->sockets, buf);
+	safe_unpack16(&node->cores, buf);
+	safe_unpack16(&node->threads, buf);
+
+	safe_unpack64(&node->real_memory, buf);
+	safe_unpack32(&node->tmp_disk, buf);
+
+	safe_unpackstr_dict(&node->mcs_label, dict, buf);
+	safe_unpack32(&node->owner, buf);
+	safe_unpack16(&node->core_spec_cnt, buf);
+	safe_unpack32(&node->cpu_bind, buf);
+	safe_unpack64(&node->mem_spec_limit, buf);
+	safe_unpackstr_dict(&node->cpu_spec_list, dict, buf);
+
+	safe_unpack32(&node->cpu_load, buf);
+	safe_unpack64(&node->free_mem, buf);
+	safe_unpack32(&node->weight, buf);
+	safe_unpack32(&node->reason_uid, buf);
+
+	safe_unpack_time(&node->boot_time, buf);
+	safe_unpack_time(&node->reason_time, buf);
+	safe_unpack_time(&node->slurmd_start_time, buf);
+
+	safe_unpackstr_dict(&node->arch, dict, buf);
+	safe_unpackstr_dict(&node->features, dict, buf);
+	safe_unpackstr_dict(&node->features_act, dict, buf);
+	safe_unpackstr_dict(&node->gres, dict, buf);
+	safe_unpackstr_dict(&node->gres_drain, dict, buf);
+	safe_unpackstr_dict(&node->gres_used, dict, buf);
+	safe_unpackstr_dict(&node->os, dict, buf);
+	safe_unpackstr_dict(&node->comment, dict, buf);
+	safe_unpackstr_dict(&node->reason, dict, buf);
+	safe_unpackstr_dict(&node->tres_fmt_str, dict, buf);
+	return SLURM_SUCCESS;
+
+unpack_error:
+	return SLURM_ERROR;
+}
+
+static void _free_node(node_info_t *node)
+{
+	xfree(node->name);
+	xfree(node->node_hostname);
+	xfree(node->node_addr);
+	xfree(node->bcast_address);
+	xfree(node->version);
+	xfree(node->mcs_label);
+	xfree(node->cpu_spec_list);
+	xfree(node->arch);
+	xfree(node->features);
+	xfree(node->features_act);
+	xfree(node->gres);
+	xfree(node->gres_drain);
+	xfree(node->gres_used);
+	xfree(node->os);
+	xfree(node->comment);
+	xfree(node->reason);
+	xfree(node->tres_fmt_str);
+}
+
+static void _pack_job(job_info_t *job, pack_str_dict_t *dict, buf_t *buf)
+{
+	pack32(job->array_job_id, buf);
+	pack32(job->array_task_id, buf);
+	pack32(job->job_id, buf);
+	pack32(job->user_id, buf);
+	pack32(job->group_id, buf);
+	pack32(job->job_state, buf);
+	pack32(job->priority, buf);
+	pack32(job->time_limit, buf);
+	pack32(job->num_cpus, buf);
+	pack32(job->num_nodes, buf);
+	pack64(job->pn_min_memory, buf);
+
+	pack_time(job->submit_time, buf);
+	pack_time(job->eligible_time, buf);
+	pack_time(job->start_time, buf);
+	pack_time(job->end_time, buf);
+
+	packstr(job->name, buf);
+	packstr(job->work_dir, buf);
+	packstr(job->command, buf);
+	packstr_dict(job->partition, dict, buf);
+	packstr_dict(job->account, dict, buf);
+	packstr_dict(job->qos, dict, buf);
+	packstr(job->nodes, buf);
+	packstr_dict(job->tres_req_str, dict, buf);
+	packstr_dict(job->tres_alloc_str, dict, buf);
+	packstr(job->std_out, buf);
+	packstr(job->std_err, buf);
+}
+
+static int _unpack_job(job_info_t *job, pack_str_dict_t *dict, buf_t *buf)
+{
+	uint32_t uint32_tmp;
+
+	memset(job, 0, sizeof(*job));
+
+	safe_unpack32(&job->array_job_id, buf);
+	safe_unpack32(&job->array_task_id, buf);
+	safe_unpack32(&job->job_id, buf);
+	safe_unpack32(&job->user_id, buf);
+	safe_unpack32(&job->group_id, buf);
+	safe_unpack32(&job->job_state, buf);
+	safe_unpack32(&job->priority, buf);
+	safe_unpack32(&job->time_limit, buf);
+	safe_unpack32(&job->num_cpus, buf);
+	safe_unpack32(&job->num_nodes, buf);
+	safe_unpack64(&job->pn_min_memory, buf);
+
+	safe_unpack_time(&job->submit_time, buf);
+	safe_unpack_time(&job->eligible_time, buf);
+	safe_unpack_time(&job->start_time, buf);
+	safe_unpack_time(&job->end_time, buf);
+
+	safe_unpackstr_xmalloc(&job->name, &uint32_tmp, buf);
+	safe_unpackstr_xmalloc(&job->work_dir, &uint32_tmp, buf);
+	safe_unpackstr_xmalloc(&job->command, &uint32_tmp, buf);
+	safe_unpackstr_dict(&job->partition, dict, buf);
+	safe_unpackstr_dict(&job->account, dict, buf);
+	safe_unpackstr_dict(&job->qos, dict, buf);
+	safe_unpackstr_xmalloc(&job->nodes, &uint32_tmp, buf);
+	safe_unpackstr_dict(&job->tres_req_str, dict, buf);
+	safe_unpackstr_dict(&job->tres_alloc_str, dict, buf);
+	safe_unpackstr_xmalloc(&job->std_out, &uint32_tmp, buf);
+	safe_unpackstr_xmalloc(&job->std_err, &uint32_tmp, buf);
+	return SLURM_SUCCESS;
+
+unpack_error:
+	return SLURM_ERROR;
+}
+
+static void _free_job(job_info_t *job)
+{
+	xfree(job->name);
+	xfree(job->work_dir);
+	xfree(job->command);
+	xfree(job->partition);
+	xfree(job->account);
+	xfree(job->qos);
+	xfree(job->nodes);
+	xfree(job->tres_req_str);
+	xfree(job->tres_alloc_str);
+	xfree(job->std_out);
+	xfree(job->std_err);
+}
+
+static buf_t *_pack_nodes(void)
+{
+	pack_str_dict_t *dict = pack_str_dict_create();
+	buf_t *buf = init_buf(BUF_SIZE);
+
+	pack32(NRECORDS, buf);
+	for (int i = 0; i < NRECORDS; i++)
+		_pack_node(&nodes[i], dict, buf);
+	pack_str_dict_destroy(dict);
+	return buf;
+}
+
+static buf_t *_pack_jobs(void)
+{
+	pack_str_dict_t *dict = pack_str_dict_create();
+	buf_t *buf = init_buf(BUF_SIZE);
+
+	pack32(NRECORDS, buf);
+	for (int i = 0; i < NRECORDS; i++)
+		_pack_job(&jobs[i], dict, buf);
+	pack_str_dict_destroy(dict);
+	return buf;
+}
+
+static void _node_pack(uint64_t iters, void *arg)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		buf_t *buf = _pack_nodes();
+		bench_sink += get_buf_offset(buf);
+		FREE_NULL_BUFFER(buf);
+	}
+}
+
+static void _node_unpack(uint64_t iters, void *arg)
+{
+	buf_t *buf = _pack_nodes();
+	node_info_t node;
+	uint32_t cnt;
+
+	for (uint64_t i = 0; i < iters; i++) {
+		pack_str_dict_t *dict = pack_str_dict_create();
+
+		set_buf_offset(buf, 0);
+		if (unpack32(&cnt, buf))
+			fatal("%s: unpack failed", __func__);
+		for (int j = 0; j < cnt; j++) {
+			if (_unpack_node(&node, dict, buf))
+				fatal("%s: unpack failed", __func__);
+			bench_sink += node.cpus;
+			_free_node(&node);
+		}
+		pack_str_dict_destroy(dict);
+	}
+	FREE_NULL_BUFFER(buf);
+}
+
+static void _job_pack(uint64_t iters, void *arg)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		buf_t *buf = _pack_jobs();
+		bench_sink += get_buf_offset(buf);
+		FREE_NULL_BUFFER(buf);
+	}
+}
+
+static void _job_unpack(uint64_t iters, void *arg)
+{
+	buf_t *buf = _pack_jobs();
+	job_info_t job;
+	uint32_t cnt;
+
+	for (uint64_t i = 0; i < iters; i++) {
+		pack_str_dict_t *dict = pack_str_dict_create();
+
+		set_buf_offset(buf, 0);
+		if (unpack32(&cnt, buf))
+			fatal("%s: unpack failed", __func__);
+		for (int j = 0; j < cnt; j++) {
+			if (_unpack_job(&job, dict, buf))
+				fatal("%s: unpack failed", __func__);
+			bench_sink += job.job_id;
+			_free_job(&job);
+		}
+		pack_str_dict_destroy(dict);
+	}
+	FREE_NULL_BUFFER(buf);
+}
+
+static void _pack32(uint64_t iters, void *arg)
+{
+	buf_t *buf = init_buf(BUF_SIZE);
+
+	for (uint64_t i = 0; i < iters; i++) {
+		if (!(i % 1024))
+			set_buf_offset(buf, 0);
+		pack32(i, buf);
+	}
+	bench_sink += get_buf_offset(buf);
+	FREE_NULL_BUFFER(buf);
+}
+
+static void _packstr(uint64_t iters, void *arg)
+{
+	buf_t *buf = init_buf(BUF_SIZE);
+
+	for (uint64_t i = 0; i < iters; i++) {
+		if (!(i % 256))
+			set_buf_offset(buf, 0);
+		packstr("/home/user/jobs/run.sh", buf);
+	}
+	bench_sink += get_buf_offset(buf);
+	FREE_NULL_BUFFER(buf);
+}
+
+static void _fill_records(void)
+{
+	static const char *features[] = { "haswell,ib", "skylake,ib",
+					  "skylake,ib,gpu" };
+	static const char *parts[] = { "debug", "batch", "gpu", "long" };
+	static const char *accounts[] = { "physics", "chem", "bio", "cs",
+					  "math" };
+
+	nodes = xcalloc(NRECORDS, sizeof(node_info_t));
+	for (int i = 0; i < NRECORDS; i++) {
+		node_info_t *node = &nodes[i];
+		int f = random() % ARRAY_SIZE(features);
+
+		slurm_init_node_info_t(node, true);
+		node->name = xstrdup_printf("node%05d", i);
+		node->node_hostname = xstrdup(node->name);
+		node->node_addr = xstrdup(node->name);
+		node->port = 6818;
+		node->node_state = NODE_STATE_IDLE;
+		node->version = xstrdup("21.08.0");
+		node->cpus = 64;
+		node->boards = 1;
+		node->sockets = 2;
+		node->cores = 16;
+		node->threads = 2;
+		node->real_memory = 256000;
+		node->cpu_load = random() % 6400;
+		node->free_mem = random() % 256000;
+		node->weight = 1;
+		node->boot_time = node->slurmd_start_time = random();
+		node->arch = xstrdup("x86_64");
+		node->features = xstrdup(features[f]);
+		node->features_act = xstrdup(features[f]);
+		if (f == 2)
+			node->gres = xstrdup("gpu:4");
+		node->os = xstrdup("Linux 5.4.0-1 #1 SMP");
+		node->tres_fmt_str = xstrdup("cpu=64,mem=250G,billing=64");
+	}
+
+	jobs = xcalloc(NRECORDS, sizeof(job_info_t));
+	for (int i = 0; i < NRECORDS; i++) {
+		job_info_t *job = &jobs[i];
+
+		job->job_id = 1000 + i;
+		job->array_task_id = NO_VAL;
+		job->user_id = 1000 + random() % 100;
+		job->group_id = 1000;
+		job->job_state = (random() & 1) ? JOB_RUNNING : JOB_PENDING;
+		job->priority = random();
+		job->time_limit = 60;
+		job->num_cpus = 64;
+		job->num_nodes = 1 + random() % 4;
+		job->submit_time = random();
+		job->name = xstrdup_printf("job%d", i);
+		job->work_dir = xstrdup_printf("/home/user%u",
+					       job->user_id);
+		job->command = xstrdup_printf("%s/run.sh", job->work_dir);
+		job->partition = xstrdup(parts[random() % ARRAY_SIZE(parts)]);
+		job->account =
+			xstrdup(accounts[random() % ARRAY_SIZE(accounts)]);
+		job->qos = xstrdup("normal");
+		job->nodes = xstrdup_printf("node[%05d-%05d]", i,
+					    i + job->num_nodes - 1);
+		job->tres_req_str = xstrdup("cpu=64,mem=250G,node=1");
+		job->tres_alloc_str = xstrdup(job->tres_req_str);
+		job->std_out = xstrdup_printf("%s/slurm-%u.out",
+					      job->work_dir, job->job_id);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	bench_init("pack", argc, argv);
+	_fill_records();
+
+	bench_run("pack32", 10000000, _pack32, NULL);
+	bench_run("packstr", 1000000, _packstr, NULL);
+	bench_run("node_info_pack", 10, _node_pack, NULL);
+	bench_run("node_info_unpack", 10, _node_unpack, NULL);
+	bench_run("job_info_pack", 10, _job_pack, NULL);
+	bench_run("job_info_unpack", 10, _job_unpack, NULL);
+
+	for (int i = 0; i < NRECORDS; i++) {
+		_free_node(&nodes[i]);
+		_free_job(&jobs[i]);
+	}
+	xfree(nodes);
+	xfree(jobs);
+	bench_fini();
+
+	return 0;
+}
@@ -27,6 +27,8 @@ int main (int argc, char *argv[])
 	char *nullstr = NULL;
 	char *data;
 	int data_size;
+	bitstr_t *bitmaps[4], *outbitmap = NULL;
+	int i;
 	long double test_double = 1340664754944.2132312, test_double2;
 	uint64_t test64;
 
@@ -83,6 +85,37 @@ int main (int argc, char *argv[])
 	xfree(outstring);
 
 	free_buf(buffer);
+
+	/* Sparse (runs), random (words), odd sized and NULL bitmaps */
+	bitmaps[0] = bit_alloc(5000);
+	bit_nset(bitmaps[0], 10, 200);
+	bit_nset(bitmaps[0], 4000, 4999);
+	bit_set(bitmaps[0], 3000);
+	bitmaps[1] = bit_alloc(1000);
+	for (i = 0; i < 1000; i++)
+		if ((i * 7919) % 3)
+			bit_set(bitmaps[1], i);
+	bitmaps[2] = bit_alloc(65);
+	bit_set(bitmaps[2], 64);
+	bitmaps[3] = NULL;
+
+	buffer = init_buf(0);
+	for (i = 0; i < 4; i++)
+		pack_bit_str_bin(bitmaps[i], buffer);
+	set_buf_offset(buffer, 0);
+	for (i = 0; i < 4; i++) {
+		TEST(unpack_bit_str_bin(&outbitmap, buffer),
+		     "unpack_bit_str_bin");
+		if (bitmaps[i])
+			TEST(!outbitmap || !bit_equal(outbitmap, bitmaps[i]),
+			     "un/pack_bit_str_bin");
+		else
+			TEST(outbitmap != NULL, "un/pack_bit_str_bin of NULL");
+		FREE_NULL_BITMAP(outbitmap);
+		FREE_NULL_BITMAP(bitmaps[i]);
+	}
+	free_buf(buffer);
+
 	totals();
 	return failed;
 
@@ -0,0 +1,176 @@
+/*****************************************************************************\
+ *  parse_config-bench.c - microbenchmarks for parse_config.c
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "slurm/slurm.h"
+
+#include "src/common/pack.h"
+#include "src/common/parse_config.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "bench.h"
+
+#define NLINES 10000
+
+static s_p_options_t node_options[] = {
+	{"NodeName", S_P_STRING},
+	{"CPUs", S_P_UINT16},
+	{"Sockets", S_P_UINT16},
+	{"CoresPerSocket", S_P_UINT16},
+	{"ThreadsPerCore", S_P_UINT16},
+	{"RealMemory", S_P_UINT64},
+	{"Feature", S_P_STRING},
+	{"Gres", S_P_STRING},
+	{"Weight", S_P_UINT32},
+	{"State", S_P_STRING},
+	{NULL}
+};
+
+static s_p_options_t part_options[] = {
+	{"PartitionName", S_P_STRING},
+	{"Nodes", S_P_STRING},
+	{"MaxTime", S_P_STRING},
+	{"Default", S_P_BOOLEAN},
+	{"State", S_P_STRING},
+	{NULL}
+};
+
+static s_p_options_t options[] = {
+	{"ClusterName", S_P_STRING},
+	{"SlurmctldHost", S_P_STRING},
+	{"SchedulerType", S_P_STRING},
+	{"SchedulerParameters", S_P_STRING},
+	{"SelectType", S_P_STRING},
+	{"SelectTypeParameters", S_P_STRING},
+	{"MaxJobCount", S_P_UINT32},
+	{"NodeName", S_P_LINE, NULL, NULL, node_options},
+	{"PartitionName", S_P_LINE, NULL, NULL, part_options},
+	{NULL}
+};
+
+static char *node_line =
+	"NodeName=node[00000-00063] CPUs=64 Sockets=2 CoresPerSocket=16 "
+	"ThreadsPerCore=2 RealMemory=256000 Feature=skylake,ib "
+	"Gres=gpu:4 Weight=10 State=UNKNOWN";
+
+/* A slurm.conf with NLINES node lines, as read by the daemons */
+static buf_t *_build_conf(void)
+{
+	buf_t *buf = init_buf(BUF_SIZE);
+	char *line = NULL;
+	uint32_t size;
+
+	packstr("ClusterName=bench", buf);
+	packstr("SlurmctldHost=ctld", buf);
+	packstr("SchedulerType=sched/backfill", buf);
+	packstr("SchedulerParameters=bf_continue,bf_max_job_test=1000", buf);
+	packstr("SelectType=select/cons_tres", buf);
+	packstr("SelectTypeParameters=CR_Core_Memory", buf);
+	packstr("MaxJobCount=100000", buf);
+	for (int i = 0; i < NLINES; i++) {
+		xstrfmtcat(line, "NodeName=node%05d CPUs=64 Sockets=2 CoresPerSocket=16 ThreadsPerCore=2 RealMemory=%d Feature=%s Weight=%d State=UNKNOWN",
+			   i, 256000 - (int) (random() % 4) * 1024,
+			   (random() & 1) ? "skylake,ib" : "haswell,ib",
+			   (int) (random() % 100));
+		packstr(line, buf);
+		xfree(line);
+	}
+	packstr("PartitionName=debug Nodes=ALL MaxTime=30 Default=YES State=UP",
+		buf);
+	packstr("PartitionName=batch Nodes=ALL MaxTime=INFINITE State=UP",
+		buf);
+
+	/* s_p_parse_buffer() reads up to the buffer size, so trim it */
+	size = get_buf_offset(buf);
+	return create_buf(xfer_buf_data(buf), size);
+}
+
+static void _parse_buffer(uint64_t iters, void *arg)
+{
+	buf_t *buf = arg;
+
+	for (uint64_t i = 0; i < iters; i++) {
+		s_p_hashtbl_t *tbl = s_p_hashtbl_create(options);
+		s_p_hashtbl_t **lines = NULL;
+		int cnt = 0;
+
+		set_buf_offset(buf, 0);
+		if (s_p_parse_buffer(tbl, NULL, buf, false) != SLURM_SUCCESS)
+			fatal("%s: parse failed", __func__);
+		if (!s_p_get_line(&lines, &cnt, "NodeName", tbl))
+			fatal("%s: no NodeName lines", __func__);
+		bench_sink += cnt;
+		s_p_hashtbl_destroy(tbl);
+	}
+}
+
+static void _parse_line(uint64_t iters, void *arg)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		s_p_hashtbl_t *tbl = s_p_hashtbl_create(node_options);
+		char *leftover = NULL;
+		uint16_t cpus = 0;
+
+		if (!s_p_parse_line(tbl, node_line, &leftover))
+			fatal("%s: parse failed", __func__);
+		s_p_get_uint16(&cpus, "CPUs", tbl);
+		bench_sink += cpus;
+		s_p_hashtbl_destroy(tbl);
+	}
+}
+
+static void _hashtbl_create(uint64_t iters, void *arg)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		s_p_hashtbl_t *tbl = s_p_hashtbl_create(options);
+		bench_sink += !!tbl;
+		s_p_hashtbl_destroy(tbl);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	buf_t *conf;
+
+	bench_init("parse_config", argc, argv);
+	conf = _build_conf();
+
+	bench_run("s_p_hashtbl_create", 100000, _hashtbl_create, NULL);
+	bench_run("s_p_parse_line", 100000, _parse_line, NULL);
+	bench_run("s_p_parse_buffer", 10, _parse_buffer, conf);
+
+	FREE_NULL_BUFFER(conf);
+	bench_fini();
+
+	return 0;
+}
@@ -0,0 +1,155 @@
+/*****************************************************************************\
+ *  parse_config-test.c - unit test for parse_config.c
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "slurm/slurm.h"
+#include "src/common/parse_config.h"
+#include "src/common/xmalloc.h"
+
+static s_p_options_t options[] = {
+	{"Name", S_P_STRING},
+	{"Count", S_P_UINT32},
+	{"Feature", S_P_STRING},
+	{"Node.Weight", S_P_UINT32},
+	{NULL}
+};
+
+static s_p_hashtbl_t *_parse(const char *line)
+{
+	s_p_hashtbl_t *tbl = s_p_hashtbl_create(options);
+	char *leftover = NULL;
+
+	if (!s_p_parse_line(tbl, line, &leftover)) {
+		s_p_hashtbl_destroy(tbl);
+		return NULL;
+	}
+	return tbl;
+}
+
+START_TEST(test_keyvalue)
+{
+	s_p_hashtbl_t *tbl;
+	char *str = NULL;
+	uint32_t num = 0;
+
+	tbl = _parse("  Name=foo   Count = 12 Node.Weight=3");
+	ck_assert(tbl != NULL);
+	ck_assert(s_p_get_string(&str, "Name", tbl));
+	ck_assert_str_eq(str, "foo");
+	xfree(str);
+	ck_assert(s_p_get_uint32(&num, "Count", tbl));
+	ck_assert_int_eq(num, 12);
+	ck_assert(s_p_get_uint32(&num, "Node.Weight", tbl));
+	ck_assert_int_eq(num, 3);
+	s_p_hashtbl_destroy(tbl);
+
+	/* Empty and blank lines contain no keys */
+	tbl = _parse("");
+	ck_assert(tbl != NULL);
+	ck_assert(!s_p_get_string(&str, "Name", tbl));
+	s_p_hashtbl_destroy(tbl);
+
+	/* Unknown keys are rejected */
+	ck_assert(_parse("Bogus=1") == NULL);
+}
+END_TEST
+
+START_TEST(test_quoted)
+{
+	s_p_hashtbl_t *tbl;
+	char *str = NULL;
+	uint32_t num = 0;
+
+	tbl = _parse("Feature=\"a b c\" Count=4");
+	ck_assert(tbl != NULL);
+	ck_assert(s_p_get_string(&str, "Feature", tbl));
+	ck_assert_str_eq(str, "a b c");
+	xfree(str);
+	ck_assert(s_p_get_uint32(&num, "Count", tbl));
+	ck_assert_int_eq(num, 4);
+	s_p_hashtbl_destroy(tbl);
+
+	/* A closing quote not followed by whitespace is part of the word */
+	tbl = _parse("Feature=\"a\"b");
+	ck_assert(tbl != NULL);
+	ck_assert(s_p_get_string(&str, "Feature", tbl));
+	ck_assert_str_eq(str, "\"a\"b");
+	xfree(str);
+	s_p_hashtbl_destroy(tbl);
+}
+END_TEST
+
+START_TEST(test_operator)
+{
+	s_p_hashtbl_t *tbl;
+	slurm_parser_operator_t op = S_P_OPERATOR_SET;
+
+	tbl = _parse("Count+=2");
+	ck_assert(tbl != NULL);
+	ck_assert(s_p_get_operator(&op, "Count", tbl));
+	ck_assert_int_eq(op, S_P_OPERATOR_ADD);
+	s_p_hashtbl_destroy(tbl);
+
+	tbl = _parse("Count -= 2");
+	ck_assert(tbl != NULL);
+	ck_assert(s_p_get_operator(&op, "Count", tbl));
+	ck_assert_int_eq(op, S_P_OPERATOR_SUB);
+	s_p_hashtbl_destroy(tbl);
+}
+END_TEST
+
+Suite *parse_config_suite(void)
+{
+	Suite *s = suite_create("parse_config");
+	TCase *tc_core = tcase_create("parse_config");
+	tcase_add_test(tc_core, test_keyvalue);
+	tcase_add_test(tc_core, test_quoted);
+	tcase_add_test(tc_core, test_operator);
+	suite_add_tcase(s, tc_core);
+	return s;
+}
+
+int main(void)
+{
+	int number_failed;
+	SRunner *sr = srunner_create(parse_config_suite());
+
+	srunner_run_all(sr, CK_ENV);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,134 @@
+/*****************************************************************************\
+ *  xhash-bench.c - microbenchmarks for xhash.c
+ *****************************************************************************
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "src/common/xhash.h"
+#include "src/common/xmalloc.h"
+
+#include "bench.h"
+
+#define NITEMS 100000
+
+typedef struct {
+	char id[32];
+	uint32_t idn;
+} item_t;
+
+static item_t *items = NULL;
+
+static void _item_identify(void *voiditem, const char **key,
+			   uint32_t *key_len)
+{
+	item_t *item = voiditem;
+
+	*key = item->id;
+	*key_len = strlen(item->id);
+}
+
+static void _item_sum(void *item, void *arg)
+{
+	*(uint64_t *) arg += ((item_t *) item)->idn;
+}
+
+static xhash_t *_fill_table(void)
+{
+	xhash_t *table = xhash_init(_item_identify, NULL);
+
+	for (int i = 0; i < NITEMS; i++)
+		xhash_add(table, &items[i]);
+	return table;
+}
+
+static void _add_free(uint64_t iters, void *arg)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		xhash_t *table = _fill_table();
+		bench_sink += xhash_count(table);
+		xhash_free(table);
+	}
+}
+
+static void _get_hit(uint64_t iters, void *arg)
+{
+	xhash_t *table = _fill_table();
+
+	for (uint64_t i = 0; i < iters; i++)
+		bench_sink += !!xhash_get_str(table,
+					      items[(i * 7919) % NITEMS].id);
+	xhash_free(table);
+}
+
+static void _get_miss(uint64_t iters, void *arg)
+{
+	xhash_t *table = _fill_table();
+	char key[32];
+
+	for (uint64_t i = 0; i < iters; i++) {
+		snprintf(key, sizeof(key), "missing%"PRIu64, i);
+		bench_sink += !!xhash_get_str(table, key);
+	}
+	xhash_free(table);
+}
+
+static void _walk(uint64_t iters, void *arg)
+{
+	xhash_t *table = _fill_table();
+	uint64_t sum = 0;
+
+	for (uint64_t i = 0; i < iters; i++)
+		xhash_walk(table, _item_sum, &sum);
+	bench_sink += sum;
+	xhash_free(table);
+}
+
+int main(int argc, char **argv)
+{
+	bench_init("xhash", argc, argv);
+
+	/* Keys shaped like job and user names */
+	items = xcalloc(NITEMS, sizeof(item_t));
+	for (int i = 0; i < NITEMS; i++) {
+		items[i].idn = random();
+		snprintf(items[i].id, sizeof(items[i].id), "user%u_%d",
+			 items[i].idn, i);
+	}
+
+	bench_run("xhash_add_free", 10, _add_free, NULL);
+	bench_run("xhash_get_hit", 1000000, _get_hit, NULL);
+	bench_run("xhash_get_miss", 1000000, _get_miss, NULL);
+	bench_run("xhash_walk", 10, _walk, NULL);
+
+	xfree(items);
+	bench_fini();
+
+	return 0;
+}